@@ -20,6 +20,12 @@ STDOUT_PATH=""
 STDERR_PATH=""
 INPUT_PATHS=()
 OUTPUT_PATHS=()
+METRIC_NAMES=()
+# Performance baseline file and the machine class the values are recorded
+# for. Baseline values are only compared within the same machine class.
+PERF_BASELINE=${TIT_PERF_BASELINE:-"$SOURCE_DIR/output/perf_baseline.txt"}
+PERF_MACHINE=${TIT_PERF_MACHINE:-"$(uname -s)-$(uname -m)-$(get-num-cpus)"}
+PERF_TOLERANCE=${TIT_PERF_TOLERANCE:-0.1}
 DIFF_EXE=${DIFF_EXE:-diff}
 # Prefer `gsed` to regular `sed`. This is essential on the BSD-like systems.
 SED_EXE=${SED_EXE:-$(command -v gsed || echo sed)}
@@ -47,6 +53,7 @@ usage() {
   echo "  --match-stderr <path> Match test 'stderr' with the specified file."
   echo "  --match-file <path>   Match test output file with the specified file."
   echo "  --filter <filter>     Extra 'sed' filter to be applied to the test output."
+  echo "  --match-metric <name> Match metric with the performance baseline."
   echo "  -- <test-command>     Test command line arguments."
 }
 
@@ -70,6 +77,8 @@ parse-args() {
       --match-file=*)   OUTPUT_PATHS+=("${1#*=}"); shift 1;;
       --filter)         SED_FILTERS+=("$2");       shift 2;;
       --filter=*)       SED_FILTERS+=("${1#*=}");  shift 1;;
+      --match-metric)   METRIC_NAMES+=("$2");      shift 2;;
+      --match-metric=*) METRIC_NAMES+=("${1#*=}"); shift 1;;
       --)               TEST_COMMAND=("${@:2}");   break;;
       # Help.
       -h | -help | --help)             usage; exit 0;;
@@ -143,6 +152,10 @@ setup-output() {
 
 run-test() {
   echo "# Running test..."
+  if [ ${#METRIC_NAMES[@]} -gt 0 ]; then
+    export TIT_ENABLE_METRICS=1
+    export TIT_METRICS_FILE="metrics.jsonl"
+  fi
   echo "# $ ${TEST_COMMAND[*]}"
   "${TEST_COMMAND[@]}" <"stdin.txt" >"stdout.txt" 2>"stderr.txt"
 }
@@ -250,6 +263,61 @@ match-file() {
   "$MATCH_COMMAND" "$FILE"
 }
 
+# Get the metric value from the last line of the metrics file.
+get-metric() {
+  local FILE="$1"
+  local NAME="$2"
+  tail -n 1 "$FILE" | awk -v key="\"$NAME\":" '{
+    i = index($0, key); if (i == 0) exit 1
+    value = substr($0, i + length(key)); sub(/[,}].*$/, "", value)
+    print value
+  }'
+}
+
+# Get the baseline value of the metric, the last recorded one wins.
+get-baseline() {
+  local KEY="$1"
+  [ -f "$PERF_BASELINE" ] || return 0
+  awk -v key="$KEY " 'index($0, key) == 1 { value = $NF }
+                      END { if (value != "") print value }' "$PERF_BASELINE"
+}
+
+match-metric() {
+  local NAME="$1"
+
+  # Get the actual value.
+  local ACTUAL
+  if [ ! -f "metrics.jsonl" ] ||
+     ! ACTUAL=$(get-metric "metrics.jsonl" "$NAME") ||
+     [ "$ACTUAL" = "null" ]; then
+    echo "# Metric $NAME was not reported!"
+    return 1
+  fi
+
+  # Get the baseline value. If there is none, or the update is requested,
+  # the actual value is recorded as the new baseline.
+  local KEY="$PERF_MACHINE $TEST_NAME $NAME"
+  local EXPECTED
+  EXPECTED=$(get-baseline "$KEY")
+  if [ -z "$EXPECTED" ] || [ "$TIT_PERF_UPDATE" ]; then
+    echo "# Recording $NAME baseline $ACTUAL for $PERF_MACHINE..."
+    mkdir -p "$(dirname "$PERF_BASELINE")"
+    echo "$KEY $ACTUAL" >> "$PERF_BASELINE"
+    return 0
+  fi
+
+  # Match them. Metrics are the throughputs, so only the drops are reported.
+  if ! awk -v actual="$ACTUAL" -v expected="$EXPECTED" \
+           -v tolerance="$PERF_TOLERANCE" \
+           'BEGIN { exit !(actual >= (1 - tolerance) * expected) }'; then
+    echo "# Metric $NAME has regressed!"
+    echo "#   Baseline: $EXPECTED"
+    echo "#   Actual:   $ACTUAL"
+    echo "#   Tolerance: $PERF_TOLERANCE"
+    return 1
+  fi
+}
+
 match() {
   echo "# Matching results..."
   PASSED=true
@@ -264,6 +332,12 @@ match() {
   done
   for PID in "${PIDS[@]}"; do wait "$PID" || PASSED=false; done
 
+  # Match the metrics. Baseline file is updated, so this is sequential.
+  for NAME in "${METRIC_NAMES[@]}"; do
+    echo "# Matching $NAME metric..."
+    match-metric "$NAME" || PASSED=false
+  done
+
   # Exit with status.
   if [ "$PASSED" = true ]; then
     echo "# Test passed!"
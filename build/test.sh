@@ -57,8 +57,13 @@ run-tests() {
   # Parallelize the test execution.
   [ "$JOBS" -gt 1 ] && CTEST_ARGS+=("-j" "$JOBS")
 
-  # Exclude long tests if the flag is not set.
-  [ ! "$TIT_LONG_TESTS" ] && CTEST_ARGS+=("--exclude-regex" "\[long\]")
+  # Exclude long and performance tests if the flags are not set.
+  local EXCLUDE=()
+  [ ! "$TIT_LONG_TESTS" ] && EXCLUDE+=("\[long\]")
+  [ ! "$TIT_PERF_TESTS" ] && EXCLUDE+=("\[perf\]")
+  if [ ${#EXCLUDE[@]} -gt 0 ]; then
+    CTEST_ARGS+=("--exclude-regex" "$(IFS="|"; echo "${EXCLUDE[*]}")")
+  fi
 
   # Run CTest.
   (cd "$TEST_DIR" && "${CTEST_ARGS[@]}") || exit $?
@@ -23,13 +23,18 @@ set(
   -Wno-unknown-warning-option
 )
 
+# Target architecture of the generated machine code. The host system's one is
+# used by default. To run a single binary on the heterogeneous nodes, set it to
+# the oldest architecture among them, for example `x86-64-v3`.
+set(TIT_TARGET_ARCH "native" CACHE STRING "Target architecture (-march).")
+
 # Define common compile options.
 set(
   CLANG_COMPILE_OPTIONS
   # Warnings and diagnostics.
   ${CLANG_WARNINGS}
-  # Generate machine code for the host system's architecture.
-  -march=native
+  # Generate machine code for the target architecture.
+  -march=${TIT_TARGET_ARCH}
   # Position independent code.
   -fPIC
   # Bug in LLVM.
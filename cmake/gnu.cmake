@@ -46,13 +46,18 @@ set(
   -Wno-psabi
 )
 
+# Target architecture of the generated machine code. The host system's one is
+# used by default. To run a single binary on the heterogeneous nodes, set it to
+# the oldest architecture among them, for example `x86-64-v3`.
+set(TIT_TARGET_ARCH "native" CACHE STRING "Target architecture (-march).")
+
 # Define common compile options.
 set(
   GNU_COMPILE_OPTIONS
   # Warnings and diagnostics.
   ${GNU_WARNINGS}
-  # Generate machine code for the host system's architecture.
-  -march=native
+  # Generate machine code for the target architecture.
+  -march=${TIT_TARGET_ARCH}
   # Position independent code.
   -fPIC
 )
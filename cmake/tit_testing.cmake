@@ -29,7 +29,7 @@ function(add_tit_test)
     TEST
     ""
     "NAME;EXIT_CODE;STDIN;MATCH_STDOUT;MATCH_STDERR"
-    "COMMAND;ENVIRONMENT;INPUT_FILES;MATCH_FILES;FILTERS"
+    "COMMAND;ENVIRONMENT;INPUT_FILES;MATCH_FILES;MATCH_METRICS;FILTERS"
     ${ARGN}
   )
   if(NOT TEST_NAME)
@@ -64,6 +64,9 @@ function(add_tit_test)
     cmake_path(ABSOLUTE_PATH FILE NORMALIZE)
     list(APPEND TEST_DRIVER_ARGS "--match-file=${FILE}")
   endforeach()
+  foreach(METRIC ${TEST_MATCH_METRICS})
+    list(APPEND TEST_DRIVER_ARGS "--match-metric=${METRIC}")
+  endforeach()
   foreach(FILTER ${TEST_FILTERS})
     list(APPEND TEST_DRIVER_ARGS "--filter=${FILTER}")
   endforeach()
@@ -83,6 +86,12 @@ function(add_tit_test)
       PROPERTIES ENVIRONMENT "${TEST_ENVIRONMENT}"
     )
   endif()
+
+  # Timed tests are run one at a time, so that they do not compete for the
+  # cores with the other tests.
+  if(TEST_MATCH_METRICS)
+    set_tests_properties("${TEST_NAME}" PROPERTIES RUN_SERIAL TRUE)
+  endif()
 endfunction()
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
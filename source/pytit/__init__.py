@@ -3,4 +3,186 @@
 # Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-print()  # TODO: Remove this line once we actual code.
+"""
+Python interface to the BlueTit Solver.
+
+Data storages (`.ttdb` files) are read with `DataStorage`. Data arrays are
+decoded straight into the NumPy arrays, with the GIL released, so that the
+arrays could be read from multiple threads at once.
+
+>>> storage = pytit.DataStorage("particles.ttdb")
+>>> step = storage.last_series.time_steps[-1]
+>>> rho = step.varyings["rho"]
+
+Datasets implement the Arrow PyCapsule interface, e.g. they are converted
+into the Arrow record batches with `pyarrow.record_batch(step.varyings)`.
+
+Derived quantities are computed with the native post-processing operators,
+e.g. `interpolate`, `vorticity` and `kinetic_energy`, that run in parallel
+with the GIL released, and find the particle neighbors on their own.
+"""
+
+from collections.abc import Iterator, Mapping
+
+import numpy as np
+
+from . import _pytit
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+
+class DataSet(Mapping[str, np.ndarray]):
+    """Dataset: a mapping of the data array names to their values."""
+
+    def __init__(self, storage: "DataStorage", dataset_id: int):
+        self._storage = storage
+        self._dataset_id = dataset_id
+        self._array_ids = _pytit.dataset_array_ids(storage.handle, dataset_id)
+
+    def __getitem__(self, name: str) -> np.ndarray:
+        """Read the data array with the given name."""
+        return _pytit.read_array(self._storage.handle, self._array_ids[name])
+
+    def __iter__(self) -> Iterator[str]:
+        return iter(self._array_ids)
+
+    def __len__(self) -> int:
+        return len(self._array_ids)
+
+    def __arrow_c_array__(
+        self, requested_schema: object = None
+    ) -> tuple[object, object]:
+        """
+        Export the dataset as an Arrow record batch, with one column per data
+        array, through the Arrow PyCapsule interface.
+
+        Vectors and matrices are the fixed-size lists. The requested schema
+        is ignored, the arrays are always exported with their own types.
+        """
+        del requested_schema
+        return _pytit.dataset_arrow(self._storage.handle, self._dataset_id)
+
+
+class DataTimeStep:
+    """Data time step."""
+
+    def __init__(self, storage: "DataStorage", time_step_id: int):
+        self._storage = storage
+        self.id = time_step_id
+        self.time, self._uniforms_id, self._varyings_id = (
+            _pytit.time_step_info(storage.handle, time_step_id)
+        )
+
+    @property
+    def uniforms(self) -> DataSet:
+        """Uniform dataset of the time step."""
+        return DataSet(self._storage, self._uniforms_id)
+
+    @property
+    def varyings(self) -> DataSet:
+        """Varying dataset of the time step."""
+        return DataSet(self._storage, self._varyings_id)
+
+
+class DataSeries:
+    """Data series."""
+
+    def __init__(self, storage: "DataStorage", series_id: int):
+        self._storage = storage
+        self.id = series_id
+
+    @property
+    def parameters(self) -> str:
+        """Parameters of the data series."""
+        return _pytit.series_parameters(self._storage.handle, self.id)
+
+    @property
+    def time_steps(self) -> list[DataTimeStep]:
+        """All time steps of the data series."""
+        return [
+            DataTimeStep(self._storage, time_step_id)
+            for time_step_id in _pytit.series_time_step_ids(
+                self._storage.handle, self.id
+            )
+        ]
+
+
+class DataStorage:
+    """Data storage, opened for reading."""
+
+    def __init__(self, path: str):
+        self.handle = _pytit.open(str(path))
+
+    @property
+    def series(self) -> list[DataSeries]:
+        """All data series of the storage."""
+        return [
+            DataSeries(self, series_id)
+            for series_id in _pytit.series_ids(self.handle)
+        ]
+
+    @property
+    def last_series(self) -> DataSeries:
+        """Last data series of the storage."""
+        series_ids = _pytit.series_ids(self.handle)
+        if not series_ids:
+            raise LookupError("Data storage has no series.")
+        return DataSeries(self, series_ids[-1])
+
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+
+def interpolate(
+    r: np.ndarray,
+    V: np.ndarray,
+    h: np.ndarray,
+    values: np.ndarray,
+    points: np.ndarray,
+) -> np.ndarray:
+    """
+    Interpolate the particle values onto the points.
+
+    Values are interpolated with the Shepard-normalized quartic Wendland
+    kernel. Points with no particles nearby get zero values.
+
+    :param r: Particle positions, of shape (N, D).
+    :param V: Particle volumes, i.e. `m / rho`, of shape (N,).
+    :param h: Particle widths, of shape (N,).
+    :param values: Particle values, of shape (N, ...).
+    :param points: Interpolation points, of shape (M, D).
+    :returns: Interpolated values, of shape (M, ...).
+    """
+    values = np.asarray(values, dtype=np.float64)
+    points = np.asarray(points, dtype=np.float64)
+    result = _pytit.interpolate(
+        r, V, h, values.reshape(len(values), -1), points
+    )
+    return result.reshape((len(points),) + values.shape[1:])
+
+
+def vorticity(
+    r: np.ndarray, V: np.ndarray, h: np.ndarray, v: np.ndarray
+) -> np.ndarray:
+    """
+    Compute the particle velocity curl, of shape (N, 3).
+
+    :param r: Particle positions, of shape (N, D).
+    :param V: Particle volumes, i.e. `m / rho`, of shape (N,).
+    :param h: Particle widths, of shape (N,).
+    :param v: Particle velocities, of shape (N, D).
+    """
+    return _pytit.vorticity(r, V, h, v)
+
+
+def kinetic_energy(m: np.ndarray, v: np.ndarray) -> float:
+    """
+    Compute the total kinetic energy of the particles.
+
+    :param m: Particle masses, of shape (N,).
+    :param v: Particle velocities, of shape (N, D).
+    """
+    return _pytit.kinetic_energy(m, v)
+
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
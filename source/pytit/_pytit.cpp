@@ -0,0 +1,346 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/mdvector.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/arrow.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/py/arrow.hpp"
+#include "tit/py/capsule.hpp"
+#include "tit/py/func.hpp"
+#include "tit/py/gil.hpp"
+#include "tit/py/mapping.hpp"
+#include "tit/py/module.hpp"
+#include "tit/py/numpy.hpp"
+#include "tit/py/object.hpp"
+#include "tit/py/sequence.hpp"
+
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/postprocess.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Data storage is passed to Python as a capsule, that owns it.
+auto storage_of(const py::Capsule& storage) -> data::DataStorage& {
+  return *static_cast<data::DataStorage*>(storage.data());
+}
+
+// Make a list of the row IDs.
+template<class IDs>
+auto make_id_list(const IDs& ids) -> py::List {
+  py::List result{};
+  for (const auto id : ids) result.append(id.get());
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Open the data storage for reading.
+auto open_storage(std::string path) -> py::Capsule {
+  if (!std::filesystem::exists(path)) {
+    TIT_THROW("Data storage '{}' does not exist.", path);
+  }
+  return py::Capsule{std::make_unique<data::DataStorage>(path)};
+}
+
+// Get the IDs of all the data series.
+auto series_ids(py::Capsule storage) -> py::List {
+  return make_id_list(storage_of(storage).series_ids());
+}
+
+// Get the parameters of the data series.
+auto series_parameters(py::Capsule storage, int64_t series_id)
+    -> std::string {
+  const data::DataSeriesID id{series_id};
+  if (!storage_of(storage).check_series(id)) {
+    TIT_THROW("Data series {} does not exist.", series_id);
+  }
+  return storage_of(storage).series_parameters(id);
+}
+
+// Get the IDs of all the time steps of the data series.
+auto series_time_step_ids(py::Capsule storage, int64_t series_id)
+    -> py::List {
+  const data::DataSeriesID id{series_id};
+  if (!storage_of(storage).check_series(id)) {
+    TIT_THROW("Data series {} does not exist.", series_id);
+  }
+  return make_id_list(storage_of(storage).series_time_step_ids(id));
+}
+
+// Get the time and the uniform and varying dataset IDs of the time step.
+auto time_step_info(py::Capsule storage, int64_t time_step_id) -> py::Tuple {
+  const data::DataTimeStepID id{time_step_id};
+  const auto& data_storage = storage_of(storage);
+  if (!data_storage.check_time_step(id)) {
+    TIT_THROW("Time step {} does not exist.", time_step_id);
+  }
+  return py::make_tuple(data_storage.time_step_time(id),
+                        data_storage.time_step_uniforms_id(id).get(),
+                        data_storage.time_step_varyings_id(id).get());
+}
+
+// Get the names and the IDs of all the data arrays of the dataset.
+auto dataset_array_ids(py::Capsule storage, int64_t dataset_id) -> py::Dict {
+  const data::DataSetID id{dataset_id};
+  if (!storage_of(storage).check_dataset(id)) {
+    TIT_THROW("Dataset {} does not exist.", dataset_id);
+  }
+  py::Dict result{};
+  for (const auto& [name, array_id] :
+       storage_of(storage).dataset_array_ids(id)) {
+    result.set_at(name, array_id.get());
+  }
+  return result;
+}
+
+// Export the data arrays of the dataset through the Arrow PyCapsule
+// interface. Data arrays are decoded while the GIL is held, since the storage
+// is not thread-safe, and are then owned by the exported Arrow arrays.
+auto dataset_arrow(py::Capsule storage, int64_t dataset_id) -> py::Tuple {
+  const data::DataSetID id{dataset_id};
+  if (!storage_of(storage).check_dataset(id)) {
+    TIT_THROW("Dataset {} does not exist.", dataset_id);
+  }
+  const data::DataSetView dataset{storage_of(storage), id};
+  return py::arrow_capsules(data::arrow_record_batch(dataset));
+}
+
+// Read the data array into a new NumPy array.
+//
+// Encoded data is read while the GIL is held, since the storage is not
+// thread-safe. Data is then decoded with the GIL released, straight into the
+// NumPy array buffer. For the compressed arrays that are not chunked, the
+// number of values is only known after decoding, so they are decoded into
+// a temporary buffer and copied.
+auto read_array(py::Capsule storage, int64_t array_id) -> py::NDArray {
+  const data::DataArrayID id{array_id};
+  if (!storage_of(storage).check_array(id)) {
+    TIT_THROW("Data array {} does not exist.", array_id);
+  }
+  const auto encoded = storage_of(storage).array_data_encoded(id);
+  const auto type = encoded.type;
+  const auto make_array = [type](size_t num_values) {
+    std::vector<size_t> shape{num_values};
+    if (type.rank() != data::DataRank::scalar) shape.push_back(type.dim());
+    if (type.rank() == data::DataRank::matrix) shape.push_back(type.dim());
+    return py::NDArray{type.kind(), shape};
+  };
+  if (encoded.num_values.has_value()) {
+    const auto array = make_array(*encoded.num_values);
+    const auto bytes = array.bytes();
+    const py::ReleaseGIL released{};
+    encoded.decode_into(bytes);
+    return array;
+  }
+  const auto decoded = [&encoded] {
+    const py::ReleaseGIL released{};
+    return encoded.decode();
+  }();
+  const auto array = make_array(decoded.size() / type.width());
+  std::ranges::copy(decoded, array.bytes().begin());
+  return array;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Convert the array-like object into a contiguous array of the numbers.
+auto as_array(const py::Object& obj) -> py::NDArray {
+  return py::NDArray::from(obj, data::kind_of<float64_t>);
+}
+
+// Numbers of the contiguous array.
+auto nums_of(const py::NDArray& array) -> std::span<const float64_t> {
+  const auto bytes = array.bytes();
+  return {std::bit_cast<const float64_t*>(bytes.data()),
+          bytes.size() / sizeof(float64_t)};
+}
+
+// Scalar particle values, one per particle.
+auto scalars_of(const py::NDArray& array,
+                size_t num_particles,
+                std::string_view name) -> std::span<const float64_t> {
+  if (array.rank() != 1 || array.shape()[0] != num_particles) {
+    TIT_THROW("Array '{}' must be of shape ({},).", name, num_particles);
+  }
+  return nums_of(array);
+}
+
+// Call the function with the spatial dimension of the points array, that
+// must be of shape (N, D).
+template<class Func>
+auto with_dim(const py::NDArray& points, const Func& func) {
+  if (points.rank() == 2) {
+    switch (points.shape()[1]) {
+      case 1: return func.template operator()<1>();
+      case 2: return func.template operator()<2>();
+      case 3: return func.template operator()<3>();
+      default: break;
+    }
+  }
+  TIT_THROW("Points must be of shape (N, D), where D is 1, 2 or 3.");
+}
+
+// Copy the points array of shape (N, D) into a vector. Vector elements may
+// be padded, so the points could not be used in place.
+template<size_t Dim>
+auto points_of(const py::NDArray& array, std::string_view name)
+    -> std::vector<Vec<float64_t, Dim>> {
+  if (array.rank() != 2 || array.shape()[1] != Dim) {
+    TIT_THROW("Array '{}' must be of shape (N, {}).", name, Dim);
+  }
+  return array.values<Vec<float64_t, Dim>>();
+}
+
+// Interpolate the particle values of shape (N, K) onto the points.
+//
+// Arrays are converted while the GIL is held, and the interpolation runs
+// with the GIL released.
+auto interpolate(py::Object r_obj,
+                 py::Object V_obj,
+                 py::Object h_obj,
+                 py::Object vals_obj,
+                 py::Object points_obj) -> py::NDArray {
+  const auto r_array = as_array(r_obj);
+  return with_dim(r_array, [&]<size_t Dim>() {
+    const auto r = points_of<Dim>(r_array, "r");
+    const auto V_array = as_array(V_obj);
+    const auto V = scalars_of(V_array, r.size(), "V");
+    const auto h_array = as_array(h_obj);
+    const auto h = scalars_of(h_array, r.size(), "h");
+    const auto vals_array = as_array(vals_obj);
+    if (vals_array.rank() != 2 || vals_array.shape()[0] != r.size()) {
+      TIT_THROW("Array 'values' must be of shape ({}, K).", r.size());
+    }
+    const std::array shape{vals_array.shape()[0], vals_array.shape()[1]};
+    const Mdspan vals{nums_of(vals_array).begin(), shape};
+    const auto points = points_of<Dim>(as_array(points_obj), "points");
+    auto result = [&] {
+      const py::ReleaseGIL released{};
+      const sph::ParticleSnapshot snapshot{
+          sph::QuarticWendlandKernel{},
+          std::span<const Vec<float64_t, Dim>>{r},
+          V,
+          h};
+      return snapshot.interpolate(vals, points);
+    }();
+    return py::NDArray{std::move(result)};
+  });
+}
+
+// Compute the particle velocity curl, of shape (N, 3).
+auto vorticity(py::Object r_obj,
+               py::Object V_obj,
+               py::Object h_obj,
+               py::Object v_obj) -> py::NDArray {
+  const auto r_array = as_array(r_obj);
+  return with_dim(r_array, [&]<size_t Dim>() {
+    const auto r = points_of<Dim>(r_array, "r");
+    const auto V_array = as_array(V_obj);
+    const auto V = scalars_of(V_array, r.size(), "V");
+    const auto h_array = as_array(h_obj);
+    const auto h = scalars_of(h_array, r.size(), "h");
+    const auto v = points_of<Dim>(as_array(v_obj), "v");
+    if (v.size() != r.size()) {
+      TIT_THROW("Array 'v' must be of shape ({}, {}).", r.size(), Dim);
+    }
+    const auto curl_v = [&] {
+      const py::ReleaseGIL released{};
+      const sph::ParticleSnapshot snapshot{
+          sph::QuarticWendlandKernel{},
+          std::span<const Vec<float64_t, Dim>>{r},
+          V,
+          h};
+      return snapshot.vorticity(v);
+    }();
+    return py::NDArray::copy(std::span{curl_v});
+  });
+}
+
+// Compute the total kinetic energy of the particles.
+auto kinetic_energy(py::Object m_obj, py::Object v_obj) -> float64_t {
+  const auto v_array = as_array(v_obj);
+  return with_dim(v_array, [&]<size_t Dim>() {
+    const auto v = points_of<Dim>(v_array, "v");
+    const auto m_array = as_array(m_obj);
+    const auto m = scalars_of(m_array, v.size(), "m");
+    const py::ReleaseGIL released{};
+    return sph::kinetic_energy(m, std::span{v});
+  });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void init_module(const py::Module& m) {
+  m.def<"open", open_storage, py::Param<std::string, "path">>();
+  m.def<"series_ids", series_ids, py::Param<py::Capsule, "storage">>();
+  m.def<"series_parameters",
+        series_parameters,
+        py::Param<py::Capsule, "storage">,
+        py::Param<int64_t, "series_id">>();
+  m.def<"series_time_step_ids",
+        series_time_step_ids,
+        py::Param<py::Capsule, "storage">,
+        py::Param<int64_t, "series_id">>();
+  m.def<"time_step_info",
+        time_step_info,
+        py::Param<py::Capsule, "storage">,
+        py::Param<int64_t, "time_step_id">>();
+  m.def<"dataset_array_ids",
+        dataset_array_ids,
+        py::Param<py::Capsule, "storage">,
+        py::Param<int64_t, "dataset_id">>();
+  m.def<"dataset_arrow",
+        dataset_arrow,
+        py::Param<py::Capsule, "storage">,
+        py::Param<int64_t, "dataset_id">>();
+  m.def<"read_array",
+        read_array,
+        py::Param<py::Capsule, "storage">,
+        py::Param<int64_t, "array_id">>();
+  m.def<"interpolate",
+        interpolate,
+        py::Param<py::Object, "r">,
+        py::Param<py::Object, "V">,
+        py::Param<py::Object, "h">,
+        py::Param<py::Object, "values">,
+        py::Param<py::Object, "points">>();
+  m.def<"vorticity",
+        vorticity,
+        py::Param<py::Object, "r">,
+        py::Param<py::Object, "V">,
+        py::Param<py::Object, "h">,
+        py::Param<py::Object, "v">>();
+  m.def<"kinetic_energy",
+        kinetic_energy,
+        py::Param<py::Object, "m">,
+        py::Param<py::Object, "v">>();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
+
+TIT_PYTHON_MODULE(_pytit, tit::init_module)
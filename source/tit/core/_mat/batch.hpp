@@ -0,0 +1,382 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/mat.hpp"
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <expected>
+#include <span>
+#include <utility>
+
+#include "tit/core/_mat/fact.hpp"
+#include "tit/core/_mat/mat.hpp"
+#include "tit/core/_mat/sym.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/vec.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Chunk of the matrices, stored as a structure of arrays: each matrix entry
+// is a SIMD register, and each matrix of the chunk occupies a register lane.
+template<class Num, size_t Dim, size_t Size>
+class MatChunk final {
+public:
+
+  using Reg = simd::Reg<Num, Size>;
+
+  // Load the matrices of the chunk, either full or packed symmetric. Missing
+  // lanes are filled with the identity matrices, so that they could be
+  // factorized safely.
+  template<class Matrix>
+  explicit MatChunk(std::span<const Matrix> mats) {
+    TIT_ASSERT(mats.size() <= Size, "Chunk is too large!");
+    std::array<Num, Size> lanes{};
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j < Dim; ++j) {
+        for (size_t k = 0; k < Size; ++k) {
+          lanes[k] = k < mats.size() ? mats[k][i, j] : static_cast<Num>(i == j);
+        }
+        (*this)[i, j] = Reg(std::span<const Num>{lanes});
+      }
+    }
+  }
+
+  // Matrix entry at the given indices.
+  auto operator[](this auto& self, size_t i, size_t j) noexcept -> auto& {
+    TIT_ASSERT(i < Dim && j < Dim, "Index is out of range!");
+    return self.entries_[i * Dim + j];
+  }
+
+  // Replace the entry with one in the lanes where it is tiny, and mark these
+  // lanes as failed.
+  void guard_tiny(size_t i, size_t j) noexcept {
+    auto& entry = (*this)[i, j];
+    const auto is_tiny = max(entry, -entry) <= Reg(tiny_v<Num>);
+    failed_ = select(is_tiny, Reg(Num{1}), failed_);
+    entry = select(is_tiny, Reg(Num{1}), entry);
+  }
+
+  // Store the success flags of the lanes.
+  void store_ok(std::span<bool> ok) const noexcept {
+    TIT_ASSERT(ok.size() <= Size, "Chunk is too large!");
+    std::array<Num, Size> lanes{};
+    failed_.store(lanes);
+    for (size_t k = 0; k < ok.size(); ++k) ok[k] = lanes[k] == Num{0};
+  }
+
+  // Store the lower-triangular parts of the matrices of the chunk into the
+  // packed symmetric matrices. Nearly singular lanes are stored as zeroes.
+  void store_lower(std::span<SymMat<Num, Dim>> mats) const noexcept {
+    TIT_ASSERT(mats.size() <= Size, "Chunk is too large!");
+    std::array<Num, Size> failed{};
+    failed_.store(failed);
+    std::array<Num, Size> lanes{};
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j <= i; ++j) {
+        (*this)[i, j].store(lanes);
+        for (size_t k = 0; k < mats.size(); ++k) {
+          mats[k][i, j] = failed[k] == Num{0} ? lanes[k] : Num{0};
+        }
+      }
+    }
+  }
+
+private:
+
+  std::array<Reg, Dim * Dim> entries_;
+  Reg failed_{}; // Nearly singular lanes are marked with ones.
+
+}; // class MatChunk
+
+// Chunk of the vectors, stored as a structure of arrays.
+template<class Num, size_t Dim, size_t Size>
+class VecChunk final {
+public:
+
+  using Reg = simd::Reg<Num, Size>;
+
+  // Load the vectors of the chunk. Missing lanes are filled with zeroes.
+  explicit VecChunk(std::span<const Vec<Num, Dim>> vecs) {
+    TIT_ASSERT(vecs.size() <= Size, "Chunk is too large!");
+    std::array<Num, Size> lanes{};
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t k = 0; k < vecs.size(); ++k) lanes[k] = vecs[k][i];
+      entries_[i] = Reg(std::span<const Num>{lanes});
+    }
+  }
+
+  // Vector entry at the given index.
+  auto operator[](this auto& self, size_t i) noexcept -> auto& {
+    TIT_ASSERT(i < Dim, "Index is out of range!");
+    return self.entries_[i];
+  }
+
+  // Store the vectors of the chunk, skipping the lanes that are not ok.
+  void store(std::span<Vec<Num, Dim>> vecs,
+             std::span<const bool> ok) const noexcept {
+    TIT_ASSERT(vecs.size() <= Size, "Chunk is too large!");
+    TIT_ASSERT(ok.size() == vecs.size(), "Flags size mismatch!");
+    std::array<Num, Size> lanes{};
+    for (size_t i = 0; i < Dim; ++i) {
+      entries_[i].store(lanes);
+      for (size_t k = 0; k < vecs.size(); ++k) {
+        if (ok[k]) vecs[k][i] = lanes[k];
+      }
+    }
+  }
+
+private:
+
+  std::array<Reg, Dim> entries_;
+
+}; // class VecChunk
+
+// Factorize the chunk using LDL: `A = L * D * L^T`, in place.
+template<class Num, size_t Dim, size_t Size>
+void ldl_chunk(MatChunk<Num, Dim, Size>& LD) noexcept {
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      for (size_t k = 0; k < j; ++k) {
+        LD[i, j] -= LD[i, k] * LD[k, k] * LD[j, k];
+      }
+      LD[i, j] /= LD[j, j];
+    }
+    for (size_t k = 0; k < i; ++k) {
+      LD[i, i] -= LD[i, k] * LD[k, k] * LD[i, k];
+    }
+    LD.guard_tiny(i, i);
+  }
+}
+
+// Solve the equation using the LDL factorization of the chunk, in place.
+template<class Num, size_t Dim, size_t Size>
+void ldl_solve_chunk(const MatChunk<Num, Dim, Size>& LD,
+                     VecChunk<Num, Dim, Size>& x) noexcept {
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t k = 0; k < i; ++k) x[i] -= LD[i, k] * x[k];
+  }
+  for (size_t i = 0; i < Dim; ++i) x[i] /= LD[i, i];
+  for (size_t i = Dim; i-- > 0;) {
+    for (size_t k = i + 1; k < Dim; ++k) x[i] -= LD[k, i] * x[k];
+  }
+}
+
+// Factorize the chunk using LU: `A = L * U`, in place.
+template<class Num, size_t Dim, size_t Size>
+void lu_chunk(MatChunk<Num, Dim, Size>& LU) noexcept {
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      for (size_t k = 0; k < j; ++k) LU[i, j] -= LU[i, k] * LU[k, j];
+      LU[i, j] /= LU[j, j];
+    }
+    for (size_t j = i; j < Dim; ++j) {
+      for (size_t k = 0; k < i; ++k) LU[i, j] -= LU[i, k] * LU[k, j];
+    }
+    LU.guard_tiny(i, i);
+  }
+}
+
+// Solve the equation using the LU factorization of the chunk, in place.
+template<class Num, size_t Dim, size_t Size>
+void lu_solve_chunk(const MatChunk<Num, Dim, Size>& LU,
+                    VecChunk<Num, Dim, Size>& x) noexcept {
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t k = 0; k < i; ++k) x[i] -= LU[i, k] * x[k];
+  }
+  for (size_t i = Dim; i-- > 0;) {
+    for (size_t k = i + 1; k < Dim; ++k) x[i] -= LU[i, k] * x[k];
+    x[i] /= LU[i, i];
+  }
+}
+
+// Factorize the batch of matrices and solve the equations in place, chunk
+// by chunk. Falls back to the one by one factorization if the number type
+// is not supported by SIMD.
+template<class Num, size_t Dim, class Matrix, class... Xs>
+void fact_solve_batch(auto fact,
+                      auto fact_chunk,
+                      auto solve_chunk,
+                      std::span<const Matrix> A,
+                      std::span<bool> ok,
+                      Xs... x) {
+  TIT_ASSERT(ok.size() == A.size(), "Flags size mismatch!");
+  TIT_ASSERT(((x.size() == A.size()) && ...), "Vectors size mismatch!");
+  if constexpr (simd::supported_type<Num>) {
+    constexpr auto Size = simd::max_reg_size_v<Num>;
+    for (size_t first = 0; first < A.size(); first += Size) {
+      const auto count = std::min(Size, A.size() - first);
+      MatChunk<Num, Dim, Size> chunk{A.subspan(first, count)};
+      fact_chunk(chunk);
+      const auto chunk_ok = ok.subspan(first, count);
+      chunk.store_ok(chunk_ok);
+      const auto solve = [&chunk, &solve_chunk, first, count, chunk_ok](
+                             std::span<Vec<Num, Dim>> xs) {
+        const auto chunk_xs = xs.subspan(first, count);
+        VecChunk<Num, Dim, Size> chunk_x{chunk_xs};
+        solve_chunk(chunk, chunk_x);
+        chunk_x.store(chunk_xs, chunk_ok);
+      };
+      (solve(x), ...);
+    }
+  } else {
+    for (size_t k = 0; k < A.size(); ++k) {
+      const auto result = fact(A[k]);
+      ok[k] = result.has_value();
+      if (result) ((x[k] = result->solve(x[k])), ...);
+    }
+  }
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Solve the batch of the symmetric matrix equations `A[k] * x[k] = b[k]`
+/// using the LDL factorization.
+///
+/// Matrices are processed in chunks of the SIMD register size, each matrix
+/// of the chunk occupies a register lane. This is much faster than calling
+/// `ldl` on each of the small matrices one by one.
+///
+/// @param A  Matrices, only the lower-triangular parts are accessed.
+/// @param ok Success flags. Equations with the nearly singular matrices are
+///           left unsolved, and `false` is stored into their flags.
+/// @param x  Right hand sides, that are replaced with the solutions. Several
+///           right hand sides may be passed to reuse the factorizations.
+template<class Num, size_t Dim, std::same_as<std::span<Vec<Num, Dim>>>... Xs>
+void ldl_solve_batch(std::span<const Mat<Num, Dim>> A,
+                     std::span<bool> ok,
+                     Xs... x) {
+  impl::fact_solve_batch<Num, Dim>(
+      [](const auto& A_k) { return ldl(A_k); },
+      [](auto& chunk) { impl::ldl_chunk(chunk); },
+      [](const auto& chunk, auto& chunk_x) {
+        impl::ldl_solve_chunk(chunk, chunk_x);
+      },
+      A,
+      ok,
+      x...);
+}
+
+/// Solve the batch of the packed symmetric matrix equations
+/// `A[k] * x[k] = b[k]` using the LDL factorization.
+///
+/// @copydetails ldl_solve_batch
+template<class Num, size_t Dim, std::same_as<std::span<Vec<Num, Dim>>>... Xs>
+void ldl_solve_batch(std::span<const SymMat<Num, Dim>> A,
+                     std::span<bool> ok,
+                     Xs... x) {
+  impl::fact_solve_batch<Num, Dim>(
+      [](const auto& A_k) { return ldl(A_k); },
+      [](auto& chunk) { impl::ldl_chunk(chunk); },
+      [](const auto& chunk, auto& chunk_x) {
+        impl::ldl_solve_chunk(chunk, chunk_x);
+      },
+      A,
+      ok,
+      x...);
+}
+
+/// Factorize the batch of the packed symmetric matrices using the LDL
+/// factorization, in place, so that the factors could be reused by
+/// `ldl_factored_solve_batch` for many right hand sides.
+///
+/// Factors are packed into the lower-triangular parts of the matrices: `L`
+/// below the diagonal (its unit diagonal is implied), and `D` on the
+/// diagonal. Nearly singular matrices are replaced with zeroes.
+template<class Num, size_t Dim>
+void ldl_batch(std::span<SymMat<Num, Dim>> A) {
+  if constexpr (simd::supported_type<Num>) {
+    constexpr auto Size = simd::max_reg_size_v<Num>;
+    for (size_t first = 0; first < A.size(); first += Size) {
+      const auto chunk_A = A.subspan(first, std::min(Size, A.size() - first));
+      impl::MatChunk<Num, Dim, Size> chunk{
+          std::span<const SymMat<Num, Dim>>{chunk_A}};
+      impl::ldl_chunk(chunk);
+      chunk.store_lower(chunk_A);
+    }
+  } else {
+    for (auto& A_k : A) {
+      const auto fact = ldl(A_k);
+      if (!fact) {
+        A_k = {};
+        continue;
+      }
+      const auto L = fact->L();
+      const auto D = fact->D();
+      for (size_t i = 0; i < Dim; ++i) {
+        for (size_t j = 0; j < i; ++j) A_k[i, j] = L[i, j];
+        A_k[i, i] = D[i, i];
+      }
+    }
+  }
+}
+
+/// Solve the batch of the symmetric matrix equations `A[k] * x[k] = b[k]`
+/// using the packed LDL factors of the matrices, see `ldl_batch`.
+///
+/// @param LD Packed factors. Equations with the zero factors, i.e. with the
+///           nearly singular matrices, are left unsolved, and `false` is
+///           stored into their flags.
+/// @param ok Success flags.
+/// @param x  Right hand sides, that are replaced with the solutions.
+template<class Num, size_t Dim, std::same_as<std::span<Vec<Num, Dim>>>... Xs>
+void ldl_factored_solve_batch(std::span<const SymMat<Num, Dim>> LD,
+                              std::span<bool> ok,
+                              Xs... x) {
+  impl::fact_solve_batch<Num, Dim>(
+      [](const auto& LD_k) -> FactResult<FactLDL<Mat<Num, Dim>>> {
+        Mat<Num, Dim> unpacked;
+        for (size_t i = 0; i < Dim; ++i) {
+          if (is_tiny(LD_k[i, i])) {
+            return std::unexpected{FactError::near_singular};
+          }
+          for (size_t j = 0; j <= i; ++j) unpacked[i, j] = LD_k[i, j];
+        }
+        return FactLDL{std::move(unpacked)};
+      },
+      [](auto& chunk) {
+        for (size_t i = 0; i < Dim; ++i) chunk.guard_tiny(i, i);
+      },
+      [](const auto& chunk, auto& chunk_x) {
+        impl::ldl_solve_chunk(chunk, chunk_x);
+      },
+      LD,
+      ok,
+      x...);
+}
+
+/// Solve the batch of the matrix equations `A[k] * x[k] = b[k]` using the
+/// LU factorization.
+///
+/// @copydetails ldl_solve_batch
+template<class Num, size_t Dim, std::same_as<std::span<Vec<Num, Dim>>>... Xs>
+void lu_solve_batch(std::span<const Mat<Num, Dim>> A,
+                    std::span<bool> ok,
+                    Xs... x) {
+  impl::fact_solve_batch<Num, Dim>(
+      [](const auto& A_k) { return lu(A_k); },
+      [](auto& chunk) { impl::lu_chunk(chunk); },
+      [](const auto& chunk, auto& chunk_x) {
+        impl::lu_solve_chunk(chunk, chunk_x);
+      },
+      A,
+      ok,
+      x...);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
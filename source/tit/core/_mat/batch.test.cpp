@@ -0,0 +1,108 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/math.hpp" // IWYU pragma: keep
+#include "tit/core/vec.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using Mat3 = Mat<double, 3>;
+using Vec3 = Vec<double, 3>;
+
+// Batch of the small matrices, large enough to span several SIMD chunks and
+// to have a partial last chunk. The matrix with the given index is singular.
+auto make_batch(size_t size, size_t singular_index) -> std::vector<Mat3> {
+  std::vector<Mat3> A(size);
+  for (size_t k = 0; k < size; ++k) {
+    const auto t = static_cast<double>(k);
+    A[k] = Mat3{
+        {4.0 + t, 1.0, 0.5 * t},
+        {1.0, 3.0 + t, 0.25},
+        {0.5 * t, 0.25, 2.0 + 2.0 * t},
+    };
+  }
+  A[singular_index] = Mat3{
+      {1.0, 2.0, 3.0},
+      {2.0, 4.0, 6.0},
+      {3.0, 6.0, 9.0},
+  };
+  return A;
+}
+
+auto make_rhs(size_t size) -> std::vector<Vec3> {
+  std::vector<Vec3> b(size);
+  for (size_t k = 0; k < size; ++k) {
+    const auto t = static_cast<double>(k);
+    b[k] = Vec3{1.0 + t, 2.0 - t, 0.5 * t};
+  }
+  return b;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Mat::ldl_solve_batch") {
+  constexpr size_t size = 13;
+  constexpr size_t singular_index = 5;
+  const auto A = make_batch(size, singular_index);
+  const auto b = make_rhs(size);
+  auto x = b;
+  auto y = b;
+  std::array<bool, size> ok{};
+  ldl_solve_batch(std::span<const Mat3>{A},
+                  std::span{ok},
+                  std::span{x},
+                  std::span{y});
+  for (size_t k = 0; k < size; ++k) {
+    const auto fact = ldl(A[k]);
+    CHECK(ok[k] == fact.has_value());
+    if (!fact) {
+      // Equations with the singular matrices must be left unsolved.
+      CHECK(all(x[k] == b[k]));
+      CHECK(all(y[k] == b[k]));
+      continue;
+    }
+    CHECK_APPROX_EQ(x[k], fact->solve(b[k]));
+    CHECK_APPROX_EQ(y[k], x[k]);
+  }
+}
+
+TEST_CASE("Mat::lu_solve_batch") {
+  constexpr size_t size = 13;
+  constexpr size_t singular_index = 9;
+  auto A = make_batch(size, singular_index);
+  for (size_t k = 0; k < size; ++k) {
+    if (k != singular_index) A[k][0, 2] += 1.0; // Make it non-symmetric.
+  }
+  const auto b = make_rhs(size);
+  auto x = b;
+  std::array<bool, size> ok{};
+  lu_solve_batch(std::span<const Mat3>{A}, std::span{ok}, std::span{x});
+  for (size_t k = 0; k < size; ++k) {
+    const auto fact = lu(A[k]);
+    CHECK(ok[k] == fact.has_value());
+    if (!fact) {
+      CHECK(all(x[k] == b[k]));
+      continue;
+    }
+    CHECK_APPROX_EQ(x[k], fact->solve(b[k]));
+    CHECK_APPROX_EQ(A[k] * x[k], b[k]);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
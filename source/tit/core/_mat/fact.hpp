@@ -11,6 +11,7 @@
 
 #include "tit/core/_mat/mat.hpp"
 #include "tit/core/_mat/part.hpp"
+#include "tit/core/_mat/sym.hpp"
 #include "tit/core/_mat/traits.hpp"
 #include "tit/core/basic_types.hpp"
 #include "tit/core/math.hpp"
@@ -226,16 +227,12 @@ private:
 
 }; // class FactLDL
 
-/// Compute the Modified Cholesky matrix factorization: `A = L * D * L^T`,
-/// where `D` is a diagonal matrix and `L` is a lower-triangular matrix with
-/// unit diagonal.
-///
-/// Suitable for symmetric matrices.
-///
-/// Only the lower-triangular part of the input matrix is accessed.
-template<class Num, size_t Dim>
-constexpr auto ldl(const Mat<Num, Dim>& A)
-    -> FactResult<FactLDL<Mat<Num, Dim>>> {
+namespace impl {
+
+// Compute the LDL factorization, accessing only the lower-triangular part of
+// the input matrix.
+template<class Num, size_t Dim, class Matrix>
+constexpr auto ldl(const Matrix& A) -> FactResult<FactLDL<Mat<Num, Dim>>> {
   Mat<Num, Dim> LD;
   auto& L = LD;
   auto& D = LD;
@@ -258,6 +255,29 @@ constexpr auto ldl(const Mat<Num, Dim>& A)
   return FactLDL{std::move(LD)};
 }
 
+} // namespace impl
+
+/// Compute the Modified Cholesky matrix factorization: `A = L * D * L^T`,
+/// where `D` is a diagonal matrix and `L` is a lower-triangular matrix with
+/// unit diagonal.
+///
+/// Suitable for symmetric matrices.
+///
+/// Only the lower-triangular part of the input matrix is accessed.
+template<class Num, size_t Dim>
+constexpr auto ldl(const Mat<Num, Dim>& A)
+    -> FactResult<FactLDL<Mat<Num, Dim>>> {
+  return impl::ldl<Num, Dim>(A);
+}
+
+/// Compute the Modified Cholesky matrix factorization of the packed symmetric
+/// matrix, directly from its packed entries.
+template<class Num, size_t Dim>
+constexpr auto ldl(const SymMat<Num, Dim>& A)
+    -> FactResult<FactLDL<Mat<Num, Dim>>> {
+  return impl::ldl<Num, Dim>(A);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
@@ -0,0 +1,253 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/mat.hpp"
+#pragma once
+
+#include <array>
+#include <format>
+#include <utility>
+
+#include "tit/core/_mat/mat.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Symmetric square matrix, with the packed upper-triangular storage.
+///
+/// Only `Dim * (Dim + 1) / 2` entries are stored, and both `A[i, j]` and
+/// `A[j, i]` refer to the same entry.
+template<class Num, size_t Dim>
+class SymMat final {
+public:
+
+  /// Number of the stored entries.
+  static constexpr size_t num_entries = Dim * (Dim + 1) / 2;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Fill-initialize the matrix with zeroes.
+  constexpr SymMat() = default;
+
+  /// Fill-initialize the matrix diagonal with the value @p q.
+  constexpr explicit(Dim > 1) SymMat(const Num& q) {
+    for (size_t i = 0; i < Dim; ++i) (*this)[i, i] = q;
+  }
+
+  /// Initialize a matrix with the upper-triangular part of the matrix.
+  constexpr explicit SymMat(const Mat<Num, Dim>& A) {
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = i; j < Dim; ++j) (*this)[i, j] = A[i, j];
+    }
+  }
+
+  /// Packed entries array.
+  constexpr auto entries(this auto&& self) noexcept -> auto&& {
+    return TIT_FORWARD_LIKE(self, self.entries_);
+  }
+
+  /// Matrix element at index.
+  constexpr auto operator[](this auto&& self, size_t i, size_t j) noexcept
+      -> auto&& {
+    TIT_ASSERT(i < Dim, "Row index is out of range!");
+    TIT_ASSERT(j < Dim, "Column index is out of range!");
+    if (i > j) std::swap(i, j);
+    const auto k = i * (2 * Dim - i - 1) / 2 + j;
+    return TIT_FORWARD_LIKE(self, self.entries_[k]);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Matrix unary plus.
+  friend constexpr auto operator+(const SymMat& A) noexcept -> SymMat {
+    return A;
+  }
+
+  /// Matrix addition.
+  friend constexpr auto operator+(const SymMat& A, const SymMat& B)
+      -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < num_entries; ++k) {
+      R.entries_[k] = A.entries_[k] + B.entries_[k];
+    }
+    return R;
+  }
+
+  /// Matrix addition with assignment.
+  friend constexpr auto operator+=(SymMat& A, const SymMat& B) -> SymMat& {
+    for (size_t k = 0; k < num_entries; ++k) A.entries_[k] += B.entries_[k];
+    return A;
+  }
+
+  /// Matrix negation.
+  friend constexpr auto operator-(const SymMat& A) -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < num_entries; ++k) R.entries_[k] = -A.entries_[k];
+    return R;
+  }
+
+  /// Matrix subtraction.
+  friend constexpr auto operator-(const SymMat& A, const SymMat& B)
+      -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < num_entries; ++k) {
+      R.entries_[k] = A.entries_[k] - B.entries_[k];
+    }
+    return R;
+  }
+
+  /// Matrix subtraction with assignment.
+  friend constexpr auto operator-=(SymMat& A, const SymMat& B) -> SymMat& {
+    for (size_t k = 0; k < num_entries; ++k) A.entries_[k] -= B.entries_[k];
+    return A;
+  }
+
+  /// Matrix-scalar multiplication.
+  /// @{
+  friend constexpr auto operator*(const Num& a, const SymMat& B) -> SymMat {
+    return B * a;
+  }
+  friend constexpr auto operator*(const SymMat& A, const Num& b) -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < num_entries; ++k) R.entries_[k] = A.entries_[k] * b;
+    return R;
+  }
+  /// @}
+
+  /// Matrix-scalar multiplication with assignment.
+  friend constexpr auto operator*=(SymMat& A, const Num& b) -> SymMat& {
+    for (size_t k = 0; k < num_entries; ++k) A.entries_[k] *= b;
+    return A;
+  }
+
+  /// Matrix-vector multiplication.
+  friend constexpr auto operator*(const SymMat& A, const Vec<Num, Dim>& b)
+      -> Vec<Num, Dim> {
+    Vec<Num, Dim> r{};
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j < Dim; ++j) r[i] += A[i, j] * b[j];
+    }
+    return r;
+  }
+
+  /// Matrix-scalar division.
+  friend constexpr auto operator/(const SymMat& A, const Num& b) -> SymMat {
+    return A * inverse(b);
+  }
+
+  /// Matrix-scalar division with assignment.
+  friend constexpr auto operator/=(SymMat& A, const Num& b) -> SymMat& {
+    return A *= inverse(b);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Matrix exact equality operator.
+  friend constexpr auto operator==(const SymMat& A, const SymMat& B) noexcept
+      -> bool = default;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  std::array<Num, num_entries> entries_{};
+
+}; // class SymMat
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Expand the symmetric matrix into the full one.
+template<class Num, size_t Dim>
+constexpr auto full(const SymMat<Num, Dim>& A) -> Mat<Num, Dim> {
+  Mat<Num, Dim> R;
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t j = 0; j < Dim; ++j) R[i, j] = A[i, j];
+  }
+  return R;
+}
+
+/// Matrix trace (sum of the diagonal elements).
+template<class Num, size_t Dim>
+constexpr auto tr(const SymMat<Num, Dim>& A) -> Num {
+  auto r = A[0, 0];
+  for (size_t i = 1; i < Dim; ++i) r += A[i, i];
+  return r;
+}
+
+/// Symmetric part of the vector outer product: `(a * b^T + b * a^T) / 2`.
+template<class Num, size_t Dim>
+constexpr auto sym_outer(const Vec<Num, Dim>& a, const Vec<Num, Dim>& b)
+    -> SymMat<Num, Dim> {
+  SymMat<Num, Dim> R;
+  for (size_t i = 0; i < Dim; ++i) {
+    R[i, i] = a[i] * b[i];
+    for (size_t j = i + 1; j < Dim; ++j) {
+      R[i, j] = Num{0.5} * (a[i] * b[j] + a[j] * b[i]);
+    }
+  }
+  return R;
+}
+
+/// Vector outer square: `a * a^T`, only the upper triangle is computed.
+template<class Num, size_t Dim>
+constexpr auto sym_outer_sqr(const Vec<Num, Dim>& a) -> SymMat<Num, Dim> {
+  SymMat<Num, Dim> R;
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t j = i; j < Dim; ++j) R[i, j] = a[i] * a[j];
+  }
+  return R;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Matrix approximate equality operator.
+template<class Num, size_t Dim>
+constexpr auto approx_equal_to(const SymMat<Num, Dim>& A,
+                               const SymMat<Num, Dim>& B) noexcept -> bool {
+  for (size_t k = 0; k < SymMat<Num, Dim>::num_entries; ++k) {
+    if (!approx_equal_to(A.entries()[k], B.entries()[k])) return false;
+  }
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Serialize a symmetric matrix into the output stream. Matrix is stored
+/// expanded, in the same layout as the full matrix.
+template<class Stream, class Num, size_t Dim>
+constexpr void serialize(Stream& out, const SymMat<Num, Dim>& mat) {
+  serialize(out, full(mat));
+}
+
+/// Deserialize a symmetric matrix from the input stream.
+template<class Stream, class Num, size_t Dim>
+constexpr auto deserialize(Stream& in, SymMat<Num, Dim>& mat) -> bool {
+  Mat<Num, Dim> full_mat;
+  if (!deserialize(in, full_mat)) return false;
+  mat = SymMat<Num, Dim>{full_mat};
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
+
+// Symmetric matrix formatter.
+template<class Num, tit::size_t Dim>
+struct std::formatter<tit::SymMat<Num, Dim>> {
+  constexpr auto parse(auto& context) {
+    return context.begin();
+  }
+  constexpr auto format(const tit::SymMat<Num, Dim>& A, auto& context) const {
+    return std::format_to(context.out(), "{}", full(A));
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,142 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <span>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/math.hpp" // IWYU pragma: keep
+#include "tit/core/vec.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using Mat3 = Mat<double, 3>;
+using SymMat3 = SymMat<double, 3>;
+using Vec3 = Vec<double, 3>;
+
+TEST_CASE("SymMat") {
+  const Mat3 A{
+      {4.0, 1.0, 0.5},
+      {1.0, 3.0, 0.25},
+      {0.5, 0.25, 2.0},
+  };
+  const SymMat3 S{A};
+  STATIC_CHECK(SymMat3::num_entries == 6);
+  SUBCASE("access") {
+    CHECK(S[0, 1] == 1.0);
+    CHECK(S[1, 0] == 1.0);
+    CHECK(S[2, 1] == 0.25);
+    CHECK(full(S) == A);
+    CHECK(tr(S) == tr(A));
+    auto T = S;
+    T[2, 0] = 7.0;
+    CHECK(T[0, 2] == 7.0);
+  }
+  SUBCASE("operations") {
+    CHECK(full(S + S) == A + A);
+    CHECK(full(S - 2.0 * S) == A - 2.0 * A);
+    CHECK(full(S / 2.0) == A / 2.0);
+    CHECK_APPROX_EQ(S * Vec3{1.0, 2.0, 3.0}, A * Vec3{1.0, 2.0, 3.0});
+    auto T = S;
+    T += S;
+    T *= 0.5;
+    CHECK(T == S);
+  }
+  SUBCASE("outer") {
+    const Vec3 a{1.0, 2.0, 3.0};
+    const Vec3 b{2.0, 4.0, 6.0};
+    CHECK(full(sym_outer_sqr(a)) == outer_sqr(a));
+    CHECK(full(sym_outer(a, b)) == outer(a, b));
+    const Vec3 c{1.0, 0.0, 0.0};
+    CHECK(sym_outer(a, c)[0, 1] == 1.0);
+    CHECK(sym_outer(a, c)[1, 0] == 1.0);
+  }
+}
+
+TEST_CASE("SymMat::ldl") {
+  const Mat3 A{
+      {4.0, 1.0, 0.5},
+      {1.0, 3.0, 0.25},
+      {0.5, 0.25, 2.0},
+  };
+  const auto fact = ldl(SymMat3{A});
+  REQUIRE(fact);
+  const auto expected = ldl(A);
+  REQUIRE(expected);
+  CHECK_APPROX_EQ(fact->L(), expected->L());
+  CHECK_APPROX_EQ(fact->D(), expected->D());
+  const Vec3 b{1.0, 2.0, 3.0};
+  CHECK_APPROX_EQ(A * fact->solve(b), b);
+  SUBCASE("singular") {
+    CHECK_FALSE(ldl(sym_outer_sqr(Vec3{1.0, 2.0, 3.0})));
+  }
+}
+
+TEST_CASE("SymMat::ldl_solve_batch") {
+  const std::array A{
+      SymMat3{Mat3{{4.0, 1.0, 0.5}, {1.0, 3.0, 0.25}, {0.5, 0.25, 2.0}}},
+      sym_outer_sqr(Vec3{1.0, 2.0, 3.0}),
+      SymMat3{2.0},
+  };
+  const std::array b{
+      Vec3{1.0, 2.0, 3.0},
+      Vec3{1.0, 1.0, 1.0},
+      Vec3{2.0, 2.0, 2.0},
+  };
+  auto x = b;
+  std::array<bool, A.size()> ok{};
+  ldl_solve_batch(std::span<const SymMat3>{A},
+                  std::span{ok},
+                  std::span{x});
+  for (size_t k = 0; k < A.size(); ++k) {
+    const auto fact = ldl(A[k]);
+    CHECK(ok[k] == fact.has_value());
+    if (!fact) {
+      CHECK(all(x[k] == b[k]));
+      continue;
+    }
+    CHECK_APPROX_EQ(x[k], fact->solve(b[k]));
+  }
+}
+
+TEST_CASE("SymMat::ldl_batch") {
+  std::array A{
+      SymMat3{Mat3{{4.0, 1.0, 0.5}, {1.0, 3.0, 0.25}, {0.5, 0.25, 2.0}}},
+      sym_outer_sqr(Vec3{1.0, 2.0, 3.0}),
+      SymMat3{2.0},
+  };
+  const auto original = A;
+  ldl_batch(std::span{A});
+  const std::array b{
+      Vec3{1.0, 2.0, 3.0},
+      Vec3{1.0, 1.0, 1.0},
+      Vec3{2.0, 2.0, 2.0},
+  };
+  auto x = b;
+  std::array<bool, A.size()> ok{};
+  ldl_factored_solve_batch(std::span<const SymMat3>{A},
+                           std::span{ok},
+                           std::span{x});
+  for (size_t k = 0; k < A.size(); ++k) {
+    const auto fact = ldl(original[k]);
+    CHECK(ok[k] == fact.has_value());
+    if (!fact) {
+      CHECK(all(x[k] == b[k]));
+      continue;
+    }
+    CHECK_APPROX_EQ(x[k], fact->solve(b[k]));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -6,7 +6,12 @@
 // IWYU pragma: private, include "tit/core/simd.hpp"
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
 #include <span>
+#include <type_traits>
 
 #include <hwy/highway.h>
 
@@ -14,6 +19,7 @@
 #include "tit/core/_simd/traits.hpp"
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
 
 namespace tit::simd {
 
@@ -70,6 +76,80 @@ public:
     hn::StoreU(base, Tag{}, span.data());
   }
 
+  /// Gather SIMD register from memory: the lane `k` is loaded from
+  /// `span[indices[k]]`.
+  template<std::integral Index>
+    requires (sizeof(Num) >= 4)
+  [[gnu::always_inline]]
+  Reg(std::span<const Num> span, std::span<const Index> indices) noexcept {
+    TIT_ASSERT(indices.size() >= Size, "Indices size is too small!");
+    base = hn::GatherIndex( // NOLINT(*-prefer-member-initializer)
+        Tag{},
+        std::bit_cast<const Lane_*>(span.data()),
+        load_indices_(span.size(), indices));
+  }
+
+  /// Scatter SIMD register into memory: the lane `k` is stored into
+  /// `span[indices[k]]`. Indices must be distinct.
+  template<std::integral Index>
+    requires (sizeof(Num) >= 4)
+  [[gnu::always_inline]]
+  void scatter(std::span<Num> span,
+               std::span<const Index> indices) const noexcept {
+    TIT_ASSERT(indices.size() >= Size, "Indices size is too small!");
+    hn::ScatterIndex(base,
+                     Tag{},
+                     std::bit_cast<Lane_*>(span.data()),
+                     load_indices_(span.size(), indices));
+  }
+
+  /// Scatter-add SIMD register into memory: the lane `k` is added to
+  /// `span[indices[k]]`.
+  ///
+  /// Indices may repeat, as in the neighbor lists of a single particle, in
+  /// which case all the conflicting lanes are accumulated. Conflicts are
+  /// detected with an index comparison, and the vector gather-add-scatter is
+  /// used if there are none.
+  template<std::integral Index>
+    requires (sizeof(Num) >= 4)
+  void scatter_add(std::span<Num> span,
+                   std::span<const Index> indices) const noexcept {
+    TIT_ASSERT(indices.size() >= Size, "Indices size is too small!");
+    bool conflict = false;
+    for (size_t i = 1; i < Size; ++i) {
+      for (size_t j = 0; j < i; ++j) conflict |= indices[i] == indices[j];
+    }
+    if (!conflict) {
+      const auto idx = load_indices_(span.size(), indices);
+      const auto data = std::bit_cast<Lane_*>(span.data());
+      hn::ScatterIndex(hn::GatherIndex(Tag{}, data, idx) + base,
+                       Tag{},
+                       data,
+                       idx);
+      return;
+    }
+    std::array<Num, Size> lanes;
+    store(lanes);
+    for (size_t k = 0; k < Size; ++k) {
+      TIT_ASSERT(static_cast<size_t>(indices[k]) < span.size(),
+                 "Index is out of range!");
+      span[indices[k]] += lanes[k];
+    }
+  }
+
+  /// Compress-store SIMD register into memory: the lanes selected by the mask
+  /// are stored contiguously, in order, and the rest of the span is left
+  /// intact. Returns the number of the stored lanes.
+  [[gnu::always_inline]]
+  auto compress_store(const RegMask& m, std::span<Num> span) const noexcept
+      -> size_t {
+    TIT_ASSERT(span.size() >= Size, "Data size is too small!");
+    return hn::CompressBlendedStore(base,
+                                    m.base,
+                                    Tag{},
+                                    std::bit_cast<Lane_*>(span.data()));
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// SIMD unary plus operation.
@@ -172,6 +252,27 @@ public:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+private:
+
+  using Lane_ = impl::fixed_width_type_t<Num>;
+  using IndexTag_ = hn::RebindToSigned<Tag>;
+  using LaneIndex_ = hn::TFromD<IndexTag_>;
+
+  // Load the gather or scatter indices into the index register, that has
+  // the same lane width as the data register.
+  template<std::integral Index>
+  [[gnu::always_inline]]
+  static auto load_indices_(size_t size,
+                            std::span<const Index> indices) noexcept {
+    std::array<LaneIndex_, Size> lanes;
+    for (size_t k = 0; k < Size; ++k) {
+      TIT_ASSERT(static_cast<size_t>(indices[k]) < size,
+                 "Index is out of range!");
+      lanes[k] = static_cast<LaneIndex_>(indices[k]);
+    }
+    return hn::LoadU(IndexTag_{}, lanes.data());
+  }
+
 }; // class Reg
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -249,6 +350,74 @@ inline auto ceil(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
   return hn::Ceil(a.base);
 }
 
+/// SIMD `sqrt` function overload.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto sqrt(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  return hn::Sqrt(a.base);
+}
+
+/// SIMD `approx_rsqrt` function overload.
+///
+/// The initial guess and the Newton iterations are the same as in the scalar
+/// `approx_rsqrt`, so are the results.
+/// @{
+template<size_t Iters, std::floating_point Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto approx_rsqrt(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  using Tag = typename Reg<Num, Size>::Tag;
+  using BitsTag = hn::RebindToUnsigned<Tag>;
+  using Bits = hn::TFromD<BitsTag>;
+  constexpr Bits magic = sizeof(Num) == sizeof(uint32_t) ?
+                             Bits{0x5F375A86} :
+                             static_cast<Bits>(0x5FE6EB50C7B537A9);
+  Reg<Num, Size> y = hn::BitCast(
+      Tag{},
+      hn::Sub(hn::Set(BitsTag{}, magic),
+              hn::ShiftRight<1>(hn::BitCast(BitsTag{}, a.base))));
+  const auto half_a = Reg<Num, Size>(Num{0.5}) * a;
+  for (size_t i = 0; i < Iters; ++i) {
+    y *= Reg<Num, Size>(Num{1.5}) - half_a * y * y;
+  }
+  return y;
+}
+template<std::floating_point Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto approx_rsqrt(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  return approx_rsqrt<rsqrt_iters_v<Num>>(a);
+}
+/// @}
+
+/// SIMD `pow` function overload.
+///
+/// Integer powers are computed by the repeated squaring, in at most
+/// `2 * log2(|power|) + 1` multiplications, so the relative error is bounded
+/// by that many rounding errors, and no `exp`/`log` approximation is needed.
+/// Other powers are computed lane-wise with the scalar `std::pow`.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+inline auto pow(const Reg<Num, Size>& a,
+                std::type_identity_t<Num> power) noexcept
+    -> Reg<Num, Size> {
+  static constexpr Num max_int_power{1 << 16};
+  if (std::floor(power) == power && std::abs(power) <= max_int_power) {
+    auto n = static_cast<uint32_t>(std::abs(power));
+    Reg<Num, Size> result(Num{1});
+    for (auto base = a; n != 0; n >>= 1) {
+      if ((n & 1U) != 0) result *= base;
+      if (n > 1) base *= base;
+    }
+    return power < Num{0} ? Reg<Num, Size>(Num{1}) / result : result;
+  }
+  std::array<Num, Size> lanes;
+  a.store(lanes);
+  for (auto& lane : lanes) lane = std::pow(lane, power);
+  return Reg<Num, Size>(lanes);
+}
+
 /// SIMD fused multiply-add operation.
 template<class Num, size_t Size>
   requires supported<Num, Size>
@@ -4,7 +4,11 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <array>
+#include <cmath>
+#include <span>
 
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
 #include "tit/core/simd.hpp"
 
 #include "tit/testing/test.hpp"
@@ -93,6 +97,52 @@ TEST_CASE("simd::Reg::select") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("simd::Reg::gather") {
+  const std::array data{0.0F, 1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F, 7.0F};
+  const std::array<size_t, 4> indices{7, 0, 5, 5};
+  const FloatReg r(std::span<const float>{data},
+                   std::span<const size_t>{indices});
+  FloatArray out{};
+  r.store(out);
+  CHECK(out == FloatArray{7.0F, 0.0F, 5.0F, 5.0F});
+}
+
+TEST_CASE("simd::Reg::scatter") {
+  std::array<float, 8> data{};
+  const std::array<uint32_t, 4> indices{6, 1, 3, 0};
+  FloatReg{FloatArray{1.0F, 2.0F, 3.0F, 4.0F}}.scatter(
+      std::span{data},
+      std::span<const uint32_t>{indices});
+  CHECK(data == std::array{4.0F, 2.0F, 0.0F, 3.0F, 0.0F, 0.0F, 1.0F, 0.0F});
+}
+
+TEST_CASE("simd::Reg::scatter_add") {
+  std::array<float, 4> data{1.0F, 1.0F, 1.0F, 1.0F};
+  const FloatReg r{FloatArray{1.0F, 2.0F, 3.0F, 4.0F}};
+  SUBCASE("distinct indices") {
+    const std::array<size_t, 4> indices{3, 2, 1, 0};
+    r.scatter_add(std::span{data}, std::span<const size_t>{indices});
+    CHECK(data == FloatArray{5.0F, 4.0F, 3.0F, 2.0F});
+  }
+  SUBCASE("conflicting indices") {
+    const std::array<size_t, 4> indices{2, 0, 2, 2};
+    r.scatter_add(std::span{data}, std::span<const size_t>{indices});
+    CHECK(data == FloatArray{3.0F, 1.0F, 9.0F, 1.0F});
+  }
+}
+
+TEST_CASE("simd::Reg::compress_store") {
+  FloatArray out{-1.0F, -1.0F, -1.0F, -1.0F};
+  const FloatReg r{FloatArray{5.0F, 6.0F, 7.0F, 8.0F}};
+  const auto count = r.compress_store(
+      FloatRegMask{FloatMaskArray{false, true, false, true}},
+      out);
+  CHECK(count == 2);
+  CHECK(out == FloatArray{6.0F, 8.0F, -1.0F, -1.0F});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("simd::Reg::operator+") {
   const FloatArray a{1.0F, 2.0F, 3.0F, 4.0F};
   const FloatArray b{5.0F, 6.0F, 7.0F, 8.0F};
@@ -198,6 +248,35 @@ TEST_CASE("simd::Reg::ceil") {
   CHECK(out == FloatArray{2.0F, 3.0F, 4.0F, 5.0F});
 }
 
+TEST_CASE("simd::Reg::sqrt") {
+  const auto r = simd::sqrt(FloatReg{FloatArray{1.0F, 4.0F, 9.0F, 16.0F}});
+  FloatArray out{};
+  r.store(out);
+  CHECK(out == FloatArray{1.0F, 2.0F, 3.0F, 4.0F});
+}
+
+TEST_CASE("simd::Reg::pow") {
+  const FloatReg a{FloatArray{1.0F, 2.0F, 0.5F, 1.1F}};
+  FloatArray out{};
+  SUBCASE("integer") {
+    simd::pow(a, 7.0F).store(out);
+    CHECK(out[0] == 1.0F);
+    CHECK(out[1] == 128.0F);
+    CHECK(out[2] == 0.0078125F);
+    CHECK(out[3] == doctest::Approx(std::pow(1.1F, 7.0F)));
+    simd::pow(a, -2.0F).store(out);
+    CHECK(out == FloatArray{1.0F, 0.25F, 4.0F, 1.0F / (1.1F * 1.1F)});
+    simd::pow(a, 0.0F).store(out);
+    CHECK(out == FloatArray{1.0F, 1.0F, 1.0F, 1.0F});
+  }
+  SUBCASE("fractional") {
+    simd::pow(a, 1.4F).store(out);
+    for (size_t i = 0; i < out.size(); ++i) {
+      CHECK(out[i] == std::pow(std::array{1.0F, 2.0F, 0.5F, 1.1F}[i], 1.4F));
+    }
+  }
+}
+
 TEST_CASE("simd::Reg::fma") {
   const auto r = simd::fma(FloatReg{FloatArray{1.0F, 2.0F, 3.0F, 4.0F}},
                            FloatReg{FloatArray{5.0F, 6.0F, 7.0F, 8.0F}},
@@ -264,6 +343,24 @@ TEST_CASE("simd::Reg::max_value") {
   CHECK(simd::max_value(FloatReg{FloatArray{3.0F, 2.0F, 4.0F, 1.0F}}) == 4.0F);
 }
 
+TEST_CASE("simd::Reg::approx_rsqrt") {
+  const FloatArray in{0.25F, 1.0F, 2.0F, 1.0e4F};
+  FloatArray out{};
+  SUBCASE("default") {
+    simd::approx_rsqrt(FloatReg{in}).store(out);
+    for (size_t i = 0; i < in.size(); ++i) {
+      CHECK(std::abs(out[i] * std::sqrt(in[i]) - 1.0F) <= 1.0e-6F);
+    }
+  }
+  SUBCASE("iterations") {
+    // SIMD results match the scalar ones.
+    simd::approx_rsqrt<1>(FloatReg{in}).store(out);
+    for (size_t i = 0; i < in.size(); ++i) {
+      CHECK(out[i] == approx_rsqrt<1>(in[i]));
+    }
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
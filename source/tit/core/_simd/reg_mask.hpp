@@ -114,6 +114,16 @@ public:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Make a SIMD register mask with the first @p n elements set to true.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto first_n(size_t n) noexcept -> RegMask<Num, Size> {
+  return hn::FirstN(typename RegMask<Num, Size>::Tag{}, n);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Check if any SIMD register mask element is set to true.
 template<class Num, size_t Size>
   requires supported<Num, Size>
@@ -87,6 +87,16 @@ TEST_CASE("simd::RegMask::operator==") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("simd::RegMask::first_n") {
+  FloatMaskArray out{};
+  simd::first_n<float, 4>(3).store(out);
+  CHECK(out == FloatMaskArray{true, true, true, false});
+  simd::first_n<float, 4>(0).store(out);
+  CHECK(out == FloatMaskArray{false, false, false, false});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("simd::RegMask::any_and_all") {
   SUBCASE("all") {
     const FloatRegMask m{FloatMaskArray{true, true, true, true}};
@@ -0,0 +1,35 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstdint>
+#include <string_view>
+
+#include <hwy/highway.h>
+#include <hwy/targets.h>
+
+#include "tit/core/_simd/target.hpp"
+
+namespace tit::simd {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto compiled_target_name() -> std::string_view {
+  return hwy::TargetName(HWY_STATIC_TARGET);
+}
+
+auto best_supported_target_name() -> std::string_view {
+  // Highway targets are ordered from the best one to the worst one, and the
+  // better targets have the lower bits.
+  const auto targets = static_cast<uint64_t>(hwy::SupportedTargets());
+  return hwy::TargetName(static_cast<int64_t>(targets & -targets));
+}
+
+auto compiled_target_supported() -> bool {
+  return (hwy::SupportedTargets() & HWY_STATIC_TARGET) != 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::simd
@@ -0,0 +1,28 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/simd.hpp"
+#pragma once
+
+#include <string_view>
+
+namespace tit::simd {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Name of the SIMD instruction set the code is compiled for, for example
+/// "AVX2" or "AVX3" (AVX-512).
+auto compiled_target_name() -> std::string_view;
+
+/// Name of the best SIMD instruction set supported by the current CPU.
+auto best_supported_target_name() -> std::string_view;
+
+/// Check if the current CPU supports the SIMD instruction set the code is
+/// compiled for. Running the code on the CPU that does not is an error.
+auto compiled_target_supported() -> bool;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::simd
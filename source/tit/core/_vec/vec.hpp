@@ -45,6 +45,11 @@ struct VecSIMD<Num, Dim> {
 } // namespace impl
 
 /// Column vector.
+///
+/// Vectors of the SIMD-supported types are stored in the SIMD registers, and
+/// are padded to the whole number of registers. For example, a 3D vector of
+/// doubles is a single aligned 256-bit register on the AVX-capable hardware.
+/// Padding elements hold arbitrary values and are excluded from reductions.
 template<class Num, size_t Dim>
 class Vec final {
 public:
@@ -503,18 +508,33 @@ constexpr auto ceil(const Vec<Num, Dim>& a) -> Vec<Num, Dim> {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Replace the padding elements of the last vector register with the fill
+// value, so that the register can be reduced as a whole.
+template<class Num, size_t Dim, class Reg = Vec<Num, Dim>::Reg>
+auto mask_vec_padding(const Reg& last_reg, const Reg& fill = {}) -> Reg {
+  constexpr auto RegSize = Vec<Num, Dim>::RegSize;
+  constexpr auto TailSize = Dim - (Vec<Num, Dim>::RegCount - 1) * RegSize;
+  if constexpr (TailSize == RegSize) return last_reg;
+  else {
+    return simd::select(simd::first_n<Num, RegSize>(TailSize),
+                        last_reg,
+                        fill);
+  }
+}
+
+} // namespace impl
+
 /// Sum of the vector elements.
 template<class Num, size_t Dim>
 constexpr auto sum(const Vec<Num, Dim>& a) -> Num {
   TIT_IF_SIMD_AVALIABLE(Num) {
-    constexpr auto RegSize = Vec<Num, Dim>::RegSize;
-    constexpr auto FullRegCount = Dim / RegSize;
-    if constexpr (FullRegCount > 0) {
-      auto r_reg = a.reg(0);
-      for (size_t i = 1; i < FullRegCount; ++i) r_reg += a.reg(i);
-      auto r = simd::sum(r_reg);
-      for (size_t i = FullRegCount * RegSize; i < Dim; ++i) r += a[i];
-      return r;
+    if constexpr (Dim > 1) {
+      constexpr auto Last = Vec<Num, Dim>::RegCount - 1;
+      auto r_reg = impl::mask_vec_padding<Num, Dim>(a.reg(Last));
+      for (size_t i = 0; i < Last; ++i) r_reg += a.reg(i);
+      return simd::sum(r_reg);
     }
   }
   auto r = a[0];
@@ -535,18 +555,12 @@ constexpr auto prod(const Vec<Num, Dim>& a) -> Num {
 template<class Num, size_t Dim>
 constexpr auto min_value(const Vec<Num, Dim>& a) -> Num {
   TIT_IF_SIMD_AVALIABLE(Num) {
-    constexpr auto RegSize = Vec<Num, Dim>::RegSize;
-    constexpr auto FullRegCount = Dim / RegSize;
-    if constexpr (FullRegCount > 0) {
-      auto r_reg = a.reg(0);
-      for (size_t i = 1; i < FullRegCount; ++i) {
-        r_reg = simd::min(r_reg, a.reg(i));
-      }
-      auto r = simd::min_value(r_reg);
-      for (size_t i = FullRegCount * RegSize; i < Dim; ++i) {
-        r = std::min(r, a[i]);
-      }
-      return r;
+    if constexpr (Dim > 1) {
+      using Reg = Vec<Num, Dim>::Reg;
+      constexpr auto Last = Vec<Num, Dim>::RegCount - 1;
+      auto r_reg = impl::mask_vec_padding<Num, Dim>(a.reg(Last), Reg(a[0]));
+      for (size_t i = 0; i < Last; ++i) r_reg = simd::min(r_reg, a.reg(i));
+      return simd::min_value(r_reg);
     }
   }
   auto r = a[0];
@@ -559,18 +573,12 @@ template<class Num, size_t Dim>
 constexpr auto max_value(const Vec<Num, Dim>& a) -> Num {
   using std::max;
   TIT_IF_SIMD_AVALIABLE(Num) {
-    constexpr auto RegSize = Vec<Num, Dim>::RegSize;
-    constexpr auto FullRegCount = Dim / RegSize;
-    if constexpr (FullRegCount > 0) {
-      auto r_reg = a.reg(0);
-      for (size_t i = 1; i < FullRegCount; ++i) {
-        r_reg = simd::max(r_reg, a.reg(i));
-      }
-      auto r = simd::max_value(r_reg);
-      for (size_t i = FullRegCount * RegSize; i < Dim; ++i) {
-        r = std::max(r, a[i]);
-      }
-      return r;
+    if constexpr (Dim > 1) {
+      using Reg = Vec<Num, Dim>::Reg;
+      constexpr auto Last = Vec<Num, Dim>::RegCount - 1;
+      auto r_reg = impl::mask_vec_padding<Num, Dim>(a.reg(Last), Reg(a[0]));
+      for (size_t i = 0; i < Last; ++i) r_reg = simd::max(r_reg, a.reg(i));
+      return simd::max_value(r_reg);
     }
   }
   auto r = a[0];
@@ -604,16 +612,14 @@ constexpr auto max_value_index(const Vec<Num, Dim>& a) -> size_t {
 template<class Num, size_t Dim>
 constexpr auto dot(const Vec<Num, Dim>& a, const Vec<Num, Dim>& b) -> Num {
   TIT_IF_SIMD_AVALIABLE(Num) {
-    constexpr auto RegSize = Vec<Num, Dim>::RegSize;
-    constexpr auto FullRegCount = Dim / RegSize;
-    if constexpr (FullRegCount > 0) {
-      auto r_reg = a.reg(0) * b.reg(0);
-      for (size_t i = 1; i < FullRegCount; ++i) {
+    if constexpr (Dim > 1) {
+      constexpr auto Last = Vec<Num, Dim>::RegCount - 1;
+      auto r_reg =
+          impl::mask_vec_padding<Num, Dim>(a.reg(Last) * b.reg(Last));
+      for (size_t i = 0; i < Last; ++i) {
         r_reg = simd::fma(a.reg(i), b.reg(i), r_reg);
       }
-      auto r = simd::sum(r_reg);
-      for (size_t i = FullRegCount * RegSize; i < Dim; ++i) r += a[i] * b[i];
-      return r;
+      return simd::sum(r_reg);
     }
   }
   auto r = a[0] * b[0];
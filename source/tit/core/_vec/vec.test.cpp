@@ -266,6 +266,10 @@ TEST_CASE_TEMPLATE("Vec::sum", Num, NUM_TYPES) {
     constexpr auto Dim = 2 * simd::max_reg_size_v<double> + 1;
     CHECK(sum(Vec<Num, Dim>(Num{10})) == Num{Dim * 10});
   }
+  SUBCASE("padding") {
+    // Value initialization fills the padding elements as well.
+    CHECK(sum(Vec<Num, 3>(Num{2})) == Num{6});
+  }
 }
 
 TEST_CASE_TEMPLATE("Vec::prod", Num, NUM_TYPES) {
@@ -285,6 +289,11 @@ TEST_CASE_TEMPLATE("Vec::min_value", Num, NUM_TYPES) {
     v[Dim / 2] = Num{1};
     CHECK(min_value(v) == Num{1});
   }
+  SUBCASE("padding") {
+    Vec<Num, 3> v(Num{1});
+    v[0] = v[1] = v[2] = Num{2};
+    CHECK(min_value(v) == Num{2});
+  }
 }
 
 TEST_CASE_TEMPLATE("Vec::max_value", Num, NUM_TYPES) {
@@ -299,6 +308,11 @@ TEST_CASE_TEMPLATE("Vec::max_value", Num, NUM_TYPES) {
     v[Dim / 2] = Num{2};
     CHECK(max_value(v) == Num{2});
   }
+  SUBCASE("padding") {
+    Vec<Num, 3> v(Num{3});
+    v[0] = v[1] = v[2] = Num{2};
+    CHECK(max_value(v) == Num{2});
+  }
 }
 
 TEST_CASE_TEMPLATE("Vec::min_value_index", Num, NUM_TYPES) {
@@ -330,6 +344,9 @@ TEST_CASE_TEMPLATE("Vec::dot", Num, NUM_TYPES) {
     CHECK(dot(Vec<Num, Dim>(Num{3}), Vec<Num, Dim>(Num{4})) ==
           Num{Dim * 3 * 4});
   }
+  SUBCASE("padding") {
+    CHECK(dot(Vec<Num, 3>(Num{3}), Vec<Num, 3>(Num{4})) == Num{36});
+  }
 }
 
 TEST_CASE_TEMPLATE("Vec::norm2", Num, NUM_TYPES) {
@@ -0,0 +1,130 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "tit/core/autotune.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/str_utils.hpp"
+#include "tit/core/sys/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Trim the surrounding whitespace.
+auto trim(std::string_view str) -> std::string_view {
+  constexpr std::string_view whitespace = " \t\r\n";
+  const auto first = str.find_first_not_of(whitespace);
+  if (first == std::string_view::npos) return {};
+  const auto last = str.find_last_not_of(whitespace);
+  return str.substr(first, last - first + 1);
+}
+
+// Make the string usable as a part of the cache key: the characters that
+// have a special meaning in the `key = value` format are replaced.
+auto sanitize(std::string_view str) -> std::string {
+  std::string result{trim(str)};
+  for (auto& c : result) {
+    if (c == '=' || c == '#' || c == '\n' || c == '\r') c = '_';
+  }
+  return result;
+}
+
+// Name of the CPU model, if known.
+auto cpu_model() -> std::string {
+#ifdef __linux__
+  try {
+    const auto file = open_file("/proc/cpuinfo", "r");
+    std::array<char, 512> line{};
+    while (std::fgets(line.data(), line.size(), file.get()) != nullptr) {
+      const std::string_view str{line.data()};
+      if (!str.starts_with("model name")) continue;
+      const auto sep = str.find(':');
+      if (sep != std::string_view::npos) return sanitize(str.substr(sep + 1));
+    }
+  } catch (const Exception& /*e*/) { // NOLINT(*-empty-catch)
+    // Machine is simply reported as unknown.
+  }
+#endif
+  return "unknown CPU";
+}
+
+} // namespace
+
+auto machine_key() -> std::string {
+  return std::format("{}, {} CPUs, {} threads",
+                     cpu_model(),
+                     par::num_cpus(),
+                     par::num_threads());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Autotuner::Autotuner(std::filesystem::path cache_path,
+                     std::string_view case_key)
+    : cache_path_{std::move(cache_path)},
+      prefix_{std::format("{} | {} | ", machine_key(), sanitize(case_key))} {
+  if (!std::filesystem::exists(cache_path_)) return;
+  const MappedFile file{cache_path_};
+  const auto bytes = file.bytes();
+  const std::string_view text{reinterpret_cast<const char*>(bytes.data()),
+                              bytes.size()};
+  // Malformed lines are skipped, the cache is merely a hint.
+  for (const auto line_range : std::views::split(text, '\n')) {
+    const auto line = trim(std::string_view{line_range});
+    if (line.empty() || line.starts_with('#')) continue;
+    const auto sep = line.rfind('=');
+    if (sep == std::string_view::npos) continue;
+    entries_.insert_or_assign(std::string{trim(line.substr(0, sep))},
+                              std::string{trim(line.substr(sep + 1))});
+  }
+}
+
+auto Autotuner::cached(std::string_view name) const -> std::optional<size_t> {
+  const auto iter = entries_.find(entry_key_(name));
+  if (iter == entries_.end()) return std::nullopt;
+  return str_to<size_t>(iter->second);
+}
+
+void Autotuner::store(std::string_view name, size_t index) {
+  entries_.insert_or_assign(entry_key_(name), std::to_string(index));
+
+  // Write into a temporary file first, so that the concurrent runs never
+  // observe a partially written cache.
+  auto temp_path = cache_path_;
+  temp_path += ".tmp";
+  {
+    const auto file = open_file(temp_path.c_str(), "wb");
+    const std::string_view header{"# Autotuner cache. "
+                                  "Remove the file to repeat the trials.\n"};
+    std::fwrite(header.data(), 1, header.size(), file.get());
+    for (const auto& [key, value] : entries_) {
+      const auto line = std::format("{} = {}\n", key, value);
+      std::fwrite(line.data(), 1, line.size(), file.get());
+    }
+  }
+  std::filesystem::rename(temp_path, cache_path_);
+}
+
+auto Autotuner::entry_key_(std::string_view name) const -> std::string {
+  return prefix_ + sanitize(name);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
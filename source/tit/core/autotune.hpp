@@ -0,0 +1,105 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/time.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Key of the current machine: the CPU model, the number of the available
+/// CPUs and the number of the worker threads.
+auto machine_key() -> std::string;
+
+/// Startup autotuner.
+///
+/// Selects the fastest of the candidate values of a parameter by running a
+/// short timed trial with each of them. Selections are cached in a file,
+/// keyed by the machine and the case, so that the later runs of the same case
+/// on the same machine skip the trials.
+///
+/// Cache file has the same `key = value` format as the case configuration,
+/// see `Config`.
+class Autotuner final {
+public:
+
+  /// Construct an autotuner.
+  ///
+  /// @param cache_path Path to the cache file. It is created on the first
+  ///                   selection, if it does not exist.
+  /// @param case_key   Key of the case, e.g. its name and size.
+  Autotuner(std::filesystem::path cache_path, std::string_view case_key);
+
+  /// Cached selection of the parameter, if any.
+  auto cached(std::string_view name) const -> std::optional<size_t>;
+
+  /// Store the selection of the parameter and save the cache file.
+  void store(std::string_view name, size_t index);
+
+  /// Select the fastest of the parameter candidates.
+  ///
+  /// @param name           Parameter name.
+  /// @param num_candidates Number of the candidate values.
+  /// @param trial          Function `trial(index)` that runs a short trial
+  ///                       with the candidate at @p index. It is timed.
+  ///
+  /// @returns Index of the fastest candidate, or of the cached one.
+  template<std::invocable<size_t> Trial>
+  auto select(std::string_view name, size_t num_candidates, Trial trial)
+      -> size_t {
+    TIT_ASSERT(num_candidates > 0, "Number of candidates must be positive!");
+    if (const auto index = cached(name);
+        index.has_value() && *index < num_candidates) {
+      TIT_INFO("Autotuner: '{}' = {} (cached).", name, *index);
+      return *index;
+    }
+    size_t best_index = 0;
+    auto best_time = std::numeric_limits<real_t>::max();
+    for (size_t index = 0; index < num_candidates; ++index) {
+      Stopwatch stopwatch{};
+      {
+        const StopwatchCycle cycle{stopwatch};
+        trial(index);
+      }
+      TIT_INFO("Autotuner: '{}' = {} took {:.4g} s.",
+               name,
+               index,
+               stopwatch.total());
+      if (stopwatch.total() < best_time) {
+        best_index = index, best_time = stopwatch.total();
+      }
+    }
+    TIT_INFO("Autotuner: '{}' = {} selected.", name, best_index);
+    store(name, best_index);
+    return best_index;
+  }
+
+private:
+
+  auto entry_key_(std::string_view name) const -> std::string;
+
+  std::filesystem::path cache_path_;
+  std::string prefix_;
+  std::map<std::string, std::string, std::less<>> entries_;
+
+}; // class Autotuner
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,64 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "tit/core/autotune.hpp"
+#include "tit/core/basic_types.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Autotuner") {
+  const std::filesystem::path cache_path{"test_autotune.txt"};
+  std::filesystem::remove(cache_path);
+  CHECK_FALSE(machine_key().empty());
+
+  // Candidate that sleeps the least must be selected.
+  const auto sleep_ms = std::vector<size_t>{20, 1, 10};
+  std::vector<size_t> trials;
+  const auto trial = [&sleep_ms, &trials](size_t index) {
+    trials.push_back(index);
+    std::this_thread::sleep_for(std::chrono::milliseconds{sleep_ms[index]});
+  };
+  {
+    Autotuner autotuner{cache_path, "case = 1"};
+    CHECK_FALSE(autotuner.cached("sleep").has_value());
+    CHECK(autotuner.select("sleep", sleep_ms.size(), trial) == 1);
+    CHECK(trials == std::vector<size_t>{0, 1, 2});
+    CHECK(autotuner.cached("sleep") == 1);
+  }
+
+  // Selection must be reused from the cache file, without the trials.
+  trials.clear();
+  {
+    Autotuner autotuner{cache_path, "case = 1"};
+    CHECK(autotuner.select("sleep", sleep_ms.size(), trial) == 1);
+    CHECK(trials.empty());
+  }
+
+  // Selections of the other cases must not be reused.
+  {
+    Autotuner autotuner{cache_path, "case = 2"};
+    CHECK_FALSE(autotuner.cached("sleep").has_value());
+    autotuner.store("sleep", 2);
+  }
+  {
+    const Autotuner autotuner{cache_path, "case = 1"};
+    CHECK(autotuner.cached("sleep") == 1);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -3,11 +3,16 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+
 #include "tit/core/checks.hpp"
 #include "tit/core/cmd.hpp"
 #include "tit/core/exception.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/metrics.hpp"
 #include "tit/core/par/control.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/stats.hpp"
 #include "tit/core/sys/signal.hpp"
 #include "tit/core/sys/utils.hpp"
@@ -21,12 +26,40 @@ auto run_main(int argc, char** argv, MainFunc main_func) -> int {
   const TerminateHandler terminate_handler{};
   const FatalSignalHandler signal_handler{};
 
+  // Check that the CPU supports the SIMD instruction set the binary is built
+  // for, instead of crashing on the first unsupported instruction.
+  if (!simd::compiled_target_supported()) {
+    TIT_THROW("Binary is built for the '{}' SIMD instruction set, but the "
+              "CPU supports '{}' at most. Rebuild with the lower "
+              "`TIT_TARGET_ARCH` for this machine.",
+              simd::compiled_target_name(),
+              simd::best_supported_target_name());
+  }
+
   // Enable subsystems.
+  if (get_env("TIT_ASYNC_LOG", false)) {
+    Logger::enable_async(get_env("TIT_LOG_QUEUE_SIZE", 1024UZ));
+  }
   if (get_env("TIT_ENABLE_STATS", false)) Stats::enable();
-  if (get_env("TIT_ENABLE_PROFILER", false)) Profiler::enable();
+  if (get_env("TIT_ENABLE_METRICS", false)) {
+    Metrics::enable(get_env("TIT_METRICS_FILE").value_or(""),
+                    get_env("TIT_METRICS_INTERVAL", 10.0));
+  }
+  if (get_env("TIT_ENABLE_PROFILER", false)) {
+    Profiler::enable(get_env("TIT_PROFILER_TRACE").value_or(""),
+                     get_env("TIT_PROFILER_COUNTERS", false),
+                     get_env("TIT_PROFILER_ENERGY", false),
+                     get_env("TIT_PROFILER_MEMORY", false));
+  }
 
   // Setup parallelism.
-  par::set_num_threads(get_env("TIT_NUM_THREADS", 8UZ));
+  par::set_num_threads(
+      get_env("TIT_NUM_THREADS", std::min(8UZ, par::num_cpus())));
+  if (get_env("TIT_PIN_THREADS", false)) par::pin_threads();
+  if (const auto num_io_threads = get_env<size_t>("TIT_NUM_IO_THREADS")) {
+    par::set_num_io_threads(*num_io_threads);
+  }
+  par::set_reproducible(get_env("TIT_REPRODUCIBLE", 0UZ));
 
   // Run the main function.
   TIT_ASSERT(main_func != nullptr, "Main function must be specified!");
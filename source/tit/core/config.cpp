@@ -0,0 +1,88 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/config.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/sys/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Trim the surrounding whitespace.
+auto trim(std::string_view str) -> std::string_view {
+  constexpr std::string_view whitespace = " \t\r";
+  const auto first = str.find_first_not_of(whitespace);
+  if (first == std::string_view::npos) return {};
+  const auto last = str.find_last_not_of(whitespace);
+  return str.substr(first, last - first + 1);
+}
+
+} // namespace
+
+Config::Config(std::string_view text) {
+  size_t line_index = 0;
+  for (const auto line_range : std::views::split(text, '\n')) {
+    line_index += 1;
+    const auto line = trim(std::string_view{line_range});
+    if (line.empty() || line.starts_with('#')) continue;
+    const auto sep = line.find('=');
+    if (sep == std::string_view::npos) {
+      TIT_THROW("Line {} of the configuration is not a `key = value` pair.",
+                line_index);
+    }
+    const auto key = trim(line.substr(0, sep));
+    const auto value = trim(line.substr(sep + 1));
+    if (key.empty()) {
+      TIT_THROW("Line {} of the configuration has an empty key.", line_index);
+    }
+    if (!params_.emplace(key, value).second) {
+      TIT_THROW("Parameter '{}' is defined more than once.", key);
+    }
+  }
+}
+
+auto Config::load(const std::filesystem::path& path) -> Config {
+  const MappedFile file{path};
+  const auto bytes = file.bytes();
+  return Config{std::string_view{reinterpret_cast<const char*>(bytes.data()),
+                                 bytes.size()}};
+}
+
+auto Config::contains(std::string_view key) const -> bool {
+  return params_.contains(key);
+}
+
+auto Config::get(std::string_view key) const
+    -> std::optional<std::string_view> {
+  const auto iter = params_.find(key);
+  if (iter == params_.end()) return std::nullopt;
+  used_keys_.emplace(key);
+  return iter->second;
+}
+
+auto Config::unused_keys() const -> std::vector<std::string> {
+  auto keys = params_ | std::views::keys |
+              std::views::filter([this](const std::string& key) {
+                return !used_keys_.contains(key);
+              }) |
+              std::ranges::to<std::vector>();
+  std::ranges::sort(keys);
+  return keys;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
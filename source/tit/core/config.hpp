@@ -0,0 +1,75 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/exception.hpp"
+#include "tit/core/str_utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Case configuration, a set of the named parameters read at runtime.
+///
+/// Configuration text consists of lines, each of which is either empty, a
+/// comment that starts with `#`, or a `key = value` parameter. Keys and
+/// values are trimmed of the surrounding whitespace. Accessed parameters are
+/// tracked, so that the misspelled keys could be reported.
+class Config final {
+public:
+
+  /// Construct an empty configuration.
+  Config() = default;
+
+  /// Parse the configuration text.
+  explicit Config(std::string_view text);
+
+  /// Load the configuration from the file.
+  static auto load(const std::filesystem::path& path) -> Config;
+
+  /// Check if the parameter is present.
+  auto contains(std::string_view key) const -> bool;
+
+  /// Get the parameter value string, if present.
+  auto get(std::string_view key) const -> std::optional<std::string_view>;
+
+  /// Get the parameter value, or the fallback value if it is not present.
+  /// Throws if the value can not be converted to the requested type.
+  template<class Val>
+  auto get(std::string_view key, Val fallback) const -> Val {
+    const auto str = get(key);
+    if (!str.has_value()) return fallback;
+    if constexpr (std::constructible_from<Val, std::string_view>) {
+      return Val{*str};
+    } else {
+      const auto value = str_to<Val>(*str);
+      if (!value.has_value()) {
+        TIT_THROW("Invalid value '{}' of the parameter '{}'.", *str, key);
+      }
+      return *value;
+    }
+  }
+
+  /// Keys of the parameters that were never accessed, in the sorted order.
+  auto unused_keys() const -> std::vector<std::string>;
+
+private:
+
+  StrHashMap<std::string> params_;
+  mutable StrHashSet used_keys_;
+
+}; // class Config
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
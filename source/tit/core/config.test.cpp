@@ -0,0 +1,66 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/config.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Config") {
+  SUBCASE("parse") {
+    const Config config{"# Case parameters.\n"
+                        "cs_0 = 24.3\n"
+                        "\n"
+                        "  kernel=quartic_wendland  \n"
+                        "num_steps = 100\r\n"
+                        "restart = true\n"};
+    CHECK(config.contains("cs_0"));
+    CHECK_FALSE(config.contains("# Case parameters."));
+    CHECK(config.get("kernel") == "quartic_wendland");
+    CHECK(config.get<double>("cs_0", 0.0) == 24.3);
+    CHECK(config.get<size_t>("num_steps", 0) == 100);
+    CHECK(config.get<std::string>("missing", "fallback") == "fallback");
+    CHECK(config.unused_keys() == std::vector<std::string>{"restart"});
+  }
+  SUBCASE("load") {
+    const std::filesystem::path file_name{"test_config.txt"};
+    {
+      const auto file = open_file(file_name.c_str(), "wb");
+      const std::string_view contents{"H = 0.6\n"};
+      std::fwrite(contents.data(), 1, contents.size(), file.get());
+    }
+    const auto config = Config::load(file_name);
+    CHECK(config.get<double>("H", 0.0) == 0.6);
+  }
+  SUBCASE("failure") {
+    CHECK_THROWS_WITH_AS(Config{"cs_0 24.3"},
+                         "Line 1 of the configuration is not a `key = value` "
+                         "pair.",
+                         Exception);
+    CHECK_THROWS_WITH_AS(Config{"a = 1\na = 2"},
+                         "Parameter 'a' is defined more than once.",
+                         Exception);
+    CHECK_THROWS_WITH_AS(Config{"cs_0 = fast"}.get<double>("cs_0", 0.0),
+                         "Invalid value 'fast' of the parameter 'cs_0'.",
+                         Exception);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -7,8 +7,12 @@
 
 #include <algorithm> // IWYU pragma: keep
 #include <array>
+#include <bit>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
 #include <ranges>
 #include <span>
 #include <type_traits>
@@ -17,6 +21,7 @@
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/range_utils.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/tuple_utils.hpp"
 
 namespace tit {
@@ -32,6 +37,19 @@ concept mdshape = can_pack_array<Rank, size_t, Extents...> &&
 template<size_t Rank, class... Indices>
 concept mdindex = can_pack_array<Rank, size_t, Indices...>;
 
+/// Row-major strides (in values) of the multidimensional shape.
+template<size_t Rank>
+constexpr auto row_major_strides(std::span<const size_t, Rank> shape) noexcept
+    -> std::array<size_t, Rank> {
+  std::array<size_t, Rank> strides{};
+  size_t stride = 1;
+  for (size_t axis = Rank; axis-- > 0;) {
+    strides[axis] = stride;
+    stride *= shape[axis];
+  }
+  return strides;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Basic multidimensional non-owning container.
@@ -43,16 +61,25 @@ public:
   /// Shape type.
   using Shape = std::span<const size_t, Rank>;
 
+  /// Strides type.
+  using Strides = std::array<size_t, Rank>;
+
   /// Construct a multidimensional span from values iterator and shape.
   template<std::contiguous_iterator ValIter>
   constexpr Mdspan(ValIter iter, Shape shape) noexcept
-      // NOLINTNEXTLINE(misc-include-cleaner)
-      : vals_{iter, std::ranges::fold_left(shape, 1, std::multiplies{})},
-        shape_{shape} {}
+      : Mdspan{iter, shape, row_major_strides(shape)} {}
+
+  /// Construct a multidimensional span from values iterator, shape and
+  /// strides (in values), e.g. over the storage with the padded rows.
+  template<std::contiguous_iterator ValIter>
+  constexpr Mdspan(ValIter iter, Shape shape, const Strides& strides) noexcept
+      : vals_{iter, storage_size_(shape, strides)}, shape_{shape},
+        strides_{strides} {}
 
   /// Amount of elements.
   constexpr auto size() const noexcept -> size_t {
-    return vals_.size();
+    // NOLINTNEXTLINE(misc-include-cleaner)
+    return std::ranges::fold_left(shape_, 1, std::multiplies{});
   }
 
   /// Span shape.
@@ -60,6 +87,11 @@ public:
     return shape_;
   }
 
+  /// Span strides (in values).
+  constexpr auto strides() const noexcept -> const Strides& {
+    return strides_;
+  }
+
   /// Span data.
   /// @{
   constexpr auto data() noexcept -> Val* {
@@ -71,6 +103,9 @@ public:
   /// @}
 
   /// Iterator pointing to the first span element.
+  ///
+  /// @note Iteration covers the values between the rows too, if the span
+  ///       is padded.
   constexpr auto begin() const noexcept {
     return vals_.begin();
   }
@@ -86,24 +121,42 @@ public:
       -> decltype(auto) {
     size_t offset = 0;
     for (const auto index_pack = make_array<Rank, size_t>(indices...);
-         const auto [extent, index] : std::views::zip(shape_, index_pack)) {
+         const auto [extent, stride, index] :
+         std::views::zip(shape_, strides_, index_pack)) {
       TIT_ASSERT(index < extent, "Index is out of range!");
-      offset = index + offset * extent;
+      offset += index * stride;
     }
     TIT_ASSERT(offset < vals_.size(), "Offset is out of range!");
     if constexpr (constexpr auto ResultRank = packed_array_size_v<Indices...>;
                   ResultRank == Rank) {
       return vals_[offset];
     } else {
+      std::array<size_t, Rank - ResultRank> sub_strides{};
+      std::ranges::copy(std::span{strides_}.template subspan<ResultRank>(),
+                        sub_strides.begin());
       return tit::Mdspan{vals_.begin() + offset,
-                         shape_.template subspan<ResultRank>()};
+                         shape_.template subspan<ResultRank>(),
+                         sub_strides};
     }
   }
 
 private:
 
+  // Number of the values between the first and the last elements.
+  static constexpr auto storage_size_(Shape shape,
+                                      const Strides& strides) noexcept
+      -> size_t {
+    if (std::ranges::contains(shape, size_t{0})) return 0;
+    size_t size = 1;
+    for (const auto [extent, stride] : std::views::zip(shape, strides)) {
+      size += (extent - 1) * stride;
+    }
+    return size;
+  }
+
   std::span<Val> vals_;
   Shape shape_;
+  Strides strides_;
 
 }; // class Mdspan
 
@@ -112,10 +165,131 @@ Mdspan(ValIter, Shape&&)
     -> Mdspan<std::remove_reference_t<std::iter_reference_t<ValIter>>,
               range_fixed_size_v<Shape>>;
 
+template<std::contiguous_iterator ValIter,
+         contiguous_fixed_size_range Shape,
+         class Strides>
+Mdspan(ValIter, Shape&&, const Strides&)
+    -> Mdspan<std::remove_reference_t<std::iter_reference_t<ValIter>>,
+              range_fixed_size_v<Shape>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Row-major layout of the multidimensional vectors.
+///
+/// @tparam Align   Alignment of the storage (in bytes). Natural alignment of
+///                 the values is used if zero.
+/// @tparam PadRows Pad each innermost row to a multiple of `Align` bytes, so
+///                 that every row starts at an aligned address, and the loops
+///                 over the rows vectorize with no peeling.
+template<size_t Align = 0, bool PadRows = false>
+  requires (std::has_single_bit(Align) || (Align == 0 && !PadRows))
+struct RowMajorLayout final {
+  /// Storage alignment.
+  static constexpr size_t align = Align;
+
+  /// Are the innermost rows padded?
+  static constexpr bool pad_rows = PadRows;
+};
+
+/// Dense row-major layout, with no padding.
+using DenseLayout = RowMajorLayout<>;
+
+/// Row-major layout with the rows aligned and padded to the cache lines.
+using CacheAlignedLayout = RowMajorLayout<64, true>;
+
+/// Row-major layout with the rows aligned and padded to the widest SIMD
+/// registers.
+using SIMDAlignedLayout = RowMajorLayout<simd::max_reg_byte_width_v, true>;
+
+/// Tiled (blocked) layout of the multidimensional vectors, e.g. 2D and 3D
+/// grids.
+///
+/// Values are stored in the cubic tiles of `Tile` values per side. Tiles
+/// follow each other in the row-major order, and the values within a tile
+/// are row-major too. Extents are padded to a multiple of the tile size.
+/// Neighbors along each of the axes are close in memory, so the stencil
+/// loops that sweep the vector tile by tile stay in cache.
+///
+/// @tparam Tile  Tile size along each axis.
+/// @tparam Align Alignment of the storage (in bytes).
+template<size_t Tile, size_t Align = 64>
+  requires (Tile > 0 && std::has_single_bit(Align))
+struct TiledLayout final {
+  /// Tile size along each axis.
+  static constexpr size_t tile = Tile;
+
+  /// Storage alignment.
+  static constexpr size_t align = Align;
+};
+
+namespace impl {
+
+template<class Layout>
+inline constexpr bool is_row_major_layout_v = false;
+
+template<size_t Align, bool PadRows>
+inline constexpr bool
+    is_row_major_layout_v<RowMajorLayout<Align, PadRows>> = true;
+
+template<class Layout>
+inline constexpr bool is_tiled_layout_v = false;
+
+template<size_t Tile, size_t Align>
+inline constexpr bool is_tiled_layout_v<TiledLayout<Tile, Align>> = true;
+
+// Allocator of the memory blocks with the given alignment.
+template<class Val, size_t Align>
+class AlignedAllocator final {
+public:
+
+  using value_type = Val;
+
+  template<class Other>
+  struct rebind {
+    using other = AlignedAllocator<Other, Align>;
+  };
+
+  constexpr AlignedAllocator() noexcept = default;
+  template<class Other>
+  constexpr explicit(false) AlignedAllocator(
+      const AlignedAllocator<Other, Align>& /*other*/) noexcept {}
+
+  [[nodiscard]] auto allocate(size_t count) const -> Val* {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(Val)) {
+      throw std::bad_array_new_length{};
+    }
+    return static_cast<Val*>(
+        ::operator new(count * sizeof(Val), std::align_val_t{Align}));
+  }
+
+  void deallocate(Val* ptr, size_t /*count*/) const noexcept {
+    ::operator delete(ptr, std::align_val_t{Align});
+  }
+
+  template<class Other>
+  friend constexpr auto operator==(
+      const AlignedAllocator& /*lhs*/,
+      const AlignedAllocator<Other, Align>& /*rhs*/) noexcept -> bool {
+    return true;
+  }
+
+}; // class AlignedAllocator
+
+} // namespace impl
+
+/// Layout of the multidimensional vectors.
+template<class Layout>
+concept md_layout =
+    impl::is_row_major_layout_v<Layout> || impl::is_tiled_layout_v<Layout>;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Basic multidimensional owning container.
-template<class Val, size_t Rank>
+///
+/// Values are stored according to the layout, dense row-major by default,
+/// see `RowMajorLayout` and `TiledLayout`. Padding values are
+/// value-initialized.
+template<class Val, size_t Rank, md_layout Layout = DenseLayout>
   requires (Rank >= 1)
 class Mdvector final {
 public:
@@ -123,6 +297,18 @@ public:
   /// Shape type.
   using Shape = std::array<size_t, Rank>;
 
+  /// Is the layout tiled?
+  static constexpr bool is_tiled = impl::is_tiled_layout_v<Layout>;
+
+  /// Are the values stored contiguously, with no padding?
+  static constexpr bool is_contiguous = [] {
+    if constexpr (is_tiled) {
+      return false;
+    } else {
+      return !Layout::pad_rows;
+    }
+  }();
+
   /// Construct an empty multidimensional vector.
   constexpr Mdvector() noexcept = default;
 
@@ -142,7 +328,7 @@ public:
 
   /// Vector size.
   constexpr auto size() const noexcept -> size_t {
-    return vals_.size();
+    return std::ranges::fold_left(shape_, 1, std::multiplies{});
   }
 
   /// Vector shape.
@@ -150,24 +336,47 @@ public:
     return shape_;
   }
 
-  /// Vector data.
+  /// Number of the stored values, including the padding.
+  constexpr auto storage_size() const noexcept -> size_t {
+    return vals_.size();
+  }
+
+  /// Strides of the storage (in values).
+  constexpr auto strides() const noexcept -> const Shape&
+    requires (!is_tiled)
+  {
+    return strides_;
+  }
+
+  /// Memory allocated by the vector (in bytes), including the unused
+  /// capacity.
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return vals_.capacity() * sizeof(Val);
+  }
+
+  /// Vector data, as it is stored.
   constexpr auto data(this auto& self) noexcept {
     return self.vals_.data();
   }
 
   /// Iterator pointing to the first vector element.
-  constexpr auto begin(this auto& self) noexcept {
+  constexpr auto begin(this auto& self) noexcept
+    requires is_contiguous
+  {
     return self.vals_.begin();
   }
 
   /// Iterator pointing to the element after the last vector element.
-  constexpr auto end(this auto& self) noexcept {
+  constexpr auto end(this auto& self) noexcept
+    requires is_contiguous
+  {
     return self.vals_.end();
   }
 
   /// Clear the vector.
   constexpr void clear() noexcept {
     shape_.fill(0);
+    strides_.fill(0);
     vals_.clear();
   }
 
@@ -176,30 +385,119 @@ public:
     requires mdshape<Rank, Extents...>
   constexpr void assign(const Extents&... extents) {
     shape_ = make_array<Rank, size_t>(extents...);
+    auto storage_shape = shape_;
+    size_t storage_size = 1;
+    if constexpr (is_tiled) {
+      // Strides are of the tiles, in the tiles.
+      for (auto& extent : storage_shape) {
+        extent = (extent + Layout::tile - 1) / Layout::tile;
+      }
+      storage_size = tile_volume_;
+    } else if constexpr (Layout::pad_rows) {
+      static_assert(Layout::align % sizeof(Val) == 0,
+                    "Alignment must be a multiple of the value size!");
+      constexpr auto row_pad = Layout::align / sizeof(Val);
+      storage_shape.back() = (storage_shape.back() + row_pad - 1) / row_pad;
+      storage_shape.back() *= row_pad;
+    }
+    strides_ = row_major_strides(std::span<const size_t, Rank>{storage_shape});
+    storage_size *= std::ranges::fold_left(storage_shape, 1, std::multiplies{});
     vals_.clear();
-    vals_.resize(std::ranges::fold_left(shape_, 1, std::multiplies{}));
+    vals_.resize(storage_size);
   }
 
-  /// Reshape the vector and assign values.
+  /// Reshape the vector and assign values, given in the row-major order.
   template<std::forward_iterator ValIter, class... Extents>
     requires mdshape<Rank, Extents...>
   constexpr void assign(ValIter iter, const Extents&... extents) {
     assign(extents...);
-    std::ranges::copy(iter, iter + size(), vals_.begin());
+    if constexpr (is_contiguous) {
+      std::ranges::copy(iter, iter + size(), vals_.begin());
+    } else {
+      for (size_t flat_index = 0; flat_index < size(); ++flat_index, ++iter) {
+        vals_[offset(unflatten_(flat_index))] = *iter;
+      }
+    }
   }
 
-  /// Reference to vector element or sub-vector span.
+  /// Copy the values into the output iterator in the row-major order,
+  /// skipping the padding.
+  template<std::output_iterator<const Val&> OutIter>
+  constexpr auto copy_to(OutIter out) const -> OutIter {
+    if constexpr (is_contiguous) {
+      return std::ranges::copy(vals_, out).out;
+    } else {
+      for (size_t flat_index = 0; flat_index < size(); ++flat_index, ++out) {
+        *out = vals_[offset(unflatten_(flat_index))];
+      }
+      return out;
+    }
+  }
+
+  /// Storage offset of the element with the given index.
+  constexpr auto offset(const Shape& index) const noexcept -> size_t {
+    size_t result = 0;
+    if constexpr (is_tiled) {
+      size_t tile_offset = 0;
+      for (size_t axis = 0; axis < Rank; ++axis) {
+        TIT_ASSERT(index[axis] < shape_[axis], "Index is out of range!");
+        result += (index[axis] / Layout::tile) * strides_[axis];
+        tile_offset = tile_offset * Layout::tile + index[axis] % Layout::tile;
+      }
+      result = result * tile_volume_ + tile_offset;
+    } else {
+      for (size_t axis = 0; axis < Rank; ++axis) {
+        TIT_ASSERT(index[axis] < shape_[axis], "Index is out of range!");
+        result += index[axis] * strides_[axis];
+      }
+    }
+    TIT_ASSERT(result < vals_.size(), "Offset is out of range!");
+    return result;
+  }
+
+  /// Reference to vector element or sub-vector span. Tiled vectors have no
+  /// sub-vector spans.
   template<class... Indices>
     requires mdindex<Rank, Indices...>
   constexpr auto operator[](this auto& self, Indices... indices) noexcept
       -> decltype(auto) {
-    return Mdspan{self.vals_.begin(), self.shape_}[indices...];
+    if constexpr (is_tiled) {
+      static_assert(packed_array_size_v<Indices...> == Rank,
+                    "Tiled vectors have no sub-vector spans!");
+      return self.vals_[self.offset(make_array<Rank, size_t>(indices...))];
+    } else {
+      return Mdspan{self.vals_.begin(), self.shape_, self.strides_}[indices...];
+    }
   }
 
 private:
 
-  std::array<size_t, Rank> shape_{};
-  std::vector<Val> vals_;
+  // Row-major index of the element with the given flat index.
+  constexpr auto unflatten_(size_t flat_index) const noexcept -> Shape {
+    Shape index{};
+    for (size_t axis = Rank; axis-- > 0;) {
+      index[axis] = flat_index % shape_[axis];
+      flat_index /= shape_[axis];
+    }
+    return index;
+  }
+
+  static constexpr auto align_ = std::max(alignof(Val), Layout::align);
+  static constexpr auto tile_volume_ = [] {
+    size_t volume = 1;
+    if constexpr (is_tiled) {
+      for (size_t axis = 0; axis < Rank; ++axis) volume *= Layout::tile;
+    }
+    return volume;
+  }();
+
+  using Allocator_ = std::conditional_t<(align_ > alignof(Val)),
+                                        impl::AlignedAllocator<Val, align_>,
+                                        std::allocator<Val>>;
+
+  Shape shape_{};
+  Shape strides_{};
+  std::vector<Val, Allocator_> vals_;
 
 }; // class Mdvector
 
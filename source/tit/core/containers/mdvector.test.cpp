@@ -4,6 +4,7 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <array>
+#include <bit>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/containers/mdvector.hpp"
@@ -25,6 +26,18 @@ TEST_CASE("Mdspan") {
       CHECK(mdspan.data() == vals.data());
       CHECK_RANGE_EQ(mdspan, vals);
       CHECK_RANGE_EQ(mdspan.shape(), shape);
+      CHECK_RANGE_EQ(mdspan.strides(), std::array{3, 1});
+    }
+    SUBCASE("from shape, strides and values") {
+      // Rows are padded with zeros.
+      const std::array vals{1, 2, 0, 0, 3, 4, 0, 0, 5, 6};
+      const auto shape = std::to_array<size_t>({3, 2});
+      const Mdspan mdspan{vals.begin(), shape, std::to_array<size_t>({4, 1})};
+      CHECK(mdspan.size() == 6);
+      CHECK(mdspan.data() == vals.data());
+      CHECK(mdspan[1, 1] == 4);
+      CHECK(mdspan[2, 0] == 5);
+      CHECK_RANGE_EQ(mdspan[2], std::array{5, 6});
     }
   }
   SUBCASE("operator[]") {
@@ -142,6 +155,58 @@ TEST_CASE("Mdvector") {
   }
 }
 
+TEST_CASE("Mdvector<CacheAlignedLayout>") {
+  const std::array vals{1, 2, 3, 4, 5, 6};
+  const Mdvector<int, 2, CacheAlignedLayout> mdvector{vals.begin(), 2, 3};
+  CHECK(mdvector.size() == 6);
+  CHECK_RANGE_EQ(mdvector.shape(), std::array{2, 3});
+  SUBCASE("storage") {
+    CHECK(std::bit_cast<size_t>(mdvector.data()) % 64 == 0);
+    CHECK_RANGE_EQ(mdvector.strides(), std::array{16, 1});
+    CHECK(mdvector.storage_size() == 32);
+    CHECK(mdvector.data()[16] == 4);
+    CHECK(mdvector.data()[3] == 0); // padding is value-initialized.
+  }
+  SUBCASE("operator[]") {
+    CHECK(mdvector[0, 2] == 3);
+    CHECK(mdvector[1, 0] == 4);
+    CHECK_RANGE_EQ(mdvector[1], std::array{4, 5, 6});
+  }
+  SUBCASE("copy_to") {
+    std::array<int, 6> out{};
+    CHECK(mdvector.copy_to(out.begin()) == out.end());
+    CHECK_RANGE_EQ(out, vals);
+  }
+}
+
+TEST_CASE("Mdvector<TiledLayout>") {
+  const std::array vals{1, 2, 3, 4, 5, 6, 7, 8, 9};
+  Mdvector<int, 2, TiledLayout<2>> mdvector{vals.begin(), 3, 3};
+  CHECK(mdvector.size() == 9);
+  CHECK_RANGE_EQ(mdvector.shape(), std::array{3, 3});
+  SUBCASE("storage") {
+    // Extents are padded to 4, so there are 2x2 tiles of 2x2 values.
+    CHECK(std::bit_cast<size_t>(mdvector.data()) % 64 == 0);
+    CHECK(mdvector.storage_size() == 16);
+    CHECK(mdvector.offset({0, 1}) == 1);
+    CHECK(mdvector.offset({1, 0}) == 2);
+    CHECK(mdvector.offset({0, 2}) == 4);
+    CHECK(mdvector.offset({2, 1}) == 9);
+    CHECK(mdvector.data()[9] == 8);
+  }
+  SUBCASE("operator[]") {
+    CHECK(mdvector[1, 1] == 5);
+    CHECK(mdvector[std::array{2, 2}] == 9);
+    mdvector[1, 2] = 10;
+    CHECK(mdvector.data()[mdvector.offset({1, 2})] == 10);
+  }
+  SUBCASE("copy_to") {
+    std::array<int, 9> out{};
+    mdvector.copy_to(out.begin());
+    CHECK_RANGE_EQ(out, vals);
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
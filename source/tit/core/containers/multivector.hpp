@@ -9,6 +9,7 @@
 #include <concepts>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <numeric>
 #include <ranges>
 #include <span>
@@ -20,8 +21,10 @@
 #include "tit/core/containers/mdvector.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/allocator.hpp"
 #include "tit/core/par/atomic.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/uint_utils.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit {
@@ -73,6 +76,18 @@ public:
                      self.vals_.begin() + self.val_ranges_[index + 1]};
   }
 
+  /// Values of all the buckets, one bucket after another.
+  constexpr auto values(this auto& self) noexcept {
+    return std::span{self.vals_};
+  }
+
+  /// Memory allocated by the multivector (in bytes), including the unused
+  /// capacity.
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return val_ranges_.capacity() * sizeof(size_t) +
+           vals_.capacity() * sizeof(Val);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Clear the multivector.
@@ -99,18 +114,15 @@ public:
   void assign_buckets_par(Buckets&& buckets) {
     TIT_ASSUME_UNIVERSAL(Buckets, buckets);
 
-    // Compute the total number of values.
-    size_t num_values = 0;
+    // Compute the bucket ranges from the bucket sizes.
     val_ranges_.clear(), val_ranges_.resize(std::size(buckets) + 1);
-    for (const auto& [index, bucket] :
-         std::views::as_const(std::views::enumerate(buckets))) {
-      const auto bucket_size = std::size(bucket);
-      val_ranges_[index + 1] = num_values + bucket_size;
-      num_values += bucket_size;
-    }
+    par::transform(buckets, std::next(val_ranges_.begin()), [](const auto& b) {
+      return std::size(b);
+    });
+    par::inclusive_scan(val_ranges_, val_ranges_.begin());
 
     // Copy the values.
-    vals_.resize(num_values);
+    vals_.resize(val_ranges_.back());
     par::for_each( //
         std::views::enumerate(buckets),
         [this](const auto& index_and_bucket) {
@@ -120,6 +132,50 @@ public:
         });
   }
 
+  /// Build the multivector from the buckets that are generated in parallel.
+  ///
+  /// Buckets are generated into the per-thread staging buffers and then
+  /// copied into the storage, so no per-bucket allocations are made.
+  ///
+  /// @param count Amount of the value buckets to be added.
+  /// @param func  Function `func(index, out)` that writes the values of the
+  ///              bucket at @p index into the output iterator @p out.
+  template<class Func>
+    requires std::invocable<Func&,
+                            size_t,
+                            std::back_insert_iterator<std::vector<Val>>>
+  void assign_buckets_par(size_t count, Func func) {
+    // Generate the buckets. Each thread processes a contiguous block of the
+    // bucket indices in order, so its staging buffer matches a contiguous
+    // range of the values.
+    const auto num_threads = par::num_threads();
+    std::vector<std::vector<Val>> thread_vals(num_threads);
+    std::vector<size_t> thread_first(num_threads, count);
+    val_ranges_.clear(), val_ranges_.resize(count + 1);
+    par::static_for_each(
+        std::views::iota(size_t{0}, count),
+        [&func, &thread_vals, &thread_first, this](size_t thread,
+                                                   size_t index) {
+          auto& vals = thread_vals[thread];
+          thread_first[thread] = std::min(thread_first[thread], index);
+          const auto old_size = vals.size();
+          func(index, std::back_inserter(vals));
+          val_ranges_[index + 1] = vals.size() - old_size;
+        });
+
+    // Compute the bucket ranges from the bucket sizes.
+    par::inclusive_scan(val_ranges_, val_ranges_.begin());
+
+    // Copy the values. Threads that got no buckets have empty buffers.
+    vals_.resize(val_ranges_.back());
+    par::for_each(std::views::iota(size_t{0}, num_threads),
+                  [&thread_vals, &thread_first, this](size_t thread) {
+                    std::ranges::copy(
+                        thread_vals[thread],
+                        vals_.begin() + val_ranges_[thread_first[thread]]);
+                  });
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Build the multivector from pairs of bucket indices and values.
@@ -181,6 +237,116 @@ public:
   }
   /// @}
 
+  /// Build the multivector from pairs of bucket indices and values.
+  ///
+  /// Bucket indices are split into the contiguous sub-ranges, a few per
+  /// thread. Pairs are first scattered into a staging buffer grouped by the
+  /// sub-ranges, with the per-thread counters of the sub-ranges only, and
+  /// then each sub-range places its values independently, with the counters
+  /// of its buckets only. No atomic operations are used, and the memory
+  /// overhead does not depend on the product of the bucket and the thread
+  /// counts. Values within each bucket keep their order in @p pairs.
+  ///
+  /// @param count Amount of the value buckets to be added.
+  /// @param pairs Range of the pairs of bucket indices and values.
+  /// @{
+  template<par::range Pairs>
+  constexpr void assign_pairs_par_partitioned(size_t count, Pairs&& pairs) {
+    TIT_ASSUME_UNIVERSAL(Pairs, pairs);
+    assign_pairs_partitioned_impl_(count, [&pairs](auto func) {
+      par::static_for_each(pairs, std::move(func));
+    });
+  }
+  template<par::range Range>
+  constexpr void assign_pairs_par_partitioned(
+      size_t count,
+      std::ranges::join_view<Range> pairs) {
+    auto base = std::move(pairs).base();
+    assign_pairs_partitioned_impl_(count, [&base](auto func) {
+      par::static_for_each(base, [&func](size_t thread, const auto& range) {
+        std::ranges::for_each(range, std::bind_front(std::ref(func), thread));
+      });
+    });
+  }
+  /// @}
+
+  /// Build the multivector from pairs of bucket indices and values.
+  ///
+  /// The assignment strategy is selected from the bucket and the pair
+  /// counts: the "wide" version is used if its per-thread counters are
+  /// small, the "tall" version is used if there are only a few pairs per
+  /// bucket, so that the atomic counters are rarely contended, and the
+  /// partitioned version is used otherwise.
+  ///
+  /// @param count Amount of the value buckets to be added.
+  /// @param pairs Range of the pairs of bucket indices and values.
+  /// @{
+  template<par::range Pairs>
+  constexpr void assign_pairs_par(size_t count, Pairs&& pairs) {
+    TIT_ASSUME_UNIVERSAL(Pairs, pairs);
+    const auto num_pairs = static_cast<size_t>(std::size(pairs));
+    const auto num_counters = count * par::num_threads();
+    if (num_counters <= std::max(max_wide_counters_, num_pairs)) {
+      assign_pairs_par_wide(count, pairs);
+    } else if (num_pairs <= max_tall_bucket_size_ * count) {
+      assign_pairs_par_tall(count, pairs);
+    } else {
+      assign_pairs_par_partitioned(count, pairs);
+    }
+  }
+  template<par::range Range>
+  constexpr void assign_pairs_par(size_t count,
+                                  std::ranges::join_view<Range> pairs) {
+    // Pair count is not known in advance, so the tall version is never
+    // selected.
+    if (count * par::num_threads() <= max_wide_counters_) {
+      assign_pairs_par_wide(count, std::move(pairs));
+    } else {
+      assign_pairs_par_partitioned(count, std::move(pairs));
+    }
+  }
+  /// @}
+
+  /// Build the multivector from the bucket indices, sorted in the ascending
+  /// order, and the corresponding values, e.g. the results of the key sort.
+  ///
+  /// Bucket ranges are found with the binary searches, and the values are
+  /// copied as is. Unlike the other versions, no atomic operations are used,
+  /// and the order of the values within each bucket is preserved.
+  ///
+  /// @param count   Amount of the value buckets to be added.
+  /// @param indices Sorted bucket indices.
+  /// @param values  Values, one per each bucket index.
+  template<par::range Indices, par::range Values>
+  void assign_sorted_pairs_par(size_t count,
+                               Indices&& indices,
+                               Values&& values) {
+    TIT_ASSUME_UNIVERSAL(Indices, indices);
+    TIT_ASSUME_UNIVERSAL(Values, values);
+    TIT_ASSERT(std::size(indices) == std::size(values),
+               "Number of the indices and the values must match!");
+    TIT_ASSERT(std::ranges::is_sorted(indices),
+               "Bucket indices must be sorted!");
+    TIT_ASSERT(std::ranges::empty(indices) ||
+                   std::begin(indices)[std::size(indices) - 1] < count,
+               "Index of the value is out of expected range!");
+
+    // Find the first value of each bucket.
+    val_ranges_.clear(), val_ranges_.resize(count + 1);
+    par::for_each(std::views::iota(size_t{0}, count + 1),
+                  [&indices, this](size_t index) {
+                    const auto iter = std::ranges::lower_bound(indices, index);
+                    val_ranges_[index] = static_cast<size_t>(
+                        std::ranges::distance(std::begin(indices), iter));
+                  });
+
+    // Copy the values.
+    vals_.resize(std::size(values));
+    par::transform(values, vals_.begin(), [](const auto& value) -> Val {
+      return value;
+    });
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
@@ -220,10 +386,11 @@ private:
   constexpr void assign_pairs_wide_impl_(size_t count,
                                          ForEachPair for_each_pair) {
     // Compute how many values there are per each index per each thread.
-    static Mdvector<size_t, 2> per_thread_ranges{};
+    static thread_local Mdvector<size_t, 2> ranges_buffer{};
+    auto& per_thread_ranges = ranges_buffer;
     const auto num_threads = par::num_threads();
     per_thread_ranges.assign(num_threads, count + 1);
-    for_each_pair([count](size_t thread, const auto& pair) {
+    for_each_pair([&per_thread_ranges, count](size_t thread, const auto& pair) {
       const auto index = std::get<0>(pair);
       TIT_ASSERT(index < count, "Index of the value is out of expected range!");
       per_thread_ranges[thread, index] += 1;
@@ -242,19 +409,105 @@ private:
     // Place each value into position of the first element of it's index
     // range, then increment the position.
     vals_.resize(val_ranges_.back());
-    for_each_pair([count, this](size_t thread, const auto& pair) {
-      const auto& [index, value] = pair;
+    for_each_pair(
+        [&per_thread_ranges, count, this](size_t thread, const auto& pair) {
+          const auto& [index, value] = pair;
+          TIT_ASSERT(index < count,
+                     "Index of the value is out of expected range!");
+          auto& position = per_thread_ranges[thread, index];
+          vals_[position] = value;
+          position += 1;
+        });
+  }
+
+  template<class ForEachPair>
+  constexpr void assign_pairs_partitioned_impl_(size_t count,
+                                                ForEachPair for_each_pair) {
+    // Split the bucket indices into the sub-ranges, and compute how many
+    // values there are per each sub-range per each thread.
+    static thread_local Mdvector<size_t, 2> ranges_buffer{};
+    auto& per_thread_ranges = ranges_buffer;
+    const auto num_threads = par::num_threads();
+    const auto num_ranges =
+        std::max<size_t>(std::min(count, num_threads * ranges_per_thread_), 1);
+    const auto range_size = std::max<size_t>(divide_up(count, num_ranges), 1);
+    per_thread_ranges.assign(num_threads, num_ranges + 1);
+    for_each_pair([&per_thread_ranges, count, range_size](size_t thread,
+                                                          const auto& pair) {
+      const auto index = std::get<0>(pair);
       TIT_ASSERT(index < count, "Index of the value is out of expected range!");
-      auto& position = per_thread_ranges[thread, index];
-      vals_[position] = value;
+      per_thread_ranges[thread, index / range_size] += 1;
+    });
+
+    // Compute the staging positions of the sub-ranges per each thread, and
+    // the first staging positions of the sub-ranges.
+    std::vector<size_t> range_first(num_ranges + 1);
+    for (size_t offset = 0, range = 0; range < num_ranges; ++range) {
+      range_first[range] = offset;
+      for (size_t thread = 0; thread < num_threads; ++thread) {
+        per_thread_ranges[thread, range] =
+            std::exchange(offset, offset + per_thread_ranges[thread, range]);
+      }
+      range_first[range + 1] = offset;
+    }
+
+    // Scatter the pairs into the staging buffer, grouped by the sub-ranges.
+    static thread_local std::vector<std::pair<size_t, Val>> staging_buffer{};
+    auto& staging = staging_buffer;
+    staging.resize(range_first.back());
+    for_each_pair([&per_thread_ranges, &staging, range_size](size_t thread,
+                                                             const auto& pair) {
+      const auto& [index, value] = pair;
+      auto& position = per_thread_ranges[thread, index / range_size];
+      staging[position] = {index, value};
       position += 1;
     });
+
+    // Place the values of each sub-range. Sub-ranges own the disjoint
+    // ranges of the buckets and the values, so they are processed
+    // independently. Bucket sizes are accumulated into the slots of the next
+    // buckets, converted to the first positions and then incremented while
+    // placing the values, so that they end up at the bucket ends.
+    val_ranges_.clear(), val_ranges_.resize(count + 1);
+    vals_.resize(range_first.back());
+    par::for_each(
+        std::views::iota(size_t{0}, num_ranges),
+        [&staging, &range_first, count, range_size, this](size_t range) {
+          const auto first_index = std::min(range * range_size, count);
+          const auto last_index = std::min(first_index + range_size, count);
+          const std::span range_pairs{
+              staging.begin() + range_first[range],
+              staging.begin() + range_first[range + 1]};
+          for (const auto& [index, value] : range_pairs) {
+            val_ranges_[index + 1] += 1;
+          }
+          for (auto offset = range_first[range], index = first_index;
+               index < last_index;
+               ++index) {
+            auto& position = val_ranges_[index + 1];
+            position = std::exchange(offset, offset + position);
+          }
+          for (const auto& [index, value] : range_pairs) {
+            auto& position = val_ranges_[index + 1];
+            vals_[position] = value;
+            position += 1;
+          }
+        });
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  std::vector<size_t> val_ranges_{0};
-  std::vector<Val> vals_;
+  // Largest number of the per-thread counters of the "wide" version.
+  static constexpr size_t max_wide_counters_ = size_t{1} << 18;
+
+  // Largest average bucket size for the "tall" version.
+  static constexpr size_t max_tall_bucket_size_ = 4;
+
+  // Number of the sub-ranges per thread for the partitioned version.
+  static constexpr size_t ranges_per_thread_ = 8;
+
+  std::vector<size_t, par::Allocator<size_t>> val_ranges_{0};
+  std::vector<Val, par::Allocator<Val>> vals_;
 
 }; // class Multivector
 
@@ -264,6 +517,259 @@ Multivector(std::initializer_list<std::initializer_list<Val>>)
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Multivector with a slack capacity in each bucket, that can be updated in
+/// place.
+///
+/// Buckets are stored one after another, each followed by the unused slots.
+/// Bucket that fits into its capacity is updated in place, otherwise it is
+/// relocated to the end of the storage, and its old slots are wasted until
+/// the next compaction. Updating a small fraction of the buckets costs
+/// roughly the same fraction of the full rebuild.
+template<class Val>
+class SlackMultivector {
+public:
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Default slack capacity of a bucket.
+  static constexpr size_t default_slack = 4;
+
+  /// Construct an empty multivector.
+  ///
+  /// @param slack Number of the unused slots reserved after each bucket.
+  constexpr explicit SlackMultivector(size_t slack = default_slack) noexcept
+      : slack_{slack} {}
+
+  /// Construct a multivector from initial values.
+  constexpr explicit SlackMultivector(
+      std::initializer_list<std::initializer_list<Val>> buckets,
+      size_t slack = default_slack)
+      : slack_{slack} {
+    for (const auto& bucket : buckets) append_bucket(bucket);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Multivector size.
+  constexpr auto size() const noexcept -> size_t {
+    return bucket_sizes_.size();
+  }
+
+  /// Is multivector empty?
+  constexpr auto empty() const noexcept -> bool {
+    return bucket_sizes_.empty();
+  }
+
+  /// Range of bucket sizes.
+  constexpr auto bucket_sizes() const noexcept -> std::span<const size_t> {
+    return bucket_sizes_;
+  }
+
+  /// Capacity of the bucket at index.
+  constexpr auto capacity(size_t index) const noexcept -> size_t {
+    TIT_ASSERT(index < size(), "Bucket index is out of range!");
+    return bucket_caps_[index];
+  }
+
+  /// Slack capacity of a bucket.
+  constexpr auto slack() const noexcept -> size_t {
+    return slack_;
+  }
+
+  /// Fraction of the storage wasted by the relocated buckets.
+  constexpr auto fragmentation() const noexcept -> float64_t {
+    if (vals_.empty()) return 0.0;
+    return static_cast<float64_t>(num_wasted_) /
+           static_cast<float64_t>(vals_.size());
+  }
+
+  /// Buckets of values.
+  constexpr auto buckets(this auto& self) noexcept {
+    return std::views::iota(size_t{0}, self.size()) |
+           std::views::transform([&self](size_t index) { return self[index]; });
+  }
+
+  /// Bucket of values at index.
+  constexpr auto operator[](this auto& self, size_t index) noexcept {
+    TIT_ASSERT(index < self.size(), "Bucket index is out of range!");
+    return std::span{self.vals_.begin() + self.bucket_firsts_[index],
+                     self.bucket_sizes_[index]};
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Clear the multivector.
+  constexpr void clear() noexcept {
+    bucket_firsts_.clear();
+    bucket_sizes_.clear();
+    bucket_caps_.clear();
+    vals_.clear();
+    num_wasted_ = 0;
+  }
+
+  /// Append a new bucket to the multivector.
+  template<std::ranges::input_range Bucket>
+    requires std::constructible_from<Val,
+                                     std::ranges::range_reference_t<Bucket>>
+  constexpr void append_bucket(Bucket&& bucket) {
+    TIT_ASSUME_UNIVERSAL(Bucket, bucket);
+    bucket_firsts_.push_back(vals_.size());
+    std::ranges::copy(bucket, std::back_inserter(vals_));
+    const auto bucket_size = vals_.size() - bucket_firsts_.back();
+    bucket_sizes_.push_back(bucket_size);
+    bucket_caps_.push_back(bucket_size + slack_);
+    vals_.resize(vals_.size() + slack_);
+  }
+
+  /// Assign the bucket at index, in place if it fits into its capacity.
+  template<std::ranges::input_range Bucket>
+    requires std::constructible_from<Val,
+                                     std::ranges::range_reference_t<Bucket>>
+  constexpr void set_bucket(size_t index, Bucket&& bucket) {
+    TIT_ASSUME_UNIVERSAL(Bucket, bucket);
+    TIT_ASSERT(index < size(), "Bucket index is out of range!");
+    if constexpr (std::ranges::sized_range<Bucket>) {
+      reserve_bucket_(index, std::size(bucket));
+      std::ranges::copy(bucket, vals_.begin() + bucket_firsts_[index]);
+      bucket_sizes_[index] = std::size(bucket);
+    } else {
+      set_bucket(index, std::ranges::to<std::vector<Val>>(bucket));
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Build the multivector from a range of buckets.
+  template<par::range Buckets>
+  void assign_buckets_par(Buckets&& buckets) {
+    TIT_ASSUME_UNIVERSAL(Buckets, buckets);
+    bucket_sizes_.resize(std::size(buckets));
+    par::transform(buckets, bucket_sizes_.begin(), [](const auto& b) {
+      return std::size(b);
+    });
+    layout_();
+    par::for_each( //
+        std::views::enumerate(buckets),
+        [this](const auto& index_and_bucket) {
+          const auto& [index, bucket] = index_and_bucket;
+          std::ranges::copy(bucket, vals_.begin() + bucket_firsts_[index]);
+        });
+  }
+
+  /// Update the buckets at the given indices, that are generated in parallel.
+  ///
+  /// Buckets are generated into the per-thread staging buffers. Buckets
+  /// that fit into their capacity are copied in place, the rest are
+  /// relocated to the end of the storage.
+  ///
+  /// @param indices Range of the unique bucket indices to be updated.
+  /// @param func    Function `func(index, out)` that writes the new values of
+  ///                the bucket at @p index into the output iterator @p out.
+  template<par::range Indices, class Func>
+    requires std::invocable<Func&,
+                            size_t,
+                            std::back_insert_iterator<std::vector<Val>>>
+  void update_buckets_par(Indices&& indices, Func func) {
+    TIT_ASSUME_UNIVERSAL(Indices, indices);
+
+    // Generate the buckets. Each thread records the indices and the sizes
+    // of its buckets, in order.
+    const auto num_threads = par::num_threads();
+    std::vector<std::vector<Val>> thread_vals(num_threads);
+    std::vector<std::vector<std::pair<size_t, size_t>>> thread_buckets(
+        num_threads);
+    par::static_for_each(
+        indices,
+        [&func, &thread_vals, &thread_buckets, this](size_t thread,
+                                                     size_t index) {
+          TIT_ASSERT(index < size(), "Bucket index is out of range!");
+          auto& vals = thread_vals[thread];
+          const auto old_size = vals.size();
+          func(index, std::back_inserter(vals));
+          thread_buckets[thread].emplace_back(index, vals.size() - old_size);
+        });
+
+    // Relocate the buckets that do not fit. This pass is sequential, but
+    // touches the updated buckets only.
+    for (const auto& buckets : thread_buckets) {
+      for (const auto& [index, bucket_size] : buckets) {
+        reserve_bucket_(index, bucket_size);
+        bucket_sizes_[index] = bucket_size;
+      }
+    }
+
+    // Copy the values.
+    par::for_each(
+        std::views::iota(size_t{0}, num_threads),
+        [&thread_vals, &thread_buckets, this](size_t thread) {
+          auto iter = thread_vals[thread].begin();
+          for (const auto& [index, bucket_size] : thread_buckets[thread]) {
+            const auto next = iter + static_cast<ssize_t>(bucket_size);
+            std::copy(iter, next, vals_.begin() + bucket_firsts_[index]);
+            iter = next;
+          }
+        });
+  }
+
+  /// Compact the storage: lay out the buckets in order, each followed by the
+  /// slack capacity, and release the wasted slots.
+  ///
+  /// Should be called periodically, for example, when the fragmentation
+  /// exceeds a threshold.
+  void compact() {
+    const auto old_firsts = std::move(bucket_firsts_);
+    auto old_vals = std::move(vals_);
+    layout_();
+    par::for_each(std::views::iota(size_t{0}, size()),
+                  [&old_firsts, &old_vals, this](size_t index) {
+                    const auto first = old_vals.begin() + old_firsts[index];
+                    std::copy(first,
+                              first + bucket_sizes_[index],
+                              vals_.begin() + bucket_firsts_[index]);
+                  });
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  // Compute the bucket capacities and positions from the bucket sizes, and
+  // allocate the storage.
+  void layout_() {
+    bucket_caps_.resize(size());
+    par::transform(bucket_sizes_,
+                   bucket_caps_.begin(),
+                   [slack = slack_](size_t bucket_size) {
+                     return bucket_size + slack;
+                   });
+    bucket_firsts_.resize(size());
+    par::exclusive_scan(bucket_caps_, bucket_firsts_.begin(), size_t{0});
+    vals_.clear();
+    vals_.resize(empty() ? 0 : bucket_firsts_.back() + bucket_caps_.back());
+    num_wasted_ = 0;
+  }
+
+  // Ensure the bucket at index can hold the given number of values,
+  // relocating it to the end of the storage if needed.
+  constexpr void reserve_bucket_(size_t index, size_t bucket_size) {
+    if (bucket_size <= bucket_caps_[index]) return;
+    num_wasted_ += bucket_caps_[index];
+    bucket_firsts_[index] = vals_.size();
+    bucket_caps_[index] = bucket_size + slack_;
+    vals_.resize(vals_.size() + bucket_caps_[index]);
+  }
+
+  size_t slack_;
+  size_t num_wasted_ = 0;
+  std::vector<size_t, par::Allocator<size_t>> bucket_firsts_;
+  std::vector<size_t> bucket_sizes_;
+  std::vector<size_t, par::Allocator<size_t>> bucket_caps_;
+  std::vector<Val, par::Allocator<Val>> vals_;
+
+}; // class SlackMultivector
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Multivector with a known upper bound on the bucket size.
 template<class Val, size_t MaxBucketSize>
 class CapMultivector {
@@ -39,6 +39,8 @@ TEST_CASE("Multivector") {
     CHECK_RANGE_EQ(multivector[0], std::vector{1, 2, 3, 4});
     CHECK_RANGE_EQ(multivector[1], std::vector{5, 6, 7});
     CHECK_RANGE_EQ(multivector[2], std::vector{8, 9});
+    CHECK_RANGE_EQ(multivector.values(),
+                   std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9});
   }
 }
 
@@ -116,6 +118,22 @@ TEST_CASE("Multivector::assign_buckets_par") {
   }
 }
 
+TEST_CASE("Multivector::assign_buckets_par(generator)") {
+  // Build a multivector with the bucket `i` holding `i % 7` copies of `i`.
+  constexpr size_t count = 100;
+  Multivector<size_t> multivector{};
+  multivector.assign_buckets_par(count, [](size_t index, auto out) {
+    std::ranges::fill_n(out, index % 7, index);
+  });
+
+  // Ensure the multivector is correct.
+  REQUIRE(multivector.size() == count);
+  for (size_t index = 0; index < count; ++index) {
+    CHECK_RANGE_EQ(multivector[index],
+                   std::vector<size_t>(index % 7, index));
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("Multivector::assign_pairs_par_tall") {
@@ -172,6 +190,178 @@ TEST_CASE("Multivector::assign_pairs_par_wide") {
   CHECK_RANGE_EQ(multivector[2], std::vector{8, 9});
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Multivector::assign_pairs_par_partitioned") {
+  SUBCASE("basic") {
+    // Build a multivector from a sequence of pairs.
+    const std::vector<std::pair<size_t, int>> pairs{
+        {0, 1},
+        {2, 8},
+        {0, 2},
+        {0, 4},
+        {1, 5},
+        {1, 6},
+        {0, 3},
+        {1, 7},
+        {2, 9},
+    };
+    Multivector<int> multivector{};
+    multivector.assign_pairs_par_partitioned(3, pairs);
+
+    // Ensure the multivector is correct. Order of the values is preserved.
+    REQUIRE(multivector.size() == 3);
+    CHECK_RANGE_EQ(multivector[0], std::vector{1, 2, 4, 3});
+    CHECK_RANGE_EQ(multivector[1], std::vector{5, 6, 7});
+    CHECK_RANGE_EQ(multivector[2], std::vector{8, 9});
+  }
+  SUBCASE("many buckets") {
+    // Build a multivector with many buckets, some of them are empty.
+    constexpr size_t count = 1000;
+    const auto pairs = std::views::iota(size_t{0}, 5 * count) |
+                       std::views::transform([](size_t i) {
+                         return std::pair{(7 * i) % count / 2 * 2, i};
+                       });
+    Multivector<size_t> multivector{};
+    multivector.assign_pairs_par_partitioned(count, pairs);
+
+    // Ensure the multivector matches the sequential version.
+    Multivector<size_t> expected{};
+    expected.assign_pairs_seq(count, pairs);
+    REQUIRE(multivector.size() == count);
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_RANGE_EQ(multivector[i], expected[i]);
+    }
+  }
+}
+
+TEST_CASE("Multivector::assign_pairs_par") {
+  // Build a multivector from a sequence of pairs.
+  const std::vector<std::pair<size_t, int>> pairs{
+      {0, 1},
+      {2, 8},
+      {0, 2},
+      {0, 4},
+      {1, 5},
+      {1, 6},
+      {0, 3},
+      {1, 7},
+      {2, 9},
+  };
+  Multivector<int> multivector{};
+  multivector.assign_pairs_par(3, pairs);
+
+  // Sort the buckets, since parallel algorithms does not guarantee order.
+  std::ranges::for_each(multivector.buckets(), std::ranges::sort);
+
+  // Ensure the multivector is correct.
+  REQUIRE(multivector.size() == 3);
+  CHECK_RANGE_EQ(multivector[0], std::vector{1, 2, 3, 4});
+  CHECK_RANGE_EQ(multivector[1], std::vector{5, 6, 7});
+  CHECK_RANGE_EQ(multivector[2], std::vector{8, 9});
+}
+
+TEST_CASE("Multivector::assign_sorted_pairs_par") {
+  // Build a multivector from the sorted indices, with the empty buckets.
+  const std::vector<size_t> indices{0, 0, 0, 2, 2, 3};
+  const std::vector<int> values{3, 1, 2, 6, 5, 4};
+  Multivector<int> multivector{};
+  multivector.assign_sorted_pairs_par(5, indices, values);
+
+  // Ensure the multivector is correct, and the order of values is kept.
+  REQUIRE(multivector.size() == 5);
+  CHECK_RANGE_EQ(multivector[0], std::vector{3, 1, 2});
+  CHECK(multivector[1].empty());
+  CHECK_RANGE_EQ(multivector[2], std::vector{6, 5});
+  CHECK_RANGE_EQ(multivector[3], std::vector{4});
+  CHECK(multivector[4].empty());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// SlackMultivector class.
+//
+
+TEST_CASE("SlackMultivector") {
+  SUBCASE("empty") {
+    const SlackMultivector<int> multivector{};
+    CHECK(multivector.size() == 0);
+    CHECK(multivector.empty());
+    CHECK_RANGE_EMPTY(multivector.bucket_sizes());
+    CHECK_RANGE_EMPTY(multivector.buckets());
+  }
+  SUBCASE("from initial values") {
+    const SlackMultivector<int> multivector{{1, 2, 3, 4}, {5, 6, 7}, {8, 9}};
+    CHECK(multivector.size() == 3);
+    CHECK_FALSE(multivector.empty());
+    CHECK_RANGE_EQ(multivector.bucket_sizes(), std::vector{4, 3, 2});
+    CHECK_RANGE_EQ(multivector.buckets() | std::views::join,
+                   std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9});
+    CHECK(multivector.capacity(0) == 4 + multivector.slack());
+  }
+}
+
+TEST_CASE("SlackMultivector::set_bucket") {
+  SlackMultivector<int> multivector({{1, 2}, {3}}, /*slack=*/1);
+  SUBCASE("in place") {
+    multivector.set_bucket(0, std::vector{4, 5, 6});
+    CHECK(multivector.capacity(0) == 3);
+    CHECK(multivector.fragmentation() == 0.0);
+    CHECK_RANGE_EQ(multivector[0], std::vector{4, 5, 6});
+    CHECK_RANGE_EQ(multivector[1], std::vector{3});
+  }
+  SUBCASE("relocate") {
+    multivector.set_bucket(0, std::vector{4, 5, 6, 7});
+    CHECK(multivector.capacity(0) == 5);
+    CHECK(multivector.fragmentation() > 0.0);
+    CHECK_RANGE_EQ(multivector[0], std::vector{4, 5, 6, 7});
+    CHECK_RANGE_EQ(multivector[1], std::vector{3});
+  }
+}
+
+TEST_CASE("SlackMultivector::assign_buckets_par") {
+  const std::vector<std::vector<int>> buckets{{1, 2, 3, 4}, {}, {5, 6}};
+  SlackMultivector<int> multivector{};
+  multivector.assign_buckets_par(buckets);
+  REQUIRE(multivector.size() == buckets.size());
+  for (const auto& [bucket, expected] :
+       std::views::zip(multivector.buckets(), buckets)) {
+    CHECK_RANGE_EQ(bucket, expected);
+  }
+}
+
+TEST_CASE("SlackMultivector::update_buckets_par") {
+  // Build a multivector, where bucket `i` holds `i` copies of `i`.
+  constexpr size_t count = 100;
+  SlackMultivector<size_t> multivector(/*slack=*/2);
+  multivector.assign_buckets_par(
+      std::views::iota(size_t{0}, count) | std::views::transform([](size_t i) {
+        return std::views::repeat(i, i);
+      }));
+
+  // Grow every tenth bucket, some of them beyond the slack capacity.
+  const auto indices = std::views::iota(size_t{0}, count / 10) |
+                       std::views::transform([](size_t i) { return 10 * i; });
+  const auto new_size = [](size_t i) { return i + i / 20; };
+  multivector.update_buckets_par(indices, [&new_size](size_t i, auto out) {
+    std::ranges::fill_n(out, static_cast<ssize_t>(new_size(i)), i);
+  });
+  const auto check = [&multivector, &new_size] {
+    REQUIRE(multivector.size() == count);
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_RANGE_EQ(multivector[i],
+                     std::views::repeat(i, i % 10 == 0 ? new_size(i) : i));
+    }
+  };
+  check();
+  CHECK(multivector.fragmentation() > 0.0);
+
+  // Compact the storage.
+  multivector.compact();
+  check();
+  CHECK(multivector.fragmentation() == 0.0);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
 // CapMultivector class.
@@ -0,0 +1,284 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/io.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/sys/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Queued log message.
+struct LogMessage final {
+  LogLevel level;
+  std::string text;
+};
+
+// Lock-free bounded multi-producer queue of the messages. Each slot carries
+// a sequence number, that tells whether the slot is free for the push at the
+// given position, or holds the message to be popped. Messages are popped by
+// the writer, and by the signal handler, so the slots are claimed by moving
+// the tail, and the claimed slots are never touched by the other consumer.
+class LogQueue final {
+public:
+
+  // Construct the queue with the given capacity, that is a power of two.
+  explicit LogQueue(size_t capacity)
+      : mask_{capacity - 1}, slots_{std::make_unique<Slot[]>(capacity)} {
+    TIT_ASSERT(std::has_single_bit(capacity),
+               "Capacity must be a power of two!");
+    for (size_t i = 0; i < capacity; ++i) slots_[i].seq.store(i);
+  }
+
+  // Try to push the message. Returns false if the queue is full.
+  auto try_push(LogMessage& message) noexcept -> bool {
+    auto pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& slot = slots_[pos & mask_];
+      const auto seq = slot.seq.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos,
+                                        pos + 1,
+                                        std::memory_order_relaxed)) {
+          slot.message = std::move(message);
+          slot.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Try to pop the message.
+  auto try_pop() noexcept -> std::optional<LogMessage> {
+    auto* const slot = try_claim_();
+    if (slot == nullptr) return {};
+    auto message = std::move(slot->message);
+    release_(*slot);
+    return message;
+  }
+
+  // Pop each queued message and call the function for it. Messages are not
+  // moved out of the slots, so no memory is allocated or freed, and it
+  // could be called from the signal handler. Returns the number of the
+  // popped messages.
+  template<class Func>
+  auto pop_each(const Func& func) noexcept -> size_t {
+    size_t count = 0;
+    while (auto* const slot = try_claim_()) {
+      func(std::as_const(slot->message));
+      release_(*slot);
+      ++count;
+    }
+    return count;
+  }
+
+private:
+
+  struct Slot final {
+    std::atomic<size_t> seq;
+    LogMessage message;
+  };
+
+  // Claim the slot at the tail, if it holds the message.
+  auto try_claim_() noexcept -> Slot* {
+    auto pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& slot = slots_[pos & mask_];
+      if (slot.seq.load(std::memory_order_acquire) != pos + 1) return nullptr;
+      if (tail_.compare_exchange_weak(pos,
+                                      pos + 1,
+                                      std::memory_order_relaxed)) {
+        return &slot;
+      }
+    }
+  }
+
+  // Release the claimed slot for the next push.
+  void release_(Slot& slot) noexcept {
+    const auto pos = slot.seq.load(std::memory_order_relaxed) - 1;
+    slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+  }
+
+  size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+
+}; // class LogQueue
+
+// Global asynchronous logger state.
+struct LoggerState final {
+  std::unique_ptr<LogQueue> queue;
+  std::atomic<size_t> num_pushed{0};
+  std::atomic<size_t> num_written{0};
+  std::atomic<size_t> num_dropped{0};
+  std::atomic<size_t> num_wakeups{0};
+  std::jthread writer;
+};
+
+auto state() -> LoggerState& {
+  static LoggerState instance;
+  return instance;
+}
+
+// Write the message synchronously.
+void write_message(const LogMessage& message) {
+  if (message.level == LogLevel::info) {
+    println("{}", message.text);
+    std::fflush(stdout);
+  } else {
+    eprintln("{}", message.text);
+  }
+}
+
+// Wake up the writer.
+void wake_writer() noexcept {
+  auto& s = state();
+  s.num_wakeups.fetch_add(1, std::memory_order_release);
+  s.num_wakeups.notify_one();
+}
+
+// Write the queued messages, until the stop is requested and the queue is
+// drained.
+void write_messages(const std::stop_token& stop_token) {
+  auto& s = state();
+  while (true) {
+    const auto num_wakeups = s.num_wakeups.load(std::memory_order_acquire);
+    while (auto message = s.queue->try_pop()) {
+      write_message(*message);
+      s.num_written.fetch_add(1, std::memory_order_release);
+      s.num_written.notify_all();
+    }
+    if (stop_token.stop_requested()) break;
+    s.num_wakeups.wait(num_wakeups, std::memory_order_acquire);
+  }
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+std::atomic_bool Logger::is_async_{false};
+
+void Logger::enable_async(size_t capacity) {
+  TIT_ASSERT(capacity > 0, "Capacity must be positive!");
+  auto& s = state();
+  TIT_ASSERT(s.queue == nullptr, "Asynchronous logging is already enabled!");
+  s.queue = std::make_unique<LogQueue>(std::bit_ceil(capacity));
+  s.writer = std::jthread{[](std::stop_token stop_token) {
+    write_messages(stop_token);
+  }};
+  is_async_ = true;
+
+  // Write the rest of the messages at exit, and report the dropped ones.
+  checked_atexit([] {
+    auto& writer = state().writer;
+    writer.request_stop();
+    wake_writer();
+    writer.join();
+    is_async_ = false;
+    if (const auto num_dropped = Logger::num_dropped(); num_dropped > 0) {
+      eprintln("WARN: {} log messages were dropped.", num_dropped);
+    }
+  });
+}
+
+void Logger::write(LogLevel level, std::string message) {
+  LogMessage log_message{.level = level, .text = std::move(message)};
+  if (!is_async()) {
+    write_message(log_message);
+    return;
+  }
+
+  // Information messages are dropped if the queue is full, while the rest
+  // of the messages wait for the writer to free a slot.
+  auto& s = state();
+  while (!s.queue->try_push(log_message)) {
+    if (level == LogLevel::info) {
+      s.num_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    std::this_thread::yield();
+  }
+  s.num_pushed.fetch_add(1, std::memory_order_release);
+  wake_writer();
+}
+
+void Logger::flush() {
+  if (!is_async()) {
+    std::fflush(stdout);
+    return;
+  }
+  auto& s = state();
+  const auto num_pushed = s.num_pushed.load(std::memory_order_acquire);
+  auto num_written = s.num_written.load(std::memory_order_acquire);
+  while (num_written < num_pushed) {
+    s.num_written.wait(num_written, std::memory_order_acquire);
+    num_written = s.num_written.load(std::memory_order_acquire);
+  }
+}
+
+void Logger::flush_on_signal() noexcept {
+  if (!is_async()) return;
+  auto& s = state();
+  const auto num_written = s.queue->pop_each([](const LogMessage& message) {
+    const auto fd =
+        message.level == LogLevel::info ? STDOUT_FILENO : STDERR_FILENO;
+    auto result = ::write(fd, message.text.data(), message.text.size());
+    result = ::write(fd, "\n", 1);
+    static_cast<void>(result); // Ignore the result.
+  });
+  // Waiters are not notified, that is not async-signal-safe.
+  s.num_written.fetch_add(num_written, std::memory_order_release);
+}
+
+auto Logger::num_dropped() noexcept -> size_t {
+  return state().num_dropped.load(std::memory_order_relaxed);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LogRateLimit::LogRateLimit(float64_t interval) noexcept
+    : interval_ns_{static_cast<int64_t>(interval * 1.0e9)} {}
+
+auto LogRateLimit::try_acquire() noexcept -> bool {
+  const auto now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  auto last_ns = last_ns_.load(std::memory_order_relaxed);
+  if (last_ns != 0 && now_ns - last_ns < interval_ns_) return false;
+  return last_ns_.compare_exchange_strong(last_ns,
+                                          now_ns,
+                                          std::memory_order_relaxed);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
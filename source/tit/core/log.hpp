@@ -5,20 +5,123 @@
 
 #pragma once
 
+#include <atomic>
+#include <format>
+#include <string>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/io.hpp" // IWYU pragma: keep
 
+namespace tit {
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Log message level.
+enum class LogLevel : uint8_t {
+  info,    ///< Information message, written to the standard output.
+  warning, ///< Warning message, written to the standard error.
+  error,   ///< Error message, written to the standard error.
+};
+
+/// Log messages interface.
+///
+/// By default, messages are written synchronously. In the asynchronous mode,
+/// messages are formatted by the caller, put into the lock-free bounded
+/// queue and written by a background thread, so that the slow terminals and
+/// file systems do not stall the caller. All the functions are thread-safe.
+class Logger final {
+public:
+
+  /// Logger is a static object.
+  Logger() = delete;
+
+  /// Enable the asynchronous mode.
+  ///
+  /// When the queue is full, the information messages are dropped and
+  /// counted, while the warnings and the errors wait for the free slot.
+  /// Queued messages are written at exit, and on the fatal signals.
+  ///
+  /// @param capacity Queue capacity, rounded up to the power of two.
+  static void enable_async(size_t capacity = 1024);
+
+  /// Check if the asynchronous mode is enabled.
+  static auto is_async() noexcept -> bool {
+    return is_async_.load(std::memory_order_relaxed);
+  }
+
+  /// Write the message.
+  static void write(LogLevel level, std::string message);
+
+  /// Wait until all the queued messages are written.
+  static void flush();
+
+  /// Write the queued messages in the "async-signal-safe" way. Messages are
+  /// claimed from the queue, so each one is written exactly once, either by
+  /// this call, or by the background thread, that may keep running.
+  static void flush_on_signal() noexcept;
+
+  /// Number of the information messages dropped because of the full queue.
+  static auto num_dropped() noexcept -> size_t;
+
+private:
+
+  static std::atomic_bool is_async_;
+
+}; // class Logger
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Rate limit of the messages of a single call site.
+class LogRateLimit final {
+public:
+
+  /// Construct the rate limit.
+  ///
+  /// @param interval Minimal interval between the messages (in seconds).
+  explicit LogRateLimit(float64_t interval) noexcept;
+
+  /// Check if the message can be written now, and if so, start the next
+  /// interval.
+  auto try_acquire() noexcept -> bool;
+
+private:
+
+  int64_t interval_ns_;
+  std::atomic<int64_t> last_ns_{0};
+
+}; // class LogRateLimit
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Format and write the log message.
+#define TIT_LOG_(level, message, ...)                                          \
+  tit::Logger::write(level, std::format(message __VA_OPT__(, __VA_ARGS__)))
+
 /// Print information message.
 #define TIT_INFO(message, ...)                                                 \
-  tit::println("INFO: " message __VA_OPT__(, __VA_ARGS__))
+  TIT_LOG_(tit::LogLevel::info, "INFO: " message __VA_OPT__(, __VA_ARGS__))
+
+/// Print information message, at most once per interval (in seconds) for
+/// the call site. Messages within the interval are skipped without being
+/// formatted.
+#define TIT_INFO_EVERY(interval, message, ...)                                 \
+  do {                                                                         \
+    static tit::LogRateLimit tit_log_rate_limit_{interval};                    \
+    if (tit_log_rate_limit_.try_acquire()) {                                   \
+      TIT_INFO(message __VA_OPT__(, __VA_ARGS__));                             \
+    }                                                                          \
+  } while (false)
 
 /// Print warning message.
 #define TIT_WARN(message, ...)                                                 \
-  tit::eprintln("WARN: " message __VA_OPT__(, __VA_ARGS__))
+  TIT_LOG_(tit::LogLevel::warning, "WARN: " message __VA_OPT__(, __VA_ARGS__))
 
 /// Print error message.
 #define TIT_ERROR(message, ...)                                                \
-  tit::eprintln("ERROR: " message __VA_OPT__(, __VA_ARGS__))
+  TIT_LOG_(tit::LogLevel::error, "ERROR: " message __VA_OPT__(, __VA_ARGS__))
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
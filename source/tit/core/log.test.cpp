@@ -0,0 +1,124 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("LogRateLimit") {
+  SUBCASE("zero interval") {
+    // Ensure every message is allowed.
+    LogRateLimit rate_limit{0.0};
+    CHECK(rate_limit.try_acquire());
+    CHECK(rate_limit.try_acquire());
+  }
+  SUBCASE("interval") {
+    // Ensure the first message is allowed, and the next one is only allowed
+    // once the interval has passed.
+    using namespace std::chrono_literals;
+    LogRateLimit rate_limit{0.05};
+    CHECK(rate_limit.try_acquire());
+    CHECK_FALSE(rate_limit.try_acquire());
+    std::this_thread::sleep_for(60ms);
+    CHECK(rate_limit.try_acquire());
+    CHECK_FALSE(rate_limit.try_acquire());
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Logger::flush_on_signal") {
+  // Ensure that each message is written exactly once, when the queue is
+  // flushed repeatedly while the producers and the writer thread are running.
+  // Standard output is redirected into the file for the duration of the test.
+  constexpr size_t num_producers = 4;
+  constexpr size_t num_messages = 200;
+  const std::filesystem::path file_name{"test_log.txt"};
+  std::fflush(stdout);
+  const auto saved_stdout = dup(STDOUT_FILENO);
+  REQUIRE(saved_stdout >= 0);
+  {
+    // NOLINTNEXTLINE(*-vararg)
+    const auto fd = ::open(file_name.c_str(),
+                           O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                           0644);
+    REQUIRE(fd >= 0);
+    REQUIRE(dup2(fd, STDOUT_FILENO) >= 0);
+    close(fd);
+  }
+  Logger::enable_async(num_producers * num_messages);
+  {
+    std::atomic_bool done = false;
+    const std::jthread flusher{[&done] {
+      while (!done.load()) Logger::flush_on_signal();
+    }};
+    {
+      std::vector<std::jthread> producers;
+      for (size_t i = 0; i < num_producers; ++i) {
+        producers.emplace_back([i] {
+          for (size_t j = 0; j < num_messages; ++j) {
+            Logger::write(LogLevel::info,
+                          std::format("message {}", i * num_messages + j));
+          }
+        });
+      }
+    }
+    done = true;
+  }
+  Logger::flush();
+  std::fflush(stdout);
+  REQUIRE(dup2(saved_stdout, STDOUT_FILENO) >= 0);
+  close(saved_stdout);
+  CHECK(Logger::num_dropped() == 0);
+
+  // Messages written by the writer and by the flush may interleave, so they
+  // are searched for by the prefix, rather than line by line.
+  std::vector<byte_t> bytes;
+  read_from(make_file_input_stream(file_name), bytes, /*chunk_size=*/256);
+  const std::string_view output{reinterpret_cast<const char*>(bytes.data()),
+                                bytes.size()};
+  constexpr std::string_view prefix = "message ";
+  std::vector<size_t> counts(num_producers * num_messages);
+  for (auto pos = output.find(prefix); pos != std::string_view::npos;
+       pos = output.find(prefix, pos)) {
+    pos += prefix.size();
+    size_t index = 0;
+    const auto* const last = output.data() + output.size();
+    const auto result = std::from_chars(output.data() + pos, last, index);
+    REQUIRE(result.ec == std::errc{});
+    REQUIRE(index < counts.size());
+    counts[index] += 1;
+  }
+  CHECK(std::ranges::all_of(counts, [](size_t count) { return count == 1; }));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -8,10 +8,12 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 // IWYU pragma: begin_exports
+#include "tit/core/_mat/batch.hpp"
 #include "tit/core/_mat/eig.hpp"
 #include "tit/core/_mat/fact.hpp"
 #include "tit/core/_mat/mat.hpp"
 #include "tit/core/_mat/part.hpp"
+#include "tit/core/_mat/sym.hpp"
 #include "tit/core/_mat/traits.hpp"
 // IWYU pragma: end_exports
 
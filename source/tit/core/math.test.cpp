@@ -3,6 +3,7 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <limits>
 
 #include "tit/core/math.hpp"
@@ -90,6 +91,28 @@ TEST_CASE_TEMPLATE("inverse", Num, NUM_TYPES) {
   CHECK(inverse(Num{8}) == 0.125);
 }
 
+TEST_CASE_TEMPLATE("rsqrt", Num, NUM_TYPES) {
+  CHECK(rsqrt(Num{4}) == Num{0.5});
+  CHECK(rsqrt(Num{0.0625}) == Num{4});
+}
+
+TEST_CASE_TEMPLATE("approx_rsqrt", Num, NUM_TYPES) {
+  // Relative error is bounded for each number of iterations, and the default
+  // number of iterations reaches the full precision.
+  const auto max_error = [](auto approx) {
+    Num error{0};
+    for (Num a = Num{1.0e-6}; a < Num{1.0e6}; a *= Num{1.37}) {
+      error = std::max(error, abs(approx(a) * sqrt(a) - Num{1}));
+    }
+    return error;
+  };
+  CHECK(max_error([](Num a) { return approx_rsqrt<0>(a); }) < 3.5e-2);
+  CHECK(max_error([](Num a) { return approx_rsqrt<1>(a); }) < 1.8e-3);
+  CHECK(max_error([](Num a) { return approx_rsqrt<2>(a); }) < 4.8e-6);
+  CHECK(max_error([](Num a) { return approx_rsqrt(a); }) <
+        8 * std::numeric_limits<Num>::epsilon());
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE_TEMPLATE("avg", Num, NUM_TYPES) {
@@ -0,0 +1,202 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/str_utils.hpp"
+#include "tit/core/sys/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Global metrics state.
+struct MetricsState final {
+  std::mutex mutex;
+  StrHashMap<std::pair<MetricKind, float64_t>> values;
+  std::condition_variable_any cv;
+  std::jthread writer;
+};
+
+auto state() -> MetricsState& {
+  static MetricsState instance;
+  return instance;
+}
+
+// Convert the metric name into the valid OpenMetrics name: the runs of the
+// characters that are not allowed are replaced with a single underscore.
+auto openmetrics_name(std::string_view name) -> std::string {
+  std::string result{"tit"};
+  bool is_separated = false;
+  for (const auto c : name) {
+    const bool is_allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                            (c >= '0' && c <= '9') || c == '_';
+    if (!is_allowed) {
+      is_separated = true;
+      continue;
+    }
+    if (is_separated || result.size() == 3) result.push_back('_');
+    is_separated = false;
+    result.push_back(c);
+  }
+  return result;
+}
+
+// Escape the string for JSON.
+auto json_escape(std::string_view str) -> std::string {
+  std::string result;
+  result.reserve(str.size());
+  for (const auto c : str) {
+    if (c == '"' || c == '\\') result.push_back('\\');
+    result.push_back(c);
+  }
+  return result;
+}
+
+// Write the metrics as JSON lines, until the stop is requested.
+void write_lines(const std::stop_token& stop_token,
+                 const std::filesystem::path& path,
+                 std::chrono::duration<float64_t> interval) {
+  const auto out = make_file_output_stream(path);
+  const auto write_line = [&out] {
+    const auto line = Metrics::render_json() + '\n';
+    out->write(std::as_bytes(std::span{line}));
+    out->flush();
+  };
+  auto& s = state();
+  std::unique_lock lock{s.mutex};
+  while (!s.cv.wait_for(lock, stop_token, interval, [] { return false; })) {
+    if (stop_token.stop_requested()) break;
+    lock.unlock();
+    write_line();
+    lock.lock();
+  }
+  lock.unlock();
+  write_line();
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+std::atomic_bool Metrics::is_enabled_{false};
+
+void Metrics::enable(const std::filesystem::path& path, float64_t interval) {
+  TIT_ASSERT(interval > 0.0, "Interval must be positive!");
+  is_enabled_ = true;
+  if (path.empty()) return;
+
+  // Write the lines in background, and write the last line at exit.
+  auto& s = state();
+  TIT_ASSERT(!s.writer.joinable(), "Metrics are already written!");
+  s.writer = std::jthread{[path, interval](std::stop_token stop_token) {
+    write_lines(stop_token, path, std::chrono::duration<float64_t>{interval});
+  }};
+  checked_atexit([] {
+    auto& writer = state().writer;
+    writer.request_stop();
+    writer.join();
+  });
+}
+
+void Metrics::set(std::string_view name, float64_t value) {
+  if (!is_enabled()) return;
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
+  /// @todo In C++26 there would be no need for `std::string{...}`.
+  s.values.insert_or_assign(std::string{name},
+                            std::pair{MetricKind::gauge, value});
+}
+
+void Metrics::add(std::string_view name, float64_t delta) {
+  if (!is_enabled()) return;
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
+  /// @todo In C++26 there would be no need for `std::string{...}`.
+  auto& [kind, value] =
+      s.values.try_emplace(std::string{name}, MetricKind::counter, 0.0)
+          .first->second;
+  TIT_ASSERT(kind == MetricKind::counter, "Metric is not a counter!");
+  value += delta;
+}
+
+auto Metrics::snapshot() -> std::vector<Metric> {
+  std::vector<Metric> result;
+  {
+    auto& s = state();
+    const std::scoped_lock lock{s.mutex};
+    result.reserve(s.values.size());
+    for (const auto& [name, kind_and_value] : s.values) {
+      const auto [kind, value] = kind_and_value;
+      result.push_back({.name = name, .kind = kind, .value = value});
+    }
+  }
+  std::ranges::sort(result, {}, &Metric::name);
+  return result;
+}
+
+auto Metrics::render_openmetrics() -> std::string {
+  std::string result;
+  for (const auto& metric : snapshot()) {
+    const auto name = openmetrics_name(metric.name);
+    if (metric.kind == MetricKind::counter) {
+      std::format_to(std::back_inserter(result),
+                     "# TYPE {} counter\n{}_total {}\n",
+                     name,
+                     name,
+                     metric.value);
+    } else {
+      std::format_to(std::back_inserter(result),
+                     "# TYPE {} gauge\n{} {}\n",
+                     name,
+                     name,
+                     metric.value);
+    }
+  }
+  result += "# EOF\n";
+  return result;
+}
+
+auto Metrics::render_json() -> std::string {
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  std::string result = std::format(
+      R"({{"timestamp":{:.3f})",
+      std::chrono::duration<float64_t>{now}.count());
+  for (const auto& metric : snapshot()) {
+    // JSON has no representation for the non-finite numbers.
+    std::format_to(std::back_inserter(result),
+                   R"(,"{}":{})",
+                   json_escape(metric.name),
+                   std::isfinite(metric.value) ? std::format("{}", metric.value)
+                                               : "null");
+  }
+  result += '}';
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
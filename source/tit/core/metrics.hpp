@@ -0,0 +1,92 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Metric kind.
+enum class MetricKind : uint8_t {
+  gauge,   ///< Latest value.
+  counter, ///< Accumulated value.
+};
+
+/// Metric value.
+struct Metric final {
+  /// Metric name.
+  std::string name;
+
+  /// Metric kind.
+  MetricKind kind;
+
+  /// Metric value.
+  float64_t value;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Live metrics interface.
+///
+/// Unlike the statistics and the profiler, that are reported at exit, the
+/// metrics can be read at any time while the program is running, so that
+/// the long runs can be monitored live. Metrics are either written
+/// periodically as JSON lines, or rendered in the OpenMetrics text format to
+/// be scraped by Prometheus. All the functions are thread-safe.
+class Metrics final {
+public:
+
+  /// Metrics is a static object.
+  Metrics() = delete;
+
+  /// Enable metrics.
+  ///
+  /// @param path     If not empty, metrics are written to the file as JSON
+  ///                 lines, once per @p interval and at exit.
+  /// @param interval Interval between the written lines (in seconds).
+  static void enable(const std::filesystem::path& path = {},
+                     float64_t interval = 10.0);
+
+  /// Check if metrics are enabled.
+  static auto is_enabled() noexcept -> bool {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// Set the gauge value. Does nothing if metrics are not enabled.
+  static void set(std::string_view name, float64_t value);
+
+  /// Increment the counter value. Does nothing if metrics are not enabled.
+  static void add(std::string_view name, float64_t delta = 1.0);
+
+  /// Current values of all the metrics, sorted by name.
+  static auto snapshot() -> std::vector<Metric>;
+
+  /// Render the metrics in the OpenMetrics text format. Names are prefixed
+  /// with `tit_`, and the characters that are not allowed are replaced with
+  /// underscores.
+  static auto render_openmetrics() -> std::string;
+
+  /// Render the metrics as a single line JSON object, along with the Unix
+  /// timestamp (in seconds).
+  static auto render_json() -> std::string;
+
+private:
+
+  static std::atomic_bool is_enabled_;
+
+}; // class Metrics
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,61 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+
+#include "tit/core/metrics.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Metrics") {
+  Metrics::enable();
+  Metrics::set("test::step()::seconds", 0.5);
+  Metrics::set("test::step()::seconds", 0.25);
+  Metrics::add("test::num_steps");
+  Metrics::add("test::num_steps", 2.0);
+
+  {
+    // Ensure the gauges are overwritten and the counters are accumulated.
+    const auto metrics = Metrics::snapshot();
+    REQUIRE(metrics.size() >= 2);
+    const auto find = [&metrics](const auto& name) {
+      return std::ranges::find(metrics, name, &Metric::name);
+    };
+    const auto seconds = find("test::step()::seconds");
+    REQUIRE(seconds != metrics.end());
+    CHECK(seconds->kind == MetricKind::gauge);
+    CHECK(seconds->value == 0.25);
+    const auto num_steps = find("test::num_steps");
+    REQUIRE(num_steps != metrics.end());
+    CHECK(num_steps->kind == MetricKind::counter);
+    CHECK(num_steps->value == 3.0);
+  }
+  {
+    // Ensure the names are converted to the valid OpenMetrics names.
+    const auto text = Metrics::render_openmetrics();
+    CHECK(text.contains("# TYPE tit_test_step_seconds gauge\n"
+                        "tit_test_step_seconds 0.25\n"));
+    CHECK(text.contains("# TYPE tit_test_num_steps counter\n"
+                        "tit_test_num_steps_total 3\n"));
+    CHECK(text.ends_with("# EOF\n"));
+  }
+  {
+    const auto line = Metrics::render_json();
+    CHECK(line.starts_with(R"({"timestamp":)"));
+    CHECK(line.contains(R"(,"test::step()::seconds":0.25)"));
+    CHECK(line.contains(R"(,"test::num_steps":3)"));
+    CHECK(line.ends_with("}"));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
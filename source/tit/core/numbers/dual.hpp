@@ -9,13 +9,19 @@
 #include <type_traits>
 #include <utility>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
 
 namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Dual number.
+///
+/// Derivative part is not required to be a number: for example, with the
+/// vector derivative part, multiple directional derivatives are computed at
+/// once, see `VecDual`.
 template<class Num, class Deriv = Num>
 class Dual final {
 public:
@@ -48,14 +54,27 @@ public:
   }
 
   /// Dual number addition.
+  /// @{
+  friend constexpr auto operator+(const Num& a, const Dual& f) -> Dual {
+    return Dual{a + f.val(), f.deriv()};
+  }
+  friend constexpr auto operator+(const Dual& f, const Num& a) -> Dual {
+    return Dual{f.val() + a, f.deriv()};
+  }
   friend constexpr auto operator+(const Dual& f, const Dual& g) -> Dual {
     return Dual{f.val() + g.val(), f.deriv() + g.deriv()};
   }
+  /// @}
 
   /// Dual number addition with assignment.
+  /// @{
+  friend constexpr auto operator+=(Dual& f, const Num& a) -> Dual& {
+    return f = f + a;
+  }
   friend constexpr auto operator+=(Dual& f, const Dual& g) -> Dual& {
     return f = f + g;
   }
+  /// @}
 
   /// Dual number negation.
   friend constexpr auto operator-(const Dual& f) -> Dual {
@@ -63,14 +82,27 @@ public:
   }
 
   /// Dual number subtraction.
+  /// @{
+  friend constexpr auto operator-(const Num& a, const Dual& f) -> Dual {
+    return Dual{a - f.val(), -f.deriv()};
+  }
+  friend constexpr auto operator-(const Dual& f, const Num& a) -> Dual {
+    return Dual{f.val() - a, f.deriv()};
+  }
   friend constexpr auto operator-(const Dual& f, const Dual& g) -> Dual {
     return Dual{f.val() - g.val(), f.deriv() - g.deriv()};
   }
+  /// @}
 
   /// Dual number subtraction with assignment.
+  /// @{
+  friend constexpr auto operator-=(Dual& f, const Num& a) -> Dual& {
+    return f = f - a;
+  }
   friend constexpr auto operator-=(Dual& f, const Dual& g) -> Dual& {
     return f = f - g;
   }
+  /// @}
 
   /// Dual number multiplication.
   /// @{
@@ -133,6 +165,12 @@ public:
   friend constexpr auto operator<=>(const Dual& f, const Dual& g) noexcept {
     return f.val_ <=> g.val_;
   }
+  friend constexpr auto operator==(const Dual& f, const Num& a) noexcept {
+    return f.val_ == a;
+  }
+  friend constexpr auto operator<=>(const Dual& f, const Num& a) noexcept {
+    return f.val_ <=> a;
+  }
   /// @}
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -149,6 +187,38 @@ constexpr auto tiny_v<Dual<Float, Deriv>> = Dual{tiny_v<Float>, Deriv{}};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Dual number with multiple derivative directions.
+///
+/// Derivative part is stored in the SIMD-backed vector, so that the
+/// derivatives along all the directions are computed in the single pass.
+/// For example, Jacobian-vector products of a function for several vectors
+/// are computed in a single evaluation of the function.
+template<class Num, size_t Dim>
+using VecDual = Dual<Num, Vec<Num, Dim>>;
+
+/// Seed the vector of dual numbers with the unit derivative directions:
+/// derivative part of the `i`-th element is the `i`-th unit vector. Passing
+/// the result to a function yields its value and its whole gradient.
+template<class Num, size_t Dim>
+constexpr auto seed_duals(const Vec<Num, Dim>& x)
+    -> Vec<VecDual<Num, Dim>, Dim> {
+  Vec<VecDual<Num, Dim>, Dim> r;
+  for (size_t i = 0; i < Dim; ++i) {
+    Vec<Num, Dim> direction{};
+    direction[i] = Num{1.0};
+    r[i] = VecDual<Num, Dim>{x[i], direction};
+  }
+  return r;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Absolute value of a dual number.
+template<class Num, class Deriv>
+constexpr auto abs(const Dual<Num, Deriv>& f) -> Dual<Num, Deriv> {
+  return f.val() < Num{0.0} ? -f : f;
+}
+
 /// Square root of a dual number.
 template<class Num, class Deriv>
 constexpr auto sqrt(const Dual<Num, Deriv>& f) -> Dual<Num, Deriv> {
@@ -6,6 +6,7 @@
 #include <numbers>
 
 #include "tit/core/numbers/dual.hpp"
+#include "tit/core/vec.hpp"
 
 #include "tit/testing/test.hpp"
 
@@ -23,16 +24,38 @@ TEST_CASE("Dual") {
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("Dual::operator+") {
-  SUBCASE("normal") {
-    const auto d = Dual{1.0, 2.0} + Dual{3.0, 4.0};
-    CHECK(d.val() == 4.0);
-    CHECK(d.deriv() == 6.0);
+  SUBCASE("shifting") {
+    SUBCASE("normal") {
+      SUBCASE("real + dual") {
+        const auto d = 3.0 + Dual{1.0, 2.0};
+        CHECK(d.val() == 4.0);
+        CHECK(d.deriv() == 2.0);
+      }
+      SUBCASE("dual + real") {
+        const auto d = Dual{1.0, 2.0} + 3.0;
+        CHECK(d.val() == 4.0);
+        CHECK(d.deriv() == 2.0);
+      }
+    }
+    SUBCASE("with assignment") {
+      Dual d{1.0, 2.0};
+      d += 3.0;
+      CHECK(d.val() == 4.0);
+      CHECK(d.deriv() == 2.0);
+    }
   }
-  SUBCASE("with assignment") {
-    Dual d{1.0, 2.0};
-    d += Dual{3.0, 4.0};
-    CHECK(d.val() == 4.0);
-    CHECK(d.deriv() == 6.0);
+  SUBCASE("addition") {
+    SUBCASE("normal") {
+      const auto d = Dual{1.0, 2.0} + Dual{3.0, 4.0};
+      CHECK(d.val() == 4.0);
+      CHECK(d.deriv() == 6.0);
+    }
+    SUBCASE("with assignment") {
+      Dual d{1.0, 2.0};
+      d += Dual{3.0, 4.0};
+      CHECK(d.val() == 4.0);
+      CHECK(d.deriv() == 6.0);
+    }
   }
 }
 
@@ -42,6 +65,26 @@ TEST_CASE("Dual::operator-") {
     CHECK(d.val() == -1.0);
     CHECK(d.deriv() == -2.0);
   }
+  SUBCASE("shifting") {
+    SUBCASE("normal") {
+      SUBCASE("real - dual") {
+        const auto d = 3.0 - Dual{1.0, 2.0};
+        CHECK(d.val() == 2.0);
+        CHECK(d.deriv() == -2.0);
+      }
+      SUBCASE("dual - real") {
+        const auto d = Dual{1.0, 2.0} - 3.0;
+        CHECK(d.val() == -2.0);
+        CHECK(d.deriv() == 2.0);
+      }
+    }
+    SUBCASE("with assignment") {
+      Dual d{1.0, 2.0};
+      d -= 3.0;
+      CHECK(d.val() == -2.0);
+      CHECK(d.deriv() == 2.0);
+    }
+  }
   SUBCASE("subtraction") {
     SUBCASE("normal") {
       const Dual d = Dual{1.0, 2.0} - Dual{3.0, 4.0};
@@ -141,10 +184,29 @@ TEST_CASE("Dual::operator<=>") {
     CHECK(Dual{3.0, 2.0} <= Dual{3.0, 1.0});
     CHECK(Dual{3.0, 0.0} >= Dual{3.0, 1.0});
   }
+  SUBCASE("with real") {
+    CHECK(Dual{3.0, 1.0} == 3.0);
+    CHECK(Dual{3.0, 1.0} != 4.0);
+    CHECK(Dual{3.0, 1.0} < 4.0);
+    CHECK(2.0 < Dual{3.0, 1.0});
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("Dual::abs") {
+  SUBCASE("positive") {
+    const auto d = abs(Dual{2.0, 1.0});
+    CHECK(d.val() == 2.0);
+    CHECK(d.deriv() == 1.0);
+  }
+  SUBCASE("negative") {
+    const auto d = abs(Dual{-2.0, 1.0});
+    CHECK(d.val() == 2.0);
+    CHECK(d.deriv() == -1.0);
+  }
+}
+
 TEST_CASE("Dual::sqrt") {
   const auto d = sqrt(Dual{4.0, 1.0});
   CHECK(d.val() == 2.0);
@@ -183,5 +245,35 @@ TEST_CASE("Dual::log") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("VecDual") {
+  SUBCASE("arithmetic") {
+    // Derivatives along all the directions are computed at once.
+    const VecDual<double, 2> f{2.0, Vec{1.0, 0.0}};
+    const VecDual<double, 2> g{3.0, Vec{0.0, 1.0}};
+    const auto d = f * g + 1.0 / f;
+    CHECK(d.val() == 6.5);
+    CHECK(all(d.deriv() == Vec{2.75, 2.0}));
+  }
+  SUBCASE("functions") {
+    const VecDual<double, 3> f{4.0, Vec{1.0, 2.0, 4.0}};
+    const auto d = sqrt(f);
+    CHECK(d.val() == 2.0);
+    CHECK(all(d.deriv() == Vec{0.25, 0.5, 1.0}));
+  }
+}
+
+TEST_CASE("seed_duals") {
+  // Gradient of the vector norm is the normalized vector.
+  const Vec x{3.0, 4.0};
+  const auto x_dual = seed_duals(x);
+  CHECK(all(x_dual[0].deriv() == Vec{1.0, 0.0}));
+  CHECK(all(x_dual[1].deriv() == Vec{0.0, 1.0}));
+  const auto d = norm(x_dual);
+  CHECK(d.val() == 5.0);
+  CHECK(approx_equal_to(d.deriv(), normalize(x)));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -6,21 +6,32 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <concepts>
 #include <functional>
 #include <iterator>
+#include <optional>
 #include <ranges>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <oneapi/tbb/blocked_range.h>
 #include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
+#include <oneapi/tbb/parallel_scan.h>
 #include <oneapi/tbb/parallel_sort.h>
 #include <oneapi/tbb/partitioner.h>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/par/atomic.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/par/task_group.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/uint_utils.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit::par {
@@ -34,6 +45,39 @@ concept range =
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Persistent affinity of the parallel loop iterations to the threads.
+///
+/// Affinity is owned by the call site and is passed to each run of the same
+/// loop, e.g. a pass over the particles that is repeated each time step.
+/// Iterations are then replayed on the threads that ran them before, so that
+/// the data they touch stays in the caches of the same cores. Affinity is
+/// only a hint: it is not thread-safe, so concurrently run loops must not
+/// share it, and a copy of it starts anew.
+class Affinity final {
+public:
+
+  /// Construct an empty affinity.
+  Affinity() = default;
+
+  /// Copy the affinity. Copy starts anew, since it is meant for another
+  /// loop.
+  /// @{
+  Affinity(const Affinity& /*other*/) noexcept {}
+  auto operator=(const Affinity& /*other*/) noexcept -> Affinity& {
+    return *this;
+  }
+  /// @}
+
+  /// Destroy the affinity.
+  ~Affinity() = default;
+
+private:
+
+  friend struct ForEach;
+  tbb::affinity_partitioner partitioner_;
+
+}; // class Affinity
+
 /// Iterate through the range in parallel (dynamic partitioning).
 struct ForEach {
   template<range Range,
@@ -41,8 +85,37 @@ struct ForEach {
   void operator()(Range&& range, Func func) const {
     /// @todo Replace with `tbb::parallel_for_each` when it supports ranges.
     TIT_ASSUME_UNIVERSAL(Range, range);
-    tbb::parallel_for(tbb::blocked_range{std::begin(range), std::end(range)},
-                      std::bind_back(std::ranges::for_each, std::move(func)));
+    tbb::parallel_for(
+        tbb::blocked_range{std::begin(range), std::end(range), grain_size()},
+        std::bind_back(std::ranges::for_each, std::move(func)));
+  }
+
+  /// Iterate through the range in parallel, with the range never split into
+  /// the chunks smaller than the grain size.
+  template<range Range,
+           std::regular_invocable<std::ranges::range_reference_t<Range&&>> Func>
+  void operator()(Range&& range, Func func, size_t grain_size) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSERT(grain_size > 0, "Grain size must be positive!");
+    tbb::parallel_for(
+        tbb::blocked_range{std::begin(range), std::end(range), grain_size},
+        std::bind_back(std::ranges::for_each, std::move(func)));
+  }
+
+  /// Iterate through the range in parallel, with the iterations distributed
+  /// across the threads same as in the previous runs with the affinity.
+  template<range Range,
+           std::regular_invocable<std::ranges::range_reference_t<Range&&>> Func>
+  void operator()(Range&& range,
+                  Func func,
+                  Affinity& affinity,
+                  size_t grain_size = 1) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSERT(grain_size > 0, "Grain size must be positive!");
+    tbb::parallel_for(
+        tbb::blocked_range{std::begin(range), std::end(range), grain_size},
+        std::bind_back(std::ranges::for_each, std::move(func)),
+        affinity.partitioner_);
   }
 };
 
@@ -89,11 +162,56 @@ struct BlockForEach {
                std::ranges::range_value_t<Range>>> Func>
   void operator()(Range&& range, Func func) const {
     TIT_ASSUME_UNIVERSAL(Range, range);
-    for (auto chunk : std::views::chunk(range, num_threads())) {
-      for_each(std::move(chunk),
-               std::bind_back(std::ranges::for_each, std::cref(func)));
+    for (auto chunk : std::views::chunk(range, num_parts())) {
+      TIT_PROFILE_SECTION("par::block_for_each(chunk)");
+      for_each(std::move(chunk), block_func_(func));
     }
   }
+
+  /// Iterate through the block of ranges in parallel, running the task
+  /// concurrently with the first chunk of blocks. The remaining chunks are
+  /// processed after the task is completed.
+  template<range Range,
+           std::invocable<std::ranges::range_reference_t<
+               std::ranges::range_value_t<Range>>> Func,
+           task Task>
+  void operator()(Range&& range, Func func, Task overlap_task) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TaskGroup overlap{};
+    overlap.run(std::move(overlap_task));
+    bool overlapped = true;
+    for (auto chunk : std::views::chunk(range, num_parts())) {
+      TIT_PROFILE_SECTION("par::block_for_each(chunk)");
+      for_each(std::move(chunk), block_func_(func));
+      if (overlapped) overlap.wait(), overlapped = false;
+    }
+    if (overlapped) overlap.wait();
+  }
+
+private:
+
+  // Make a function that processes a single block. Blocks are profiled to
+  // expose the load imbalance between the chunks, block sizes are reported
+  // as the processed items, so that the counters are normalized per item.
+  // Block timings are also collected into the statistics, if enabled.
+  template<class Func>
+  static auto block_func_(const Func& func) {
+    return [&func](auto&& block) {
+      TIT_PROFILE_SECTION("par::block_for_each(block)");
+      if constexpr (std::ranges::sized_range<decltype(block)>) {
+        Profiler::add_items(std::ranges::size(block));
+      }
+      if (!Stats::enabled()) {
+        std::ranges::for_each(block, std::cref(func));
+        return;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      std::ranges::for_each(block, std::cref(func));
+      const std::chrono::duration<float64_t> elapsed =
+          std::chrono::steady_clock::now() - start;
+      TIT_STATS_HIST("par::block_for_each::block_time", elapsed.count());
+    };
+  }
 };
 
 /// @copydoc BlockForEach
@@ -103,7 +221,7 @@ inline constexpr BlockForEach block_for_each{};
 
 /// Parallel copy-if.
 /// Relative order of the elements in the output range is not preserved.
-struct CopyIf {
+struct CopyIfUnordered final {
   template<range Range,
            std::random_access_iterator OutIter,
            class Proj = std::identity,
@@ -123,8 +241,8 @@ struct CopyIf {
   }
 };
 
-/// @copydoc CopyIf
-inline constexpr CopyIf copy_if{};
+/// @copydoc CopyIfUnordered
+inline constexpr CopyIfUnordered copy_if_unordered{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -158,6 +276,298 @@ inline constexpr Transform transform{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Parallel transform-reduce.
+///
+/// Range is split into the same blocks regardless of the number of threads,
+/// so the result is reproducible even for the operations that are not
+/// exactly associative, such as the floating-point addition.
+struct TransformReduce final {
+  /// Number of elements in the block that is reduced sequentially.
+  static constexpr size_t grain_size = 1024;
+
+  template<range Range,
+           class Val,
+           class ReduceOp,
+           std::regular_invocable<std::ranges::range_reference_t<Range&&>> Func>
+    requires std::convertible_to<
+                 std::invoke_result_t<ReduceOp&,
+                                      Val,
+                                      std::invoke_result_t<
+                                          Func&,
+                                          std::ranges::range_reference_t<
+                                              Range&&>>>,
+                 Val>
+  static auto operator()(Range&& range,
+                         Val init,
+                         ReduceOp reduce_op,
+                         Func func) -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    using Acc = std::optional<Val>;
+    const auto first = std::begin(range);
+    const auto result = tbb::parallel_deterministic_reduce(
+        tbb::blocked_range<size_t>{0, std::size(range), grain_size},
+        Acc{},
+        [&first, &reduce_op, &func](const tbb::blocked_range<size_t>& block,
+                                    Acc acc) -> Acc {
+          for (auto i = block.begin(); i != block.end(); ++i) {
+            auto&& val = std::invoke(func, first[i]);
+            if (acc.has_value()) acc = std::invoke(reduce_op, *acc, val);
+            else acc.emplace(val);
+          }
+          return acc;
+        },
+        [&reduce_op](const Acc& left, const Acc& right) -> Acc {
+          if (!left.has_value()) return right;
+          if (!right.has_value()) return left;
+          return std::invoke(reduce_op, *left, *right);
+        },
+        tbb::simple_partitioner{});
+    if (!result.has_value()) return init;
+    return std::invoke(reduce_op, std::move(init), *result);
+  }
+};
+
+/// @copydoc TransformReduce
+inline constexpr TransformReduce transform_reduce{};
+
+/// Parallel reduce, see `par::transform_reduce`.
+struct Reduce final {
+  template<range Range, class Val, class ReduceOp = std::plus<>>
+  static auto operator()(Range&& range, Val init, ReduceOp reduce_op = {})
+      -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return transform_reduce(range,
+                            std::move(init),
+                            std::move(reduce_op),
+                            std::identity{});
+  }
+};
+
+/// @copydoc Reduce
+inline constexpr Reduce reduce{};
+
+/// Parallel minimum of the projected values of the non-empty range.
+struct Min final {
+  template<range Range, class Proj = std::identity>
+  static auto operator()(Range&& range, Proj proj = {}) {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSERT(!std::ranges::empty(range), "Range must not be empty!");
+    return transform_reduce(
+        range | std::views::drop(1),
+        std::invoke(proj, *std::begin(range)),
+        [](const auto& a, const auto& b) { return std::min(a, b); },
+        std::move(proj));
+  }
+};
+
+/// @copydoc Min
+inline constexpr Min min{};
+
+/// Parallel maximum of the projected values of the non-empty range.
+struct Max final {
+  template<range Range, class Proj = std::identity>
+  static auto operator()(Range&& range, Proj proj = {}) {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSERT(!std::ranges::empty(range), "Range must not be empty!");
+    return transform_reduce(
+        range | std::views::drop(1),
+        std::invoke(proj, *std::begin(range)),
+        [](const auto& a, const auto& b) { return std::max(a, b); },
+        std::move(proj));
+  }
+};
+
+/// @copydoc Max
+inline constexpr Max max{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel inclusive scan. Output may be the beginning of the input range.
+struct InclusiveScan final {
+  /// Number of elements in the block that is scanned sequentially.
+  static constexpr size_t grain_size = 1024;
+
+  template<range Range,
+           std::random_access_iterator OutIter,
+           class ScanOp = std::plus<>>
+  static auto operator()(Range&& range, OutIter out, ScanOp scan_op = {})
+      -> OutIter {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    using Acc = std::optional<std::ranges::range_value_t<Range>>;
+    const auto first = std::begin(range);
+    tbb::parallel_scan(
+        tbb::blocked_range<size_t>{0, std::size(range), grain_size},
+        Acc{},
+        [&first, &out, &scan_op](const tbb::blocked_range<size_t>& block,
+                                 Acc acc,
+                                 bool is_final) -> Acc {
+          for (auto i = block.begin(); i != block.end(); ++i) {
+            if (acc.has_value()) acc = std::invoke(scan_op, *acc, first[i]);
+            else acc.emplace(first[i]);
+            if (is_final) out[i] = *acc;
+          }
+          return acc;
+        },
+        [&scan_op](const Acc& left, const Acc& right) -> Acc {
+          if (!left.has_value()) return right;
+          if (!right.has_value()) return left;
+          return std::invoke(scan_op, *left, *right);
+        });
+    return std::next(out, std::size(range));
+  }
+};
+
+/// @copydoc InclusiveScan
+inline constexpr InclusiveScan inclusive_scan{};
+
+/// Parallel exclusive scan. Output may be the beginning of the input range.
+struct ExclusiveScan final {
+  /// Number of elements in the block that is scanned sequentially.
+  static constexpr size_t grain_size = 1024;
+
+  template<range Range,
+           std::random_access_iterator OutIter,
+           class Val,
+           class ScanOp = std::plus<>>
+  static auto operator()(Range&& range,
+                         OutIter out,
+                         Val init,
+                         ScanOp scan_op = {}) -> OutIter {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    using Acc = std::optional<Val>;
+    const auto first = std::begin(range);
+    tbb::parallel_scan(
+        tbb::blocked_range<size_t>{0, std::size(range), grain_size},
+        Acc{},
+        [&first, &out, &init, &scan_op](const tbb::blocked_range<size_t>& block,
+                                        Acc acc,
+                                        bool is_final) -> Acc {
+          // The initial value is accounted for by the first block only, so
+          // the prefix of any other block in the final pass includes it.
+          if (block.begin() == 0) acc.emplace(init);
+          for (auto i = block.begin(); i != block.end(); ++i) {
+            auto val = first[i]; // Output may alias the input.
+            if (is_final) out[i] = *acc;
+            if (acc.has_value()) acc = std::invoke(scan_op, *acc, val);
+            else acc.emplace(val);
+          }
+          return acc;
+        },
+        [&scan_op](const Acc& left, const Acc& right) -> Acc {
+          if (!left.has_value()) return right;
+          if (!right.has_value()) return left;
+          return std::invoke(scan_op, *left, *right);
+        });
+    return std::next(out, std::size(range));
+  }
+};
+
+/// @copydoc ExclusiveScan
+inline constexpr ExclusiveScan exclusive_scan{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel copy-if.
+/// Relative order of the elements in the output range is preserved.
+struct CopyIf final {
+  /// Number of elements in the block that is processed sequentially.
+  static constexpr size_t grain_size = 1024;
+
+  template<range Range,
+           std::random_access_iterator OutIter,
+           class Proj = std::identity,
+           std::indirect_unary_predicate<
+               std::projected<std::ranges::iterator_t<Range>, Proj>> Pred>
+    requires std::indirectly_copyable<std::ranges::iterator_t<Range>, OutIter>
+  static auto operator()(Range&& range, OutIter out, Pred pred, Proj proj = {})
+      -> OutIter {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    const auto first = std::begin(range);
+    const auto size = std::size(range);
+    const auto num_blocks = divide_up(size, grain_size);
+    const auto block_indices = [size](size_t block) {
+      return std::views::iota(block * grain_size,
+                              std::min((block + 1) * grain_size, size));
+    };
+
+    // Evaluate the predicate and count the accepted elements in each block.
+    std::vector<uint8_t> accepted(size);
+    std::vector<size_t> offsets(num_blocks);
+    for_each(std::views::iota(size_t{0}, num_blocks),
+             [&first, &pred, &proj, &block_indices, &accepted, &offsets](
+                 size_t block) {
+               size_t count = 0;
+               for (const auto i : block_indices(block)) {
+                 accepted[i] = std::invoke(pred, std::invoke(proj, first[i]));
+                 count += accepted[i];
+               }
+               offsets[block] = count;
+             });
+
+    // Compute the output offsets of the blocks and copy the elements.
+    const auto num_accepted = reduce(offsets, size_t{0});
+    exclusive_scan(offsets, offsets.begin(), size_t{0});
+    for_each(std::views::iota(size_t{0}, num_blocks),
+             [&first, &out, &block_indices, &accepted, &offsets](size_t block) {
+               auto block_out = std::next(out, offsets[block]);
+               for (const auto i : block_indices(block)) {
+                 if (accepted[i] != 0) *block_out++ = first[i];
+               }
+             });
+    return std::next(out, num_accepted);
+  }
+};
+
+/// @copydoc CopyIf
+inline constexpr CopyIf copy_if{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel stable partition.
+/// Returns the subrange of the elements that do not satisfy the predicate.
+struct StablePartition final {
+  template<range Range,
+           class Proj = std::identity,
+           std::indirect_unary_predicate<
+               std::projected<std::ranges::iterator_t<Range>, Proj>> Pred>
+    requires std::permutable<std::ranges::iterator_t<Range>> &&
+             std::default_initializable<std::ranges::range_value_t<Range>>
+  static auto operator()(Range&& range, Pred pred, Proj proj = {})
+      -> std::ranges::borrowed_subrange_t<Range> {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    const auto first = std::begin(range);
+    const auto size = std::size(range);
+    if (size == 0) return {first, first};
+
+    // Count the satisfying elements up to and including each element.
+    std::vector<size_t> ranks(size);
+    transform(range, ranks.begin(), [&pred, &proj](const auto& item) {
+      return std::invoke(pred, std::invoke(proj, item)) ? 1UZ : 0UZ;
+    });
+    inclusive_scan(ranks, ranks.begin());
+    const auto num_true = ranks.back();
+
+    // Move the elements into their places and back.
+    std::vector<std::ranges::range_value_t<Range>> buffer(size);
+    for_each(std::views::iota(size_t{0}, size),
+             [&first, &ranks, &buffer, num_true](size_t i) {
+               const auto prev_rank = i == 0 ? 0 : ranks[i - 1];
+               const auto place = ranks[i] != prev_rank ?
+                                      prev_rank :
+                                      num_true + (i - ranks[i]);
+               buffer[place] = std::ranges::iter_move(first + i);
+             });
+    for_each(std::views::iota(size_t{0}, size),
+             [&first, &buffer](size_t i) { first[i] = std::move(buffer[i]); });
+    return {first + num_true, first + size};
+  }
+};
+
+/// @copydoc StablePartition
+inline constexpr StablePartition stable_partition{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Parallel sort.
 struct Sort final {
   template<range Range, class Compare = std::less<>, class Proj = std::identity>
@@ -180,4 +590,220 @@ inline constexpr Sort sort{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Parallel selection. Reorders the range, so that the element at the given
+/// position is the one that would be there if the range was sorted, and none
+/// of the elements before it is greater than any of the elements after it.
+///
+/// Large ranges are narrowed down by the parallel three-way partitions around
+/// the pair of pivots, picked from the sorted sample of the range around the
+/// rank of the selected element (Floyd-Rivest style), so that each pass leaves
+/// only a small fraction of the range. The remainder is selected sequentially.
+struct NthElement final {
+  /// Number of elements in the range that is processed sequentially.
+  static constexpr size_t grain_size = 16384;
+
+  template<range Range,
+           class Compare = std::ranges::less,
+           class Proj = std::identity>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Proj> &&
+             std::default_initializable<std::ranges::range_value_t<Range>>
+  static void operator()(Range&& range,
+                         std::ranges::iterator_t<Range> nth,
+                         Compare compare = {},
+                         Proj proj = {}) {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    auto first = std::begin(range);
+    auto last = std::end(range);
+    if (nth == last) return;
+
+    // Narrow the range down to the elements between the pivots.
+    constexpr size_t sample_size = 1024;
+    constexpr size_t sample_margin = 32;
+    std::vector<size_t> sample(sample_size);
+    while (static_cast<size_t>(last - first) > grain_size) {
+      TIT_PROFILE_SECTION("par::nth_element(pass)");
+      const auto size = static_cast<size_t>(last - first);
+      const auto rank = static_cast<size_t>(nth - first);
+
+      // Pick the pivots around the rank of the element in the sorted sample.
+      for (size_t i = 0; i < sample_size; ++i) {
+        sample[i] = i * size / sample_size;
+      }
+      std::ranges::sort(sample, compare, [&first, &proj](size_t offset) {
+        return std::invoke(proj, first[offset]);
+      });
+      const auto pos = rank * sample_size / size;
+      const auto low = std::invoke(
+          proj,
+          first[sample[pos - std::min(pos, sample_margin)]]);
+      const auto high = std::invoke(
+          proj,
+          first[sample[std::min(pos + sample_margin, sample_size - 1)]]);
+
+      // Partition the range into the elements that are less than the lower
+      // pivot, the ones between the pivots, and the ones greater than the
+      // upper pivot.
+      const auto mid_first = std::begin(stable_partition(
+          std::ranges::subrange{first, last},
+          [&compare, &low](const auto& key) {
+            return std::invoke(compare, key, low);
+          },
+          proj));
+      const auto mid_last = std::begin(stable_partition(
+          std::ranges::subrange{mid_first, last},
+          [&compare, &high](const auto& key) {
+            return !std::invoke(compare, high, key);
+          },
+          proj));
+
+      // Continue with the part that contains the element. If all of the
+      // elements are between the pivots (e.g., most of them are equal),
+      // there is no progress, and the rest is left to the sequential pass.
+      if (nth < mid_first) {
+        last = mid_first;
+      } else if (nth >= mid_last) {
+        first = mid_last;
+      } else if (static_cast<size_t>(mid_last - mid_first) < size) {
+        first = mid_first, last = mid_last;
+      } else {
+        break;
+      }
+    }
+
+    // Select the element in the remaining range.
+    std::ranges::nth_element(first, nth, last, compare, proj);
+  }
+};
+
+/// @copydoc NthElement
+inline constexpr NthElement nth_element{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel stable LSD radix sort of the unsigned integer keys. Values are
+/// reordered together with the keys.
+///
+/// The keys are sorted by the 8-bit digits, each pass counts the digits of
+/// the blocks of keys in parallel, and then scatters the blocks in parallel
+/// into the ping-pong buffer. Passes over the digits that are equal for
+/// all of the keys, e.g. the leading zero bytes, are skipped.
+struct RadixSort final {
+  template<range Keys, range Vals>
+    requires std::unsigned_integral<std::ranges::range_value_t<Keys>> &&
+             std::permutable<std::ranges::iterator_t<Keys>> &&
+             std::permutable<std::ranges::iterator_t<Vals>>
+  static void operator()(Keys&& keys, Vals&& vals) {
+    TIT_PROFILE_SECTION("par::radix_sort()");
+    TIT_ASSUME_UNIVERSAL(Keys, keys);
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    using Key = std::ranges::range_value_t<Keys>;
+    using Val = std::ranges::range_value_t<Vals>;
+    const auto size = std::size(keys);
+    TIT_ASSERT(size == static_cast<size_t>(std::size(vals)),
+               "Keys and values must have the same size!");
+    if (size <= 1) return;
+
+    // Split the keys into the blocks, large enough to amortize the counts.
+    constexpr size_t digit_bits = 8;
+    constexpr size_t num_buckets = size_t{1} << digit_bits;
+    constexpr size_t min_block_size = 16384; // Empirical value.
+    const auto num_blocks =
+        std::clamp<size_t>(size / min_block_size, 1, num_threads());
+    const auto block_first = [size, num_blocks](size_t block) {
+      return block * size / num_blocks;
+    };
+    const auto for_each_block = [num_blocks](const auto& func) {
+      tbb::parallel_for<size_t>(/*first=*/0,
+                                /*last=*/num_blocks,
+                                /*step=*/1,
+                                func,
+                                tbb::static_partitioner{});
+    };
+
+    // Sort the keys by a single digit. Returns false if the pass is skipped.
+    std::vector<size_t> offsets(num_blocks * num_buckets);
+    const auto pass = [&](auto src_keys,
+                          auto src_vals,
+                          auto dst_keys,
+                          auto dst_vals,
+                          size_t shift) -> bool {
+      const auto digit = [shift](Key key) {
+        return static_cast<size_t>(key >> shift) & (num_buckets - 1);
+      };
+
+      // Count the digits in each block.
+      std::ranges::fill(offsets, 0);
+      for_each_block([&](size_t block) {
+        const auto counts = offsets.begin() + block * num_buckets;
+        for (auto i = block_first(block); i < block_first(block + 1); ++i) {
+          ++counts[digit(src_keys[i])];
+        }
+      });
+
+      // Compute the scatter offsets: buckets are ordered by the digit, and the
+      // blocks inside of each bucket are ordered by index to keep stability.
+      size_t offset = 0;
+      for (size_t bucket = 0; bucket < num_buckets; ++bucket) {
+        const auto bucket_first = offset;
+        for (size_t block = 0; block < num_blocks; ++block) {
+          auto& count = offsets[block * num_buckets + bucket];
+          offset += std::exchange(count, offset);
+        }
+        if (offset - bucket_first == size) return false;
+      }
+
+      // Scatter the keys and the values.
+      for_each_block([&](size_t block) {
+        const auto block_offsets = offsets.begin() + block * num_buckets;
+        for (auto i = block_first(block); i < block_first(block + 1); ++i) {
+          const auto j = block_offsets[digit(src_keys[i])]++;
+          dst_keys[j] = src_keys[i];
+          dst_vals[j] = std::move(src_vals[i]);
+        }
+      });
+      return true;
+    };
+
+    // Sort the keys digit by digit, alternating between the input ranges and
+    // the buffers.
+    std::vector<Key> key_buffer(size);
+    std::vector<Val> val_buffer(size);
+    const auto keys_first = std::begin(keys);
+    const auto vals_first = std::begin(vals);
+    bool in_buffers = false;
+    for (size_t shift = 0; shift < sizeof(Key) * 8; shift += digit_bits) {
+      const auto done =
+          in_buffers ?
+              pass(key_buffer.begin(),
+                   val_buffer.begin(),
+                   keys_first,
+                   vals_first,
+                   shift) :
+              pass(keys_first,
+                   vals_first,
+                   key_buffer.begin(),
+                   val_buffer.begin(),
+                   shift);
+      if (done) in_buffers = !in_buffers;
+    }
+    if (in_buffers) {
+      for_each_block([&](size_t block) {
+        const auto first = block_first(block);
+        const auto last = block_first(block + 1);
+        std::copy(key_buffer.begin() + first,
+                  key_buffer.begin() + last,
+                  keys_first + first);
+        std::move(val_buffer.begin() + first,
+                  val_buffer.begin() + last,
+                  vals_first + first);
+      });
+    }
+  }
+};
+
+/// @copydoc RadixSort
+inline constexpr RadixSort radix_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::par
@@ -4,7 +4,10 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <numeric>
 #include <random>
 #include <ranges>
 #include <thread>
@@ -36,6 +39,19 @@ TEST_CASE("par::for_each") {
     });
     CHECK(data == std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
   }
+  SUBCASE("grain size") {
+    // Ensure the loop is executed with the chunks of the grain size.
+    par::for_each(data, [](int& i) { i += 1; }, /*grain_size=*/4);
+    CHECK(data == std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  }
+  SUBCASE("affinity") {
+    // Ensure the loop is executed each time the affinity is reused.
+    par::Affinity affinity{};
+    for (int pass = 0; pass < 3; ++pass) {
+      par::for_each(data, [](int& i) { i += 1; }, affinity);
+    }
+    CHECK(data == std::vector{3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  }
   SUBCASE("exceptions") {
     // Ensure the exceptions from the worker threads are caught.
     const auto loop = [&data] {
@@ -95,6 +111,23 @@ TEST_CASE("par::block_for_each") {
     });
     CHECK(data == VectorOfVectors{{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}});
   }
+  SUBCASE("overlap") {
+    // Ensure the task is completed before the blocks after the first chunk
+    // are processed.
+    std::atomic_bool task_done = false;
+    std::atomic_bool waited = true;
+    par::block_for_each(
+        data,
+        [&task_done, &waited](int i) {
+          if (i >= 8 && !task_done) waited = false;
+        },
+        [&task_done] {
+          std::this_thread::sleep_for(std::chrono::milliseconds{50});
+          task_done = true;
+        });
+    CHECK(task_done);
+    CHECK(waited);
+  }
   SUBCASE("exceptions") {
     // Ensure the exceptions from the worker threads are caught.
     const auto loop = [&data] {
@@ -110,13 +143,13 @@ TEST_CASE("par::block_for_each") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-TEST_CASE("par::copy_if") {
+TEST_CASE("par::copy_if_unordered") {
   par::set_num_threads(4);
   std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
   std::vector<int> out(data.size());
   SUBCASE("basic") {
     // Ensure the loop is executed.
-    const auto iter = par::copy_if(data, out.begin(), [](int i) {
+    const auto iter = par::copy_if_unordered(data, out.begin(), [](int i) {
       std::this_thread::sleep_for(std::chrono::milliseconds{10});
       return i % 2 == 0;
     });
@@ -125,6 +158,46 @@ TEST_CASE("par::copy_if") {
     std::ranges::sort(out_range);
     CHECK_RANGE_EQ(out_range, std::vector{0, 2, 4, 6, 8});
   }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto algorithm = [&data, &out] {
+      par::copy_if_unordered(data, out.begin(), [](int i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        if (i == 7) throw std::runtime_error{"Algorithm failed!"};
+        return i % 2 == 0;
+      });
+      FAIL("Algorithm should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(algorithm(), "Algorithm failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::copy_if") {
+  par::set_num_threads(4);
+  std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::vector<int> out(data.size());
+  SUBCASE("basic") {
+    // Ensure the loop is executed.
+    const auto iter = par::copy_if(data, out.begin(), [](int i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      return i % 2 == 0;
+    });
+    CHECK(iter == out.begin() + 5);
+    CHECK_RANGE_EQ(std::ranges::subrange(out.begin(), iter),
+                   std::vector{0, 2, 4, 6, 8});
+  }
+  SUBCASE("large") {
+    // Ensure the order is preserved across the blocks.
+    const auto large_data =
+        std::views::iota(0, 10000) | std::ranges::to<std::vector>();
+    std::vector<int> large_out(large_data.size());
+    const auto is_even = [](int i) { return i % 2 == 0; };
+    const auto iter = par::copy_if(large_data, large_out.begin(), is_even);
+    CHECK_RANGE_EQ(std::ranges::subrange(large_out.begin(), iter),
+                   large_data | std::views::filter(is_even));
+  }
   SUBCASE("exceptions") {
     // Ensure the exceptions from the worker threads are caught.
     const auto algorithm = [&data, &out] {
@@ -170,6 +243,90 @@ TEST_CASE("par::transform") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("par::reduce") {
+  par::set_num_threads(4);
+  const auto data = std::views::iota(0, 10000) | std::ranges::to<std::vector>();
+  SUBCASE("basic") {
+    CHECK(par::reduce(data, 10) == 49995010);
+    CHECK(par::reduce(std::views::take(data, 0), 10) == 10);
+  }
+  SUBCASE("transform") {
+    const auto sum_of_squares = par::transform_reduce(data,
+                                                      int64_t{0},
+                                                      std::plus{},
+                                                      [](int i) {
+                                                        return int64_t{i} * i;
+                                                      });
+    CHECK(sum_of_squares == 333283335000);
+  }
+  SUBCASE("min and max") {
+    CHECK(par::min(data) == 0);
+    CHECK(par::max(data) == 9999);
+    CHECK(par::min(data, [](int i) { return (i - 5000) * (i - 5000); }) == 0);
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto algorithm = [&data] {
+      par::transform_reduce(data, 0, std::plus{}, [](int i) {
+        if (i == 7777) throw std::runtime_error{"Algorithm failed!"};
+        return i;
+      });
+      FAIL("Algorithm should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(algorithm(), "Algorithm failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::inclusive_scan") {
+  par::set_num_threads(4);
+  auto data = std::views::iota(0, 10000) | std::ranges::to<std::vector>();
+  std::vector<int> expected(data.size());
+  std::inclusive_scan(data.begin(), data.end(), expected.begin());
+  SUBCASE("basic") {
+    std::vector<int> out(data.size());
+    CHECK(par::inclusive_scan(data, out.begin()) == out.end());
+    CHECK(out == expected);
+  }
+  SUBCASE("in place") {
+    par::inclusive_scan(data, data.begin());
+    CHECK(data == expected);
+  }
+}
+
+TEST_CASE("par::exclusive_scan") {
+  par::set_num_threads(4);
+  auto data = std::views::iota(0, 10000) | std::ranges::to<std::vector>();
+  std::vector<int> expected(data.size());
+  std::exclusive_scan(data.begin(), data.end(), expected.begin(), 10);
+  SUBCASE("basic") {
+    std::vector<int> out(data.size());
+    CHECK(par::exclusive_scan(data, out.begin(), 10) == out.end());
+    CHECK(out == expected);
+  }
+  SUBCASE("in place") {
+    par::exclusive_scan(data, data.begin(), 10);
+    CHECK(data == expected);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::stable_partition") {
+  par::set_num_threads(4);
+  auto data = std::views::iota(0, 10000) | std::ranges::to<std::vector>();
+  auto expected = data;
+  const auto is_one_mod_three = [](int i) { return i % 3 == 1; };
+  std::ranges::stable_partition(expected, is_one_mod_three);
+  const auto rest = par::stable_partition(data, is_one_mod_three);
+  CHECK(rest.begin() == data.begin() + 3333);
+  CHECK(rest.end() == data.end());
+  CHECK(data == expected);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("par::sort") {
   par::set_num_threads(4);
   constexpr auto sorted = std::views::iota(0, 1000);
@@ -195,5 +352,88 @@ TEST_CASE("par::sort") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("par::nth_element") {
+  par::set_num_threads(4);
+  const auto check_selected = [](const auto& data, auto nth) {
+    CHECK(std::ranges::all_of(data.begin(), nth, [nth](auto x) {
+      return x <= *nth;
+    }));
+    CHECK(std::ranges::all_of(nth, data.end(), [nth](auto x) {
+      return x >= *nth;
+    }));
+  };
+  SUBCASE("basic") {
+    // Ensure the parallel passes are used.
+    auto data = std::views::iota(0, 100000) | std::ranges::to<std::vector>();
+    std::ranges::shuffle(data, std::mt19937{123});
+    for (const auto rank : {0, 12345, 50000, 99999}) {
+      const auto nth = data.begin() + rank;
+      par::nth_element(data, nth);
+      CHECK(*nth == rank);
+      check_selected(data, nth);
+    }
+  }
+  SUBCASE("projection") {
+    // Ensure the comparator and the projection are respected.
+    auto data = std::views::iota(0, 100000) | std::ranges::to<std::vector>();
+    std::ranges::shuffle(data, std::mt19937{123});
+    const auto nth = data.begin() + 25000;
+    par::nth_element(data, nth, std::greater{}, [](int x) { return x / 2; });
+    CHECK(*nth / 2 == 37499);
+    CHECK(std::ranges::all_of(data.begin(), nth, [](int x) {
+      return x / 2 >= 37499;
+    }));
+    CHECK(std::ranges::all_of(nth, data.end(), [](int x) {
+      return x / 2 <= 37499;
+    }));
+  }
+  SUBCASE("equal keys") {
+    // Ensure the selection terminates if the pivots do not narrow the range.
+    std::vector<int> data(100000, 1);
+    data[123] = 0;
+    data[456] = 2;
+    const auto nth = data.begin() + 50000;
+    par::nth_element(data, nth);
+    CHECK(*nth == 1);
+    check_selected(data, nth);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::radix_sort") {
+  par::set_num_threads(4);
+  SUBCASE("basic") {
+    // Ensure multiple blocks and multiple passes are used.
+    std::mt19937_64 random_engine{123};
+    std::vector<uint64_t> keys(100000);
+    for (auto& key : keys) key = random_engine() % 1000000;
+    auto vals = std::views::iota(0UZ, keys.size()) |
+                std::ranges::to<std::vector>();
+    auto expected_vals = vals;
+    std::ranges::stable_sort(expected_vals, {}, [&keys](size_t i) {
+      return keys[i];
+    });
+    auto expected_keys = keys;
+    std::ranges::sort(expected_keys);
+    par::radix_sort(keys, vals);
+    CHECK_RANGE_EQ(keys, expected_keys);
+    CHECK_RANGE_EQ(vals, expected_vals);
+  }
+  SUBCASE("equal keys") {
+    // Ensure the skipped passes do not break the stability.
+    std::vector<uint32_t> keys(1000, 0xABCD'0000);
+    keys[500] = 0xABCD'0001;
+    auto vals = std::views::iota(0UZ, keys.size()) |
+                std::ranges::to<std::vector>();
+    par::radix_sort(keys, vals);
+    CHECK(keys.back() == 0xABCD'0001);
+    CHECK(vals.back() == 500);
+    CHECK(std::ranges::is_sorted(vals | std::views::take(999)));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
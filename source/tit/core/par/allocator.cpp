@@ -0,0 +1,71 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cstddef>
+#include <ranges>
+
+#include <sys/mman.h>
+
+#include <oneapi/tbb/scalable_allocator.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/allocator.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/uint_utils.hpp"
+
+namespace tit::par::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Size of the regular memory page. Touching a single byte of each regular
+// page is enough to place the huge page that contains it.
+constexpr size_t page_size = 4096;
+
+// Alignment of the regular blocks, chosen to avoid false sharing.
+constexpr size_t block_alignment = 64;
+
+} // namespace
+
+auto allocate_bytes(size_t size, size_t alignment) -> void* {
+  Profiler::count_alloc(size);
+  alignment = std::max(alignment, block_alignment);
+  if (size < huge_page_size) {
+    auto* const ptr = scalable_aligned_malloc(size, alignment);
+    if (ptr == nullptr) TIT_THROW("Failed to allocate {} bytes.", size);
+    return ptr;
+  }
+
+  // Allocate the block aligned to the huge pages.
+  const auto aligned_size = align_up(size, huge_page_size);
+  alignment = std::max(alignment, huge_page_size);
+  auto* const ptr = scalable_aligned_malloc(aligned_size, alignment);
+  if (ptr == nullptr) TIT_THROW("Failed to allocate {} bytes.", aligned_size);
+#ifdef MADV_HUGEPAGE
+  // Huge pages are only a hint, the failure is not an error.
+  madvise(ptr, aligned_size, MADV_HUGEPAGE);
+#endif
+
+  // Touch the pages in parallel, so that they are placed on the NUMA nodes of
+  // the threads that would process the corresponding blocks of values.
+  auto* const bytes = static_cast<byte_t*>(ptr);
+  static_for_each(std::views::iota(size_t{0}, aligned_size / page_size),
+                  [bytes](size_t /*thread*/, size_t page) {
+                    bytes[page * page_size] = byte_t{0};
+                  });
+  return ptr;
+}
+
+void deallocate_bytes(void* ptr) noexcept {
+  scalable_aligned_free(ptr);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par::impl
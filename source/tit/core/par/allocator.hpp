@@ -0,0 +1,81 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include "tit/core/basic_types.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Size of the huge memory page.
+inline constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+namespace impl {
+
+// Allocate the memory block, see `Allocator`.
+auto allocate_bytes(size_t size, size_t alignment) -> void*;
+
+// Deallocate the memory block that was allocated with `allocate_bytes`.
+void deallocate_bytes(void* ptr) noexcept;
+
+} // namespace impl
+
+/// Allocator for the large arrays that are processed in parallel.
+///
+/// Memory is allocated with the TBB scalable allocator. Blocks of at least
+/// `huge_page_size` bytes are aligned to the huge pages and are advised to be
+/// backed with the transparent huge pages. Pages of such blocks are touched
+/// in parallel right after the allocation, with the same thread-to-block
+/// mapping as `par::static_for_each` uses, so that on the NUMA systems the
+/// pages are placed on the nodes of the threads that process them.
+template<class Val>
+  requires std::is_object_v<Val>
+class Allocator final {
+public:
+
+  /// Allocated value type.
+  using value_type = Val;
+
+  /// Construct an allocator.
+  /// @{
+  constexpr Allocator() noexcept = default;
+  template<class Other>
+  constexpr explicit(false) Allocator(
+      const Allocator<Other>& /*other*/) noexcept {}
+  /// @}
+
+  /// Allocate the memory for @p count values.
+  [[nodiscard]] auto allocate(size_t count) const -> Val* {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(Val)) {
+      throw std::bad_array_new_length{};
+    }
+    return static_cast<Val*>(
+        impl::allocate_bytes(count * sizeof(Val), alignof(Val)));
+  }
+
+  /// Deallocate the memory.
+  void deallocate(Val* ptr, size_t /*count*/) const noexcept {
+    impl::deallocate_bytes(ptr);
+  }
+
+  /// All allocators are interchangeable.
+  template<class Other>
+  friend constexpr auto operator==(const Allocator& /*lhs*/,
+                                   const Allocator<Other>& /*rhs*/) noexcept
+      -> bool {
+    return true;
+  }
+
+}; // class Allocator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
@@ -0,0 +1,37 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/allocator.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::Allocator") {
+  SUBCASE("small") {
+    std::vector<int, par::Allocator<int>> vec(100, 1);
+    CHECK(std::ranges::all_of(vec, [](int val) { return val == 1; }));
+  }
+  SUBCASE("large") {
+    // Large blocks must be aligned to the huge pages.
+    constexpr size_t count = 2 * par::huge_page_size / sizeof(double);
+    std::vector<double, par::Allocator<double>> vec(count, 1.0);
+    CHECK(std::bit_cast<size_t>(vec.data()) % par::huge_page_size == 0);
+    CHECK(std::ranges::all_of(vec, [](double val) { return val == 1.0; }));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -21,6 +21,21 @@ auto fetch_and_add(Val& val, difference_t<Val> delta) noexcept -> Val {
   return __atomic_fetch_add(&val, delta, __ATOMIC_RELAXED); // NOLINT(*-vararg)
 }
 
+/// Atomically replace the value with the minimum of it and the given one, and
+/// return what was stored before.
+template<std::integral Val>
+auto fetch_and_min(Val& val, Val other) noexcept -> Val {
+  auto current = __atomic_load_n(&val, __ATOMIC_RELAXED);
+  while (other < current &&
+         !__atomic_compare_exchange_n(&val,
+                                      &current,
+                                      other,
+                                      /*weak=*/true,
+                                      __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {}
+  return current;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit::par
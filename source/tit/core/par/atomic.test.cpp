@@ -22,6 +22,16 @@ TEST_CASE("par::fetch_and_add") {
   CHECK(val == init + delta);
 }
 
+TEST_CASE("par::fetch_and_min") {
+  auto val = 10;
+  // Ensure that the larger value does not replace the stored one.
+  CHECK(par::fetch_and_min(val, 20) == 10);
+  CHECK(val == 10);
+  // Ensure that the smaller value replaces the stored one.
+  CHECK(par::fetch_and_min(val, 5) == 10);
+  CHECK(val == 5);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
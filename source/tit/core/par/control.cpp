@@ -3,10 +3,20 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <mutex>
 #include <optional>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <oneapi/tbb/global_control.h>
+#include <oneapi/tbb/task_arena.h>
+#include <oneapi/tbb/task_scheduler_observer.h>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
@@ -28,6 +38,139 @@ void set_num_threads(size_t value) {
   control.emplace(tbb::global_control::max_allowed_parallelism, value);
 }
 
+auto thread_index() noexcept -> size_t {
+  const auto index = tbb::this_task_arena::current_thread_index();
+  return index < 0 ? 0 : static_cast<size_t>(index);
+}
+
+auto num_thread_slots() noexcept -> size_t {
+  return static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+}
+
+namespace {
+
+// Number of parts in the reproducible mode, zero if it is disabled.
+auto reproducible_num_parts() noexcept -> size_t& {
+  static size_t value = 0;
+  return value;
+}
+
+} // namespace
+
+auto num_parts() noexcept -> size_t {
+  if (reproducible()) return reproducible_num_parts();
+  return num_threads();
+}
+
+auto reproducible() noexcept -> bool {
+  return reproducible_num_parts() != 0;
+}
+
+void set_reproducible(size_t num_parts) {
+  reproducible_num_parts() = num_parts;
+}
+
+namespace {
+
+// Default grain size of the dynamically partitioned loops.
+auto default_grain_size() noexcept -> size_t& {
+  static size_t value = 1;
+  return value;
+}
+
+} // namespace
+
+auto grain_size() noexcept -> size_t {
+  return default_grain_size();
+}
+
+void set_grain_size(size_t value) {
+  TIT_ASSERT(value > 0, "Grain size must be positive!");
+  default_grain_size() = value;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// CPUs that are available to the process, queried before any thread is
+// pinned.
+auto available_cpus() -> const std::vector<size_t>& {
+  static const auto cpus = [] {
+    std::vector<size_t> result{};
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) result.push_back(cpu);
+      }
+    }
+#endif
+    return result;
+  }();
+  return cpus;
+}
+
+// Observer that pins the threads entering the task arena.
+class PinningObserver final : public tbb::task_scheduler_observer {
+public:
+
+  // Start observing the threads.
+  PinningObserver() {
+    observe(true);
+  }
+
+  // Pin the thread to the CPU that corresponds to its arena slot.
+  void on_scheduler_entry(bool /*is_worker*/) override {
+#ifdef __linux__
+    const auto& cpus = available_cpus();
+    const auto slot = tbb::this_task_arena::current_thread_index();
+    if (cpus.empty() || slot < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[static_cast<size_t>(slot) % cpus.size()], &set);
+    // Pinning is only an optimization, the failure is not an error.
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+  }
+
+}; // class PinningObserver
+
+} // namespace
+
+auto num_cpus() noexcept -> size_t {
+  const auto& cpus = available_cpus();
+  if (!cpus.empty()) return cpus.size();
+  return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+void pin_threads() {
+  static PinningObserver observer{};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto io_arena() -> tbb::task_arena& {
+  static tbb::task_arena arena{tbb::task_arena::automatic,
+                               /*reserved_for_masters=*/1,
+                               tbb::task_arena::priority::low};
+  return arena;
+}
+
+auto num_io_threads() -> size_t {
+  return static_cast<size_t>(io_arena().max_concurrency());
+}
+
+void set_num_io_threads(size_t value) {
+  TIT_ASSERT(value > 0, "Invalid number of the I/O threads!");
+  auto& arena = io_arena();
+  if (arena.is_active()) arena.terminate();
+  arena.initialize(static_cast<int>(value),
+                   /*reserved_for_masters=*/1,
+                   tbb::task_arena::priority::low);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto global_mutex() noexcept -> std::mutex& {
@@ -5,7 +5,11 @@
 
 #pragma once
 
+#include <concepts>
 #include <mutex>
+#include <utility>
+
+#include <oneapi/tbb/task_arena.h>
 
 #include "tit/core/basic_types.hpp"
 
@@ -19,6 +23,86 @@ auto num_threads() noexcept -> size_t;
 /// Set number of the worker threads.
 void set_num_threads(size_t value);
 
+/// Get index of the current thread in the current task arena, in the range
+/// `[0, num_thread_slots())`. Unlike the system thread identifiers, indices
+/// are dense, so they can address the per-thread data, e.g. the partial
+/// results of the reductions. Threads outside of any arena get index zero.
+auto thread_index() noexcept -> size_t;
+
+/// Get number of the thread slots of the current task arena.
+auto num_thread_slots() noexcept -> size_t;
+
+/// Get number of the parts the parallel work is partitioned into, e.g. the
+/// number of the particle mesh blocks per level. It is equal to the number of
+/// the worker threads, unless the reproducible mode is enabled.
+auto num_parts() noexcept -> size_t;
+
+/// Is the reproducible mode enabled?
+auto reproducible() noexcept -> bool;
+
+/// Enable the reproducible mode.
+///
+/// In the reproducible mode, the work is partitioned into @p num_parts parts
+/// regardless of the number of the worker threads. Since each part is
+/// processed sequentially in a fixed order, the floating-point results are
+/// bitwise reproducible across the runs and the thread counts, at the cost
+/// of the load balance when @p num_parts is not a multiple of the number of
+/// threads. Pass zero to disable the reproducible mode.
+void set_reproducible(size_t num_parts);
+
+/// Get the default grain size of the dynamically partitioned loops, i.e. the
+/// minimal number of the iterations that are processed by a single task.
+auto grain_size() noexcept -> size_t;
+
+/// Set the default grain size of the dynamically partitioned loops. Larger
+/// grain reduces the scheduling overhead of the cheap loop bodies, at the
+/// cost of the load balance.
+void set_grain_size(size_t value);
+
+/// Get number of the CPUs that are available to the process. On Linux, it
+/// is the size of the process affinity mask, which honors the cgroup and
+/// cpuset limits.
+auto num_cpus() noexcept -> size_t;
+
+/// Pin the worker threads to the CPUs that are available to the process.
+///
+/// Each thread is pinned to a single CPU, chosen by the index of its slot in
+/// the task arena. Since `par::static_for_each` maps the blocks to the slots
+/// in a fixed order, each block is then processed on the same CPU across the
+/// calls, and its data stays in that CPU's cache. Pinning is not supported
+/// on all the platforms, and it cannot be undone.
+void pin_threads();
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Get the I/O task arena.
+///
+/// Background work, e.g. compression and writing of the output, or decoding
+/// of the input, runs in a separate low-priority task arena, so that it does
+/// not compete with the compute tasks. Workers only join the I/O arena while
+/// the compute arena has no work for them, and leave it as soon as the
+/// compute work appears. One slot is reserved for the calling thread, so the
+/// background work always makes progress on its own thread, even if all the
+/// workers are busy computing.
+auto io_arena() -> tbb::task_arena&;
+
+/// Get number of the threads of the I/O task arena, including the calling
+/// thread.
+auto num_io_threads() -> size_t;
+
+/// Set number of the threads of the I/O task arena, including the calling
+/// thread. Must be called at startup, while no work runs in the arena. To
+/// reserve the cores for the background work, set the number of the worker
+/// threads below the number of the available CPUs.
+void set_num_io_threads(size_t value);
+
+/// Run the function in the I/O task arena. Parallel algorithms called by the
+/// function run in the I/O arena as well.
+template<std::invocable Func>
+auto io_execute(Func&& func) -> decltype(auto) {
+  return io_arena().execute(std::forward<Func>(func));
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Get the global mutex.
@@ -3,6 +3,13 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <atomic>
+#include <ranges>
+#include <utility>
+
+#include <oneapi/tbb/task_arena.h>
+
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/par/control.hpp"
 
 #include "tit/testing/test.hpp"
@@ -21,6 +28,58 @@ TEST_CASE("par::num_threads") {
   CHECK(par::num_threads() == 3);
 }
 
+TEST_CASE("par::thread_index") {
+  par::set_num_threads(3);
+  const auto num_slots = par::num_thread_slots();
+  REQUIRE(num_slots > 0);
+  std::atomic<size_t> num_invalid = 0;
+  par::for_each(std::views::iota(0, 1000), [&](int /*i*/) {
+    if (par::thread_index() >= num_slots) ++num_invalid;
+  });
+  CHECK(num_invalid == 0);
+}
+
+TEST_CASE("par::reproducible") {
+  par::set_num_threads(3);
+  REQUIRE_FALSE(par::reproducible());
+  CHECK(par::num_parts() == 3);
+  par::set_reproducible(16);
+  CHECK(par::reproducible());
+  CHECK(par::num_parts() == 16);
+  par::set_reproducible(0);
+  CHECK_FALSE(par::reproducible());
+  CHECK(par::num_parts() == 3);
+}
+
+TEST_CASE("par::grain_size") {
+  REQUIRE(par::grain_size() == 1);
+  par::set_grain_size(64);
+  CHECK(par::grain_size() == 64);
+  par::set_grain_size(1);
+  CHECK(par::grain_size() == 1);
+}
+
+TEST_CASE("par::pin_threads") {
+  REQUIRE(par::num_cpus() > 0);
+  par::pin_threads();
+  par::pin_threads(); // Repeated pinning is a no-op.
+  CHECK(par::num_cpus() > 0);
+}
+
+TEST_CASE("par::io_execute") {
+  par::set_num_threads(3);
+  par::set_num_io_threads(2);
+  CHECK(par::num_io_threads() == 2);
+  const auto result = par::io_execute([] {
+    // Algorithms are confined to the I/O arena.
+    std::atomic<size_t> count = 0;
+    par::for_each(std::views::iota(0, 100), [&count](int /*i*/) { ++count; });
+    return std::pair{count.load(), tbb::this_task_arena::max_concurrency()};
+  });
+  CHECK(result.first == 100);
+  CHECK(result.second == 2);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
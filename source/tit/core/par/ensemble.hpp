@@ -0,0 +1,54 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <functional>
+
+#include <oneapi/tbb/task_arena.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/task_group.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Run the independent ensemble members concurrently in the current arena.
+///
+/// Each member is a task that typically runs a complete small simulation,
+/// with its own particle array, particle mesh and integrator. The parallel
+/// algorithms invoked by the members share the worker threads, so that the
+/// cores stay busy even if a single member can not saturate them.
+///
+/// Each member runs in an isolated region: a thread that waits for the
+/// parallel algorithm of one member never picks up the work of the other
+/// members. Hence the thread-local scratch buffers used by the solver are
+/// never shared between the members.
+///
+/// Members must not share the mutable state, including the data storages:
+/// each member shall open its own `data::DataStorage` connection, possibly
+/// to the same file, and write its own series, created with the member
+/// parameters string.
+///
+/// @param num_members Number of the ensemble members.
+/// @param func        Member function, invoked with the member index.
+template<std::invocable<size_t> Func>
+void run_ensemble(size_t num_members, const Func& func) {
+  TaskGroup group{};
+  for (size_t member = 0; member < num_members; ++member) {
+    group.run([&func, member] {
+      tbb::this_task_arena::isolate([&func, member] {
+        std::invoke(func, member);
+      });
+    });
+  }
+  group.wait();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
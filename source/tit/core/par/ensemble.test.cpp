@@ -0,0 +1,82 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/ensemble.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::run_ensemble") {
+  par::set_num_threads(4);
+  SUBCASE("basic") {
+    // Ensure each member is executed exactly once.
+    std::vector<size_t> num_runs(8, 0);
+    par::run_ensemble(num_runs.size(), [&num_runs](size_t member) {
+      num_runs[member] += 1;
+    });
+    CHECK(std::ranges::all_of(num_runs, [](size_t n) { return n == 1; }));
+  }
+  SUBCASE("scratch") {
+    // Ensure the members that run the parallel algorithms with the scratch
+    // buffers concurrently do not interfere with each other.
+    constexpr size_t num_members = 8;
+    std::array<bool, num_members> valid{};
+    par::run_ensemble(num_members, [&valid](size_t member) {
+      const auto count = member + 2;
+      const auto pairs =
+          std::views::iota(size_t{0}, 1000 * count) |
+          std::views::transform([count](size_t i) {
+            return std::pair{i % count, i};
+          }) |
+          std::ranges::to<std::vector>();
+      bool member_valid = true;
+      Multivector<size_t> multivector{};
+      for (size_t iter = 0; iter < 10; ++iter) {
+        multivector.assign_pairs_par_wide(count, pairs);
+        member_valid &= multivector.size() == count;
+        for (size_t index = 0; index < multivector.size(); ++index) {
+          member_valid &= multivector[index].size() == 1000;
+          member_valid &= std::ranges::all_of(
+              multivector[index],
+              [count, index](size_t i) { return i % count == index; });
+        }
+      }
+      valid[member] = member_valid;
+    });
+    CHECK(std::ranges::all_of(valid, std::identity{}));
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the members are propagated.
+    CHECK_THROWS_WITH_AS(
+        par::run_ensemble(4,
+                          [](size_t member) {
+                            if (member == 2) {
+                              throw std::runtime_error{"Member failed!"};
+                            }
+                          }),
+        "Member failed!",
+        std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
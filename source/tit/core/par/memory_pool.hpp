@@ -6,8 +6,12 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
+#include <limits>
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <vector>
 
 #ifndef TBB_PREVIEW_MEMORY_POOL
 #define TBB_PREVIEW_MEMORY_POOL 1
@@ -15,6 +19,7 @@
 
 #include <oneapi/tbb/memory_pool.h>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/exception.hpp"
 
@@ -49,4 +54,101 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Thread-safe and scalable arena for the temporary buffers.
+///
+/// Arena is meant to be reset once per step, releasing all the temporaries
+/// at once, while keeping the memory for the next step. Use it through
+/// `ArenaAllocator` with the standard containers.
+class Arena final {
+public:
+
+  /// Allocate @p size bytes.
+  [[nodiscard]] auto allocate(size_t size) -> void* {
+    TIT_ASSERT(pool_ != nullptr, "Arena was moved away!");
+    auto* const ptr = pool_->malloc(size);
+    if (ptr == nullptr) {
+      TIT_THROW("Arena failed to allocate {} bytes.", size);
+    }
+    return ptr;
+  }
+
+  /// Deallocate the memory block, so that it can be reused before the reset.
+  void deallocate(void* ptr) noexcept {
+    TIT_ASSERT(pool_ != nullptr, "Arena was moved away!");
+    pool_->free(ptr);
+  }
+
+  /// Release all the memory blocks that were allocated from the arena.
+  /// No containers that use the arena must be alive at this point.
+  void reset() {
+    TIT_ASSERT(pool_ != nullptr, "Arena was moved away!");
+    pool_->recycle();
+  }
+
+private:
+
+  std::unique_ptr<tbb::memory_pool<std::allocator<std::byte>>> pool_ =
+      std::make_unique<typename decltype(pool_)::element_type>();
+
+}; // class Arena
+
+/// Allocator that allocates the memory from an arena.
+template<class Val>
+  requires std::is_object_v<Val>
+class ArenaAllocator final {
+public:
+
+  static_assert(alignof(Val) <= alignof(std::max_align_t),
+                "Over-aligned values cannot be allocated from an arena!");
+
+  /// Allocated value type.
+  using value_type = Val;
+
+  /// Construct an allocator for the arena.
+  constexpr explicit ArenaAllocator(Arena& arena) noexcept : arena_{&arena} {}
+
+  /// Construct an allocator for the arena of the other allocator.
+  template<class Other>
+  constexpr explicit(false)
+      ArenaAllocator(const ArenaAllocator<Other>& other) noexcept
+      : arena_{&other.arena()} {}
+
+  /// Arena the memory is allocated from.
+  constexpr auto arena() const noexcept -> Arena& {
+    return *arena_;
+  }
+
+  /// Allocate the memory for @p count values.
+  [[nodiscard]] auto allocate(size_t count) const -> Val* {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(Val)) {
+      throw std::bad_array_new_length{};
+    }
+    return static_cast<Val*>(arena_->allocate(count * sizeof(Val)));
+  }
+
+  /// Deallocate the memory.
+  void deallocate(Val* ptr, size_t /*count*/) const noexcept {
+    arena_->deallocate(ptr);
+  }
+
+  /// Allocators are interchangeable if they share the arena.
+  template<class Other>
+  friend constexpr auto operator==(const ArenaAllocator& lhs,
+                                   const ArenaAllocator<Other>& rhs) noexcept
+      -> bool {
+    return &lhs.arena() == &rhs.arena();
+  }
+
+private:
+
+  Arena* arena_;
+
+}; // class ArenaAllocator
+
+/// Vector that allocates the memory from an arena.
+template<class Val>
+using ArenaVector = std::vector<Val, ArenaAllocator<Val>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::par
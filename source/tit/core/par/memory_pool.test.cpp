@@ -3,6 +3,9 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <ranges>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/par/memory_pool.hpp"
 
 #include "tit/testing/test.hpp"
@@ -27,6 +30,28 @@ TEST_CASE("par::MemoryPool") {
   CHECK(root->data_2 == 20);
 }
 
+TEST_CASE("par::Arena") {
+  par::Arena arena{};
+  for (size_t step = 0; step < 3; ++step) {
+    {
+      par::ArenaVector<par::ArenaVector<int>> buckets(
+          4,
+          par::ArenaVector<int>(par::ArenaAllocator<int>{arena}),
+          par::ArenaAllocator<par::ArenaVector<int>>{arena});
+      for (auto& bucket : buckets) {
+        for (const int i : std::views::iota(0, 100)) bucket.push_back(i);
+      }
+      for (const auto& bucket : buckets) {
+        REQUIRE(bucket.size() == 100);
+        CHECK(bucket.front() == 0);
+        CHECK(bucket.back() == 99);
+        CHECK(&bucket.get_allocator().arena() == &arena);
+      }
+    }
+    arena.reset();
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
@@ -4,88 +4,567 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/io.hpp"
+#include "tit/core/log.hpp"
 #include "tit/core/profiler.hpp"
 #include "tit/core/str_utils.hpp"
+#include "tit/core/sys/energy.hpp"
+#include "tit/core/sys/perf.hpp"
 #include "tit/core/sys/utils.hpp"
-#include "tit/core/time.hpp"
 
 namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-StrHashMap<Stopwatch> Profiler::sections_{};
+namespace {
 
-auto Profiler::section(std::string_view section_name) -> Stopwatch& {
+using Clock = std::chrono::steady_clock;
+
+// Completed section record.
+struct TraceRecord final {
+  ProfilerSectionID section_id;
+  uint32_t depth;
+  size_t start_ns;
+  size_t duration_ns;
+};
+
+// Call tree node of a single thread.
+struct ThreadNode final {
+  ProfilerSectionID section_id;
+  size_t num_calls = 0;
+  size_t total_ns = 0;
+  PerfCounts counts;
+  uint64_t energy_uj = 0;
+  size_t rss_growth = 0;
+  size_t num_allocs = 0;
+  size_t alloc_bytes = 0;
+  size_t num_items = 0;
+  std::vector<size_t> children;
+};
+
+// Entered section of a single thread.
+struct ThreadFrame final {
+  size_t node_index;
+  size_t start_ns;
+  std::optional<PerfCounts> start_counts;
+  std::optional<uint64_t> start_energy_uj;
+  std::optional<size_t> start_rss;
+};
+
+// Profiling data of a single thread.
+struct ThreadData final {
+  size_t thread_index;
+  std::vector<ThreadNode> nodes{ThreadNode{.section_id = 0}};
+  std::vector<ThreadFrame> stack{ThreadFrame{.node_index = 0, .start_ns = 0}};
+  std::vector<TraceRecord> trace;
+  size_t trace_next = 0;
+  std::optional<PerfCounters> counters;
+  bool measures_energy = false;
+  bool measures_memory = false;
+};
+
+// Global profiler state.
+struct ProfilerState final {
+  std::mutex mutex;
+  StrHashMap<ProfilerSectionID> section_ids;
+  std::vector<std::string> section_names;
+  std::vector<std::unique_ptr<ThreadData>> threads;
+  Clock::time_point epoch = Clock::now();
+  std::filesystem::path trace_path;
+  std::atomic_bool counters_enabled{false};
+  std::optional<EnergyCounters> energy;
+  bool memory_enabled = false;
+  StrHashMap<ProfilerMemory> memory;
+};
+
+auto state() -> ProfilerState& {
+  static ProfilerState instance;
+  return instance;
+}
+
+// Profiling data of the current thread, if it was already created.
+thread_local ThreadData* current_thread_data = nullptr;
+
+// Profiling data of the current thread. Data is owned by the global state,
+// so that it outlives the thread and can be reported at exit.
+auto thread_data() -> ThreadData& {
+  thread_local ThreadData* const data = [] {
+    auto& s = state();
+    const std::scoped_lock lock{s.mutex};
+    auto& result = s.threads.emplace_back(std::make_unique<ThreadData>());
+    result->thread_index = s.threads.size() - 1;
+    current_thread_data = result.get();
+    result->trace.reserve(Profiler::trace_capacity);
+    return result.get();
+  }();
+  return *data;
+}
+
+// Are the allocations counted?
+std::atomic_bool allocs_enabled{false};
+
+
+auto now_ns() -> size_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              state().epoch)
+      .count();
+}
+
+// Merge the thread call tree node into the aggregated node.
+void merge_node(ProfilerNode& result,
+                const ThreadData& data,
+                const ThreadNode& node,
+                std::span<const std::string> section_names) {
+  for (const auto child_index : node.children) {
+    const auto& child = data.nodes[child_index];
+    const auto& child_name = section_names[child.section_id];
+    auto iter = std::ranges::find(result.children,
+                                  child_name,
+                                  &ProfilerNode::name);
+    if (iter == result.children.end()) {
+      result.children.push_back({.name = child_name});
+      iter = std::prev(result.children.end());
+    }
+    iter->num_calls += child.num_calls;
+    iter->total_ns += child.total_ns;
+    iter->counts += child.counts;
+    iter->energy_uj += child.energy_uj;
+    iter->rss_growth += child.rss_growth;
+    iter->num_allocs += child.num_allocs;
+    iter->alloc_bytes += child.alloc_bytes;
+    iter->num_items += child.num_items;
+    merge_node(*iter, data, child, section_names);
+  }
+}
+
+// Children of the call tree node, sorted by the total time.
+auto sorted_children(const ProfilerNode& node)
+    -> std::vector<const ProfilerNode*> {
+  auto result =
+      node.children |
+      std::views::transform([](const ProfilerNode& child) { return &child; }) |
+      std::ranges::to<std::vector>();
+  std::ranges::sort(result, std::greater{}, &ProfilerNode::total_ns);
+  return result;
+}
+
+// Escape the string for JSON.
+auto json_escape(std::string_view str) -> std::string {
+  std::string result;
+  result.reserve(str.size());
+  for (const auto c : str) {
+    if (c == '"' || c == '\\') result.push_back('\\');
+    result.push_back(c);
+  }
+  return result;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+std::atomic_bool Profiler::is_enabled_{false};
+
+auto Profiler::section(std::string_view section_name) -> ProfilerSectionID {
   TIT_ASSERT(!section_name.empty(), "Section name must not be empty!");
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
   /// @todo In C++26 there would be no need for `std::string{...}`.
-  return sections_[std::string{section_name}];
+  const auto [iter, inserted] = s.section_ids.try_emplace(
+      std::string{section_name},
+      static_cast<ProfilerSectionID>(s.section_names.size()));
+  if (inserted) s.section_names.emplace_back(section_name);
+  return iter->second;
 }
 
-void Profiler::enable() noexcept {
+void Profiler::enable(const std::filesystem::path& trace_path,
+                      bool counters,
+                      bool energy,
+                      bool memory) {
+  // Check if the counters are available.
+  if (counters && !PerfCounters{}.is_open()) {
+    TIT_WARN("Hardware performance counters are not available, check the "
+             "'/proc/sys/kernel/perf_event_paranoid' setting.");
+    counters = false;
+  }
+
+  // Check if the energy counters are available.
+  if (energy) {
+    state().energy.emplace();
+    if (!state().energy->is_open()) {
+      TIT_WARN("Energy counters are not available, check the permissions of "
+               "'/sys/class/powercap/intel-rapl:*/energy_uj'.");
+      state().energy.reset();
+    }
+  }
+
   // Start profiling.
-  constexpr const auto* root_section_name = "main";
-  section(root_section_name).start();
+  static const auto root_section_id = section("main");
+  state().epoch = Clock::now();
+  state().trace_path = trace_path;
+  state().counters_enabled = counters;
+  state().memory_enabled = memory;
+  thread_data().measures_energy = state().energy.has_value();
+  thread_data().measures_memory = memory;
+  allocs_enabled = memory;
+  is_enabled_ = true;
+  enter(root_section_id);
 
   // Stop profiling and report at exit.
   checked_atexit([] {
-    section(root_section_name).stop();
+    leave();
+    allocs_enabled = false;
+    is_enabled_ = false;
     report_();
+    if (const auto& path = state().trace_path; !path.empty()) {
+      write_trace(path);
+    }
   });
 }
 
-void Profiler::report_() {
-  // Gather the sections and sort them by total time.
-  auto sorted_sections =
-      sections_ |
-      std::views::transform([](auto& section) { return &section; }) |
-      std::ranges::to<std::vector>();
-  std::ranges::sort(sorted_sections, std::greater{}, [](const auto* s) {
-    return s->second.total_ns();
+void Profiler::enter(ProfilerSectionID section_id) {
+  auto& data = thread_data();
+
+  // Counters are opened lazily, since the thread may have been profiled
+  // before the counters were enabled.
+  if (!data.counters.has_value() &&
+      state().counters_enabled.load(std::memory_order_relaxed)) {
+    data.counters.emplace();
+  }
+
+  const auto parent_index = data.stack.back().node_index;
+  const auto& siblings = data.nodes[parent_index].children;
+  auto iter = std::ranges::find(siblings, section_id, [&data](size_t index) {
+    return data.nodes[index].section_id;
   });
+  size_t node_index = 0;
+  if (iter != siblings.end()) {
+    node_index = *iter;
+  } else {
+    node_index = data.nodes.size();
+    data.nodes.push_back({.section_id = section_id});
+    data.nodes[parent_index].children.push_back(node_index);
+  }
 
-  // Print the report table.
+  // Counters are read last, so that the bookkeeping is not counted.
+  data.stack.push_back({.node_index = node_index, .start_ns = now_ns()});
+  if (data.measures_memory) data.stack.back().start_rss = peak_rss();
+  if (data.measures_energy) {
+    data.stack.back().start_energy_uj = state().energy->read();
+  }
+  if (data.counters.has_value()) {
+    data.stack.back().start_counts = data.counters->read();
+  }
+}
+
+void Profiler::leave() noexcept {
+  // Counters are read first, so that the bookkeeping is not counted.
+  auto& data = thread_data();
+  TIT_ASSERT(data.stack.size() > 1, "No section was entered!");
+  const auto [node_index, start_ns, start_counts, start_energy_uj, start_rss] =
+      data.stack.back();
+  const auto stop_counts =
+      start_counts.has_value() ? data.counters->read() : PerfCounts{};
+  const auto stop_energy_uj =
+      start_energy_uj.has_value() ? state().energy->read() : 0;
+  const auto stop_rss = start_rss.has_value() ? peak_rss() : 0;
+  const auto stop_ns = now_ns();
+  data.stack.pop_back();
+
+  // Update the call tree.
+  auto& node = data.nodes[node_index];
+  node.num_calls += 1;
+  node.total_ns += stop_ns - start_ns;
+  if (start_counts.has_value()) node.counts += stop_counts - *start_counts;
+  if (start_energy_uj.has_value()) {
+    node.energy_uj += stop_energy_uj - *start_energy_uj;
+  }
+  if (start_rss.has_value()) node.rss_growth += stop_rss - *start_rss;
+
+  // Record the completed section, overwriting the oldest record if needed.
+  const TraceRecord record{
+      .section_id = node.section_id,
+      .depth = static_cast<uint32_t>(data.stack.size() - 1),
+      .start_ns = start_ns,
+      .duration_ns = stop_ns - start_ns,
+  };
+  if (data.trace.size() < trace_capacity) {
+    data.trace.push_back(record);
+  } else {
+    data.trace[data.trace_next] = record;
+    data.trace_next = (data.trace_next + 1) % trace_capacity;
+  }
+}
+
+void Profiler::add_items(size_t count) noexcept {
+  if (!is_enabled()) return;
+  auto& data = thread_data();
+  data.nodes[data.stack.back().node_index].num_items += count;
+}
+
+void Profiler::count_alloc(size_t size) noexcept {
+  // Allocation must not allocate itself, so the threads that have not yet
+  // entered any section are skipped.
+  if (!allocs_enabled.load(std::memory_order_relaxed)) return;
+  auto* const data = current_thread_data;
+  if (data == nullptr) return;
+  auto& node = data->nodes[data->stack.back().node_index];
+  node.num_allocs += 1;
+  node.alloc_bytes += size;
+}
+
+void Profiler::track_memory(std::string_view name, size_t bytes) {
+  if (!is_enabled()) return;
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
+  /// @todo In C++26 there would be no need for `std::string{...}`.
+  auto& memory = s.memory[std::string{name}];
+  if (memory.name.empty()) memory.name = name;
+  memory.bytes = bytes;
+  memory.peak_bytes = std::max(memory.peak_bytes, bytes);
+}
+
+auto Profiler::memory_usage() -> std::vector<ProfilerMemory> {
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
+  auto result = s.memory | std::views::values | std::ranges::to<std::vector>();
+  std::ranges::sort(result, std::greater{}, &ProfilerMemory::peak_bytes);
+  return result;
+}
+
+auto Profiler::call_tree() -> ProfilerNode {
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
+  ProfilerNode result;
+  for (const auto& data : s.threads) {
+    merge_node(result, *data, data->nodes.front(), s.section_names);
+  }
+  return result;
+}
+
+void Profiler::write_trace(const std::filesystem::path& path) {
+  auto& s = state();
+  const std::scoped_lock lock{s.mutex};
+  const auto out = make_file_output_stream(path);
+  std::string buffer;
+  const auto write = [&out, &buffer] {
+    out->write(std::as_bytes(std::span{buffer}));
+    buffer.clear();
+  };
+  buffer += R"({"displayTimeUnit":"ms","traceEvents":[)";
+  bool is_first = true;
+  for (const auto& data : s.threads) {
+    std::format_to(std::back_inserter(buffer),
+                   R"({}{{"name":"thread_name","ph":"M","pid":0,"tid":{},)"
+                   R"("args":{{"name":"thread {}"}}}})",
+                   is_first ? "" : ",",
+                   data->thread_index,
+                   data->thread_index);
+    is_first = false;
+    for (const auto& record : data->trace) {
+      std::format_to(std::back_inserter(buffer),
+                     R"(,{{"name":"{}","ph":"X","pid":0,"tid":{},)"
+                     R"("ts":{:.3f},"dur":{:.3f},"args":{{"depth":{}}}}})",
+                     json_escape(s.section_names[record.section_id]),
+                     data->thread_index,
+                     1.0e-3 * static_cast<float64_t>(record.start_ns),
+                     1.0e-3 * static_cast<float64_t>(record.duration_ns),
+                     record.depth);
+      constexpr size_t chunk_size = 64 * 1024;
+      if (buffer.size() >= chunk_size) write();
+    }
+  }
+  buffer += "]}\n";
+  write();
+  out->flush();
+}
+
+void Profiler::report_() {
+  // Print the call tree, children are sorted by the total time.
+  const auto tree = call_tree();
   const auto width = tty_width(TTY::Stdout).value_or(80);
   constexpr std::string_view abs_time_title = "abs. time [s]";
   constexpr std::string_view rel_time_title = "rel. time [%]";
   constexpr std::string_view num_calls_title = "calls [#]";
+  constexpr std::string_view ipc_title = "IPC";
+  constexpr std::string_view llc_title = "LLC miss/item";
+  constexpr std::string_view branch_title = "br. miss/item";
+  constexpr std::string_view energy_title = "energy [J]";
+  constexpr std::string_view energy_item_title = "energy/item [J]";
+  constexpr std::string_view rss_title = "peak RSS growth [MB]";
+  constexpr std::string_view allocs_title = "allocs/call";
+  constexpr std::string_view alloc_bytes_title = "alloc. [MB]";
   constexpr std::string_view section_title = "section name";
+  const bool counters = state().counters_enabled;
+  const bool energy = state().energy.has_value();
+  const bool memory = state().memory_enabled;
   println();
   println("Profiling report:");
   println();
   println("{:->{}}", "", width);
-  println("{}    {}    {}    {}",
-          abs_time_title,
-          rel_time_title,
-          num_calls_title,
-          section_title);
+  print("{}    {}    {}    ", abs_time_title, rel_time_title, num_calls_title);
+  if (counters) {
+    print("{:>6}    {}    {}    ", ipc_title, llc_title, branch_title);
+  }
+  if (energy) print("{}    {}    ", energy_title, energy_item_title);
+  if (memory) {
+    print("{}    {}    {}    ", rss_title, allocs_title, alloc_bytes_title);
+  }
+  println("{}", section_title);
+  println("{:->{}}", "", width);
+  const auto root_iter =
+      std::ranges::find(tree.children, "main", &ProfilerNode::name);
+  const auto root_time =
+      root_iter != tree.children.end() ? root_iter->total_ns : 1;
+  const auto print_node = [root_time, counters, energy, memory](
+                              this const auto& self,
+                              const ProfilerNode& node,
+                              size_t depth) -> void {
+    const auto abs_time = 1.0e-9 * static_cast<float64_t>(node.total_ns);
+    const auto rel_time = 100.0 * static_cast<float64_t>(node.total_ns) /
+                          static_cast<float64_t>(root_time);
+    print("{:>{}.5f}    {:>{}.5f}    {:>{}}    ",
+          abs_time,
+          abs_time_title.size(),
+          rel_time,
+          rel_time_title.size(),
+          node.num_calls,
+          num_calls_title.size());
+    // Misses and energy are normalized per item if the items were reported,
+    // and per call otherwise.
+    const auto num_items = static_cast<float64_t>(
+        node.num_items != 0 ? node.num_items : node.num_calls);
+    if (counters) {
+      const auto& counts = node.counts;
+      const auto num_cycles = std::max(counts.cycles, uint64_t{1});
+      const auto ipc = static_cast<float64_t>(counts.instructions) /
+                       static_cast<float64_t>(num_cycles);
+      print("{:>6.3f}    {:>{}.5f}    {:>{}.5f}    ",
+            ipc,
+            static_cast<float64_t>(counts.cache_misses) / num_items,
+            llc_title.size(),
+            static_cast<float64_t>(counts.branch_misses) / num_items,
+            branch_title.size());
+    }
+    if (energy) {
+      const auto joules = 1.0e-6 * static_cast<float64_t>(node.energy_uj);
+      print("{:>{}.5f}    {:>{}.3e}    ",
+            joules,
+            energy_title.size(),
+            joules / num_items,
+            energy_item_title.size());
+    }
+    if (memory) {
+      const auto num_calls =
+          static_cast<float64_t>(std::max(node.num_calls, size_t{1}));
+      print("{:>{}.3f}    {:>{}.1f}    {:>{}.3f}    ",
+            1.0e-6 * static_cast<float64_t>(node.rss_growth),
+            rss_title.size(),
+            static_cast<float64_t>(node.num_allocs) / num_calls,
+            allocs_title.size(),
+            1.0e-6 * static_cast<float64_t>(node.alloc_bytes),
+            alloc_bytes_title.size());
+    }
+    println("{:>{}}{}", "", 2 * depth, node.name);
+    for (const auto* child : sorted_children(node)) self(*child, depth + 1);
+  };
+  for (const auto* root : sorted_children(tree)) print_node(*root, 0);
   println("{:->{}}", "", width);
-  const auto root_absolute_time = sorted_sections.front()->second.total();
-  for (const auto* section : sorted_sections) {
-    const auto& [section_name, stopwatch] = *section;
-    const auto abs_time = stopwatch.total();
-    const auto rel_time = 100.0 * abs_time / root_absolute_time;
-    const auto num_calls = stopwatch.cycles();
-    println("{:>{}.5f}    {:>{}.5f}    {:>{}}    {}",
-            abs_time,
-            abs_time_title.size(),
-            rel_time,
-            rel_time_title.size(),
-            num_calls,
-            num_calls_title.size(),
-            section_name);
+  println();
+
+  // Print the memory usage of the tracked data structures.
+  const auto memory_usage = Profiler::memory_usage();
+  if (memory_usage.empty() && !memory) return;
+  constexpr std::string_view bytes_title = "latest [MB]";
+  constexpr std::string_view peak_bytes_title = "peak [MB]";
+  constexpr std::string_view name_title = "data structure";
+  println("Memory report:");
+  println();
+  println("{:->{}}", "", width);
+  println("{}    {}    {}", bytes_title, peak_bytes_title, name_title);
+  println("{:->{}}", "", width);
+  for (const auto& [name, bytes, peak_bytes] : memory_usage) {
+    println("{:>{}.3f}    {:>{}.3f}    {}",
+            1.0e-6 * static_cast<float64_t>(bytes),
+            bytes_title.size(),
+            1.0e-6 * static_cast<float64_t>(peak_bytes),
+            peak_bytes_title.size(),
+            name);
   }
   println("{:->{}}", "", width);
+  println("Peak RSS: {:.3f} MB", 1.0e-6 * static_cast<float64_t>(peak_rss()));
   println();
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Replacement allocation functions, that count the allocations for the
+// profiler. Only the basic forms are replaced, since the default array and
+// non-throwing forms call them.
+
+auto operator new(std::size_t size) -> void* {
+  tit::Profiler::count_alloc(size);
+  // NOLINTNEXTLINE(*-no-malloc,*-owning-memory)
+  if (auto* const ptr = std::malloc(size != 0 ? size : 1); ptr != nullptr) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+auto operator new(std::size_t size, std::align_val_t align) -> void* {
+  tit::Profiler::count_alloc(size);
+  const auto alignment = static_cast<std::size_t>(align);
+  const auto aligned_size = (std::max(size, std::size_t{1}) + alignment - 1) &
+                            ~(alignment - 1);
+  // NOLINTNEXTLINE(*-no-malloc,*-owning-memory)
+  if (auto* const ptr = std::aligned_alloc(alignment, aligned_size);
+      ptr != nullptr) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr); // NOLINT(*-no-malloc,*-owning-memory)
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr); // NOLINT(*-no-malloc,*-owning-memory)
+}
+
+void operator delete(void* ptr, std::align_val_t /*align*/) noexcept {
+  std::free(ptr); // NOLINT(*-no-malloc,*-owning-memory)
+}
+
+void operator delete(void* ptr,
+                     std::size_t /*size*/,
+                     std::align_val_t /*align*/) noexcept {
+  std::free(ptr); // NOLINT(*-no-malloc,*-owning-memory)
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -5,43 +5,212 @@
 
 #pragma once
 
+#include <atomic>
+#include <filesystem>
+#include <string>
 #include <string_view>
+#include <vector>
 
-#include "tit/core/str_utils.hpp"
-#include "tit/core/time.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/perf.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Profiler section identifier.
+using ProfilerSectionID = uint32_t;
+
+/// Node of the aggregated profiler call tree.
+struct ProfilerNode final {
+  /// Section name. Empty for the root node.
+  std::string name;
+
+  /// Number of the section calls.
+  size_t num_calls = 0;
+
+  /// Total time spent in the section (in nanoseconds), summed over the
+  /// threads.
+  size_t total_ns = 0;
+
+  /// Hardware performance counter values, summed over the threads. Zero if
+  /// the counters are not enabled.
+  PerfCounts counts;
+
+  /// Energy consumed by the CPU packages during the section (in
+  /// microjoules). Zero if the energy is not measured.
+  uint64_t energy_uj = 0;
+
+  /// Growth of the peak resident set size of the process during the section
+  /// (in bytes), summed over the calls. Zero if the memory is not measured.
+  size_t rss_growth = 0;
+
+  /// Number of the allocations made in the section (excluding the nested
+  /// sections), summed over the threads. Zero if the memory is not measured.
+  size_t num_allocs = 0;
+
+  /// Total size of the allocations made in the section (in bytes), excluding
+  /// the nested sections, summed over the threads.
+  size_t alloc_bytes = 0;
+
+  /// Number of the items (e.g., particles or pairs) processed in the
+  /// section, summed over the threads.
+  size_t num_items = 0;
+
+  /// Sections that were called from this section.
+  std::vector<ProfilerNode> children;
+};
+
+/// Memory usage of a tracked data structure.
+struct ProfilerMemory final {
+  /// Data structure name.
+  std::string name;
+
+  /// Latest reported memory usage (in bytes).
+  size_t bytes = 0;
+
+  /// Largest reported memory usage (in bytes).
+  size_t peak_bytes = 0;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Profiler interface.
+///
+/// Each thread aggregates its own call tree of the sections, and records the
+/// completed sections into its own ring buffer, so the sections can be
+/// profiled inside of the parallel loops. Once the ring buffer is full, the
+/// oldest records are overwritten, while the call tree stays exact.
+///
+/// Optionally, the sections are attached with the hardware performance
+/// counters. Counters of a section count only the events of the thread that
+/// entered it, so the work of the other threads is attributed to the sections
+/// entered by those threads.
+///
+/// Optionally, the energy consumed by the CPU packages is measured. Since the
+/// energy counters are shared by all the threads, energy is only measured in
+/// the sections entered by the thread that enabled profiling, so it includes
+/// the energy of the parallel loops called from those sections. Growth of the
+/// peak resident set size is measured in the same sections, so that the
+/// sections that allocate the most are easy to spot. Also, the global
+/// allocation functions are replaced, and each allocation made with `new`
+/// (e.g., by the standard containers) is attributed to the innermost section
+/// entered by the allocating thread, as well as each allocation made with
+/// `par::Allocator`.
+///
+/// Large data structures report their memory usage (e.g., after a rebuild),
+/// and the latest and the largest reported values are printed along with the
+/// call tree.
 class Profiler final {
 public:
 
+  /// Maximal number of the completed sections recorded by each thread.
+  static constexpr size_t trace_capacity = 64 * 1024;
+
   /// Profiler is a static object.
   Profiler() = delete;
 
-  /// Stopwatch associated with a section.
-  static auto section(std::string_view section_name) -> Stopwatch&;
+  /// Register the section and get its identifier.
+  static auto section(std::string_view section_name) -> ProfilerSectionID;
 
   /// Enable profiling. Report will be printed at exit.
-  static void enable() noexcept;
+  ///
+  /// @param trace_path If not empty, a trace of the recorded sections will be
+  ///                   written at exit in the Chrome trace event format, that
+  ///                   can be viewed with Perfetto or `chrome://tracing`.
+  /// @param counters   Attach the hardware performance counters to the
+  ///                   sections. If the counters are not available, a warning
+  ///                   is printed and the counters are not attached.
+  /// @param energy     Measure the energy consumed in the sections. If the
+  ///                   energy counters are not available, a warning is
+  ///                   printed and the energy is not measured.
+  /// @param memory     Measure the growth of the peak resident set size and
+  ///                   count the allocations in the sections.
+  static void enable(const std::filesystem::path& trace_path = {},
+                     bool counters = false,
+                     bool energy = false,
+                     bool memory = false);
+
+  /// Check if profiling is enabled.
+  static auto is_enabled() noexcept -> bool {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// Enter the section in the current thread.
+  static void enter(ProfilerSectionID section_id);
+
+  /// Leave the innermost entered section in the current thread.
+  static void leave() noexcept;
+
+  /// Report the items processed in the innermost entered section in the
+  /// current thread. Does nothing if profiling is not enabled.
+  static void add_items(size_t count) noexcept;
+
+  /// Count the allocation in the innermost entered section in the current
+  /// thread. Does nothing if the memory is not measured.
+  static void count_alloc(size_t size) noexcept;
+
+  /// Report the memory usage of the data structure. Does nothing if
+  /// profiling is not enabled.
+  static void track_memory(std::string_view name, size_t bytes);
+
+  /// Memory usage of the tracked data structures, sorted by the largest
+  /// reported memory usage.
+  static auto memory_usage() -> std::vector<ProfilerMemory>;
+
+  /// Aggregate the call trees of all the threads.
+  ///
+  /// @note Sections must not be entered or left by the other threads.
+  static auto call_tree() -> ProfilerNode;
+
+  /// Write the recorded sections of all the threads in the Chrome trace
+  /// event format.
+  ///
+  /// @note Sections must not be entered or left by the other threads.
+  static void write_trace(const std::filesystem::path& path);
 
 private:
 
   static void report_();
 
-  static StrHashMap<Stopwatch> sections_;
+  static std::atomic_bool is_enabled_;
 
 }; // class Profiler
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Scoped profiler section.
+class ProfilerScope final {
+public:
+
+  /// Profiler scope is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(ProfilerScope);
+
+  /// Enter the section, if profiling is enabled.
+  explicit ProfilerScope(ProfilerSectionID section_id)
+      : is_active_{Profiler::is_enabled()} {
+    if (is_active_) Profiler::enter(section_id);
+  }
+
+  /// Leave the section.
+  ~ProfilerScope() noexcept {
+    if (is_active_) Profiler::leave();
+  }
+
+private:
+
+  bool is_active_;
+
+}; // class ProfilerScope
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Profile the current scope.
 #define TIT_PROFILE_SECTION(section_name)                                      \
-  static auto& TIT_NAME(prof_section) = tit::Profiler::section(section_name);  \
-  const tit::StopwatchCycle TIT_NAME(prof_cycle)(TIT_NAME(prof_section))
+  static const auto TIT_NAME(prof_section) =                                   \
+      tit::Profiler::section(section_name);                                    \
+  const tit::ProfilerScope TIT_NAME(prof_scope)(TIT_NAME(prof_section))
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -0,0 +1,83 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/profiler.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Find the child node by name, or fail.
+auto child(const ProfilerNode& node, const std::string& name)
+    -> const ProfilerNode& {
+  const auto iter = std::ranges::find(node.children, name, &ProfilerNode::name);
+  REQUIRE(iter != node.children.end());
+  return *iter;
+}
+
+TEST_CASE("Profiler") {
+  // Enter the nested sections in multiple threads. Profiling is not enabled
+  // in the tests, so the sections are entered explicitly.
+  const auto outer_id = Profiler::section("test::outer");
+  const auto inner_id = Profiler::section("test::inner");
+  REQUIRE(Profiler::section("test::outer") == outer_id);
+  const auto run = [outer_id, inner_id] {
+    for (size_t i = 0; i < 3; ++i) {
+      Profiler::enter(outer_id);
+      Profiler::enter(inner_id);
+      Profiler::leave();
+      Profiler::enter(inner_id);
+      Profiler::leave();
+      Profiler::leave();
+    }
+  };
+  {
+    std::vector<std::jthread> threads;
+    for (size_t i = 0; i < 2; ++i) threads.emplace_back(run);
+  }
+
+  {
+    // Ensure the calls are aggregated over the threads, and nested.
+    const auto tree = Profiler::call_tree();
+    const auto& outer = child(tree, "test::outer");
+    CHECK(outer.num_calls == 6);
+    const auto& inner = child(outer, "test::inner");
+    CHECK(inner.num_calls == 12);
+    CHECK(inner.children.empty());
+    CHECK(inner.total_ns <= outer.total_ns);
+  }
+  {
+    // Ensure the completed sections are written.
+    const std::filesystem::path path{"test_profiler_trace.json"};
+    Profiler::write_trace(path);
+    std::vector<byte_t> bytes;
+    read_from(make_file_input_stream(path), bytes, /*chunk_size=*/4096);
+    const std::string trace{reinterpret_cast<const char*>(bytes.data()),
+                            bytes.size()};
+    CHECK(trace.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+    CHECK(trace.contains(R"({"name":"test::outer","ph":"X")"));
+    CHECK(trace.contains(R"({"name":"test::inner","ph":"X")"));
+    CHECK(trace.ends_with("]}\n"));
+    std::filesystem::remove(path);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -12,6 +12,7 @@
 #include "tit/core/_simd/mask.hpp"
 #include "tit/core/_simd/reg.hpp"
 #include "tit/core/_simd/reg_mask.hpp"
+#include "tit/core/_simd/target.hpp"
 #include "tit/core/_simd/traits.hpp"
 // IWYU pragma: end_exports
 
@@ -4,12 +4,21 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <cmath>
+#include <format>
+#include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/io.hpp"
+#include "tit/core/metrics.hpp"
 #include "tit/core/stats.hpp"
 #include "tit/core/str_utils.hpp"
 #include "tit/core/sys/utils.hpp"
@@ -18,7 +27,82 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+void StatsShard<StatsHist>::update(float64_t val) {
+  TIT_ASSERT(val >= 0.0, "Histogram values must be non-negative!");
+  if (count_ == 0) min_ = max_ = val;
+  else min_ = std::min(min_, val), max_ = std::max(max_, val);
+  sum_ += val;
+  count_ += 1;
+  counts_[bucket_(val)] += 1;
+}
+
+void StatsShard<StatsHist>::merge(const StatsShard& other) {
+  if (other.count_ == 0) return;
+  if (count_ == 0) min_ = other.min_, max_ = other.max_;
+  else min_ = std::min(min_, other.min_), max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+  count_ += other.count_;
+  std::ranges::transform(counts_, other.counts_, counts_.begin(), std::plus{});
+}
+
+auto StatsShard<StatsHist>::render_avg() const -> std::string {
+  if (count_ == 0) return {};
+  return std::format("{}", sum_ / static_cast<float64_t>(count_));
+}
+
+auto StatsShard<StatsHist>::render_min() const -> std::string {
+  return std::format("{}", min_);
+}
+
+auto StatsShard<StatsHist>::render_max() const -> std::string {
+  return std::format("{}", max_);
+}
+
+auto StatsShard<StatsHist>::render_percentiles() const -> std::string {
+  return std::format("p50: {:.6g}, p90: {:.6g}, p99: {:.6g}",
+                     percentile(50.0),
+                     percentile(90.0),
+                     percentile(99.0));
+}
+
+auto StatsShard<StatsHist>::percentile(float64_t p) const -> float64_t {
+  TIT_ASSERT(p >= 0.0 && p <= 100.0, "Percentile is out of range!");
+  if (count_ == 0) return 0.0;
+  const auto rank_estimate = p / 100.0 * static_cast<float64_t>(count_);
+  const auto rank =
+      std::max(static_cast<size_t>(std::ceil(rank_estimate)), size_t{1});
+  size_t num_below = 0;
+  for (size_t bucket = 0; bucket < num_buckets_; ++bucket) {
+    num_below += counts_[bucket];
+    if (num_below >= rank) return std::clamp(bucket_value_(bucket), min_, max_);
+  }
+  return max_;
+}
+
+auto StatsShard<StatsHist>::bucket_(float64_t val) noexcept -> size_t {
+  if (!(val >= std::ldexp(1.0, min_exp_))) return 0;
+  int exp = 0;
+  const auto mantissa = std::frexp(val, &exp);
+  const auto exp_index = static_cast<size_t>(exp - min_exp_ - 1);
+  const auto sub_index = static_cast<size_t>(
+      (2.0 * mantissa - 1.0) * static_cast<float64_t>(sub_buckets));
+  return std::min(exp_index * sub_buckets + sub_index, num_buckets_ - 1);
+}
+
+auto StatsShard<StatsHist>::bucket_value_(size_t bucket) noexcept
+    -> float64_t {
+  // Bucket is represented by its midpoint.
+  const auto exp_index = static_cast<int>(bucket / sub_buckets);
+  const auto sub_index = static_cast<float64_t>(bucket % sub_buckets);
+  const auto mantissa =
+      0.5 + (sub_index + 0.5) / (2.0 * static_cast<float64_t>(sub_buckets));
+  return std::ldexp(mantissa, exp_index + min_exp_ + 1);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 bool Stats::enabled_ = false;
+std::mutex Stats::mutex_;
 StrHashMap<std::unique_ptr<BaseStatsVar>> Stats::vars_;
 
 void Stats::enable() noexcept {
@@ -29,6 +113,7 @@ void Stats::enable() noexcept {
 
 void Stats::report_() {
   // Gather the variables and sort them by name.
+  const std::scoped_lock lock{mutex_};
   auto sorted_vars = vars_ |
                      std::views::transform([](auto& var) { return &var; }) |
                      std::ranges::to<std::vector>();
@@ -52,6 +137,10 @@ void Stats::report_() {
     println("{:<{}} min: {}", "  ", name_width, var_ptr->render_min());
     println("{:<{}} avg: {}", name, name_width, var_ptr->render_avg());
     println("{:<{}} max: {}", "  ", name_width, var_ptr->render_max());
+    if (const auto percentiles = var_ptr->render_percentiles();
+        !percentiles.empty()) {
+      println("{:<{}} pct: {}", "  ", name_width, percentiles);
+    }
     println("{:->{}}", "", width);
   }
   println();
@@ -59,4 +148,29 @@ void Stats::report_() {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+StatsThroughput::StatsThroughput(
+    std::string_view name,
+    std::initializer_list<std::pair<std::string_view, size_t>> amounts)
+    : name_{name} {
+  if (!Stats::enabled() && !Metrics::is_enabled()) return;
+  amounts_.assign(amounts);
+  stopwatch_.start();
+}
+
+StatsThroughput::~StatsThroughput() {
+  if (amounts_.empty()) return;
+  stopwatch_.stop();
+  const auto elapsed = static_cast<float64_t>(stopwatch_.total_ns()) * 1.0e-9;
+  if (elapsed <= 0.0) return;
+  Metrics::set(std::format("{}::seconds", name_), elapsed);
+  for (const auto& [unit, amount] : amounts_) {
+    const auto var_name = std::format("{}::{}/s", name_, unit);
+    const auto rate = static_cast<float64_t>(amount) / elapsed;
+    if (Stats::enabled()) Stats::var<float64_t>(var_name).update(rate);
+    Metrics::set(var_name, rate);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit
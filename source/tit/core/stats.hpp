@@ -5,20 +5,27 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <concepts>
 #include <format>
 #include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <ranges>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/str_utils.hpp"
+#include "tit/core/time.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit {
@@ -38,6 +45,11 @@ public:
   /// Get the maximum value as a string.
   constexpr virtual auto render_max() const -> std::string = 0;
 
+  /// Get the percentiles as a string. Empty if percentiles are not tracked.
+  constexpr virtual auto render_percentiles() const -> std::string {
+    return {};
+  }
+
 }; // class BaseStatsVar
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -55,36 +67,56 @@ concept stattable =
       { std::max(val, val) } -> std::convertible_to<Val>;
     };
 
-/// Statistics variable.
+/// Histogram statistics variable tag. Values are non-negative numbers, and
+/// the percentiles are tracked along with the average, minimum and maximum.
+struct StatsHist final {};
+
+/// Accumulator of the statistics variable values of a single thread.
 template<class Val>
-class StatsVar;
+class StatsShard;
 
-template<stattable Val>
-class StatsVar<Val> final : public BaseStatsVar {
+template<stattable Val_>
+class StatsShard<Val_> final {
 public:
 
+  /// Value type.
+  using Val = Val_;
+
+  /// Update the accumulator.
+  constexpr void update(const Val& val) {
+    if (count_ == 0) sum_ = min_ = max_ = val;
+    else sum_ += val, min_ = std::min(min_, val), max_ = std::max(max_, val);
+    count_ += 1;
+  }
+
+  /// Merge the other accumulator into this one.
+  constexpr void merge(const StatsShard& other) {
+    if (other.count_ == 0) return;
+    if (count_ == 0) {
+      *this = other;
+      return;
+    }
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    count_ += other.count_;
+  }
+
   /// Get the mean value as a string.
-  constexpr auto render_avg() const -> std::string override {
-    return std::format("{}", sum_ / count_);
+  constexpr auto render_avg() const -> std::string {
+    return count_ != 0 ? std::format("{}", sum_ / count_) : std::string{};
   }
 
   /// Get the minimum value as a string.
-  constexpr auto render_min() const -> std::string override {
+  constexpr auto render_min() const -> std::string {
     return std::format("{}", min_);
   }
 
   /// Get the maximum value as a string.
-  constexpr auto render_max() const -> std::string override {
+  constexpr auto render_max() const -> std::string {
     return std::format("{}", max_);
   }
 
-  /// Update the statistics variable.
-  void update(const Val& val) {
-    if (count_ == 0) sum_ = min_ = max_ = val;
-    else sum_ += val, min_ = std::min(min_, val), max_ = std::max(max_, val);
-    count_ += 1;
-  }
-
 private:
 
   size_t count_ = 0;
@@ -92,56 +124,196 @@ private:
   Val min_{};
   Val max_{};
 
-}; // class StatsVar
+}; // class StatsShard
 
 template<std::ranges::input_range Vals>
   requires stattable<std::ranges::range_value_t<Vals>>
-class StatsVar<Vals> final : public BaseStatsVar {
+class StatsShard<Vals> final {
 public:
 
   /// Value type.
-  using Val = std::ranges::range_value_t<Vals>;
+  using Val = Vals;
+
+  /// Update the accumulator.
+  ///
+  /// Storage only grows when a longer range is passed, so that the updates
+  /// with the ranges of a stable size do not allocate.
+  constexpr void update(const Vals& range) {
+    accumulate_(range, range, range);
+    count_ += 1;
+  }
+
+  /// Merge the other accumulator into this one.
+  constexpr void merge(const StatsShard& other) {
+    accumulate_(other.sum_, other.min_, other.max_);
+    count_ += other.count_;
+  }
 
   /// Get the mean value as a string.
-  constexpr auto render_avg() const -> std::string override {
+  constexpr auto render_avg() const -> std::string {
     const auto averages =
         sum_ |
-        std::views::transform(std::bind_back(std::divides<Val>{}, count_));
+        std::views::transform(std::bind_back(std::divides<Item_>{}, count_));
     return std::format("{}", averages);
   }
 
   /// Get the minimum value as a string.
-  constexpr auto render_min() const -> std::string override {
+  constexpr auto render_min() const -> std::string {
     return std::format("{}", min_);
   }
 
   /// Get the maximum value as a string.
-  constexpr auto render_max() const -> std::string override {
+  constexpr auto render_max() const -> std::string {
     return std::format("{}", max_);
   }
 
-  /// Update the statistics variable.
-  void update(const Vals& range) {
+private:
+
+  using Item_ = std::ranges::range_value_t<Vals>;
+
+  constexpr void accumulate_(const auto& sums,
+                             const auto& mins,
+                             const auto& maxs) {
     for (const auto& [i, val] :
-         std::views::enumerate(range) | std::views::take(sum_.size())) {
+         std::views::enumerate(sums) | std::views::take(sum_.size())) {
       sum_[i] += val;
+    }
+    for (const auto& [i, val] :
+         std::views::enumerate(mins) | std::views::take(min_.size())) {
       min_[i] = std::min(min_[i], val);
-      max_[i] = std::max(max_[i], val);
     }
-    for (const auto& val : range | std::views::drop(sum_.size())) {
-      sum_.push_back(val);
-      min_.push_back(val);
-      max_.push_back(val);
+    for (const auto& [i, val] :
+         std::views::enumerate(maxs) | std::views::take(max_.size())) {
+      max_[i] = std::max(max_[i], val);
     }
-    count_ += 1;
+    std::ranges::copy(sums | std::views::drop(sum_.size()),
+                      std::back_inserter(sum_));
+    std::ranges::copy(mins | std::views::drop(min_.size()),
+                      std::back_inserter(min_));
+    std::ranges::copy(maxs | std::views::drop(max_.size()),
+                      std::back_inserter(max_));
   }
 
+  size_t count_ = 0;
+  std::vector<Item_> sum_{};
+  std::vector<Item_> min_{};
+  std::vector<Item_> max_{};
+
+}; // class StatsShard
+
+template<>
+class StatsShard<StatsHist> final {
+public:
+
+  /// Value type.
+  using Val = float64_t;
+
+  /// Update the accumulator.
+  void update(float64_t val);
+
+  /// Merge the other accumulator into this one.
+  void merge(const StatsShard& other);
+
+  /// Get the mean value as a string.
+  auto render_avg() const -> std::string;
+
+  /// Get the minimum value as a string.
+  auto render_min() const -> std::string;
+
+  /// Get the maximum value as a string.
+  auto render_max() const -> std::string;
+
+  /// Get the percentiles as a string.
+  auto render_percentiles() const -> std::string;
+
+  /// Approximate percentile of the values, with the relative error of
+  /// about `1 / (2 * sub_buckets)`.
+  auto percentile(float64_t p) const -> float64_t;
+
+  /// Number of the buckets per a power of two.
+  static constexpr size_t sub_buckets = 16;
+
 private:
 
+  // Values are bucketed by their binary exponent and the leading bits of
+  // their mantissa. Values below `2^min_exp` are counted in the first bucket.
+  static constexpr int min_exp_ = -48;
+  static constexpr int max_exp_ = 80;
+  static constexpr size_t num_buckets_ =
+      static_cast<size_t>(max_exp_ - min_exp_) * sub_buckets;
+
+  static auto bucket_(float64_t val) noexcept -> size_t;
+  static auto bucket_value_(size_t bucket) noexcept -> float64_t;
+
   size_t count_ = 0;
-  std::vector<Val> sum_{};
-  std::vector<Val> min_{};
-  std::vector<Val> max_{};
+  float64_t sum_ = 0.0;
+  float64_t min_ = 0.0;
+  float64_t max_ = 0.0;
+  std::array<size_t, num_buckets_> counts_{};
+
+}; // class StatsShard
+
+/// Statistics variable.
+///
+/// Values are accumulated into the per-thread shards, that are merged once
+/// the variable is rendered. Shards are owned by the variable, so the values
+/// outlive the threads that produced them.
+template<class Val>
+class StatsVar final : public BaseStatsVar {
+public:
+
+  /// Shard type.
+  using Shard = StatsShard<Val>;
+
+  /// Get the mean value as a string.
+  auto render_avg() const -> std::string override {
+    return merged_().render_avg();
+  }
+
+  /// Get the minimum value as a string.
+  auto render_min() const -> std::string override {
+    return merged_().render_min();
+  }
+
+  /// Get the maximum value as a string.
+  auto render_max() const -> std::string override {
+    return merged_().render_max();
+  }
+
+  /// Get the percentiles as a string.
+  auto render_percentiles() const -> std::string override {
+    if constexpr (requires (const Shard& shard) {
+                    shard.render_percentiles();
+                  }) {
+      return merged_().render_percentiles();
+    } else return {};
+  }
+
+  /// Create a new shard. Shard must be updated by a single thread only.
+  auto shard() -> Shard& {
+    const std::scoped_lock lock{mutex_};
+    return *shards_.emplace_back(std::make_unique<Shard>());
+  }
+
+  /// Update the statistics variable. Thread-safe, but slower than updating
+  /// a thread's own shard, see `shard`.
+  void update(const typename Shard::Val& val) {
+    const std::scoped_lock lock{mutex_};
+    shared_.update(val);
+  }
+
+private:
+
+  auto merged_() const -> Shard {
+    const std::scoped_lock lock{mutex_};
+    auto result = shared_;
+    for (const auto& shard : shards_) result.merge(*shard);
+    return result;
+  }
+
+  mutable std::mutex mutex_;
+  Shard shared_;
+  std::vector<std::unique_ptr<Shard>> shards_;
 
 }; // class StatsVar
 
@@ -154,10 +326,11 @@ public:
   /// Statistics is a static object.
   Stats() = delete;
 
-  /// Profiling variable.
+  /// Statistics variable. Thread-safe.
   template<class Type>
     requires std::is_object_v<Type>
   static auto var(std::string_view var_name) -> StatsVar<Type>& {
+    const std::scoped_lock lock{mutex_};
     /// @todo In C++26 there would be no need for `std::string{...}`.
     auto& var = vars_[std::string{var_name}];
     if (var == nullptr) var = std::make_unique<StatsVar<Type>>();
@@ -179,19 +352,67 @@ private:
   static void report_();
 
   static bool enabled_;
+  static std::mutex mutex_;
   static StrHashMap<std::unique_ptr<BaseStatsVar>> vars_;
 
 }; // class Stats
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-/// Update the statistics variable.
+/// Scoped throughput meter.
+///
+/// Measures the wall time of the scope, and on exit updates the statistics
+/// variables `<name>::<unit>/s` with the processing rates of the amounts
+/// that were processed in the scope, e.g. `<name>::pairs/s` for the particle
+/// pairs, or `<name>::bytes/s` for the effective memory bandwidth. If metrics
+/// are enabled, the rates and the `<name>::seconds` elapsed time are also
+/// published as the metrics gauges.
+class StatsThroughput final {
+public:
+
+  /// Throughput meter is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(StatsThroughput);
+
+  /// Start measuring, if statistics or metrics are enabled.
+  ///
+  /// @param name    Name prefix of the statistics variables.
+  /// @param amounts Units and amounts processed in the scope.
+  StatsThroughput(
+      std::string_view name,
+      std::initializer_list<std::pair<std::string_view, size_t>> amounts);
+
+  /// Stop measuring and update the statistics variables.
+  ~StatsThroughput();
+
+private:
+
+  std::string_view name_;
+  std::vector<std::pair<std::string_view, size_t>> amounts_;
+  Stopwatch stopwatch_;
+
+}; // class StatsThroughput
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Update the statistics variable. Each thread updates its own shard of the
+/// variable, so the statistics can be collected inside of the parallel loops.
 #define TIT_STATS(var_name, ...)                                               \
   do {                                                                         \
     if (tit::Stats::enabled()) {                                               \
       using TIT_NAME(Type) = std::remove_cvref_t<decltype(__VA_ARGS__)>;       \
-      static auto& TIT_NAME(var) = tit::Stats::var<TIT_NAME(Type)>(var_name);  \
-      TIT_NAME(var).update(__VA_ARGS__);                                       \
+      thread_local auto& TIT_NAME(shard) =                                     \
+          tit::Stats::var<TIT_NAME(Type)>(var_name).shard();                   \
+      TIT_NAME(shard).update(__VA_ARGS__);                                     \
+    }                                                                          \
+  } while (false)
+
+/// Update the histogram statistics variable, see `TIT_STATS`.
+#define TIT_STATS_HIST(var_name, ...)                                          \
+  do {                                                                         \
+    if (tit::Stats::enabled()) {                                               \
+      thread_local auto& TIT_NAME(shard) =                                     \
+          tit::Stats::var<tit::StatsHist>(var_name).shard();                   \
+      TIT_NAME(shard).update(static_cast<tit::float64_t>(__VA_ARGS__));       \
     }                                                                          \
   } while (false)
 
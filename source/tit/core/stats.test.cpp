@@ -0,0 +1,76 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/stats.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("StatsVar") {
+  SUBCASE("scalar") {
+    // Ensure the per-thread shards are merged.
+    StatsVar<int> var;
+    {
+      std::vector<std::jthread> threads;
+      for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&var, i] {
+          auto& shard = var.shard();
+          for (int j = 0; j < 10; ++j) shard.update(10 * i + j);
+        });
+      }
+    }
+    var.update(40);
+    CHECK(var.render_min() == "0");
+    CHECK(var.render_max() == "40");
+    CHECK(var.render_avg() == "20");
+    CHECK(var.render_percentiles().empty());
+  }
+  SUBCASE("range") {
+    StatsVar<std::vector<int>> var;
+    var.shard().update({1, 4});
+    var.shard().update({3, 2, 5});
+    CHECK(var.render_min() == "[1, 2, 5]");
+    CHECK(var.render_max() == "[3, 4, 5]");
+    CHECK(var.render_avg() == "[2, 3, 2]");
+  }
+}
+
+TEST_CASE("StatsShard<StatsHist>") {
+  StatsShard<StatsHist> hist;
+  StatsShard<StatsHist> other;
+  for (size_t i = 1; i <= 1000; ++i) {
+    (i % 2 == 0 ? hist : other).update(static_cast<float64_t>(i));
+  }
+  hist.merge(other);
+  CHECK(hist.render_min() == "1");
+  CHECK(hist.render_max() == "1000");
+  CHECK(hist.render_avg() == "500.5");
+  // Percentiles are approximate, within the bucket width.
+  const auto is_near = [](float64_t val, float64_t expected) {
+    constexpr auto tol =
+        1.0 / static_cast<float64_t>(StatsShard<StatsHist>::sub_buckets);
+    return std::abs(val - expected) <= tol * expected;
+  };
+  CHECK(is_near(hist.percentile(50.0), 500.0));
+  CHECK(is_near(hist.percentile(90.0), 900.0));
+  CHECK(is_near(hist.percentile(99.0), 990.0));
+  CHECK(is_near(hist.percentile(0.0), 1.0));
+  CHECK(is_near(hist.percentile(100.0), 1000.0));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
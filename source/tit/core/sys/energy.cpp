@@ -0,0 +1,106 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <charconv>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/energy.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Read the unsigned integer from the start of the file.
+auto read_uint(int fd) noexcept -> std::optional<uint64_t> {
+  std::array<char, 32> buffer{};
+  const auto num_bytes = pread(fd, buffer.data(), buffer.size(), 0);
+  if (num_bytes <= 0) return std::nullopt;
+  uint64_t result = 0;
+  const auto [_, error] =
+      std::from_chars(buffer.data(), buffer.data() + num_bytes, result);
+  if (error != std::errc{}) return std::nullopt;
+  return result;
+}
+
+// Read the unsigned integer from the file at the path.
+auto read_uint(const std::filesystem::path& path) noexcept
+    -> std::optional<uint64_t> {
+  const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return std::nullopt;
+  const auto result = read_uint(fd);
+  close(fd);
+  return result;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+EnergyCounters::EnergyCounters() {
+#ifdef __linux__
+  // Only the top level domains, e.g. `intel-rapl:0`, are the packages, the
+  // nested ones, e.g. `intel-rapl:0:0`, are the parts of the packages.
+  std::error_code error;
+  const std::filesystem::directory_iterator dir{"/sys/class/powercap", error};
+  if (error) return;
+  for (const auto& entry : dir) {
+    const auto name = entry.path().filename().string();
+    if (!name.starts_with("intel-rapl:") ||
+        name.find(':') != name.rfind(':')) {
+      continue;
+    }
+    const auto max_uj = read_uint(entry.path() / "max_energy_range_uj");
+    if (!max_uj.has_value()) continue;
+    const auto fd =
+        open((entry.path() / "energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) continue;
+    const auto start_uj = read_uint(fd);
+    if (!start_uj.has_value()) {
+      close(fd);
+      continue;
+    }
+    domains_.push_back(
+        {.fd = fd, .max_uj = *max_uj, .last_uj = *start_uj, .total_uj = 0});
+  }
+#endif
+}
+
+EnergyCounters::~EnergyCounters() noexcept {
+  for (const auto& domain : domains_) close(domain.fd);
+}
+
+auto EnergyCounters::is_open() const noexcept -> bool {
+  return !domains_.empty();
+}
+
+auto EnergyCounters::read() noexcept -> uint64_t {
+  uint64_t result = 0;
+  for (auto& domain : domains_) {
+    // Counter wraps around at the maximal value, so it must be read more
+    // often than it wraps, which takes minutes at the full power.
+    if (const auto uj = read_uint(domain.fd); uj.has_value()) {
+      domain.total_uj += *uj >= domain.last_uj ?
+                             *uj - domain.last_uj :
+                             domain.max_uj - domain.last_uj + *uj;
+      domain.last_uj = *uj;
+    }
+    result += domain.total_uj;
+  }
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,64 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Energy counters of the CPU packages.
+///
+/// Counters are the RAPL package domains, that are read through the Linux
+/// powercap interface (`/sys/class/powercap/intel-rapl:*`), which is also
+/// provided for the AMD processors. Unlike the performance counters, energy
+/// is consumed by the whole packages, so the readings include the work of
+/// all the threads and processes. Counters that could not be opened (e.g.,
+/// since `energy_uj` is only readable by root on the recent kernels, or on
+/// the other platforms) always read as zero.
+///
+/// @note Counters are not thread-safe, since the readings are tracked to
+///       extend the wrapping hardware counters.
+class EnergyCounters final {
+public:
+
+  /// Energy counters are not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(EnergyCounters);
+
+  /// Open the counters of all the CPU packages.
+  EnergyCounters();
+
+  /// Close the counters.
+  ~EnergyCounters() noexcept;
+
+  /// Check if any of the counters is open.
+  auto is_open() const noexcept -> bool;
+
+  /// Read the energy consumed by all the CPU packages since the counters
+  /// were opened (in microjoules).
+  auto read() noexcept -> uint64_t;
+
+private:
+
+  // Counter of a single package domain.
+  struct Domain_ final {
+    int fd;
+    uint64_t max_uj;
+    uint64_t last_uj;
+    uint64_t total_uj;
+  };
+
+  std::vector<Domain_> domains_;
+
+}; // class EnergyCounters
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,35 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/energy.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("EnergyCounters") {
+  // Counters may be unavailable in the test environment, in that case they
+  // must read as zero.
+  EnergyCounters counters{};
+  const auto start = counters.read();
+  volatile uint64_t sum = 0;
+  for (uint64_t i = 0; i < 100'000; ++i) sum = sum + i;
+  const auto stop = counters.read();
+  if (counters.is_open()) {
+    CHECK(stop >= start);
+  } else {
+    CHECK(start == 0);
+    CHECK(stop == 0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,87 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/perf.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+PerfCounters::PerfCounters() {
+#ifdef __linux__
+  // Counters are opened in the same order as the `PerfCounts` fields. The
+  // first counter that is successfully opened becomes the group leader, so
+  // that all the counters are read at once.
+  static constexpr std::array<uint64_t, num_counters_> configs{
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+  };
+  for (size_t i = 0; i < num_counters_; ++i) {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = configs[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    const auto fd = static_cast<int>(syscall(SYS_perf_event_open,
+                                             &attr,
+                                             /*pid=*/0,
+                                             /*cpu=*/-1,
+                                             /*group_fd=*/leader_fd_,
+                                             /*flags=*/0UL));
+    if (fd < 0) continue;
+    if (leader_fd_ < 0) leader_fd_ = fd;
+    fds_[i] = fd;
+    slots_[i] = num_slots_++;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() noexcept {
+  for (const auto fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+auto PerfCounters::is_open() const noexcept -> bool {
+  return leader_fd_ >= 0;
+}
+
+auto PerfCounters::read() const noexcept -> PerfCounts {
+  if (!is_open()) return {};
+
+  // Group is read as the number of the counters, followed by the values.
+  std::array<uint64_t, num_counters_ + 1> buffer{};
+  const auto num_bytes = (num_slots_ + 1) * sizeof(uint64_t);
+  if (::read(leader_fd_, buffer.data(), num_bytes) !=
+      static_cast<ssize_t>(num_bytes)) {
+    return {};
+  }
+  const auto value = [&buffer, this](size_t i) -> uint64_t {
+    return fds_[i] >= 0 ? buffer[slots_[i] + 1] : 0;
+  };
+  return {
+      .cycles = value(0),
+      .instructions = value(1),
+      .cache_misses = value(2),
+      .branch_misses = value(3),
+  };
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,91 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Hardware performance counter values.
+struct PerfCounts final {
+  /// Number of the CPU cycles.
+  uint64_t cycles = 0;
+
+  /// Number of the retired instructions.
+  uint64_t instructions = 0;
+
+  /// Number of the last level cache misses.
+  uint64_t cache_misses = 0;
+
+  /// Number of the mispredicted branches.
+  uint64_t branch_misses = 0;
+
+  /// Accumulate the counter values.
+  constexpr auto operator+=(const PerfCounts& other) noexcept -> PerfCounts& {
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cache_misses += other.cache_misses;
+    branch_misses += other.branch_misses;
+    return *this;
+  }
+
+  /// Difference of the counter values.
+  friend constexpr auto operator-(const PerfCounts& a,
+                                  const PerfCounts& b) noexcept -> PerfCounts {
+    return {
+        .cycles = a.cycles - b.cycles,
+        .instructions = a.instructions - b.instructions,
+        .cache_misses = a.cache_misses - b.cache_misses,
+        .branch_misses = a.branch_misses - b.branch_misses,
+    };
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Hardware performance counters of the calling thread.
+///
+/// Counters are opened with `perf_event_open` on Linux, and count the user
+/// space events of the thread that opened them. Counters that could not be
+/// opened (e.g., due to the `perf_event_paranoid` setting, or on the other
+/// platforms) always read as zeros.
+class PerfCounters final {
+public:
+
+  /// Performance counters are not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(PerfCounters);
+
+  /// Open and start the counters for the calling thread.
+  PerfCounters();
+
+  /// Close the counters.
+  ~PerfCounters() noexcept;
+
+  /// Check if any of the counters is open.
+  auto is_open() const noexcept -> bool;
+
+  /// Read the current counter values.
+  auto read() const noexcept -> PerfCounts;
+
+private:
+
+  static constexpr size_t num_counters_ = 4;
+
+  int leader_fd_ = -1;
+  std::array<int, num_counters_> fds_{-1, -1, -1, -1};
+  std::array<size_t, num_counters_> slots_{};
+  size_t num_slots_ = 0;
+
+}; // class PerfCounters
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,51 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/perf.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("PerfCounts") {
+  PerfCounts a{.cycles = 4, .instructions = 3, .cache_misses = 2};
+  const PerfCounts b{.cycles = 1, .instructions = 1, .branch_misses = 1};
+  a += b;
+  CHECK(a.cycles == 5);
+  CHECK(a.instructions == 4);
+  CHECK(a.cache_misses == 2);
+  CHECK(a.branch_misses == 1);
+  const auto c = a - b;
+  CHECK(c.cycles == 4);
+  CHECK(c.instructions == 3);
+  CHECK(c.cache_misses == 2);
+  CHECK(c.branch_misses == 0);
+}
+
+TEST_CASE("PerfCounters") {
+  // Counters may be unavailable in the test environment, in that case they
+  // must read as zeros.
+  const PerfCounters counters{};
+  const auto start = counters.read();
+  volatile uint64_t sum = 0;
+  for (uint64_t i = 0; i < 100'000; ++i) sum = sum + i;
+  const auto stop = counters.read();
+  if (counters.is_open()) {
+    CHECK(stop.cycles >= start.cycles);
+    CHECK(stop.instructions > start.instructions);
+  } else {
+    CHECK(stop.cycles == 0);
+    CHECK(stop.instructions == 0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -116,7 +116,9 @@ FatalSignalHandler::FatalSignalHandler()
     dump("\n\nInterrupted by Ctrl+C.\n");
     exit(ExitCode::success);
   } else {
-    // Dump backtrace and fast-exit with an error.
+    // Write the queued log messages, dump backtrace and fast-exit with an
+    // error.
+    Logger::flush_on_signal();
     dump("\n\nTerminated by ");
     dump(translate<std::string_view>(signal_number)
              .option(SIGILL, "SIGILL (illegal instruction)")
@@ -134,4 +136,19 @@ FatalSignalHandler::FatalSignalHandler()
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+StopSignalHandler::StopSignalHandler()
+    : SignalHandler{SIGTERM, SIGUSR1, SIGUSR2} {}
+
+void StopSignalHandler::on_signal(int signal_number) noexcept {
+  // Request the stop on the first signal, and terminate on the second one,
+  // in case the program is not able to reach the safe point in time.
+  int expected = 0;
+  if (signal_number_.compare_exchange_strong(expected, signal_number)) return;
+  Logger::flush_on_signal();
+  dump("\n\nTerminated by the repeated stop request.\n");
+  fast_exit(ExitCode::failure);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit
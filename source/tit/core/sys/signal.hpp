@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <csignal>
 #include <initializer_list>
 #include <ranges>
@@ -72,4 +73,38 @@ protected:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Signal handler that requests the cooperative stop on the preemption
+/// signals: `SIGTERM`, `SIGUSR1` and `SIGUSR2`.
+///
+/// The program is expected to check for the stop request at the safe points,
+/// such as the time step boundaries, save its state and exit. The second
+/// preemption signal terminates the program immediately.
+class StopSignalHandler final : public SignalHandler {
+public:
+
+  /// Initialize handling for the preemption signals.
+  StopSignalHandler();
+
+  /// Check if the stop was requested.
+  auto stop_requested() const noexcept -> bool {
+    return signal_number_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /// Number of the signal that requested the stop, or zero.
+  auto signal_number() const noexcept -> int {
+    return signal_number_.load(std::memory_order_relaxed);
+  }
+
+protected:
+
+  void on_signal(int signal_number) noexcept override;
+
+private:
+
+  std::atomic<int> signal_number_{0};
+
+}; // class StopSignalHandler
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit
@@ -67,6 +67,17 @@ TEST_CASE("SignalHandler") {
   CHECK(handler_1.last() == SIGTERM);
 }
 
+TEST_CASE("StopSignalHandler") {
+  const StopSignalHandler handler{};
+  CHECK_FALSE(handler.stop_requested());
+  CHECK(handler.signal_number() == 0);
+
+  // Raise the preemption signal, and ensure the stop is requested.
+  checked_raise(SIGUSR1);
+  CHECK(handler.stop_requested());
+  CHECK(handler.signal_number() == SIGUSR1);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
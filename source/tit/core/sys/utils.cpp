@@ -10,6 +10,7 @@
 #include <cstdlib>
 #include <filesystem>
 #include <optional>
+#include <span>
 #include <string>
 #include <utility>
 
@@ -18,7 +19,11 @@
 #include <sys/proc_info.h>
 #include <sys/ttycom.h>
 #endif
+#include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <boost/core/demangle.hpp>
@@ -71,6 +76,17 @@ auto exe_path() -> std::filesystem::path {
 #endif
 }
 
+auto peak_rss() noexcept -> size_t {
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  const auto max_rss = static_cast<size_t>(usage.ru_maxrss);
+#ifdef __APPLE__
+  return max_rss; // Bytes on macOS.
+#else
+  return max_rss * 1024; // Kilobytes on Linux.
+#endif
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto get_env(CStrView name) noexcept -> std::optional<std::string_view> {
@@ -93,6 +109,75 @@ auto open_file(CStrView file_name, CStrView mode) -> FilePtr {
   return file;
 }
 
+MappedFile::MappedFile(const std::filesystem::path& path) {
+  // NOLINTNEXTLINE(*-vararg)
+  const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) TIT_THROW("Failed to open file '{}'.", path.native());
+
+  struct stat file_stat = {};
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    TIT_THROW("Failed to query the size of file '{}'.", path.native());
+  }
+  size_ = static_cast<size_t>(file_stat.st_size);
+  if (size_ == 0) {
+    // Empty files cannot be mapped.
+    close(fd);
+    return;
+  }
+  // The descriptor is not needed once the mapping is established.
+  auto* const addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) { // NOLINT(*-cstyle-cast,*-int-to-ptr)
+    TIT_THROW("Failed to map file '{}'.", path.native());
+  }
+  data_ = static_cast<const byte_t*>(addr);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)} {}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile& {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+// NOLINTNEXTLINE(*-exception-escape)
+MappedFile::~MappedFile() noexcept {
+  if (data_ == nullptr) return; // NOLINTNEXTLINE(*-const-cast)
+  if (munmap(const_cast<byte_t*>(data_), size_) != 0) {
+    TIT_ERROR("Failed to unmap file.");
+  }
+}
+
+FileOutputStream::FileOutputStream(const std::filesystem::path& path)
+    : path_{path}, file_{open_file(path.c_str(), "wb")} {}
+
+void FileOutputStream::write(std::span<const byte_t> data) {
+  if (std::fwrite(data.data(), 1, data.size(), file_.get()) != data.size()) {
+    TIT_THROW("Failed to write into file '{}'.", path_.native());
+  }
+}
+
+void FileOutputStream::flush() {
+  if (std::fflush(file_.get()) != 0) {
+    TIT_THROW("Failed to flush file '{}'.", path_.native());
+  }
+}
+
+FileInputStream::FileInputStream(const std::filesystem::path& path)
+    : path_{path}, file_{open_file(path.c_str(), "rb")} {}
+
+auto FileInputStream::read(std::span<byte_t> data) -> size_t {
+  const auto count = std::fread(data.data(), 1, data.size(), file_.get());
+  if (count < data.size() && std::ferror(file_.get()) != 0) {
+    TIT_THROW("Failed to read from file '{}'.", path_.native());
+  }
+  return count;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto tty_width(TTY tty) -> std::optional<size_t> {
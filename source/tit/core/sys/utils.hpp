@@ -9,6 +9,7 @@
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <typeinfo>
@@ -17,6 +18,8 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/str_utils.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
 
 namespace tit {
 
@@ -47,6 +50,9 @@ enum class ExitCode : uint8_t {
 /// Path to the current executable.
 auto exe_path() -> std::filesystem::path;
 
+/// Peak resident set size of the current process (in bytes).
+auto peak_rss() noexcept -> size_t;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Get the value of an environment variable.
@@ -75,6 +81,90 @@ using FilePtr = std::unique_ptr<std::FILE, FileCloser>;
 /// Open a file.
 auto open_file(CStrView file_name, CStrView mode) -> FilePtr;
 
+/// Read-only memory mapping of a file.
+class MappedFile final {
+public:
+
+  /// Map the whole file into memory.
+  explicit MappedFile(const std::filesystem::path& path);
+
+  /// Move-construct the mapping.
+  MappedFile(MappedFile&& other) noexcept;
+
+  /// Move-assign the mapping.
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+  TIT_MOVE_ONLY(MappedFile);
+
+  /// Unmap the file.
+  ~MappedFile() noexcept;
+
+  /// Size of the mapped file in bytes.
+  auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+  /// Mapped file contents.
+  auto bytes() const noexcept -> std::span<const byte_t> {
+    return {data_, size_};
+  }
+
+private:
+
+  const byte_t* data_ = nullptr;
+  size_t size_ = 0;
+
+}; // class MappedFile
+
+/// Output stream that writes the bytes into a file.
+class FileOutputStream final : public OutputStream<byte_t> {
+public:
+
+  /// Open the file for writing. Existing file is truncated.
+  explicit FileOutputStream(const std::filesystem::path& path);
+
+  /// Write the bytes into the file.
+  void write(std::span<const byte_t> data) override;
+
+  /// Flush the buffered bytes into the file.
+  void flush() override;
+
+private:
+
+  std::filesystem::path path_;
+  FilePtr file_;
+
+}; // class FileOutputStream
+
+/// Make a file output stream.
+inline auto make_file_output_stream(const std::filesystem::path& path)
+    -> OutputStreamPtr<byte_t> {
+  return make_flushable<FileOutputStream>(path);
+}
+
+/// Input stream that reads the bytes from a file.
+class FileInputStream final : public InputStream<byte_t> {
+public:
+
+  /// Open the file for reading.
+  explicit FileInputStream(const std::filesystem::path& path);
+
+  /// Read the next bytes from the file.
+  auto read(std::span<byte_t> data) -> size_t override;
+
+private:
+
+  std::filesystem::path path_;
+  FilePtr file_;
+
+}; // class FileInputStream
+
+/// Make a file input stream.
+inline auto make_file_input_stream(const std::filesystem::path& path)
+    -> InputStreamPtr<byte_t> {
+  return std::make_unique<FileInputStream>(path);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Terminal stream type.
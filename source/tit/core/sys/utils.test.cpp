@@ -3,6 +3,17 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <ranges>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/stream.hpp"
 #include "tit/core/sys/utils.hpp"
 
 #include "tit/testing/test.hpp"
@@ -16,6 +27,14 @@ TEST_CASE("exe_path") {
   CHECK(exe_path().filename() == "tit_core_tests");
 }
 
+TEST_CASE("peak_rss") {
+  // Ensure the touched memory is accounted.
+  constexpr size_t size = 16 * 1024 * 1024;
+  std::vector<byte_t> bytes(size, byte_t{1});
+  CHECK(peak_rss() >= size);
+  CHECK(bytes.back() == byte_t{1});
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("get_env") {
@@ -46,5 +65,75 @@ TEST_CASE("get_env") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("MappedFile") {
+  const std::filesystem::path file_name{"test_mapped_file.bin"};
+  const auto write_file = [&file_name](std::string_view contents) {
+    const auto file = open_file(file_name.c_str(), "wb");
+    std::fwrite(contents.data(), 1, contents.size(), file.get());
+  };
+  const auto as_chars = std::views::transform(
+      [](byte_t b) { return static_cast<char>(b); });
+  SUBCASE("success") {
+    SUBCASE("non-empty file") {
+      write_file("Hello, world!");
+      const MappedFile mapped{file_name};
+      CHECK(mapped.size() == 13);
+      CHECK(std::ranges::equal(mapped.bytes() | as_chars,
+                               std::string_view{"Hello, world!"}));
+    }
+    SUBCASE("empty file") {
+      write_file("");
+      const MappedFile mapped{file_name};
+      CHECK(mapped.size() == 0);
+      CHECK(mapped.bytes().empty());
+    }
+    SUBCASE("move") {
+      write_file("abc");
+      MappedFile mapped{file_name};
+      const MappedFile moved{std::move(mapped)};
+      CHECK(moved.size() == 3);
+      CHECK(std::ranges::equal(moved.bytes() | as_chars,
+                               std::string_view{"abc"}));
+    }
+  }
+  SUBCASE("failure") {
+    CHECK_THROWS_WITH_AS(
+        MappedFile{"/invalid/path/to/file.bin"},
+        "Failed to open file '/invalid/path/to/file.bin'.",
+        Exception);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("FileOutputStream and FileInputStream") {
+  const std::filesystem::path file_name{"test_file_stream.bin"};
+  const auto bytes = std::views::iota(0, 1000) |
+                     std::views::transform(
+                         [](int i) { return static_cast<byte_t>(i % 256); }) |
+                     std::ranges::to<std::vector>();
+  SUBCASE("success") {
+    write_to(make_file_output_stream(file_name), bytes);
+    CHECK(std::filesystem::file_size(file_name) == bytes.size());
+    std::vector<byte_t> read_bytes;
+    read_from(make_file_input_stream(file_name),
+              read_bytes,
+              /*chunk_size=*/64);
+    CHECK(read_bytes == bytes);
+  }
+  SUBCASE("failure") {
+    CHECK_THROWS_WITH_AS(
+        make_file_output_stream("/invalid/path/to/file.bin"),
+        "Failed to open file '/invalid/path/to/file.bin'.",
+        Exception);
+    CHECK_THROWS_WITH_AS(
+        make_file_input_stream("/invalid/path/to/file.bin"),
+        "Failed to open file '/invalid/path/to/file.bin'.",
+        Exception);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
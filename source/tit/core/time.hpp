@@ -30,7 +30,8 @@ public:
     const auto stop = std::chrono::steady_clock::now();
     TIT_ASSERT(stop > start_, "Stopwatch was not started!");
     const auto delta = stop - start_;
-    total_ += std::chrono::duration_cast<std::chrono::nanoseconds>(delta);
+    last_ = std::chrono::duration_cast<std::chrono::nanoseconds>(delta);
+    total_ += last_;
     cycles_ += 1;
   }
 
@@ -54,6 +55,16 @@ public:
     return 1.0e-9 * static_cast<real_t>(cycle_ns());
   }
 
+  /// Get the last cycle time (in nanoseconds).
+  constexpr auto last_cycle_ns() const noexcept -> size_t {
+    return last_.count();
+  }
+
+  /// Get the last cycle time (in seconds).
+  constexpr auto last_cycle() const noexcept -> real_t {
+    return 1.0e-9 * static_cast<real_t>(last_cycle_ns());
+  }
+
   /// Amount of cycles.
   constexpr auto cycles() const noexcept -> size_t {
     return cycles_;
@@ -62,6 +73,7 @@ public:
   /// Reset the stopwatch.
   void reset() noexcept {
     total_ = std::chrono::nanoseconds{};
+    last_ = std::chrono::nanoseconds{};
     cycles_ = 0;
   }
 
@@ -69,6 +81,7 @@ private:
 
   std::chrono::time_point<std::chrono::steady_clock> start_;
   std::chrono::nanoseconds total_{};
+  std::chrono::nanoseconds last_{};
   size_t cycles_{};
 
 }; // class Stopwatch
@@ -30,6 +30,7 @@ TEST_CASE("Stopwatch") {
   // unstable.
   CHECK(stopwatch.total() >= delta_sec);
   CHECK(stopwatch.cycle() >= delta_sec);
+  CHECK(stopwatch.last_cycle() >= delta_sec);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
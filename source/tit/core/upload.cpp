@@ -0,0 +1,172 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/upload.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+UploadStream::UploadStream(MultipartUploaderPtr uploader,
+                           const UploadOptions& options)
+    : uploader_{std::move(uploader)}, options_{options},
+      thread_{[this] { run_(); }} {
+  TIT_ASSERT(uploader_ != nullptr, "Uploader must not be null!");
+  TIT_ASSERT(options_.part_size > 0, "Part size must be positive!");
+  TIT_ASSERT(options_.max_queue_size > 0, "Queue size must be positive!");
+  part_.reserve(options_.part_size);
+}
+
+UploadStream::~UploadStream() noexcept {
+  if (!is_closed_) {
+    if (std::uncaught_exceptions() > num_uncaught_exceptions_) {
+      // Stream is destroyed due to an exception, so the object is likely
+      // incomplete, and it must not be assembled.
+      is_closed_ = true;
+      uploader_->abort();
+    } else {
+      try {
+        close();
+      } catch (const std::exception& e) {
+        TIT_ERROR("Failed to complete the upload: {}", e.what());
+      }
+    }
+  }
+
+  // Background thread is stopped once the queue is drained, and it is joined
+  // by its destructor.
+  const std::scoped_lock lock{mutex_};
+  is_stopping_ = true;
+  cv_.notify_all();
+}
+
+void UploadStream::write(std::span<const byte_t> data) {
+  TIT_ASSERT(!is_closed_, "Upload stream is closed!");
+  while (!data.empty()) {
+    const auto count = std::min(data.size(), options_.part_size - part_.size());
+    part_.insert(part_.end(), data.begin(), data.begin() + count);
+    data = data.subspan(count);
+    if (part_.size() == options_.part_size) submit_();
+  }
+}
+
+void UploadStream::flush() {
+  std::unique_lock lock{mutex_};
+  wait_(lock, 0);
+}
+
+void UploadStream::close() {
+  TIT_ASSERT(!is_closed_, "Upload stream is already closed!");
+  is_closed_ = true;
+  try {
+    // Empty object is uploaded as a single empty part.
+    if (!part_.empty() || num_parts_ == 0) submit_();
+    flush();
+    uploader_->complete(num_parts_);
+  } catch (...) {
+    uploader_->abort();
+    throw;
+  }
+}
+
+auto UploadStream::num_uploaded_parts() const -> size_t {
+  const std::scoped_lock lock{mutex_};
+  return num_uploaded_parts_;
+}
+
+void UploadStream::submit_() {
+  std::unique_lock lock{mutex_};
+  wait_(lock, options_.max_queue_size);
+  queue_.push_back(std::exchange(part_, {}));
+  ++num_parts_;
+  Metrics::set("UploadStream::queue_size",
+               static_cast<float64_t>(queue_.size()));
+  if (!free_.empty()) {
+    part_ = std::move(free_.back());
+    free_.pop_back();
+  }
+  part_.clear();
+  part_.reserve(options_.part_size);
+  cv_.notify_all();
+}
+
+void UploadStream::wait_(std::unique_lock<std::mutex>& lock,
+                         size_t queue_size) {
+  // Part that is currently being uploaded is still in the queue.
+  cv_.wait(lock, [queue_size, this] {
+    return error_ != nullptr || queue_.size() <= queue_size;
+  });
+  // Error is not reset, so that the upload could never be completed.
+  if (error_ != nullptr) std::rethrow_exception(error_);
+}
+
+void UploadStream::run_() {
+  std::unique_lock lock{mutex_};
+  bool failed = false;
+  while (true) {
+    cv_.wait(lock, [this] { return is_stopping_ || !queue_.empty(); });
+    if (queue_.empty()) break;
+
+    // Part stays at the front of the queue until it is uploaded. Once any
+    // part failed, the remaining parts are discarded, since the upload is
+    // going to be aborted anyway.
+    const auto& part = queue_.front();
+    const auto part_index = num_uploaded_parts_;
+    lock.unlock();
+    std::exception_ptr error;
+    if (!failed) {
+      try {
+        uploader_->upload_part(part_index, part);
+      } catch (...) {
+        error = std::current_exception();
+        failed = true;
+      }
+    }
+    lock.lock();
+    if (error != nullptr) {
+      error_ = std::move(error);
+    } else if (!failed) {
+      ++num_uploaded_parts_;
+    }
+    free_.push_back(std::move(queue_.front()));
+    queue_.pop_front();
+    Metrics::set("UploadStream::queue_size",
+                 static_cast<float64_t>(queue_.size()));
+    cv_.notify_all();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void upload_file(const std::filesystem::path& path,
+                 MultipartUploaderPtr uploader,
+                 const UploadOptions& options) {
+  UploadStream stream{std::move(uploader), options};
+  FileInputStream file{path};
+  std::vector<byte_t> buffer(options.part_size);
+  while (true) {
+    const auto count = file.read(buffer);
+    if (count == 0) break;
+    stream.write(std::span{buffer}.first(count));
+  }
+  stream.close();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
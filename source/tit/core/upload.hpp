@@ -0,0 +1,139 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Abstract multipart uploader of a single object, e.g. into an
+/// S3-compatible object storage.
+class MultipartUploader : public VirtualBase {
+public:
+
+  /// Upload the next part of the object. Parts are numbered from zero, and
+  /// are uploaded in order. All the parts except the last one have the same
+  /// size.
+  virtual void upload_part(size_t part_index, std::span<const byte_t> data) = 0;
+
+  /// Assemble the object from the uploaded parts.
+  virtual void complete(size_t num_parts) = 0;
+
+  /// Abort the upload and discard the uploaded parts.
+  virtual void abort() noexcept = 0;
+
+}; // class MultipartUploader
+
+/// Multipart uploader pointer.
+using MultipartUploaderPtr = std::unique_ptr<MultipartUploader>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Upload stream options.
+struct UploadOptions final {
+  /// Size of each uploaded part (in bytes). Object storages typically
+  /// require at least 5 MiB for all the parts except the last one.
+  size_t part_size = 8 * 1024 * 1024;
+
+  /// Maximal number of the filled parts that wait to be uploaded.
+  size_t max_queue_size = 2;
+};
+
+/// Output stream that uploads the bytes in background.
+///
+/// Written bytes are staged in memory until a part is filled, and then the
+/// part is uploaded by a background thread, so that the transfer overlaps
+/// with the computations, and nothing is written to the local disk. At most
+/// `max_queue_size` filled parts may wait to be uploaded: once the queue is
+/// full, writing blocks until the oldest part is uploaded. Hence, at most
+/// `max_queue_size + 2` parts are staged at once: the waiting ones, the one
+/// being uploaded and the one being filled. Part buffers are reused.
+///
+/// Upload is completed either explicitly by `close`, or by the destructor.
+/// If any part fails to upload, or the stream is destroyed during the stack
+/// unwinding, the upload is aborted.
+class UploadStream final : public OutputStream<byte_t> {
+public:
+
+  /// Construct an upload stream.
+  explicit UploadStream(MultipartUploaderPtr uploader,
+                        const UploadOptions& options = {});
+
+  /// Upload stream is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(UploadStream);
+
+  /// Close the stream, if it was not closed yet.
+  ~UploadStream() noexcept override;
+
+  /// Stage the bytes for uploading. Blocks while the queue of the filled
+  /// parts is full.
+  void write(std::span<const byte_t> data) override;
+
+  /// Block until all the filled parts are uploaded. Partially filled part
+  /// is not uploaded until the stream is closed.
+  void flush() override;
+
+  /// Upload the remaining bytes and complete the upload.
+  void close();
+
+  /// Number of parts that were uploaded.
+  auto num_uploaded_parts() const -> size_t;
+
+private:
+
+  void submit_();
+  void wait_(std::unique_lock<std::mutex>& lock, size_t queue_size);
+  void run_();
+
+  MultipartUploaderPtr uploader_;
+  UploadOptions options_;
+  std::vector<byte_t> part_;
+  size_t num_parts_ = 0;
+  bool is_closed_ = false;
+  int num_uncaught_exceptions_ = std::uncaught_exceptions();
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::vector<byte_t>> queue_;
+  std::vector<std::vector<byte_t>> free_;
+  size_t num_uploaded_parts_ = 0;
+  std::exception_ptr error_;
+  bool is_stopping_ = false;
+  std::jthread thread_;
+
+}; // class UploadStream
+
+/// Make an upload stream.
+inline auto make_upload_stream(MultipartUploaderPtr uploader,
+                               const UploadOptions& options = {})
+    -> OutputStreamPtr<byte_t> {
+  return make_flushable<UploadStream>(std::move(uploader), options);
+}
+
+/// Upload the finished file, e.g. a closed storage shard. File is read
+/// while the previous parts are being uploaded.
+void upload_file(const std::filesystem::path& path,
+                 MultipartUploaderPtr uploader,
+                 const UploadOptions& options = {});
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
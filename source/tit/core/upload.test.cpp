@@ -0,0 +1,156 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/upload.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// State of the uploaded object.
+struct Upload final {
+  std::vector<std::vector<byte_t>> parts;
+  size_t num_completed_parts = 0;
+  bool is_completed = false;
+  bool is_aborted = false;
+  size_t fail_at_part = SIZE_MAX;
+};
+
+// Uploader that stores the parts in memory.
+class TestUploader final : public MultipartUploader {
+public:
+
+  explicit TestUploader(Upload& upload) : upload_{&upload} {}
+
+  void upload_part(size_t part_index, std::span<const byte_t> data) override {
+    if (part_index == upload_->fail_at_part) TIT_THROW("Upload failed.");
+    upload_->parts.emplace_back(data.begin(), data.end());
+  }
+
+  void complete(size_t num_parts) override {
+    upload_->num_completed_parts = num_parts;
+    upload_->is_completed = true;
+  }
+
+  void abort() noexcept override {
+    upload_->is_aborted = true;
+  }
+
+private:
+
+  Upload* upload_;
+
+}; // class TestUploader
+
+// Concatenate the uploaded parts.
+auto joined(const Upload& upload) -> std::vector<byte_t> {
+  std::vector<byte_t> result;
+  for (const auto& part : upload.parts) {
+    result.insert(result.end(), part.begin(), part.end());
+  }
+  return result;
+}
+
+// Make the test bytes.
+auto make_bytes(size_t count) -> std::vector<byte_t> {
+  std::vector<byte_t> result(count);
+  for (size_t i = 0; i < count; ++i) result[i] = static_cast<byte_t>(i % 251);
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("UploadStream") {
+  Upload upload;
+  const UploadOptions options{.part_size = 16, .max_queue_size = 1};
+  const auto bytes = make_bytes(100);
+  SUBCASE("close") {
+    UploadStream stream{std::make_unique<TestUploader>(upload), options};
+    stream.write(std::span{bytes}.first(10));
+    stream.write(std::span{bytes}.subspan(10));
+    stream.flush();
+    CHECK(stream.num_uploaded_parts() == 6);
+    CHECK_FALSE(upload.is_completed);
+    stream.close();
+    CHECK(stream.num_uploaded_parts() == 7);
+    REQUIRE(upload.is_completed);
+    CHECK(upload.num_completed_parts == 7);
+    CHECK(upload.parts.front().size() == 16);
+    CHECK(upload.parts.back().size() == 4);
+    CHECK(joined(upload) == bytes);
+  }
+  SUBCASE("destroy") {
+    {
+      const auto stream =
+          make_upload_stream(std::make_unique<TestUploader>(upload), options);
+      stream->write(bytes);
+    }
+    REQUIRE(upload.is_completed);
+    CHECK(joined(upload) == bytes);
+  }
+  SUBCASE("empty") {
+    UploadStream stream{std::make_unique<TestUploader>(upload), options};
+    stream.close();
+    REQUIRE(upload.is_completed);
+    CHECK(upload.num_completed_parts == 1);
+    CHECK(upload.parts.front().empty());
+  }
+  SUBCASE("failure") {
+    // Failure is reported either by the blocked write, or by the close.
+    upload.fail_at_part = 2;
+    {
+      UploadStream stream{std::make_unique<TestUploader>(upload), options};
+      CHECK_THROWS_MSG(
+          [&stream, &bytes] {
+            stream.write(bytes);
+            stream.close();
+          }(),
+          Exception,
+          "Upload failed.");
+    }
+    CHECK(upload.parts.size() == 2);
+    CHECK_FALSE(upload.is_completed);
+    CHECK(upload.is_aborted);
+  }
+  SUBCASE("unwinding") {
+    try {
+      UploadStream stream{std::make_unique<TestUploader>(upload), options};
+      stream.write(bytes);
+      TIT_THROW("Producer failed.");
+    } catch (const Exception&) {} // NOLINT(*-empty-catch)
+    CHECK_FALSE(upload.is_completed);
+    CHECK(upload.is_aborted);
+  }
+}
+
+TEST_CASE("upload_file") {
+  const std::filesystem::path file_name{"test_upload.bin"};
+  const auto bytes = make_bytes(1000);
+  make_file_output_stream(file_name)->write(bytes);
+  Upload upload;
+  upload_file(file_name,
+              std::make_unique<TestUploader>(upload),
+              {.part_size = 64, .max_queue_size = 2});
+  REQUIRE(upload.is_completed);
+  CHECK(upload.num_completed_parts == 16);
+  CHECK(joined(upload) == bytes);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
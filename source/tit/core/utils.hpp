@@ -36,6 +36,12 @@ namespace tit {
 /// Forward a member of a class.
 #define TIT_FORWARD_LIKE(self, member) std::forward_like<decltype(self)>(member)
 
+/// Qualify a pointer as the only one used to access the pointed memory.
+#define TIT_RESTRICT __restrict
+
+/// Hint the processor to load the pointed memory into the cache for reading.
+#define TIT_PREFETCH(ptr) __builtin_prefetch((ptr), /*rw=*/0, /*locality=*/3)
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Predicate that is always true.
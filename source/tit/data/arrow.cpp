@@ -0,0 +1,252 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <format>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/arrow.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto arrow_format(DataKind kind) -> std::string_view {
+  using enum DataKind::ID;
+  switch (kind.id()) {
+    case int8:    return "c";
+    case uint8:   return "C";
+    case int16:   return "s";
+    case uint16:  return "S";
+    case int32:   return "i";
+    case uint32:  return "I";
+    case int64:   return "l";
+    case uint64:  return "L";
+    case float32: return "f";
+    case float64: return "g";
+    default:
+      TIT_THROW("Data kind '{}' has no Arrow counterpart.", kind.name());
+  }
+}
+
+auto arrow_format(DataType type) -> std::string {
+  using enum DataRank;
+  switch (type.rank()) {
+    case scalar: return std::string{arrow_format(type.kind())};
+    case vector:
+    case matrix: return std::format("+w:{}", type.dim());
+    default:     std::unreachable();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Private data of the exported schema node.
+struct SchemaData final {
+  std::string format;
+  std::string name;
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema*> child_ptrs;
+};
+
+// Release the exported schema node and its children that were not moved
+// out by the consumer.
+void release_schema(ArrowSchema* schema) noexcept {
+  TIT_ASSERT(schema != nullptr, "Schema is null!");
+  TIT_ASSERT(schema->release != nullptr, "Schema is already released!");
+  const std::unique_ptr<SchemaData> data{
+      static_cast<SchemaData*>(schema->private_data)};
+  for (auto& child : data->children) {
+    if (child.release != nullptr) child.release(&child);
+  }
+  schema->release = nullptr;
+}
+
+// Initialize the exported schema node.
+auto init_schema(ArrowSchema& schema,
+                 std::string format,
+                 std::string name,
+                 size_t num_children) -> std::span<ArrowSchema> {
+  auto data = std::make_unique<SchemaData>(
+      std::move(format),
+      std::move(name),
+      std::vector<ArrowSchema>(num_children),
+      std::vector<ArrowSchema*>{});
+  for (auto& child : data->children) data->child_ptrs.push_back(&child);
+  schema = {
+      .format = data->format.c_str(),
+      .name = data->name.c_str(),
+      .metadata = nullptr,
+      .flags = 0,
+      .n_children = static_cast<int64_t>(num_children),
+      .children = data->child_ptrs.data(),
+      .dictionary = nullptr,
+      .release = &release_schema,
+      .private_data = data.get(),
+  };
+  return std::span{data.release()->children};
+}
+
+// Export the schema of the column, or of its list items.
+void export_column_schema(ArrowSchema& schema,
+                          std::string name,
+                          DataType type,
+                          size_t num_levels) {
+  if (num_levels == 0) {
+    init_schema(schema,
+                std::string{arrow_format(type.kind())},
+                std::move(name),
+                0);
+    return;
+  }
+  const auto children = init_schema(schema,
+                                     std::format("+w:{}", type.dim()),
+                                     std::move(name),
+                                     1);
+  export_column_schema(children.front(), "item", type, num_levels - 1);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Private data of the exported array node.
+struct ArrayData final {
+  std::shared_ptr<const void> owner;
+  std::array<const void*, 2> buffers;
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray*> child_ptrs;
+};
+
+// Release the exported array node and its children that were not moved out
+// by the consumer.
+void release_array(ArrowArray* array) noexcept {
+  TIT_ASSERT(array != nullptr, "Array is null!");
+  TIT_ASSERT(array->release != nullptr, "Array is already released!");
+  const std::unique_ptr<ArrayData> data{
+      static_cast<ArrayData*>(array->private_data)};
+  for (auto& child : data->children) {
+    if (child.release != nullptr) child.release(&child);
+  }
+  array->release = nullptr;
+}
+
+// Initialize the exported array node. Primitive arrays have the validity
+// and the data buffers, the nested arrays have the validity buffer only.
+// Validity buffers are always null, since there are no nulls.
+auto init_array(ArrowArray& array,
+                size_t length,
+                const byte_t* values,
+                size_t num_children,
+                std::shared_ptr<const void> owner) -> std::span<ArrowArray> {
+  auto data = std::make_unique<ArrayData>(
+      std::move(owner),
+      std::array<const void*, 2>{nullptr, values},
+      std::vector<ArrowArray>(num_children),
+      std::vector<ArrowArray*>{});
+  for (auto& child : data->children) data->child_ptrs.push_back(&child);
+  array = {
+      .length = static_cast<int64_t>(length),
+      .null_count = 0,
+      .offset = 0,
+      .n_buffers = num_children == 0 ? 2 : 1,
+      .n_children = static_cast<int64_t>(num_children),
+      .buffers = data->buffers.data(),
+      .children = data->child_ptrs.data(),
+      .dictionary = nullptr,
+      .release = &release_array,
+      .private_data = data.get(),
+  };
+  return std::span{data.release()->children};
+}
+
+// Export the data of the column, or of its list items.
+void export_column_array(ArrowArray& array,
+                         size_t length,
+                         std::span<const byte_t> data,
+                         size_t dim,
+                         size_t num_levels,
+                         const std::shared_ptr<const void>& owner) {
+  if (num_levels == 0) {
+    init_array(array, length, data.data(), 0, owner);
+    return;
+  }
+  const auto children = init_array(array, length, nullptr, 1, owner);
+  export_column_array(children.front(),
+                      length * dim,
+                      data,
+                      dim,
+                      num_levels - 1,
+                      owner);
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void ArrowRecordBatch::add_column(std::string name,
+                                  DataType type,
+                                  std::span<const byte_t> data,
+                                  std::shared_ptr<const void> owner) {
+  static_cast<void>(arrow_format(type.kind())); // Check if it is supported.
+  if (data.size() % type.width() != 0) {
+    TIT_THROW("Size {} of the column '{}' is not a multiple of {}.",
+              data.size(),
+              name,
+              type.width());
+  }
+  const auto num_rows = data.size() / type.width();
+  if (columns_.empty()) {
+    num_rows_ = num_rows;
+  } else if (num_rows != num_rows_) {
+    TIT_THROW("Column '{}' has {} rows, but the batch has {}.",
+              name,
+              num_rows,
+              num_rows_);
+  }
+  columns_.push_back({.name = std::move(name),
+                      .type = type,
+                      .data = data,
+                      .owner = std::move(owner)});
+}
+
+void ArrowRecordBatch::export_schema(ArrowSchema& schema) const {
+  const auto children = init_schema(schema, "+s", "", columns_.size());
+  for (const auto& [column, child] : std::views::zip(columns_, children)) {
+    export_column_schema(child,
+                         column.name,
+                         column.type,
+                         std::to_underlying(column.type.rank()));
+  }
+}
+
+void ArrowRecordBatch::export_array(ArrowArray& array) const {
+  const auto children =
+      init_array(array, num_rows_, nullptr, columns_.size(), nullptr);
+  for (const auto& [column, child] : std::views::zip(columns_, children)) {
+    export_column_array(child,
+                        num_rows_,
+                        column.data,
+                        column.type.dim(),
+                        std::to_underlying(column.type.rank()),
+                        column.owner);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,174 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Structures of the Arrow C data interface, as they are defined by the Arrow
+// specification. They are guarded the same way as in the Arrow headers, so
+// the both could be included together.
+// NOLINTBEGIN(*)
+extern "C" {
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+} // extern "C"
+// NOLINTEND(*)
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Arrow format string of the primitive values of the data kind.
+/// 128-bit floating point values have no Arrow counterpart.
+auto arrow_format(DataKind kind) -> std::string_view;
+
+/// Arrow format string of the data type. Vectors are the fixed-size lists of
+/// their components, and matrices are the fixed-size lists of their rows.
+auto arrow_format(DataType type) -> std::string;
+
+/// Record batch, that is exported through the Arrow C data interface.
+///
+/// Batch is a struct array with one non-nullable column per data array, see
+/// `arrow_format` for the column types. Columns are exported without
+/// copying: the exported arrays reference the column data, and keep the
+/// owners of the data alive until they are released by the consumer, so
+/// they may outlive the batch.
+class ArrowRecordBatch final {
+public:
+
+  /// Construct an empty record batch.
+  ArrowRecordBatch() = default;
+
+  /// Number of the rows. Zero if there are no columns.
+  auto num_rows() const noexcept -> size_t {
+    return num_rows_;
+  }
+
+  /// Number of the columns.
+  auto num_columns() const noexcept -> size_t {
+    return columns_.size();
+  }
+
+  /// Add a column over the serialized values. All the columns must have the
+  /// same number of the values.
+  ///
+  /// @param owner Object that owns the data. If it is null, the data must
+  ///              stay valid until the exported arrays are released.
+  void add_column(std::string name,
+                  DataType type,
+                  std::span<const byte_t> data,
+                  std::shared_ptr<const void> owner = nullptr);
+
+  /// Add a column over the values. Contiguous ranges of the mappable values
+  /// are referenced as they are, like with the serialized values, the other
+  /// ranges are serialized into a buffer owned by the batch.
+  template<std::ranges::input_range Vals>
+    requires known_type_of<std::ranges::range_value_t<Vals>>
+  void add_column(std::string name,
+                  Vals&& vals,
+                  std::shared_ptr<const void> owner = nullptr) {
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    using Val = std::ranges::range_value_t<Vals>;
+    if constexpr (std::ranges::contiguous_range<Vals> &&
+                  std::ranges::sized_range<Vals> && mappable_type_of<Val>) {
+      add_column(std::move(name),
+                 type_of<Val>,
+                 std::as_bytes(std::span{std::ranges::data(vals),
+                                         std::ranges::size(vals)}),
+                 std::move(owner));
+    } else {
+      auto data = std::make_shared<std::vector<byte_t>>();
+      write_values(make_container_output_stream(*data), vals);
+      const std::span<const byte_t> bytes{*data};
+      add_column(std::move(name), type_of<Val>, bytes, std::move(data));
+    }
+  }
+
+  /// Export the schema of the batch into the uninitialized structure.
+  void export_schema(ArrowSchema& schema) const;
+
+  /// Export the data of the batch into the uninitialized structure.
+  void export_array(ArrowArray& array) const;
+
+private:
+
+  struct Column_ final {
+    std::string name;
+    DataType type;
+    std::span<const byte_t> data;
+    std::shared_ptr<const void> owner;
+  };
+
+  size_t num_rows_ = 0;
+  std::vector<Column_> columns_;
+
+}; // class ArrowRecordBatch
+
+/// Export the data arrays of the dataset as a record batch. Externally
+/// stored data arrays are mapped into memory, the other ones are decoded.
+template<data_storage Storage>
+auto arrow_record_batch(DataSetView<Storage> dataset) -> ArrowRecordBatch {
+  ArrowRecordBatch batch;
+  for (const auto& [name, array] : dataset.arrays()) {
+    if (array.is_external()) {
+      auto mapped = std::make_shared<MappedArrayData<byte_t>>(array.map());
+      const auto data = mapped->data();
+      batch.add_column(name, array.type(), data, std::move(mapped));
+    } else {
+      auto decoded = std::make_shared<std::vector<byte_t>>(array.data());
+      const std::span<const byte_t> data{*decoded};
+      batch.add_column(name, array.type(), data, std::move(decoded));
+    }
+  }
+  return batch;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,129 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/arrow.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::arrow_format") {
+  CHECK(data::arrow_format(data::kind_of<int32_t>) == "i");
+  CHECK(data::arrow_format(data::kind_of<uint64_t>) == "L");
+  CHECK(data::arrow_format(data::kind_of<float32_t>) == "f");
+  CHECK(data::arrow_format(data::type_of<float64_t>) == "g");
+  CHECK(data::arrow_format(data::type_of<Vec<float64_t, 3>>) == "+w:3");
+  CHECK(data::arrow_format(data::type_of<Mat<float64_t, 2>>) == "+w:2");
+  CHECK_THROWS_MSG(data::arrow_format(
+                       data::DataKind{data::DataKind::ID::float128}),
+                   Exception,
+                   "has no Arrow counterpart");
+}
+
+TEST_CASE("data::ArrowRecordBatch") {
+  auto rho = std::make_shared<std::vector<float64_t>>(
+      std::vector{1000.0, 1001.0, 1002.0});
+  const std::vector r{Vec{0.0, 1.0}, Vec{2.0, 3.0}, Vec{4.0, 5.0}};
+  const std::weak_ptr<std::vector<float64_t>> rho_owner = rho;
+
+  data::ArrowRecordBatch batch;
+  batch.add_column("rho", *rho, rho);
+  batch.add_column("r", r);
+  rho.reset();
+  REQUIRE(batch.num_rows() == 3);
+  REQUIRE(batch.num_columns() == 2);
+  CHECK_THROWS_MSG(batch.add_column("p", std::vector{1.0, 2.0}),
+                   Exception,
+                   "Column 'p' has 2 rows, but the batch has 3.");
+
+  SUBCASE("schema") {
+    ArrowSchema schema{};
+    batch.export_schema(schema);
+    CHECK(std::string_view{schema.format} == "+s");
+    REQUIRE(schema.n_children == 2);
+    const auto& rho_schema = *schema.children[0];
+    CHECK(std::string_view{rho_schema.name} == "rho");
+    CHECK(std::string_view{rho_schema.format} == "g");
+    CHECK(rho_schema.n_children == 0);
+    const auto& r_schema = *schema.children[1];
+    CHECK(std::string_view{r_schema.name} == "r");
+    CHECK(std::string_view{r_schema.format} == "+w:2");
+    REQUIRE(r_schema.n_children == 1);
+    CHECK(std::string_view{r_schema.children[0]->format} == "g");
+    schema.release(&schema);
+    CHECK(schema.release == nullptr);
+  }
+
+  SUBCASE("array") {
+    ArrowArray array{};
+    batch.export_array(array);
+    CHECK(array.length == 3);
+    REQUIRE(array.n_children == 2);
+
+    // Columns reference the values without copying.
+    const auto& rho_array = *array.children[0];
+    CHECK(rho_array.length == 3);
+    CHECK(rho_array.null_count == 0);
+    REQUIRE(rho_array.n_buffers == 2);
+    CHECK(rho_array.buffers[0] == nullptr);
+    CHECK(static_cast<const float64_t*>(rho_array.buffers[1])[2] == 1002.0);
+    const auto& r_array = *array.children[1];
+    CHECK(r_array.length == 3);
+    REQUIRE(r_array.n_children == 1);
+    CHECK(r_array.children[0]->length == 6);
+    CHECK(r_array.children[0]->buffers[1] == r.data());
+
+    // Consumer may move the column out of the batch, and release it later.
+    auto rho_column = std::exchange(*array.children[0], {});
+    array.release(&array);
+    CHECK(array.release == nullptr);
+    CHECK_FALSE(rho_owner.expired());
+    rho_column.release(&rho_column);
+  }
+
+  // Exported arrays keep the column owners alive, but not the batch.
+  batch = {};
+  CHECK(rho_owner.expired());
+}
+
+TEST_CASE("data::arrow_record_batch") {
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  const auto time_step = series.create_time_step(0.0);
+  time_step.varyings().create_array("rho", std::vector{1.0, 2.0});
+  time_step.varyings().create_array("v",
+                                    std::vector{Vec{1.0, 2.0}, Vec{3.0, 4.0}});
+
+  const auto batch = data::arrow_record_batch(time_step.varyings());
+  REQUIRE(batch.num_rows() == 2);
+  REQUIRE(batch.num_columns() == 2);
+  ArrowArray array{};
+  batch.export_array(array);
+  REQUIRE(array.n_children == 2);
+  const auto& v_values = *array.children[1]->children[0];
+  REQUIRE(v_values.length == 4);
+  CHECK(static_cast<const float64_t*>(v_values.buffers[1])[3] == 4.0);
+  array.release(&array);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
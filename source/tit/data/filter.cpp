@@ -0,0 +1,307 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <span>
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Shuffle or unshuffle the bytes of the items in a block. Trailing bytes that
+// do not form a complete item are copied as is.
+void shuffle_block(std::span<const byte_t> in,
+                   std::span<byte_t> out,
+                   size_t item_width,
+                   bool unshuffle) {
+  TIT_ASSERT(in.size() == out.size(), "Block sizes must match!");
+  const auto num_items = in.size() / item_width;
+  for (size_t i = 0; i < num_items; ++i) {
+    for (size_t j = 0; j < item_width; ++j) {
+      const auto item_index = i * item_width + j;
+      const auto plane_index = j * num_items + i;
+      if (unshuffle) {
+        out[item_index] = in[plane_index];
+      } else {
+        out[plane_index] = in[item_index];
+      }
+    }
+  }
+  const auto tail = num_items * item_width;
+  std::ranges::copy(in.subspan(tail), out.subspan(tail).begin());
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+ShuffleOutputStream::ShuffleOutputStream(OutputStreamPtr<byte_t> stream,
+                                         size_t item_width)
+    : stream_{std::move(stream)}, item_width_{item_width} {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  TIT_ASSERT(item_width_ > 0, "Item width must be positive!");
+}
+
+void ShuffleOutputStream::write(std::span<const byte_t> data) {
+  // Prepare the buffer.
+  const auto block_size = block_num_items * item_width_;
+  if (in_buffer_.capacity() == 0) in_buffer_.reserve(block_size);
+
+  // Copy the data into the buffer, and shuffle the complete blocks.
+  for (size_t copied = 0; !data.empty(); data = data.subspan(copied)) {
+    copied = std::min(block_size - in_buffer_.size(), data.size());
+    std::copy_n(data.begin(), copied, std::back_inserter(in_buffer_));
+    if (in_buffer_.size() == block_size) {
+      flush();
+      TIT_ASSERT(in_buffer_.empty(), "Buffer must be empty after flushing!");
+    }
+  }
+}
+
+void ShuffleOutputStream::flush() {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  if (!in_buffer_.empty()) {
+    out_buffer_.resize(in_buffer_.size());
+    shuffle_block(in_buffer_, out_buffer_, item_width_, /*unshuffle=*/false);
+    stream_->write(out_buffer_);
+    in_buffer_.clear();
+  }
+  stream_->flush();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+UnshuffleInputStream::UnshuffleInputStream(InputStreamPtr<byte_t> stream,
+                                           size_t item_width)
+    : stream_{std::move(stream)}, item_width_{item_width} {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  TIT_ASSERT(item_width_ > 0, "Item width must be positive!");
+}
+
+auto UnshuffleInputStream::read(std::span<byte_t> data) -> size_t {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  const auto block_size = ShuffleOutputStream::block_num_items * item_width_;
+
+  size_t total_copied = 0;
+  for (size_t copied = 0; !data.empty(); data = data.subspan(copied)) {
+    // If the output buffer is exhausted, read and unshuffle the next block.
+    // The underlying stream may return less data than requested, so we keep
+    // reading until the block is complete or the stream is exhausted.
+    if (out_offset_ == out_buffer_.size()) {
+      in_buffer_.resize(block_size);
+      size_t block_read = 0;
+      while (block_read < block_size) {
+        const auto num_read =
+            stream_->read(std::span{in_buffer_}.subspan(block_read));
+        if (num_read == 0) break;
+        block_read += num_read;
+      }
+      if (block_read == 0) break; // Input stream is exhausted.
+      in_buffer_.resize(block_read);
+      out_buffer_.resize(block_read);
+      shuffle_block(in_buffer_, out_buffer_, item_width_, /*unshuffle=*/true);
+      out_offset_ = 0;
+    }
+
+    // Copy what we have in the output buffer.
+    TIT_ASSERT(out_offset_ <= out_buffer_.size(), "Offset is out of range!");
+    copied = std::min(out_buffer_.size() - out_offset_, data.size());
+    std::copy_n(out_buffer_.begin() + static_cast<ssize_t>(out_offset_),
+                copied,
+                data.begin());
+    total_copied += copied;
+    out_offset_ += copied;
+  }
+
+  return total_copied;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Number of values that are quantized or restored at once.
+constexpr size_t quantize_chunk_num_items = 8 * 1024;
+
+// Quantized values must fit into 64-bit integers with some margin.
+constexpr float64_t max_quantized = 0x1p62;
+
+// Check the quantization parameters.
+void check_quantization(DataKind kind, float64_t tolerance) {
+  using enum DataKind::ID;
+  if (kind.id() != float32 && kind.id() != float64) {
+    TIT_THROW("Only floating point data can be quantized, got '{}'.",
+              kind.name());
+  }
+  if (!(tolerance > 0.0)) {
+    TIT_THROW("Quantization tolerance must be positive, got {}.", tolerance);
+  }
+}
+
+// Quantize the values.
+template<class Float>
+void quantize_items(std::span<const byte_t> in,
+                    std::span<byte_t> out,
+                    float64_t step) {
+  const auto num_items = in.size() / sizeof(Float);
+  TIT_ASSERT(out.size() == num_items * sizeof(int64_t), "Size mismatch!");
+  for (size_t i = 0; i < num_items; ++i) {
+    const auto value = static_cast<float64_t>(
+        from_bytes<Float>(in.subspan(i * sizeof(Float), sizeof(Float))));
+    const auto scaled = value / step;
+    if (!(std::abs(scaled) < max_quantized)) {
+      TIT_THROW("Value {} cannot be quantized with tolerance {}.",
+                value,
+                step / 2);
+    }
+    const auto quantized = static_cast<int64_t>(std::round(scaled));
+    std::ranges::copy(to_byte_array(quantized),
+                      out.subspan(i * sizeof(int64_t)).begin());
+  }
+}
+
+// Restore the quantized values.
+template<class Float>
+void dequantize_items(std::span<const byte_t> in,
+                      std::span<byte_t> out,
+                      float64_t step) {
+  const auto num_items = in.size() / sizeof(int64_t);
+  TIT_ASSERT(out.size() == num_items * sizeof(Float), "Size mismatch!");
+  for (size_t i = 0; i < num_items; ++i) {
+    const auto quantized = from_bytes<int64_t>(
+        in.subspan(i * sizeof(int64_t), sizeof(int64_t)));
+    const auto value =
+        static_cast<Float>(static_cast<float64_t>(quantized) * step);
+    std::ranges::copy(to_byte_array(value),
+                      out.subspan(i * sizeof(Float)).begin());
+  }
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+QuantizeOutputStream::QuantizeOutputStream(OutputStreamPtr<byte_t> stream,
+                                           DataKind kind,
+                                           float64_t tolerance)
+    : stream_{std::move(stream)}, kind_{kind}, step_{2 * tolerance} {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  check_quantization(kind_, tolerance);
+}
+
+void QuantizeOutputStream::write(std::span<const byte_t> data) {
+  const auto item_width = kind_.width();
+
+  // Complete the item that was split between the writes.
+  if (!partial_item_.empty()) {
+    const auto copied =
+        std::min(item_width - partial_item_.size(), data.size());
+    std::copy_n(data.begin(), copied, std::back_inserter(partial_item_));
+    data = data.subspan(copied);
+    if (partial_item_.size() < item_width) return;
+    quantize_(partial_item_);
+    partial_item_.clear();
+  }
+
+  // Quantize the complete items in chunks, and keep the remainder.
+  const auto chunk_size = quantize_chunk_num_items * item_width;
+  while (data.size() >= item_width) {
+    const auto num_items = data.size() / item_width;
+    const auto size = std::min(chunk_size, num_items * item_width);
+    quantize_(data.first(size));
+    data = data.subspan(size);
+  }
+  std::ranges::copy(data, std::back_inserter(partial_item_));
+}
+
+void QuantizeOutputStream::flush() {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  if (!partial_item_.empty()) {
+    TIT_THROW("Quantization failed: incomplete value.");
+  }
+  stream_->flush();
+}
+
+void QuantizeOutputStream::quantize_(std::span<const byte_t> data) {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  out_buffer_.resize(data.size() / kind_.width() * sizeof(int64_t));
+  if (kind_.id() == DataKind::ID::float32) {
+    quantize_items<float32_t>(data, out_buffer_, step_);
+  } else {
+    quantize_items<float64_t>(data, out_buffer_, step_);
+  }
+  stream_->write(out_buffer_);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DequantizeInputStream::DequantizeInputStream(InputStreamPtr<byte_t> stream,
+                                             DataKind kind,
+                                             float64_t tolerance)
+    : stream_{std::move(stream)}, kind_{kind}, step_{2 * tolerance} {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  check_quantization(kind_, tolerance);
+}
+
+auto DequantizeInputStream::read(std::span<byte_t> data) -> size_t {
+  TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  const auto chunk_size = quantize_chunk_num_items * sizeof(int64_t);
+
+  size_t total_copied = 0;
+  for (size_t copied = 0; !data.empty(); data = data.subspan(copied)) {
+    // If the output buffer is exhausted, read and restore the next chunk.
+    if (out_offset_ == out_buffer_.size()) {
+      in_buffer_.resize(chunk_size);
+      size_t chunk_read = 0;
+      while (chunk_read < chunk_size) {
+        const auto num_read =
+            stream_->read(std::span{in_buffer_}.subspan(chunk_read));
+        if (num_read == 0) break;
+        chunk_read += num_read;
+      }
+      if (chunk_read == 0) break; // Input stream is exhausted.
+      if (chunk_read % sizeof(int64_t) != 0) {
+        TIT_THROW("Dequantization failed: truncated stream.");
+      }
+      in_buffer_.resize(chunk_read);
+      out_buffer_.resize(chunk_read / sizeof(int64_t) * kind_.width());
+      if (kind_.id() == DataKind::ID::float32) {
+        dequantize_items<float32_t>(in_buffer_, out_buffer_, step_);
+      } else {
+        dequantize_items<float64_t>(in_buffer_, out_buffer_, step_);
+      }
+      out_offset_ = 0;
+    }
+
+    // Copy what we have in the output buffer.
+    TIT_ASSERT(out_offset_ <= out_buffer_.size(), "Offset is out of range!");
+    copied = std::min(out_buffer_.size() - out_offset_, data.size());
+    std::copy_n(out_buffer_.begin() + static_cast<ssize_t>(out_offset_),
+                copied,
+                data.begin());
+    total_copied += copied;
+    out_offset_ += copied;
+  }
+
+  return total_copied;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
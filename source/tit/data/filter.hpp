@@ -0,0 +1,191 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Filter that is applied to the data array before it is compressed.
+enum class DataFilter : uint8_t {
+  /// Data is compressed as is.
+  none = 0,
+
+  /// Byte shuffle: bytes of the same significance of the consecutive items
+  /// are grouped together. Exponent and high mantissa bytes of the floating
+  /// point values vary slowly, so the shuffled data compresses much better.
+  shuffle = 1,
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Stream that shuffles the bytes of the items in blocks and writes them to
+/// the underlying output stream.
+///
+/// Flushing completes the current block, so the stream shall be flushed only
+/// once all the data is written.
+class ShuffleOutputStream final : public OutputStream<byte_t> {
+public:
+
+  /// Number of items in a shuffled block.
+  static constexpr size_t block_num_items = 16 * 1024;
+
+  /// Construct a shuffle output stream.
+  ///
+  /// @param item_width Width of a single item (in bytes).
+  ShuffleOutputStream(OutputStreamPtr<byte_t> stream, size_t item_width);
+
+  /// Shuffle the data and write it to the underlying stream.
+  void write(std::span<const byte_t> data) override;
+
+  /// Flush the stream.
+  void flush() override;
+
+private:
+
+  OutputStreamPtr<byte_t> stream_;
+  size_t item_width_;
+  std::vector<byte_t> in_buffer_;
+  std::vector<byte_t> out_buffer_;
+
+}; // class ShuffleOutputStream
+
+/// Make a shuffle output stream.
+inline auto make_shuffle_output_stream(OutputStreamPtr<byte_t> stream,
+                                       size_t item_width)
+    -> OutputStreamPtr<byte_t> {
+  return make_flushable<ShuffleOutputStream>(std::move(stream), item_width);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Stream that reads the data shuffled by `ShuffleOutputStream` from the
+/// underlying input stream and unshuffles it.
+class UnshuffleInputStream final : public InputStream<byte_t> {
+public:
+
+  /// Construct an unshuffle input stream.
+  ///
+  /// @param item_width Width of a single item (in bytes).
+  UnshuffleInputStream(InputStreamPtr<byte_t> stream, size_t item_width);
+
+  /// Read and unshuffle the data.
+  auto read(std::span<byte_t> data) -> size_t override;
+
+private:
+
+  InputStreamPtr<byte_t> stream_;
+  size_t item_width_;
+  std::vector<byte_t> in_buffer_;
+  std::vector<byte_t> out_buffer_;
+  size_t out_offset_ = 0;
+
+}; // class UnshuffleInputStream
+
+/// Make an unshuffle input stream.
+inline auto make_unshuffle_input_stream(InputStreamPtr<byte_t> stream,
+                                        size_t item_width)
+    -> InputStreamPtr<byte_t> {
+  return std::make_unique<UnshuffleInputStream>(std::move(stream), item_width);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Stream that quantizes the floating point values to the multiples of the
+/// doubled tolerance, and writes the quantized values to the underlying
+/// output stream as 64-bit integers. Absolute error of the restored values
+/// does not exceed the tolerance (up to the floating point rounding).
+class QuantizeOutputStream final : public OutputStream<byte_t> {
+public:
+
+  /// Construct a quantize output stream.
+  ///
+  /// @param kind      Kind of the values, either `float32` or `float64`.
+  /// @param tolerance Absolute error tolerance, must be positive.
+  QuantizeOutputStream(OutputStreamPtr<byte_t> stream,
+                       DataKind kind,
+                       float64_t tolerance);
+
+  /// Quantize the data and write it to the underlying stream.
+  void write(std::span<const byte_t> data) override;
+
+  /// Flush the stream.
+  void flush() override;
+
+private:
+
+  void quantize_(std::span<const byte_t> data);
+
+  OutputStreamPtr<byte_t> stream_;
+  DataKind kind_;
+  float64_t step_;
+  std::vector<byte_t> partial_item_;
+  std::vector<byte_t> out_buffer_;
+
+}; // class QuantizeOutputStream
+
+/// Make a quantize output stream.
+inline auto make_quantize_output_stream(OutputStreamPtr<byte_t> stream,
+                                        DataKind kind,
+                                        float64_t tolerance)
+    -> OutputStreamPtr<byte_t> {
+  return make_flushable<QuantizeOutputStream>(std::move(stream),
+                                              kind,
+                                              tolerance);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Stream that reads the values quantized by `QuantizeOutputStream` from
+/// the underlying input stream and restores them.
+class DequantizeInputStream final : public InputStream<byte_t> {
+public:
+
+  /// Construct a dequantize input stream.
+  ///
+  /// @param kind      Kind of the values, either `float32` or `float64`.
+  /// @param tolerance Absolute error tolerance the values were quantized with.
+  DequantizeInputStream(InputStreamPtr<byte_t> stream,
+                        DataKind kind,
+                        float64_t tolerance);
+
+  /// Read and restore the data.
+  auto read(std::span<byte_t> data) -> size_t override;
+
+private:
+
+  InputStreamPtr<byte_t> stream_;
+  DataKind kind_;
+  float64_t step_;
+  std::vector<byte_t> in_buffer_;
+  std::vector<byte_t> out_buffer_;
+  size_t out_offset_ = 0;
+
+}; // class DequantizeInputStream
+
+/// Make a dequantize input stream.
+inline auto make_dequantize_input_stream(InputStreamPtr<byte_t> stream,
+                                         DataKind kind,
+                                         float64_t tolerance)
+    -> InputStreamPtr<byte_t> {
+  return std::make_unique<DequantizeInputStream>(std::move(stream),
+                                                 kind,
+                                                 tolerance);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,184 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+using data::make_dequantize_input_stream;
+using data::make_quantize_output_stream;
+using data::make_shuffle_output_stream;
+using data::make_unshuffle_input_stream;
+using data::ShuffleOutputStream;
+
+template<class... Vals>
+auto bytes(Vals... vals) -> std::vector<byte_t> {
+  return {static_cast<byte_t>(vals)...};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::ShuffleOutputStream") {
+  // Three items of width 4, and two trailing bytes.
+  const auto data = bytes(0x00, 0x01, 0x02, 0x03, //
+                          0x10, 0x11, 0x12, 0x13, //
+                          0x20, 0x21, 0x22, 0x23, //
+                          0x30, 0x31);
+  std::vector<byte_t> shuffled_data;
+  make_shuffle_output_stream(make_container_output_stream(shuffled_data),
+                             /*item_width=*/4)
+      ->write(data);
+  CHECK_RANGE_EQ(shuffled_data,
+                 bytes(0x00, 0x10, 0x20, //
+                       0x01, 0x11, 0x21, //
+                       0x02, 0x12, 0x22, //
+                       0x03, 0x13, 0x23, //
+                       0x30, 0x31));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::UnshuffleInputStream") {
+  const auto run_test = [](size_t item_width, size_t size) {
+    const auto data =
+        std::views::iota(0UZ, size) |
+        std::views::transform(
+            [](size_t i) { return static_cast<byte_t>(i % 251); }) |
+        std::ranges::to<std::vector>();
+
+    // Write in chunks to make sure the blocks are assembled correctly.
+    std::vector<byte_t> shuffled_data;
+    auto shuffler = make_shuffle_output_stream(
+        make_container_output_stream(shuffled_data),
+        item_width);
+    for (const auto chunk : data | std::views::chunk(1000)) {
+      shuffler->write(chunk);
+    }
+    shuffler->flush();
+    REQUIRE(shuffled_data.size() == data.size());
+
+    // Read in chunks that do not match the block size.
+    std::vector<byte_t> unshuffled_data(data.size() + 1);
+    auto unshuffler = make_unshuffle_input_stream(
+        make_range_input_stream(shuffled_data),
+        item_width);
+    size_t offset = 0;
+    while (true) {
+      const auto chunk =
+          std::span{unshuffled_data}.subspan(offset).first(
+              std::min(777UZ, unshuffled_data.size() - offset));
+      const auto copied = unshuffler->read(chunk);
+      if (copied == 0) break;
+      offset += copied;
+    }
+    REQUIRE(offset == data.size());
+    unshuffled_data.resize(offset);
+    CHECK_RANGE_EQ(unshuffled_data, data);
+  };
+
+  constexpr auto large_size = 3 * ShuffleOutputStream::block_num_items * 8;
+  SUBCASE("single byte") {
+    run_test(1, large_size + 5);
+  }
+  SUBCASE("uneven width") {
+    run_test(3, large_size + 5);
+  }
+  SUBCASE("double") {
+    run_test(8, large_size + 5);
+  }
+  SUBCASE("small") {
+    run_test(8, 13);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::QuantizeOutputStream") {
+  constexpr float64_t tolerance = 1.0e-3;
+  const auto run_test = []<class Float>(std::type_identity<Float> /*type*/) {
+    const auto values =
+        std::views::iota(0, 50000) | std::views::transform([](int i) {
+          return static_cast<Float>(std::sin(0.001 * i) * 100.0);
+        }) |
+        std::ranges::to<std::vector>();
+    std::vector<byte_t> quantized_data;
+    make_stream_serializer<Float>(make_quantize_output_stream(
+                                      make_container_output_stream(
+                                          quantized_data),
+                                      data::kind_of<Float>,
+                                      tolerance))
+        ->write(values);
+    REQUIRE(quantized_data.size() == values.size() * sizeof(int64_t));
+
+    std::vector<Float> restored_values(values.size() + 1);
+    auto dequantizer = make_stream_deserializer<Float>(
+        make_dequantize_input_stream(make_range_input_stream(quantized_data),
+                                     data::kind_of<Float>,
+                                     tolerance));
+    REQUIRE(dequantizer->read(restored_values) == values.size());
+    restored_values.pop_back();
+    // Restored values are additionally rounded to the value type.
+    const auto max_error =
+        tolerance + 100.0 * std::numeric_limits<Float>::epsilon();
+    for (const auto& [value, restored] :
+         std::views::zip(values, restored_values)) {
+      CHECK(std::abs(value - restored) <= max_error);
+    }
+  };
+  SUBCASE("float32") {
+    run_test(std::type_identity<float32_t>{});
+  }
+  SUBCASE("float64") {
+    run_test(std::type_identity<float64_t>{});
+  }
+  SUBCASE("errors") {
+    std::vector<byte_t> quantized_data;
+    CHECK_THROWS_MSG(
+        make_quantize_output_stream(
+            make_container_output_stream(quantized_data),
+            data::kind_of<int32_t>,
+            tolerance),
+        Exception,
+        "Only floating point data can be quantized, got 'int32_t'.");
+    CHECK_THROWS_MSG(
+        make_quantize_output_stream(
+            make_container_output_stream(quantized_data),
+            data::kind_of<float64_t>,
+            0.0),
+        Exception,
+        "Quantization tolerance must be positive, got 0.");
+    auto quantizer = make_quantize_output_stream(
+        make_container_output_stream(quantized_data),
+        data::kind_of<float64_t>,
+        tolerance);
+    CHECK_THROWS_MSG(
+        quantizer->write(to_byte_array(std::numeric_limits<float64_t>::max())),
+        Exception,
+        "cannot be quantized");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,163 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/live.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+#include "tit/data/zstd.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Encode the data array into the live frame.
+void encode_live_array(OutputStream<byte_t>& out,
+                       const DataArraySnapshot& array,
+                       bool is_varying,
+                       const LiveFrameOptions& options) {
+  const auto kind = array.type.kind();
+  const auto width = array.type.width();
+  const auto is_float = kind.id() == DataKind::ID::float32 ||
+                        kind.id() == DataKind::ID::float64;
+  const auto tol = is_float ? options.tolerance : 0.0;
+  const auto stride = is_varying ? options.stride : 1;
+  const auto num_items = array.data.size() / width;
+  const auto first = is_varying ? std::min(options.first, num_items) : 0;
+  const auto last =
+      is_varying ? first + std::min(options.count, num_items - first)
+                 : num_items;
+  const auto num_encoded = (last - first + stride - 1) / stride;
+
+  // Compress the decimated items, just like the data storage does.
+  std::vector<byte_t> data;
+  {
+    auto stream = zstd::make_stream_compressor(
+        make_container_output_stream(data),
+        options.compression);
+    stream = make_shuffle_output_stream(std::move(stream),
+                                        tol > 0.0 ? sizeof(int64_t) : width);
+    if (tol > 0.0) {
+      stream = make_quantize_output_stream(std::move(stream), kind, tol);
+    }
+    const auto items =
+        std::span{array.data}.subspan(first * width, (last - first) * width);
+    if (stride == 1) {
+      stream->write(items);
+    } else {
+      for (size_t i = 0; i < last - first; i += stride) {
+        stream->write(items.subspan(i * width, width));
+      }
+    }
+  }
+
+  serialize(out, static_cast<uint8_t>(is_varying));
+  serialize(out, array.type.id());
+  serialize(out, tol);
+  serialize(out, static_cast<uint64_t>(num_items));
+  serialize(out, static_cast<uint64_t>(num_encoded));
+  serialize(out, static_cast<uint32_t>(array.name.size()));
+  out.write(std::as_bytes(std::span{array.name}));
+  serialize(out, static_cast<uint64_t>(data.size()));
+  out.write(data);
+}
+
+} // namespace
+
+auto encode_live_frame(const DataTimeStepSnapshot& snapshot,
+                       const LiveFrameOptions& options)
+    -> std::vector<byte_t> {
+  TIT_ASSERT(options.stride > 0, "Stride must be positive!");
+  TIT_ASSERT(options.tolerance >= 0.0, "Tolerance must be non-negative!");
+  const auto is_selected = [&options](const DataArraySnapshot& array) {
+    return options.arrays.empty() ||
+           std::ranges::contains(options.arrays, array.name);
+  };
+  const auto num_arrays =
+      std::ranges::count_if(snapshot.uniforms().arrays(), is_selected) +
+      std::ranges::count_if(snapshot.varyings().arrays(), is_selected);
+
+  std::vector<byte_t> frame;
+  const auto out = make_container_output_stream(frame);
+  serialize(*out, static_cast<float64_t>(snapshot.time()));
+  serialize(*out, static_cast<uint32_t>(num_arrays));
+  for (const auto& array :
+       snapshot.uniforms().arrays() | std::views::filter(is_selected)) {
+    encode_live_array(*out, array, /*is_varying=*/false, options);
+  }
+  for (const auto& array :
+       snapshot.varyings().arrays() | std::views::filter(is_selected)) {
+    encode_live_array(*out, array, /*is_varying=*/true, options);
+  }
+  return frame;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto LiveChannel::subscribe(float64_t rate) -> size_t {
+  TIT_ASSERT(rate > 0.0, "Frame rate must be positive!");
+  const std::scoped_lock lock{mutex_};
+  const auto viewer_id = next_viewer_id_++;
+  periods_[viewer_id] = std::chrono::duration_cast<Clock_::duration>(
+      std::chrono::duration<float64_t>{1.0 / rate});
+  return viewer_id;
+}
+
+void LiveChannel::unsubscribe(size_t viewer_id) {
+  const std::scoped_lock lock{mutex_};
+  periods_.erase(viewer_id);
+}
+
+auto LiveChannel::is_wanted() const -> bool {
+  const std::scoped_lock lock{mutex_};
+  if (periods_.empty()) return false;
+  const auto min_period = std::ranges::min(periods_ | std::views::values);
+  return latest_index_ == 0 || Clock_::now() - last_submit_time_ >= min_period;
+}
+
+auto LiveChannel::acquire(real_t time) -> DataTimeStepSnapshotPtr {
+  auto snapshot = std::make_unique<DataTimeStepSnapshot>();
+  snapshot->reset(time);
+  return snapshot;
+}
+
+void LiveChannel::submit(DataTimeStepSnapshotPtr snapshot) {
+  TIT_ASSERT(snapshot != nullptr, "Snapshot must not be null!");
+  const std::scoped_lock lock{mutex_};
+  last_submit_time_ = Clock_::now();
+  latest_index_ += 1;
+  latest_ = std::move(snapshot);
+}
+
+auto LiveChannel::latest() const
+    -> std::pair<size_t, std::shared_ptr<const DataTimeStepSnapshot>> {
+  const std::scoped_lock lock{mutex_};
+  return {latest_index_, latest_};
+}
+
+auto live_channel() -> LiveChannel& {
+  static LiveChannel channel;
+  return channel;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,129 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/writer.hpp"
+#include "tit/data/zstd.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Live frame encoding options.
+struct LiveFrameOptions final {
+  /// Names of the arrays to encode. Empty list selects all the arrays.
+  std::vector<std::string> arrays;
+
+  /// Index of the first encoded item of the varying arrays.
+  size_t first = 0;
+
+  /// Maximal number of the varying array items to encode, starting from
+  /// `first`, before the decimation. If the items are stored in the
+  /// level-of-detail order, the consecutive ranges progressively refine the
+  /// leading one.
+  size_t count = npos;
+
+  /// Decimation stride: only every `stride`-th item of the varying arrays
+  /// is encoded.
+  size_t stride = 1;
+
+  /// Absolute error tolerance of the floating point values. Zero means that
+  /// the values are encoded losslessly.
+  float64_t tolerance = 0.0;
+
+  /// Compression options.
+  zstd::CompressionOptions compression{.level = 1};
+};
+
+/// Encode the time step snapshot into a live frame.
+///
+/// Frame consists of the time step time (`float64_t`) and the number of the
+/// arrays (`uint32_t`), followed by the arrays. Each array consists of:
+/// - dataset (`uint8_t`): zero for the uniform and one for the varying data;
+/// - data type identifier (`uint32_t`), see `DataType::id`;
+/// - tolerance (`float64_t`), zero if the array is encoded losslessly;
+/// - total number of the items in the array (`uint64_t`);
+/// - number of the encoded items (`uint64_t`);
+/// - name size (`uint32_t`), followed by the name;
+/// - data size (`uint64_t`), followed by the data.
+///
+/// Array data is a ZSTD frame of the byte-shuffled values, in the same way as
+/// in the data storage. Lossy encoded values are stored as 64-bit integer
+/// multiples of the doubled tolerance. All numbers are in the native byte
+/// order.
+auto encode_live_frame(const DataTimeStepSnapshot& snapshot,
+                       const LiveFrameOptions& options = {})
+    -> std::vector<byte_t>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Channel that passes the in-memory time step snapshots from the solver to
+/// the live viewers, bypassing the data storage.
+///
+/// Solver checks whether a frame is wanted, and if so, submits a snapshot.
+/// Only the latest submitted snapshot is kept: viewers that are slower than
+/// the solver skip the frames, so the solver never waits for the viewers.
+/// Frames are wanted only at the highest rate requested by the viewers.
+class LiveChannel final {
+public:
+
+  /// Construct a live channel.
+  LiveChannel() = default;
+
+  /// Live channel is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(LiveChannel);
+
+  /// Register a viewer, that wants at most @p rate frames per second.
+  ///
+  /// @returns Viewer identifier.
+  auto subscribe(float64_t rate) -> size_t;
+
+  /// Unregister the viewer.
+  void unsubscribe(size_t viewer_id);
+
+  /// Check if a new frame is wanted by any of the viewers.
+  auto is_wanted() const -> bool;
+
+  /// Acquire an empty snapshot of the time step.
+  static auto acquire(real_t time) -> DataTimeStepSnapshotPtr;
+
+  /// Submit the snapshot as the latest frame.
+  void submit(DataTimeStepSnapshotPtr snapshot);
+
+  /// Latest frame and its index. Index is zero if nothing was submitted.
+  auto latest() const
+      -> std::pair<size_t, std::shared_ptr<const DataTimeStepSnapshot>>;
+
+private:
+
+  using Clock_ = std::chrono::steady_clock;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<size_t, Clock_::duration> periods_;
+  size_t next_viewer_id_ = 0;
+  Clock_::time_point last_submit_time_;
+  size_t latest_index_ = 0;
+  std::shared_ptr<const DataTimeStepSnapshot> latest_;
+
+}; // class LiveChannel
+
+/// Live channel of the current process.
+auto live_channel() -> LiveChannel&;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
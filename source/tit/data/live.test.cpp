@@ -0,0 +1,123 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/live.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+#include "tit/data/zstd.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Deserialize the value from the stream, or fail.
+template<class Val>
+auto read_value(InputStream<byte_t>& in) -> Val {
+  Val val{};
+  REQUIRE(deserialize(in, val));
+  return val;
+}
+
+TEST_CASE("data::encode_live_frame") {
+  data::DataTimeStepSnapshot snapshot;
+  snapshot.reset(1.5);
+  const std::vector<float64_t> h{0.1};
+  snapshot.uniforms().create_array("h", h);
+  const std::vector<float64_t> rho{0.0, 1.0, 2.0, 3.0, 4.0, //
+                                   5.0, 6.0, 7.0, 8.0, 9.0};
+  snapshot.varyings().create_array("rho", rho);
+  snapshot.varyings().create_array("m", rho);
+
+  // Decode the single selected array of the frame.
+  const auto decode = [](const std::vector<byte_t>& frame) {
+    const auto in = make_range_input_stream(frame);
+    CHECK(read_value<float64_t>(*in) == 1.5);
+    REQUIRE(read_value<uint32_t>(*in) == 1);
+    CHECK(read_value<uint8_t>(*in) == 1);
+    CHECK(read_value<uint32_t>(*in) == data::type_of<float64_t>.id());
+    const auto tol = read_value<float64_t>(*in);
+    CHECK(read_value<uint64_t>(*in) == 10);
+    const auto num_items = read_value<uint64_t>(*in);
+    std::string name(read_value<uint32_t>(*in), '\0');
+    in->read(std::as_writable_bytes(std::span{name}));
+    CHECK(name == "rho");
+    std::vector<byte_t> data(read_value<uint64_t>(*in));
+    REQUIRE(in->read(data) == data.size());
+
+    auto stream = zstd::make_stream_decompressor(make_range_input_stream(data));
+    const auto kind = data::type_of<float64_t>.kind();
+    stream = data::make_unshuffle_input_stream(
+        std::move(stream),
+        tol > 0.0 ? sizeof(int64_t) : kind.width());
+    if (tol > 0.0) {
+      stream = data::make_dequantize_input_stream(std::move(stream), kind, tol);
+    }
+    std::vector<float64_t> values(num_items);
+    REQUIRE(make_stream_deserializer<float64_t>(std::move(stream))
+                ->read(values) == values.size());
+    return values;
+  };
+
+  SUBCASE("lossless") {
+    const auto frame = data::encode_live_frame(snapshot,
+                                               {.arrays = {"rho"},
+                                                .stride = 3});
+    CHECK_RANGE_EQ(decode(frame), std::vector{0.0, 3.0, 6.0, 9.0});
+  }
+  SUBCASE("range") {
+    const auto frame = data::encode_live_frame(snapshot,
+                                               {.arrays = {"rho"},
+                                                .first = 5,
+                                                .count = 4,
+                                                .stride = 2});
+    CHECK_RANGE_EQ(decode(frame), std::vector{5.0, 7.0});
+  }
+  SUBCASE("quantized") {
+    const auto frame = data::encode_live_frame(snapshot,
+                                               {.arrays = {"rho"},
+                                                .stride = 4,
+                                                .tolerance = 0.25});
+    CHECK_RANGE_EQ(decode(frame), std::vector{0.0, 4.0, 8.0});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::LiveChannel") {
+  data::LiveChannel channel;
+  CHECK_FALSE(channel.is_wanted());
+  CHECK(channel.latest().first == 0);
+
+  // Subscribe with a very low rate, so that only the first frame is wanted.
+  const auto viewer_id = channel.subscribe(/*rate=*/1.0e-6);
+  REQUIRE(channel.is_wanted());
+  channel.submit(data::LiveChannel::acquire(2.0));
+  CHECK_FALSE(channel.is_wanted());
+  const auto [index, frame] = channel.latest();
+  CHECK(index == 1);
+  REQUIRE(frame != nullptr);
+  CHECK(frame->time() == 2.0);
+
+  channel.unsubscribe(viewer_id);
+  CHECK_FALSE(channel.is_wanted());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,679 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/uint_utils.hpp"
+
+#include "tit/data/pack.hpp"
+#include "tit/data/sqlite.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Magic number that starts the header and ends the trailer of the file.
+constexpr std::array pack_magic{byte_t{'T'},
+                                byte_t{'I'},
+                                byte_t{'T'},
+                                byte_t{'P'},
+                                byte_t{'A'},
+                                byte_t{'C'},
+                                byte_t{'K'},
+                                byte_t{'1'}};
+
+// Version of the file format.
+constexpr uint32_t pack_version = 1;
+
+// Trailer at the end of the file: the index offset, the index size, and the
+// magic number.
+constexpr size_t trailer_size = 2 * sizeof(uint64_t) + pack_magic.size();
+
+// Serialize a string into the output stream.
+void serialize_string(OutputStream<byte_t>& out, std::string_view str) {
+  serialize(out, static_cast<uint64_t>(str.size()));
+  out.write(std::as_bytes(std::span{str}));
+}
+
+// Deserialize a string from the input stream.
+auto deserialize_string(InputStream<byte_t>& in) -> std::string {
+  uint64_t size = 0;
+  if (!deserialize(in, size)) deserialization_failed();
+  std::string result(size, '\0');
+  const auto bytes = std::as_writable_bytes(std::span{result});
+  if (in.read(bytes) != bytes.size()) deserialization_failed();
+  return result;
+}
+
+// Deserialize a value from the input stream, that must not be truncated.
+template<class Val>
+auto deserialize_value(InputStream<byte_t>& in) -> Val {
+  Val result{};
+  if (!deserialize(in, result)) deserialization_failed();
+  return result;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+PackStorage::PackStorage(const std::filesystem::path& path,
+                         const PackOptions& options)
+    : path_{path}, options_{options} {
+  if (!std::has_single_bit(options_.alignment)) {
+    TIT_THROW("Alignment must be a power of two, got {}.", options_.alignment);
+  }
+  if (options_.chunk_size == 0 ||
+      options_.chunk_size % options_.alignment != 0) {
+    TIT_THROW("Chunk size {} is not a positive multiple of alignment {}.",
+              options_.chunk_size,
+              options_.alignment);
+  }
+
+  // NOLINTNEXTLINE(*-vararg)
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) TIT_THROW("Failed to open file '{}'.", path_.native());
+
+  // Data arrays are written through the separate descriptor, that bypasses
+  // the page cache. Header and index are small, so they are always buffered.
+  if (options_.direct_io) {
+#ifdef O_DIRECT
+    // NOLINTNEXTLINE(*-vararg)
+    direct_fd_ = ::open(path_.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+#endif
+    if (direct_fd_ < 0) {
+      close(fd_);
+      TIT_THROW("Failed to open file '{}' for direct I/O.", path_.native());
+    }
+  }
+
+  try {
+    struct stat file_stat = {};
+    if (fstat(fd_, &file_stat) != 0) {
+      TIT_THROW("Failed to query the size of file '{}'.", path_.native());
+    }
+    if (file_stat.st_size == 0) {
+      write_header_();
+    } else {
+      end_offset_ = static_cast<size_t>(file_stat.st_size);
+      read_header_();
+      read_index_();
+    }
+  } catch (...) {
+    if (direct_fd_ >= 0) close(direct_fd_);
+    close(fd_);
+    throw;
+  }
+}
+
+// NOLINTNEXTLINE(*-exception-escape)
+PackStorage::~PackStorage() noexcept {
+  try {
+    flush();
+  } catch (const Exception& e) {
+    TIT_ERROR("Failed to write the index of '{}': {}",
+              path_.native(),
+              e.what());
+  }
+  if (direct_fd_ >= 0 && close(direct_fd_) != 0) {
+    TIT_ERROR("Failed to close file.");
+  }
+  if (close(fd_) != 0) TIT_ERROR("Failed to close file.");
+}
+
+void PackStorage::flush() {
+  const std::scoped_lock lock{mutex_};
+  if (!changed_) return;
+  write_index_();
+  if (fsync(fd_) != 0) {
+    TIT_THROW("Failed to flush file '{}'.", path_.native());
+  }
+  changed_ = false;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::num_series() const -> size_t {
+  const std::scoped_lock lock{mutex_};
+  return series_.size();
+}
+
+auto PackStorage::series_ids() const -> std::vector<DataSeriesID> {
+  const std::scoped_lock lock{mutex_};
+  std::vector<DataSeriesID> result(series_.size());
+  for (size_t i = 0; i < result.size(); ++i) {
+    result[i] = DataSeriesID{static_cast<sqlite::RowID>(i + 1)};
+  }
+  return result;
+}
+
+auto PackStorage::last_series_id() const -> DataSeriesID {
+  const std::scoped_lock lock{mutex_};
+  TIT_ASSERT(!series_.empty(), "No data series in the storage!");
+  return DataSeriesID{static_cast<sqlite::RowID>(series_.size())};
+}
+
+auto PackStorage::create_series_id(std::string_view parameters)
+    -> DataSeriesID {
+  const std::scoped_lock lock{mutex_};
+  series_.push_back({.parameters = std::string{parameters},
+                     .time_step_ids = {}});
+  changed_ = true;
+  return DataSeriesID{static_cast<sqlite::RowID>(series_.size())};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::check_series(DataSeriesID series_id) const -> bool {
+  const std::scoped_lock lock{mutex_};
+  return series_id.get() > 0 &&
+         std::cmp_less_equal(series_id.get(), series_.size());
+}
+
+auto PackStorage::series_parameters(DataSeriesID series_id) const
+    -> std::string {
+  const std::scoped_lock lock{mutex_};
+  return series_info_(series_id).parameters;
+}
+
+auto PackStorage::series_num_time_steps(DataSeriesID series_id) const
+    -> size_t {
+  const std::scoped_lock lock{mutex_};
+  return series_info_(series_id).time_step_ids.size();
+}
+
+auto PackStorage::series_time_step_ids(DataSeriesID series_id) const
+    -> std::vector<DataTimeStepID> {
+  const std::scoped_lock lock{mutex_};
+  return series_info_(series_id).time_step_ids;
+}
+
+auto PackStorage::series_last_time_step_id(DataSeriesID series_id) const
+    -> DataTimeStepID {
+  const std::scoped_lock lock{mutex_};
+  const auto& time_step_ids = series_info_(series_id).time_step_ids;
+  TIT_ASSERT(!time_step_ids.empty(), "No time steps in the series!");
+  return time_step_ids.back();
+}
+
+auto PackStorage::create_time_step_id(DataSeriesID series_id, real_t time)
+    -> DataTimeStepID {
+  const std::scoped_lock lock{mutex_};
+  TIT_ASSERT(series_id.get() > 0 &&
+                 std::cmp_less_equal(series_id.get(), series_.size()),
+             "Invalid data series ID!");
+  const auto uniforms_id = create_set_();
+  const auto varyings_id = create_set_();
+  time_steps_.push_back({.time = time,
+                         .uniforms_id = uniforms_id,
+                         .varyings_id = varyings_id});
+  const DataTimeStepID time_step_id{
+      static_cast<sqlite::RowID>(time_steps_.size())};
+  series_[series_id.get() - 1].time_step_ids.push_back(time_step_id);
+  changed_ = true;
+  return time_step_id;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::check_time_step(DataTimeStepID time_step_id) const -> bool {
+  const std::scoped_lock lock{mutex_};
+  return time_step_id.get() > 0 &&
+         std::cmp_less_equal(time_step_id.get(), time_steps_.size());
+}
+
+auto PackStorage::time_step_time(DataTimeStepID time_step_id) const -> real_t {
+  const std::scoped_lock lock{mutex_};
+  return time_step_info_(time_step_id).time;
+}
+
+auto PackStorage::time_step_uniforms_id(DataTimeStepID time_step_id) const
+    -> DataSetID {
+  const std::scoped_lock lock{mutex_};
+  return time_step_info_(time_step_id).uniforms_id;
+}
+
+auto PackStorage::time_step_varyings_id(DataTimeStepID time_step_id) const
+    -> DataSetID {
+  const std::scoped_lock lock{mutex_};
+  return time_step_info_(time_step_id).varyings_id;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::check_dataset(DataSetID dataset_id) const -> bool {
+  const std::scoped_lock lock{mutex_};
+  return dataset_id.get() > 0 &&
+         std::cmp_less_equal(dataset_id.get(), sets_.size());
+}
+
+auto PackStorage::dataset_num_arrays(DataSetID dataset_id) const -> size_t {
+  const std::scoped_lock lock{mutex_};
+  return set_info_(dataset_id).array_ids.size();
+}
+
+auto PackStorage::dataset_array_ids(DataSetID dataset_id) const
+    -> std::vector<std::pair<std::string, DataArrayID>> {
+  const std::scoped_lock lock{mutex_};
+  return set_info_(dataset_id).array_ids;
+}
+
+auto PackStorage::find_array_id(DataSetID dataset_id,
+                                std::string_view name) const
+    -> std::optional<DataArrayID> {
+  const std::scoped_lock lock{mutex_};
+  const auto& array_ids = set_info_(dataset_id).array_ids;
+  const auto iter = std::ranges::find(array_ids, name, [](const auto& p) {
+    return std::string_view{p.first};
+  });
+  if (iter == array_ids.end()) return std::nullopt;
+  return iter->second;
+}
+
+auto PackStorage::create_array_id(DataSetID dataset_id,
+                                  std::string_view name,
+                                  DataType type,
+                                  std::span<const byte_t> data)
+    -> DataArrayID {
+  TIT_ASSERT(check_dataset(dataset_id), "Invalid dataset ID!");
+  TIT_ASSERT(!find_array_id(dataset_id, name).has_value(),
+             "Data array with the given name already exists!");
+  if (data.size() % type.width() != 0) {
+    TIT_THROW("Data array size {} is not a multiple of the value width {}.",
+              data.size(),
+              type.width());
+  }
+
+  // Data is written outside of the lock, so that the arrays are written
+  // concurrently. Array becomes visible only once it is fully written.
+  const auto offset = reserve_(data.size());
+  write_chunks_(offset, data);
+
+  const std::scoped_lock lock{mutex_};
+  arrays_.push_back({.type = type, .offset = offset, .size = data.size()});
+  const DataArrayID array_id{static_cast<sqlite::RowID>(arrays_.size())};
+  sets_[dataset_id.get() - 1].array_ids.emplace_back(name, array_id);
+  changed_ = true;
+  return array_id;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::check_array(DataArrayID array_id) const -> bool {
+  const std::scoped_lock lock{mutex_};
+  return array_id.get() > 0 &&
+         std::cmp_less_equal(array_id.get(), arrays_.size());
+}
+
+auto PackStorage::array_type(DataArrayID array_id) const -> DataType {
+  const std::scoped_lock lock{mutex_};
+  return array_info_(array_id).type;
+}
+
+auto PackStorage::array_data(DataArrayID array_id) const
+    -> std::vector<byte_t> {
+  const auto [offset, size] = array_location_(array_id);
+  std::vector<byte_t> result(size);
+  read_at_(offset, result);
+  return result;
+}
+
+auto PackStorage::array_data_encoded(DataArrayID array_id) const
+    -> EncodedArrayData {
+  const auto type = array_type(array_id);
+  EncodedArrayData result{.type = type,
+                          .filter = DataFilter::none,
+                          .tolerance = 0.0,
+                          .compressed = false,
+                          .chunks = {}};
+  const auto& chunk = result.chunks.emplace_back(array_data(array_id));
+  result.num_values = chunk.size() / type.width();
+  return result;
+}
+
+auto PackStorage::array_data_range(DataArrayID array_id,
+                                   size_t first,
+                                   size_t count) const -> std::vector<byte_t> {
+  const auto width = array_type(array_id).width();
+  const auto [offset, size] = array_location_(array_id);
+  const auto begin = std::min(first * width, size);
+  const auto end = std::min(begin + count * width, size);
+  std::vector<byte_t> result(end - begin);
+  read_at_(offset + begin, result);
+  return result;
+}
+
+auto PackStorage::array_data_map(DataArrayID array_id) const
+    -> MappedArrayData<byte_t> {
+  const auto [offset, size] = array_location_(array_id);
+  return MappedArrayData<byte_t>{MappedFile{path_}, offset, size};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::series_info_(DataSeriesID series_id) const
+    -> const SeriesInfo_& {
+  TIT_ASSERT(series_id.get() > 0 &&
+                 std::cmp_less_equal(series_id.get(), series_.size()),
+             "Invalid data series ID!");
+  return series_[series_id.get() - 1];
+}
+
+auto PackStorage::time_step_info_(DataTimeStepID time_step_id) const
+    -> const TimeStepInfo_& {
+  TIT_ASSERT(time_step_id.get() > 0 &&
+                 std::cmp_less_equal(time_step_id.get(), time_steps_.size()),
+             "Invalid time step ID!");
+  return time_steps_[time_step_id.get() - 1];
+}
+
+auto PackStorage::set_info_(DataSetID dataset_id) const -> const SetInfo_& {
+  TIT_ASSERT(dataset_id.get() > 0 &&
+                 std::cmp_less_equal(dataset_id.get(), sets_.size()),
+             "Invalid dataset ID!");
+  return sets_[dataset_id.get() - 1];
+}
+
+auto PackStorage::array_info_(DataArrayID array_id) const
+    -> const ArrayInfo_& {
+  TIT_ASSERT(array_id.get() > 0 &&
+                 std::cmp_less_equal(array_id.get(), arrays_.size()),
+             "Invalid data array ID!");
+  return arrays_[array_id.get() - 1];
+}
+
+auto PackStorage::create_set_() -> DataSetID {
+  sets_.emplace_back();
+  return DataSetID{static_cast<sqlite::RowID>(sets_.size())};
+}
+
+auto PackStorage::array_location_(DataArrayID array_id) const
+    -> std::pair<size_t, size_t> {
+  const std::scoped_lock lock{mutex_};
+  const auto& info = array_info_(array_id);
+  return {info.offset, info.size};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto PackStorage::reserve_(size_t size) -> size_t {
+  return end_offset_.fetch_add(align_up(size, options_.alignment));
+}
+
+void PackStorage::write_chunks_(size_t offset,
+                                std::span<const byte_t> data) const {
+  const auto chunk_size = options_.chunk_size;
+  const auto num_chunks = divide_up(data.size(), chunk_size);
+  par::for_each(std::views::iota(size_t{0}, num_chunks), [&](size_t i) {
+    const auto chunk = data.subspan(i * chunk_size).first(
+        std::min(chunk_size, data.size() - i * chunk_size));
+    if (direct_fd_ < 0) {
+      write_at_(fd_, offset + i * chunk_size, chunk);
+      return;
+    }
+
+    // Direct I/O requires the aligned buffers of the aligned sizes, so the
+    // chunk is copied, and the tail is padded with zeroes, that fall into
+    // the reserved range anyway.
+    const auto alignment = options_.alignment;
+    const auto padded_size = align_up(chunk.size(), alignment);
+    const std::unique_ptr<byte_t[], decltype(&std::free)> buffer{
+        static_cast<byte_t*>(std::aligned_alloc(alignment, padded_size)),
+        &std::free};
+    if (buffer == nullptr) TIT_THROW("Failed to allocate the I/O buffer.");
+    std::ranges::copy(chunk, buffer.get());
+    std::fill(buffer.get() + chunk.size(),
+              buffer.get() + padded_size,
+              byte_t{0});
+    write_at_(direct_fd_,
+              offset + i * chunk_size,
+              {buffer.get(), padded_size});
+  });
+}
+
+void PackStorage::write_at_(int fd,
+                            size_t offset,
+                            std::span<const byte_t> data) const {
+  while (!data.empty()) {
+    const auto count = pwrite(fd,
+                              data.data(),
+                              data.size(),
+                              static_cast<off_t>(offset));
+    if (count <= 0) {
+      TIT_THROW("Failed to write into file '{}'.", path_.native());
+    }
+    data = data.subspan(static_cast<size_t>(count));
+    offset += static_cast<size_t>(count);
+  }
+}
+
+void PackStorage::read_at_(size_t offset, std::span<byte_t> data) const {
+  while (!data.empty()) {
+    const auto count = pread(fd_,
+                             data.data(),
+                             data.size(),
+                             static_cast<off_t>(offset));
+    if (count <= 0) {
+      TIT_THROW("Failed to read from file '{}'.", path_.native());
+    }
+    data = data.subspan(static_cast<size_t>(count));
+    offset += static_cast<size_t>(count);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void PackStorage::write_header_() {
+  // Header occupies the whole first aligned block, so that the data arrays
+  // start at the aligned offsets.
+  std::vector<byte_t> header;
+  const auto out = make_container_output_stream(header);
+  out->write(pack_magic);
+  serialize(*out, pack_version);
+  serialize(*out, static_cast<uint64_t>(options_.alignment));
+  header.resize(align_up(header.size(), options_.alignment));
+  write_at_(fd_, reserve_(header.size()), header);
+
+  // Even an empty storage must have an index, to be reopened.
+  changed_ = true;
+}
+
+void PackStorage::read_header_() {
+  std::array<byte_t, pack_magic.size() + sizeof(uint32_t) + sizeof(uint64_t)>
+      header{};
+  if (end_offset_ < header.size()) {
+    TIT_THROW("File '{}' is not a packed data storage.", path_.native());
+  }
+  read_at_(0, header);
+  const auto in = make_range_input_stream(header);
+  std::array<byte_t, pack_magic.size()> magic{};
+  in->read(magic);
+  if (magic != pack_magic) {
+    TIT_THROW("File '{}' is not a packed data storage.", path_.native());
+  }
+  if (const auto version = deserialize_value<uint32_t>(*in);
+      version != pack_version) {
+    TIT_THROW("Unsupported packed data storage version {}.", version);
+  }
+  if (const auto alignment = deserialize_value<uint64_t>(*in);
+      alignment != options_.alignment) {
+    TIT_THROW("Packed data storage '{}' has alignment {}, expected {}.",
+              path_.native(),
+              alignment,
+              options_.alignment);
+  }
+}
+
+void PackStorage::write_index_() {
+  std::vector<byte_t> index;
+  const auto out = make_container_output_stream(index);
+  serialize(*out, static_cast<uint64_t>(series_.size()));
+  for (const auto& series : series_) {
+    serialize_string(*out, series.parameters);
+    serialize(*out, static_cast<uint64_t>(series.time_step_ids.size()));
+    for (const auto id : series.time_step_ids) serialize(*out, id.get());
+  }
+  serialize(*out, static_cast<uint64_t>(time_steps_.size()));
+  for (const auto& time_step : time_steps_) {
+    serialize(*out,
+              time_step.time,
+              time_step.uniforms_id.get(),
+              time_step.varyings_id.get());
+  }
+  serialize(*out, static_cast<uint64_t>(sets_.size()));
+  for (const auto& set : sets_) {
+    serialize(*out, static_cast<uint64_t>(set.array_ids.size()));
+    for (const auto& [name, id] : set.array_ids) {
+      serialize_string(*out, name);
+      serialize(*out, id.get());
+    }
+  }
+  serialize(*out, static_cast<uint64_t>(arrays_.size()));
+  for (const auto& array : arrays_) {
+    serialize(*out,
+              array.type.id(),
+              static_cast<uint64_t>(array.offset),
+              static_cast<uint64_t>(array.size));
+  }
+
+  // Trailer is placed at the very end of the aligned footer, so that it is
+  // found at the end of the file.
+  const auto index_size = index.size();
+  const auto footer_size =
+      align_up(index_size + trailer_size, options_.alignment);
+  const auto index_offset = reserve_(footer_size);
+  index.resize(footer_size - trailer_size);
+  serialize(*out,
+            static_cast<uint64_t>(index_offset),
+            static_cast<uint64_t>(index_size));
+  out->write(pack_magic);
+  write_at_(fd_, index_offset, index);
+}
+
+void PackStorage::read_index_() {
+  // Index footers end at the aligned offsets, right after the header block
+  // at the earliest. If the storage was not closed properly, the data arrays
+  // that were written after the last flush are not indexed, so the last
+  // valid footer is searched for. The file is not modified on opening, the
+  // unindexed tail is overwritten by the next appended arrays.
+  const auto alignment = options_.alignment;
+  const size_t file_size = end_offset_;
+  for (auto footer_end = file_size / alignment * alignment;
+       footer_end > alignment;
+       footer_end -= alignment) {
+    if (!read_index_at_(footer_end)) continue;
+    if (footer_end != file_size) {
+      TIT_WARN("Packed data storage '{}' was not closed properly, the last "
+               "{} bytes are not indexed and are dropped.",
+               path_.native(),
+               file_size - footer_end);
+      end_offset_ = footer_end;
+    }
+    return;
+  }
+  TIT_THROW("Packed data storage '{}' has no index.", path_.native());
+}
+
+auto PackStorage::read_index_at_(size_t footer_end) -> bool {
+  std::array<byte_t, trailer_size> trailer{};
+  read_at_(footer_end - trailer.size(), trailer);
+  const auto trailer_in = make_range_input_stream(trailer);
+  const auto index_offset = deserialize_value<uint64_t>(*trailer_in);
+  const auto index_size = deserialize_value<uint64_t>(*trailer_in);
+  std::array<byte_t, pack_magic.size()> magic{};
+  trailer_in->read(magic);
+  const auto alignment = options_.alignment;
+  if (magic != pack_magic || index_offset < alignment ||
+      index_offset % alignment != 0 || index_offset >= footer_end ||
+      index_size > footer_end - index_offset ||
+      align_up(index_size + trailer_size, alignment) !=
+          footer_end - index_offset) {
+    return false;
+  }
+
+  // Index may be torn, if the storage was not closed properly while the
+  // footer was being written.
+  try {
+    std::vector<byte_t> index(index_size);
+    read_at_(index_offset, index);
+    const auto in = make_range_input_stream(index);
+    series_.resize(deserialize_value<uint64_t>(*in));
+    for (auto& series : series_) {
+      series.parameters = deserialize_string(*in);
+      series.time_step_ids.resize(deserialize_value<uint64_t>(*in));
+      for (auto& id : series.time_step_ids) {
+        id = DataTimeStepID{deserialize_value<sqlite::RowID>(*in)};
+      }
+    }
+    time_steps_.resize(deserialize_value<uint64_t>(*in));
+    for (auto& time_step : time_steps_) {
+      time_step.time = deserialize_value<real_t>(*in);
+      time_step.uniforms_id =
+          DataSetID{deserialize_value<sqlite::RowID>(*in)};
+      time_step.varyings_id =
+          DataSetID{deserialize_value<sqlite::RowID>(*in)};
+    }
+    sets_.resize(deserialize_value<uint64_t>(*in));
+    for (auto& set : sets_) {
+      set.array_ids.resize(deserialize_value<uint64_t>(*in));
+      for (auto& [name, id] : set.array_ids) {
+        name = deserialize_string(*in);
+        id = DataArrayID{deserialize_value<sqlite::RowID>(*in)};
+      }
+    }
+    const auto num_arrays = deserialize_value<uint64_t>(*in);
+    arrays_.clear();
+    arrays_.reserve(num_arrays);
+    for (size_t i = 0; i < num_arrays; ++i) {
+      const DataType type{deserialize_value<uint32_t>(*in)};
+      const auto offset = deserialize_value<uint64_t>(*in);
+      const auto size = deserialize_value<uint64_t>(*in);
+      if (offset > index_offset || size > index_offset - offset) {
+        TIT_THROW("Data array is out of the indexed range.");
+      }
+      arrays_.push_back({.type = type, .offset = offset, .size = size});
+    }
+  } catch (const Exception& /*e*/) {
+    series_.clear();
+    time_steps_.clear();
+    sets_.clear();
+    arrays_.clear();
+    return false;
+  }
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,423 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Packed data storage options.
+struct PackOptions final {
+  /// Alignment of the data arrays in the file (in bytes). Must be a power of
+  /// two, and a multiple of the file system block size for the direct I/O.
+  size_t alignment = 4096;
+
+  /// Size of the chunks, that are written in parallel (in bytes). Must be a
+  /// multiple of the alignment.
+  size_t chunk_size = 4 * 1024 * 1024;
+
+  /// Bypass the page cache when writing the data arrays.
+  bool direct_io = false;
+};
+
+/// Packed data storage.
+///
+/// Packed storage is a single append-only binary file: a header, the raw
+/// data arrays, each starting at an aligned offset, and the index footer,
+/// that describes the series, the time steps, the datasets and the arrays.
+/// It is an alternative to the SQLite-based `DataStorage` for the large
+/// outputs, with the same view API.
+///
+/// Data arrays are written uncompressed, directly at the reserved offsets,
+/// chunk by chunk and in parallel, with no buffering of the whole array and
+/// no single-writer lock: several threads may create the arrays at once.
+/// Aligned arrays are memory-mapped on reading with no copies, and may be
+/// written bypassing the page cache.
+///
+/// Index is kept in memory and appended to the file on `flush` and on
+/// destruction. Reopened storage continues appending after the last index,
+/// so the stale indices remain in the file, but are never read. If the
+/// storage was not closed properly, it is reopened from the last valid
+/// index, and the arrays written after it are dropped.
+class PackStorage final {
+public:
+
+  /// Packed storage is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(PackStorage);
+
+  /// Open a packed storage or create it if it does not exist.
+  explicit PackStorage(const std::filesystem::path& path,
+                       const PackOptions& options = {});
+
+  /// Write the index and close the storage.
+  ~PackStorage() noexcept;
+
+  /// Path to the storage file.
+  auto path() const -> const std::filesystem::path& {
+    return path_;
+  }
+
+  /// Storage options.
+  auto options() const noexcept -> const PackOptions& {
+    return options_;
+  }
+
+  /// Append the index to the file and synchronize it with the storage
+  /// device. Data written before the flush survives a crash after it.
+  void flush();
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Number of data series in the storage.
+  auto num_series() const -> size_t;
+
+  /// Enumerate all data series.
+  /// @{
+  auto series_ids() const -> std::vector<DataSeriesID>;
+  auto series(this auto& self) {
+    return self.series_ids() | std::views::transform([&self](DataSeriesID id) {
+             return DataSeriesView{self, id};
+           });
+  }
+  /// @}
+
+  /// Get the last series.
+  /// @{
+  auto last_series_id() const -> DataSeriesID;
+  auto last_series(this auto& self) {
+    return DataSeriesView{self, self.last_series_id()};
+  }
+  /// @}
+
+  /// Create a new data series.
+  /// @{
+  auto create_series_id(std::string_view parameters = "") -> DataSeriesID;
+  auto create_series(std::string_view parameters = "")
+      -> DataSeriesView<PackStorage> {
+    return DataSeriesView{*this, create_series_id(parameters)};
+  }
+  /// @}
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Check if a data series with the given ID exists.
+  auto check_series(DataSeriesID series_id) const -> bool;
+
+  /// Get the parameters of a data series.
+  auto series_parameters(DataSeriesID series_id) const -> std::string;
+
+  /// Number of time steps in the series.
+  auto series_num_time_steps(DataSeriesID series_id) const -> size_t;
+
+  /// Enumerate all time steps in the series.
+  /// @{
+  auto series_time_step_ids(DataSeriesID series_id) const
+      -> std::vector<DataTimeStepID>;
+  auto series_time_steps(this auto& self, DataSeriesID series_id) {
+    return self.series_time_step_ids(series_id) |
+           std::views::transform([&self](DataTimeStepID id) {
+             return DataTimeStepView{self, id};
+           });
+  }
+  /// @}
+
+  /// Get the last time step in the series.
+  /// @{
+  auto series_last_time_step_id(DataSeriesID series_id) const -> DataTimeStepID;
+  auto series_last_time_step(this auto& self, DataSeriesID series_id) {
+    return DataTimeStepView{self, self.series_last_time_step_id(series_id)};
+  }
+  /// @}
+
+  /// Create a new time step in the series.
+  /// @{
+  auto create_time_step_id(DataSeriesID series_id, real_t time)
+      -> DataTimeStepID;
+  auto create_time_step(DataSeriesID series_id, real_t time)
+      -> DataTimeStepView<PackStorage> {
+    return DataTimeStepView{*this, create_time_step_id(series_id, time)};
+  }
+  /// @}
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Check if a time step with the given ID exists.
+  auto check_time_step(DataTimeStepID time_step_id) const -> bool;
+
+  /// Get the time of a time step.
+  auto time_step_time(DataTimeStepID time_step_id) const -> real_t;
+
+  /// Get the uniform dataset of a time step.
+  /// @{
+  auto time_step_uniforms_id(DataTimeStepID time_step_id) const -> DataSetID;
+  auto time_step_uniforms(this auto& self, DataTimeStepID time_step_id) {
+    return DataSetView{self, self.time_step_uniforms_id(time_step_id)};
+  }
+  /// @}
+
+  /// Get the varying dataset of a time step.
+  /// @{
+  auto time_step_varyings_id(DataTimeStepID time_step_id) const -> DataSetID;
+  auto time_step_varyings(this auto& self, DataTimeStepID time_step_id) {
+    return DataSetView{self, self.time_step_varyings_id(time_step_id)};
+  }
+  /// @}
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Check if a dataset with the given ID exists.
+  auto check_dataset(DataSetID dataset_id) const -> bool;
+
+  /// Number of data arrays in the dataset.
+  auto dataset_num_arrays(DataSetID dataset_id) const -> size_t;
+
+  /// Enumerate all data arrays in the dataset.
+  /// @{
+  auto dataset_array_ids(DataSetID dataset_id) const
+      -> std::vector<std::pair<std::string, DataArrayID>>;
+  auto dataset_arrays(this auto& self, DataSetID dataset_id) {
+    return self.dataset_array_ids(dataset_id) |
+           std::views::transform([&self](auto name_and_id) {
+             auto [name, id] = std::move(name_and_id);
+             return std::pair{std::move(name), DataArrayView{self, id}};
+           });
+  }
+  /// @}
+
+  /// Find the data array with the given name.
+  /// @{
+  auto find_array_id(DataSetID dataset_id, std::string_view name) const
+      -> std::optional<DataArrayID>;
+  auto find_array(this auto& self,
+                  DataSetID dataset_id,
+                  std::string_view name) {
+    return self.find_array_id(dataset_id, name).transform([&self](auto id) {
+      return DataArrayView{self, id};
+    });
+  }
+  /// @}
+
+  /// Create a new data array in the dataset. Data is written immediately,
+  /// since the storage is append-only.
+  /// @{
+  auto create_array_id(DataSetID dataset_id,
+                       std::string_view name,
+                       DataType type,
+                       std::span<const byte_t> data) -> DataArrayID;
+  template<std::ranges::input_range Vals>
+    requires known_type_of<std::ranges::range_value_t<Vals>>
+  auto create_array_id(DataSetID dataset_id, std::string_view name, Vals&& vals)
+      -> DataArrayID {
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    using Val = std::ranges::range_value_t<Vals>;
+    if constexpr (std::ranges::contiguous_range<Vals> &&
+                  std::ranges::sized_range<Vals> && mappable_type_of<Val>) {
+      return create_array_id(
+          dataset_id,
+          name,
+          type_of<Val>,
+          std::as_bytes(
+              std::span{std::ranges::data(vals), std::ranges::size(vals)}));
+    } else {
+      std::vector<byte_t> data;
+      write_values(make_container_output_stream(data), vals);
+      return create_array_id(dataset_id, name, type_of<Val>, data);
+    }
+  }
+  template<class... Args>
+  auto create_array(DataSetID dataset_id, std::string_view name, Args&&... args)
+      -> DataArrayView<PackStorage> {
+    return DataArrayView{
+        *this,
+        create_array_id(dataset_id, name, std::forward<Args>(args)...)};
+  }
+  /// @}
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Check if a data array with the given ID exists.
+  auto check_array(DataArrayID array_id) const -> bool;
+
+  /// Get the data type of a data array.
+  auto array_type(DataArrayID array_id) const -> DataType;
+
+  /// Get the filter of a data array. Packed arrays are never filtered.
+  auto array_filter(DataArrayID /*array_id*/) const noexcept -> DataFilter {
+    return DataFilter::none;
+  }
+
+  /// Get the lossy compression tolerance of a data array. Packed arrays are
+  /// always lossless.
+  auto array_tolerance(DataArrayID /*array_id*/) const noexcept -> float64_t {
+    return 0.0;
+  }
+
+  /// Check if a data array is stored externally. Packed arrays are not.
+  auto array_is_external(DataArrayID /*array_id*/) const noexcept -> bool {
+    return false;
+  }
+
+  /// Get the number of values per chunk of a data array. Packed arrays are
+  /// stored contiguously, so they are not chunked.
+  auto array_chunk_size(DataArrayID /*array_id*/) const noexcept -> size_t {
+    return 0;
+  }
+
+  /// Check if the data of a data array is compressed. Packed arrays are not.
+  auto array_is_compressed(DataArrayID /*array_id*/) const noexcept -> bool {
+    return false;
+  }
+
+  /// Get the data of a data array.
+  /// @{
+  auto array_data(DataArrayID array_id) const -> std::vector<byte_t>;
+  template<known_type_of Val>
+  auto array_data(DataArrayID array_id) const -> std::vector<Val> {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    std::vector<Val> result;
+    read_from(make_stream_deserializer<Val>(
+                  make_range_input_stream(array_data(array_id))),
+              result,
+              /*chunk_size=*/(64 * 1024UZ / sizeof(Val)));
+    return result;
+  }
+  /// @}
+
+  /// Read the data of a data array as a single uncompressed chunk.
+  auto array_data_encoded(DataArrayID array_id) const -> EncodedArrayData;
+
+  /// Get the range of values of a data array. Values that are out of the
+  /// array bounds are not returned.
+  /// @{
+  auto array_data_range(DataArrayID array_id, size_t first, size_t count) const
+      -> std::vector<byte_t>;
+  template<known_type_of Val>
+  auto array_data_range(DataArrayID array_id, size_t first, size_t count) const
+      -> std::vector<Val> {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    std::vector<Val> result;
+    read_from(make_stream_deserializer<Val>(make_range_input_stream(
+                  array_data_range(array_id, first, count))),
+              result,
+              /*chunk_size=*/(64 * 1024UZ / sizeof(Val)));
+    return result;
+  }
+  /// @}
+
+  /// Map the data of a data array into memory.
+  /// @{
+  auto array_data_map(DataArrayID array_id) const -> MappedArrayData<byte_t>;
+  template<mappable_type_of Val>
+  auto array_data_map(DataArrayID array_id) const -> MappedArrayData<Val> {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    const auto [offset, size] = array_location_(array_id);
+    return MappedArrayData<Val>{MappedFile{path_}, offset, size};
+  }
+  /// @}
+
+private:
+
+  // Series entry of the index.
+  struct SeriesInfo_ final {
+    std::string parameters;
+    std::vector<DataTimeStepID> time_step_ids;
+  };
+
+  // Time step entry of the index.
+  struct TimeStepInfo_ final {
+    real_t time;
+    DataSetID uniforms_id;
+    DataSetID varyings_id;
+  };
+
+  // Dataset entry of the index.
+  struct SetInfo_ final {
+    std::vector<std::pair<std::string, DataArrayID>> array_ids;
+  };
+
+  // Data array entry of the index.
+  struct ArrayInfo_ final {
+    DataType type;
+    size_t offset;
+    size_t size;
+  };
+
+  // Get the index entries. IDs are the one-based entry indices. Mutex must
+  // be held by the caller.
+  auto series_info_(DataSeriesID series_id) const -> const SeriesInfo_&;
+  auto time_step_info_(DataTimeStepID time_step_id) const
+      -> const TimeStepInfo_&;
+  auto set_info_(DataSetID dataset_id) const -> const SetInfo_&;
+  auto array_info_(DataArrayID array_id) const -> const ArrayInfo_&;
+
+  // Create a new dataset. Mutex must be held by the caller.
+  auto create_set_() -> DataSetID;
+
+  // Get the offset and the size of the data array in the file.
+  auto array_location_(DataArrayID array_id) const
+      -> std::pair<size_t, size_t>;
+
+  // Reserve the aligned byte range at the end of the file.
+  auto reserve_(size_t size) -> size_t;
+
+  // Write the bytes at the offset, chunk by chunk and in parallel.
+  void write_chunks_(size_t offset, std::span<const byte_t> data) const;
+
+  // Write or read the bytes at the offset.
+  void write_at_(int fd, size_t offset, std::span<const byte_t> data) const;
+  void read_at_(size_t offset, std::span<byte_t> data) const;
+
+  // Write the header of the new file, or check the header of the existing.
+  void write_header_();
+  void read_header_();
+
+  // Append the index, or load the last valid one.
+  void write_index_();
+  void read_index_();
+
+  // Load the index of the footer that ends at the offset, if it is valid.
+  auto read_index_at_(size_t footer_end) -> bool;
+
+  std::filesystem::path path_;
+  PackOptions options_;
+  int fd_ = -1;
+  int direct_fd_ = -1;
+  std::atomic<size_t> end_offset_ = 0;
+
+  mutable std::mutex mutex_;
+  bool changed_ = false;
+  std::vector<SeriesInfo_> series_;
+  std::vector<TimeStepInfo_> time_steps_;
+  std::vector<SetInfo_> sets_;
+  std::vector<ArrayInfo_> arrays_;
+
+}; // class PackStorage
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,181 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/par/algorithms.hpp"
+
+#include "tit/data/pack.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Remove the file if it already exists.
+void remove_file(const std::filesystem::path& file_name) {
+  if (std::filesystem::exists(file_name)) {
+    REQUIRE(std::filesystem::remove(file_name));
+  }
+}
+
+TEST_CASE("data::PackStorage") {
+  const std::filesystem::path file_name{"test.ttpack"};
+  remove_file(file_name);
+  const data::PackOptions options{.alignment = 256, .chunk_size = 512};
+  const std::vector<float64_t> values{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
+  std::vector<uint32_t> indices(300);
+  std::ranges::iota(indices, uint32_t{0});
+  {
+    data::PackStorage storage{file_name, options};
+    CHECK(storage.num_series() == 0);
+    const auto series = storage.create_series("parameters");
+    const auto time_step = series.create_time_step(0.5);
+    time_step.uniforms().create_array("values", values);
+    time_step.varyings().create_array("indices", indices);
+    CHECK(storage.num_series() == 1);
+    CHECK(series.parameters() == "parameters");
+    CHECK(series.num_time_steps() == 1);
+    CHECK(time_step.time() == 0.5);
+    const auto array = time_step.uniforms().find_array("values");
+    REQUIRE(array.has_value());
+    CHECK(array->type() == data::type_of<float64_t>);
+    CHECK_FALSE(array->is_compressed());
+    CHECK(array->data<float64_t>() == values);
+  }
+  SUBCASE("reopen") {
+    data::PackStorage storage{file_name, options};
+    REQUIRE(storage.num_series() == 1);
+    const auto series = storage.last_series();
+    CHECK(series.parameters() == "parameters");
+    const auto time_step = series.last_time_step();
+    CHECK(time_step.time() == 0.5);
+    const auto uniforms = time_step.uniforms();
+    REQUIRE(uniforms.num_arrays() == 1);
+    CHECK(uniforms.find_array("values")->data<float64_t>() == values);
+    const auto varyings = time_step.varyings();
+    CHECK(varyings.find_array("indices")->data<uint32_t>() == indices);
+    CHECK_FALSE(varyings.find_array("missing").has_value());
+    SUBCASE("append") {
+      series.create_time_step(1.0).uniforms().create_array("values", values);
+      storage.flush();
+      const data::PackStorage reopened{file_name, options};
+      const auto last = reopened.last_series().last_time_step();
+      CHECK(reopened.last_series().num_time_steps() == 2);
+      CHECK(last.time() == 1.0);
+      CHECK(last.uniforms().find_array("values")->data<float64_t>() ==
+            values);
+    }
+  }
+  SUBCASE("read range") {
+    const data::PackStorage storage{file_name, options};
+    const auto array =
+        storage.last_series().last_time_step().uniforms().find_array("values");
+    REQUIRE(array.has_value());
+    CHECK(array->read_range<float64_t>(2, 3) ==
+          std::vector<float64_t>{3.0, 4.0, 5.0});
+    CHECK(array->read_range<float64_t>(5, 10) ==
+          std::vector<float64_t>{6.0, 7.0});
+    CHECK(array->read_range<float64_t>(10, 1).empty());
+  }
+  SUBCASE("map") {
+    const data::PackStorage storage{file_name, options};
+    const auto array = storage.last_series().last_time_step().varyings()
+                           .find_array("indices");
+    REQUIRE(array.has_value());
+    const auto mapped = array->map<uint32_t>();
+    REQUIRE(mapped.size() == indices.size());
+    CHECK(std::ranges::equal(mapped.data(), indices));
+    CHECK(array->encoded().decode() == array->data());
+  }
+  SUBCASE("truncated") {
+    // Trailer of the last index is cut off, as if the storage was not closed
+    // properly, so the last time step is not indexed.
+    {
+      data::PackStorage storage{file_name, options};
+      storage.last_series().create_time_step(1.0).uniforms().create_array(
+          "values",
+          values);
+    }
+    std::filesystem::resize_file(file_name,
+                                 std::filesystem::file_size(file_name) - 1);
+    data::PackStorage storage{file_name, options};
+    const auto series = storage.last_series();
+    REQUIRE(series.num_time_steps() == 1);
+    const auto time_step = series.last_time_step();
+    CHECK(time_step.time() == 0.5);
+    CHECK(time_step.uniforms().find_array("values")->data<float64_t>() ==
+          values);
+    CHECK(time_step.varyings().find_array("indices")->data<uint32_t>() ==
+          indices);
+    SUBCASE("append") {
+      series.create_time_step(2.0).uniforms().create_array("values", values);
+      storage.flush();
+      const data::PackStorage reopened{file_name, options};
+      const auto last = reopened.last_series().last_time_step();
+      CHECK(reopened.last_series().num_time_steps() == 2);
+      CHECK(last.time() == 2.0);
+      CHECK(last.uniforms().find_array("values")->data<float64_t>() ==
+            values);
+    }
+  }
+  SUBCASE("no index") {
+    std::filesystem::resize_file(file_name, options.alignment);
+    CHECK_THROWS_MSG(data::PackStorage(file_name, options),
+                     Exception,
+                     "Packed data storage 'test.ttpack' has no index.");
+  }
+  SUBCASE("alignment mismatch") {
+    CHECK_THROWS_MSG(
+        data::PackStorage(file_name, {.alignment = 512, .chunk_size = 512}),
+        Exception,
+        "Packed data storage 'test.ttpack' has alignment 256, expected 512.");
+  }
+}
+
+TEST_CASE("data::PackStorage::concurrent") {
+  const std::filesystem::path file_name{"test_concurrent.ttpack"};
+  remove_file(file_name);
+  constexpr size_t num_arrays = 32;
+  const auto make_values = [](size_t i) {
+    return std::vector<float64_t>(100 + i, static_cast<float64_t>(i));
+  };
+  {
+    data::PackStorage storage{file_name,
+                              {.alignment = 256, .chunk_size = 256}};
+    const auto dataset =
+        storage.create_series().create_time_step(0.0).varyings();
+    // Arrays are created from the different threads at once.
+    par::for_each(std::views::iota(size_t{0}, num_arrays), [&](size_t i) {
+      dataset.create_array(std::format("array_{}", i), make_values(i));
+    });
+  }
+  const data::PackStorage storage{file_name,
+                                  {.alignment = 256, .chunk_size = 256}};
+  const auto dataset = storage.last_series().last_time_step().varyings();
+  REQUIRE(dataset.num_arrays() == num_arrays);
+  for (size_t i = 0; i < num_arrays; ++i) {
+    const auto array = dataset.find_array(std::format("array_{}", i));
+    REQUIRE(array.has_value());
+    CHECK(array->data<float64_t>() == make_values(i));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
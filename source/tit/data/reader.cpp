@@ -0,0 +1,143 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/profiler.hpp"
+
+#include "tit/data/reader.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataReader::DataReader(DataSeriesView<DataStorage> series, size_t max_prefetch)
+    : series_{series},
+      time_step_ids_{series_.storage().series_time_step_ids(series_.id())},
+      max_prefetch_{max_prefetch}, thread_{[this] { run_(); }} {
+  TIT_ASSERT(max_prefetch_ > 0, "Prefetch size must be positive!");
+}
+
+DataReader::~DataReader() noexcept {
+  // The time step that is currently being read is discarded, and the
+  // background thread is joined by its destructor.
+  const std::scoped_lock lock{mutex_};
+  is_stopping_ = true;
+  cv_.notify_all();
+}
+
+auto DataReader::num_time_steps() const noexcept -> size_t {
+  return time_step_ids_.size();
+}
+
+void DataReader::seek(size_t index) {
+  TIT_ASSERT(index <= num_time_steps(), "Time step index is out of range!");
+  const std::scoped_lock lock{mutex_};
+  queue_.clear();
+  next_read_ = next_taken_ = index;
+  ++generation_;
+  error_ = nullptr;
+  cv_.notify_all();
+}
+
+auto DataReader::next() -> DataTimeStepSnapshotPtr {
+  std::unique_lock lock{mutex_};
+  if (next_taken_ == num_time_steps()) return nullptr;
+  cv_.wait(lock, [this] { return error_ != nullptr || !queue_.empty(); });
+  if (error_ != nullptr) std::rethrow_exception(std::exchange(error_, {}));
+  auto snapshot = std::move(queue_.front());
+  queue_.pop_front();
+  ++next_taken_;
+  cv_.notify_all();
+  return snapshot;
+}
+
+auto DataReader::read_(DataTimeStepID time_step_id) const
+    -> DataTimeStepSnapshotPtr {
+  TIT_PROFILE_SECTION("DataReader::read_()");
+  const DataTimeStepView time_step{series_.storage(), time_step_id};
+  auto snapshot = std::make_unique<DataTimeStepSnapshot>();
+  snapshot->reset(time_step.time());
+
+  // Encoded data is read sequentially, since the storage is not thread-safe.
+  struct ArrayToDecode final {
+    bool is_uniform;
+    std::string name;
+    EncodedArrayData encoded;
+  };
+  std::vector<ArrayToDecode> arrays;
+  const auto read_dataset = [&arrays, this](DataSetView<DataStorage> dataset,
+                                            bool is_uniform) {
+    for (auto [name, array] : dataset.arrays()) {
+      arrays.push_back(
+          {.is_uniform = is_uniform,
+           .name = std::move(name),
+           .encoded = series_.storage().array_data_encoded(array.id())});
+    }
+  };
+  read_dataset(time_step.uniforms(), /*is_uniform=*/true);
+  read_dataset(time_step.varyings(), /*is_uniform=*/false);
+
+  // Decoding does not access the storage, so it is done in parallel.
+  std::vector<std::vector<byte_t>> decoded(arrays.size());
+  par::for_each(std::views::iota(size_t{0}, arrays.size()),
+                [&arrays, &decoded](size_t i) {
+                  decoded[i] = arrays[i].encoded.decode();
+                });
+  for (auto&& [array, data] : std::views::zip(arrays, decoded)) {
+    auto& dataset =
+        array.is_uniform ? snapshot->uniforms() : snapshot->varyings();
+    dataset.create_array(array.name, array.encoded.type, std::move(data));
+  }
+  return snapshot;
+}
+
+void DataReader::run_() {
+  std::unique_lock lock{mutex_};
+  while (true) {
+    cv_.wait(lock, [this] {
+      return is_stopping_ ||
+             (error_ == nullptr && queue_.size() < max_prefetch_ &&
+              next_read_ < num_time_steps());
+    });
+    if (is_stopping_) break;
+
+    // Time step that was read for a previous seek position is discarded.
+    const auto index = next_read_++;
+    const auto generation = generation_;
+    lock.unlock();
+    DataTimeStepSnapshotPtr snapshot;
+    std::exception_ptr error;
+    try {
+      // Decoding runs in the I/O arena, so that it does not steal the
+      // workers from the compute tasks.
+      snapshot = par::io_execute(
+          [index, this] { return read_(time_step_ids_[index]); });
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    if (generation != generation_) continue;
+    if (error != nullptr) error_ = std::move(error);
+    else queue_.push_back(std::move(snapshot));
+    cv_.notify_all();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
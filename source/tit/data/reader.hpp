@@ -0,0 +1,83 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Prefetching data series reader.
+///
+/// Time steps are read by a background thread ahead of the consumer, so
+/// that the playback is not blocked by the storage. Encoded data arrays of
+/// a time step are read sequentially, and then all of them, and all of
+/// their chunks, are decoded in parallel. At most `max_prefetch` decoded
+/// time steps wait to be consumed.
+///
+/// The storage must not be accessed by the other threads while the reader
+/// is alive.
+class DataReader final {
+public:
+
+  /// Construct a data reader, starting from the first time step.
+  explicit DataReader(DataSeriesView<DataStorage> series,
+                      size_t max_prefetch = 2);
+
+  /// Data reader is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(DataReader);
+
+  /// Stop the reader.
+  ~DataReader() noexcept;
+
+  /// Number of time steps in the series, when the reader was constructed.
+  auto num_time_steps() const noexcept -> size_t;
+
+  /// Continue reading from the time step with the given index. Prefetched
+  /// time steps are discarded.
+  void seek(size_t index);
+
+  /// Take the next time step. Blocks until it is read and decoded.
+  ///
+  /// @returns Snapshot of the time step, or null if all of the time steps
+  ///          were already taken.
+  auto next() -> DataTimeStepSnapshotPtr;
+
+private:
+
+  auto read_(DataTimeStepID time_step_id) const -> DataTimeStepSnapshotPtr;
+  void run_();
+
+  DataSeriesView<DataStorage> series_;
+  std::vector<DataTimeStepID> time_step_ids_;
+  size_t max_prefetch_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<DataTimeStepSnapshotPtr> queue_;
+  size_t next_read_ = 0;   // Index of the time step to read next.
+  size_t next_taken_ = 0;  // Index of the time step to be taken next.
+  size_t generation_ = 0;  // Incremented on each seek.
+  std::exception_ptr error_;
+  bool is_stopping_ = false;
+  std::jthread thread_;
+
+}; // class DataReader
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,84 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/range_utils.hpp"
+
+#include "tit/data/reader.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::DataReader") {
+  data::DataStorage storage{":memory:"};
+  storage.set_chunk_size(100); // Make sure the arrays are chunked.
+  const auto series = storage.create_series("");
+  constexpr size_t num_time_steps = 5;
+  const auto values = [](size_t n) {
+    return std::views::iota(0UZ, 1000UZ) |
+           std::views::transform(
+               [n](size_t i) { return static_cast<double>(n * i); });
+  };
+  for (size_t n = 0; n < num_time_steps; ++n) {
+    const auto time_step = series.create_time_step(static_cast<real_t>(n));
+    time_step.uniforms().create_array("n", std::span{&n, 1});
+    time_step.varyings().create_array("values", values(n));
+  }
+  const auto check = [&values](const data::DataTimeStepSnapshot& snapshot,
+                               size_t n) {
+    CHECK(snapshot.time() == static_cast<real_t>(n));
+    const auto uniforms = snapshot.uniforms().arrays();
+    REQUIRE(uniforms.size() == 1);
+    CHECK(uniforms[0].name == "n");
+    CHECK(uniforms[0].type == data::type_of<size_t>);
+    CHECK_RANGE_EQ(uniforms[0].data, to_byte_array(n));
+    const auto varyings = snapshot.varyings().arrays();
+    REQUIRE(varyings.size() == 1);
+    CHECK(varyings[0].name == "values");
+    CHECK(varyings[0].type == data::type_of<double>);
+    std::vector<byte_t> expected;
+    for (const auto value : values(n)) {
+      const auto bytes = to_byte_array(value);
+      expected.insert(expected.end(), bytes.begin(), bytes.end());
+    }
+    CHECK_RANGE_EQ(varyings[0].data, expected);
+  };
+  SUBCASE("sequential") {
+    data::DataReader reader{series, /*max_prefetch=*/2};
+    REQUIRE(reader.num_time_steps() == num_time_steps);
+    for (size_t n = 0; n < num_time_steps; ++n) {
+      const auto snapshot = reader.next();
+      REQUIRE(snapshot != nullptr);
+      check(*snapshot, n);
+    }
+    CHECK(reader.next() == nullptr);
+  }
+  SUBCASE("seek") {
+    data::DataReader reader{series};
+    REQUIRE(reader.next() != nullptr);
+    reader.seek(3);
+    const auto snapshot = reader.next();
+    REQUIRE(snapshot != nullptr);
+    check(*snapshot, 3);
+    reader.seek(num_time_steps);
+    CHECK(reader.next() == nullptr);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,119 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <filesystem>
+#include <format>
+#include <memory>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/data/sharded.hpp"
+#include "tit/data/sqlite.hpp"
+#include "tit/data/storage.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Path to the manifest database. Storage directory is created if needed.
+auto manifest_path(const std::filesystem::path& dir) -> std::filesystem::path {
+  std::filesystem::create_directories(dir);
+  return dir / "manifest.ttdb";
+}
+
+} // namespace
+
+ShardedStorage::ShardedStorage(const std::filesystem::path& dir,
+                               const sqlite::DatabaseOptions& options)
+    : dir_{dir}, options_{options}, manifest_{manifest_path(dir)} {
+  manifest_.configure(options_);
+  manifest_.execute(R"SQL(
+    CREATE TABLE IF NOT EXISTS Shards (
+      id    INTEGER PRIMARY KEY,
+      file  TEXT NOT NULL
+    ) STRICT;
+
+    CREATE TABLE IF NOT EXISTS TimeSteps (
+      id    INTEGER PRIMARY KEY,
+      time  REAL NOT NULL
+    ) STRICT;
+  )SQL");
+}
+
+auto ShardedStorage::shard_path(size_t shard_index) const
+    -> std::filesystem::path {
+  return dir_ / std::format("shard-{:05}.ttdb", shard_index);
+}
+
+auto ShardedStorage::num_shards() const -> size_t {
+  sqlite::Statement statement{manifest_, R"SQL(
+    SELECT COALESCE(MAX(id) + 1, 0) FROM Shards
+  )SQL"};
+  if (!statement.step()) TIT_THROW("Unable to count shards!");
+  return statement.column<size_t>();
+}
+
+auto ShardedStorage::shard(size_t shard_index) -> DataStorage& {
+  if (shard_index >= shards_.size()) shards_.resize(shard_index + 1);
+  auto& shard = shards_[shard_index];
+  if (shard == nullptr) {
+    const auto path = shard_path(shard_index);
+    shard = std::make_unique<DataStorage>(path, options_);
+    sqlite::Statement statement{manifest_, R"SQL(
+      INSERT OR IGNORE INTO Shards (id, file) VALUES (?, ?)
+    )SQL"};
+    statement.run(shard_index, path.filename().native());
+  }
+  return *shard;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto ShardedStorage::num_time_steps() const -> size_t {
+  sqlite::Statement statement{manifest_, R"SQL(
+    SELECT COUNT(*) FROM TimeSteps
+  )SQL"};
+  if (!statement.step()) TIT_THROW("Unable to count time steps!");
+  return statement.column<size_t>();
+}
+
+auto ShardedStorage::time_step_time(size_t index) const -> real_t {
+  sqlite::Statement statement{manifest_, R"SQL(
+    SELECT time FROM TimeSteps WHERE id = ?
+  )SQL"};
+  statement.bind(index);
+  if (!statement.step()) TIT_THROW("Time step {} is not committed.", index);
+  return statement.column<real_t>();
+}
+
+void ShardedStorage::commit_time_step(real_t time) {
+  sqlite::Statement statement{manifest_, R"SQL(
+    INSERT INTO TimeSteps (id, time) VALUES (?, ?)
+  )SQL"};
+  statement.run(num_time_steps(), time);
+}
+
+auto ShardedStorage::shard_time_step(size_t shard_index, size_t index)
+    -> DataTimeStepView<DataStorage> {
+  TIT_ASSERT(index < num_time_steps(), "Time step is not committed!");
+  auto& storage = shard(shard_index);
+  if (storage.num_series() == 0) {
+    TIT_THROW("Shard {} has no data series.", shard_index);
+  }
+  const auto time_step_ids =
+      storage.series_time_step_ids(storage.last_series_id());
+  if (index >= time_step_ids.size()) {
+    TIT_THROW("Shard {} has no time step {}.", shard_index, index);
+  }
+  return DataTimeStepView{storage, time_step_ids[index]};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
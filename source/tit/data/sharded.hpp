@@ -0,0 +1,117 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/sqlite.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Sharded data storage.
+///
+/// Sharded storage is a directory of the regular data storage files, one
+/// shard per rank (or per partition), so that the ranks write concurrently
+/// with no contention for a single SQLite writer, and the output bandwidth
+/// scales with the number of the ranks. Each rank writes the time steps into
+/// the last series of its own shard, and once all of the ranks have written
+/// a time step, it is committed into the manifest, a small SQLite database
+/// in the same directory, that lists the shards and the committed time steps.
+///
+/// Readers only see the committed time steps, and stitch them across the
+/// shards: uniform arrays are read from the first shard, and varying arrays
+/// are concatenated in the shard order.
+class ShardedStorage final {
+public:
+
+  /// Sharded storage is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(ShardedStorage);
+
+  /// Open a sharded storage in the directory or create it if it does not
+  /// exist.
+  ///
+  /// @param options Options of the shard databases.
+  explicit ShardedStorage(const std::filesystem::path& dir,
+                          const sqlite::DatabaseOptions& options = {});
+
+  /// Path to the storage directory.
+  auto path() const -> const std::filesystem::path& {
+    return dir_;
+  }
+
+  /// Path to the shard file.
+  auto shard_path(size_t shard_index) const -> std::filesystem::path;
+
+  /// Number of the registered shards.
+  auto num_shards() const -> size_t;
+
+  /// Open the shard, and register it in the manifest if it is new.
+  auto shard(size_t shard_index) -> DataStorage&;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Number of the committed time steps.
+  auto num_time_steps() const -> size_t;
+
+  /// Time of the committed time step.
+  auto time_step_time(size_t index) const -> real_t;
+
+  /// Commit the next time step into the manifest. Must be called once, e.g.
+  /// by the first rank, after all of the shards have written the time step.
+  void commit_time_step(real_t time);
+
+  /// Time step of the shard, that corresponds to the committed time step.
+  auto shard_time_step(size_t shard_index, size_t index)
+      -> DataTimeStepView<DataStorage>;
+
+  /// Read the uniform data array of the committed time step from the first
+  /// shard.
+  template<known_type_of Val>
+  auto uniform_data(size_t index, std::string_view name) -> std::vector<Val> {
+    const auto array = shard_time_step(0, index).uniforms().find_array(name);
+    if (!array) TIT_THROW("Uniform array '{}' does not exist.", name);
+    return array->template data<Val>();
+  }
+
+  /// Read the varying data array of the committed time step, concatenated
+  /// over the shards. Shards that do not have the array are skipped.
+  template<known_type_of Val>
+  auto varying_data(size_t index, std::string_view name) -> std::vector<Val> {
+    std::vector<Val> result;
+    for (const auto shard_index : std::views::iota(size_t{0}, num_shards())) {
+      const auto array =
+          shard_time_step(shard_index, index).varyings().find_array(name);
+      if (!array) continue;
+      const auto vals = array->template data<Val>();
+      result.insert(result.end(), vals.begin(), vals.end());
+    }
+    return result;
+  }
+
+private:
+
+  std::filesystem::path dir_;
+  sqlite::DatabaseOptions options_;
+  mutable sqlite::Database manifest_;
+  std::vector<std::unique_ptr<DataStorage>> shards_;
+
+}; // class ShardedStorage
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
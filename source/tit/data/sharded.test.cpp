@@ -0,0 +1,70 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <filesystem>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/data/sharded.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::ShardedStorage") {
+  const std::filesystem::path dir{"test_sharded"};
+  std::filesystem::remove_all(dir);
+  {
+    // Write the time steps into the shards, as the ranks would do.
+    data::ShardedStorage storage{dir};
+    for (size_t rank = 0; rank < 2; ++rank) {
+      auto& shard = storage.shard(rank);
+      const auto series = shard.create_series();
+      for (size_t step = 0; step < 2; ++step) {
+        const auto time_step = series.create_time_step(1.0 * step);
+        if (rank == 0) {
+          time_step.uniforms().create_array("step", std::vector{1.0 * step});
+        }
+        time_step.varyings().create_array(
+            "rank",
+            std::vector<float64_t>(rank + 1, 1.0 * rank));
+      }
+    }
+    CHECK(std::filesystem::exists(storage.shard_path(0)));
+    CHECK(std::filesystem::exists(storage.shard_path(1)));
+
+    // Only the first time step is committed.
+    storage.commit_time_step(0.0);
+  }
+  {
+    // Read the stitched time steps.
+    data::ShardedStorage storage{dir};
+    REQUIRE(storage.num_shards() == 2);
+    REQUIRE(storage.num_time_steps() == 1);
+    CHECK(storage.time_step_time(0) == 0.0);
+    CHECK(storage.uniform_data<float64_t>(0, "step") == std::vector{0.0});
+    CHECK(storage.varying_data<float64_t>(0, "rank") ==
+          std::vector{0.0, 1.0, 1.0});
+    CHECK_THROWS_MSG(storage.uniform_data<float64_t>(0, "invalid"),
+                     Exception,
+                     "Uniform array 'invalid' does not exist.");
+
+    // Commit the second time step.
+    storage.commit_time_step(1.0);
+    REQUIRE(storage.num_time_steps() == 2);
+    CHECK(storage.shard_time_step(1, 1).time() == 1.0);
+  }
+  std::filesystem::remove_all(dir);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
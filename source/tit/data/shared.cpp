@@ -0,0 +1,432 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/uint_utils.hpp"
+
+#include "tit/data/shared.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Magic number of the shared memory segment, "TITSHM01".
+constexpr uint64_t SharedMagic = 0x31304D4853544954;
+
+// Alignment of the headers and the array data.
+constexpr size_t SharedAlign = 64;
+
+// Header of the shared memory segment.
+struct alignas(SharedAlign) SegmentHeader final {
+  uint64_t magic;
+  uint64_t num_slots;
+  uint64_t slot_capacity;
+  std::atomic<uint64_t> latest;
+};
+
+// Header of the slot.
+struct alignas(SharedAlign) SlotHeader final {
+  std::atomic<uint64_t> seq;
+  float64_t time;
+  uint64_t num_arrays;
+  uint64_t size;
+};
+
+// Header of the array.
+struct ArrayHeader final {
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t next_offset;
+  uint32_t type_id;
+  uint32_t name_size;
+  uint32_t is_varying;
+  uint32_t reserved;
+};
+
+// Headers are shared between the processes, so the counters must be
+// address-free.
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(sizeof(SegmentHeader) == SharedAlign);
+static_assert(sizeof(SlotHeader) == SharedAlign);
+static_assert(sizeof(ArrayHeader) == 40);
+
+// Size of the slot, including its header.
+constexpr auto slot_stride(size_t capacity) noexcept -> size_t {
+  return sizeof(SlotHeader) + capacity;
+}
+
+// Size of the segment.
+constexpr auto segment_size(size_t capacity, size_t num_slots) noexcept
+    -> size_t {
+  return sizeof(SegmentHeader) + num_slots * slot_stride(capacity);
+}
+
+// Slot of the frame with the given index.
+template<class Byte>
+auto slot_of(std::span<Byte> segment,
+             size_t capacity,
+             size_t num_slots,
+             size_t index) noexcept -> std::span<Byte> {
+  TIT_ASSERT(index > 0, "Frame index must be positive!");
+  const auto stride = slot_stride(capacity);
+  const auto offset = sizeof(SegmentHeader) + (index - 1) % num_slots * stride;
+  return segment.subspan(offset, stride);
+}
+
+// Create a value-initialized object at the start of the bytes.
+template<class Object>
+auto create_at(std::span<byte_t> bytes) noexcept -> Object& {
+  TIT_ASSERT(bytes.size() >= sizeof(Object), "Bytes are too short!");
+  // NOLINTNEXTLINE(*-reinterpret-cast)
+  return *std::construct_at(reinterpret_cast<Object*>(bytes.data()));
+}
+
+// Object that is placed at the start of the bytes.
+template<class Object, class Byte>
+auto object_at(std::span<Byte> bytes) noexcept -> auto& {
+  TIT_ASSERT(bytes.size() >= sizeof(Object), "Bytes are too short!");
+  using Ptr =
+      std::conditional_t<std::is_const_v<Byte>, const Object*, Object*>;
+  // NOLINTNEXTLINE(*-reinterpret-cast)
+  return *std::launder(reinterpret_cast<Ptr>(bytes.data()));
+}
+
+// Output stream that appends the bytes to the frame data.
+class SlotOutputStream final : public OutputStream<byte_t> {
+public:
+
+  SlotOutputStream(std::span<byte_t> slot, size_t& size) noexcept
+      : slot_{slot}, size_{&size} {}
+
+  void write(std::span<const byte_t> data) override {
+    if (data.size() > slot_.size() - *size_) {
+      TIT_THROW("Frame does not fit into the shared memory slot of {} bytes.",
+                slot_.size() - sizeof(SlotHeader));
+    }
+    std::ranges::copy(data, slot_.subspan(*size_).begin());
+    *size_ += data.size();
+  }
+
+  void flush() override {
+    // Nothing to do.
+  }
+
+private:
+
+  std::span<byte_t> slot_;
+  size_t* size_;
+
+}; // class SlotOutputStream
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto SharedFrame::open_array_(bool is_varying,
+                              std::string_view name,
+                              DataType type) -> OutputStreamPtr<byte_t> {
+  TIT_ASSERT(array_offset_ == 0, "Previous array must be closed!");
+  const auto name_offset = size_ + sizeof(ArrayHeader);
+  const auto data_offset = align_up(name_offset + name.size(), SharedAlign);
+  if (data_offset > slot_.size()) {
+    TIT_THROW("Frame does not fit into the shared memory slot of {} bytes.",
+              slot_.size() - sizeof(SlotHeader));
+  }
+  array_offset_ = size_;
+  auto& header = create_at<ArrayHeader>(slot_.subspan(array_offset_));
+  header.data_offset = data_offset;
+  header.type_id = type.id();
+  header.name_size = static_cast<uint32_t>(name.size());
+  header.is_varying = static_cast<uint32_t>(is_varying);
+  std::ranges::copy(std::as_bytes(std::span{name}),
+                    slot_.subspan(name_offset).begin());
+  size_ = data_offset;
+  return make_flushable<SlotOutputStream>(slot_, size_);
+}
+
+void SharedFrame::close_array_() {
+  TIT_ASSERT(array_offset_ != 0, "No array is open!");
+  auto& header = object_at<ArrayHeader>(slot_.subspan(array_offset_));
+  header.data_size = size_ - header.data_offset;
+  header.next_offset = align_up(size_, SharedAlign);
+  size_ = header.next_offset;
+  array_offset_ = 0;
+  num_arrays_ += 1;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+SharedChannel::SharedChannel(std::string name,
+                             size_t slot_capacity,
+                             size_t num_slots)
+    : name_{std::move(name)},
+      slot_capacity_{align_up(slot_capacity, SharedAlign)},
+      num_slots_{num_slots} {
+  TIT_ASSERT(slot_capacity_ > 0, "Slot capacity must be positive!");
+  if (num_slots_ < 2) {
+    TIT_THROW("Shared channel must have at least two slots, got {}.",
+              num_slots_);
+  }
+
+  // Replace the stale segment, e.g. of a crashed run, if any.
+  shm_unlink(name_.c_str());
+  // NOLINTNEXTLINE(*-vararg)
+  const auto fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) TIT_THROW("Failed to create shared memory '{}'.", name_);
+  const auto size = segment_size(slot_capacity_, num_slots_);
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    shm_unlink(name_.c_str());
+    TIT_THROW("Failed to resize shared memory '{}' to {} bytes.", name_, size);
+  }
+  // The descriptor is not needed once the mapping is established.
+  auto* const addr =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) { // NOLINT(*-cstyle-cast,*-int-to-ptr)
+    shm_unlink(name_.c_str());
+    TIT_THROW("Failed to map shared memory '{}'.", name_);
+  }
+  segment_ = {static_cast<byte_t*>(addr), size};
+
+  // Initialize the headers. Magic number is published last, so that the
+  // readers never attach to a partially initialized segment.
+  for (size_t index = 1; index <= num_slots_; ++index) {
+    create_at<SlotHeader>(slot_of(segment_, slot_capacity_, num_slots_, index));
+  }
+  auto& header = create_at<SegmentHeader>(segment_);
+  header.num_slots = num_slots_;
+  header.slot_capacity = slot_capacity_;
+  header.latest.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header.magic = SharedMagic;
+}
+
+// NOLINTNEXTLINE(*-exception-escape)
+SharedChannel::~SharedChannel() noexcept {
+  if (munmap(segment_.data(), segment_.size()) != 0) {
+    TIT_ERROR("Failed to unmap shared memory '{}'.", name_);
+  }
+  if (shm_unlink(name_.c_str()) != 0) {
+    TIT_ERROR("Failed to remove shared memory '{}'.", name_);
+  }
+}
+
+auto SharedChannel::acquire(real_t time) -> SharedFrame {
+  // Frame that was acquired but not submitted is overwritten.
+  const auto index = num_frames_ + 1;
+  const auto slot = slot_of(segment_, slot_capacity_, num_slots_, index);
+  auto& header = object_at<SlotHeader>(slot);
+
+  // Invalidate the slot before its data is overwritten.
+  header.seq.store(2 * index - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header.time = static_cast<float64_t>(time);
+  header.num_arrays = 0;
+  header.size = 0;
+
+  SharedFrame frame{index, slot};
+  frame.size_ = sizeof(SlotHeader);
+  return frame;
+}
+
+void SharedChannel::submit(SharedFrame frame) {
+  TIT_ASSERT(frame.index_ == num_frames_ + 1,
+             "Frame was not acquired from the channel!");
+  TIT_ASSERT(frame.array_offset_ == 0, "Frame has an open array!");
+  auto& header = object_at<SlotHeader>(frame.slot_);
+  header.num_arrays = frame.num_arrays_;
+  header.size = frame.size_;
+  header.seq.store(2 * frame.index_, std::memory_order_release);
+  object_at<SegmentHeader>(segment_).latest.store(frame.index_,
+                                                  std::memory_order_release);
+  num_frames_ = frame.index_;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto SharedFrameView::is_intact() const noexcept -> bool {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const auto& header = object_at<SlotHeader>(slot_);
+  return header.seq.load(std::memory_order_relaxed) == 2 * index_;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+SharedChannelReader::SharedChannelReader(const std::string& name) {
+  // NOLINTNEXTLINE(*-vararg)
+  const auto fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) TIT_THROW("Failed to open shared memory '{}'.", name);
+  struct stat segment_stat = {};
+  if (fstat(fd, &segment_stat) != 0) {
+    close(fd);
+    TIT_THROW("Failed to query the size of shared memory '{}'.", name);
+  }
+  const auto size = static_cast<size_t>(segment_stat.st_size);
+  if (size < sizeof(SegmentHeader)) {
+    close(fd);
+    TIT_THROW("Shared memory '{}' is not a shared channel.", name);
+  }
+  // The descriptor is not needed once the mapping is established.
+  auto* const addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) { // NOLINT(*-cstyle-cast,*-int-to-ptr)
+    TIT_THROW("Failed to map shared memory '{}'.", name);
+  }
+  segment_ = {static_cast<const byte_t*>(addr), size};
+
+  // Validate the segment header.
+  const auto& header = object_at<SegmentHeader>(segment_);
+  const auto magic = header.magic;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  num_slots_ = header.num_slots;
+  slot_capacity_ = header.slot_capacity;
+  if (magic != SharedMagic || num_slots_ == 0 ||
+      segment_size(slot_capacity_, num_slots_) != size) {
+    munmap(addr, size);
+    segment_ = {};
+    TIT_THROW("Shared memory '{}' is not a shared channel.", name);
+  }
+}
+
+SharedChannelReader::SharedChannelReader(SharedChannelReader&& other) noexcept
+    : segment_{std::exchange(other.segment_, {})},
+      slot_capacity_{std::exchange(other.slot_capacity_, 0)},
+      num_slots_{std::exchange(other.num_slots_, 0)} {}
+
+auto SharedChannelReader::operator=(SharedChannelReader&& other) noexcept
+    -> SharedChannelReader& {
+  std::swap(segment_, other.segment_);
+  std::swap(slot_capacity_, other.slot_capacity_);
+  std::swap(num_slots_, other.num_slots_);
+  return *this;
+}
+
+// NOLINTNEXTLINE(*-exception-escape)
+SharedChannelReader::~SharedChannelReader() noexcept {
+  if (segment_.empty()) return; // NOLINTNEXTLINE(*-const-cast)
+  if (munmap(const_cast<byte_t*>(segment_.data()), segment_.size()) != 0) {
+    TIT_ERROR("Failed to unmap shared memory.");
+  }
+}
+
+auto SharedChannelReader::latest_index() const noexcept -> size_t {
+  TIT_ASSERT(!segment_.empty(), "Reader is not attached!");
+  const auto& header = object_at<SegmentHeader>(segment_);
+  return header.latest.load(std::memory_order_acquire);
+}
+
+auto SharedChannelReader::view() const -> std::optional<SharedFrameView> {
+  TIT_ASSERT(!segment_.empty(), "Reader is not attached!");
+  while (true) {
+    const auto index = latest_index();
+    if (index == 0) return std::nullopt;
+    SharedFrameView frame;
+    frame.index_ = index;
+    frame.slot_ = slot_of(segment_, slot_capacity_, num_slots_, index);
+    const auto& slot = frame.slot_;
+    const auto& header = object_at<SlotHeader>(slot);
+    if (header.seq.load(std::memory_order_acquire) != 2 * index) {
+      continue; // Slot is already overwritten with a newer frame.
+    }
+    frame.time_ = header.time;
+
+    // Parse the arrays. Writer may overwrite the slot meanwhile, so all the
+    // offsets are checked, and the results are only trusted if the frame
+    // is still intact after parsing.
+    struct Record final {
+      std::string_view name;
+      uint32_t type_id;
+      bool is_varying;
+      std::span<const byte_t> data;
+    };
+    std::vector<Record> records;
+    bool is_valid = header.num_arrays <= slot.size() / sizeof(ArrayHeader);
+    for (size_t i = 0, offset = sizeof(SlotHeader);
+         is_valid && i < header.num_arrays;
+         ++i) {
+      if (offset % alignof(ArrayHeader) != 0 ||
+          offset + sizeof(ArrayHeader) > slot.size()) {
+        is_valid = false;
+        break;
+      }
+      const auto array = object_at<ArrayHeader>(slot.subspan(offset));
+      const auto name_offset = offset + sizeof(ArrayHeader);
+      if (array.name_size > slot.size() - name_offset ||
+          array.data_offset > slot.size() ||
+          array.data_size > slot.size() - array.data_offset ||
+          array.next_offset <= offset) {
+        is_valid = false;
+        break;
+      }
+      const auto name = slot.subspan(name_offset, array.name_size);
+      records.push_back(
+          {.name = {reinterpret_cast<const char*>(name.data()), // NOLINT
+                    name.size()},
+           .type_id = array.type_id,
+           .is_varying = array.is_varying != 0,
+           .data = slot.subspan(array.data_offset, array.data_size)});
+      offset = array.next_offset;
+    }
+    if (!frame.is_intact()) continue;
+    if (!is_valid) TIT_THROW("Shared channel frame {} is corrupted.", index);
+
+    frame.arrays_.reserve(records.size());
+    for (const auto& record : records) {
+      frame.arrays_.push_back({.name = record.name,
+                               .type = DataType{record.type_id},
+                               .is_varying = record.is_varying,
+                               .data = record.data});
+    }
+    return frame;
+  }
+}
+
+auto SharedChannelReader::read(DataTimeStepSnapshot& snapshot) const
+    -> size_t {
+  while (true) {
+    const auto frame = view();
+    if (!frame) return 0;
+    snapshot.reset(static_cast<real_t>(frame->time()));
+    for (const auto& array : frame->arrays()) {
+      auto& dataset =
+          array.is_varying ? snapshot.varyings() : snapshot.uniforms();
+      dataset.create_array(
+          array.name,
+          array.type,
+          std::vector<byte_t>(array.data.begin(), array.data.end()));
+    }
+    if (frame->is_intact()) return frame->index();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,287 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Time step frame that is being written into a slot of the shared channel.
+///
+/// Array data is serialized directly into the shared memory, so the
+/// contiguous arrays are written with a single copy.
+class SharedFrame final {
+public:
+
+  /// Dataset of the frame.
+  class DataSet final {
+  public:
+
+    /// Write the values into a new data array.
+    template<std::ranges::input_range Vals>
+      requires known_type_of<std::ranges::range_value_t<Vals>>
+    void create_array(std::string_view name, Vals&& vals) {
+      TIT_ASSUME_UNIVERSAL(Vals, vals);
+      using Val = std::ranges::range_value_t<Vals>;
+      write_values(frame_->open_array_(is_varying_, name, type_of<Val>), vals);
+      frame_->close_array_();
+    }
+
+    /// Write the serialized data into a new data array.
+    void create_array(std::string_view name,
+                      DataType type,
+                      std::span<const byte_t> data) {
+      frame_->open_array_(is_varying_, name, type)->write(data);
+      frame_->close_array_();
+    }
+
+  private:
+
+    friend class SharedFrame;
+
+    constexpr DataSet(SharedFrame& frame, bool is_varying) noexcept
+        : frame_{&frame}, is_varying_{is_varying} {}
+
+    SharedFrame* frame_;
+    bool is_varying_;
+
+  }; // class DataSet
+
+  /// Move-construct the frame.
+  SharedFrame(SharedFrame&&) noexcept = default;
+
+  /// Move-assign the frame.
+  auto operator=(SharedFrame&&) noexcept -> SharedFrame& = default;
+
+  TIT_MOVE_ONLY(SharedFrame);
+
+  /// Frame index, starting from one.
+  auto index() const noexcept -> size_t {
+    return index_;
+  }
+
+  /// Uniform data.
+  auto uniforms() noexcept -> DataSet {
+    return DataSet{*this, /*is_varying=*/false};
+  }
+
+  /// Varying data.
+  auto varyings() noexcept -> DataSet {
+    return DataSet{*this, /*is_varying=*/true};
+  }
+
+private:
+
+  friend class SharedChannel;
+
+  SharedFrame(size_t index, std::span<byte_t> slot) noexcept
+      : index_{index}, slot_{slot} {}
+
+  auto open_array_(bool is_varying, std::string_view name, DataType type)
+      -> OutputStreamPtr<byte_t>;
+  void close_array_();
+
+  size_t index_;
+  std::span<byte_t> slot_;
+  size_t size_ = 0;
+  size_t array_offset_ = 0;
+  size_t num_arrays_ = 0;
+
+}; // class SharedFrame
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Channel that passes the time step frames from the solver to the external
+/// processes on the same machine, such as the in-situ visualization and
+/// analysis tools, through a POSIX shared memory segment.
+///
+/// Segment is a ring of fixed-size slots, each holds a single frame. Frames
+/// are written into the slots in turn, and the index of the latest complete
+/// frame is published. Each slot is guarded by a sequence counter, so that
+/// any number of readers could read the frames in place, with no locks and
+/// no involvement of the solver threads, see `SharedChannelReader`. Readers
+/// that are slower than the solver skip the frames, so the solver never
+/// waits for them: a reader has the time of `num_slots - 1` frames to read
+/// a frame before it is overwritten.
+///
+/// Segment layout, all numbers are in the native byte order, and all the
+/// offsets are relative to the slot start:
+/// - segment header: magic number (`uint64_t`), number of the slots
+///   (`uint64_t`), slot capacity (`uint64_t`), and the index of the latest
+///   complete frame (`uint64_t`, zero if nothing was written), padded to 64
+///   bytes;
+/// - slots, each consists of the slot header and the capacity bytes. Slot
+///   header is the sequence counter (`uint64_t`, `2 * index - 1` while the
+///   frame `index` is written, and `2 * index` once it is complete), the
+///   time (`float64_t`), the number of the arrays (`uint64_t`), and the
+///   used size (`uint64_t`), padded to 64 bytes.
+///
+/// Arrays follow the slot header one by one, each consists of the array
+/// header and the array name. Array header is the data offset, aligned to
+/// 64 bytes, the data size, and the offset of the next array (`uint64_t`
+/// each), the data type identifier (`uint32_t`, see `DataType::id`), the
+/// name size (`uint32_t`), the dataset (`uint32_t`, zero for the uniform
+/// and one for the varying data), and the four reserved bytes.
+class SharedChannel final {
+public:
+
+  /// Create a shared memory segment.
+  ///
+  /// @param name          Segment name, e.g. `/tit-wcsph`. Existing segment
+  ///                      with the same name is replaced.
+  /// @param slot_capacity Capacity of each slot in bytes.
+  /// @param num_slots     Number of the slots, at least two.
+  explicit SharedChannel(std::string name,
+                         size_t slot_capacity,
+                         size_t num_slots = 4);
+
+  /// Shared channel is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(SharedChannel);
+
+  /// Unmap and remove the shared memory segment. Readers that are already
+  /// attached keep their mappings.
+  ~SharedChannel() noexcept;
+
+  /// Segment name.
+  auto name() const noexcept -> const std::string& {
+    return name_;
+  }
+
+  /// Number of the submitted frames.
+  auto num_frames() const noexcept -> size_t {
+    return num_frames_;
+  }
+
+  /// Start writing the next frame into the next slot. Previous frame must be
+  /// submitted.
+  auto acquire(real_t time) -> SharedFrame;
+
+  /// Publish the frame as the latest one.
+  void submit(SharedFrame frame);
+
+private:
+
+  std::string name_;
+  size_t slot_capacity_;
+  size_t num_slots_;
+  std::span<byte_t> segment_;
+  size_t num_frames_ = 0;
+  bool is_writing_ = false;
+
+}; // class SharedChannel
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Array of the shared frame, that is read in place.
+struct SharedArrayView final {
+  /// Array name.
+  std::string_view name;
+
+  /// Array data type.
+  DataType type;
+
+  /// Is the array varying?
+  bool is_varying;
+
+  /// Serialized array data.
+  std::span<const byte_t> data;
+};
+
+/// Frame of the shared channel, that is read in place.
+///
+/// Writer may overwrite the slot while the frame is read, so the data must
+/// only be trusted if the frame is still intact after it was read.
+class SharedFrameView final {
+public:
+
+  /// Frame index, starting from one.
+  auto index() const noexcept -> size_t {
+    return index_;
+  }
+
+  /// Time step time.
+  auto time() const noexcept -> float64_t {
+    return time_;
+  }
+
+  /// Arrays of the frame.
+  auto arrays() const noexcept -> std::span<const SharedArrayView> {
+    return arrays_;
+  }
+
+  /// Check if the frame was not overwritten since the view was created.
+  auto is_intact() const noexcept -> bool;
+
+private:
+
+  friend class SharedChannelReader;
+
+  SharedFrameView() = default;
+
+  std::span<const byte_t> slot_;
+  size_t index_ = 0;
+  float64_t time_ = 0.0;
+  std::vector<SharedArrayView> arrays_;
+
+}; // class SharedFrameView
+
+/// Reader of the shared channel, that runs in the external process.
+class SharedChannelReader final {
+public:
+
+  /// Attach to the shared memory segment created by the `SharedChannel`.
+  explicit SharedChannelReader(const std::string& name);
+
+  /// Move-construct the reader.
+  SharedChannelReader(SharedChannelReader&& other) noexcept;
+
+  /// Move-assign the reader.
+  auto operator=(SharedChannelReader&& other) noexcept
+      -> SharedChannelReader&;
+
+  TIT_MOVE_ONLY(SharedChannelReader);
+
+  /// Detach from the shared memory segment.
+  ~SharedChannelReader() noexcept;
+
+  /// Index of the latest complete frame. Zero if nothing was written.
+  auto latest_index() const noexcept -> size_t;
+
+  /// View the latest complete frame in place, without copying.
+  auto view() const -> std::optional<SharedFrameView>;
+
+  /// Copy the latest complete frame into the snapshot.
+  ///
+  /// @returns Index of the frame, or zero if nothing was written, in which
+  ///          case the snapshot is left unchanged.
+  auto read(DataTimeStepSnapshot& snapshot) const -> size_t;
+
+private:
+
+  std::span<const byte_t> segment_;
+  size_t slot_capacity_ = 0;
+  size_t num_slots_ = 0;
+
+}; // class SharedChannelReader
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,118 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstring>
+#include <format>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/data/shared.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Copy the serialized data into the values.
+auto to_values(std::span<const byte_t> data) -> std::vector<float64_t> {
+  std::vector<float64_t> values(data.size() / sizeof(float64_t));
+  std::memcpy(values.data(), data.data(), data.size());
+  return values;
+}
+
+TEST_CASE("data::SharedChannel") {
+  const auto name = std::format("/tit_shared_test_{}", getpid());
+  data::SharedChannel channel{name, /*slot_capacity=*/4096, /*num_slots=*/2};
+  data::SharedChannelReader reader{name};
+  data::DataTimeStepSnapshot snapshot;
+
+  // Nothing can be read before the first frame is submitted.
+  CHECK(reader.latest_index() == 0);
+  CHECK_FALSE(reader.view().has_value());
+  CHECK(reader.read(snapshot) == 0);
+
+  // Write the frames, and read the latest one.
+  const std::vector<float64_t> h{0.1};
+  const auto write_frame = [&channel, &h](size_t index) {
+    auto frame = channel.acquire(static_cast<real_t>(index));
+    CHECK(frame.index() == index);
+    frame.uniforms().create_array("h", h);
+    frame.varyings().create_array(
+        "rho",
+        std::vector<float64_t>(10, static_cast<float64_t>(index)));
+    channel.submit(std::move(frame));
+  };
+  for (size_t index = 1; index <= 3; ++index) {
+    write_frame(index);
+    CHECK(channel.num_frames() == index);
+    CHECK(reader.latest_index() == index);
+    REQUIRE(reader.read(snapshot) == index);
+    CHECK(snapshot.time() == static_cast<real_t>(index));
+    const auto uniforms = snapshot.uniforms().arrays();
+    REQUIRE(uniforms.size() == 1);
+    CHECK(uniforms[0].name == "h");
+    CHECK(uniforms[0].type == data::type_of<float64_t>);
+    CHECK_RANGE_EQ(to_values(uniforms[0].data), h);
+    const auto varyings = snapshot.varyings().arrays();
+    REQUIRE(varyings.size() == 1);
+    CHECK(varyings[0].name == "rho");
+    CHECK_RANGE_EQ(to_values(varyings[0].data),
+                   std::vector<float64_t>(10, static_cast<float64_t>(index)));
+  }
+
+  // View the latest frame in place. It stays intact until its slot is
+  // reused by the writer.
+  const auto frame = reader.view();
+  REQUIRE(frame.has_value());
+  CHECK(frame->index() == 3);
+  CHECK(frame->time() == 3.0);
+  REQUIRE(frame->arrays().size() == 2);
+  CHECK(frame->arrays()[0].name == "h");
+  CHECK_FALSE(frame->arrays()[0].is_varying);
+  CHECK(frame->arrays()[1].name == "rho");
+  CHECK(frame->arrays()[1].is_varying);
+  CHECK_RANGE_EQ(to_values(frame->arrays()[1].data),
+                 std::vector<float64_t>(10, 3.0));
+  CHECK(frame->is_intact());
+  write_frame(4);
+  CHECK(frame->is_intact());
+  write_frame(5);
+  CHECK_FALSE(frame->is_intact());
+
+  // Frames that do not fit into the slot are rejected, and the latest
+  // complete frame is still read.
+  {
+    auto big_frame = channel.acquire(6.0);
+    CHECK_THROWS_MSG(big_frame.varyings().create_array(
+                         "rho",
+                         std::vector<float64_t>(1024, 6.0)),
+                     Exception,
+                     "Frame does not fit into the shared memory slot");
+  }
+  CHECK(reader.read(snapshot) == 5);
+  write_frame(6);
+  CHECK(reader.read(snapshot) == 6);
+
+  // Readers only attach to the existing channels.
+  CHECK_THROWS_MSG(data::SharedChannelReader{name + "_missing"},
+                   Exception,
+                   "Failed to open shared memory");
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
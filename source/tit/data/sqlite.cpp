@@ -6,12 +6,15 @@
 #include <algorithm>
 #include <bit>
 #include <cctype>
+#include <exception>
 #include <filesystem>
 #include <format>
 #include <limits>
+#include <memory>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 
 #include <sqlite3.h>
 
@@ -19,6 +22,7 @@
 #include "tit/core/checks.hpp"
 #include "tit/core/exception.hpp"
 #include "tit/core/log.hpp"
+#include "tit/core/profiler.hpp"
 #include "tit/core/str_utils.hpp"
 #include "tit/core/utils.hpp"
 
@@ -41,13 +45,14 @@ auto error_message(int status, sqlite3* db = nullptr) -> std::string {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-Database::Database(const std::filesystem::path& path) {
+Database::Database(const std::filesystem::path& path, OpenMode mode) {
+  using enum OpenMode;
+  const int flags = translate<int>(mode)
+                        .option(read_write,
+                                SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)
+                        .option(read_only, SQLITE_OPEN_READONLY);
   sqlite3* db = nullptr;
-  const auto status = sqlite3_open_v2( //
-      path.c_str(),
-      &db,
-      SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
-      nullptr);
+  const auto status = sqlite3_open_v2(path.c_str(), &db, flags, nullptr);
   if (status != SQLITE_OK) {
     TIT_THROW("SQLite database open failed ({}): {}",
               status,
@@ -77,6 +82,34 @@ auto Database::path() const -> std::filesystem::path {
   return path;
 }
 
+void Database::configure(const DatabaseOptions& options) {
+  // Page size must be set before anything is written.
+  if (options.page_size != 0) {
+    if (!std::has_single_bit(options.page_size) ||
+        !in_range(options.page_size, 512, 65536)) {
+      TIT_THROW("Invalid SQLite page size: {}.", options.page_size);
+    }
+    execute(std::format("PRAGMA page_size = {}", options.page_size));
+  }
+  using enum JournalMode;
+  execute(translate<CStrView>(options.journal_mode)
+              .option(rollback, "PRAGMA journal_mode = DELETE")
+              .option(wal, "PRAGMA journal_mode = WAL"));
+  using enum Synchronous;
+  execute(translate<CStrView>(options.synchronous)
+              .option(off, "PRAGMA synchronous = OFF")
+              .option(normal, "PRAGMA synchronous = NORMAL")
+              .option(full, "PRAGMA synchronous = FULL"));
+  execute(std::format("PRAGMA mmap_size = {}", options.mmap_size));
+  if (options.cache_size != 0) {
+    // Note: negative cache size is the size in KiB, not in pages.
+    execute(std::format("PRAGMA cache_size = -{}", options.cache_size));
+  }
+  TIT_ASSERT(options.busy_timeout <= std::numeric_limits<int>::max(),
+             "Busy timeout is too large!");
+  sqlite3_busy_timeout(base(), static_cast<int>(options.busy_timeout));
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 void Database::execute(CStrView sql) const {
@@ -100,14 +133,40 @@ auto Database::last_insert_row_id() const -> RowID {
   return sqlite3_last_insert_rowid(base());
 }
 
+auto Database::changes() const -> size_t {
+  return static_cast<size_t>(sqlite3_changes64(base()));
+}
+
+auto Database::in_transaction() const -> bool {
+  return sqlite3_get_autocommit(base()) == 0;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-Statement::Statement(Database& db, std::string_view sql) : db_{&db} {
+void Database::StmtFinalizer_::operator()(sqlite3_stmt* stmt) {
+  if (const auto status = sqlite3_finalize(stmt); status != SQLITE_OK) {
+    // `sqlite3_finalize` returns an error code if any usage of the statement
+    // resulted in an error, so we've must have already thrown an exception.
+    // So, let's just log the error here and return peacefully.
+    TIT_ERROR("SQLite statement close failed ({}): {}",
+              status,
+              error_message(status));
+  }
+}
+
+auto Database::acquire_stmt_(std::string_view sql) -> StmtPtr_ {
   TIT_ASSERT(!sql.empty(), "SQL statement is null!");
   TIT_ASSERT(sql.size() <= std::numeric_limits<int>::max(), "SQL is too big!");
 
+  // Reuse the cached statement, if any.
+  if (const auto iter = stmts_.find(sql); iter != stmts_.end()) {
+    auto stmt = std::move(iter->second);
+    stmts_.erase(iter);
+    return stmt;
+  }
+
   sqlite3_stmt* stmt = nullptr;
-  if (const auto status = sqlite3_prepare_v3(db_->base(),
+  if (const auto status = sqlite3_prepare_v3(base(),
                                              sql.data(),
                                              static_cast<int>(sql.size()),
                                              SQLITE_PREPARE_PERSISTENT,
@@ -117,24 +176,55 @@ Statement::Statement(Database& db, std::string_view sql) : db_{&db} {
     TIT_THROW("SQLite statement '{}' prepare failed ({}): {}",
               sql,
               status,
-              error_message(status, db_->base()));
+              error_message(status, base()));
   }
+  return StmtPtr_{stmt};
+}
 
-  stmt_.reset(stmt);
-  state_ = State_::prepared;
+void Database::release_stmt_(std::string_view sql, StmtPtr_ stmt) {
+  TIT_ASSERT(stmt != nullptr, "Statement is null!");
+
+  // Note: `sqlite3_reset` returns the error code of the last step, if it
+  //       failed. It was already reported, so the code is ignored here.
+  sqlite3_reset(stmt.get());
+  sqlite3_clear_bindings(stmt.get());
+  stmts_.emplace(sql, std::move(stmt));
 }
 
-void Statement::Finalizer_::operator()(sqlite3_stmt* stmt) {
-  if (const auto status = sqlite3_finalize(stmt); status != SQLITE_OK) {
-    // `sqlite3_finalize` returns an error code if any usage of the statement
-    // resulted in an error, so we've must have already thrown an exception.
-    // So, let's just log the error here and return peacefully.
-    TIT_ERROR("SQLite statement close failed ({}): {}",
-              status,
-              error_message(status));
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Transaction::Transaction(Database& db)
+    : db_{&db}, is_outermost_{!db.in_transaction()} {
+  if (is_outermost_) db_->execute("BEGIN");
+}
+
+Transaction::~Transaction() noexcept {
+  if (!is_outermost_ || is_finished_) return;
+  try {
+    db_->execute("ROLLBACK");
+  } catch (const std::exception& e) {
+    // Let's not throw in destructors.
+    TIT_ERROR("SQLite transaction rollback failed: {}", e.what());
   }
 }
 
+void Transaction::commit() {
+  TIT_ASSERT(!is_finished_, "Transaction was already committed!");
+  if (is_outermost_) db_->execute("COMMIT");
+  is_finished_ = true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Statement::Statement(Database& db, std::string_view sql)
+    : db_{&db}, sql_{sql}, stmt_{db_->acquire_stmt_(sql_)} {
+  state_ = State_::prepared;
+}
+
+Statement::~Statement() {
+  if (stmt_ != nullptr) db_->release_stmt_(sql_, std::move(stmt_));
+}
+
 auto Statement::base() const noexcept -> sqlite3_stmt* {
   TIT_ASSERT(stmt_.get() != nullptr, "Statement was moved away!");
   return stmt_.get();
@@ -423,14 +513,55 @@ void BlobWriter::write(std::span<const byte_t> data) {
   buffer_.insert(buffer_.end(), data.begin(), data.end());
 }
 
+void BlobWriter::Finalizer_::operator()(sqlite3_blob* blob) {
+  const auto status = sqlite3_blob_close(blob);
+  if (status != SQLITE_OK) {
+    // Let's not throw in destructors.
+    TIT_ERROR("SQLite blob close failed ({}): {}",
+              status,
+              error_message(status));
+  }
+}
+
 void BlobWriter::flush() {
-  // Note: we cannot set table and column names as arguments, so we have to
-  //       construct the SQL statement code manually.
-  const auto sql = std::format("UPDATE {} SET {} = ? WHERE rowid = ?",
+  Profiler::track_memory("BlobWriter", buffer_.capacity());
+
+  // Reserve the blob of the exact size. Note: we cannot set table and column
+  // names as arguments, so we have to construct the SQL statement code
+  // manually.
+  const auto sql = std::format("UPDATE {} SET {} = zeroblob(?) WHERE rowid = ?",
                                table_name_,
                                column_name_);
   Statement statement{*db_, sql};
-  statement.run(buffer_, row_id_);
+  statement.run(buffer_.size(), row_id_);
+  if (buffer_.empty()) return;
+
+  // Write the data into the reserved blob.
+  sqlite3_blob* blob_ptr = nullptr;
+  if (const auto status = sqlite3_blob_open(db_->base(),
+                                            "main",
+                                            table_name_.c_str(),
+                                            column_name_.c_str(),
+                                            row_id_,
+                                            /*flags=*/1, // Read-write.
+                                            &blob_ptr);
+      status != SQLITE_OK) {
+    TIT_THROW("SQLite blob open failed ({}): {}",
+              status,
+              error_message(status, db_->base()));
+  }
+  const std::unique_ptr<sqlite3_blob, Finalizer_> blob{blob_ptr};
+  TIT_ASSERT(buffer_.size() <= std::numeric_limits<int>::max(),
+             "Data size is too large!");
+  if (const auto status = sqlite3_blob_write(blob.get(),
+                                             buffer_.data(),
+                                             static_cast<int>(buffer_.size()),
+                                             /*iOffset=*/0);
+      status != SQLITE_OK) {
+    TIT_THROW("SQLite blob write failed ({}): {}",
+              status,
+              error_message(status, db_->base()));
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
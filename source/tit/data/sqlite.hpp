@@ -7,6 +7,8 @@
 
 #include <concepts>
 #include <filesystem>
+#include <functional>
+#include <map>
 #include <memory>
 #include <ranges>
 #include <span>
@@ -19,6 +21,7 @@
 #include "tit/core/checks.hpp"
 #include "tit/core/str_utils.hpp"
 #include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
 
 struct sqlite3;
 struct sqlite3_stmt;
@@ -31,6 +34,65 @@ using RowID = int64_t;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// SQLite database open mode.
+enum class OpenMode : uint8_t {
+  /// Open the database for reading and writing, create it if it does not
+  /// exist.
+  read_write,
+
+  /// Open the existing database for reading only.
+  read_only,
+};
+
+/// SQLite journal mode.
+enum class JournalMode : uint8_t {
+  /// Rollback journal that is deleted at the end of each transaction.
+  /// Readers and writers block each other.
+  rollback,
+
+  /// Write-ahead log. Readers do not block the writer, and the writer does
+  /// not block the readers, so the database can be read while it is being
+  /// written by another process.
+  wal,
+};
+
+/// SQLite synchronization level.
+enum class Synchronous : uint8_t {
+  /// No syncs, data may be lost on a power failure.
+  off,
+
+  /// Sync at the critical moments only. In WAL mode, a power failure may
+  /// roll back the last transactions, but never corrupts the database.
+  normal,
+
+  /// Sync on every transaction commit.
+  full,
+};
+
+/// SQLite database options.
+struct DatabaseOptions final {
+  /// Journal mode.
+  JournalMode journal_mode = JournalMode::wal;
+
+  /// Synchronization level.
+  Synchronous synchronous = Synchronous::normal;
+
+  /// Page size (in bytes), must be a power of two between 512 and 65536.
+  /// Only applies to the new databases. Zero keeps the SQLite default.
+  size_t page_size = 0;
+
+  /// Maximum amount of the database file that is memory-mapped for reading
+  /// (in bytes). Zero disables memory mapping.
+  size_t mmap_size = 0;
+
+  /// Maximum page cache size (in KiB). Zero keeps the SQLite default.
+  size_t cache_size = 0;
+
+  /// Time to wait for the lock held by another connection (in milliseconds)
+  /// before failing with the "database is locked" error.
+  size_t busy_timeout = 5000;
+};
+
 /// SQLite database.
 class Database final {
 public:
@@ -38,7 +100,8 @@ public:
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Open or create a database file.
-  explicit Database(const std::filesystem::path& path);
+  explicit Database(const std::filesystem::path& path,
+                    OpenMode mode = OpenMode::read_write);
 
   /// SQLite database object.
   auto base() const noexcept -> sqlite3*;
@@ -46,6 +109,9 @@ public:
   /// Database path, empty if in-memory.
   auto path() const -> std::filesystem::path;
 
+  /// Apply the database options.
+  void configure(const DatabaseOptions& options);
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Execute a SQL statement.
@@ -54,20 +120,73 @@ public:
   /// Get the last insert row ID.
   auto last_insert_row_id() const -> RowID;
 
+  /// Get the number of rows changed by the last statement.
+  auto changes() const -> size_t;
+
+  /// Check if a transaction is active.
+  auto in_transaction() const -> bool;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  friend class Statement;
+
   struct Closer_ final {
     static void operator()(sqlite3* db);
   };
 
+  struct StmtFinalizer_ final {
+    static void operator()(sqlite3_stmt* stmt);
+  };
+
+  using StmtPtr_ = std::unique_ptr<sqlite3_stmt, StmtFinalizer_>;
+
+  // Prepare a statement, or take the cached one that was prepared from the
+  // same SQL code before.
+  auto acquire_stmt_(std::string_view sql) -> StmtPtr_;
+
+  // Return the statement to the cache.
+  void release_stmt_(std::string_view sql, StmtPtr_ stmt);
+
   std::unique_ptr<sqlite3, Closer_> db_;
+  std::multimap<std::string, StmtPtr_, std::less<>> stmts_;
 
 }; // class Database
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// SQLite transaction scope.
+///
+/// Changes are committed by `commit`. If the scope is left without
+/// committing, for example due to an exception, the changes are rolled back.
+/// Transaction scopes that are opened within an active transaction join it,
+/// and only the outermost scope actually commits or rolls back.
+class Transaction final {
+public:
+
+  /// Begin a transaction, or join the active one.
+  explicit Transaction(Database& db);
+
+  /// Transaction is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(Transaction);
+
+  /// Roll back the transaction if it was not committed.
+  ~Transaction() noexcept;
+
+  /// Commit the transaction.
+  void commit();
+
+private:
+
+  Database* db_;
+  bool is_outermost_;
+  bool is_finished_ = false;
+
+}; // class Transaction
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Blob view type.
 using BlobView = std::span<const byte_t>;
 
@@ -96,9 +215,19 @@ public:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  /// Execute a SQL statement.
+  /// Prepare a SQL statement. Prepared statements are cached by the
+  /// database, so constructing a statement from the same SQL code again
+  /// does not compile it from scratch.
   explicit Statement(Database& db, std::string_view sql);
 
+  /// Statement is move-constructible, but not assignable.
+  TIT_MOVE_ONLY(Statement);
+  Statement(Statement&&) noexcept = default;
+  auto operator=(Statement&&) -> Statement& = delete;
+
+  /// Return the statement to the database cache.
+  ~Statement();
+
   /// SQLite statement object.
   auto base() const noexcept -> sqlite3_stmt*;
 
@@ -206,10 +335,6 @@ private:
     finished,
   };
 
-  struct Finalizer_ final {
-    static void operator()(sqlite3_stmt* stmt);
-  };
-
   // Bind the statement arguments.
   auto num_params_() const -> size_t;
   void bind_(size_t index, int64_t value) const;
@@ -226,7 +351,8 @@ private:
   auto column_blob_(size_t index) const -> BlobView;
 
   Database* db_;
-  std::unique_ptr<sqlite3_stmt, Finalizer_> stmt_;
+  std::string sql_;
+  Database::StmtPtr_ stmt_;
   State_ state_ = State_::invalid;
 
 }; // class Statement
@@ -273,6 +399,11 @@ constexpr auto make_blob_reader(const Database& db,
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// SQLite blob writer.
+///
+/// Data is accumulated until the stream is flushed, and then written into
+/// the blob that is reserved with the exact size. SQLite does not copy the
+/// reserved blob into the row record, and the data is written directly into
+/// the database pages.
 class BlobWriter final : public OutputStream<byte_t> {
 public:
 
@@ -290,6 +421,10 @@ public:
 
 private:
 
+  struct Finalizer_ final {
+    static void operator()(sqlite3_blob* blob);
+  };
+
   Database* db_;
   std::string table_name_;
   std::string column_name_;
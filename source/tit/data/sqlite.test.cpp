@@ -3,11 +3,14 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <array>
 #include <filesystem>
 #include <numbers>
 #include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -53,8 +56,25 @@ TEST_CASE("data::sqlite::Database") {
       CHECK(db.base() != nullptr);
       CHECK(db.path().filename() == file_name);
     }
+    SUBCASE("open existing read-only") {
+      REQUIRE(std::filesystem::exists(file_name));
+      const data::sqlite::Database db{file_name,
+                                      data::sqlite::OpenMode::read_only};
+      CHECK(db.path().filename() == file_name);
+      CHECK_THROWS_MSG(db.execute("CREATE TABLE test (id INTEGER)"),
+                       Exception,
+                       "attempt to write a readonly database");
+    }
   }
   SUBCASE("failure") {
+    SUBCASE("cannot open missing read-only") {
+      REQUIRE(!std::filesystem::exists(invalid_file_name));
+      CHECK_THROWS_MSG(
+          data::sqlite::Database(invalid_file_name,
+                                 data::sqlite::OpenMode::read_only),
+          Exception,
+          "unable to open database file");
+    }
     SUBCASE("cannot create") {
       REQUIRE(!std::filesystem::exists(invalid_file_name));
       CHECK_THROWS_MSG(data::sqlite::Database{invalid_file_name},
@@ -66,6 +86,54 @@ TEST_CASE("data::sqlite::Database") {
   }
 }
 
+TEST_CASE("data::sqlite::Database::configure") {
+  const std::filesystem::path file_name{"test_configure.db"};
+  if (std::filesystem::exists(file_name)) {
+    // Remove the file if it already exists.
+    REQUIRE(std::filesystem::remove(file_name));
+  }
+  const auto query_text = [](data::sqlite::Database& db,
+                              std::string_view sql) {
+    data::sqlite::Statement statement{db, sql};
+    REQUIRE(statement.step());
+    return statement.column<std::string>();
+  };
+  const auto query_int = [](data::sqlite::Database& db, std::string_view sql) {
+    data::sqlite::Statement statement{db, sql};
+    REQUIRE(statement.step());
+    return statement.column<int64_t>();
+  };
+  SUBCASE("success") {
+    data::sqlite::Database writer{file_name};
+    writer.configure({.journal_mode = data::sqlite::JournalMode::wal,
+                      .synchronous = data::sqlite::Synchronous::normal,
+                      .page_size = 8192,
+                      .cache_size = 16 * 1024});
+    CHECK(query_text(writer, "PRAGMA journal_mode") == "wal");
+    CHECK(query_int(writer, "PRAGMA synchronous") == 1);
+    CHECK(query_int(writer, "PRAGMA page_size") == 8192);
+    CHECK(query_int(writer, "PRAGMA cache_size") == -16384);
+    writer.execute(R"SQL(
+      CREATE TABLE test (id INTEGER PRIMARY KEY);
+      INSERT INTO test (id) VALUES (1);
+    )SQL");
+
+    // Readers are not blocked by the active write transaction.
+    data::sqlite::Transaction transaction{writer};
+    writer.execute("INSERT INTO test (id) VALUES (2)");
+    data::sqlite::Database reader{file_name};
+    CHECK(query_int(reader, "SELECT COUNT(*) FROM test") == 1);
+    transaction.commit();
+    CHECK(query_int(reader, "SELECT COUNT(*) FROM test") == 2);
+  }
+  SUBCASE("failure") {
+    data::sqlite::Database db{file_name};
+    CHECK_THROWS_MSG(db.configure({.page_size = 1000}),
+                     Exception,
+                     "Invalid SQLite page size: 1000.");
+  }
+}
+
 TEST_CASE("data::sqlite::Database::execute") {
   SUBCASE("success") {
     const data::sqlite::Database db{":memory:"};
@@ -117,6 +185,51 @@ TEST_CASE("data::sqlite::Database::last_insert_row_id") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("data::sqlite::Transaction") {
+  data::sqlite::Database db{":memory:"};
+  db.execute("CREATE TABLE test (id INTEGER PRIMARY KEY)");
+  const auto count = [&db] {
+    data::sqlite::Statement statement{db, "SELECT COUNT(*) FROM test"};
+    REQUIRE(statement.step());
+    return statement.column<int64_t>();
+  };
+  SUBCASE("commit") {
+    {
+      data::sqlite::Transaction transaction{db};
+      CHECK(db.in_transaction());
+      db.execute("INSERT INTO test (id) VALUES (1)");
+      transaction.commit();
+      CHECK_FALSE(db.in_transaction());
+    }
+    CHECK(count() == 1);
+  }
+  SUBCASE("rollback") {
+    {
+      const data::sqlite::Transaction transaction{db};
+      db.execute("INSERT INTO test (id) VALUES (1)");
+    }
+    CHECK_FALSE(db.in_transaction());
+    CHECK(count() == 0);
+  }
+  SUBCASE("nested") {
+    {
+      data::sqlite::Transaction outer{db};
+      db.execute("INSERT INTO test (id) VALUES (1)");
+      {
+        // Nested transaction joins the outer one.
+        data::sqlite::Transaction inner{db};
+        db.execute("INSERT INTO test (id) VALUES (2)");
+        inner.commit();
+        CHECK(db.in_transaction());
+      }
+      outer.commit();
+    }
+    CHECK(count() == 2);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("data::sqlite::Statement") {
   data::sqlite::Database db{":memory:"};
   db.execute("CREATE TABLE test (id INTEGER PRIMARY KEY)");
@@ -124,6 +237,27 @@ TEST_CASE("data::sqlite::Statement") {
     const data::sqlite::Statement s{db, "INSERT INTO test (id) VALUES (?)"};
     CHECK(s.base() != nullptr);
   }
+  SUBCASE("cache") {
+    constexpr std::string_view sql = "INSERT INTO test (id) VALUES (?)";
+    const sqlite3_stmt* first_stmt = nullptr;
+    {
+      data::sqlite::Statement first{db, sql};
+      first_stmt = first.base();
+      first.run(1);
+
+      // Statement is in use, so a new one is prepared.
+      const data::sqlite::Statement second{db, sql};
+      CHECK(second.base() != first_stmt);
+    }
+
+    // Statement was returned to the cache, and it is reset.
+    data::sqlite::Statement third{db, sql};
+    CHECK(third.base() == first_stmt);
+    third.run(2);
+    data::sqlite::Statement count{db, "SELECT COUNT(*) FROM test"};
+    REQUIRE(count.step());
+    CHECK(count.column<int64_t>() == 2);
+  }
   SUBCASE("failure") {
     SUBCASE("invalid SQL") {
       CHECK_THROWS_MSG(data::sqlite::Statement(db, "INVALID SQL"),
@@ -379,6 +513,24 @@ TEST_CASE("data::sqlite::BlobWriter") {
                                  to_bytes(std::numbers::phi_v<double>)} |
                          std::views::join);
     }
+    SUBCASE("large") {
+      std::vector<byte_t> data(1024 * 1024);
+      for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<byte_t>(i * 7 % 251);
+      }
+      {
+        auto writer =
+            data::sqlite::make_blob_writer(db, "Constants", "value", 1);
+        for (size_t offset = 0; offset < data.size(); offset += 1000) {
+          const auto count = std::min<size_t>(1000, data.size() - offset);
+          writer->write(std::span{data}.subspan(offset, count));
+        }
+      }
+      std::vector<byte_t> result(data.size());
+      CHECK(data::sqlite::make_blob_reader(db, "Constants", "value", 1)
+                ->read(result) == data.size());
+      CHECK(result == data);
+    }
   }
   SUBCASE("failure") {
     SUBCASE("SQL injection") {
@@ -3,19 +3,30 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <array>
 #include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/exception.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/str_utils.hpp"
 #include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
 
+#include "tit/data/filter.hpp"
 #include "tit/data/sqlite.hpp"
 #include "tit/data/storage.hpp"
 #include "tit/data/type.hpp"
@@ -25,10 +36,256 @@ namespace tit::data {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
+namespace {
+
+// Directory where the externally stored data arrays are placed.
+auto external_dir(const std::filesystem::path& db_path)
+    -> std::filesystem::path {
+  auto result = db_path;
+  result += ".arrays";
+  return result;
+}
+
+// Input stream that reads the data from a memory-mapped file.
+class MappedFileReader final : public InputStream<byte_t> {
+public:
+
+  explicit MappedFileReader(MappedFile file) : file_{std::move(file)} {}
+
+  auto read(std::span<byte_t> data) -> size_t override {
+    const auto bytes = file_.bytes().subspan(offset_);
+    const auto count = std::min(data.size(), bytes.size());
+    std::ranges::copy(bytes.first(count), data.begin());
+    offset_ += count;
+    return count;
+  }
+
+private:
+
+  MappedFile file_;
+  size_t offset_ = 0;
+
+}; // class MappedFileReader
+
+// Output stream that splits the data into the chunks of the fixed size.
+template<class WriteChunk>
+class ChunkedWriter final : public OutputStream<byte_t> {
+public:
+
+  ChunkedWriter(size_t chunk_size, WriteChunk write_chunk)
+      : chunk_size_{chunk_size}, write_chunk_{std::move(write_chunk)} {
+    TIT_ASSERT(chunk_size_ > 0, "Chunk size must be positive!");
+  }
+
+  void write(std::span<const byte_t> data) override {
+    while (!data.empty()) {
+      // Full chunks are written directly, without buffering.
+      if (buffer_.empty() && data.size() >= chunk_size_) {
+        write_chunk_(data.first(chunk_size_));
+        data = data.subspan(chunk_size_);
+        continue;
+      }
+      const auto count = std::min(data.size(), chunk_size_ - buffer_.size());
+      buffer_.insert(buffer_.end(), data.begin(), data.begin() + count);
+      data = data.subspan(count);
+      if (buffer_.size() == chunk_size_) flush();
+    }
+  }
+
+  void flush() override {
+    if (buffer_.empty()) return;
+    write_chunk_(std::span<const byte_t>{buffer_});
+    buffer_.clear();
+  }
+
+private:
+
+  size_t chunk_size_;
+  WriteChunk write_chunk_;
+  std::vector<byte_t> buffer_;
+
+}; // class ChunkedWriter
+
+// Output stream that buffers the small data and writes it raw, or opens the
+// actual stream once the data turns out to be large.
+template<class OpenLarge, class WriteRaw>
+class SmallDataWriter final : public OutputStream<byte_t> {
+public:
+
+  SmallDataWriter(size_t max_raw_size, OpenLarge open_large, WriteRaw write_raw)
+      : max_raw_size_{max_raw_size}, open_large_{std::move(open_large)},
+        write_raw_{std::move(write_raw)} {}
+
+  void write(std::span<const byte_t> data) override {
+    if (large_ == nullptr) {
+      if (buffer_.size() + data.size() <= max_raw_size_) {
+        buffer_.insert(buffer_.end(), data.begin(), data.end());
+        return;
+      }
+      large_ = open_large_();
+      large_->write(buffer_);
+      buffer_.clear();
+    }
+    large_->write(data);
+  }
+
+  void flush() override {
+    if (large_ != nullptr) large_->flush();
+    else write_raw_(std::span<const byte_t>{buffer_});
+  }
+
+private:
+
+  size_t max_raw_size_;
+  OpenLarge open_large_;
+  WriteRaw write_raw_;
+  std::vector<byte_t> buffer_;
+  OutputStreamPtr<byte_t> large_;
+
+}; // class SmallDataWriter
+
+// Input stream that reads the data from the sequence of chunks.
+template<class OpenChunk>
+class ChunkedReader final : public InputStream<byte_t> {
+public:
+
+  ChunkedReader(std::vector<sqlite::RowID> chunk_ids, OpenChunk open_chunk)
+      : chunk_ids_{std::move(chunk_ids)}, open_chunk_{std::move(open_chunk)} {}
+
+  auto read(std::span<byte_t> data) -> size_t override {
+    size_t num_read = 0;
+    while (num_read < data.size()) {
+      if (chunk_ == nullptr) {
+        if (next_chunk_ == chunk_ids_.size()) break;
+        chunk_ = open_chunk_(chunk_ids_[next_chunk_++]);
+      }
+      const auto copied = chunk_->read(data.subspan(num_read));
+      if (copied == 0) chunk_.reset();
+      num_read += copied;
+    }
+    return num_read;
+  }
+
+private:
+
+  std::vector<sqlite::RowID> chunk_ids_;
+  OpenChunk open_chunk_;
+  size_t next_chunk_ = 0;
+  InputStreamPtr<byte_t> chunk_;
+
+}; // class ChunkedReader
+
+// Wrap the stream with the decoders of the data array with the given
+// encoding parameters.
+auto make_decoder(InputStreamPtr<byte_t> stream,
+                  DataKind kind,
+                  DataFilter filter,
+                  float64_t tolerance) -> InputStreamPtr<byte_t> {
+  stream = zstd::make_stream_decompressor(std::move(stream));
+  if (filter == DataFilter::shuffle) {
+    const auto item_width = tolerance > 0.0 ? sizeof(int64_t) : kind.width();
+    stream = make_unshuffle_input_stream(std::move(stream), item_width);
+  }
+  if (tolerance > 0.0) {
+    stream = make_dequantize_input_stream(std::move(stream), kind, tolerance);
+  }
+  return stream;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto EncodedArrayData::decode() const -> std::vector<byte_t> {
+  if (!compressed) {
+    TIT_ASSERT(chunks.size() <= 1, "Uncompressed data must not be chunked!");
+    return chunks.empty() ? std::vector<byte_t>{} : chunks.front();
+  }
+  std::vector<std::vector<byte_t>> decoded(chunks.size());
+  par::for_each(std::views::iota(size_t{0}, chunks.size()),
+                [&decoded, this](size_t i) {
+                  read_from(make_decoder(make_range_input_stream(
+                                             std::span{chunks[i]}),
+                                         type.kind(),
+                                         filter,
+                                         tolerance),
+                            decoded[i],
+                            /*chunk_size=*/(64 * 1024UZ));
+                });
+  if (decoded.size() == 1) return std::move(decoded.front());
+  std::vector<byte_t> result;
+  result.reserve(std::ranges::fold_left(
+      decoded | std::views::transform(std::ranges::size),
+      size_t{0},
+      std::plus{}));
+  for (const auto& chunk : decoded) {
+    result.insert(result.end(), chunk.begin(), chunk.end());
+  }
+  return result;
+}
+
+void EncodedArrayData::decode_into(std::span<byte_t> out) const {
+  TIT_ASSERT(num_values.has_value(), "Number of values must be known!");
+  TIT_ASSERT(out.size() == *num_values * type.width(), "Size mismatch!");
+  if (!compressed) {
+    TIT_ASSERT(chunks.size() <= 1, "Uncompressed data must not be chunked!");
+    if (!chunks.empty()) std::ranges::copy(chunks.front(), out.begin());
+    return;
+  }
+
+  // Each chunk but the last one holds exactly `chunk_size` values, so the
+  // chunks are decoded straight into their own parts of the buffer.
+  const auto chunk_bytes =
+      chunk_size == 0 ? out.size() : chunk_size * type.width();
+  par::for_each(
+      std::views::iota(size_t{0}, chunks.size()),
+      [&out, chunk_bytes, this](size_t i) {
+        const auto first = std::min(i * chunk_bytes, out.size());
+        const auto chunk_out =
+            out.subspan(first, std::min(chunk_bytes, out.size() - first));
+        const auto stream = make_decoder(make_range_input_stream(
+                                             std::span{chunks[i]}),
+                                         type.kind(),
+                                         filter,
+                                         tolerance);
+        size_t num_read = 0;
+        while (num_read < chunk_out.size()) {
+          const auto count = stream->read(chunk_out.subspan(num_read));
+          if (count == 0) break;
+          num_read += count;
+        }
+        std::array<byte_t, 1> extra{};
+        if (num_read != chunk_out.size() || stream->read(extra) != 0) {
+          TIT_THROW("Chunk {} of the data array has unexpected size.", i);
+        }
+      });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataStorage::DataStorage(const std::filesystem::path& path,
+                         const sqlite::DatabaseOptions& options)
+    : DataStorage{path, sqlite::OpenMode::read_write, options} {}
+
+DataStorage::DataStorage(const std::filesystem::path& path,
+                         sqlite::OpenMode mode,
+                         const sqlite::DatabaseOptions& options)
+    : db_{path, mode} {
+  if (mode == sqlite::OpenMode::read_only) {
+    // Waiting for the writers does not modify the database.
+    db_.execute(
+        std::format("PRAGMA busy_timeout = {}", options.busy_timeout));
+    migrate_schema_(mode);
+    return;
+  }
+  db_.configure(options);
   db_.execute(R"SQL(
     PRAGMA foreign_keys = ON;
 
+    -- Freed pages are returned to the file system by `collect_garbage`.
+    -- This only takes effect for the newly created database files.
+    PRAGMA auto_vacuum = INCREMENTAL;
+
     CREATE TABLE IF NOT EXISTS Settings (
       id INTEGER PRIMARY KEY CHECK (id = 0),
       max_series INTEGER
@@ -37,7 +294,8 @@ DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
 
     CREATE TABLE IF NOT EXISTS DataSeries (
       id          INTEGER PRIMARY KEY AUTOINCREMENT,
-      parameters  TEXT
+      parameters  TEXT,
+      retired     INTEGER NOT NULL DEFAULT 0
     ) STRICT;
 
     CREATE TABLE IF NOT EXISTS TimeSteps (
@@ -60,17 +318,93 @@ DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
       data_set_id INTEGER NOT NULL,
       name        TEXT NOT NULL,
       type        INTEGER NOT NULL,
+      filter      INTEGER NOT NULL DEFAULT 0,
+      tolerance   REAL NOT NULL DEFAULT 0.0,
+      external    INTEGER NOT NULL DEFAULT 0,
+      chunk_size  INTEGER NOT NULL DEFAULT 0,
+      compressed  INTEGER NOT NULL DEFAULT 1,
       data        BLOB,
       FOREIGN KEY (data_set_id) REFERENCES DataSets(id) ON DELETE CASCADE
     ) STRICT;
+
+    CREATE TABLE IF NOT EXISTS DataArrayChunks (
+      id          INTEGER PRIMARY KEY AUTOINCREMENT,
+      array_id    INTEGER NOT NULL,
+      first_index INTEGER NOT NULL,
+      num_values  INTEGER NOT NULL,
+      data        BLOB,
+      UNIQUE (array_id, first_index),
+      FOREIGN KEY (array_id) REFERENCES DataArrays(id) ON DELETE CASCADE
+    ) STRICT;
   )SQL");
   /// @todo We shall check if the database schema is actually what we expect.
+
+  migrate_schema_(mode);
+}
+
+void DataStorage::migrate_schema_(sqlite::OpenMode mode) {
+  // Storages created by the older versions lack some of the columns. Those
+  // are added, unless the storage is read-only: then the missing columns are
+  // replaced by their default values in the queries.
+  const auto add_missing_column = [mode, this](std::string_view table,
+                                               std::string_view column,
+                                               std::string_view type,
+                                               std::string_view default_value) {
+    sqlite::Statement statement{db_, R"SQL(
+      SELECT COUNT(*) FROM pragma_table_info(?) WHERE name = ?
+    )SQL"};
+    statement.bind(table, column);
+    if (statement.step() && statement.column<size_t>() == 0) {
+      if (mode == sqlite::OpenMode::read_only) {
+        return std::string{default_value};
+      }
+      db_.execute(std::format("ALTER TABLE {} ADD COLUMN {} {} NOT NULL "
+                              "DEFAULT {}",
+                              table,
+                              column,
+                              type,
+                              default_value));
+    }
+    return std::string{column};
+  };
+  retired_column_ = add_missing_column("DataSeries", "retired", "INTEGER", "0");
+  array_info_columns_ = std::format(
+      "type, {}, {}, {}, {}, {}",
+      add_missing_column("DataArrays", "filter", "INTEGER", "0"),
+      add_missing_column("DataArrays", "tolerance", "REAL", "0.0"),
+      add_missing_column("DataArrays", "external", "INTEGER", "0"),
+      add_missing_column("DataArrays", "chunk_size", "INTEGER", "0"),
+      add_missing_column("DataArrays", "compressed", "INTEGER", "1"));
 }
 
 auto DataStorage::path() const -> std::filesystem::path {
   return db_.path();
 }
 
+auto DataStorage::tolerance(std::string_view name) const -> float64_t {
+  const auto iter = tolerances_.find(name);
+  return iter != tolerances_.end() ? iter->second : 0.0;
+}
+
+void DataStorage::set_tolerance(std::string_view name, float64_t tolerance) {
+  TIT_ASSERT(!name.empty(), "Array name must not be empty!");
+  if (tolerance < 0.0) {
+    TIT_THROW("Tolerance must be non-negative, got {}.", tolerance);
+  }
+  if (tolerance == 0.0) {
+    tolerances_.erase(std::string{name});
+  } else {
+    tolerances_.insert_or_assign(std::string{name}, tolerance);
+  }
+}
+
+void DataStorage::set_external_arrays(bool enabled) {
+  if (enabled && path().empty()) {
+    TIT_THROW("In-memory data storage cannot store data arrays externally.");
+  }
+  external_arrays_ = enabled;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto DataStorage::max_series() const -> size_t {
@@ -89,28 +423,23 @@ void DataStorage::set_max_series(size_t value) {
     UPDATE Settings SET max_series = ?
   )SQL"};
   update_statement.run(value);
-  if (num_series() > value) {
-    sqlite::Statement remove_extra_statement{db_, R"SQL(
-      DELETE FROM DataSeries WHERE id IN (
-        SELECT id FROM DataSeries ORDER BY id ASC LIMIT ?
-      )
-    )SQL"};
-    remove_extra_statement.run(num_series() - value);
+  if (const auto count = num_series(); count > value) {
+    retire_oldest_series_(count - value);
   }
 }
 
 auto DataStorage::num_series() const -> size_t {
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT COUNT(*) FROM DataSeries
-  )SQL"};
+  sqlite::Statement statement{db_, std::format(R"SQL(
+    SELECT COUNT(*) FROM DataSeries WHERE {} = 0
+  )SQL", retired_column_)};
   if (!statement.step()) TIT_THROW("Unable to count data series!");
   return statement.column<size_t>();
 }
 
 auto DataStorage::series_ids() const -> std::vector<DataSeriesID> {
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT id FROM DataSeries ORDER BY id ASC
-  )SQL"};
+  sqlite::Statement statement{db_, std::format(R"SQL(
+    SELECT id FROM DataSeries WHERE {} = 0 ORDER BY id ASC
+  )SQL", retired_column_)};
   std::vector<DataSeriesID> result{};
   while (statement.step()) {
     result.emplace_back(statement.column<sqlite::RowID>());
@@ -120,22 +449,19 @@ auto DataStorage::series_ids() const -> std::vector<DataSeriesID> {
 
 auto DataStorage::last_series_id() const -> DataSeriesID {
   TIT_ASSERT(num_series() > 0, "No data series in the storage!");
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT id FROM DataSeries ORDER BY id DESC LIMIT 1
-  )SQL"};
+  sqlite::Statement statement{db_, std::format(R"SQL(
+    SELECT id FROM DataSeries WHERE {} = 0 ORDER BY id DESC LIMIT 1
+  )SQL", retired_column_)};
   if (!statement.step()) TIT_THROW("Unable to get last data series!");
   return DataSeriesID{statement.column<sqlite::RowID>()};
 }
 
 auto DataStorage::create_series_id(std::string_view parameters)
     -> DataSeriesID {
-  if (num_series() >= max_series()) {
-    // Delete the oldest series if the maximum number of series is reached.
-    db_.execute(R"SQL(
-      DELETE FROM DataSeries WHERE id IN (
-        SELECT id FROM DataSeries ORDER BY id ASC LIMIT 1
-      )
-    )SQL");
+  if (const auto count = num_series(), max_count = max_series();
+      count >= max_count) {
+    // Retire the oldest series if the maximum number of series is reached.
+    retire_oldest_series_(count - max_count + 1);
   }
   sqlite::Statement statement{db_, R"SQL(
     INSERT INTO DataSeries (parameters) VALUES (?)
@@ -150,14 +476,59 @@ void DataStorage::delete_series(DataSeriesID series_id) {
     DELETE FROM DataSeries WHERE id = ?
   )SQL"};
   statement.run(series_id.get());
+  drop_cached_infos_();
+  remove_orphan_files_();
+}
+
+auto DataStorage::collect_garbage(size_t max_arrays, size_t max_pages)
+    -> bool {
+  TIT_ASSERT(!db_.in_transaction(), "Garbage must be collected outside of "
+                                    "the transactions!");
+
+  // Delete the data arrays of the retired series, at most `max_arrays` of
+  // them at once. The remaining metadata is small, so once the arrays are
+  // gone, the series are deleted as a whole.
+  sqlite::Statement delete_arrays_statement{db_, R"SQL(
+    DELETE FROM DataArrays WHERE id IN (
+      SELECT DataArrays.id FROM DataArrays
+        JOIN DataSets ON DataSets.id = DataArrays.data_set_id
+        JOIN TimeSteps ON TimeSteps.id = DataSets.time_step_id
+        JOIN DataSeries ON DataSeries.id = TimeSteps.series_id
+      WHERE DataSeries.retired = 1
+      LIMIT ?
+    )
+  )SQL"};
+  delete_arrays_statement.run(max_arrays);
+  const auto has_more_arrays = db_.changes() == max_arrays;
+  if (!has_more_arrays) {
+    db_.execute(R"SQL(
+      DELETE FROM DataSeries WHERE retired = 1
+    )SQL");
+  }
+  drop_cached_infos_();
+  remove_orphan_files_();
+
+  // Return at most `max_pages` of the freed pages to the file system. This
+  // is a no-op unless the database was created with the incremental vacuum.
+  db_.execute(std::format("PRAGMA incremental_vacuum({})", max_pages));
+  if (has_more_arrays) return true;
+  sqlite::Statement vacuum_statement{db_, R"SQL(
+    SELECT auto_vacuum, freelist_count
+    FROM pragma_auto_vacuum(), pragma_freelist_count()
+  )SQL"};
+  if (!vacuum_statement.step()) TIT_THROW("Unable to get free page count!");
+  static constexpr int64_t incremental_auto_vacuum = 2;
+  const auto [auto_vacuum, freelist_count] =
+      vacuum_statement.columns<int64_t, size_t>();
+  return auto_vacuum == incremental_auto_vacuum && freelist_count > 0;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto DataStorage::check_series(DataSeriesID series_id) const -> bool {
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT id FROM DataSeries WHERE id = ?
-  )SQL"};
+  sqlite::Statement statement{db_, std::format(R"SQL(
+    SELECT id FROM DataSeries WHERE id = ? AND {} = 0
+  )SQL", retired_column_)};
   statement.bind(series_id.get());
   return statement.step();
 }
@@ -217,6 +588,8 @@ auto DataStorage::create_time_step_id(DataSeriesID series_id, real_t time)
               time > series_last_time_step(series_id).time()),
              "Time step time must be greater than the last time step!");
 
+  // Time step and its datasets are created atomically.
+  auto transaction = this->transaction();
   const auto uniforms_id = create_set_();
   const auto varyings_id = create_set_();
   sqlite::Statement statement{db_, R"SQL(
@@ -232,6 +605,7 @@ auto DataStorage::create_time_step_id(DataSeriesID series_id, real_t time)
   )SQL"};
   associate_statement.run(time_step_id.get(), uniforms_id.get());
   associate_statement.run(time_step_id.get(), varyings_id.get());
+  transaction.commit();
 
   return time_step_id;
 }
@@ -242,6 +616,8 @@ void DataStorage::delete_time_step(DataTimeStepID time_step_id) {
     DELETE FROM TimeSteps WHERE id = ?
   )SQL"};
   statement.run(time_step_id.get());
+  drop_cached_infos_();
+  remove_orphan_files_();
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -255,39 +631,39 @@ auto DataStorage::check_time_step(DataTimeStepID time_step_id) const -> bool {
 }
 
 auto DataStorage::time_step_time(DataTimeStepID time_step_id) const -> real_t {
-  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT time FROM TimeSteps WHERE id = ?
-  )SQL"};
-  statement.bind(time_step_id.get());
-  if (!statement.step()) TIT_THROW("Unable to get time step time!");
-  return statement.column<real_t>();
+  return time_step_info_(time_step_id).time;
 }
 
 auto DataStorage::time_step_uniforms_id(DataTimeStepID time_step_id) const
     -> DataSetID {
-  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT uniform_id FROM TimeSteps WHERE id = ?
-  )SQL"};
-  statement.bind(time_step_id.get());
-  if (!statement.step()) {
-    TIT_THROW("Unable to get time step uniform data set ID!");
-  }
-  return DataSetID{statement.column<sqlite::RowID>()};
+  return time_step_info_(time_step_id).uniforms_id;
 }
 
 auto DataStorage::time_step_varyings_id(DataTimeStepID time_step_id) const
     -> DataSetID {
+  return time_step_info_(time_step_id).varyings_id;
+}
+
+auto DataStorage::time_step_info_(DataTimeStepID time_step_id) const
+    -> const TimeStepInfo_& {
   TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  if (const auto iter = time_step_infos_.find(time_step_id.get());
+      iter != time_step_infos_.end()) {
+    return iter->second;
+  }
   sqlite::Statement statement{db_, R"SQL(
-    SELECT varying_id FROM TimeSteps WHERE id = ?
+    SELECT time, uniform_id, varying_id FROM TimeSteps WHERE id = ?
   )SQL"};
   statement.bind(time_step_id.get());
-  if (!statement.step()) {
-    TIT_THROW("Unable to get time step varying data set ID!");
-  }
-  return DataSetID{statement.column<sqlite::RowID>()};
+  if (!statement.step()) TIT_THROW("Unable to get time step metadata!");
+  const auto [time, uniforms_id, varyings_id] =
+      statement.columns<real_t, sqlite::RowID, sqlite::RowID>();
+  return time_step_infos_
+      .emplace(time_step_id.get(),
+               TimeStepInfo_{.time = time,
+                             .uniforms_id = DataSetID{uniforms_id},
+                             .varyings_id = DataSetID{varyings_id}})
+      .first->second;
 }
 
 auto DataStorage::create_set_() -> DataSetID {
@@ -351,11 +727,40 @@ auto DataStorage::create_array_id(DataSetID dataset_id,
   TIT_ASSERT(check_dataset(dataset_id), "Invalid data set ID!");
   TIT_ASSERT(!name.empty(), "Array name must not be empty!");
   TIT_ASSERT(!find_array_id(dataset_id, name), "Array already exists!");
+  // Shuffling makes no sense for the single byte items, and only the
+  // floating point data can be quantized. External data arrays are stored
+  // as is, so that they could be mapped into memory.
+  const auto external = external_arrays_;
+  const auto filter =
+      external || type.kind().width() == 1 ? DataFilter::none : filter_;
+  using enum DataKind::ID;
+  const auto is_float = type.kind().id() == float32 ||
+                        type.kind().id() == float64;
+  const auto tol = !external && is_float ? tolerance(name) : 0.0;
+  const auto chunk_size = external ? 0 : chunk_size_;
   sqlite::Statement statement{db_, R"SQL(
-    INSERT INTO DataArrays (data_set_id, name, type) VALUES (?, ?, ?)
+    INSERT INTO DataArrays
+      (data_set_id, name, type, filter, tolerance, external, chunk_size)
+    VALUES (?, ?, ?, ?, ?, ?, ?)
   )SQL"};
-  statement.run(dataset_id.get(), name, type.id());
-  return DataArrayID{db_.last_insert_row_id()};
+  statement.run(dataset_id.get(),
+                name,
+                type.id(),
+                std::to_underlying(filter),
+                tol,
+                external,
+                chunk_size);
+  const DataArrayID array_id{db_.last_insert_row_id()};
+
+  // Rolled back rows may have their IDs reused, so the entry is replaced.
+  array_infos_.insert_or_assign(array_id.get(),
+                                ArrayInfo_{.type = type,
+                                           .filter = filter,
+                                           .tolerance = tol,
+                                           .external = external,
+                                           .chunk_size = chunk_size,
+                                           .compressed = true});
+  return array_id;
 }
 
 auto DataStorage::create_array_id(DataSetID dataset_id,
@@ -373,6 +778,8 @@ void DataStorage::delete_array(DataArrayID array_id) {
     DELETE FROM DataArrays WHERE id = ?
   )SQL"};
   statement.run(array_id.get());
+  array_infos_.erase(array_id.get());
+  remove_orphan_files_();
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -386,31 +793,181 @@ auto DataStorage::check_array(DataArrayID array_id) const -> bool {
 }
 
 auto DataStorage::array_type(DataArrayID array_id) const -> DataType {
+  return array_info_(array_id).type;
+}
+
+auto DataStorage::array_filter(DataArrayID array_id) const -> DataFilter {
+  return array_info_(array_id).filter;
+}
+
+auto DataStorage::array_tolerance(DataArrayID array_id) const -> float64_t {
+  return array_info_(array_id).tolerance;
+}
+
+auto DataStorage::array_is_external(DataArrayID array_id) const -> bool {
+  return array_info_(array_id).external;
+}
+
+auto DataStorage::array_chunk_size(DataArrayID array_id) const -> size_t {
+  return array_info_(array_id).chunk_size;
+}
+
+auto DataStorage::array_is_compressed(DataArrayID array_id) const -> bool {
+  return array_info_(array_id).compressed;
+}
+
+auto DataStorage::array_info_(DataArrayID array_id) const
+    -> const ArrayInfo_& {
   TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
-  sqlite::Statement statement{db_, R"SQL(
-    SELECT type FROM DataArrays WHERE id = ?
-  )SQL"};
+  if (const auto iter = array_infos_.find(array_id.get());
+      iter != array_infos_.end()) {
+    return iter->second;
+  }
+  sqlite::Statement statement{db_, std::format(R"SQL(
+    SELECT {} FROM DataArrays WHERE id = ?
+  )SQL", array_info_columns_)};
   statement.bind(array_id.get());
-  if (!statement.step()) TIT_THROW("Unable to get data array data type!");
-  return DataType{statement.column<uint32_t>()};
+  if (!statement.step()) TIT_THROW("Unable to get data array metadata!");
+  const auto [type, filter, tol, external, chunk_size, compressed] =
+      statement.columns<uint32_t, uint8_t, float64_t, bool, size_t, bool>();
+  if (filter > std::to_underlying(DataFilter::shuffle)) {
+    TIT_THROW("Invalid data array filter: {}.", filter);
+  }
+  return array_infos_
+      .emplace(array_id.get(),
+               ArrayInfo_{.type = DataType{type},
+                          .filter = DataFilter{filter},
+                          .tolerance = tol,
+                          .external = external,
+                          .chunk_size = chunk_size,
+                          .compressed = compressed})
+      .first->second;
 }
 
 auto DataStorage::array_data_open_write(DataArrayID array_id)
     -> OutputStreamPtr<byte_t> {
   TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
-  return zstd::make_stream_compressor(
-      sqlite::make_blob_writer(db_, "DataArrays", "data", array_id.get()));
+  if (array_is_external(array_id)) {
+    const auto file_path = array_file_path_(array_id);
+    std::filesystem::create_directories(file_path.parent_path());
+    return make_file_output_stream(file_path);
+  }
+  if (max_raw_size_ == 0) return open_encoded_write_(array_id);
+
+  // Size of the data is not known in advance, so the data is buffered until
+  // it is either flushed, or grows too large to be stored raw.
+  auto open_large = [array_id, this] { return open_encoded_write_(array_id); };
+  auto write_raw = [array_id, this](std::span<const byte_t> data) {
+    array_data_write_raw_(array_id, data);
+  };
+  return make_flushable<
+      SmallDataWriter<decltype(open_large), decltype(write_raw)>>(
+      max_raw_size_,
+      std::move(open_large),
+      std::move(write_raw));
+}
+
+auto DataStorage::open_encoded_write_(DataArrayID array_id)
+    -> OutputStreamPtr<byte_t> {
+  const auto chunk_size = array_chunk_size(array_id);
+  if (chunk_size == 0) {
+    return open_encoder_(
+        array_id,
+        sqlite::make_blob_writer(db_, "DataArrays", "data", array_id.get()));
+  }
+
+  // Each chunk is encoded separately, so that it could be decoded alone.
+  const auto width = array_type(array_id).width();
+  auto write_chunk = [array_id, width, first_index = 0UZ, this](
+                         std::span<const byte_t> chunk) mutable {
+    const auto num_values = chunk.size() / width;
+    TIT_ASSERT(num_values * width == chunk.size(), "Partial value in chunk!");
+    sqlite::Statement statement{db_, R"SQL(
+      INSERT INTO DataArrayChunks (array_id, first_index, num_values)
+      VALUES (?, ?, ?)
+    )SQL"};
+    statement.run(array_id.get(), first_index, num_values);
+    open_encoder_(array_id,
+                  sqlite::make_blob_writer(db_,
+                                           "DataArrayChunks",
+                                           "data",
+                                           db_.last_insert_row_id()))
+        ->write(chunk);
+    first_index += num_values;
+  };
+  return make_flushable<ChunkedWriter<decltype(write_chunk)>>(
+      chunk_size * width,
+      std::move(write_chunk));
+}
+
+void DataStorage::array_data_write_raw_(DataArrayID array_id,
+                                        std::span<const byte_t> data) {
+  sqlite::Statement statement{db_, R"SQL(
+    UPDATE DataArrays
+    SET compressed = 0, chunk_size = 0, data = COALESCE(?, zeroblob(0))
+    WHERE id = ?
+  )SQL"};
+  statement.run(data, array_id.get());
+  array_infos_.erase(array_id.get()); // Metadata is reloaded on access.
+}
+
+auto DataStorage::open_encoder_(DataArrayID array_id,
+                                OutputStreamPtr<byte_t> stream)
+    -> OutputStreamPtr<byte_t> {
+  const auto kind = array_type(array_id).kind();
+  const auto tol = array_tolerance(array_id);
+  stream = zstd::make_stream_compressor(std::move(stream),
+                                        compression_options_);
+  if (array_filter(array_id) == DataFilter::shuffle) {
+    const auto item_width = tol > 0.0 ? sizeof(int64_t) : kind.width();
+    stream = make_shuffle_output_stream(std::move(stream), item_width);
+  }
+  if (tol > 0.0) {
+    stream = make_quantize_output_stream(std::move(stream), kind, tol);
+  }
+  return stream;
 }
 
 auto DataStorage::array_data_open_read(DataArrayID array_id) const
     -> InputStreamPtr<byte_t> {
   TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
-  return zstd::make_stream_decompressor(
-      sqlite::make_blob_reader(db_, "DataArrays", "data", array_id.get()));
+  if (array_is_external(array_id)) {
+    return std::make_unique<MappedFileReader>(array_data_map_file_(array_id));
+  }
+  if (!array_is_compressed(array_id)) {
+    return sqlite::make_blob_reader(db_, "DataArrays", "data", array_id.get());
+  }
+  if (array_chunk_size(array_id) == 0) {
+    return open_decoder_(
+        array_id,
+        sqlite::make_blob_reader(db_, "DataArrays", "data", array_id.get()));
+  }
+  auto open_chunk = [array_id, this](sqlite::RowID chunk_id) {
+    return open_decoder_(
+        array_id,
+        sqlite::make_blob_reader(db_, "DataArrayChunks", "data", chunk_id));
+  };
+  return std::make_unique<ChunkedReader<decltype(open_chunk)>>(
+      array_chunk_ids_(array_id),
+      std::move(open_chunk));
+}
+
+auto DataStorage::open_decoder_(DataArrayID array_id,
+                                InputStreamPtr<byte_t> stream) const
+    -> InputStreamPtr<byte_t> {
+  const auto& info = array_info_(array_id);
+  return make_decoder(std::move(stream),
+                      info.type.kind(),
+                      info.filter,
+                      info.tolerance);
 }
 
 auto DataStorage::array_data(DataArrayID array_id) const
     -> std::vector<byte_t> {
+  if (array_is_external(array_id)) {
+    const auto bytes = array_data_map(array_id).data();
+    return {bytes.begin(), bytes.end()};
+  }
   std::vector<byte_t> result;
   read_from(array_data_open_read(array_id),
             result,
@@ -418,6 +975,164 @@ auto DataStorage::array_data(DataArrayID array_id) const
   return result;
 }
 
+auto DataStorage::array_data_encoded(DataArrayID array_id) const
+    -> EncodedArrayData {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  const auto& info = array_info_(array_id);
+  EncodedArrayData result{.type = info.type,
+                          .filter = info.filter,
+                          .tolerance = info.tolerance,
+                          .compressed = !info.external && info.compressed,
+                          .chunks = {}};
+  const auto read_blob = [&result, this](CStrView table_name,
+                                         sqlite::RowID row_id) {
+    auto& chunk = result.chunks.emplace_back();
+    read_from(sqlite::make_blob_reader(db_, table_name, "data", row_id),
+              chunk,
+              /*chunk_size=*/(64 * 1024UZ));
+  };
+  if (info.external) {
+    const auto bytes = array_data_map(array_id).data();
+    result.chunks.emplace_back(bytes.begin(), bytes.end());
+  } else if (info.chunk_size == 0) {
+    read_blob("DataArrays", array_id.get());
+  } else {
+    for (const auto chunk_id : array_chunk_ids_(array_id)) {
+      read_blob("DataArrayChunks", chunk_id);
+    }
+  }
+
+  // Compute the number of values, if possible.
+  if (!result.compressed) {
+    const auto num_bytes =
+        result.chunks.empty() ? 0 : result.chunks.front().size();
+    result.num_values = num_bytes / info.type.width();
+  } else if (info.chunk_size != 0) {
+    result.chunk_size = info.chunk_size;
+    sqlite::Statement statement{db_, R"SQL(
+      SELECT COALESCE(SUM(num_values), 0) FROM DataArrayChunks
+        WHERE array_id = ?
+    )SQL"};
+    statement.bind(array_id.get());
+    if (statement.step()) result.num_values = statement.column<size_t>();
+  }
+  return result;
+}
+
+auto DataStorage::array_data_range(DataArrayID array_id,
+                                   size_t first,
+                                   size_t count) const -> std::vector<byte_t> {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  const auto width = array_type(array_id).width();
+  const auto range_begin = first * width;
+  const auto range_end = range_begin + count * width;
+  if (array_is_external(array_id)) {
+    const auto bytes = array_data_map(array_id).data();
+    const auto begin = std::min(range_begin, bytes.size());
+    const auto end = std::min(range_end, bytes.size());
+    return {bytes.begin() + begin, bytes.begin() + end};
+  }
+
+  // Only the chunks that overlap with the range are decoded. Arrays that are
+  // not chunked are decoded as a whole.
+  std::vector<byte_t> result;
+  std::vector<byte_t> buffer;
+  const auto append = [range_begin, range_end, &result, &buffer](
+                          size_t offset,
+                          InputStreamPtr<byte_t> stream) {
+    buffer.clear();
+    read_from(std::move(stream), buffer, /*chunk_size=*/(64 * 1024UZ));
+    const auto begin = std::max(range_begin, offset) - offset;
+    const auto end = std::min(range_end - offset, buffer.size());
+    if (begin >= end) return;
+    result.insert(result.end(), buffer.begin() + begin, buffer.begin() + end);
+  };
+  if (array_chunk_size(array_id) == 0) {
+    append(0, array_data_open_read(array_id));
+    return result;
+  }
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT id, first_index FROM DataArrayChunks
+      WHERE array_id = ? AND first_index < ? AND first_index + num_values > ?
+      ORDER BY first_index ASC
+  )SQL"};
+  statement.bind(array_id.get(), first + count, first);
+  while (statement.step()) {
+    const auto [chunk_id, first_index] =
+        statement.columns<sqlite::RowID, size_t>();
+    append(first_index * width,
+           open_decoder_(array_id,
+                         sqlite::make_blob_reader(db_,
+                                                  "DataArrayChunks",
+                                                  "data",
+                                                  chunk_id)));
+  }
+  return result;
+}
+
+auto DataStorage::array_chunk_ids_(DataArrayID array_id) const
+    -> std::vector<sqlite::RowID> {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT id FROM DataArrayChunks WHERE array_id = ? ORDER BY first_index ASC
+  )SQL"};
+  statement.bind(array_id.get());
+  std::vector<sqlite::RowID> result{};
+  while (statement.step()) result.push_back(statement.column<sqlite::RowID>());
+  return result;
+}
+
+auto DataStorage::array_file_path_(DataArrayID array_id) const
+    -> std::filesystem::path {
+  return external_dir(path()) / std::format("{}.bin", array_id.get());
+}
+
+auto DataStorage::array_data_map_file_(DataArrayID array_id) const
+    -> MappedFile {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  if (!array_is_external(array_id)) {
+    TIT_THROW("Data array {} is not stored externally.", array_id.get());
+  }
+  return MappedFile{array_file_path_(array_id)};
+}
+
+void DataStorage::drop_cached_infos_() noexcept {
+  time_step_infos_.clear();
+  array_infos_.clear();
+}
+
+void DataStorage::retire_oldest_series_(size_t count) {
+  // Retiring is cheap, the data of the retired series is deleted later, in
+  // the bounded steps, see `collect_garbage`.
+  sqlite::Statement statement{db_, R"SQL(
+    UPDATE DataSeries SET retired = 1 WHERE id IN (
+      SELECT id FROM DataSeries WHERE retired = 0 ORDER BY id ASC LIMIT ?
+    )
+  )SQL"};
+  statement.run(count);
+}
+
+void DataStorage::remove_orphan_files_() {
+  // Files are removed only after the deletion is committed, otherwise a
+  // rollback would leave the restored data arrays without their data. The
+  // files that were skipped are removed by the next deletion.
+  if (db_.in_transaction()) return;
+  const auto dir = external_dir(path());
+  if (path().empty() || !std::filesystem::is_directory(dir)) return;
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT id FROM DataArrays WHERE external = 1
+  )SQL"};
+  std::unordered_set<sqlite::RowID> array_ids{};
+  while (statement.step()) array_ids.insert(statement.column<sqlite::RowID>());
+  for (const auto& entry : std::filesystem::directory_iterator{dir}) {
+    const auto& file_path = entry.path();
+    if (file_path.extension() != ".bin") continue;
+    const auto array_id = str_to<sqlite::RowID>(file_path.stem().native());
+    if (array_id && !array_ids.contains(*array_id)) {
+      std::filesystem::remove(file_path);
+    }
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit::data
@@ -5,26 +5,35 @@
 
 #pragma once
 
+#include <algorithm>
 #include <concepts>
 #include <filesystem>
+#include <functional>
+#include <map>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
 #include "tit/core/numbers/strict.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/serialization.hpp"
 #include "tit/core/stream.hpp"
-
+#include "tit/core/sys/utils.hpp"
 #include "tit/core/utils.hpp"
+
+#include "tit/data/filter.hpp"
 #include "tit/data/sqlite.hpp"
 #include "tit/data/type.hpp"
+#include "tit/data/zstd.hpp"
 
 namespace tit::data {
 
@@ -52,7 +61,163 @@ using DataArrayID = Strict<sqlite::RowID, impl::DataArrayTag>;
 /// Data storage type.
 template<class Storage>
 concept data_storage =
-    std::same_as<std::remove_const_t<Storage>, class DataStorage>;
+    std::same_as<std::remove_const_t<Storage>, class DataStorage> ||
+    std::same_as<std::remove_const_t<Storage>, class PackStorage>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Class that can be viewed directly in the stored data array bytes.
+template<class Val>
+concept mappable_type_of =
+    known_type_of<Val> && std::is_trivially_copyable_v<Val> &&
+    sizeof(Val) == type_of<Val>.width();
+
+/// Memory-mapped data of an externally stored data array.
+template<class Val>
+  requires (std::same_as<Val, byte_t> || mappable_type_of<Val>)
+class MappedArrayData final {
+public:
+
+  /// Construct the data array view over the mapped file.
+  explicit MappedArrayData(MappedFile file)
+      : MappedArrayData{std::move(file), 0, std::nullopt} {}
+
+  /// Construct the data array view over the byte range of the mapped file.
+  /// Range offset must be aligned to the value size.
+  MappedArrayData(MappedFile file, size_t offset, std::optional<size_t> size)
+      : file_{std::move(file)} {
+    TIT_ASSERT(offset <= file_.size(), "Offset is out of range!");
+    const auto bytes = file_.bytes().subspan(offset);
+    bytes_ = size.has_value() ? bytes.first(*size) : bytes;
+    if (bytes_.size() % sizeof(Val) != 0) {
+      TIT_THROW("Mapped data array size {} is not a multiple of {}.",
+                bytes_.size(),
+                sizeof(Val));
+    }
+  }
+
+  /// Number of values in the data array.
+  auto size() const noexcept -> size_t {
+    return bytes_.size() / sizeof(Val);
+  }
+
+  /// Data array values. They remain valid as long as the mapping is alive.
+  auto data() const noexcept -> std::span<const Val> {
+    // NOLINTNEXTLINE(*-reinterpret-cast)
+    return {reinterpret_cast<const Val*>(bytes_.data()), size()};
+  }
+
+private:
+
+  MappedFile file_;
+  std::span<const byte_t> bytes_;
+
+}; // class MappedArrayData
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Output stream that serializes into a fixed-size byte span.
+class SpanSink final {
+public:
+
+  constexpr explicit SpanSink(std::span<byte_t> bytes) noexcept
+      : bytes_{bytes} {}
+
+  constexpr void write(std::span<const byte_t> data) noexcept {
+    TIT_ASSERT(data.size() <= bytes_.size(), "Serialized value is too large!");
+    std::ranges::copy(data, bytes_.begin());
+    bytes_ = bytes_.subspan(data.size());
+  }
+
+  constexpr auto full() const noexcept -> bool {
+    return bytes_.empty();
+  }
+
+private:
+
+  std::span<byte_t> bytes_;
+
+}; // class SpanSink
+
+} // namespace impl
+
+/// Serialize the values and write them into the byte stream in large blocks.
+///
+/// Contiguous ranges of the mappable values are written as they are, with
+/// a single call. Other random access ranges are serialized in parallel,
+/// block by block, each value into its own slot of the block buffer.
+/// Remaining ranges are serialized value by value.
+template<std::ranges::input_range Vals>
+  requires known_type_of<std::ranges::range_value_t<Vals>>
+void write_values(OutputStreamPtr<byte_t> out, Vals&& vals) {
+  TIT_ASSUME_UNIVERSAL(Vals, vals);
+  using Val = std::ranges::range_value_t<Vals>;
+  if constexpr (std::ranges::contiguous_range<Vals> &&
+                std::ranges::sized_range<Vals> && mappable_type_of<Val>) {
+    out->write(std::as_bytes(
+        std::span{std::ranges::data(vals), std::ranges::size(vals)}));
+  } else if constexpr (std::ranges::random_access_range<Vals> &&
+                       std::ranges::sized_range<Vals>) {
+    static constexpr size_t BlockSize = 64 * 1024;
+    const auto width = type_of<Val>.width();
+    const auto size = std::ranges::size(vals);
+    std::vector<byte_t> block(std::min(size, BlockSize) * width);
+    for (size_t first = 0; first < size; first += BlockSize) {
+      const auto count = std::min(BlockSize, size - first);
+      par::for_each(std::views::iota(size_t{0}, count),
+                    [&vals, &block, width, first](size_t i) {
+                      impl::SpanSink sink{
+                          std::span{block}.subspan(i * width, width)};
+                      serialize(sink, vals[first + i]);
+                      TIT_ASSERT(sink.full(), "Serialized value is short!");
+                    });
+      out->write(std::span{block}.first(count * width));
+    }
+  } else {
+    write_to(make_stream_serializer<Val>(std::move(out)), vals);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Encoded data of a data array, as it is stored.
+///
+/// Decoding does not access the storage, so the arrays that were read
+/// sequentially could be decoded in parallel.
+struct EncodedArrayData final {
+  /// Array data type.
+  DataType type;
+
+  /// Array filter.
+  DataFilter filter = DataFilter::none;
+
+  /// Array quantization tolerance.
+  float64_t tolerance = 0.0;
+
+  /// Whether the data is compressed. Externally stored data is not.
+  bool compressed = true;
+
+  /// Encoded chunks. Arrays that are not chunked consist of a single chunk.
+  std::vector<std::vector<byte_t>> chunks;
+
+  /// Number of values per chunk. Zero means that the data is not chunked.
+  size_t chunk_size = 0;
+
+  /// Number of values, if it is known without decoding. It is unknown only
+  /// for the compressed arrays that are not chunked.
+  std::optional<size_t> num_values;
+
+  /// Decode the data. Chunks are decoded in parallel.
+  auto decode() const -> std::vector<byte_t>;
+
+  /// Decode the data directly into the buffer, without intermediate copies.
+  /// Chunks are decoded in parallel. Number of values must be known, and the
+  /// buffer size must match it.
+  void decode_into(std::span<byte_t> out) const;
+
+}; // struct EncodedArrayData
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -95,6 +260,31 @@ public:
     return storage().array_type(array_id_);
   }
 
+  /// Get the filter of the data array.
+  auto filter() const -> DataFilter {
+    return storage().array_filter(array_id_);
+  }
+
+  /// Get the lossy compression tolerance of the data array.
+  auto tolerance() const -> float64_t {
+    return storage().array_tolerance(array_id_);
+  }
+
+  /// Check if the data array is stored externally.
+  auto is_external() const -> bool {
+    return storage().array_is_external(array_id_);
+  }
+
+  /// Get the number of values per chunk of the data array.
+  auto chunk_size() const -> size_t {
+    return storage().array_chunk_size(array_id_);
+  }
+
+  /// Check if the data of the data array is compressed.
+  auto is_compressed() const -> bool {
+    return storage().array_is_compressed(array_id_);
+  }
+
   /// Get the data of the data array.
   /// @{
   auto data() const -> std::vector<byte_t> {
@@ -106,6 +296,33 @@ public:
   }
   /// @}
 
+  /// Read the range of values of the data array.
+  /// @{
+  auto read_range(size_t first, size_t count) const -> std::vector<byte_t> {
+    return storage().array_data_range(array_id_, first, count);
+  }
+  template<known_type_of Val>
+  auto read_range(size_t first, size_t count) const -> std::vector<Val> {
+    return storage().template array_data_range<Val>(array_id_, first, count);
+  }
+  /// @}
+
+  /// Read the encoded data of the data array, without decoding it.
+  auto encoded() const -> EncodedArrayData {
+    return storage().array_data_encoded(array_id_);
+  }
+
+  /// Map the data of the externally stored data array into memory.
+  /// @{
+  auto map() const -> MappedArrayData<byte_t> {
+    return storage().array_data_map(array_id_);
+  }
+  template<mappable_type_of Val>
+  auto map() const -> MappedArrayData<Val> {
+    return storage().template array_data_map<Val>(array_id_);
+  }
+  /// @}
+
 private:
 
   Storage* storage_;
@@ -321,11 +538,101 @@ public:
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Open a data storage or create it if it does not exist.
-  explicit DataStorage(const std::filesystem::path& path);
+  explicit DataStorage(const std::filesystem::path& path,
+                       const sqlite::DatabaseOptions& options = {});
+
+  /// Open a data storage in the given mode.
+  ///
+  /// Read-only storages must exist, and are used as they are: the schema is
+  /// neither created nor migrated, and the database options, except for the
+  /// busy timeout, are not applied. So the storages of the running
+  /// simulations, or the unrelated files, are never modified.
+  DataStorage(const std::filesystem::path& path,
+              sqlite::OpenMode mode,
+              const sqlite::DatabaseOptions& options = {});
 
   /// Path to the database file.
   auto path() const -> std::filesystem::path;
 
+  /// Begin a transaction scope. All the changes made within the scope are
+  /// written at once on commit, which is much faster than committing each
+  /// change separately.
+  auto transaction() -> sqlite::Transaction {
+    return sqlite::Transaction{db_};
+  }
+
+  /// Options that are used to compress the data arrays.
+  auto compression_options() const noexcept
+      -> const zstd::CompressionOptions& {
+    return compression_options_;
+  }
+
+  /// Set the options that are used to compress the data arrays that are
+  /// written afterwards. Existing data arrays are not recompressed.
+  void set_compression_options(const zstd::CompressionOptions& options) {
+    compression_options_ = options;
+  }
+
+  /// Filter that is applied to the data arrays before compression.
+  auto filter() const noexcept -> DataFilter {
+    return filter_;
+  }
+
+  /// Set the filter that is applied to the data arrays that are created
+  /// afterwards. Filter is recorded for each data array, so the arrays are
+  /// unfiltered transparently on reading.
+  void set_filter(DataFilter filter) noexcept {
+    filter_ = filter;
+  }
+
+  /// Absolute error tolerance of the lossy compression of the data arrays
+  /// with the given name. Zero means that the data is stored losslessly.
+  auto tolerance(std::string_view name) const -> float64_t;
+
+  /// Set the absolute error tolerance of the lossy compression of the data
+  /// arrays with the given name that are created afterwards. Only floating
+  /// point data is compressed lossily, the other arrays are not affected.
+  /// Zero tolerance disables the lossy compression.
+  void set_tolerance(std::string_view name, float64_t tolerance);
+
+  /// Check if the data arrays are stored externally.
+  auto external_arrays() const noexcept -> bool {
+    return external_arrays_;
+  }
+
+  /// Set if the data arrays that are created afterwards are stored
+  /// externally. External data arrays are written uncompressed and
+  /// unfiltered into separate files in the directory next to the database
+  /// file, so that they can be memory-mapped on reading without any copies.
+  /// In-memory storages cannot store the data arrays externally.
+  void set_external_arrays(bool enabled);
+
+  /// Maximum size of the data arrays (in bytes) that are stored raw.
+  auto max_raw_size() const noexcept -> size_t {
+    return max_raw_size_;
+  }
+
+  /// Set the maximum size of the data arrays (in bytes) that are stored raw,
+  /// without filtering, compression and chunking. For the tiny arrays, such
+  /// as the uniform fields, the compressed frame overhead exceeds the data
+  /// itself. Zero means that all the data arrays are compressed.
+  void set_max_raw_size(size_t max_raw_size) noexcept {
+    max_raw_size_ = max_raw_size;
+  }
+
+  /// Number of values per chunk of the data arrays.
+  auto chunk_size() const noexcept -> size_t {
+    return chunk_size_;
+  }
+
+  /// Set the number of values per chunk of the data arrays that are created
+  /// afterwards. Each chunk is compressed separately, so that a range of
+  /// values can be read without decompressing the whole array. Zero means
+  /// that the data arrays are compressed as a whole.
+  void set_chunk_size(size_t chunk_size) noexcept {
+    chunk_size_ = chunk_size;
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Get the maximum number of data series.
@@ -368,6 +675,21 @@ public:
   /// Delete a data series.
   void delete_series(DataSeriesID series_id);
 
+  /// Reclaim the storage space of the retired data series in a bounded step.
+  ///
+  /// Data series that exceed the maximum number of series are not deleted
+  /// immediately, but only retired, so that starting a new run does not
+  /// cost the I/O of deleting an old one. Their data is deleted, and the
+  /// freed pages are returned to the file system, by this function, that is
+  /// expected to be called between the outputs, e.g. by `DataWriter`.
+  ///
+  /// @param max_arrays Maximum number of data arrays to delete.
+  /// @param max_pages  Maximum number of free pages to return.
+  ///
+  /// @returns True if there is more garbage to collect.
+  auto collect_garbage(size_t max_arrays = 64, size_t max_pages = 1024)
+      -> bool;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Check if a data series with the given ID exists.
@@ -486,7 +808,7 @@ public:
     TIT_ASSUME_UNIVERSAL(Vals, vals);
     using Val = std::ranges::range_value_t<Vals>;
     const auto array_id = create_array_id(dataset_id, name, type_of<Val>);
-    write_to(array_data_open_write<Val>(array_id), vals);
+    write_values(array_data_open_write(array_id), vals);
     return array_id;
   }
   template<class... Args>
@@ -509,6 +831,23 @@ public:
   /// Get the data type of a data array.
   auto array_type(DataArrayID array_id) const -> DataType;
 
+  /// Get the filter of a data array.
+  auto array_filter(DataArrayID array_id) const -> DataFilter;
+
+  /// Get the lossy compression tolerance of a data array.
+  auto array_tolerance(DataArrayID array_id) const -> float64_t;
+
+  /// Check if a data array is stored externally.
+  auto array_is_external(DataArrayID array_id) const -> bool;
+
+  /// Get the number of values per chunk of a data array. Zero means that the
+  /// data array is not chunked.
+  auto array_chunk_size(DataArrayID array_id) const -> size_t;
+
+  /// Check if the data of a data array is compressed. Small arrays are
+  /// stored raw, see `set_max_raw_size`.
+  auto array_is_compressed(DataArrayID array_id) const -> bool;
+
   /// Open an output stream to the data of a data array.
   /// @{
   auto array_data_open_write(DataArrayID array_id) -> OutputStreamPtr<byte_t>;
@@ -535,6 +874,12 @@ public:
   auto array_data(DataArrayID array_id) const -> std::vector<byte_t>;
   template<known_type_of Val>
   auto array_data(DataArrayID array_id) const -> std::vector<Val> {
+    if constexpr (mappable_type_of<Val>) {
+      if (array_is_external(array_id)) {
+        const auto values = array_data_map<Val>(array_id).data();
+        return {values.begin(), values.end()};
+      }
+    }
     std::vector<Val> result;
     read_from(array_data_open_read<Val>(array_id),
               result,
@@ -543,16 +888,128 @@ public:
   }
   /// @}
 
+  /// Read the encoded data of a data array, without decoding it.
+  auto array_data_encoded(DataArrayID array_id) const -> EncodedArrayData;
+
+  /// Get the range of values of a data array. Only the chunks that overlap
+  /// with the range are decompressed. Values that are out of the array bounds
+  /// are not returned.
+  /// @{
+  auto array_data_range(DataArrayID array_id, size_t first, size_t count) const
+      -> std::vector<byte_t>;
+  template<known_type_of Val>
+  auto array_data_range(DataArrayID array_id, size_t first, size_t count) const
+      -> std::vector<Val> {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    std::vector<Val> result;
+    read_from(make_stream_deserializer<Val>(make_range_input_stream(
+                  array_data_range(array_id, first, count))),
+              result,
+              /*chunk_size=*/(64 * 1024UZ / sizeof(Val)));
+    return result;
+  }
+  /// @}
+
+  /// Map the data of an externally stored data array into memory.
+  /// @{
+  auto array_data_map(DataArrayID array_id) const -> MappedArrayData<byte_t> {
+    return MappedArrayData<byte_t>{array_data_map_file_(array_id)};
+  }
+  template<mappable_type_of Val>
+  auto array_data_map(DataArrayID array_id) const -> MappedArrayData<Val> {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    return MappedArrayData<Val>{array_data_map_file_(array_id)};
+  }
+  /// @}
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  // Bring the schema of a storage, created by an older version, up to date.
+  void migrate_schema_(sqlite::OpenMode mode);
+
   // Create a new dataset.
   auto create_set_() -> DataSetID;
 
+  // Immutable metadata of a time step.
+  struct TimeStepInfo_ final {
+    real_t time;
+    DataSetID uniforms_id;
+    DataSetID varyings_id;
+  };
+
+  // Immutable metadata of a data array.
+  struct ArrayInfo_ final {
+    DataType type;
+    DataFilter filter;
+    float64_t tolerance;
+    bool external;
+    size_t chunk_size;
+    bool compressed;
+  };
+
+  // Get the metadata of a time step or a data array. Metadata is loaded from
+  // the database once, and then is taken from the cache.
+  auto time_step_info_(DataTimeStepID time_step_id) const
+      -> const TimeStepInfo_&;
+  auto array_info_(DataArrayID array_id) const -> const ArrayInfo_&;
+
+  // Drop the cached metadata of the deleted rows.
+  void drop_cached_infos_() noexcept;
+
+  // Open the encoded output stream of a data array.
+  auto open_encoded_write_(DataArrayID array_id) -> OutputStreamPtr<byte_t>;
+
+  // Wrap the stream with the encoders of a data array.
+  auto open_encoder_(DataArrayID array_id, OutputStreamPtr<byte_t> stream)
+      -> OutputStreamPtr<byte_t>;
+
+  // Wrap the stream with the decoders of a data array.
+  auto open_decoder_(DataArrayID array_id, InputStreamPtr<byte_t> stream) const
+      -> InputStreamPtr<byte_t>;
+
+  // Get the IDs of the chunks of a data array, in order.
+  auto array_chunk_ids_(DataArrayID array_id) const
+      -> std::vector<sqlite::RowID>;
+
+  // Path to the file of an externally stored data array.
+  auto array_file_path_(DataArrayID array_id) const -> std::filesystem::path;
+
+  // Map the file of an externally stored data array into memory.
+  auto array_data_map_file_(DataArrayID array_id) const -> MappedFile;
+
+  // Store the data of a data array raw.
+  void array_data_write_raw_(DataArrayID array_id,
+                             std::span<const byte_t> data);
+
+  // Retire the oldest data series.
+  void retire_oldest_series_(size_t count);
+
+  // Remove the files of the deleted externally stored data arrays.
+  void remove_orphan_files_();
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   mutable sqlite::Database db_;
+  zstd::CompressionOptions compression_options_;
+  DataFilter filter_ = DataFilter::shuffle;
+  std::map<std::string, float64_t, std::less<>> tolerances_;
+  bool external_arrays_ = false;
+  size_t chunk_size_ = 64 * 1024;
+  size_t max_raw_size_ = 256;
+
+  // Read-only storages are not migrated, so the columns they lack are
+  // substituted with their default values in the queries.
+  std::string retired_column_ = "retired";
+  std::string array_info_columns_ =
+      "type, filter, tolerance, external, chunk_size, compressed";
+
+  // Metadata never changes after the row is created, and the IDs are never
+  // reused, so the cached entries can only become stale by deletion. Rows
+  // are always checked for existence in the database itself.
+  mutable std::unordered_map<sqlite::RowID, TimeStepInfo_> time_step_infos_;
+  mutable std::unordered_map<sqlite::RowID, ArrayInfo_> array_infos_;
 
 }; // class Database
 
@@ -3,10 +3,17 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
 #include <numbers>
+#include <ranges>
 #include <set>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -15,6 +22,8 @@
 #include "tit/core/range_utils.hpp"
 #include "tit/core/sys/utils.hpp"
 
+#include "tit/data/filter.hpp"
+#include "tit/data/sqlite.hpp"
 #include "tit/data/storage.hpp"
 #include "tit/data/type.hpp"
 
@@ -48,6 +57,117 @@ TEST_CASE("data::DataStorage") {
       const data::DataStorage storage{file_name};
       CHECK(storage.path().filename() == file_name);
     }
+    SUBCASE("open older version") {
+      const std::filesystem::path old_file_name{"test_old.ttdb"};
+      if (std::filesystem::exists(old_file_name)) {
+        REQUIRE(std::filesystem::remove(old_file_name));
+      }
+      {
+        // Schema of the storages, written before the data array encoding
+        // options were introduced.
+        const data::sqlite::Database db{old_file_name};
+        db.execute(R"SQL(
+          CREATE TABLE DataArrays (
+            id          INTEGER PRIMARY KEY AUTOINCREMENT,
+            data_set_id INTEGER NOT NULL,
+            name        TEXT NOT NULL,
+            type        INTEGER NOT NULL,
+            data        BLOB
+          ) STRICT;
+        )SQL");
+      }
+      data::DataStorage storage{old_file_name};
+      data::sqlite::Database db{old_file_name};
+      const std::array columns{"filter", "tolerance", "external", "chunk_size"};
+      for (const std::string_view column : columns) {
+        data::sqlite::Statement statement{db, R"SQL(
+          SELECT COUNT(*) FROM pragma_table_info('DataArrays') WHERE name = ?
+        )SQL"};
+        statement.bind(column);
+        REQUIRE(statement.step());
+        CHECK(statement.column<size_t>() == 1);
+      }
+
+      // Migrated storage is fully usable.
+      const auto series = storage.create_series();
+      const auto step = series.create_time_step(0.0);
+      const auto array =
+          step.varyings().create_array("rho", std::vector{1.0, 2.0});
+      CHECK(array.template data<float64_t>() == std::vector{1.0, 2.0});
+    }
+    SUBCASE("open read-only") {
+      const std::filesystem::path read_only_file_name{"test_read_only.ttdb"};
+      auto wal_file_name = read_only_file_name;
+      wal_file_name += "-wal";
+      if (std::filesystem::exists(read_only_file_name)) {
+        REQUIRE(std::filesystem::remove(read_only_file_name));
+      }
+      {
+        data::DataStorage storage{
+            read_only_file_name,
+            {.journal_mode = data::sqlite::JournalMode::rollback}};
+        storage.create_series("1");
+      }
+      const data::DataStorage storage{read_only_file_name,
+                                      data::sqlite::OpenMode::read_only};
+      CHECK(storage.num_series() == 1);
+      CHECK(storage.last_series().parameters() == "1");
+
+      // Storage is not switched to the WAL mode.
+      CHECK_FALSE(std::filesystem::exists(wal_file_name));
+    }
+    SUBCASE("open older version read-only") {
+      const std::filesystem::path old_file_name{"test_old_read_only.ttdb"};
+      if (std::filesystem::exists(old_file_name)) {
+        REQUIRE(std::filesystem::remove(old_file_name));
+      }
+      {
+        data::DataStorage storage{
+            old_file_name,
+            {.journal_mode = data::sqlite::JournalMode::rollback}};
+        storage.set_filter(data::DataFilter::none);
+        storage.set_chunk_size(0);
+        storage.set_max_raw_size(0);
+        const auto series = storage.create_series("1");
+        const auto step = series.create_time_step(0.0);
+        step.varyings().create_array("rho", std::vector{1.0, 2.0});
+      }
+      {
+        // Strip the storage down to the schema of the older versions.
+        const data::sqlite::Database db{old_file_name};
+        db.execute(R"SQL(
+          ALTER TABLE DataSeries DROP COLUMN retired;
+          ALTER TABLE DataArrays DROP COLUMN filter;
+          ALTER TABLE DataArrays DROP COLUMN tolerance;
+          ALTER TABLE DataArrays DROP COLUMN external;
+          ALTER TABLE DataArrays DROP COLUMN chunk_size;
+          ALTER TABLE DataArrays DROP COLUMN compressed;
+        )SQL");
+      }
+
+      // Missing columns take their default values, and are not added.
+      const data::DataStorage storage{old_file_name,
+                                      data::sqlite::OpenMode::read_only};
+      REQUIRE(storage.num_series() == 1);
+      const auto series = storage.last_series();
+      CHECK(storage.check_series(series));
+      CHECK(series.parameters() == "1");
+      const auto array = series.last_time_step().varyings().find_array("rho");
+      REQUIRE(array.has_value());
+      CHECK(array->filter() == data::DataFilter::none);
+      CHECK(array->chunk_size() == 0);
+      CHECK_FALSE(array->is_external());
+      CHECK(array->is_compressed());
+      CHECK(array->template data<float64_t>() == std::vector{1.0, 2.0});
+      data::sqlite::Database db{old_file_name,
+                                data::sqlite::OpenMode::read_only};
+      data::sqlite::Statement statement{db, R"SQL(
+        SELECT COUNT(*) FROM pragma_table_info('DataSeries')
+          WHERE name = 'retired'
+      )SQL"};
+      REQUIRE(statement.step());
+      CHECK(statement.column<size_t>() == 0);
+    }
   }
   SUBCASE("failure") {
     SUBCASE("cannot create") {
@@ -63,6 +183,24 @@ TEST_CASE("data::DataStorage") {
                        Exception,
                        "file is not a database");
     }
+    SUBCASE("read-only empty file") {
+      // No schema is written into the files that are opened read-only.
+      const std::filesystem::path empty_file_name{"test_empty.ttdb"};
+      std::ofstream{empty_file_name}.close();
+      const data::DataStorage storage{empty_file_name,
+                                      data::sqlite::OpenMode::read_only};
+      CHECK_THROWS_MSG(static_cast<void>(storage.num_series()),
+                       Exception,
+                       "no such table");
+      CHECK(std::filesystem::file_size(empty_file_name) == 0);
+    }
+    SUBCASE("read-only missing file") {
+      REQUIRE(!std::filesystem::exists(invalid_file_name));
+      CHECK_THROWS_MSG(data::DataStorage(invalid_file_name,
+                                         data::sqlite::OpenMode::read_only),
+                       Exception,
+                       "unable to open database file");
+    }
     /// @todo We shall add tests for valid database files with invalid schema.
   }
 }
@@ -192,6 +330,41 @@ TEST_CASE("data::DataSeriesView") {
     CHECK(series_4 != series_2);
     CHECK_RANGE_EQ(storage.series(), std::vector{series_1, series_3, series_4});
   }
+  SUBCASE("collect garbage") {
+    const std::filesystem::path file_name{"test_garbage.ttdb"};
+    if (std::filesystem::exists(file_name)) {
+      REQUIRE(std::filesystem::remove(file_name));
+    }
+    data::DataStorage storage{file_name};
+    storage.set_max_series(1);
+    const auto values = std::vector<float64_t>(10000, std::numbers::pi);
+    const auto series_1 = storage.create_series("1");
+    std::vector<data::DataArrayView<data::DataStorage>> arrays;
+    for (size_t i = 0; i < 5; ++i) {
+      const auto step = series_1.create_time_step(static_cast<double>(i));
+      arrays.push_back(step.varyings().create_array("values", values));
+    }
+
+    // Oldest series is retired, but its data is not deleted yet.
+    const auto series_2 = storage.create_series("2");
+    CHECK_FALSE(storage.check_series(series_1));
+    CHECK_RANGE_EQ(storage.series(), std::vector{series_2});
+    CHECK(std::ranges::all_of(arrays, [&storage](const auto& array) {
+      return storage.check_array(array);
+    }));
+
+    // Data is deleted in the bounded steps.
+    size_t num_steps = 0;
+    while (storage.collect_garbage(/*max_arrays=*/2, /*max_pages=*/16)) {
+      ++num_steps;
+    }
+    CHECK(num_steps >= 2);
+    CHECK(std::ranges::none_of(arrays, [&storage](const auto& array) {
+      return storage.check_array(array);
+    }));
+    CHECK_RANGE_EQ(storage.series(), std::vector{series_2});
+    CHECK_FALSE(storage.collect_garbage());
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -419,6 +592,273 @@ TEST_CASE("data::DataArrayView") {
     CHECK_RANGE_EQ(dataset.arrays(),
                    NamedArrays{{"array_1", array_1}, {"array_2", array_2}});
   }
+  SUBCASE("raw small arrays") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    storage.set_max_raw_size(64);
+    REQUIRE(storage.max_raw_size() == 64);
+
+    // Small arrays are stored raw, the large ones are compressed.
+    const auto small = dataset.create_array("small", std::vector{1.0, 2.0});
+    CHECK_FALSE(small.is_compressed());
+    CHECK(small.chunk_size() == 0);
+    CHECK(small.template data<float64_t>() == std::vector{1.0, 2.0});
+    CHECK(small.template read_range<float64_t>(1, 1) == std::vector{2.0});
+    const auto large_values = std::vector<float64_t>(100, 3.0);
+    const auto large = dataset.create_array("large", large_values);
+    CHECK(large.is_compressed());
+    CHECK(large.template data<float64_t>() == large_values);
+
+    // Empty arrays are stored raw too.
+    const auto empty = dataset.create_array("empty", std::vector<float64_t>{});
+    CHECK_FALSE(empty.is_compressed());
+    CHECK(empty.template data<float64_t>().empty());
+
+    // Raw storage can be disabled.
+    storage.set_max_raw_size(0);
+    const auto compressed =
+        dataset.create_array("compressed", std::vector{1.0});
+    CHECK(compressed.is_compressed());
+    CHECK(compressed.template data<float64_t>() == std::vector{1.0});
+  }
+  SUBCASE("metadata after rollback") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+
+    // Array that is rolled back must not leave its metadata behind, even if
+    // its ID is reused by the next array.
+    data::DataArrayID rolled_back_id{};
+    {
+      auto transaction = storage.transaction();
+      const auto array = dataset.create_array("array", std::vector{1.0});
+      rolled_back_id = array.id();
+      CHECK(array.type() == data::type_of<float64_t>);
+    }
+    const auto array =
+        dataset.create_array("array", std::vector<uint8_t>{1, 2, 3});
+    CHECK(array.type() == data::type_of<uint8_t>);
+    CHECK(array.filter() == data::DataFilter::none);
+    CHECK(array.template data<uint8_t>() == std::vector<uint8_t>{1, 2, 3});
+    if (array.id() != rolled_back_id) {
+      CHECK_FALSE(storage.check_array(rolled_back_id));
+    }
+  }
+  SUBCASE("create arrays from views") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto values = std::views::iota(0, 100000) |
+                        std::views::transform([](int i) {
+                          return std::numbers::pi * i;
+                        });
+    const auto expected = values | std::ranges::to<std::vector>();
+
+    // Random access views are serialized block by block.
+    const auto array_1 = dataset.create_array("array_1", values);
+    CHECK(array_1.template data<float64_t>() == expected);
+
+    // Other views are serialized value by value.
+    const auto array_2 = dataset.create_array(
+        "array_2",
+        values | std::views::filter([](float64_t) { return true; }));
+    CHECK(array_2.template data<float64_t>() == expected);
+  }
+  SUBCASE("filters") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto values = std::views::iota(0, 100000) |
+                        std::views::transform([](int i) {
+                          return std::numbers::pi * i;
+                        }) |
+                        std::ranges::to<std::vector>();
+
+    // Shuffle is the default filter for the multibyte types.
+    REQUIRE(storage.filter() == data::DataFilter::shuffle);
+    const auto array_1 = dataset.create_array("array_1", values);
+    CHECK(array_1.filter() == data::DataFilter::shuffle);
+    CHECK(array_1.template data<float64_t>() == values);
+
+    // Filter is not applied to the single byte types.
+    const auto array_2 =
+        dataset.create_array("array_2", std::vector<uint8_t>{1, 2, 3});
+    CHECK(array_2.filter() == data::DataFilter::none);
+    CHECK(array_2.template data<uint8_t>() == std::vector<uint8_t>{1, 2, 3});
+
+    // Existing arrays keep their filters.
+    storage.set_filter(data::DataFilter::none);
+    const auto array_3 = dataset.create_array("array_3", values);
+    CHECK(array_3.filter() == data::DataFilter::none);
+    CHECK(array_3.template data<float64_t>() == values);
+    CHECK(array_1.filter() == data::DataFilter::shuffle);
+    CHECK(array_1.template data<float64_t>() == values);
+  }
+  SUBCASE("lossy compression") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto values = std::views::iota(0, 100000) |
+                        std::views::transform([](int i) {
+                          return std::numbers::pi * i;
+                        }) |
+                        std::ranges::to<std::vector>();
+
+    // Tolerance is specified per array name.
+    constexpr float64_t tolerance = 1.0e-2;
+    storage.set_tolerance("lossy", tolerance);
+    REQUIRE(storage.tolerance("lossy") == tolerance);
+    REQUIRE(storage.tolerance("lossless") == 0.0);
+    const auto lossy = dataset.create_array("lossy", values);
+    CHECK(lossy.tolerance() == tolerance);
+    const auto lossy_values = lossy.template data<float64_t>();
+    REQUIRE(lossy_values.size() == values.size());
+    for (const auto& [value, restored] :
+         std::views::zip(values, lossy_values)) {
+      CHECK(std::abs(value - restored) <= tolerance * (1.0 + 1.0e-6));
+    }
+    const auto lossless = dataset.create_array("lossless", values);
+    CHECK(lossless.tolerance() == 0.0);
+    CHECK(lossless.template data<float64_t>() == values);
+
+    // Integer data is never compressed lossily.
+    storage.set_tolerance("integers", tolerance);
+    const auto integers =
+        dataset.create_array("integers", std::vector<int32_t>{1, 2, 3});
+    CHECK(integers.tolerance() == 0.0);
+    CHECK(integers.template data<int32_t>() == std::vector<int32_t>{1, 2, 3});
+  }
+  SUBCASE("partial reads") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto values = std::views::iota(0, 100000) |
+                        std::views::transform([](int i) {
+                          return std::numbers::pi * i;
+                        }) |
+                        std::ranges::to<std::vector>();
+    const auto slice = [&values](size_t first, size_t count) {
+      return std::vector(values.begin() + first,
+                         values.begin() + first + count);
+    };
+
+    // Chunked arrays are read chunk by chunk.
+    storage.set_chunk_size(1000);
+    const auto chunked = dataset.create_array("chunked", values);
+    CHECK(chunked.chunk_size() == 1000);
+    CHECK(chunked.template data<float64_t>() == values);
+    CHECK(chunked.template read_range<float64_t>(12345, 10) ==
+          slice(12345, 10));
+    CHECK(chunked.template read_range<float64_t>(999, 2) == slice(999, 2));
+    CHECK(chunked.template read_range<float64_t>(500, 3000) ==
+          slice(500, 3000));
+    CHECK(chunked.template read_range<float64_t>(99990, 100) ==
+          slice(99990, 10));
+    CHECK(chunked.template read_range<float64_t>(200000, 10).empty());
+    CHECK(chunked.read_range(1, 1).size() == sizeof(float64_t));
+
+    // Arrays that are not chunked are decompressed as a whole.
+    storage.set_chunk_size(0);
+    const auto whole = dataset.create_array("whole", values);
+    CHECK(whole.chunk_size() == 0);
+    CHECK(whole.template data<float64_t>() == values);
+    CHECK(whole.template read_range<float64_t>(12345, 10) == slice(12345, 10));
+  }
+  SUBCASE("decode into buffer") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto values = std::views::iota(0, 10000) |
+                        std::views::transform([](int i) {
+                          return std::numbers::e * i;
+                        }) |
+                        std::ranges::to<std::vector>();
+    const auto decode = [](const auto& array) {
+      const auto encoded = array.encoded();
+      REQUIRE(encoded.num_values.has_value());
+      std::vector<float64_t> result(*encoded.num_values);
+      encoded.decode_into(std::as_writable_bytes(std::span{result}));
+      return result;
+    };
+
+    // Chunked arrays are decoded chunk by chunk, including the last partial
+    // chunk.
+    storage.set_chunk_size(1024);
+    const auto chunked = dataset.create_array("chunked", values);
+    CHECK(decode(chunked) == values);
+
+    // Small arrays are stored raw.
+    const auto small = dataset.create_array("small", std::vector{1.0, 2.0});
+    CHECK(decode(small) == std::vector{1.0, 2.0});
+
+    // Size of the compressed arrays that are not chunked is not known.
+    storage.set_chunk_size(0);
+    const auto whole = dataset.create_array("whole", values);
+    CHECK_FALSE(whole.encoded().num_values.has_value());
+  }
+  SUBCASE("external arrays") {
+    const std::filesystem::path file_name{"test_external.ttdb"};
+    const std::filesystem::path dir_name{"test_external.ttdb.arrays"};
+    std::filesystem::remove(file_name);
+    std::filesystem::remove_all(dir_name);
+    data::DataStorage storage{file_name};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto values = std::views::iota(0, 100000) |
+                        std::views::transform([](int i) {
+                          return std::numbers::pi * i;
+                        }) |
+                        std::ranges::to<std::vector>();
+
+    // External arrays are stored as is, without filters and tolerance.
+    storage.set_tolerance("external", 1.0e-2);
+    storage.set_external_arrays(true);
+    REQUIRE(storage.external_arrays());
+    const auto external = dataset.create_array("external", values);
+    CHECK(external.is_external());
+    CHECK(external.filter() == data::DataFilter::none);
+    CHECK(external.tolerance() == 0.0);
+    CHECK(std::filesystem::file_size(dir_name / "1.bin") ==
+          values.size() * sizeof(float64_t));
+
+    // External arrays are read either by copying or by mapping.
+    CHECK(external.template data<float64_t>() == values);
+    CHECK(external.data().size() == values.size() * sizeof(float64_t));
+    const auto mapped = external.template map<float64_t>();
+    CHECK(std::ranges::equal(mapped.data(), values));
+    CHECK(external.map().size() == values.size() * sizeof(float64_t));
+    CHECK(external.template read_range<float64_t>(10, 2) ==
+          std::vector{values[10], values[11]});
+
+    // Internal arrays cannot be mapped.
+    storage.set_external_arrays(false);
+    const auto internal = dataset.create_array("internal", values);
+    CHECK_FALSE(internal.is_external());
+    CHECK(internal.template data<float64_t>() == values);
+    CHECK_THROWS_WITH_AS(internal.map(),
+                         "Data array 2 is not stored externally.",
+                         Exception);
+
+    // Files of the deleted arrays are removed.
+    storage.delete_time_step(step);
+    CHECK_FALSE(std::filesystem::exists(dir_name / "1.bin"));
+
+    // In-memory storages cannot store arrays externally.
+    data::DataStorage memory_storage{":memory:"};
+    CHECK_THROWS_WITH_AS(
+        memory_storage.set_external_arrays(true),
+        "In-memory data storage cannot store data arrays externally.",
+        Exception);
+  }
   SUBCASE("find arrays") {
     data::DataStorage storage{":memory:"};
     const auto series = storage.create_series("");
@@ -219,6 +219,17 @@ public:
     return dim_;
   }
 
+  /// Width of a single value of the data type in bytes.
+  constexpr auto width() const -> size_t {
+    using enum DataRank;
+    switch (rank()) {
+      case scalar: return kind().width();
+      case vector: return kind().width() * dim();
+      case matrix: return kind().width() * dim() * dim();
+      default:     std::unreachable();
+    }
+  }
+
   /// Data type string representation.
   constexpr auto name() const -> std::string {
     using enum DataRank;
@@ -258,6 +269,12 @@ inline constexpr DataType type_of<Mat<Num, Dim>>{kind_of<Num>,
                                                  DataRank::matrix,
                                                  Dim};
 
+// Symmetric matrices are stored expanded, as the full matrices.
+template<known_kind_of Num, size_t Dim>
+inline constexpr DataType type_of<SymMat<Num, Dim>>{kind_of<Num>,
+                                                    DataRank::matrix,
+                                                    Dim};
+
 } // namespace impl
 
 /// Class that has a known data type.
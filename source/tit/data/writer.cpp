@@ -0,0 +1,134 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto DataSetSnapshot::next_array_() -> DataArraySnapshot& {
+  if (num_arrays_ == arrays_.size()) arrays_.emplace_back();
+  auto& array = arrays_[num_arrays_++];
+  array.data.clear();
+  return array;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataWriter::DataWriter(DataSeriesView<DataStorage> series,
+                       size_t max_queue_size)
+    : series_{series}, max_queue_size_{max_queue_size},
+      thread_{[this] { run_(); }} {
+  TIT_ASSERT(max_queue_size_ > 0, "Queue size must be positive!");
+}
+
+DataWriter::~DataWriter() noexcept {
+  // Errors cannot be reported from the destructor, so we only wait for the
+  // submitted snapshots to be written. Afterwards, the background thread is
+  // stopped, and it is joined by its destructor.
+  std::unique_lock lock{mutex_};
+  cv_.wait(lock, [this] { return queue_.empty(); });
+  is_stopping_ = true;
+  cv_.notify_all();
+}
+
+auto DataWriter::acquire(real_t time) -> DataTimeStepSnapshotPtr {
+  std::unique_lock lock{mutex_};
+  wait_(lock, max_queue_size_);
+  DataTimeStepSnapshotPtr snapshot;
+  if (free_.empty()) {
+    snapshot = std::make_unique<DataTimeStepSnapshot>();
+  } else {
+    snapshot = std::move(free_.back());
+    free_.pop_back();
+  }
+  snapshot->reset(time);
+  return snapshot;
+}
+
+void DataWriter::submit(DataTimeStepSnapshotPtr snapshot) {
+  TIT_ASSERT(snapshot != nullptr, "Snapshot must not be null!");
+  const std::scoped_lock lock{mutex_};
+  queue_.push_back(std::move(snapshot));
+  Metrics::set("DataWriter::queue_size", static_cast<float64_t>(queue_.size()));
+  cv_.notify_all();
+}
+
+void DataWriter::flush() {
+  std::unique_lock lock{mutex_};
+  wait_(lock, 0);
+}
+
+void DataWriter::wait_(std::unique_lock<std::mutex>& lock,
+                       size_t queue_size) {
+  // Snapshot that is currently being written is still in the queue.
+  cv_.wait(lock, [queue_size, this] {
+    return error_ != nullptr || queue_.size() <= queue_size;
+  });
+  if (error_ != nullptr) std::rethrow_exception(std::exchange(error_, {}));
+}
+
+void DataWriter::run_() {
+  std::unique_lock lock{mutex_};
+  while (true) {
+    cv_.wait(lock, [this] { return is_stopping_ || !queue_.empty(); });
+    if (queue_.empty()) break;
+
+    // Snapshot stays at the front of the queue until it is written, so that
+    // the producer could not acquire it back in the meantime.
+    const auto& snapshot = *queue_.front();
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      // Compression runs in the I/O arena, so that it does not steal the
+      // workers from the compute tasks.
+      par::io_execute([&snapshot, this] {
+        auto transaction = series_.storage().transaction();
+        const auto time_step = series_.create_time_step(snapshot.time());
+        const auto write_dataset =
+            [](DataSetView<DataStorage> dataset,
+               const DataSetSnapshot& dataset_snapshot) {
+              for (const auto& array : dataset_snapshot.arrays()) {
+                dataset.create_array(array.name,
+                                     array.type,
+                                     std::span{array.data});
+              }
+            };
+        write_dataset(time_step.uniforms(), snapshot.uniforms());
+        write_dataset(time_step.varyings(), snapshot.varyings());
+        transaction.commit();
+
+        // Old series are cleaned up a little after each time step.
+        series_.storage().collect_garbage();
+      });
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    if (error != nullptr && error_ == nullptr) error_ = std::move(error);
+    free_.push_back(std::move(queue_.front()));
+    queue_.pop_front();
+    Metrics::set("DataWriter::queue_size",
+                 static_cast<float64_t>(queue_.size()));
+    cv_.notify_all();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
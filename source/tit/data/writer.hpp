@@ -0,0 +1,186 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Snapshot of a data array.
+struct DataArraySnapshot final {
+  /// Array name.
+  std::string name;
+
+  /// Array data type.
+  DataType type;
+
+  /// Serialized array data.
+  std::vector<byte_t> data;
+};
+
+/// Snapshot of a dataset.
+class DataSetSnapshot final {
+public:
+
+  /// Snapshot the values into a new data array.
+  template<std::ranges::input_range Vals>
+    requires known_type_of<std::ranges::range_value_t<Vals>>
+  void create_array(std::string_view name, Vals&& vals) {
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    using Val = std::ranges::range_value_t<Vals>;
+    auto& array = next_array_();
+    array.name = name;
+    array.type = type_of<Val>;
+    write_values(make_container_output_stream(array.data), vals);
+  }
+
+  /// Snapshot the serialized data into a new data array.
+  void create_array(std::string_view name,
+                    DataType type,
+                    std::vector<byte_t> data) {
+    auto& array = next_array_();
+    array.name = name;
+    array.type = type;
+    array.data = std::move(data);
+  }
+
+  /// Data arrays in the snapshot.
+  auto arrays() const noexcept -> std::span<const DataArraySnapshot> {
+    return std::span{arrays_}.first(num_arrays_);
+  }
+
+  /// Remove all the data arrays, but keep the allocated buffers.
+  void clear() noexcept {
+    num_arrays_ = 0;
+  }
+
+private:
+
+  auto next_array_() -> DataArraySnapshot&;
+
+  std::vector<DataArraySnapshot> arrays_;
+  size_t num_arrays_ = 0;
+
+}; // class DataSetSnapshot
+
+/// Snapshot of a data time step.
+class DataTimeStepSnapshot final {
+public:
+
+  /// Time step time.
+  auto time() const noexcept -> real_t {
+    return time_;
+  }
+
+  /// Uniform data.
+  auto uniforms(this auto& self) noexcept -> auto& {
+    return self.uniforms_;
+  }
+
+  /// Varying data.
+  auto varyings(this auto& self) noexcept -> auto& {
+    return self.varyings_;
+  }
+
+  /// Reset the snapshot for the new time step, but keep the allocated
+  /// buffers.
+  void reset(real_t time) noexcept {
+    time_ = time;
+    uniforms_.clear();
+    varyings_.clear();
+  }
+
+private:
+
+  real_t time_{};
+  DataSetSnapshot uniforms_;
+  DataSetSnapshot varyings_;
+
+}; // class DataTimeStepSnapshot
+
+/// Data time step snapshot pointer type.
+using DataTimeStepSnapshotPtr = std::unique_ptr<DataTimeStepSnapshot>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Asynchronous data series writer.
+///
+/// Time steps are snapshotted by the calling thread, and then compressed and
+/// written into the data series by a background thread, so that the caller
+/// can continue while the data is written. Each time step is written in a
+/// single transaction. At most `max_queue_size` submitted snapshots may wait
+/// to be written: once the queue is full, acquiring the next snapshot blocks
+/// until the oldest one is written. Snapshot buffers are reused between the
+/// time steps. After each time step, a bounded step of the storage garbage
+/// collection is performed, see `DataStorage::collect_garbage`.
+///
+/// The storage must not be accessed by the other threads while the writer
+/// is alive.
+class DataWriter final {
+public:
+
+  /// Construct a data writer.
+  explicit DataWriter(DataSeriesView<DataStorage> series,
+                      size_t max_queue_size = 1);
+
+  /// Data writer is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(DataWriter);
+
+  /// Write the remaining snapshots and stop the writer.
+  ~DataWriter() noexcept;
+
+  /// Acquire an empty snapshot of the time step. Blocks while the queue of
+  /// the submitted snapshots is full.
+  auto acquire(real_t time) -> DataTimeStepSnapshotPtr;
+
+  /// Submit the snapshot to be written in background.
+  void submit(DataTimeStepSnapshotPtr snapshot);
+
+  /// Block until all the submitted snapshots are written.
+  void flush();
+
+private:
+
+  void wait_(std::unique_lock<std::mutex>& lock, size_t queue_size);
+  void run_();
+
+  DataSeriesView<DataStorage> series_;
+  size_t max_queue_size_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<DataTimeStepSnapshotPtr> queue_;
+  std::vector<DataTimeStepSnapshotPtr> free_;
+  std::exception_ptr error_;
+  bool is_stopping_ = false;
+  std::jthread thread_;
+
+}; // class DataWriter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
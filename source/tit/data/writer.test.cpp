@@ -0,0 +1,79 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::DataWriter") {
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series("");
+  constexpr size_t num_time_steps = 5;
+  const auto values = [](size_t n) {
+    return std::views::iota(0UZ, 100UZ) |
+           std::views::transform(
+               [n](size_t i) { return static_cast<double>(n * i); });
+  };
+  const auto write = [&values](data::DataWriter& writer) {
+    for (size_t n = 0; n < num_time_steps; ++n) {
+      const auto time = static_cast<real_t>(n);
+      auto snapshot = writer.acquire(time);
+      CHECK(snapshot->time() == time);
+      CHECK(snapshot->uniforms().arrays().empty());
+      CHECK(snapshot->varyings().arrays().empty());
+      snapshot->uniforms().create_array("n", std::span{&n, 1});
+      snapshot->varyings().create_array("values", values(n));
+      writer.submit(std::move(snapshot));
+    }
+  };
+  const auto check = [&series, &values] {
+    REQUIRE(series.num_time_steps() == num_time_steps);
+    const auto time_steps = series.time_steps();
+    for (const auto& [n, time_step] : std::views::enumerate(time_steps)) {
+      CHECK(time_step.time() == static_cast<real_t>(n));
+      const auto step_index = static_cast<size_t>(n);
+      const auto n_array = time_step.uniforms().find_array("n");
+      REQUIRE(n_array);
+      CHECK(n_array->type() == data::type_of<size_t>);
+      CHECK_RANGE_EQ(n_array->data<size_t>(),
+                     std::vector{step_index});
+      const auto values_array = time_step.varyings().find_array("values");
+      REQUIRE(values_array);
+      CHECK(values_array->type() == data::type_of<double>);
+      CHECK_RANGE_EQ(values_array->data<double>(), values(step_index));
+    }
+  };
+  SUBCASE("flush") {
+    data::DataWriter writer{series};
+    write(writer);
+    writer.flush();
+    check();
+  }
+  SUBCASE("destructor") {
+    {
+      data::DataWriter writer{series, /*max_queue_size=*/2};
+      write(writer);
+    }
+    check();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
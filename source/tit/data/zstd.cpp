@@ -27,9 +27,41 @@ const size_t StreamCompressor::in_chunk_size_ = ZSTD_CStreamInSize();
 const size_t StreamCompressor::out_chunk_size_ = ZSTD_CStreamOutSize();
 // NOLINTEND(cert-err58-cpp)
 
-StreamCompressor::StreamCompressor(OutputStreamPtr<byte_t> stream)
+namespace {
+
+// Set the compression parameter.
+void set_parameter(ZSTD_CCtx* context, ZSTD_cParameter param, int value) {
+  if (const auto status = ZSTD_CCtx_setParameter(context, param, value);
+      ZSTD_isError(status) != 0) {
+    TIT_THROW("ZSTD compression parameter {} = {} is rejected ({}): {}.",
+              std::to_underlying(param),
+              value,
+              std::to_underlying(ZSTD_getErrorCode(status)),
+              ZSTD_getErrorName(status));
+  }
+}
+
+} // namespace
+
+StreamCompressor::StreamCompressor(OutputStreamPtr<byte_t> stream,
+                                   const CompressionOptions& options)
     : stream_{std::move(stream)}, context_{ZSTD_createCCtx()} {
   TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  if (context_ == nullptr) TIT_THROW("Unable to create ZSTD context!");
+  if (options.level != 0) {
+    set_parameter(context_.get(), ZSTD_c_compressionLevel, options.level);
+  }
+  if (options.strategy != Strategy::automatic) {
+    set_parameter(context_.get(),
+                  ZSTD_c_strategy,
+                  std::to_underlying(options.strategy));
+  }
+  if (options.num_workers != 0) {
+    // Note: this fails if ZSTD was built without multithreading support.
+    set_parameter(context_.get(),
+                  ZSTD_c_nbWorkers,
+                  static_cast<int>(options.num_workers));
+  }
 }
 
 void StreamCompressor::Deleter_::operator()(ZSTD_CCtx_s* context) noexcept {
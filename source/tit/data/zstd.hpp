@@ -20,13 +20,45 @@ namespace tit::data::zstd {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Compression strategy, from the fastest to the strongest.
+/// Values match the ZSTD strategy values.
+enum class Strategy : uint8_t {
+  automatic = 0, ///< Select the strategy by the compression level.
+  fast = 1,
+  dfast = 2,
+  greedy = 3,
+  lazy = 4,
+  lazy2 = 5,
+  btlazy2 = 6,
+  btopt = 7,
+  btultra = 8,
+  btultra2 = 9,
+};
+
+/// Compression options.
+struct CompressionOptions final {
+  /// Compression level. Zero selects the default ZSTD level.
+  int level = 0;
+
+  /// Compression strategy.
+  Strategy strategy = Strategy::automatic;
+
+  /// Number of the background threads that compress the data. Zero means
+  /// that the data is compressed by the calling thread. Multithreaded
+  /// compression pays off only for the data that is at least a few MiB.
+  size_t num_workers = 0;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Stream that compresses data using ZSTD and writes it to the underlying
 /// output stream.
 class StreamCompressor final : public OutputStream<byte_t> {
 public:
 
   /// Construct a stream compressor.
-  explicit StreamCompressor(OutputStreamPtr<byte_t> stream);
+  explicit StreamCompressor(OutputStreamPtr<byte_t> stream,
+                            const CompressionOptions& options = {});
 
   /// Compress the data and write it to the underlying stream.
   void write(std::span<const byte_t> data) override;
@@ -50,9 +82,10 @@ private:
 }; // class StreamCompressor
 
 /// Make a stream compressor.
-inline auto make_stream_compressor(OutputStreamPtr<byte_t> stream)
+inline auto make_stream_compressor(OutputStreamPtr<byte_t> stream,
+                                   const CompressionOptions& options = {})
     -> OutputStreamPtr<byte_t> {
-  return make_flushable<StreamCompressor>(std::move(stream));
+  return make_flushable<StreamCompressor>(std::move(stream), options);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -171,6 +171,43 @@ TEST_CASE("data::zstd::large_data") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("data::zstd::options") {
+  std::minstd_rand rng{42};
+  std::uniform_int_distribution<int> dist{0, 3};
+  const auto large_data =
+      std::views::iota(0UZ, 8 * 1024 * 1024UZ) |
+      std::views::transform([&rng, &dist](size_t) {
+        return static_cast<byte_t>(dist(rng));
+      }) |
+      std::ranges::to<std::vector>();
+
+  const auto run_subcase = [&large_data](
+                               const data::zstd::CompressionOptions& options) {
+    std::vector<byte_t> compressed_data;
+    make_stream_compressor(make_container_output_stream(compressed_data),
+                           options)
+        ->write(large_data);
+    REQUIRE(!compressed_data.empty());
+    CHECK(compressed_data.size() < large_data.size());
+
+    std::vector<byte_t> decompressed_data(large_data.size() * 3 / 2);
+    auto decompressor =
+        make_stream_decompressor(make_range_input_stream(compressed_data));
+    REQUIRE(decompressor->read(decompressed_data) == large_data.size());
+    CHECK(decompressed_data >= large_data);
+    CHECK(decompressor->read(decompressed_data) == 0);
+  };
+
+  SUBCASE("level and strategy") {
+    run_subcase({.level = 9, .strategy = data::zstd::Strategy::lazy2});
+  }
+  SUBCASE("multithreaded") {
+    run_subcase({.level = 1, .num_workers = 4});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("data::zstd::errors") {
   static std::minstd_rand rng{std::random_device{}()};
   SUBCASE("completely invalid data") {
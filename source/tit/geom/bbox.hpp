@@ -54,6 +54,11 @@ public:
     return high_ - low_;
   }
 
+  /// Check if the @p point is inside of the bounding box.
+  constexpr auto contains(const Vec& point) const -> bool {
+    return all(low_ <= point) && all(point <= high_);
+  }
+
   /// Find the point inside of bounding box that is closest to @p point.
   constexpr auto clamp(Vec point) const -> Vec {
     point = maximum(low_, point);
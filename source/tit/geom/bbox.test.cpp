@@ -43,6 +43,16 @@ TEST_CASE("geom::BBox::center_and_extents") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("geom::BBox::contains") {
+  const geom::BBox box{Vec{0.0, 0.0}, Vec{2.0, 2.0}};
+  CHECK(box.contains({1.0, 1.0}));
+  CHECK(box.contains({0.0, 2.0}));
+  CHECK_FALSE(box.contains({3.0, 1.0}));
+  CHECK_FALSE(box.contains({1.0, -1.0}));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("geom::BBox::clamp") {
   const geom::BBox box{Vec{0.0, 0.0}, Vec{2.0, 2.0}};
   CHECK(box.clamp({-1.0, -1.0}) == box.low());
@@ -13,6 +13,7 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/tuple_utils.hpp"
 #include "tit/core/utils.hpp"
@@ -24,6 +25,32 @@ namespace tit::geom {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Select the median element of the permutation. Large permutations, that
+// appear on the top levels of the recursive partitioning, are processed in
+// parallel, since only a few of the recursion branches are running there.
+template<output_index_range Perm,
+         class Compare = std::ranges::less,
+         class Proj = std::identity>
+constexpr void select_median(Perm&& perm,
+                             std::ranges::iterator_t<Perm> median,
+                             Compare compare = {},
+                             Proj proj = {}) {
+  TIT_ASSUME_UNIVERSAL(Perm, perm);
+  if !consteval {
+    if constexpr (par::range<Perm>) {
+      par::nth_element(perm, median, std::move(compare), std::move(proj));
+      return;
+    }
+  }
+  std::ranges::nth_element(perm, median, std::move(compare), std::move(proj));
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Coordinate bisection function.
 class CoordBisection final {
 public:
@@ -112,7 +139,7 @@ public:
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Perm, perm);
     TIT_ASSERT(axis < point_range_dim_v<Points>, "Axis is out of range!");
-    std::ranges::nth_element(
+    impl::select_median(
         perm,
         median,
         std::less{},
@@ -155,7 +182,7 @@ public:
       -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Perm, perm);
-    std::ranges::nth_element( //
+    impl::select_median( //
         perm,
         median,
         [&points, &dir](size_t i, size_t j) {
@@ -6,8 +6,10 @@
 #include <algorithm>
 #include <array>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/par/control.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/vec.hpp"
 
@@ -137,6 +139,30 @@ TEST_CASE("geom::CoordMedianSplit") {
     CHECK_RANGE_EQ(left_perm, expected_left_perm);
     CHECK_RANGE_EQ(right_perm, expected_right_perm);
   }
+  SUBCASE("large") {
+    // Create points on a 256x256 lattice, large enough to be split in
+    // parallel.
+    par::set_num_threads(4);
+    std::vector<Vec2D> points(256 * 256);
+    for (size_t i = 0; i < points.size(); ++i) points[i] = {i % 256, i / 256};
+
+    // Initialize the permutation.
+    std::vector<size_t> perm(points.size());
+    iota_perm(points, perm);
+
+    // Partition the points.
+    constexpr size_t axis = 0;
+    const auto [left_perm, right_perm] =
+        geom::coord_median_split(points, perm, perm.begin() + 32768, axis);
+
+    // Ensure the result is correct.
+    CHECK(std::ranges::all_of(left_perm, [&points](size_t i) {
+      return points[i][axis] < 128.0;
+    }));
+    CHECK(std::ranges::all_of(right_perm, [&points](size_t i) {
+      return points[i][axis] >= 128.0;
+    }));
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
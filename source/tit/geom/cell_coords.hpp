@@ -0,0 +1,176 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/grid.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Point encoded relative to a grid cell: the packed cell index, and the
+/// single precision offset of the point from the cell origin.
+template<size_t Dim>
+struct CellPoint final {
+  /// Offset of the point from the origin of its cell.
+  std::array<float32_t, Dim> offset;
+
+  /// Cell index, packed with the same number of bits per axis.
+  uint32_t cell;
+};
+
+/// Cell-relative point coordinates over a grid.
+///
+/// Absolute coordinates of a large domain lose the precision away from the
+/// origin, when they are stored in the single precision. Here, each point is
+/// stored as the index of the grid cell it belongs to, and the single
+/// precision offset from the cell origin, so the precision is relative to
+/// the cell size rather than to the domain size. Deltas of the points are
+/// computed from the cell index deltas and the offset deltas, so the nearby
+/// points are subtracted without the cancellation of the large coordinates.
+///
+/// Encoded point takes `4 * (Dim + 1)` bytes, which is half of the padded
+/// double precision vector in 3D. Cell index is packed with `32 / Dim` bits
+/// per axis, so the grid cells are typically much larger than the particle
+/// spacing, and are independent from the search grid.
+template<class Vec>
+class CellCoords final {
+public:
+
+  /// Spatial dimension.
+  static constexpr size_t Dim = vec_dim_v<Vec>;
+
+  /// Encoded point type.
+  using Point = CellPoint<Dim>;
+
+  /// Number of bits per axis in the packed cell index.
+  static constexpr size_t bits_per_axis = 32 / Dim;
+
+  /// Maximal number of cells per axis.
+  static constexpr size_t max_num_cells = size_t{1} << bits_per_axis;
+
+  /// Construct the coordinates over the grid.
+  constexpr explicit CellCoords(Grid<Vec> grid) : grid_{std::move(grid)} {
+    for (size_t i = 0; i < Dim; ++i) {
+      if (grid_.num_cells()[i] > max_num_cells) {
+        TIT_THROW("Number of cells per axis exceeded the limit of {}.",
+                  max_num_cells);
+      }
+    }
+  }
+
+  /// Underlying grid.
+  constexpr auto grid() const noexcept -> const Grid<Vec>& {
+    return grid_;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Encode the point. Points outside of the grid are assigned to the
+  /// nearest boundary cell, with the offsets outside of that cell.
+  constexpr auto encode(const Vec& point) const -> Point {
+    const auto& origin = grid_.box().low();
+    const auto& extents = grid_.cell_extents();
+    Point result{};
+    for (size_t i = 0; i < Dim; ++i) {
+      const auto index_float = floor((point[i] - origin[i]) / extents[i]);
+      const auto index = static_cast<uint32_t>(std::clamp(
+          index_float,
+          Num_{0.0},
+          static_cast<Num_>(grid_.num_cells()[i] - 1)));
+      result.cell |= index << (i * bits_per_axis);
+      result.offset[i] = static_cast<float32_t>(
+          point[i] - (origin[i] + static_cast<Num_>(index) * extents[i]));
+    }
+    return result;
+  }
+
+  /// Decode the point.
+  constexpr auto decode(const Point& point) const -> Vec {
+    const auto& origin = grid_.box().low();
+    const auto& extents = grid_.cell_extents();
+    Vec result{};
+    for (size_t i = 0; i < Dim; ++i) {
+      result[i] = origin[i] +
+                  static_cast<Num_>(axis_index_(point.cell, i)) * extents[i] +
+                  static_cast<Num_>(point.offset[i]);
+    }
+    return result;
+  }
+
+  /// Delta of the two points, `decode(a) - decode(b)`, computed from the
+  /// cell index delta and the offset delta.
+  constexpr auto delta(const Point& a, const Point& b) const -> Vec {
+    const auto& extents = grid_.cell_extents();
+    Vec result{};
+    for (size_t i = 0; i < Dim; ++i) {
+      const auto cell_delta = static_cast<int64_t>(axis_index_(a.cell, i)) -
+                              static_cast<int64_t>(axis_index_(b.cell, i));
+      result[i] = static_cast<Num_>(cell_delta) * extents[i] +
+                  (static_cast<Num_>(a.offset[i]) -
+                   static_cast<Num_>(b.offset[i]));
+    }
+    return result;
+  }
+
+  /// Move the point by the displacement. Point is re-encoded relative to the
+  /// cell it ends up in, so the offsets stay within the cell.
+  constexpr auto move(const Point& point, const Vec& displacement) const
+      -> Point {
+    const auto& extents = grid_.cell_extents();
+    Vec offset{};
+    for (size_t i = 0; i < Dim; ++i) {
+      offset[i] = static_cast<Num_>(point.offset[i]) + displacement[i];
+    }
+    auto result = point;
+    for (size_t i = 0; i < Dim; ++i) {
+      const auto index = static_cast<int64_t>(axis_index_(point.cell, i));
+      const auto shift = std::clamp(
+          static_cast<int64_t>(floor(offset[i] / extents[i])),
+          -index,
+          static_cast<int64_t>(grid_.num_cells()[i]) - 1 - index);
+      result.cell &= ~(axis_mask_ << (i * bits_per_axis));
+      result.cell |= static_cast<uint32_t>(index + shift)
+                     << (i * bits_per_axis);
+      result.offset[i] = static_cast<float32_t>(
+          offset[i] - static_cast<Num_>(shift) * extents[i]);
+    }
+    return result;
+  }
+
+private:
+
+  using Num_ = vec_num_t<Vec>;
+
+  static constexpr auto axis_mask_ =
+      static_cast<uint32_t>((uint64_t{1} << bits_per_axis) - 1);
+
+  // Index of the cell along the axis.
+  static constexpr auto axis_index_(uint32_t cell, size_t axis) noexcept
+      -> uint32_t {
+    return (cell >> (axis * bits_per_axis)) & axis_mask_;
+  }
+
+  Grid<Vec> grid_;
+
+}; // class CellCoords
+
+template<class Vec>
+CellCoords(Grid<Vec>) -> CellCoords<Vec>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
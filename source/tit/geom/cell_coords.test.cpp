@@ -0,0 +1,74 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/cell_coords.hpp"
+#include "tit/geom/grid.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::CellCoords") {
+  // Setup the coordinates over a domain far from the origin, where the
+  // single precision spacing of the absolute coordinates is `1/16`.
+  const geom::BBox box{Vec{1.0e6, 0.0}, Vec{1.0e6 + 1024.0, 512.0}};
+  const geom::CellCoords coords{geom::Grid{box, {1024, 512}}};
+  const Vec x{1.0e6 + 1000.25, 100.5};
+  const Vec y{1.0e6 + 1000.2501, 100.4999};
+  SUBCASE("encode and decode") {
+    const auto a = coords.encode(x);
+    CHECK(a.offset[0] == 0.25F);
+    CHECK(a.offset[1] == 0.5F);
+    CHECK(approx_equal_to(coords.decode(a), x));
+  }
+  SUBCASE("delta") {
+    // Delta of the nearby points is exact up to the single precision of the
+    // offsets, even though the absolute coordinates are never stored in it.
+    const auto delta = coords.delta(coords.encode(y), coords.encode(x));
+    CHECK(abs(delta[0] - 1.0e-4) < 1.0e-7);
+    CHECK(abs(delta[1] + 1.0e-4) < 1.0e-7);
+    CHECK(static_cast<float32_t>(y[0]) == static_cast<float32_t>(x[0]));
+  }
+  SUBCASE("move") {
+    // Moved point is re-encoded relative to its new cell.
+    const auto a = coords.move(coords.encode(x), Vec{2.5, -1.0});
+    CHECK(a.offset[0] == 0.75F);
+    CHECK(a.offset[1] == 0.5F);
+    CHECK(approx_equal_to(coords.decode(a), x + Vec{2.5, -1.0}));
+    CHECK(a.cell == coords.encode(x + Vec{2.5, -1.0}).cell);
+  }
+  SUBCASE("outside") {
+    // Points outside of the grid are assigned to the boundary cells.
+    const Vec z{1.0e6 - 2.0, 600.0};
+    const auto a = coords.encode(z);
+    CHECK(a.offset[0] == -2.0F);
+    CHECK(a.offset[1] == 89.0F);
+    CHECK(approx_equal_to(coords.decode(a), z));
+    CHECK(approx_equal_to(coords.delta(coords.encode(x), a), x - z));
+  }
+}
+
+TEST_CASE("geom::CellCoords::max_num_cells") {
+  using Coords = geom::CellCoords<Vec<double, 3>>;
+  STATIC_CHECK(Coords::bits_per_axis == 10);
+  const geom::BBox box{Vec{0.0, 0.0, 0.0}, Vec{1.0, 1.0, 1.0}};
+  CHECK_THROWS_MSG(Coords{geom::Grid{box, {2048, 1, 1}}},
+                   Exception,
+                   "Number of cells per axis exceeded the limit of 1024.");
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,11 +5,13 @@
 
 #pragma once
 
+#include <array>
 #include <ranges>
 #include <utility>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/vec.hpp"
 
@@ -30,6 +32,9 @@ public:
   // Index type.
   using VecIndex = decltype(vec_cast<size_t>(std::declval<Vec>()));
 
+  /// Number of cells in the `3^Dim` cell stencil.
+  static constexpr size_t stencil_size = pow<vec_dim_v<Vec>>(size_t{3});
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Initialize a grid with an empty bounding box and zero cells.
@@ -129,6 +134,36 @@ public:
     return flat_index;
   }
 
+  /// Check if the cell is not on the grid boundary, so that all of the cells
+  /// of its stencil exist.
+  constexpr auto is_interior(const VecIndex& index) const -> bool {
+    return all(index >= VecIndex(1)) && all(index + VecIndex(1) < num_cells_);
+  }
+
+  /// Flat index offsets of the `3^Dim` cell stencil, in the increasing order:
+  /// cell `flatten_cell_index(index + shift)`, where `shift` is in `{-1, 0,
+  /// 1}^Dim`, has the flat index `flatten_cell_index(index) + offset`.
+  ///
+  /// Offsets only depend on the number of cells, and are only valid for the
+  /// interior cells, see `is_interior`.
+  constexpr auto stencil_offsets() const -> std::array<ssize_t, stencil_size> {
+    constexpr auto Dim = vec_dim_v<Vec>;
+    std::array<ssize_t, stencil_size> offsets{};
+    for (size_t k = 0; k < stencil_size; ++k) {
+      // Digits of `k` in base 3 are the shifts, the first axis is the most
+      // significant one, same as in `flatten_cell_index`.
+      ssize_t offset = 0;
+      ssize_t stride = 1;
+      auto rest = k;
+      for (size_t i = Dim; i-- > 0; rest /= 3) {
+        offset += (static_cast<ssize_t>(rest % 3) - 1) * stride;
+        stride *= static_cast<ssize_t>(num_cells_[i]);
+      }
+      offsets[k] = offset;
+    }
+    return offsets;
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Range of cell indices, such that `low <= index < high`.
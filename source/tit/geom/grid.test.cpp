@@ -207,5 +207,32 @@ TEST_CASE("geom::Grid::cells") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("geom::Grid::stencil_offsets") {
+  using VecIndex = Vec<size_t, 2>;
+  const geom::BBox box{Vec{0.0, 0.0}, Vec{4.0, 5.0}};
+  const geom::Grid grid{box, {4, 5}};
+  const auto offsets = grid.stencil_offsets();
+  CHECK(offsets == std::to_array<ssize_t>({-6, -5, -4, -1, 0, 1, 4, 5, 6}));
+
+  // Ensure the offsets match the stencil cells of each interior cell.
+  for (const auto& index : grid.cells(1)) {
+    REQUIRE(grid.is_interior(index));
+    const auto flat_index =
+        static_cast<ssize_t>(grid.flatten_cell_index(index));
+    size_t k = 0;
+    for (const auto& other : grid.cells_inclusive(index - VecIndex(1),
+                                                  index + VecIndex(1))) {
+      const auto other_flat_index = grid.flatten_cell_index(other);
+      CHECK(static_cast<ssize_t>(other_flat_index) == flat_index + offsets[k]);
+      k += 1;
+    }
+  }
+  CHECK_FALSE(grid.is_interior({0, 2}));
+  CHECK_FALSE(grid.is_interior({3, 2}));
+  CHECK_FALSE(grid.is_interior({1, 4}));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -5,13 +5,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <ranges>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/containers/boost.hpp"
-#include "tit/core/containers/mdvector.hpp"
 #include "tit/core/par/algorithms.hpp"
 #include "tit/core/profiler.hpp"
 #include "tit/core/range_utils.hpp"
@@ -21,15 +22,14 @@
 #include "tit/geom/point_range.hpp"
 
 #include "tit/graph/graph.hpp"
-#include "tit/graph/simple_partition.hpp"
+#include "tit/graph/partition.hpp"
 
 namespace tit::geom {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Partitioning based on a graph partitioning of a grid cell connectivity.
-/// @todo Replace `UniformPartition` with a proper graph partitioning function.
-template<graph::partition_func GraphPartition = graph::UniformPartition>
+template<graph::partition_func GraphPartition = graph::MetisPartition>
 class GridGraphPartition final {
 public:
 
@@ -75,55 +75,80 @@ public:
     // Index the cells that contain the points. Thouse would be used as nodes
     // in the graph. We'll use amount of points in each cell as the node weight.
     //
-    // Since the typical SPH adjacency graph is heavily connected, we'll use
-    // the product of the node weights as the edge weight, as if each particle
-    // in the cell is connected to all other particles in neighboring cell.
-    struct NodeAndWeight {
-      graph::node_t node = npos;
-      graph::weight_t weight = 0;
-    };
-    Mdvector<NodeAndWeight, Dim> cells{grid.num_cells().elems()};
-    par::for_each(points, [&grid, &cells](const auto& point) {
-      auto& weight = cells[grid.cell_index(point).elems()].weight;
-      par::fetch_and_add(weight, 1);
+    // Only the occupied cells are stored: points are sorted by the flat cell
+    // index, and the runs of equal indices are compacted into the nodes, so
+    // that the memory does not depend on the bounding box volume.
+    const auto num_points = std::size(points);
+    std::vector<size_t> sorted_cells(num_points);
+    par::transform(points, sorted_cells.begin(), [&grid](const auto& point) {
+      return grid.flat_cell_index(point);
+    });
+    auto sorted_points = iota_perm(points) | std::ranges::to<std::vector>();
+    par::radix_sort(sorted_cells, sorted_points);
+    std::vector<size_t> node_firsts(num_points);
+    node_firsts.erase(par::copy_if(iota_perm(points),
+                                   node_firsts.begin(),
+                                   [&sorted_cells](size_t i) {
+                                     return i == 0 ||
+                                            sorted_cells[i] !=
+                                                sorted_cells[i - 1];
+                                   }),
+                      node_firsts.end());
+    const auto num_nodes = node_firsts.size();
+    node_firsts.push_back(num_points);
+    std::vector<size_t> node_cells(num_nodes);
+    std::vector<graph::weight_t> node_weights(num_nodes);
+    std::vector<graph::node_t> point_nodes(num_points);
+    par::for_each(std::views::iota(size_t{0}, num_nodes), [&](size_t node) {
+      const auto first = node_firsts[node];
+      const auto last = node_firsts[node + 1];
+      node_cells[node] = sorted_cells[first];
+      node_weights[node] = static_cast<graph::weight_t>(last - first);
+      for (auto i = first; i < last; ++i) point_nodes[sorted_points[i]] = node;
     });
-    size_t num_nodes = 0;
-    for (auto& [node, weight] : cells) {
-      if (weight > 0) node = num_nodes++;
-    }
+
+    // Find the node of the cell, if it is occupied.
+    const auto find_node = [&node_cells](size_t cell) -> graph::node_t {
+      const auto iter = std::ranges::lower_bound(node_cells, cell);
+      if (iter == node_cells.end() || *iter != cell) return npos;
+      return static_cast<graph::node_t>(iter - node_cells.begin());
+    };
 
     // Build the graph connecting the cells.
-    /// @todo I wish this code to be cleaner. Once we have a proper graph
-    ///       library, we can simplify this code.
+    //
+    // Since the typical SPH adjacency graph is heavily connected, we'll use
+    // the product of the node weights as the edge weight, as if each particle
+    // in the cell is connected to all other particles in neighboring cell.
+    // Occupied cells are never on the grid boundary, so the neighboring flat
+    // cell indices are always valid.
     static constexpr auto MaxNumEdges = 2 * Dim;
     using EdgeMap = InplaceFlatMap<size_t, size_t, MaxNumEdges>;
+    std::array<size_t, Dim> strides{};
+    strides[Dim - 1] = 1;
+    for (size_t d = Dim - 1; d > 0; --d) {
+      strides[d - 1] = strides[d] * grid.num_cells()[d];
+    }
     graph::CapWeightedGraph<MaxNumEdges> graph(num_nodes);
-    std::vector<graph::weight_t> node_weights(num_nodes);
-    par::for_each( //
-        grid.cells(1),
-        [&graph, &node_weights, &cells](const auto& cell_index) {
-          const auto& [node, weight] = cells[cell_index.elems()];
-          if (weight == 0) return;
-          TIT_ASSERT(node != npos, "Missing node!");
+    par::for_each(
+        std::views::iota(size_t{0}, num_nodes),
+        [&graph, &node_cells, &node_weights, &strides, &find_node](
+            size_t node) {
+          const auto cell = node_cells[node];
+          const auto weight = node_weights[node];
 
           // Build the edges.
           EdgeMap edges{};
-          for (size_t d = 0; d < Dim; ++d) {
-            for (ssize_t i = -1; i <= 1; i += 2) {
-              auto neighbor_cell_index = cell_index;
-              neighbor_cell_index[d] += i;
-              const auto& [neighbor, neighbor_weight] =
-                  cells[neighbor_cell_index.elems()];
-              if (neighbor_weight == 0) continue;
-
-              const auto edge_weight = weight * neighbor_weight;
+          for (const auto stride : strides) {
+            for (const auto neighbor_cell : {cell - stride, cell + stride}) {
+              const auto neighbor = find_node(neighbor_cell);
+              if (neighbor == npos) continue;
+              const auto edge_weight = weight * node_weights[neighbor];
               edges.emplace(neighbor, edge_weight);
             }
           }
 
-          // Set the node edges and weight.
+          // Set the node edges.
           graph.set_bucket(node, edges);
-          node_weights[node] = weight;
         });
 
     // Build the graph partitioning.
@@ -132,12 +157,10 @@ public:
 
     // Propagate the partitions to the points.
     par::transform( //
-        points,
+        iota_perm(points),
         std::begin(parts),
-        [&grid, &cells, &graph_parts, init_part](const auto& point) {
-          const auto node = cells[grid.cell_index(point).elems()].node;
-          TIT_ASSERT(node != npos, "Missing node!");
-          return init_part + graph_parts[node];
+        [&point_nodes, &graph_parts, init_part](size_t i) {
+          return init_part + graph_parts[point_nodes[i]];
         });
   }
 
@@ -3,8 +3,10 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <array>
 #include <ranges>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/vec.hpp"
@@ -19,6 +21,7 @@ namespace tit {
 namespace {
 
 using Vec2D = Vec<double, 2>;
+using Vec3D = Vec<double, 3>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -57,5 +60,29 @@ TEST_CASE("geom::GridGraphPartition") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("geom::GridGraphPartition::sparse") {
+  // Create two 4x4x4 lattices far away from each other. The dense grid over
+  // the bounding box would have ~10⁸ cells, most of which are empty.
+  std::vector<Vec3D> points{};
+  for (const auto offset : {0.0, 1000.0}) {
+    for (size_t i = 0; i < 64; ++i) {
+      points.push_back({i % 4 + offset, i / 4 % 4, i / 16});
+    }
+  }
+
+  // Partition the points. Nodes are numbered along the X axis, so the first
+  // lattice starts the first part, and the second lattice ends the second.
+  std::vector<size_t> parts(points.size());
+  const geom::GridGraphPartition grid_graph_partition{
+      /*size_hint=*/2.0,
+      graph::UniformPartition{}};
+  grid_graph_partition(points, parts, 2);
+  CHECK(parts.front() == 0);
+  CHECK(parts.back() == 1);
+  CHECK(std::ranges::all_of(parts, [](size_t part) { return part < 2; }));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -6,7 +6,10 @@
 #pragma once
 
 #include <algorithm>
+#include <concepts>
+#include <cstddef>
 #include <functional>
+#include <numeric>
 #include <ranges>
 #include <span>
 #include <utility>
@@ -45,8 +48,44 @@ public:
                   size_t num_parts,
                   size_t init_part = 0) const {
     TIT_PROFILE_SECTION("RecursiveBisection::operator()");
+    partition_(points, parts, num_parts, init_part, nullptr);
+  }
+
+  /// Partition the weighted points recursively using the bisector function.
+  /// Points are split such that the total weights of the parts are roughly
+  /// equal, instead of the point counts.
+  template<point_range Points,
+           std::ranges::random_access_range Weights,
+           output_index_range Parts>
+    requires std::convertible_to<std::ranges::range_reference_t<Weights>,
+                                 float64_t>
+  void operator()(Points&& points,
+                  Weights&& weights,
+                  Parts&& parts,
+                  size_t num_parts,
+                  size_t init_part = 0) const {
+    TIT_PROFILE_SECTION("RecursiveBisection::operator()");
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    if constexpr (std::ranges::sized_range<Weights>) {
+      TIT_ASSERT(std::size(points) == std::size(weights),
+                 "Size of weights range must be equal to number of points!");
+    }
+    partition_(points, parts, num_parts, init_part, [&weights](size_t index) {
+      return static_cast<float64_t>(weights[index]);
+    });
+  }
+
+private:
+
+  template<point_range Points, output_index_range Parts, class WeightFunc>
+  void partition_(Points&& points,
+                  Parts&& parts,
+                  size_t num_parts,
+                  size_t init_part,
+                  const WeightFunc& weight_func) const {
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Parts, parts);
+    static constexpr bool Weighted = !std::same_as<WeightFunc, std::nullptr_t>;
 
     // Validate the arguments.
     TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
@@ -60,7 +99,11 @@ public:
 
     // Partition the points.
     par::TaskGroup tasks{};
-    const auto impl = [&points, &parts, &tasks, &bisection = this->bisection_](
+    const auto impl = [&points,
+                       &parts,
+                       &tasks,
+                       &weight_func,
+                       &bisection = this->bisection_](
                           this const auto& self,
                           size_t my_num_parts,
                           size_t my_part,
@@ -78,9 +121,36 @@ public:
       const auto right_num_parts = my_num_parts - left_num_parts;
       const auto left_part = my_part;
       const auto right_part = my_part + left_num_parts;
-      const auto median_index = left_num_parts * my_perm.size() / my_num_parts;
-      const auto median = my_perm.begin() + static_cast<ssize_t>(median_index);
-      const auto [left_perm, right_perm] = bisection(points, my_perm, median);
+      const auto split = [&points, &bisection, my_perm](size_t median_index) {
+        const auto median =
+            my_perm.begin() + static_cast<ssize_t>(median_index);
+        return bisection(points, my_perm, median);
+      };
+      auto median_index = left_num_parts * my_perm.size() / my_num_parts;
+      if constexpr (Weighted) {
+        // Find the split with the desired left part weight by the binary
+        // search. Bisection direction does not depend on the median, so the
+        // left part weight is monotonic with respect to the median index.
+        const auto weight_of = [&weight_func](const auto& range) {
+          return std::ranges::fold_left(
+              range | std::views::transform(std::cref(weight_func)),
+              float64_t{0.0},
+              std::plus{});
+        };
+        const auto target_weight = weight_of(my_perm) *
+                                   static_cast<float64_t>(left_num_parts) /
+                                   static_cast<float64_t>(my_num_parts);
+        auto first = left_num_parts;
+        auto last = my_perm.size() - right_num_parts;
+        while (first < last) {
+          const auto middle = std::midpoint(first, last);
+          const auto middle_left_perm = split(middle).first;
+          if (weight_of(middle_left_perm) < target_weight) first = middle + 1;
+          else last = middle;
+        }
+        median_index = first;
+      }
+      const auto [left_perm, right_perm] = split(median_index);
 
       // Recursively partition the halves.
       tasks.run(std::bind_front(self, left_num_parts, left_part, left_perm));
@@ -90,8 +160,6 @@ public:
     tasks.wait();
   }
 
-private:
-
   [[no_unique_address]] Bisection bisection_;
 
 }; // class RecursiveBisection
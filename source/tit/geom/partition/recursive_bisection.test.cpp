@@ -49,6 +49,32 @@ TEST_CASE("geom::CoordBisection") {
   }
 }
 
+TEST_CASE("geom::CoordBisection (weighted)") {
+  // Create points on a 4x16 lattice, the left half of the points is three
+  // times heavier than the right half.
+  std::array<Vec2D, 64> points{};
+  std::array<double, 64> weights{};
+  for (size_t i = 0; i < 64; ++i) {
+    points[i] = {i % 16, i / 16};
+    weights[i] = i % 16 < 8 ? 3.0 : 1.0;
+  }
+
+  // Partition the points using the weighted coordinate bisection algorithm.
+  std::array<size_t, 64> parts{};
+  geom::recursive_coord_bisection(points, weights, parts, 4);
+
+  // Ensure the parts are balanced by weight: total weight is 128, so each
+  // part shall weigh about 32, up to a few point weights.
+  std::array<double, 4> part_weights{};
+  for (const auto& [part, weight] : std::views::zip(parts, weights)) {
+    part_weights[part] += weight;
+  }
+  for (const auto part_weight : part_weights) {
+    CHECK(part_weight >= 32.0 - 6.0);
+    CHECK(part_weight <= 32.0 + 6.0);
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("geom::InertialBisection") {
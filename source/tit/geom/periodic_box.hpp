@@ -0,0 +1,140 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Periodic box, whose opposite faces are identified along the periodic axes.
+///
+/// Points are wrapped into the box, and the point deltas are computed using
+/// the minimum image convention, so that no ghost copies of the points are
+/// needed. Along the other axes the box is unbounded.
+template<class Vec>
+class PeriodicBox final {
+public:
+
+  /// Bounding box type.
+  using Box = BBox<Vec>;
+
+  /// Periodic axes mask type.
+  using Mask = VecMask<vec_num_t<Vec>, vec_dim_v<Vec>>;
+
+  /// Number of the points in the `3^Dim` image stencil.
+  static constexpr size_t stencil_size = pow<vec_dim_v<Vec>>(size_t{3});
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Construct a periodic box.
+  ///
+  /// @param box  Periodic box.
+  /// @param axes Periodic axes. All of the axes are periodic by default.
+  constexpr explicit PeriodicBox(Box box, const Mask& axes = Mask(true))
+      : box_{std::move(box)}, period_{filter(axes, box_.extents())} {
+    for (size_t i = 0; i < vec_dim_v<Vec>; ++i) {
+      if (!axes[i]) continue;
+      TIT_ASSERT(period_[i] > 0, "Box must be non-empty along periodic axes!");
+      inv_period_[i] = inverse(period_[i]);
+    }
+  }
+
+  /// Bounding box.
+  constexpr auto box() const noexcept -> const Box& {
+    return box_;
+  }
+
+  /// Box periods, zero along the non-periodic axes.
+  constexpr auto period() const noexcept -> const Vec& {
+    return period_;
+  }
+
+  /// Check if the axis is periodic.
+  constexpr auto is_periodic(size_t axis) const noexcept -> bool {
+    TIT_ASSERT(axis < vec_dim_v<Vec>, "Axis is out of range!");
+    return period_[axis] > 0;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Wrap the point into the box along the periodic axes.
+  constexpr auto wrap(const Vec& point) const -> Vec {
+    return point - period_ * floor((point - box_.low()) * inv_period_);
+  }
+
+  /// Minimum image of the point delta along the periodic axes.
+  constexpr auto min_image(const Vec& delta) const -> Vec {
+    return delta - period_ * round(delta * inv_period_);
+  }
+
+  /// Call the function for each periodic image of the point, that is within
+  /// the radius to the box. The point itself is not visited.
+  ///
+  /// Point must be inside of the box, and the radius must not exceed half of
+  /// the box periods, so that each pair of points within the radius is found
+  /// through at most one image.
+  template<class Func>
+  constexpr void for_each_image(const Vec& point,
+                                vec_num_t<Vec> radius,
+                                Func func) const {
+    constexpr auto Dim = vec_dim_v<Vec>;
+
+    // Along each periodic axis, a point that is near the lower face has an
+    // image beyond the upper face, and vice versa.
+    Vec shift_near_low{};
+    Vec shift_near_high{};
+    bool any_near = false;
+    for (size_t i = 0; i < Dim; ++i) {
+      if (!is_periodic(i)) continue;
+      TIT_ASSERT(2 * radius <= period_[i], "Radius exceeds half the period!");
+      if (point[i] - box_.low()[i] < radius) {
+        shift_near_low[i] = period_[i], any_near = true;
+      } else if (box_.high()[i] - point[i] < radius) {
+        shift_near_high[i] = -period_[i], any_near = true;
+      }
+    }
+    if (!any_near) return;
+
+    // Digits of `k` in base 3 select the shifts, zero digit means no shift.
+    // Stencil points with a digit that selects the missing shift are skipped.
+    for (size_t k = 1; k < stencil_size; ++k) {
+      auto image = point;
+      bool valid = true;
+      auto rest = k;
+      for (size_t i = 0; i < Dim; ++i, rest /= 3) {
+        const auto digit = rest % 3;
+        if (digit == 0) continue;
+        const auto shift = digit == 1 ? shift_near_low[i] : shift_near_high[i];
+        if (shift == 0) {
+          valid = false;
+          break;
+        }
+        image[i] += shift;
+      }
+      if (valid) func(image);
+    }
+  }
+
+private:
+
+  Box box_;
+  Vec period_;
+  Vec inv_period_{};
+
+}; // class PeriodicBox
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
@@ -0,0 +1,75 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <vector>
+
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/periodic_box.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::PeriodicBox::wrap") {
+  const geom::PeriodicBox box{geom::BBox{Vec{0.0, 0.0}, Vec{4.0, 2.0}},
+                              VecMask<double, 2>{true, false}};
+  CHECK(box.is_periodic(0));
+  CHECK_FALSE(box.is_periodic(1));
+  CHECK(box.period() == Vec{4.0, 0.0});
+  CHECK(box.wrap({1.0, 1.0}) == Vec{1.0, 1.0});
+  CHECK(box.wrap({5.0, 1.0}) == Vec{1.0, 1.0});
+  CHECK(box.wrap({-1.0, 3.0}) == Vec{3.0, 3.0});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::PeriodicBox::min_image") {
+  const geom::PeriodicBox box{geom::BBox{Vec{0.0, 0.0}, Vec{4.0, 2.0}},
+                              VecMask<double, 2>{true, false}};
+  CHECK(box.min_image({1.0, 1.5}) == Vec{1.0, 1.5});
+  CHECK(box.min_image({3.5, 1.5}) == Vec{-0.5, 1.5});
+  CHECK(box.min_image({-3.0, -1.5}) == Vec{1.0, -1.5});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::PeriodicBox::for_each_image") {
+  const geom::PeriodicBox box{geom::BBox{Vec{0.0, 0.0}, Vec{4.0, 4.0}}};
+  const auto images = [&box](const Vec<double, 2>& point) {
+    std::vector<Vec<double, 2>> result;
+    box.for_each_image(point, 1.0, [&result](const auto& image) {
+      result.push_back(image);
+    });
+    std::ranges::sort(result, [](const auto& a, const auto& b) {
+      return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+    });
+    return result;
+  };
+  const auto eq = [](const auto& a, const auto& b) { return all(a == b); };
+  SUBCASE("interior") {
+    CHECK(images({2.0, 2.0}).empty());
+  }
+  SUBCASE("face") {
+    CHECK_RANGE_EQ(images({0.5, 2.0}), std::vector{Vec{4.5, 2.0}}, eq);
+    CHECK_RANGE_EQ(images({2.0, 3.5}), std::vector{Vec{2.0, -0.5}}, eq);
+  }
+  SUBCASE("corner") {
+    CHECK_RANGE_EQ(
+        images({0.5, 3.5}),
+        std::vector{Vec{0.5, -0.5}, Vec{4.5, -0.5}, Vec{4.5, 3.5}},
+        eq);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
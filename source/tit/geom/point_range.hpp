@@ -8,12 +8,15 @@
 #include <algorithm>
 #include <concepts>
 #include <expected>
+#include <functional>
 #include <iterator>
 #include <ranges>
+#include <utility>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/mat.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
@@ -68,7 +71,15 @@ constexpr auto compute_center(Points&& points) -> point_range_vec_t<Points> {
   TIT_ASSUME_UNIVERSAL(Points, points);
   TIT_ASSERT(!std::ranges::empty(points), "Points must not be empty!");
   auto sum = *std::begin(points);
-  for (const auto& point : points | std::views::drop(1)) sum += point;
+  const auto rest = points | std::views::drop(1);
+  if !consteval {
+    // Reduce the large ranges in parallel.
+    if (std::size(rest) > par::TransformReduce::grain_size) {
+      sum = par::transform_reduce(rest, sum, std::plus{}, std::identity{});
+      return sum / count_points(points);
+    }
+  }
+  for (const auto& point : rest) sum += point;
   return sum / count_points(points);
 }
 template<point_range Points, index_range Perm>
@@ -92,7 +103,20 @@ constexpr auto compute_bbox(Points&& points) -> point_range_bbox_t<Points> {
   TIT_ASSERT(!std::ranges::empty(points), "Points must not be empty!");
 #endif
   BBox box{*std::begin(points)};
-  for (const auto& point : points | std::views::drop(1)) box.expand(point);
+  const auto rest = points | std::views::drop(1);
+  if !consteval {
+    // Reduce the large ranges in parallel.
+    if (std::size(rest) > par::TransformReduce::grain_size) {
+      return par::transform_reduce(
+          rest,
+          box,
+          [](BBox<point_range_vec_t<Points>> a, const auto& b) {
+            return a.expand(b.low()).expand(b.high());
+          },
+          [](const auto& point) { return BBox{point}; });
+    }
+  }
+  for (const auto& point : rest) box.expand(point);
   return box;
 }
 template<point_range Points, index_range Perm>
@@ -106,6 +130,36 @@ constexpr auto compute_bbox(Points&& points, Perm&& perm)
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Compute the sum of the points and the sum of their outer squares.
+template<point_range Points>
+constexpr auto sum_point_moments(Points&& points)
+    -> std::pair<point_range_vec_t<Points>, point_range_mat_t<Points>> {
+  TIT_ASSUME_UNIVERSAL(Points, points);
+  std::pair moments{*std::begin(points), outer_sqr(*std::begin(points))};
+  const auto rest = points | std::views::drop(1);
+  if !consteval {
+    // Reduce the large ranges in parallel, both sums in a single pass.
+    if (std::size(rest) > par::TransformReduce::grain_size) {
+      return par::transform_reduce(
+          rest,
+          moments,
+          [](const auto& a, const auto& b) {
+            return std::pair{a.first + b.first, a.second + b.second};
+          },
+          [](const auto& point) { return std::pair{point, outer_sqr(point)}; });
+    }
+  }
+  for (const auto& point : rest) {
+    moments.first += point;
+    moments.second += outer_sqr(point);
+  }
+  return moments;
+}
+
+} // namespace impl
+
 /// Compute the inertia tensor of the given non-empty point range.
 ///
 /// Inertia tensor is defined as ∑rᵢ⊗rᵢ, where rᵢ is the position vector of
@@ -116,12 +170,7 @@ constexpr auto compute_inertia_tensor(Points&& points)
     -> point_range_mat_t<Points> {
   TIT_ASSUME_UNIVERSAL(Points, points);
   TIT_ASSERT(!std::ranges::empty(points), "Points must not be empty!");
-  auto sum = *std::begin(points);
-  auto inertia_tensor = outer_sqr(sum);
-  for (const auto& point : points | std::views::drop(1)) {
-    sum += point;
-    inertia_tensor += outer_sqr(point);
-  }
+  auto [sum, inertia_tensor] = impl::sum_point_moments(points);
   const auto center = sum / count_points(points);
   inertia_tensor -= outer(sum, center);
   return inertia_tensor;
@@ -23,6 +23,13 @@ using Vec2D = Vec<double, 2>;
 using Mat2D = Mat<double, 2>;
 using Box2D = geom::BBox<Vec2D>;
 
+// Create points on a 64x64 lattice, large enough to be reduced in parallel.
+auto make_lattice() -> std::vector<Vec2D> {
+  std::vector<Vec2D> points(64 * 64);
+  for (size_t i = 0; i < points.size(); ++i) points[i] = {i % 64, i / 64};
+  return points;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("geom::count_points") {
@@ -48,6 +55,9 @@ TEST_CASE("geom::compute_center") {
     constexpr std::array perm{1, 2, 0};
     CHECK(geom::compute_center(points, perm) == expected_center);
   }
+  SUBCASE("parallel") {
+    CHECK(geom::compute_center(make_lattice()) == Vec2D{31.5, 31.5});
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -82,6 +92,11 @@ TEST_CASE("geom::compute_inertia_tensor") {
     const auto tensor = geom::compute_inertia_tensor(points, perm);
     CHECK(tensor == expected_tensor);
   }
+  SUBCASE("parallel") {
+    // Each axis contributes 64 rows of `∑(i - 31.5)²`, where `0 <= i < 64`.
+    const auto tensor = geom::compute_inertia_tensor(make_lattice());
+    CHECK(tensor == Mat2D{{1397760.0, 0.0}, {0.0, 1397760.0}});
+  }
 }
 
 TEST_CASE("geom::compute_largest_inertia_axis") {
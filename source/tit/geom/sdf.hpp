@@ -0,0 +1,191 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Signed distance from the point to the bounding box boundary. Distance is
+/// negative inside of the box and positive outside of it.
+template<class Vec>
+constexpr auto box_sdf(const BBox<Vec>& box, const Vec& point)
+    -> vec_num_t<Vec> {
+  const auto delta = maximum(box.low() - point, point - box.high());
+  const auto outside = norm(maximum(delta, Vec(0)));
+  const auto inside = std::min(max_value(delta), vec_num_t<Vec>{0});
+  return outside + inside;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Signed distance field, sampled at the nodes of a uniform grid.
+///
+/// Distance is negative inside of the shape and positive outside of it.
+/// Between the nodes, the distance is interpolated multilinearly, so that
+/// any shape with a known distance function is represented with the same
+/// cost of a query. Outside of the grid bounding box, the distance at the
+/// closest point of the box is extended by the distance to that point.
+template<class Vec>
+class GridSDF final {
+public:
+
+  /// Numeric type.
+  using Num = vec_num_t<Vec>;
+
+  /// Index type.
+  using VecIndex = Grid<Vec>::VecIndex;
+
+  /// Construct an empty signed distance field.
+  constexpr GridSDF() = default;
+
+  /// Sample the signed distance function at the grid nodes.
+  ///
+  /// @param grid Sampling grid. Its cells should be a few times smaller than
+  ///             the smallest shape features.
+  /// @param dist Signed distance function.
+  template<std::invocable<const Vec&> Func>
+  GridSDF(Grid<Vec> grid, const Func& dist) : grid_{std::move(grid)} {
+    TIT_PROFILE_SECTION("GridSDF::GridSDF()");
+    num_nodes_ = grid_.num_cells() + VecIndex(1);
+    values_.resize(prod(num_nodes_));
+    par::for_each(std::views::iota(size_t{0}, values_.size()),
+                  [&dist, this](size_t flat_node_index) {
+                    const auto node_index = unflatten_(flat_node_index);
+                    values_[flat_node_index] = dist(node_point_(node_index));
+                  });
+  }
+
+  /// Sampling grid.
+  constexpr auto grid() const noexcept -> const Grid<Vec>& {
+    return grid_;
+  }
+
+  /// Signed distance at the point.
+  constexpr auto operator()(const Vec& point) const -> Num {
+    return eval_(point).first;
+  }
+
+  /// Gradient of the signed distance at the point.
+  constexpr auto grad(const Vec& point) const -> Vec {
+    return eval_(point).second;
+  }
+
+  /// Outer unit normal at the point, i.e. the normalized gradient.
+  constexpr auto normal(const Vec& point) const -> Vec {
+    return normalize(grad(point));
+  }
+
+  /// Closest point on the surface to the given point.
+  constexpr auto project(const Vec& point) const -> Vec {
+    const auto [dist, grad] = eval_(point);
+    return point - dist * normalize(grad);
+  }
+
+  /// Point mirrored over the surface.
+  constexpr auto mirror(const Vec& point) const -> Vec {
+    return 2 * project(point) - point;
+  }
+
+private:
+
+  // Flat index of the grid node.
+  constexpr auto flatten_(const VecIndex& node_index) const noexcept
+      -> size_t {
+    TIT_ASSERT(node_index < num_nodes_, "Node index is out of range!");
+    auto flat_index = node_index[0];
+    for (size_t i = 1; i < vec_dim_v<Vec>; ++i) {
+      flat_index = num_nodes_[i] * flat_index + node_index[i];
+    }
+    return flat_index;
+  }
+
+  // Grid node index from the flat index.
+  constexpr auto unflatten_(size_t flat_index) const noexcept -> VecIndex {
+    VecIndex node_index{};
+    for (size_t i = vec_dim_v<Vec>; i-- > 0;) {
+      node_index[i] = flat_index % num_nodes_[i];
+      flat_index /= num_nodes_[i];
+    }
+    return node_index;
+  }
+
+  // Position of the grid node.
+  constexpr auto node_point_(const VecIndex& node_index) const -> Vec {
+    return grid_.box().low() + vec_cast<Num>(node_index) * grid_.cell_extents();
+  }
+
+  // Interpolate the distance and its gradient at the point.
+  constexpr auto eval_(const Vec& point) const -> std::pair<Num, Vec> {
+    static constexpr auto Dim = vec_dim_v<Vec>;
+    TIT_ASSERT(!values_.empty(), "Signed distance field is empty!");
+
+    // Locate the cell and the local coordinates within it.
+    const auto clamped_point = grid_.box().clamp(point);
+    const auto& cell_extents = grid_.cell_extents();
+    const auto cell_point = (clamped_point - grid_.box().low()) / cell_extents;
+    VecIndex cell_index{};
+    Vec t{};
+    for (size_t i = 0; i < Dim; ++i) {
+      cell_index[i] = std::min(static_cast<size_t>(cell_point[i]),
+                               grid_.num_cells()[i] - 1);
+      t[i] = cell_point[i] - static_cast<Num>(cell_index[i]);
+    }
+
+    // Interpolate over the cell corners.
+    Num dist{};
+    Vec grad{};
+    for (size_t corner = 0; corner < (size_t{1} << Dim); ++corner) {
+      auto node_index = cell_index;
+      Vec weights{};
+      Vec signs{};
+      for (size_t i = 0; i < Dim; ++i) {
+        const bool upper = ((corner >> i) & 1) != 0;
+        node_index[i] += upper ? 1 : 0;
+        weights[i] = upper ? t[i] : 1 - t[i];
+        signs[i] = upper ? 1 : -1;
+      }
+      const auto value = values_[flatten_(node_index)];
+      dist += value * prod(weights);
+      for (size_t i = 0; i < Dim; ++i) {
+        auto grad_weight = signs[i] / cell_extents[i];
+        for (size_t j = 0; j < Dim; ++j) {
+          if (j != i) grad_weight *= weights[j];
+        }
+        grad[i] += value * grad_weight;
+      }
+    }
+
+    // Extend the distance outside of the grid bounding box.
+    dist += norm(point - clamped_point);
+    return {dist, grad};
+  }
+
+  Grid<Vec> grid_;
+  VecIndex num_nodes_{};
+  std::vector<Num> values_;
+
+}; // class GridSDF
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
@@ -0,0 +1,71 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+#include "tit/geom/sdf.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::box_sdf") {
+  const geom::BBox box{Vec{0.0, 0.0}, Vec{2.0, 1.0}};
+  SUBCASE("inside") {
+    CHECK_APPROX_EQ(geom::box_sdf(box, Vec{1.0, 0.5}), -0.5);
+    CHECK_APPROX_EQ(geom::box_sdf(box, Vec{0.25, 0.5}), -0.25);
+  }
+  SUBCASE("on the boundary") {
+    CHECK_APPROX_EQ(geom::box_sdf(box, Vec{2.0, 0.5}), 0.0);
+  }
+  SUBCASE("outside") {
+    CHECK_APPROX_EQ(geom::box_sdf(box, Vec{1.0, -0.5}), 0.5);
+    CHECK_APPROX_EQ(geom::box_sdf(box, Vec{3.0, 2.0}), sqrt(2.0));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::GridSDF") {
+  // Box distance is piecewise linear, so it is reproduced exactly away from
+  // the box corners and the medial axes.
+  const geom::BBox box{Vec{0.0, 0.0}, Vec{2.0, 1.0}};
+  const geom::GridSDF sdf{
+      geom::Grid{auto{box}.grow(0.5)}.set_cell_extents(0.125),
+      [&box](const Vec<double, 2>& point) { return geom::box_sdf(box, point); },
+  };
+  SUBCASE("distance") {
+    CHECK_APPROX_EQ(sdf(Vec{1.0, 0.1}), -0.1);
+    CHECK_APPROX_EQ(sdf(Vec{1.0, -0.3}), 0.3);
+    CHECK_APPROX_EQ(sdf(Vec{2.2, 0.5}), 0.2);
+  }
+  SUBCASE("normal") {
+    CHECK_APPROX_EQ(sdf.normal(Vec{1.0, 0.1}), Vec{0.0, -1.0});
+    CHECK_APPROX_EQ(sdf.normal(Vec{1.0, -0.3}), Vec{0.0, -1.0});
+    CHECK_APPROX_EQ(sdf.normal(Vec{2.2, 0.5}), Vec{1.0, 0.0});
+  }
+  SUBCASE("project") {
+    CHECK_APPROX_EQ(sdf.project(Vec{1.0, -0.3}), Vec{1.0, 0.0});
+    CHECK_APPROX_EQ(sdf.project(Vec{2.2, 0.5}), Vec{2.0, 0.5});
+  }
+  SUBCASE("mirror") {
+    CHECK_APPROX_EQ(sdf.mirror(Vec{1.0, -0.3}), Vec{1.0, 0.3});
+    CHECK_APPROX_EQ(sdf.mirror(Vec{2.2, 0.5}), Vec{1.8, 0.5});
+  }
+  SUBCASE("outside of the grid") {
+    CHECK_APPROX_EQ(sdf(Vec{1.0, -1.0}), 1.0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
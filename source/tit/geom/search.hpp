@@ -10,6 +10,7 @@
 // IWYU pragma: begin_exports
 #include "tit/geom/search/grid_search.hpp"
 #include "tit/geom/search/kd_tree_search.hpp"
+#include "tit/geom/search/octree_search.hpp"
 // IWYU pragma: end_exports
 
 namespace tit::geom {
@@ -18,8 +19,9 @@ namespace tit::geom {
 
 /// Spatial search indexing function type.
 template<class SF>
-concept search_func = std::same_as<SF, GridSearch> || //
-                      std::same_as<SF, KDTreeSearch>;
+concept search_func = std::same_as<SF, GridSearch> ||   //
+                      std::same_as<SF, KDTreeSearch> || //
+                      std::same_as<SF, OctreeSearch>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
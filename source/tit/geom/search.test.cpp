@@ -3,13 +3,16 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <iterator>
 #include <random>
 #include <ranges>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/vec.hpp"
 
@@ -76,6 +79,25 @@ auto search_grid(const std::vector<Vec3D>& points,
   return result;
 }
 
+// Nearest neighbor search via a grid that was built for the other points and
+// then updated.
+auto search_grid_updated(const std::vector<Vec3D>& initial_points,
+                         const std::vector<Vec3D>& points,
+                         double search_radius,
+                         double size_hint) -> SearchResult {
+  // Construct the grid and update it.
+  const geom::GridSearch grid_search{size_hint};
+  auto grid_index = grid_search(initial_points);
+  grid_search.update(grid_index, points);
+
+  // Perform the nearest neighbor search.
+  SearchResult result(points.size());
+  for (const auto& [point, result_row] : std::views::zip(points, result)) {
+    grid_index.search(point, search_radius, std::back_inserter(result_row));
+  }
+  return result;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 // Nearest neighbor search via a K-dimensional tree.
@@ -94,6 +116,22 @@ auto search_kd_tree(const std::vector<Vec3D>& points,
   return result;
 }
 
+// Nearest neighbor search via an octree.
+auto search_octree(const std::vector<Vec3D>& points,
+                   double search_radius,
+                   size_t max_leaf_size) -> SearchResult {
+  // Construct the octree.
+  const geom::OctreeSearch octree_search{max_leaf_size};
+  const auto octree_index = octree_search(points);
+
+  // Perform the nearest neighbor search.
+  SearchResult result(points.size());
+  for (const auto& [point, result_row] : std::views::zip(points, result)) {
+    octree_index.search(point, search_radius, std::back_inserter(result_row));
+  }
+  return result;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("geom::Search") {
@@ -127,6 +165,53 @@ TEST_CASE("geom::Search") {
           search_grid(points, search_radius, 5.0 * search_radius);
       match_search_results(result_naive, result_grid);
     }
+    SUBCASE("for each near") {
+      const geom::GridSearch grid_search{0.5 * search_radius};
+      const auto grid_index = grid_search(points);
+      SearchResult result_grid(points.size());
+      for (size_t i = 0; i < points.size(); ++i) {
+        grid_index.for_each_near(points[i],
+                                 search_radius,
+                                 [&row = result_grid[i]](size_t j) {
+                                   row.push_back(j);
+                                 });
+      }
+      match_search_results(result_naive, result_grid);
+    }
+    SUBCASE("pairs") {
+      const geom::GridSearch grid_search{0.5 * search_radius};
+      const auto grid_index = grid_search(points);
+      Multivector<std::pair<size_t, size_t>> pairs;
+      grid_index.search_pairs(search_radius, pairs);
+      SearchResult result_grid(points.size());
+      for (size_t i = 0; i < points.size(); ++i) result_grid[i] = {i};
+      for (const auto& [a, b] : pairs.values()) {
+        REQUIRE(a < b);
+        result_grid[a].push_back(b);
+        result_grid[b].push_back(a);
+      }
+      match_search_results(result_naive, result_grid);
+    }
+    SUBCASE("update, grid is reused") {
+      std::vector<Vec3D> initial_points{points};
+      for (auto& point : initial_points) {
+        point = Vec3D(0.5) + 0.99 * (point - Vec3D(0.5));
+      }
+      const auto result_grid = search_grid_updated(initial_points,
+                                                   points,
+                                                   search_radius,
+                                                   0.5 * search_radius);
+      match_search_results(result_naive, result_grid);
+    }
+    SUBCASE("update, grid is rebuilt") {
+      std::vector<Vec3D> initial_points{points};
+      for (auto& point : initial_points) point *= 0.5;
+      const auto result_grid = search_grid_updated(initial_points,
+                                                   points,
+                                                   search_radius,
+                                                   0.5 * search_radius);
+      match_search_results(result_naive, result_grid);
+    }
   }
 
   // Nearest neighbor search with a K-dimensional tree.
@@ -139,7 +224,155 @@ TEST_CASE("geom::Search") {
       const auto result_kd_tree = search_kd_tree(points, search_radius, 10);
       match_search_results(result_naive, result_kd_tree);
     }
+    SUBCASE("max leaf size = 16") {
+      const auto result_kd_tree = search_kd_tree(points, search_radius, 16);
+      match_search_results(result_naive, result_kd_tree);
+    }
+    SUBCASE("copied index") {
+      // Index must remain valid after the original index is destroyed.
+      const auto kd_tree_index = [&points] {
+        const auto original_index = geom::KDTreeSearch{16}(points);
+        auto copied_index = original_index;
+        return copied_index;
+      }();
+      SearchResult result_kd_tree(points.size());
+      for (const auto& [point, result_row] :
+           std::views::zip(points, result_kd_tree)) {
+        kd_tree_index.search(point,
+                             search_radius,
+                             std::back_inserter(result_row));
+      }
+      match_search_results(result_naive, result_kd_tree);
+    }
+  }
+
+  // Batched nearest neighbor search.
+  SUBCASE("batch") {
+    const std::vector<double> radii(points.size(), search_radius);
+    const auto to_result = [](const Multivector<size_t>& batch_result) {
+      return batch_result.buckets() |
+             std::views::transform([](auto bucket) {
+               return bucket | std::ranges::to<std::vector>();
+             }) |
+             std::ranges::to<std::vector>();
+    };
+    SUBCASE("grid") {
+      const geom::GridSearch grid_search{0.5 * search_radius};
+      const auto grid_index = grid_search(points);
+      Multivector<size_t> result_grid;
+      grid_index.search_batch(points, radii, result_grid);
+      match_search_results(result_naive, to_result(result_grid));
+    }
+    SUBCASE("KD tree") {
+      const geom::KDTreeSearch kd_tree_search{16};
+      const auto kd_tree_index = kd_tree_search(points);
+      Multivector<size_t> result_kd_tree;
+      kd_tree_index.search_batch(points, radii, result_kd_tree);
+      match_search_results(result_naive, to_result(result_kd_tree));
+    }
+  }
+
+  // Nearest neighbor search with an octree.
+  SUBCASE("octree") {
+    SUBCASE("max leaf size = 1") {
+      const auto result_octree = search_octree(points, search_radius, 1);
+      match_search_results(result_naive, result_octree);
+    }
+    SUBCASE("max leaf size = 16") {
+      const auto result_octree = search_octree(points, search_radius, 16);
+      match_search_results(result_naive, result_octree);
+    }
+  }
+}
+
+TEST_CASE("geom::GridIndex::sparse") {
+  // Generate random points in the unit cube, and a few splashed ones far
+  // away from it, so that the most of the grid cells are empty.
+  const auto points = [] {
+    std::mt19937 random_engine{/*seed=*/123};
+    std::uniform_real_distribution<double> dist{0.0, 1.0};
+    std::vector<Vec3D> points_(1000);
+    for (auto& point : points_) {
+      for (size_t i = 0; i < 3; ++i) point[i] = dist(random_engine);
+    }
+    points_.push_back(Vec3D{100.0, 0.0, 0.0});
+    points_.push_back(Vec3D{100.0, 0.05, 0.0});
+    points_.push_back(Vec3D{0.0, -50.0, 70.0});
+    return points_;
+  }();
+  constexpr double search_radius = 0.1;
+  const auto result_naive = search_naive(points, search_radius);
+
+  // Only the occupied cells must be stored.
+  const geom::GridSearch grid_search{0.5 * search_radius};
+  const auto grid_index = grid_search(points);
+  REQUIRE(grid_index.sparse());
+  CHECK(grid_index.memory_usage() < 1000 * points.size());
+
+  SUBCASE("search") {
+    match_search_results(
+        result_naive,
+        search_grid(points, search_radius, 0.5 * search_radius));
+  }
+  SUBCASE("batch") {
+    const std::vector<double> radii(points.size(), search_radius);
+    Multivector<size_t> result_grid;
+    grid_index.search_batch(points, radii, result_grid);
+    match_search_results(result_naive,
+                         result_grid.buckets() |
+                             std::views::transform([](auto bucket) {
+                               return bucket | std::ranges::to<std::vector>();
+                             }) |
+                             std::ranges::to<std::vector>());
+  }
+  SUBCASE("pairs") {
+    Multivector<std::pair<size_t, size_t>> pairs;
+    grid_index.search_pairs(search_radius, pairs);
+    SearchResult result_grid(points.size());
+    for (size_t i = 0; i < points.size(); ++i) result_grid[i] = {i};
+    for (const auto& [a, b] : pairs.values()) {
+      REQUIRE(a < b);
+      result_grid[a].push_back(b);
+      result_grid[b].push_back(a);
+    }
+    match_search_results(result_naive, result_grid);
+  }
+}
+
+TEST_CASE("geom::OctreeIndex::search_symmetric") {
+  // Generate random points with the density contrast: the most of the points
+  // are clustered in the small cube, and the radii are scaled accordingly.
+  std::mt19937 random_engine{/*seed=*/123};
+  std::uniform_real_distribution<double> dist{0.0, 1.0};
+  std::vector<Vec3D> points(1000);
+  std::vector<double> radii(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    const auto scale = i % 10 == 0 ? 1.0 : 0.1;
+    for (size_t j = 0; j < 3; ++j) points[i][j] = scale * dist(random_engine);
+    radii[i] = 0.1 * scale;
+  }
+
+  // Nearest neighbor search using a naive approach.
+  SearchResult result_naive(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    for (size_t j = 0; j < points.size(); ++j) {
+      const auto radius = std::max(radii[i], radii[j]);
+      if (norm2(points[i] - points[j]) < pow2(radius)) {
+        result_naive[i].push_back(j);
+      }
+    }
+  }
+
+  // Nearest neighbor search using an octree.
+  const auto octree_index = geom::octree_indexing(points, radii);
+  REQUIRE(octree_index.has_radii());
+  SearchResult result_octree(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    octree_index.search_symmetric(points[i],
+                                  radii[i],
+                                  std::back_inserter(result_octree[i]));
   }
+  match_search_results(result_naive, result_octree);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
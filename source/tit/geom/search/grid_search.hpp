@@ -6,16 +6,22 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <concepts>
 #include <iterator>
 #include <ranges>
+#include <span>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/containers/multivector.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/type_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
@@ -23,12 +29,19 @@
 #include "tit/geom/bbox.hpp"
 #include "tit/geom/grid.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/search/search_batch.hpp"
 
 namespace tit::geom {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Uniform multidimensional grid spatial search index.
+///
+/// If the grid has much more cells than points, e.g. when a few points are
+/// far away from the rest, only the occupied cells are stored, and the cells
+/// are looked up by their flat index in the sorted list of the occupied ones.
+/// The index memory is then proportional to the number of points, and not to
+/// the volume of the bounding box.
 template<point_range Points>
   requires std::ranges::view<Points>
 class GridIndex final {
@@ -44,20 +57,37 @@ public:
   /// @param size_hint Cell size hint, typically 2x of the particle spacing.
   GridIndex(Points points, vec_num_t<Vec> size_hint)
       : points_{std::move(points)} {
-    TIT_ASSERT(size_hint > 0.0, "Cell size hint must be positive!");
+    bin_points_(size_hint);
+  }
 
-    // Compute bounding box and initialize the grid.
-    const auto box = compute_bbox(points_).grow(size_hint / 2);
-    // NOLINTNEXTLINE(*-prefer-member-initializer)
-    grid_ = Grid{box}.set_cell_extents(size_hint);
+  /// Re-index the points, reusing the grid and the buffers.
+  ///
+  /// The grid is rebuilt only if the cell size hint has changed or some of
+  /// the points have left the grid bounding box. Since the box is extended
+  /// with a slack of a few cells, this happens rarely for the slowly moving
+  /// points, and the points are simply re-binned into the existing cells.
+  ///
+  /// @param size_hint Cell size hint, typically 2x of the particle spacing.
+  void reindex(Points points, vec_num_t<Vec> size_hint) {
+    points_ = std::move(points);
+    bin_points_(size_hint);
+  }
 
-    // Pack the points into a multivector.
-    cell_points_.assign_pairs_par_tall(
-        grid_.flat_num_cells(),
-        iota_perm(points_) | std::views::transform([this](size_t point) {
-          const auto cell = grid_.flat_cell_index(points_[point]);
-          return std::pair{cell, point};
-        }));
+  /// Are only the occupied cells stored?
+  auto sparse() const noexcept -> bool {
+    return sparse_;
+  }
+
+  /// Memory allocated by the index (in bytes), including the unused
+  /// capacity.
+  auto memory_usage() const noexcept -> size_t {
+    size_t result = (point_cells_.capacity() + sorted_cells_.capacity() +
+                     sorted_points_.capacity() + occupied_cells_.capacity()) *
+                    sizeof(size_t);
+    for (const auto& coords : coords_) {
+      result += coords.capacity() * sizeof(Num_);
+    }
+    return result + cell_points_.memory_usage();
   }
 
   /// Find the points within the radius to the given point.
@@ -69,30 +99,392 @@ public:
               Pred pred = {}) const -> OutIter {
     TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
 
-    // Calculate the search box.
-    const auto search_box = BBox{search_point}.grow(search_radius);
-
-    // Collect points within the search box.
+    // Collect points within the search cells. Predicate is only applied to
+    // the points that have passed the distance filter.
     const auto search_dist = pow2(search_radius);
-    for (const auto& cell_index : grid_.cells_intersecting(search_box)) {
-      const auto flat_cell_index = grid_.flatten_cell_index(cell_index);
-      out = copy_points_near(points_,
-                             cell_points_[flat_cell_index],
-                             out,
-                             search_point,
-                             search_dist,
-                             pred);
-    }
+    const auto slot_points = cell_points_.values();
+    for_each_cell_near_(search_point, search_radius, [&](size_t flat_index) {
+      const auto [first, last] = cell_slots_(flat_index);
+      for_each_slot_near_(first,
+                          last,
+                          search_point,
+                          search_dist,
+                          [&out, &pred, slot_points](size_t slot) {
+                            const auto point = slot_points[slot];
+                            if (pred(point)) *out++ = point;
+                          });
+    });
 
     return out;
   }
 
+  /// Find the points within the radii to each of the given points.
+  ///
+  /// Queries are grouped by the grid cell and searched cell by cell, so
+  /// that the queries within the same cell visit the same neighboring cells
+  /// one after another.
+  ///
+  /// @param queries Query points.
+  /// @param radii   Search radii, one per query point.
+  /// @param result  Found points, one bucket per query point.
+  template<std::ranges::random_access_range Queries,
+           std::ranges::random_access_range Radii,
+           class Val>
+  void search_batch(const Queries& queries,
+                    const Radii& radii,
+                    Multivector<Val>& result) const {
+    TIT_PROFILE_SECTION("GridIndex::search_batch()");
+
+    // Group the queries by the cell. Queries are clamped to the grid box
+    // the same way the points are.
+    auto box = grid_.box();
+    box.shrink(grid_.cell_extents() / 2);
+    if (sparse_) {
+      // Bucketing would allocate all the grid cells, sort the queries by
+      // the cell keys instead.
+      std::vector<size_t> query_cells(std::size(queries));
+      auto order = std::views::iota(size_t{0}, std::size(queries)) |
+                   std::ranges::to<std::vector>();
+      par::for_each(std::views::iota(size_t{0}, std::size(queries)),
+                    [&queries, &box, &query_cells, this](size_t query) {
+                      query_cells[query] =
+                          grid_.flat_cell_index(box.clamp(queries[query]));
+                    });
+      par::radix_sort(query_cells, order);
+      impl::search_batch_ordered(*this, queries, radii, order, result);
+      return;
+    }
+    Multivector<size_t> cell_queries;
+    cell_queries.assign_pairs_par(
+        grid_.flat_num_cells(),
+        std::views::iota(size_t{0}, std::size(queries)) |
+            std::views::transform([&queries, &box, this](size_t query) {
+              const auto& query_point = queries[query];
+              return std::pair{grid_.flat_cell_index(box.clamp(query_point)),
+                               query};
+            }));
+    const auto order = cell_queries.buckets() | std::views::join |
+                       std::ranges::to<std::vector>();
+
+    // Search the grouped queries.
+    impl::search_batch_ordered(*this, queries, radii, order, result);
+  }
+
+  /// Find the unique pairs of the points within the radius to each other.
+  ///
+  /// Each cell is checked against itself and the "forward" half of the
+  /// neighboring cells only, that are the cells with the larger flat index,
+  /// so the distance for each pair of points is computed once.
+  ///
+  /// @param search_radius Search radius.
+  /// @param result        Found pairs `(a, b)`, such that `a < b`, one
+  ///                      bucket per stored grid cell.
+  template<std::unsigned_integral Val>
+  void search_pairs(vec_num_t<Vec> search_radius,
+                    Multivector<std::pair<Val, Val>>& result) const {
+    TIT_PROFILE_SECTION("GridIndex::search_pairs()");
+    TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+    const auto search_dist = pow2(search_radius);
+    result.assign_buckets_par(
+        sparse_ ? occupied_cells_.size() : grid_.flat_num_cells(),
+        [search_radius, search_dist, this](size_t cell, auto out) {
+          const auto flat_cell_index = sparse_ ? occupied_cells_[cell] : cell;
+          const auto [first, last] = cell_slots_(flat_cell_index);
+          if (first == last) return;
+          const auto slot_points = cell_points_.values();
+          const auto emit_near = [search_dist, &out, slot_points, this](
+                                     size_t slot,
+                                     size_t other_first,
+                                     size_t other_last) {
+            const auto a = slot_points[slot];
+            for_each_slot_near_(other_first,
+                                other_last,
+                                slot_point_(slot),
+                                search_dist,
+                                [a, &out, slot_points](size_t other_slot) {
+                                  const auto b = slot_points[other_slot];
+                                  *out++ = std::pair{
+                                      static_cast<Val>(std::min(a, b)),
+                                      static_cast<Val>(std::max(a, b))};
+                                });
+          };
+
+          // Check the pairs within the cell.
+          for (size_t slot = first; slot < last; ++slot) {
+            emit_near(slot, slot + 1, last);
+          }
+
+          // Check the pairs with the forward neighboring cells. If the radius
+          // does not exceed the cell extents, those are the forward half of
+          // the cell stencil, that have the positive offsets.
+          if (search_radius <= stencil_radius_ &&
+              grid_.is_interior(grid_.cell_index(slot_point_(first)))) {
+            for (const auto offset :
+                 std::span{stencil_}.subspan(Grid<Vec>::stencil_size / 2 + 1)) {
+              const auto [other_first, other_last] =
+                  cell_slots_(flat_cell_index + static_cast<size_t>(offset));
+              for (size_t slot = first; slot < last; ++slot) {
+                emit_near(slot, other_first, other_last);
+              }
+            }
+            return;
+          }
+
+          // Otherwise, any point within the radius to the cell points lies
+          // within the cell points bounding box, extended by the radius.
+          BBox search_box{slot_point_(first)};
+          for (size_t slot = first + 1; slot < last; ++slot) {
+            search_box.expand(slot_point_(slot));
+          }
+          search_box.grow(search_radius);
+          for (const auto& cell_index : grid_.cells_intersecting(search_box)) {
+            const auto other_flat_cell_index =
+                grid_.flatten_cell_index(cell_index);
+            if (other_flat_cell_index <= flat_cell_index) continue;
+            const auto [other_first, other_last] =
+                cell_slots_(other_flat_cell_index);
+            for (size_t slot = first; slot < last; ++slot) {
+              emit_near(slot, other_first, other_last);
+            }
+          }
+        });
+  }
+
+  /// Call the function for each of the points within the radius to the given
+  /// point. Unlike `search`, the points are not collected anywhere.
+  template<std::invocable<size_t> Func>
+  void for_each_near(const Vec& search_point,
+                     vec_num_t<Vec> search_radius,
+                     Func func) const {
+    TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+
+    // Visit the points within the search cells.
+    const auto search_dist = pow2(search_radius);
+    const auto slot_points = cell_points_.values();
+    for_each_cell_near_(search_point, search_radius, [&](size_t flat_index) {
+      const auto [first, last] = cell_slots_(flat_index);
+      for_each_slot_near_(first,
+                          last,
+                          search_point,
+                          search_dist,
+                          [&func, slot_points](size_t slot) {
+                            func(slot_points[slot]);
+                          });
+    });
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  using Num_ = vec_num_t<Vec>;
+  static constexpr size_t Dim_ = vec_dim_v<Vec>;
+
+  // Grid bounding box slack, in cells.
+  static constexpr size_t ExtentSlack_ = 2;
+
+  // Minimal ratio of the grid cells to the points, at which only the
+  // occupied cells are stored.
+  static constexpr size_t SparseRatio_ = 8;
+
+  // Should the cell points be filtered on the SIMD registers?
+  static constexpr bool simd_cells_ = simd::supported_type<Num_>;
+
+  // Number of the cell points processed at once.
+  static constexpr size_t CellBatch_ = [] {
+    if constexpr (simd_cells_) return simd::max_reg_size_v<Num_>;
+    else return 1;
+  }();
+
+  // Compute the point cells, rebuilding the grid if needed, and pack the
+  // points into the cells by sorting them by the cell keys.
+  void bin_points_(vec_num_t<Vec> size_hint) {
+    TIT_ASSERT(size_hint > 0.0, "Cell size hint must be positive!");
+
+    // Compute the point cells if the grid is still valid. Points must stay
+    // half a cell away from the grid boundary, like on the grid construction.
+    point_cells_.resize(std::size(points_));
+    std::atomic_bool covered = size_hint == size_hint_;
+    if (covered) {
+      auto box = grid_.box();
+      box.shrink(size_hint / 2);
+      par::for_each(iota_perm(points_), [&box, &covered, this](size_t point) {
+        const auto& p = points_[point];
+        if (!all(box.low() <= p) || !all(p < box.high())) {
+          covered.store(false, std::memory_order_relaxed);
+          return;
+        }
+        point_cells_[point] = grid_.flat_cell_index(p);
+      });
+    }
+
+    // Otherwise, compute bounding box with slack and rebuild the grid.
+    if (!covered) {
+      const auto slack = static_cast<vec_num_t<Vec>>(ExtentSlack_) * size_hint;
+      const auto box = compute_bbox(points_).grow(size_hint / 2 + slack);
+      grid_ = Grid{box}.set_cell_extents(size_hint);
+      size_hint_ = size_hint;
+      stencil_ = grid_.stencil_offsets();
+      stencil_radius_ = min_value(grid_.cell_extents());
+      stencil_box_ = grid_.box();
+      stencil_box_.shrink(grid_.cell_extents());
+      par::for_each(iota_perm(points_), [this](size_t point) {
+        point_cells_[point] = grid_.flat_cell_index(points_[point]);
+      });
+    }
+
+    // Pack the points into a multivector. The key sort needs no atomic
+    // counters, keeps the points ordered by their index within each cell, so
+    // that the index layout does not depend on the thread scheduling, and
+    // consists of the data-parallel passes only.
+    sorted_cells_.resize(point_cells_.size());
+    sorted_points_.resize(point_cells_.size());
+    par::for_each(iota_perm(points_), [this](size_t point) {
+      sorted_cells_[point] = point_cells_[point];
+      sorted_points_[point] = point;
+    });
+    par::radix_sort(sorted_cells_, sorted_points_);
+    const auto was_sparse = sparse_;
+    sparse_ = grid_.flat_num_cells() >
+              SparseRatio_ * std::max(std::size(points_), size_t{1});
+    if (sparse_) {
+      // Compact the occupied cells, and replace the sorted cell keys with the
+      // indices of the occupied cells, that remain sorted. Buckets of the
+      // dense grid are released.
+      occupied_cells_.clear();
+      std::ranges::unique_copy(sorted_cells_,
+                               std::back_inserter(occupied_cells_));
+      par::for_each(sorted_cells_, [this](size_t& cell) {
+        cell = static_cast<size_t>(
+            std::ranges::lower_bound(occupied_cells_, cell) -
+            occupied_cells_.begin());
+      });
+      if (!was_sparse) cell_points_ = {};
+      cell_points_.assign_sorted_pairs_par(occupied_cells_.size(),
+                                           sorted_cells_,
+                                           sorted_points_);
+    } else {
+      occupied_cells_ = {};
+      cell_points_.assign_sorted_pairs_par(grid_.flat_num_cells(),
+                                           sorted_cells_,
+                                           sorted_points_);
+    }
+
+    // Gather the point coordinates in the cell order, so that the cell scans
+    // stream through the contiguous memory. Arrays are padded, so that the
+    // last cell could be loaded in full batches.
+    const auto num_points = sorted_points_.size();
+    for (auto& coords : coords_) coords.resize(num_points + CellBatch_);
+    par::for_each(std::views::iota(size_t{0}, num_points), [this](size_t slot) {
+      const auto& point = points_[sorted_points_[slot]];
+      for (size_t i = 0; i < Dim_; ++i) coords_[i][slot] = point[i];
+    });
+  }
+
+  // Call the function for each flat index of the cells, that may contain the
+  // points within the radius to the given point, in the increasing order.
+  template<class Func>
+  void for_each_cell_near_(const Vec& search_point,
+                           Num_ search_radius,
+                           Func func) const {
+    // If the radius does not exceed the cell extents, the whole cell stencil
+    // is visited, with no bounds arithmetic.
+    if (search_radius <= stencil_radius_ &&
+        stencil_box_.contains(search_point)) {
+      const auto cell_index = grid_.cell_index(search_point);
+      if (grid_.is_interior(cell_index)) {
+        const auto flat_cell_index = grid_.flatten_cell_index(cell_index);
+        for (const auto offset : stencil_) {
+          func(flat_cell_index + static_cast<size_t>(offset));
+        }
+        return;
+      }
+    }
+
+    // Otherwise, visit the cells intersecting the search box.
+    const auto search_box = BBox{search_point}.grow(search_radius);
+    for (const auto& cell_index : grid_.cells_intersecting(search_box)) {
+      func(grid_.flatten_cell_index(cell_index));
+    }
+  }
+
+  // Range of the cell order slots that hold the cell points.
+  auto cell_slots_(size_t flat_cell_index) const noexcept
+      -> std::pair<size_t, size_t> {
+    auto bucket = flat_cell_index;
+    if (sparse_) {
+      const auto iter =
+          std::ranges::lower_bound(occupied_cells_, flat_cell_index);
+      if (iter == occupied_cells_.end() || *iter != flat_cell_index) {
+        return {0, 0};
+      }
+      bucket = static_cast<size_t>(iter - occupied_cells_.begin());
+    }
+    const auto cell_points = cell_points_[bucket];
+    const auto first = static_cast<size_t>(cell_points.data() -
+                                           cell_points_.values().data());
+    return {first, first + cell_points.size()};
+  }
+
+  // Point coordinates at the cell order slot.
+  auto slot_point_(size_t slot) const noexcept -> Vec {
+    Vec point{};
+    for (size_t i = 0; i < Dim_; ++i) point[i] = coords_[i][slot];
+    return point;
+  }
+
+  // Call the function for each of the cell order slots in `[first, last)`,
+  // whose points are within the squared distance to the given point.
+  template<class Func>
+  void for_each_slot_near_(size_t first,
+                           size_t last,
+                           const Vec& point,
+                           Num_ dist,
+                           Func func) const {
+    if constexpr (!simd_cells_) {
+      for (size_t slot = first; slot < last; ++slot) {
+        if (norm2(slot_point_(slot) - point) < dist) func(slot);
+      }
+    } else {
+      using Reg = simd::Reg<Num_, CellBatch_>;
+      std::array<Reg, Dim_> q;
+      for (size_t i = 0; i < Dim_; ++i) q[i] = Reg(point[i]);
+      const Reg dist_reg(dist);
+
+      // Compute the distances for a batch of slots at once, and visit the
+      // batch slots only if any of them has passed the filter.
+      std::array<simd::Mask<Num_>, CellBatch_> near{};
+      for (size_t k = first; k < last; k += CellBatch_) {
+        Reg k_dist{};
+        for (size_t i = 0; i < Dim_; ++i) {
+          const auto delta = Reg(std::span{coords_[i]}.subspan(k)) - q[i];
+          k_dist = fma(delta, delta, k_dist);
+        }
+        auto mask = k_dist < dist_reg;
+        if (last - k < CellBatch_) {
+          mask = mask && simd::first_n<Num_, CellBatch_>(last - k);
+        }
+        if (!any(mask)) continue;
+        mask.store(near);
+        for (size_t lane = 0; lane < CellBatch_; ++lane) {
+          if (near[lane]) func(k + lane);
+        }
+      }
+    }
+  }
+
   Points points_;
+  vec_num_t<Vec> size_hint_{};
   Grid<Vec> grid_;
+  std::array<ssize_t, Grid<Vec>::stencil_size> stencil_{};
+  Num_ stencil_radius_{};
+  BBox<Vec> stencil_box_;
+  std::vector<size_t> point_cells_;
+  std::vector<size_t> sorted_cells_;
+  std::vector<size_t> sorted_points_;
+  std::array<std::vector<Num_>, Dim_> coords_;
+  bool sparse_ = false;
+  std::vector<size_t> occupied_cells_;
   Multivector<size_t> cell_points_;
 
 }; // class GridIndex
@@ -122,6 +514,14 @@ public:
     return GridIndex{std::forward<Points>(points), size_hint_};
   }
 
+  /// Re-index the points for search, reusing the existing grid index.
+  template<std::ranges::viewable_range Points>
+  void update(GridIndex<std::views::all_t<Points>>& index,
+              Points&& points) const {
+    TIT_PROFILE_SECTION("GridSearch::update()");
+    index.reindex(std::views::all(std::forward<Points>(points)), size_hint_);
+  }
+
 private:
 
   real_t size_hint_;
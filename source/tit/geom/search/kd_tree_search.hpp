@@ -6,6 +6,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <concepts>
 #include <iterator>
 #include <ranges>
@@ -16,10 +17,13 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/par/memory_pool.hpp"
 #include "tit/core/par/task_group.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/type_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
@@ -27,6 +31,8 @@
 #include "tit/geom/bbox.hpp"
 #include "tit/geom/bipartition.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/search/search_batch.hpp"
+#include "tit/geom/sort/morton_curve_sort.hpp"
 
 namespace tit::geom {
 
@@ -34,6 +40,14 @@ namespace tit::geom {
 
 /// K-dimensional tree spatial search index.
 /// Inspired by nanoflann: https://github.com/jlblancoc/nanoflann
+///
+/// Tree nodes are stored in a contiguous array in the depth-first order, so
+/// that the left child of each inner node immediately follows it, and nodes
+/// refer to each other by indices. Points of each leaf are stored
+/// contiguously, coordinates are stored separately per dimension in the leaf
+/// order, so that the distances to the leaf points are computed on the SIMD
+/// registers. Index holds no pointers into itself, so it could be freely
+/// copied, moved, or written to a file.
 template<point_range Points>
   requires std::ranges::view<Points>
 class KDTreeIndex final {
@@ -47,7 +61,7 @@ public:
   /// Index the points for search using a K-dimensional tree.
   ///
   /// @param max_leaf_size Maximum amount of points in the leaf node.
-  explicit KDTreeIndex(Points points, size_t max_leaf_size = 1)
+  explicit KDTreeIndex(Points points, size_t max_leaf_size = 16)
       : points_{std::move(points)}, max_leaf_size_{max_leaf_size} {
     TIT_ASSERT(max_leaf_size_ > 0, "Maximal leaf size should be positive.");
     build_tree_();
@@ -64,26 +78,60 @@ public:
     return search_tree_(search_point, search_radius, out, pred);
   }
 
+  /// Find the points within the radii to each of the given points.
+  ///
+  /// Queries are ordered along the Morton curve and searched in that order,
+  /// so that the consecutive queries traverse the same tree nodes.
+  ///
+  /// @param queries Query points.
+  /// @param radii   Search radii, one per query point.
+  /// @param result  Found points, one bucket per query point.
+  template<std::ranges::random_access_range Queries,
+           std::ranges::random_access_range Radii,
+           class Val>
+  void search_batch(const Queries& queries,
+                    const Radii& radii,
+                    Multivector<Val>& result) const {
+    TIT_PROFILE_SECTION("KDTreeIndex::search_batch()");
+    std::vector<size_t> order(std::size(queries));
+    if (!order.empty()) morton_curve_sort(queries, order);
+    impl::search_batch_ordered(*this, queries, radii, order, result);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
-  // K-dimensional tree node structure.
-  union KDTreeNode_ {
-    std::span<const size_t> perm{};
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wpedantic"
-    struct {
-      size_t cut_axis;
-      vec_num_t<Vec> cut_left;
-      vec_num_t<Vec> cut_right;
-      KDTreeNode_* left_subtree;
-      KDTreeNode_* right_subtree;
-    };
-#pragma GCC diagnostic pop
-  }; // union KDTreeNode_
-
-  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  using Num_ = vec_num_t<Vec>;
+  static constexpr size_t Dim_ = vec_dim_v<Vec>;
+
+  // K-dimensional tree node.
+  struct KDTreeNode_ final {
+    size_t cut_axis;  // Cut axis, or `Dim_` for the leaf nodes.
+    size_t offset;    // Right subtree index, or first leaf point index.
+    size_t leaf_size; // Number of the leaf points.
+    Num_ cut_left;    // Upper bound of the left subtree along the cut axis.
+    Num_ cut_right;   // Lower bound of the right subtree along the cut axis.
+  }; // struct KDTreeNode_
+
+  // K-dimensional tree node, used while the tree is being built.
+  struct BuildNode_ final {
+    std::span<const size_t> perm;
+    size_t cut_axis = Dim_;
+    Num_ cut_left{};
+    Num_ cut_right{};
+    const BuildNode_* left_subtree = nullptr;
+    const BuildNode_* right_subtree = nullptr;
+  }; // struct BuildNode_
+
+  // Should the leaf points be searched on the SIMD registers?
+  static constexpr bool simd_leaves_ = simd::supported_type<Num_>;
+
+  // Number of the leaf points processed at once.
+  static constexpr size_t LeafBatch_ = [] {
+    if constexpr (simd_leaves_) return simd::max_reg_size_v<Num_>;
+    else return 1;
+  }();
 
   // Build the K-dimensional tree.
   void build_tree_() {
@@ -92,24 +140,40 @@ private:
     // Initialize identity points permutation.
     perm_ = iota_perm(points_) | std::ranges::to<std::vector>();
 
-    // Compute the root tree node (and bounding box).
+    // Build the tree in parallel. Nodes are allocated from the memory pool,
+    // and then flattened into the array in the depth-first order.
+    par::MemoryPool<BuildNode_> pool{};
     par::TaskGroup tasks{};
-    std::tie(root_node_, tree_box_) = build_subtree_(tasks, perm_);
+    const auto [root_node, tree_box] = build_subtree_(pool, tasks, perm_);
     tasks.wait();
+    tree_box_ = tree_box;
+    flatten_subtree_(root_node);
+
+    // Gather the point coordinates in the leaf order. Arrays are padded, so
+    // that the last leaf could be loaded in full batches.
+    if constexpr (simd_leaves_) {
+      const auto num_points = perm_.size();
+      for (auto& coords : coords_) coords.assign(num_points + LeafBatch_, {});
+      par::for_each(std::views::iota(size_t{0}, num_points), [this](size_t k) {
+        const auto& point = points_[perm_[k]];
+        for (size_t i = 0; i < Dim_; ++i) coords_[i][k] = point[i];
+      });
+    }
   }
 
   // Build the K-dimensional subtree.
-  auto build_subtree_(par::TaskGroup& tasks, std::span<size_t> perm)
-      -> std::pair<KDTreeNode_*, BBox<Vec>> {
+  auto build_subtree_(par::MemoryPool<BuildNode_>& pool,
+                      par::TaskGroup& tasks,
+                      std::span<size_t> perm)
+      -> std::pair<const BuildNode_*, BBox<Vec>> {
     // Compute bounding box.
     const auto box = compute_bbox(points_, perm);
 
     // Is leaf node reached?
-    const auto node = pool_.create();
+    const auto node = pool.create();
     if (perm.size() <= max_leaf_size_) {
       // Fill the leaf node and end partitioning.
       node->perm = perm;
-      node->left_subtree = node->right_subtree = nullptr;
       return {node, box};
     }
 
@@ -121,13 +185,15 @@ private:
 
     // Build subtrees.
     node->cut_axis = cut_axis;
-    tasks.run(is_async_(left_perm), [left_perm, node, &tasks, this] {
-      const auto [left_tree, left_box] = build_subtree_(tasks, left_perm);
+    tasks.run(is_async_(left_perm), [left_perm, node, &pool, &tasks, this] {
+      const auto [left_tree, left_box] =
+          build_subtree_(pool, tasks, left_perm);
       node->left_subtree = left_tree;
       node->cut_left = left_box.high()[node->cut_axis];
     });
-    tasks.run(is_async_(right_perm), [right_perm, node, &tasks, this] {
-      const auto [right_tree, right_box] = build_subtree_(tasks, right_perm);
+    tasks.run(is_async_(right_perm), [right_perm, node, &pool, &tasks, this] {
+      const auto [right_tree, right_box] =
+          build_subtree_(pool, tasks, right_perm);
       node->right_subtree = right_tree;
       node->cut_right = right_box.low()[node->cut_axis];
     });
@@ -135,9 +201,30 @@ private:
     return {node, box};
   }
 
-  // Should the building be done in parallel?
+  // Append the subtree nodes to the node array in the depth-first order.
+  void flatten_subtree_(const BuildNode_* node) {
+    const auto index = nodes_.size();
+    nodes_.push_back({.cut_axis = node->cut_axis,
+                      .offset = 0,
+                      .leaf_size = 0,
+                      .cut_left = node->cut_left,
+                      .cut_right = node->cut_right});
+    if (node->left_subtree == nullptr) {
+      TIT_ASSERT(node->right_subtree == nullptr, "Invalid leaf node!");
+      nodes_[index].offset =
+          static_cast<size_t>(node->perm.data() - perm_.data());
+      nodes_[index].leaf_size = node->perm.size();
+      return;
+    }
+    flatten_subtree_(node->left_subtree);
+    nodes_[index].offset = nodes_.size();
+    flatten_subtree_(node->right_subtree);
+  }
+
+  // Should the building be done in parallel? Only the top levels of the
+  // tree are split into tasks, the smaller subtrees are built inline.
   static auto is_async_(std::span<size_t> perm) noexcept -> bool {
-    constexpr size_t parallel_threshold = 50; // Empirical value.
+    constexpr size_t parallel_threshold = 4096; // Empirical value.
     return std::size(perm) >= parallel_threshold;
   }
 
@@ -158,8 +245,8 @@ private:
     auto dists = pow2(search_point - tree_box_.clamp(search_point));
 
     // Recursively search the tree.
-    TIT_ASSERT(root_node_ != nullptr, "Tree was not built!");
-    return search_subtree_(root_node_,
+    TIT_ASSERT(!nodes_.empty(), "Tree was not built!");
+    return search_subtree_(/*node_index=*/0,
                            dists,
                            search_point,
                            search_dist,
@@ -171,40 +258,37 @@ private:
   // Parameters are passed by references in order to minimize stack usage.
   template<std::output_iterator<size_t> OutIter,
            std::predicate<size_t> Pred = AlwaysTrue>
-  auto search_subtree_(const KDTreeNode_* node,
+  auto search_subtree_(size_t node_index,
                        Vec& dists,
                        const Vec& search_point,
                        vec_num_t<Vec> search_dist,
                        OutIter out,
                        Pred pred) const -> OutIter {
-    if (node->left_subtree == nullptr) {
-      TIT_ASSERT(node->right_subtree == nullptr, "Invalid leaf node!");
+    const auto& node = nodes_[node_index];
+    if (node.cut_axis == Dim_) {
       // Collect points within the leaf node.
-      out = copy_points_near(points_,
-                             node->perm,
-                             out,
-                             search_point,
-                             search_dist,
-                             pred);
-      return out;
+      return search_leaf_(node.offset,
+                          node.offset + node.leaf_size,
+                          search_point,
+                          search_dist,
+                          out,
+                          pred);
     }
 
     // Determine which branch should be taken first.
-    const auto cut_axis = node->cut_axis;
+    const auto cut_axis = node.cut_axis;
+    const auto left_node = node_index + 1;
+    const auto right_node = node.offset;
     const auto [cut_dist, first_node, second_node] = [&] {
-      const auto delta_left = search_point[cut_axis] - node->cut_left;
-      const auto delta_right = node->cut_right - search_point[cut_axis];
+      const auto delta_left = search_point[cut_axis] - node.cut_left;
+      const auto delta_right = node.cut_right - search_point[cut_axis];
       return delta_left < delta_right ?
                  // Point is on the left to the cut plane, so the
                  // corresponding subtree should be searched first.
-                 std::tuple{pow2(delta_right),
-                            node->left_subtree,
-                            node->right_subtree} :
+                 std::tuple{pow2(delta_right), left_node, right_node} :
                  // Point is on the right to the cut plane, so the
                  // corresponding subtree should be searched first.
-                 std::tuple{pow2(delta_left),
-                            node->right_subtree,
-                            node->left_subtree};
+                 std::tuple{pow2(delta_left), right_node, left_node};
     }();
 
     // Search in the first subtree.
@@ -230,14 +314,56 @@ private:
     return out;
   }
 
+  // Search for the point neighbors in the leaf node, that holds the points
+  // in the given range of the leaf order.
+  template<std::output_iterator<size_t> OutIter, std::predicate<size_t> Pred>
+  auto search_leaf_(size_t first,
+                    size_t last,
+                    const Vec& search_point,
+                    Num_ search_dist,
+                    OutIter out,
+                    Pred pred) const -> OutIter {
+    if constexpr (!simd_leaves_) {
+      return copy_points_near(points_,
+                              std::span{perm_}.subspan(first, last - first),
+                              out,
+                              search_point,
+                              search_dist,
+                              pred);
+    } else {
+      using Reg = simd::Reg<Num_, LeafBatch_>;
+      std::array<Reg, Dim_> q;
+      for (size_t i = 0; i < Dim_; ++i) q[i] = Reg(search_point[i]);
+
+      // Compute the distances for a batch of points at once, and then filter
+      // the batch points by the distance and the predicate.
+      std::array<Num_, LeafBatch_> dists{};
+      for (size_t k = first; k < last; k += LeafBatch_) {
+        Reg dist{};
+        for (size_t i = 0; i < Dim_; ++i) {
+          const auto delta = Reg(std::span{coords_[i]}.subspan(k)) - q[i];
+          dist = fma(delta, delta, dist);
+        }
+        dist.store(dists);
+        const auto batch_size = std::min(LeafBatch_, last - k);
+        for (size_t lane = 0; lane < batch_size; ++lane) {
+          if (dists[lane] >= search_dist) continue;
+          const auto index = perm_[k + lane];
+          if (pred(index)) *out++ = index;
+        }
+      }
+      return out;
+    }
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   Points points_;
   size_t max_leaf_size_;
-  par::MemoryPool<KDTreeNode_> pool_;
-  const KDTreeNode_* root_node_ = nullptr;
+  std::vector<KDTreeNode_> nodes_;
   BBox<Vec> tree_box_;
   std::vector<size_t> perm_;
+  std::array<std::vector<Num_>, Dim_> coords_;
 
 }; // class KDTreeIndex
 
@@ -254,7 +380,7 @@ public:
   /// Construct a K-dimensional tree search indexing function.
   ///
   /// @param max_leaf_size Maximum amount of points in the leaf node.
-  constexpr explicit KDTreeSearch(size_t max_leaf_size = 1)
+  constexpr explicit KDTreeSearch(size_t max_leaf_size = 16)
       : max_leaf_size_{max_leaf_size} {
     TIT_ASSERT(max_leaf_size_ > 0, "Maximal leaf size should be positive!");
   }
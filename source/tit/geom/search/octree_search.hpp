@@ -0,0 +1,349 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/type_utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/point_range.hpp"
+#include "tit/geom/sort/morton_curve_sort.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Adaptive linear octree (quadtree in 2D) spatial search index.
+///
+/// Points are ordered along the Morton curve, so that each tree node covers
+/// a contiguous range of the ordered points. Nodes are split until they
+/// contain no more than the given amount of points, hence the tree adapts to
+/// the point density, unlike the uniform grid.
+///
+/// If the point radii are provided, the maximum radius is stored per node,
+/// and the symmetric search is available: the points are found if they are
+/// within either the search radius or their own radius.
+template<point_range Points>
+  requires std::ranges::view<Points>
+class OctreeIndex final {
+public:
+
+  /// Point type.
+  using Vec = std::ranges::range_value_t<Points>;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Index the points for search using an octree.
+  ///
+  /// @param max_leaf_size Maximum amount of points in the leaf node.
+  OctreeIndex(Points points, size_t max_leaf_size)
+      : OctreeIndex{std::move(points), {}, max_leaf_size} {}
+
+  /// Index the points for the symmetric search using an octree.
+  ///
+  /// @param radii         Point radii, either empty or one per point.
+  /// @param max_leaf_size Maximum amount of points in the leaf node.
+  OctreeIndex(Points points,
+              std::vector<vec_num_t<Vec>> radii,
+              size_t max_leaf_size)
+      : points_{std::move(points)}, radii_{std::move(radii)},
+        max_leaf_size_{max_leaf_size} {
+    TIT_ASSERT(max_leaf_size_ > 0, "Maximal leaf size should be positive.");
+    TIT_ASSERT(radii_.empty() || radii_.size() == std::size(points_),
+               "Number of radii must match the number of points!");
+    build_tree_();
+  }
+
+  /// Check if the point radii were provided.
+  auto has_radii() const noexcept -> bool {
+    return !radii_.empty();
+  }
+
+  /// Find the points within the radius to the given point.
+  template<std::output_iterator<size_t> OutIter,
+           std::predicate<size_t> Pred = AlwaysTrue>
+  auto search(const Vec& search_point,
+              vec_num_t<Vec> search_radius,
+              OutIter out,
+              Pred pred = {}) const -> OutIter {
+    TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+    for_each_near_(search_point,
+                   search_radius,
+                   /*symmetric=*/false,
+                   [&out, &pred](size_t point) {
+                     if (pred(point)) *out++ = point;
+                   });
+    return out;
+  }
+
+  /// Find the points within the radius to the given point, or having the
+  /// given point within their own radius.
+  template<std::output_iterator<size_t> OutIter,
+           std::predicate<size_t> Pred = AlwaysTrue>
+  auto search_symmetric(const Vec& search_point,
+                        vec_num_t<Vec> search_radius,
+                        OutIter out,
+                        Pred pred = {}) const -> OutIter {
+    TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+    TIT_ASSERT(has_radii(), "Point radii were not provided!");
+    for_each_near_(search_point,
+                   search_radius,
+                   /*symmetric=*/true,
+                   [&out, &pred](size_t point) {
+                     if (pred(point)) *out++ = point;
+                   });
+    return out;
+  }
+
+  /// Call the function for each of the points within the radius to the given
+  /// point. Unlike `search`, the points are not collected anywhere.
+  template<std::invocable<size_t> Func>
+  void for_each_near(const Vec& search_point,
+                     vec_num_t<Vec> search_radius,
+                     Func func) const {
+    TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+    for_each_near_(search_point, search_radius, /*symmetric=*/false, func);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  using Num_ = vec_num_t<Vec>;
+  static constexpr size_t Dim_ = vec_dim_v<Vec>;
+
+  // Maximum tree depth. Nodes at this depth are leaves regardless of their
+  // size, so that the coincident points do not cause infinite splitting.
+  static constexpr size_t MaxDepth_ = 32;
+
+  // Octree node structure. Children of a node are stored contiguously.
+  struct Node_ final {
+    BBox<Vec> box;        // Bounding box of the node points.
+    Num_ max_radius{};    // Maximum radius of the node points.
+    size_t first = 0;     // Index of the first node point in the order.
+    size_t last = 0;      // Index past the last node point in the order.
+    size_t children = 0;  // Index of the first child node.
+    size_t num_children = 0;
+  }; // struct Node_
+
+  // Part of the cell that is being split.
+  struct Part_ final {
+    BBox<Vec> cell;
+    size_t first = 0;
+    size_t last = 0;
+  }; // struct Part_
+
+  // Maximum number of the node children.
+  static constexpr size_t NumChildren_ = size_t{1} << Dim_;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  // Build the octree.
+  void build_tree_() {
+    if (std::ranges::empty(points_)) return;
+
+    // Order the points along the Morton curve.
+    perm_.resize(std::size(points_));
+    morton_curve_sort(points_, perm_);
+
+    // Recursively split the cells, starting from the root.
+    nodes_.push_back({.first = 0, .last = perm_.size()});
+    build_subtree_(0, compute_bbox(points_), 0);
+  }
+
+  // Build the octree subtree for the node with the given cell box.
+  void build_subtree_(size_t node_index, const BBox<Vec>& cell, size_t depth) {
+    const auto first = nodes_[node_index].first;
+    const auto last = nodes_[node_index].last;
+
+    // Is leaf node reached?
+    if (last - first <= max_leaf_size_ || depth == MaxDepth_) {
+      auto& node = nodes_[node_index];
+      node.box = compute_bbox(points_, range_perm_(first, last));
+      if (has_radii()) {
+        for (size_t k = first; k < last; ++k) {
+          node.max_radius = std::max(node.max_radius, radii_[perm_[k]]);
+        }
+      }
+      return;
+    }
+
+    // Split the cell into the children cells the same way the Morton curve
+    // sort did: axes are bisected in turns, starting from Y, so the points of
+    // each child cell are already contiguous. Empty cells are dropped.
+    std::array<Part_, NumChildren_> parts{};
+    parts[0] = {.cell = cell, .first = first, .last = last};
+    size_t num_parts = 1;
+    for (size_t i = 0; i < Dim_; ++i) {
+      const auto axis = (i + 1) % Dim_;
+      std::array<Part_, NumChildren_> halves{};
+      size_t num_halves = 0;
+      for (const auto& part : std::span{parts}.first(num_parts)) {
+        const auto center_coord = part.cell.center()[axis];
+        const auto [left_cell, right_cell] =
+            part.cell.split(axis, center_coord);
+        const auto part_perm = range_perm_(part.first, part.last);
+        const auto middle =
+            part.first +
+            static_cast<size_t>(std::ranges::distance(
+                part_perm.begin(),
+                std::ranges::partition_point(
+                    part_perm,
+                    [center_coord, axis, this](size_t point) {
+                      return points_[point][axis] < center_coord;
+                    })));
+        if (middle > part.first) {
+          halves[num_halves++] = {left_cell, part.first, middle};
+        }
+        if (part.last > middle) {
+          halves[num_halves++] = {right_cell, middle, part.last};
+        }
+      }
+      parts = halves;
+      num_parts = num_halves;
+    }
+
+    // Create the children nodes and build the subtrees.
+    const auto children = nodes_.size();
+    nodes_[node_index].children = children;
+    nodes_[node_index].num_children = num_parts;
+    for (const auto& part : std::span{parts}.first(num_parts)) {
+      nodes_.push_back({.first = part.first, .last = part.last});
+    }
+    for (size_t i = 0; i < num_parts; ++i) {
+      build_subtree_(children + i, parts[i].cell, depth + 1);
+    }
+
+    // Merge the children bounding boxes and radii.
+    auto& node = nodes_[node_index];
+    node.box = nodes_[children].box;
+    for (size_t i = 0; i < num_parts; ++i) {
+      const auto& child = nodes_[children + i];
+      node.box.expand(child.box.low()).expand(child.box.high());
+      node.max_radius = std::max(node.max_radius, child.max_radius);
+    }
+  }
+
+  // Permutation of the points in the given range of the order.
+  auto range_perm_(size_t first, size_t last) const noexcept
+      -> std::span<const size_t> {
+    return std::span{perm_}.subspan(first, last - first);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  // Call the function for each of the points near the given point.
+  template<std::invocable<size_t> Func>
+  void for_each_near_(const Vec& search_point,
+                      Num_ search_radius,
+                      bool symmetric,
+                      Func func) const {
+    if (nodes_.empty()) return;
+
+    // Traverse the tree using the explicit stack.
+    std::vector<size_t> stack{0};
+    while (!stack.empty()) {
+      const auto& node = nodes_[stack.back()];
+      stack.pop_back();
+
+      // Skip node if it is too far.
+      const auto node_radius =
+          symmetric ? std::max(search_radius, node.max_radius) : search_radius;
+      const auto node_dist = norm2(search_point - node.box.clamp(search_point));
+      if (node_dist >= pow2(node_radius)) continue;
+
+      // Visit the children nodes, or the leaf node points.
+      if (node.num_children != 0) {
+        for (size_t i = 0; i < node.num_children; ++i) {
+          stack.push_back(node.children + i);
+        }
+        continue;
+      }
+      for (size_t k = node.first; k < node.last; ++k) {
+        const auto point = perm_[k];
+        const auto point_radius =
+            symmetric ? std::max(search_radius, radii_[point]) : search_radius;
+        if (norm2(points_[point] - search_point) < pow2(point_radius)) {
+          func(point);
+        }
+      }
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  Points points_;
+  std::vector<Num_> radii_;
+  size_t max_leaf_size_;
+  std::vector<size_t> perm_;
+  std::vector<Node_> nodes_;
+
+}; // class OctreeIndex
+
+// Wrap a viewable range into a view on construction.
+template<std::ranges::viewable_range Points, class... Args>
+OctreeIndex(Points&&, Args...) -> OctreeIndex<std::views::all_t<Points>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Adaptive octree based spatial search indexing function.
+class OctreeSearch final {
+public:
+
+  /// Construct an octree search indexing function.
+  ///
+  /// @param max_leaf_size Maximum amount of points in the leaf node.
+  constexpr explicit OctreeSearch(size_t max_leaf_size = 16)
+      : max_leaf_size_{max_leaf_size} {
+    TIT_ASSERT(max_leaf_size_ > 0, "Maximal leaf size should be positive!");
+  }
+
+  /// Index the points for search using an octree.
+  template<std::ranges::viewable_range Points>
+    requires deduce_constructible_from<OctreeIndex, Points&&, size_t>
+  [[nodiscard]] auto operator()(Points&& points) const {
+    TIT_PROFILE_SECTION("OctreeSearch::operator()");
+    return OctreeIndex{std::forward<Points>(points), max_leaf_size_};
+  }
+
+  /// Index the points for the symmetric search using an octree.
+  template<std::ranges::viewable_range Points, std::ranges::input_range Radii>
+    requires deduce_constructible_from<OctreeIndex, Points&&, size_t>
+  [[nodiscard]] auto operator()(Points&& points, Radii&& radii) const {
+    TIT_PROFILE_SECTION("OctreeSearch::operator()");
+    using Num = point_range_num_t<Points>;
+    return OctreeIndex{std::forward<Points>(points),
+                       std::forward<Radii>(radii) |
+                           std::ranges::to<std::vector<Num>>(),
+                       max_leaf_size_};
+  }
+
+private:
+
+  size_t max_leaf_size_;
+
+}; // class OctreeSearch
+
+/// Adaptive octree based spatial search indexing.
+inline constexpr OctreeSearch octree_indexing{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
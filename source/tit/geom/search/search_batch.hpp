@@ -0,0 +1,63 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+
+namespace tit::geom::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Search for the neighbors of each query point, processing the queries in the
+// given order, and store the results in the query order. Each thread takes a
+// contiguous block of the ordered queries, so the nearby queries are searched
+// one after another and the index data they touch stays in cache.
+template<class Index,
+         std::ranges::random_access_range Queries,
+         std::ranges::random_access_range Radii,
+         class Val>
+void search_batch_ordered(const Index& index,
+                          const Queries& queries,
+                          const Radii& radii,
+                          std::span<const size_t> order,
+                          Multivector<Val>& result) {
+  TIT_ASSERT(std::size(radii) == std::size(queries),
+             "Number of radii must match the number of queries!");
+  TIT_ASSERT(order.size() == std::size(queries),
+             "Order size must match the number of queries!");
+
+  // Search in the given order.
+  Multivector<Val> ordered_result;
+  ordered_result.assign_buckets_par(
+      order.size(),
+      [&index, &queries, &radii, order](size_t k, auto out) {
+        const auto query = order[k];
+        index.search(queries[query], radii[query], out);
+      });
+
+  // Restore the query order.
+  std::vector<size_t> inverse_order(order.size());
+  par::for_each(std::views::iota(size_t{0}, order.size()),
+                [order, &inverse_order](size_t k) {
+                  inverse_order[order[k]] = k;
+                });
+  result.assign_buckets_par(
+      std::views::iota(size_t{0}, order.size()) |
+      std::views::transform([&ordered_result, &inverse_order](size_t query) {
+        return ordered_result[inverse_order[query]];
+      }));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom::impl
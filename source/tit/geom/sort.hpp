@@ -8,7 +8,9 @@
 #include <concepts>
 
 // IWYU pragma: begin_exports
+#include "tit/geom/sort/curve_key_sort.hpp"
 #include "tit/geom/sort/hilbert_curve_sort.hpp"
+#include "tit/geom/sort/lod_sort.hpp"
 #include "tit/geom/sort/morton_curve_sort.hpp"
 // IWYU pragma: end_exports
 
@@ -19,7 +21,9 @@ namespace tit::geom {
 /// Spatial sort function type.
 template<class SF>
 concept sort_func = std::same_as<SF, HilbertCurveSort> || //
-                    std::same_as<SF, MortonCurveSort>;
+                    std::same_as<SF, HilbertKeySort> ||   //
+                    std::same_as<SF, MortonCurveSort> ||  //
+                    std::same_as<SF, MortonKeySort>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
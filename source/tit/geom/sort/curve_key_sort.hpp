@@ -0,0 +1,239 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/point_range.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Quantized point coordinates.
+template<size_t Dim>
+using CurveCoords = std::array<uint64_t, Dim>;
+
+// Number of bits per coordinate in the 64-bit space filling curve key.
+template<size_t Dim>
+inline constexpr size_t curve_key_bits = std::min<size_t>(64 / Dim, 32);
+
+// Point quantizer onto the uniform grid of the space filling curve.
+template<class Vec>
+class CurveQuantizer final {
+public:
+
+  // Point dimension.
+  static constexpr auto Dim = vec_dim_v<Vec>;
+
+  // Construct a quantizer for the points inside of the bounding box.
+  explicit CurveQuantizer(const BBox<Vec>& box) {
+    constexpr auto num_cells = static_cast<float64_t>(uint64_t{1}
+                                                      << curve_key_bits<Dim>);
+    const auto extents = box.extents();
+    for (size_t i = 0; i < Dim; ++i) {
+      low_[i] = static_cast<float64_t>(box.low()[i]);
+      const auto extent = static_cast<float64_t>(extents[i]);
+      scale_[i] = extent > 0.0 ? num_cells / extent : 0.0;
+    }
+  }
+
+  // Quantize the point coordinates. Coordinate at the center of the cell
+  // goes to the upper half, same as in the coordinate bisection.
+  auto operator()(const Vec& point) const noexcept -> CurveCoords<Dim> {
+    constexpr auto max_coord = static_cast<float64_t>(
+        (uint64_t{1} << curve_key_bits<Dim>) - 1);
+    CurveCoords<Dim> coords{};
+    for (size_t i = 0; i < Dim; ++i) {
+      const auto coord =
+          (static_cast<float64_t>(point[i]) - low_[i]) * scale_[i];
+      coords[i] = static_cast<uint64_t>(std::clamp(coord, 0.0, max_coord));
+    }
+    return coords;
+  }
+
+private:
+
+  std::array<float64_t, Dim> low_{};
+  std::array<float64_t, Dim> scale_{};
+
+}; // class CurveQuantizer
+
+// Spread the bits of the quantized coordinate, so that there are `Dim - 1`
+// zero bits between each of them. Branchless, so that the key computation
+// loop is vectorized by the compiler.
+template<size_t Dim>
+constexpr auto spread_bits(uint64_t coord) noexcept -> uint64_t {
+  if constexpr (Dim == 1) {
+    return coord;
+  } else if constexpr (Dim == 2) {
+    coord &= 0x0000'0000'FFFF'FFFF;
+    coord = (coord | (coord << 16)) & 0x0000'FFFF'0000'FFFF;
+    coord = (coord | (coord << 8)) & 0x00FF'00FF'00FF'00FF;
+    coord = (coord | (coord << 4)) & 0x0F0F'0F0F'0F0F'0F0F;
+    coord = (coord | (coord << 2)) & 0x3333'3333'3333'3333;
+    coord = (coord | (coord << 1)) & 0x5555'5555'5555'5555;
+    return coord;
+  } else if constexpr (Dim == 3) {
+    coord &= 0x0000'0000'001F'FFFF;
+    coord = (coord | (coord << 32)) & 0x001F'0000'0000'FFFF;
+    coord = (coord | (coord << 16)) & 0x001F'0000'FF00'00FF;
+    coord = (coord | (coord << 8)) & 0x100F'00F0'0F00'F00F;
+    coord = (coord | (coord << 4)) & 0x10C3'0C30'C30C'30C3;
+    coord = (coord | (coord << 2)) & 0x1249'2492'4924'9249;
+    return coord;
+  } else static_assert(false);
+}
+
+// Interleave the bits of the coordinates, bits of the first coordinate are
+// the most significant ones on each level.
+template<size_t Dim>
+constexpr auto interleave_bits(const CurveCoords<Dim>& coords) noexcept
+    -> uint64_t {
+  uint64_t key = 0;
+  for (size_t i = 0; i < Dim; ++i) {
+    key |= spread_bits<Dim>(coords[i]) << (Dim - i - 1);
+  }
+  return key;
+}
+
+// Compute the Morton curve key of the quantized point.
+template<size_t Dim>
+constexpr auto morton_key(const CurveCoords<Dim>& coords) noexcept
+    -> uint64_t {
+  // Axes are started from Y to match the classic Morton curve definition.
+  CurveCoords<Dim> rotated{};
+  for (size_t i = 0; i < Dim; ++i) rotated[i] = coords[(i + 1) % Dim];
+  return interleave_bits<Dim>(rotated);
+}
+
+// Compute the Hilbert curve key of the quantized point.
+//
+// Coordinates are converted into the "transposed" Hilbert index, as described
+// in J. Skilling, "Programming the Hilbert curve" (2004), which is then
+// interleaved into the key.
+template<size_t Dim>
+constexpr auto hilbert_key(CurveCoords<Dim> coords) noexcept -> uint64_t {
+  constexpr auto top_bit = uint64_t{1} << (curve_key_bits<Dim> - 1);
+
+  // Inverse undo excess work.
+  for (auto q = top_bit; q > 1; q >>= 1) {
+    const auto p = q - 1;
+    for (size_t i = 0; i < Dim; ++i) {
+      if ((coords[i] & q) != 0) {
+        coords[0] ^= p;
+      } else {
+        const auto t = (coords[0] ^ coords[i]) & p;
+        coords[0] ^= t, coords[i] ^= t;
+      }
+    }
+  }
+
+  // Gray encode.
+  for (size_t i = 1; i < Dim; ++i) coords[i] ^= coords[i - 1];
+  uint64_t t = 0;
+  for (auto q = top_bit; q > 1; q >>= 1) {
+    if ((coords[Dim - 1] & q) != 0) t ^= q - 1;
+  }
+  for (auto& coord : coords) coord ^= t;
+
+  return interleave_bits<Dim>(coords);
+}
+
+// Order the points by the space filling curve keys.
+template<point_range Points, output_index_range Perm, class KeyFunc>
+void curve_key_sort(Points&& points, Perm&& perm, const KeyFunc& key_func) {
+  TIT_ASSUME_UNIVERSAL(Points, points);
+  TIT_ASSUME_UNIVERSAL(Perm, perm);
+  if (std::ranges::empty(points)) return;
+
+  // Compute the keys in parallel.
+  const CurveQuantizer quantize{compute_bbox(points)};
+  std::vector<uint64_t> keys(std::size(points));
+  par::transform(points, keys.begin(), [&quantize, &key_func](const auto& p) {
+    return key_func(quantize(p));
+  });
+
+  // Sort the keys.
+  if constexpr (par::range<Perm>) {
+    iota_perm(points, perm);
+    par::radix_sort(keys, perm);
+  } else {
+    auto indices = iota_perm(points) | std::ranges::to<std::vector>();
+    par::radix_sort(keys, indices);
+    std::ranges::copy(indices, std::begin(perm));
+  }
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Morton space filling curve spatial sort function, based on the radix
+/// sort of the 64-bit curve keys.
+///
+/// Produces the same order as `MortonCurveSort` up to the key resolution,
+/// but with a few passes over the data instead of a recursive bisection.
+class MortonKeySort final {
+public:
+
+  /// Order the points along the Morton space filling curve.
+  template<point_range Points, output_index_range Perm>
+  void operator()(Points&& points, Perm&& perm) const {
+    TIT_PROFILE_SECTION("MortonKeySort::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    impl::curve_key_sort(points, perm, [](const auto& coords) {
+      return impl::morton_key(coords);
+    });
+  }
+
+}; // class MortonKeySort
+
+/// Morton space filling curve spatial sort, based on the radix sort.
+inline constexpr MortonKeySort morton_key_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Hilbert space filling curve spatial sort function, based on the radix
+/// sort of the 64-bit curve keys.
+///
+/// Orientation of the curve may differ from the one of `HilbertCurveSort`.
+class HilbertKeySort final {
+public:
+
+  /// Order the points along the Hilbert space filling curve.
+  template<point_range Points, output_index_range Perm>
+  void operator()(Points&& points, Perm&& perm) const {
+    TIT_PROFILE_SECTION("HilbertKeySort::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    impl::curve_key_sort(points, perm, [](const auto& coords) {
+      return impl::hilbert_key(coords);
+    });
+  }
+
+}; // class HilbertKeySort
+
+/// Hilbert space filling curve spatial sort, based on the radix sort.
+inline constexpr HilbertKeySort hilbert_key_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
@@ -0,0 +1,93 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/sort/curve_key_sort.hpp"
+#include "tit/geom/sort/morton_curve_sort.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+using Vec2D = Vec<double, 2>;
+using Vec3D = Vec<double, 3>;
+
+// Check that the consecutive lattice points are the lattice neighbors.
+template<class Vec>
+auto is_continuous(const std::vector<Vec>& points,
+                   const std::vector<size_t>& perm) -> bool {
+  for (const auto [a, b] : std::views::pairwise(perm)) {
+    if (norm2(points[a] - points[b]) != 1.0) return false;
+  }
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::MortonKeySort") {
+  SUBCASE("2D") {
+    // Create points on a 8x8 lattice.
+    std::vector<Vec2D> points(64);
+    for (size_t i = 0; i < 64; ++i) points[i] = {i % 8, i / 8};
+
+    // Ensure the permutation is the same as the one of the recursive sort.
+    std::vector<size_t> perm(points.size());
+    std::vector<size_t> expected_perm(points.size());
+    geom::morton_key_sort(points, perm);
+    geom::morton_curve_sort(points, expected_perm);
+    CHECK_RANGE_EQ(perm, expected_perm);
+  }
+  SUBCASE("3D") {
+    // Create points on a 4x4x4 lattice.
+    std::vector<Vec3D> points(64);
+    for (size_t i = 0; i < 64; ++i) points[i] = {i % 4, i / 4 % 4, i / 16};
+
+    // Ensure the permutation is the same as the one of the recursive sort.
+    std::vector<size_t> perm(points.size());
+    std::vector<size_t> expected_perm(points.size());
+    geom::morton_key_sort(points, perm);
+    geom::morton_curve_sort(points, expected_perm);
+    CHECK_RANGE_EQ(perm, expected_perm);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::HilbertKeySort") {
+  SUBCASE("2D") {
+    // Create points on a 16x16 lattice.
+    std::vector<Vec2D> points(256);
+    for (size_t i = 0; i < 256; ++i) points[i] = {i % 16, i / 16};
+
+    // Ensure the Hilbert curve visits the lattice points one by one.
+    std::vector<size_t> perm(points.size());
+    geom::hilbert_key_sort(points, perm);
+    CHECK(perm.front() == 0);
+    CHECK(is_continuous(points, perm));
+  }
+  SUBCASE("3D") {
+    // Create points on a 8x8x8 lattice.
+    std::vector<Vec3D> points(512);
+    for (size_t i = 0; i < 512; ++i) points[i] = {i % 8, i / 8 % 8, i / 64};
+
+    // Ensure the Hilbert curve visits the lattice points one by one.
+    std::vector<size_t> perm(points.size());
+    geom::hilbert_key_sort(points, perm);
+    CHECK(perm.front() == 0);
+    CHECK(is_continuous(points, perm));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,76 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <bit>
+#include <iterator>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/geom/point_range.hpp"
+#include "tit/geom/sort/morton_curve_sort.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Level-of-detail sort function.
+///
+/// Orders the points so that every prefix of the permutation is a spatially
+/// uniform sample of the points. Points are first ordered along the Morton
+/// curve, and then visited in the bit-reversed order of their curve ranks:
+/// every prefix of `2^k` points takes evenly spaced points along the curve,
+/// and the next `2^k` points refine it. Hence, a coarse level of detail is
+/// sent first, and then progressively refined by the consecutive ranges.
+///
+/// @note This order destroys the spatial locality of the points, so it is
+///       meant for visualization, and not for the neighbor search.
+class LODSort final {
+public:
+
+  /// Order the points from the coarsest level of detail to the finest.
+  template<point_range Points, output_index_range Perm>
+  void operator()(Points&& points, Perm&& perm) const {
+    TIT_PROFILE_SECTION("LODSort::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+
+    // Order the points along the curve.
+    const auto num_points = std::size(points);
+    if (num_points == 0) return;
+    std::vector<size_t> curve_perm(num_points);
+    morton_curve_sort(points, curve_perm);
+
+    // Visit the curve ranks in the bit-reversed order. Ranks beyond the
+    // number of points are skipped, so at most twice as many ranks are
+    // visited. Reversed counter is incremented in amortized constant time.
+    auto out = std::begin(perm);
+    *out++ = curve_perm.front();
+    if (num_points == 1) return;
+    const auto high_bit = std::bit_floor(num_points - 1);
+    for (size_t rank = 0, count = 1; count < 2 * high_bit; ++count) {
+      auto bit = high_bit;
+      while ((rank & bit) != 0) {
+        rank ^= bit;
+        bit >>= 1;
+      }
+      rank |= bit;
+      if (rank < num_points) *out++ = curve_perm[rank];
+    }
+  }
+
+}; // class LODSort
+
+/// Level-of-detail sort.
+inline constexpr LODSort lod_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
@@ -0,0 +1,64 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/sort/lod_sort.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+using Vec2D = Vec<double, 2>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::LODSort") {
+  SUBCASE("lattice") {
+    // Create points on a 8x8 lattice.
+    std::array<Vec2D, 64> points{};
+    for (size_t i = 0; i < 64; ++i) points[i] = {i % 8, i / 8};
+
+    // Sort points by the level of detail.
+    std::array<size_t, 64> perm{};
+    geom::lod_sort(points, perm);
+
+    // Ensure the first level takes a single point from each quadrant, and
+    // the second one refines each quadrant.
+    CHECK_RANGE_EQ(perm | std::views::take(4),
+                   std::to_array<size_t>({0, 32, 4, 36}));
+    CHECK_RANGE_EQ(perm | std::views::drop(4) | std::views::take(4),
+                   std::to_array<size_t>({16, 48, 20, 52}));
+
+    // Ensure the permutation is complete.
+    std::ranges::sort(perm);
+    CHECK_RANGE_EQ(perm, std::views::iota(0UZ, 64UZ));
+  }
+  SUBCASE("non power of two") {
+    // Create scattered points.
+    std::vector<Vec2D> points(37);
+    for (size_t i = 0; i < points.size(); ++i) points[i] = {i, (5 * i) % 11};
+
+    // Sort points by the level of detail.
+    std::vector<size_t> perm(points.size());
+    geom::lod_sort(points, perm);
+
+    // Ensure the permutation is complete.
+    std::ranges::sort(perm);
+    CHECK_RANGE_EQ(perm, std::views::iota(0UZ, points.size()));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,267 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/atomic.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/graph/graph.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Level-synchronous breadth-first search.
+//
+// Unvisited neighbors of the current level are claimed by their first parent
+// in the level order, and the children of each parent are ordered by their
+// degrees. Hence the visiting order is exactly the one of the sequential
+// Cuthill-McKee algorithm, regardless of the number of threads.
+template<std::unsigned_integral Node>
+class BreadthFirstSearch final {
+public:
+
+  // Construct a breadth-first search over the graph.
+  explicit BreadthFirstSearch(const BasicGraph<Node>& graph)
+      : graph_{&graph}, marks_(graph.num_nodes(), 0),
+        claims_(graph.num_nodes(), npos) {}
+
+  // Check if the node was visited by any of the searches.
+  auto visited(size_t node) const noexcept -> bool {
+    return marks_[node] != 0;
+  }
+
+  // Nodes in the visiting order.
+  auto order() const noexcept -> std::span<const size_t> {
+    return order_;
+  }
+
+  // Number of levels in the last search, i.e. the root eccentricity plus one.
+  auto num_levels() const noexcept -> size_t {
+    return level_firsts_.size() - 1;
+  }
+
+  // Nodes of the level in the visiting order.
+  auto level(size_t index) const noexcept -> std::span<const size_t> {
+    TIT_ASSERT(index < num_levels(), "Level index is out of range!");
+    return std::span{order_}.subspan(
+        level_firsts_[index],
+        level_firsts_[index + 1] - level_firsts_[index]);
+  }
+
+  // Node degree.
+  auto degree(size_t node) const noexcept -> size_t {
+    return (*graph_)[node].size();
+  }
+
+  // Visit the connected component of the root node.
+  void run(size_t root) {
+    TIT_ASSERT(root < graph_->num_nodes(), "Root node is out of range!");
+    stamp_ += 1;
+    order_.assign(1, root);
+    marks_[root] = stamp_;
+    level_firsts_.assign(1, 0);
+    for (size_t first = 0; first < order_.size();) {
+      const auto last = order_.size();
+      visit_level_(first, last);
+      level_firsts_.push_back(last);
+      first = last;
+    }
+
+    // Every claimed node was visited, so only those claims are reset.
+    par::for_each(order_, [this](size_t node) { claims_[node] = npos; });
+  }
+
+private:
+
+  // Append the children of the level nodes at positions `[first, last)`.
+  void visit_level_(size_t first, size_t last) {
+    const auto& graph = *graph_;
+    const auto positions = std::views::iota(first, last);
+    const auto is_child = [this](size_t neighbor, size_t pos) {
+      return marks_[neighbor] != stamp_ && claims_[neighbor] == pos;
+    };
+
+    // Claim the unvisited neighbors by their first parent.
+    par::for_each(positions, [&graph, this](size_t pos) {
+      for (const size_t neighbor : graph[order_[pos]]) {
+        if (marks_[neighbor] != stamp_) {
+          par::fetch_and_min(claims_[neighbor], pos);
+        }
+      }
+    });
+
+    // Count the children of each parent and compute their offsets.
+    std::vector<size_t> counts(last - first);
+    par::for_each(positions, [&graph, &counts, &is_child, first, this](
+                                 size_t pos) {
+      counts[pos - first] = static_cast<size_t>(
+          std::ranges::count_if(graph[order_[pos]],
+                                std::bind_back(is_child, pos)));
+    });
+    std::vector<size_t> offsets(counts.size());
+    par::exclusive_scan(counts, offsets.begin(), last);
+    order_.resize(offsets.back() + counts.back());
+
+    // Write the children, ordered by their degrees.
+    par::for_each(positions, [&graph, &offsets, &is_child, first, this](
+                                 size_t pos) {
+      const auto children_first = order_.begin() + offsets[pos - first];
+      auto children_last = children_first;
+      for (const size_t neighbor : graph[order_[pos]]) {
+        if (is_child(neighbor, pos)) *children_last++ = neighbor;
+      }
+      std::ranges::sort(children_first, children_last, {}, [this](size_t n) {
+        return std::tuple{degree(n), n};
+      });
+    });
+    par::for_each(order_ | std::views::drop(last),
+                  [this](size_t node) { marks_[node] = stamp_; });
+  }
+
+  const BasicGraph<Node>* graph_;
+  std::vector<size_t> marks_;  // Stamp of the last search visiting the node.
+  std::vector<size_t> claims_; // Position of the parent claiming the node.
+  std::vector<size_t> order_;
+  std::vector<size_t> level_firsts_;
+  size_t stamp_ = 0;
+
+}; // class BreadthFirstSearch
+
+// Find a pseudo-peripheral node of the connected component of the start node
+// using the George-Liu algorithm. The search is left at the found node.
+template<std::unsigned_integral Node>
+auto pseudo_peripheral_node(BreadthFirstSearch<Node>& bfs, size_t start)
+    -> size_t {
+  auto root = start;
+  bfs.run(root);
+  while (true) {
+    // Root with the minimal degree in the last level is at least as distant.
+    const auto num_levels = bfs.num_levels();
+    const auto candidate = *std::ranges::min_element(
+        bfs.level(num_levels - 1),
+        {},
+        [&bfs](size_t node) { return bfs.degree(node); });
+    if (candidate == root) break;
+    bfs.run(candidate);
+    root = candidate;
+    if (bfs.num_levels() == num_levels) break;
+  }
+  return root;
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Find a pseudo-peripheral node, i.e. a node with the (almost) maximal
+/// eccentricity, of the connected component that contains the start node.
+template<std::unsigned_integral Node>
+auto find_pseudo_peripheral_node(const BasicGraph<Node>& graph, size_t start)
+    -> size_t {
+  impl::BreadthFirstSearch bfs{graph};
+  return impl::pseudo_peripheral_node(bfs, start);
+}
+
+/// Compute the bandwidth of the graph adjacency matrix under the ordering,
+/// i.e. the maximal distance between the positions of the adjacent nodes.
+///
+/// @param perm Ordering, such that the node at position `i` is `perm[i]`.
+template<std::unsigned_integral Node, index_range Perm>
+auto compute_bandwidth(const BasicGraph<Node>& graph, Perm&& perm) -> size_t {
+  TIT_ASSUME_UNIVERSAL(Perm, perm);
+  std::vector<size_t> positions(graph.num_nodes());
+  par::for_each(std::views::iota(size_t{0}, graph.num_nodes()),
+                [&perm, &positions](size_t i) {
+                  positions[std::begin(perm)[i]] = i;
+                });
+  return par::transform_reduce(
+      std::views::iota(size_t{0}, graph.num_nodes()),
+      size_t{0},
+      [](size_t a, size_t b) { return std::max(a, b); },
+      [&graph, &positions](size_t node) {
+        size_t result = 0;
+        for (const size_t neighbor : graph[node]) {
+          const auto pos = positions[node];
+          const auto neighbor_pos = positions[neighbor];
+          result = std::max(result,
+                            pos > neighbor_pos ? pos - neighbor_pos :
+                                                 neighbor_pos - pos);
+        }
+        return result;
+      });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Bandwidth reducing Cuthill-McKee graph ordering function.
+///
+/// Each connected component is traversed breadth-first, starting from its
+/// pseudo-peripheral node, with the neighbors visited in the order of their
+/// degrees. Unlike the space filling curves, the ordering follows the actual
+/// connectivity of the graph. Levels of the traversal are processed in
+/// parallel, and the result does not depend on the number of threads.
+///
+/// Graph must not contain the duplicate edges.
+class CuthillMcKeeOrdering final {
+public:
+
+  /// Construct a Cuthill-McKee ordering function.
+  ///
+  /// @param reverse Reverse the ordering (RCM), which typically reduces the
+  ///                fill-in and the profile further.
+  constexpr explicit CuthillMcKeeOrdering(bool reverse = true) noexcept
+      : reverse_{reverse} {}
+
+  /// Order the graph nodes.
+  ///
+  /// @param perm Ordering, such that the node at position `i` is `perm[i]`.
+  template<std::unsigned_integral Node, output_index_range Perm>
+  void operator()(const BasicGraph<Node>& graph, Perm&& perm) const {
+    TIT_PROFILE_SECTION("CuthillMcKeeOrdering::operator()");
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    if constexpr (std::ranges::sized_range<Perm>) {
+      TIT_ASSERT(std::size(perm) == graph.num_nodes(),
+                 "Size of the ordering must be equal to the number of nodes!");
+    }
+    impl::BreadthFirstSearch bfs{graph};
+    auto out = std::begin(perm);
+    for (size_t node = 0; node < graph.num_nodes(); ++node) {
+      if (bfs.visited(node)) continue;
+      impl::pseudo_peripheral_node(bfs, node);
+      out = std::ranges::copy(bfs.order(), out).out;
+    }
+    if (reverse_) std::reverse(std::begin(perm), out);
+  }
+
+private:
+
+  bool reverse_;
+
+}; // class CuthillMcKeeOrdering
+
+/// Reverse Cuthill-McKee graph ordering.
+inline constexpr CuthillMcKeeOrdering rcm_ordering{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
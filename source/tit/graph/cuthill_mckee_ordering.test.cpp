@@ -0,0 +1,114 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/graph/cuthill_mckee_ordering.hpp"
+#include "tit/graph/graph.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+#define GRAPH_TYPES TIT_PASS(graph::Graph, graph::CompactGraph)
+
+// Build a path graph with the shuffled node labels.
+template<class Graph>
+auto make_shuffled_path(std::span<const size_t> labels) -> Graph {
+  std::vector<std::vector<size_t>> neighbors(labels.size());
+  for (size_t i = 1; i < labels.size(); ++i) {
+    neighbors[labels[i - 1]].push_back(labels[i]);
+    neighbors[labels[i]].push_back(labels[i - 1]);
+  }
+  Graph graph{};
+  for (const auto& bucket : neighbors) graph.append_bucket(bucket);
+  return graph;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("graph::find_pseudo_peripheral_node", Graph, GRAPH_TYPES) {
+  // Build a path: 3-6-0-5-2-7-1-4.
+  constexpr std::array<size_t, 8> labels{3, 6, 0, 5, 2, 7, 1, 4};
+  const auto graph = make_shuffled_path<Graph>(labels);
+
+  // Peripheral node of a path is one of its ends.
+  for (size_t start = 0; start < graph.num_nodes(); ++start) {
+    const auto node = graph::find_pseudo_peripheral_node(graph, start);
+    CHECK((node == labels.front() || node == labels.back()));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("graph::CuthillMcKeeOrdering", Graph, GRAPH_TYPES) {
+  SUBCASE("path") {
+    // Build a path with the shuffled labels, so that the bandwidth is large.
+    constexpr std::array<size_t, 8> labels{3, 6, 0, 5, 2, 7, 1, 4};
+    const auto graph = make_shuffled_path<Graph>(labels);
+    std::vector<size_t> perm(graph.num_nodes());
+    std::ranges::copy(std::views::iota(size_t{0}, graph.num_nodes()),
+                      perm.begin());
+    REQUIRE(graph::compute_bandwidth(graph, perm) > 1);
+
+    // Ensure the ordering restores the path.
+    graph::rcm_ordering(graph, perm);
+    CHECK(graph::compute_bandwidth(graph, perm) == 1);
+    CHECK((std::ranges::equal(perm, labels) ||
+           std::ranges::equal(perm, labels | std::views::reverse)));
+  }
+  SUBCASE("lattice") {
+    // Build a 4x4 lattice graph.
+    constexpr size_t n = 4;
+    Graph graph{};
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        std::vector<size_t> neighbors{};
+        if (i > 0) neighbors.push_back((i - 1) * n + j);
+        if (j > 0) neighbors.push_back(i * n + j - 1);
+        if (j + 1 < n) neighbors.push_back(i * n + j + 1);
+        if (i + 1 < n) neighbors.push_back((i + 1) * n + j);
+        graph.append_bucket(neighbors);
+      }
+    }
+
+    // Ordering starts from a corner and goes along the anti-diagonals, so
+    // the bandwidth is the length of the longest anti-diagonal.
+    std::vector<size_t> perm(graph.num_nodes());
+    graph::CuthillMcKeeOrdering{/*reverse=*/false}(graph, perm);
+    CHECK((perm.front() == 0 || perm.front() == n - 1 ||
+           perm.front() == n * (n - 1) || perm.front() == n * n - 1));
+    CHECK(graph::compute_bandwidth(graph, perm) == n);
+  }
+  SUBCASE("disconnected") {
+    // Build two triangles and an isolated node: 0-2-4, 1-3-5, 6.
+    Graph graph{};
+    graph.append_bucket(std::vector<size_t>{2, 4});
+    graph.append_bucket(std::vector<size_t>{3, 5});
+    graph.append_bucket(std::vector<size_t>{0, 4});
+    graph.append_bucket(std::vector<size_t>{1, 5});
+    graph.append_bucket(std::vector<size_t>{0, 2});
+    graph.append_bucket(std::vector<size_t>{1, 3});
+    graph.append_bucket(std::vector<size_t>{});
+
+    // Ensure every component is ordered contiguously, in the node order.
+    std::vector<size_t> perm(graph.num_nodes());
+    graph::CuthillMcKeeOrdering{/*reverse=*/false}(graph, perm);
+    CHECK_RANGE_EQ(perm, std::vector<size_t>{2, 0, 4, 3, 1, 5, 6});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
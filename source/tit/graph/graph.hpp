@@ -5,10 +5,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <concepts>
 #include <ranges>
+#include <span>
 #include <tuple>
+#include <utility>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/containers/multivector.hpp"
 
 namespace tit::graph {
@@ -24,25 +30,28 @@ using weight_t = ssize_t;
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Compressed sparse adjacency graph.
-class Graph : public Multivector<size_t> {
+///
+/// @tparam Node    Node index type. Use a narrower type, e.g. `uint32_t`,
+///                 to reduce the memory footprint of the large graphs.
+/// @tparam Storage Adjacency storage. Use `SlackMultivector` to update the
+///                 rows in place.
+template<std::unsigned_integral Node = size_t,
+         template<class> class Storage = Multivector>
+class BasicGraph : public Storage<Node> {
 public:
 
   /// Number of graph nodes.
   constexpr auto num_nodes() const noexcept -> size_t {
-    return size();
+    return this->size();
   }
 
   /// Range of the unique graph edges.
   constexpr auto edges() const noexcept {
-    return std::views::iota(0UZ, num_nodes()) |
-           std::views::transform([this](size_t row_index) {
-             return (*this)[row_index] |
-                    // Take only lower part of the row.
-                    std::views::take_while([row_index](size_t col_index) {
-                      return col_index < row_index;
-                    }) |
+    return std::views::iota(Node{0}, static_cast<Node>(num_nodes())) |
+           std::views::transform([this](Node row_index) {
+             return lower_row_(row_index) |
                     // Pack row and column indices into a tuple.
-                    std::views::transform([row_index](size_t col_index) {
+                    std::views::transform([row_index](Node col_index) {
                       return std::tuple{col_index, row_index};
                     });
            }) |
@@ -51,15 +60,11 @@ public:
 
   template<class Func>
   constexpr auto transform_edges(Func fn) const noexcept {
-    return std::views::iota(0UZ, num_nodes()) |
-           std::views::transform([this, fn](size_t row_index) {
-             return (*this)[row_index] |
-                    // Take only lower part of the row.
-                    std::views::take_while([row_index](size_t col_index) {
-                      return col_index < row_index;
-                    }) |
+    return std::views::iota(Node{0}, static_cast<Node>(num_nodes())) |
+           std::views::transform([this, fn](Node row_index) {
+             return lower_row_(row_index) |
                     // Pack row and column indices into a tuple.
-                    std::views::transform([row_index](size_t col_index) {
+                    std::views::transform([row_index](Node col_index) {
                       return std::tuple{col_index, row_index};
                     }) |
                     // Apply the transformation function.
@@ -68,7 +73,139 @@ public:
            std::views::join;
   }
 
-}; // class Graph
+private:
+
+  // Lower part of the sorted row, as a contiguous span. Unlike the
+  // `take_while` view, the span is sized, and its iteration is a plain loop.
+  constexpr auto lower_row_(Node row_index) const noexcept
+      -> std::span<const Node> {
+    const auto row = (*this)[row_index];
+    return row.first(static_cast<size_t>(
+        std::ranges::lower_bound(row, row_index) - row.begin()));
+  }
+
+}; // class BasicGraph
+
+/// Alias for a graph with the default node index type.
+using Graph = BasicGraph<>;
+
+/// Alias for a graph with the 32-bit node indices.
+using CompactGraph = BasicGraph<uint32_t>;
+
+/// Alias for a graph whose rows can be updated in place.
+using SlackGraph = BasicGraph<size_t, SlackMultivector>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Symmetric adjacency graph that stores only the lower triangle.
+///
+/// Each edge is stored once, in the row of its higher node, so the graph
+/// takes half of the memory of the full one. Most of the consumers only need
+/// the unique edges, that are served directly. Full rows are served through
+/// the transposed (upper) index, that is built on demand by
+/// `build_full_rows` and released by `release_full_rows`.
+///
+/// @note Diagonal entries, if any, are stored in the lower rows, so the full
+///       rows are exactly the rows of the original graph. They are not
+///       reported as edges.
+template<std::unsigned_integral Node = size_t>
+class BasicHalfGraph final {
+public:
+
+  /// Number of graph nodes.
+  constexpr auto num_nodes() const noexcept -> size_t {
+    return lower_.num_nodes();
+  }
+
+  /// Lower part of the row, including the diagonal, sorted.
+  constexpr auto lower(size_t row_index) const noexcept
+      -> std::span<const Node> {
+    return lower_[row_index];
+  }
+
+  /// Range of the unique graph edges.
+  constexpr auto edges() const noexcept {
+    return lower_.edges();
+  }
+
+  template<class Func>
+  constexpr auto transform_edges(Func fn) const noexcept {
+    return lower_.transform_edges(std::move(fn));
+  }
+
+  /// Are the full rows available?
+  constexpr auto has_full_rows() const noexcept -> bool {
+    return upper_.size() == num_nodes();
+  }
+
+  /// Full row, sorted. Full rows must be built first.
+  constexpr auto operator[](size_t row_index) const noexcept {
+    TIT_ASSERT(has_full_rows(), "Full rows are not built!");
+    return std::array{lower_[row_index], upper_[row_index]} | std::views::join;
+  }
+
+  /// Size of the full row. Full rows must be built first.
+  constexpr auto degree(size_t row_index) const noexcept -> size_t {
+    TIT_ASSERT(has_full_rows(), "Full rows are not built!");
+    return lower_[row_index].size() + upper_[row_index].size();
+  }
+
+  /// Memory allocated by the graph (in bytes), including the transposed
+  /// index, if it is built.
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return lower_.memory_usage() + upper_.memory_usage();
+  }
+
+  /// Clear the graph.
+  constexpr void clear() noexcept {
+    lower_.clear(), upper_.clear();
+  }
+
+  /// Build the graph from the sorted rows of a full symmetric graph, keeping
+  /// only the lower parts. Full rows are released.
+  template<template<class> class Storage>
+  void assign_full(const BasicGraph<Node, Storage>& graph) {
+    upper_.clear();
+    lower_.assign_buckets_par(graph.num_nodes(),
+                              [&graph](size_t row_index, auto out) {
+                                const auto row = graph[row_index];
+                                std::ranges::copy(
+                                    row.begin(),
+                                    std::ranges::upper_bound(row, row_index),
+                                    out);
+                              });
+  }
+
+  /// Build the transposed index, so that the full rows are available.
+  /// Does nothing if the full rows were already built.
+  void build_full_rows() {
+    if (has_full_rows()) return;
+    // Edges are visited row by row, so the transposed rows come out sorted.
+    upper_.assign_pairs_seq(
+        num_nodes(),
+        lower_.edges() | std::views::transform([](const auto& edge) {
+          const auto& [col_index, row_index] = edge;
+          return std::pair{static_cast<size_t>(col_index), row_index};
+        }));
+  }
+
+  /// Release the transposed index, the full rows are no longer available.
+  constexpr void release_full_rows() noexcept {
+    upper_.clear();
+  }
+
+private:
+
+  BasicGraph<Node> lower_;
+  BasicGraph<Node> upper_;
+
+}; // class BasicHalfGraph
+
+/// Alias for a half-storage graph with the default node index type.
+using HalfGraph = BasicHalfGraph<>;
+
+/// Alias for a half-storage graph with the 32-bit node indices.
+using CompactHalfGraph = BasicHalfGraph<uint32_t>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -0,0 +1,104 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/graph/graph.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+#define GRAPH_TYPES                                                            \
+  TIT_PASS(graph::Graph, graph::CompactGraph, graph::SlackGraph)
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("graph::Graph::edges", Graph, GRAPH_TYPES) {
+  // Build a triangle with a tail: 0-1, 0-2, 1-2, 2-3.
+  Graph graph{};
+  graph.append_bucket(std::vector<size_t>{1, 2});
+  graph.append_bucket(std::vector<size_t>{0, 2});
+  graph.append_bucket(std::vector<size_t>{0, 1, 3});
+  graph.append_bucket(std::vector<size_t>{2});
+  REQUIRE(graph.num_nodes() == 4);
+
+  // Each edge must be reported once, with the lower node first.
+  CHECK_RANGE_EQ(graph.edges(),
+                 std::vector<std::tuple<size_t, size_t>>{
+                     {0, 1},
+                     {0, 2},
+                     {1, 2},
+                     {2, 3},
+                 });
+}
+
+TEST_CASE("graph::SlackGraph::update_buckets_par") {
+  // Build a path: 0-1, 1-2, 2-3.
+  graph::SlackGraph graph{};
+  graph.append_bucket(std::vector<size_t>{1});
+  graph.append_bucket(std::vector<size_t>{0, 2});
+  graph.append_bucket(std::vector<size_t>{1, 3});
+  graph.append_bucket(std::vector<size_t>{2});
+
+  // Close the cycle by updating the end rows only.
+  graph.update_buckets_par(std::vector<size_t>{0, 3},
+                           [](size_t node, auto out) {
+                             std::ranges::copy(node == 0 ?
+                                                   std::vector<size_t>{1, 3} :
+                                                   std::vector<size_t>{0, 2},
+                                               out);
+                           });
+  CHECK_RANGE_EQ(graph.edges(),
+                 std::vector<std::tuple<size_t, size_t>>{
+                     {0, 1},
+                     {1, 2},
+                     {0, 3},
+                     {2, 3},
+                 });
+}
+
+TEST_CASE_TEMPLATE("graph::HalfGraph", Node, size_t, uint32_t) {
+  // Build a triangle with a tail, with the diagonal entries: 0-1, 0-2, 1-2,
+  // 2-3.
+  graph::BasicGraph<Node> full{};
+  full.append_bucket(std::vector<Node>{0, 1, 2});
+  full.append_bucket(std::vector<Node>{0, 1, 2});
+  full.append_bucket(std::vector<Node>{0, 1, 2, 3});
+  full.append_bucket(std::vector<Node>{2, 3});
+  graph::BasicHalfGraph<Node> graph{};
+  graph.assign_full(full);
+  REQUIRE(graph.num_nodes() == 4);
+
+  // Only the lower parts of the rows must be stored.
+  CHECK_RANGE_EQ(graph.lower(2), std::vector<Node>{0, 1, 2});
+  CHECK_RANGE_EQ(graph.lower(3), std::vector<Node>{3});
+  CHECK_RANGE_EQ(graph.edges(), full.edges());
+  CHECK_FALSE(graph.has_full_rows());
+
+  // Full rows must match the rows of the original graph.
+  graph.build_full_rows();
+  REQUIRE(graph.has_full_rows());
+  for (size_t row = 0; row < full.num_nodes(); ++row) {
+    CHECK(graph.degree(row) == full[row].size());
+    CHECK_RANGE_EQ(graph[row], full[row]);
+  }
+
+  // Full rows must be released on request.
+  graph.release_full_rows();
+  CHECK_FALSE(graph.has_full_rows());
+  CHECK_RANGE_EQ(graph.edges(), full.edges());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,93 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include <metis.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/graph/graph.hpp"
+#include "tit/graph/metis_partition.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void MetisPartition::partition_(MetisMode mode,
+                                std::span<const weight_t> row_ranges,
+                                std::span<const weight_t> cols,
+                                std::span<const weight_t> node_weights,
+                                std::span<const weight_t> edge_weights,
+                                std::span<size_t> parts,
+                                size_t num_parts) {
+  TIT_ASSERT(row_ranges.size() == parts.size() + 1,
+             "Size of row ranges must be equal to the number of nodes plus 1!");
+  TIT_ASSERT(cols.size() == edge_weights.size(),
+             "Size of edge weights must be equal to the number of edges!");
+
+  // METIS does not handle the trivial case gracefully.
+  if (num_parts == 1 || parts.empty()) {
+    std::ranges::fill(parts, 0);
+    return;
+  }
+
+  // Convert the graph to the METIS index type.
+  const auto to_idx = [](std::span<const weight_t> values) {
+    return values | std::views::transform([](weight_t value) {
+             return static_cast<idx_t>(value);
+           }) |
+           std::ranges::to<std::vector>();
+  };
+  auto xadj = to_idx(row_ranges);
+  auto adjncy = to_idx(cols);
+  auto vwgt = to_idx(node_weights);
+  auto adjwgt = to_idx(edge_weights);
+
+  // Partition the graph.
+  auto nvtxs = static_cast<idx_t>(parts.size());
+  auto ncon = idx_t{1};
+  auto nparts = static_cast<idx_t>(num_parts);
+  auto objval = idx_t{0};
+  std::vector<idx_t> part(parts.size());
+  std::array<idx_t, METIS_NOPTIONS> options{};
+  METIS_SetDefaultOptions(options.data());
+  options[METIS_OPTION_NUMBERING] = 0;
+  const auto partition_func = mode == MetisMode::recursive ?
+                                  METIS_PartGraphRecursive :
+                                  METIS_PartGraphKway;
+  const auto status = partition_func(&nvtxs,
+                                     &ncon,
+                                     xadj.data(),
+                                     adjncy.data(),
+                                     vwgt.data(),
+                                     /*vsize=*/nullptr,
+                                     adjwgt.data(),
+                                     &nparts,
+                                     /*tpwgts=*/nullptr,
+                                     /*ubvec=*/nullptr,
+                                     options.data(),
+                                     &objval,
+                                     part.data());
+  if (status != METIS_OK) {
+    TIT_THROW("METIS partitioning failed with status {}.",
+              static_cast<int>(status));
+  }
+
+  // Copy the results.
+  std::ranges::transform(part, parts.begin(), [](idx_t p) {
+    return static_cast<size_t>(p);
+  });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
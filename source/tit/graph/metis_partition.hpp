@@ -0,0 +1,90 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/profiler.hpp"
+
+#include "tit/graph/graph.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// METIS partitioning mode.
+enum class MetisMode : uint8_t {
+  kway,      ///< Multilevel k-way partitioning.
+  recursive, ///< Multilevel recursive bisection.
+};
+
+/// Graph partitioning function based on METIS.
+class MetisPartition final {
+public:
+
+  /// Construct a METIS partitioning function.
+  constexpr explicit MetisPartition(MetisMode mode = MetisMode::kway) noexcept
+      : mode_{mode} {}
+
+  /// Partition the weighted graph, minimizing the weight of the edge cut
+  /// while balancing the node weights of the parts.
+  template<class WeightedGraph>
+  void operator()(const WeightedGraph& graph,
+                  const std::vector<weight_t>& node_weights,
+                  auto& parts,
+                  size_t num_parts) const {
+    TIT_PROFILE_SECTION("MetisPartition::operator()");
+    TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
+    TIT_ASSERT(node_weights.size() == graph.num_nodes(),
+               "Size of node weights must be equal to the number of nodes!");
+
+    // Assemble the graph in the compressed sparse row format.
+    std::vector<weight_t> row_ranges{0};
+    std::vector<weight_t> cols{};
+    std::vector<weight_t> edge_weights{};
+    row_ranges.reserve(graph.num_nodes() + 1);
+    for (const auto node : graph.nodes()) {
+      for (const auto& [neighbor, weight] : graph[node]) {
+        cols.push_back(static_cast<weight_t>(neighbor));
+        edge_weights.push_back(weight);
+      }
+      row_ranges.push_back(static_cast<weight_t>(cols.size()));
+    }
+
+    // Partition the graph.
+    std::vector<size_t> node_parts(graph.num_nodes());
+    partition_(mode_,
+               row_ranges,
+               cols,
+               node_weights,
+               edge_weights,
+               node_parts,
+               num_parts);
+    std::ranges::copy(node_parts, std::begin(parts));
+  }
+
+private:
+
+  static void partition_(MetisMode mode,
+                         std::span<const weight_t> row_ranges,
+                         std::span<const weight_t> cols,
+                         std::span<const weight_t> node_weights,
+                         std::span<const weight_t> edge_weights,
+                         std::span<size_t> parts,
+                         size_t num_parts);
+
+  MetisMode mode_;
+
+}; // class MetisPartition
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
@@ -0,0 +1,54 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/graph/graph.hpp"
+#include "tit/graph/metis_partition.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::MetisPartition") {
+  // Build a graph of two cliques connected by a single light edge:
+  //
+  //   0 - 1       4 - 5
+  //   | X | ----- | X |
+  //   2 - 3       6 - 7
+  //
+  const graph::WeightedGraph graph{
+      {{1, 10}, {2, 10}, {3, 10}},
+      {{0, 10}, {2, 10}, {3, 10}},
+      {{0, 10}, {1, 10}, {3, 10}},
+      {{0, 10}, {1, 10}, {2, 10}, {4, 1}},
+      {{3, 1}, {5, 10}, {6, 10}, {7, 10}},
+      {{4, 10}, {6, 10}, {7, 10}},
+      {{4, 10}, {5, 10}, {7, 10}},
+      {{4, 10}, {5, 10}, {6, 10}},
+  };
+  const std::vector<graph::weight_t> node_weights(graph.num_nodes(), 1);
+
+  // Ensure that the cliques are separated, regardless of the mode.
+  for (const auto mode :
+       {graph::MetisMode::kway, graph::MetisMode::recursive}) {
+    std::vector<size_t> parts(graph.num_nodes());
+    const graph::MetisPartition metis_partition{mode};
+    metis_partition(graph, node_weights, parts, 2);
+    for (size_t node = 1; node < 4; ++node) CHECK(parts[node] == parts[0]);
+    for (size_t node = 5; node < 8; ++node) CHECK(parts[node] == parts[4]);
+    CHECK(parts[0] != parts[4]);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
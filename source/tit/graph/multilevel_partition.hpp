@@ -0,0 +1,412 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+
+#include "tit/graph/graph.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel multilevel graph partitioning function.
+///
+/// The graph is coarsened using the heavy edge matching until it is small
+/// enough, the coarsest graph is partitioned using the recursive greedy graph
+/// growing bisection, and the partitioning is projected back level by level
+/// and refined using the label propagation. Matching, contraction and the
+/// refinement move selection run in parallel.
+class MultilevelPartition final {
+public:
+
+  /// Construct a multilevel partitioning function.
+  ///
+  /// @param max_imbalance     Maximal ratio of the part weight to the average.
+  /// @param num_refine_passes Maximal number of refinement passes per level.
+  constexpr explicit MultilevelPartition(float64_t max_imbalance = 1.05,
+                                         size_t num_refine_passes = 8) noexcept
+      : max_imbalance_{max_imbalance}, num_refine_passes_{num_refine_passes} {
+    TIT_ASSERT(max_imbalance_ >= 1.0, "Maximal imbalance must be at least 1!");
+  }
+
+  /// Partition the weighted graph, minimizing the weight of the edge cut
+  /// while balancing the node weights of the parts.
+  template<class WeightedGraph>
+  void operator()(const WeightedGraph& graph,
+                  const std::vector<weight_t>& node_weights,
+                  auto& parts,
+                  size_t num_parts) const {
+    TIT_PROFILE_SECTION("MultilevelPartition::operator()");
+    TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
+    TIT_ASSERT(node_weights.size() == graph.num_nodes(),
+               "Size of node weights must be equal to the number of nodes!");
+
+    // Coarsen the graph.
+    std::vector<Level_> levels(1);
+    levels.front().graph.assign_buckets_par(graph.buckets());
+    levels.front().node_weights = node_weights;
+    const auto coarsest_size = CoarsestSizePerPart_ * num_parts;
+    while (levels.back().graph.num_nodes() > coarsest_size) {
+      auto& fine = levels.back();
+      const auto num_fine_nodes = fine.graph.num_nodes();
+      const auto num_coarse_nodes = match_(fine);
+      if (static_cast<float64_t>(num_coarse_nodes) >
+          MinCoarseningRatio_ * static_cast<float64_t>(num_fine_nodes)) {
+        break;
+      }
+      auto coarse = contract_(fine, num_coarse_nodes);
+      levels.push_back(std::move(coarse));
+    }
+
+    // Partition the coarsest graph.
+    std::vector<size_t> node_parts{};
+    initial_partition_(levels.back(), node_parts, num_parts);
+    refine_(levels.back(), node_parts, num_parts);
+
+    // Project the partitioning back to the finer levels and refine it.
+    std::vector<size_t> fine_parts{};
+    for (auto level = levels.rbegin() + 1; level != levels.rend(); ++level) {
+      fine_parts.resize(level->graph.num_nodes());
+      const auto& coarse_map = level->coarse_map;
+      par::for_each( //
+          level->graph.nodes(),
+          [&coarse_map, &node_parts, &fine_parts](node_t node) {
+            fine_parts[node] = node_parts[coarse_map[node]];
+          });
+      std::swap(node_parts, fine_parts);
+      refine_(*level, node_parts, num_parts);
+    }
+    std::ranges::copy(node_parts, std::begin(parts));
+  }
+
+private:
+
+  // Number of the coarsest graph nodes per part.
+  static constexpr size_t CoarsestSizePerPart_ = 20;
+
+  // Coarsening is stopped if the graph shrinks less than by this ratio.
+  static constexpr float64_t MinCoarseningRatio_ = 0.95;
+
+  // Number of the heavy edge matching rounds.
+  static constexpr size_t NumMatchingRounds_ = 3;
+
+  // Graph coarsening level.
+  struct Level_ final {
+    graph::WeightedGraph graph;
+    std::vector<weight_t> node_weights;
+    std::vector<node_t> coarse_map;
+  };
+
+  // Match the nodes of the level using the heavy edge matching, and map each
+  // node to the coarse node. Returns the number of the coarse nodes.
+  //
+  // Matching is computed in rounds: in each round every unmatched node
+  // proposes to its heaviest unmatched neighbor, and the mutual proposals
+  // are accepted.
+  static auto match_(Level_& level) -> size_t {
+    const auto& graph = level.graph;
+    std::vector<node_t> matches(graph.num_nodes(), npos);
+    std::vector<node_t> proposals(graph.num_nodes());
+    for (size_t round = 0; round < NumMatchingRounds_; ++round) {
+      par::for_each(graph.nodes(), [&graph, &matches, &proposals](node_t node) {
+        auto& proposal = proposals[node];
+        proposal = npos;
+        if (matches[node] != npos) return;
+        weight_t max_weight = 0;
+        for (const auto& [neighbor, weight] : graph[node]) {
+          if (neighbor == node || matches[neighbor] != npos) continue;
+          if (weight > max_weight) max_weight = weight, proposal = neighbor;
+        }
+      });
+      par::for_each(graph.nodes(), [&matches, &proposals](node_t node) {
+        const auto proposal = proposals[node];
+        if (proposal != npos && proposals[proposal] == node) {
+          matches[node] = proposal;
+        }
+      });
+    }
+
+    // Number the coarse nodes. Matched pair is numbered by its first node.
+    auto& coarse_map = level.coarse_map;
+    coarse_map.resize(graph.num_nodes());
+    size_t num_coarse_nodes = 0;
+    for (const auto node : graph.nodes()) {
+      if (matches[node] == npos) matches[node] = node;
+      if (node <= matches[node]) coarse_map[node] = num_coarse_nodes++;
+    }
+    par::for_each(graph.nodes(), [&matches, &coarse_map](node_t node) {
+      if (node > matches[node]) coarse_map[node] = coarse_map[matches[node]];
+    });
+    return num_coarse_nodes;
+  }
+
+  // Contract the matched nodes of the level into the coarse level.
+  static auto contract_(const Level_& fine, size_t num_coarse_nodes)
+      -> Level_ {
+    const auto& coarse_map = fine.coarse_map;
+    Multivector<node_t> members{};
+    members.assign_pairs_par_tall(
+        num_coarse_nodes,
+        fine.graph.nodes() | std::views::transform([&coarse_map](node_t node) {
+          return std::pair{coarse_map[node], node};
+        }));
+
+    // Merge the nodes and their edges, skipping the edges within the coarse
+    // node and summing the weights of the parallel edges.
+    Level_ coarse{};
+    coarse.node_weights.resize(num_coarse_nodes);
+    std::vector<std::vector<std::tuple<node_t, weight_t>>> buckets(
+        num_coarse_nodes);
+    par::for_each( //
+        std::views::iota(node_t{0}, node_t{num_coarse_nodes}),
+        [&fine, &coarse_map, &members, &coarse, &buckets](node_t coarse_node) {
+          auto& bucket = buckets[coarse_node];
+          weight_t node_weight = 0;
+          for (const auto node : members[coarse_node]) {
+            node_weight += fine.node_weights[node];
+            for (const auto& [neighbor, weight] : fine.graph[node]) {
+              const auto coarse_neighbor = coarse_map[neighbor];
+              if (coarse_neighbor == coarse_node) continue;
+              bucket.emplace_back(coarse_neighbor, weight);
+            }
+          }
+          coarse.node_weights[coarse_node] = node_weight;
+
+          std::ranges::sort(bucket);
+          auto out = bucket.begin();
+          for (auto iter = bucket.begin(); iter != bucket.end();) {
+            auto [neighbor, weight] = *iter;
+            for (++iter; iter != bucket.end() && std::get<0>(*iter) == neighbor;
+                 ++iter) {
+              weight += std::get<1>(*iter);
+            }
+            *out++ = {neighbor, weight};
+          }
+          bucket.erase(out, bucket.end());
+        });
+    coarse.graph.assign_buckets_par(buckets);
+    return coarse;
+  }
+
+  // Partition the level using the recursive greedy graph growing bisection.
+  static void initial_partition_(const Level_& level,
+                                 std::vector<size_t>& parts,
+                                 size_t num_parts) {
+    const auto& graph = level.graph;
+    parts.assign(graph.num_nodes(), 0);
+    std::vector<bool> marks(graph.num_nodes(), false);
+    bisect_(level,
+            graph.nodes() | std::ranges::to<std::vector>(),
+            parts,
+            marks,
+            0,
+            num_parts);
+  }
+
+  // Split the nodes, labeled with the first part, into the specified number
+  // of parts. Nodes are split into two halves of weights proportional to the
+  // number of parts in each half, and the halves are split recursively.
+  //
+  // The first half is grown from the pseudo-peripheral node, each time adding
+  // the frontier node that has the largest weight of the edges to the half
+  // minus the weight of the edges to the rest of the nodes.
+  static void bisect_(const Level_& level,
+                      std::vector<node_t> nodes,
+                      std::vector<size_t>& parts,
+                      std::vector<bool>& marks,
+                      size_t first_part,
+                      size_t num_parts) {
+    if (num_parts == 1 || nodes.empty()) return;
+    const auto& graph = level.graph;
+    const auto& node_weights = level.node_weights;
+    const auto is_member = [&parts, first_part](node_t node) {
+      return parts[node] == first_part;
+    };
+
+    // Find the pseudo-peripheral node by running the breadth-first search
+    // twice, each time starting from the last found node.
+    std::vector<node_t> queue{};
+    queue.reserve(nodes.size());
+    const auto last_visited = [&graph, &marks, &queue, &is_member](
+                                  node_t root) {
+      queue.clear(), queue.push_back(root);
+      marks[root] = true;
+      for (size_t index = 0; index < queue.size(); ++index) {
+        for (const auto& [neighbor, weight] : graph[queue[index]]) {
+          if (marks[neighbor] || !is_member(neighbor)) continue;
+          marks[neighbor] = true;
+          queue.push_back(neighbor);
+        }
+      }
+      for (const auto node : queue) marks[node] = false;
+      return queue.back();
+    };
+    const auto root = last_visited(last_visited(nodes.front()));
+
+    // Grow the first half.
+    const auto num_first_parts = num_parts / 2;
+    weight_t total_weight = 0;
+    for (const auto node : nodes) total_weight += node_weights[node];
+    const auto target_weight = static_cast<size_t>(total_weight) *
+                               num_first_parts;
+    std::vector<weight_t> gains(graph.num_nodes());
+    std::priority_queue<std::pair<weight_t, node_t>,
+                        std::vector<std::pair<weight_t, node_t>>,
+                        std::greater<>>
+        frontier{};
+    const auto push = [&graph, &marks, &gains, &frontier, &is_member](
+                          node_t node) {
+      weight_t gain = 0;
+      for (const auto& [neighbor, weight] : graph[node]) {
+        if (is_member(neighbor)) gain += marks[neighbor] ? weight : -weight;
+      }
+      gains[node] = gain;
+      frontier.emplace(-gain, node);
+    };
+    const auto is_unmarked = [&marks](node_t node) { return !marks[node]; };
+    push(root);
+    weight_t half_weight = 0;
+    auto rest_iter = nodes.begin();
+    while (static_cast<size_t>(half_weight) * num_parts < target_weight) {
+      if (frontier.empty()) {
+        // The nodes are disconnected, continue from any remaining node.
+        rest_iter = std::ranges::find_if(rest_iter, nodes.end(), is_unmarked);
+        if (rest_iter == nodes.end()) break;
+        push(*rest_iter);
+        continue;
+      }
+      const auto [neg_gain, node] = frontier.top();
+      frontier.pop();
+      if (marks[node] || -neg_gain != gains[node]) continue;
+      marks[node] = true;
+      half_weight += node_weights[node];
+      for (const auto& [neighbor, weight] : graph[node]) {
+        if (!marks[neighbor] && is_member(neighbor)) push(neighbor);
+      }
+    }
+
+    // Split the nodes into the halves and bisect them recursively.
+    const auto second_part = first_part + num_first_parts;
+    std::vector<node_t> second_nodes{};
+    std::erase_if(nodes, [&parts, &marks, &second_nodes, second_part](
+                             node_t node) {
+      if (marks[node]) {
+        marks[node] = false;
+        return false;
+      }
+      parts[node] = second_part;
+      second_nodes.push_back(node);
+      return true;
+    });
+    bisect_(level, std::move(nodes), parts, marks, first_part, num_first_parts);
+    bisect_(level,
+            std::move(second_nodes),
+            parts,
+            marks,
+            second_part,
+            num_parts - num_first_parts);
+  }
+
+  // Refine the partitioning of the level using the label propagation.
+  //
+  // Each pass first selects the most connected neighboring part for every
+  // node in parallel, and then applies the moves that still reduce the edge
+  // cut (or the imbalance) without violating the balance of the parts.
+  void refine_(const Level_& level,
+               std::vector<size_t>& parts,
+               size_t num_parts) const {
+    const auto& graph = level.graph;
+    const auto& node_weights = level.node_weights;
+
+    // Compute the part weights.
+    std::vector<weight_t> part_weights(num_parts, 0);
+    weight_t total_weight = 0;
+    for (const auto node : graph.nodes()) {
+      part_weights[parts[node]] += node_weights[node];
+      total_weight += node_weights[node];
+    }
+    const auto max_part_weight = static_cast<weight_t>(
+        std::ceil(max_imbalance_ * static_cast<float64_t>(total_weight) /
+                  static_cast<float64_t>(num_parts)));
+
+    // Connectivity of the node to the part.
+    const auto connectivity = [&graph, &parts](node_t node, size_t part) {
+      weight_t result = 0;
+      for (const auto& [neighbor, weight] : graph[node]) {
+        if (parts[neighbor] == part) result += weight;
+      }
+      return result;
+    };
+
+    // Most connected foreign part of the node and the gain of moving there.
+    const auto best_move = [&graph, &parts, &connectivity](node_t node) {
+      const auto part = parts[node];
+      const auto internal = connectivity(node, part);
+      auto result = std::pair{part, weight_t{0}};
+      auto max_gain = std::numeric_limits<weight_t>::min();
+      for (const auto& [neighbor, weight] : graph[node]) {
+        const auto neighbor_part = parts[neighbor];
+        if (neighbor_part == part || neighbor_part == result.first) continue;
+        const auto gain = connectivity(node, neighbor_part) - internal;
+        if (gain > max_gain) max_gain = gain, result = {neighbor_part, gain};
+      }
+      return result;
+    };
+
+    std::vector<size_t> targets(graph.num_nodes());
+    for (size_t pass = 0; pass < num_refine_passes_; ++pass) {
+      // Select the candidate moves.
+      par::for_each(graph.nodes(), [&targets, &best_move](node_t node) {
+        targets[node] = best_move(node).first;
+      });
+
+      // Apply the moves that are still profitable.
+      size_t num_moves = 0;
+      for (const auto node : graph.nodes()) {
+        const auto part = parts[node];
+        if (targets[node] == part) continue;
+        const auto [target, gain] = best_move(node);
+        if (target == part) continue;
+        const auto node_weight = node_weights[node];
+        const auto target_weight = part_weights[target] + node_weight;
+        if (target_weight > max_part_weight) continue;
+        const auto is_profitable =
+            gain > 0 || part_weights[part] > max_part_weight ||
+            (gain == 0 && target_weight < part_weights[part]);
+        if (!is_profitable) continue;
+        part_weights[part] -= node_weight;
+        part_weights[target] = target_weight;
+        parts[node] = target;
+        num_moves += 1;
+      }
+      if (num_moves == 0) break;
+    }
+  }
+
+  float64_t max_imbalance_;
+  size_t num_refine_passes_;
+
+}; // class MultilevelPartition
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
@@ -0,0 +1,89 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <tuple>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/graph/graph.hpp"
+#include "tit/graph/multilevel_partition.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::MultilevelPartition") {
+  SUBCASE("cliques") {
+    // Build a graph of two cliques connected by a single light edge:
+    //
+    //   0 - 1       4 - 5
+    //   | X | ----- | X |
+    //   2 - 3       6 - 7
+    //
+    const graph::WeightedGraph graph{
+        {{1, 10}, {2, 10}, {3, 10}},
+        {{0, 10}, {2, 10}, {3, 10}},
+        {{0, 10}, {1, 10}, {3, 10}},
+        {{0, 10}, {1, 10}, {2, 10}, {4, 1}},
+        {{3, 1}, {5, 10}, {6, 10}, {7, 10}},
+        {{4, 10}, {6, 10}, {7, 10}},
+        {{4, 10}, {5, 10}, {7, 10}},
+        {{4, 10}, {5, 10}, {6, 10}},
+    };
+    const std::vector<graph::weight_t> node_weights(graph.num_nodes(), 1);
+
+    // Ensure that the cliques are separated.
+    std::vector<size_t> parts(graph.num_nodes());
+    graph::MultilevelPartition{}(graph, node_weights, parts, 2);
+    for (size_t node = 1; node < 4; ++node) CHECK(parts[node] == parts[0]);
+    for (size_t node = 5; node < 8; ++node) CHECK(parts[node] == parts[4]);
+    CHECK(parts[0] != parts[4]);
+  }
+  SUBCASE("grid") {
+    // Build a square grid graph, large enough to be coarsened.
+    constexpr size_t size = 16;
+    constexpr size_t num_parts = 4;
+    graph::WeightedGraph graph{};
+    std::vector<std::tuple<graph::node_t, graph::weight_t>> neighbors{};
+    for (size_t i = 0; i < size; ++i) {
+      for (size_t j = 0; j < size; ++j) {
+        neighbors.clear();
+        if (i > 0) neighbors.emplace_back((i - 1) * size + j, 1);
+        if (j > 0) neighbors.emplace_back(i * size + j - 1, 1);
+        if (j + 1 < size) neighbors.emplace_back(i * size + j + 1, 1);
+        if (i + 1 < size) neighbors.emplace_back((i + 1) * size + j, 1);
+        graph.append_bucket(neighbors);
+      }
+    }
+    const std::vector<graph::weight_t> node_weights(graph.num_nodes(), 1);
+
+    // Ensure that the parts are balanced and the edge cut is no worse than
+    // the one of the partitioning into the strips.
+    std::vector<size_t> parts(graph.num_nodes());
+    graph::MultilevelPartition{}(graph, node_weights, parts, num_parts);
+    std::vector<size_t> part_sizes(num_parts, 0);
+    for (const auto part : parts) {
+      REQUIRE(part < num_parts);
+      part_sizes[part] += 1;
+    }
+    for (const auto part_size : part_sizes) {
+      CHECK(part_size <= 68); // 1.05 * 256 / 4, rounded up.
+    }
+    size_t cut = 0;
+    for (const auto& [weight, node, neighbor] : graph.edges()) {
+      if (parts[node] != parts[neighbor]) cut += 1;
+    }
+    CHECK(cut <= (num_parts - 1) * size);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,59 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "tit/core/utils.hpp"
+
+#include "tit/data/arrow.hpp"
+
+#include "tit/py/capsule.hpp"
+#include "tit/py/sequence.hpp"
+
+namespace tit::py {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Exported Arrow structure, that is released with its capsule, unless it was
+// moved out by the consumer. Structure is the first member, so the capsule
+// data points to it.
+template<class Arrow>
+struct ArrowCapsuleData final {
+  Arrow arrow{};
+
+  ArrowCapsuleData() = default;
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(ArrowCapsuleData);
+
+  ~ArrowCapsuleData() noexcept {
+    if (arrow.release != nullptr) arrow.release(&arrow);
+  }
+};
+
+} // namespace impl
+
+/// Export the record batch through the Arrow PyCapsule interface.
+///
+/// @returns Pair of the `arrow_schema` and the `arrow_array` capsules, as
+///          expected from the `__arrow_c_array__` method. Any Arrow-aware
+///          library, e.g. `pyarrow.record_batch`, imports them without
+///          copying the data.
+inline auto arrow_capsules(const data::ArrowRecordBatch& batch) -> Tuple {
+  auto schema = std::make_unique<impl::ArrowCapsuleData<ArrowSchema>>();
+  batch.export_schema(schema->arrow);
+  auto array = std::make_unique<impl::ArrowCapsuleData<ArrowArray>>();
+  batch.export_array(array->arrow);
+  return make_tuple(Capsule{std::move(schema), "arrow_schema"},
+                    Capsule{std::move(array), "arrow_array"});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::py
@@ -0,0 +1,60 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/data/arrow.hpp"
+
+#include "tit/py/arrow.hpp"
+#include "tit/py/capsule.hpp"
+#include "tit/py/error.hpp"
+#include "tit/py/object.hpp"
+#include "tit/py/sequence.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("py::arrow_capsules") {
+  auto rho = std::make_shared<std::vector<float64_t>>(
+      std::vector{1000.0, 1001.0});
+  const std::weak_ptr<std::vector<float64_t>> rho_owner = rho;
+  {
+    data::ArrowRecordBatch batch;
+    batch.add_column("rho", *rho, rho);
+    rho.reset();
+    const auto capsules = py::arrow_capsules(batch);
+    REQUIRE(py::len(capsules) == 2);
+
+    const auto schema = py::expect<py::Capsule>(capsules[0]);
+    CHECK(std::string_view{schema.name()} == "arrow_schema");
+    const auto* const arrow_schema = static_cast<ArrowSchema*>(schema.data());
+    CHECK(std::string_view{arrow_schema->format} == "+s");
+    REQUIRE(arrow_schema->n_children == 1);
+    CHECK(std::string_view{arrow_schema->children[0]->name} == "rho");
+
+    const auto array = py::expect<py::Capsule>(capsules[1]);
+    CHECK(std::string_view{array.name()} == "arrow_array");
+    const auto* const arrow_array = static_cast<ArrowArray*>(array.data());
+    CHECK(arrow_array->length == 2);
+    REQUIRE(arrow_array->n_children == 1);
+    CHECK(arrow_array->children[0]->buffers[1] == rho_owner.lock()->data());
+  }
+
+  // Unconsumed structures are released with the capsules.
+  CHECK(rho_owner.expired());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
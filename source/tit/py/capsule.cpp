@@ -23,11 +23,16 @@ auto Capsule::isinstance(const Object& obj) -> bool {
   return ensure(PyCapsule_CheckExact(obj.get()));
 }
 
-Capsule::Capsule(void* data, CapsuleDestructor destructor)
-    : Object{ensure(PyCapsule_New(data, /*name=*/nullptr, destructor))} {}
+Capsule::Capsule(void* data, const char* name, CapsuleDestructor destructor)
+    : Object{ensure(PyCapsule_New(data, name, destructor))} {}
+
+auto Capsule::name() const -> const char* {
+  // Null name is not an error, so the result is not checked.
+  return PyCapsule_GetName(get());
+}
 
 auto Capsule::data() const -> void* {
-  return ensure(PyCapsule_GetPointer(get(), /*name=*/nullptr));
+  return ensure(PyCapsule_GetPointer(get(), name()));
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
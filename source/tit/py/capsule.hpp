@@ -25,9 +25,12 @@ public:
   static auto isinstance(const Object& obj) -> bool;
 
   /// Construct a new capsule object from C++ data.
+  ///
+  /// @param name Capsule name, that must outlive the capsule, e.g. a string
+  ///             literal. Capsule is unnamed if it is null.
   template<class Data>
-  explicit Capsule(std::unique_ptr<Data> data)
-      : Capsule(data.get(), [](PyObject* self) {
+  explicit Capsule(std::unique_ptr<Data> data, const char* name = nullptr)
+      : Capsule(data.get(), name, [](PyObject* self) {
           // Destructor may be called when the capsule reference count is zero.
           // If we increase and decrease the reference count, the capsule will
           // be destroyed twice. The shenanigans below are to prevent this.
@@ -39,6 +42,9 @@ public:
     data.release();
   }
 
+  /// Capsule name, or null if the capsule is unnamed.
+  auto name() const -> const char*;
+
   /// Access the capsule data.
   auto data() const -> void*;
 
@@ -48,7 +54,7 @@ private:
   using CapsuleDestructor = void (*)(PyObject*);
 
   // Construct a new capsule object.
-  Capsule(void* data, CapsuleDestructor destructor);
+  Capsule(void* data, const char* name, CapsuleDestructor destructor);
 
 }; // class Capsule
 
@@ -4,6 +4,7 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <memory>
+#include <string_view>
 
 #include "tit/core/utils.hpp"
 
@@ -36,10 +37,16 @@ TEST_CASE("py::Capsule") {
     };
     {
       auto capsule = py::Capsule{std::make_unique<Data>()};
+      CHECK(capsule.name() == nullptr);
       CHECK(capsule.data() != nullptr);
     }
     CHECK(destroyed);
   }
+  SUBCASE("name") {
+    const auto capsule = py::Capsule{std::make_unique<int>(123), "answer"};
+    CHECK(std::string_view{capsule.name()} == "answer");
+    CHECK(*static_cast<int*>(capsule.data()) == 123);
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -10,6 +10,7 @@
 #include <concepts>
 #include <cstddef>
 #include <exception>
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -22,6 +23,7 @@
 
 #include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
+#include "tit/py/gil.hpp"
 #include "tit/py/mapping.hpp"
 #include "tit/py/object.hpp"
 #include "tit/py/type.hpp"
@@ -215,6 +217,27 @@ template<auto Func, class... Params>
 concept func_spec = (param_spec<Params> && ...) &&
                     (std::invocable<decltype(Func), typename Params::type...>);
 
+/// Function call policy that releases the GIL while the function runs, so
+/// that the other Python threads could proceed meanwhile. Arguments are parsed
+/// and the result is converted while the GIL is held.
+///
+/// @code
+/// m.def<"step", py::release_gil<step>, py::Param<size_t, "num_steps">>();
+/// @endcode
+///
+/// @note The function must not access any Python objects.
+template<auto Func>
+inline constexpr auto release_gil =
+    []<class... Args>(Args&&... args) -> decltype(auto)
+  requires std::invocable<decltype(Func), Args&&...>
+{
+  static_assert(
+      (!std::derived_from<std::remove_cvref_t<Args>, BaseObject> && ...),
+      "Function that releases the GIL must not accept Python objects!");
+  const ReleaseGIL released{};
+  return std::invoke(Func, std::forward<Args>(args)...);
+};
+
 /// C++ function pointer.
 using CppFuncPtr = PyObject* (*) (PyObject*, PyObject*, PyObject*);
 
@@ -5,9 +5,14 @@
 
 #include <filesystem>
 #include <string>
+#include <thread>
 
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+
+#include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
 #include "tit/py/func.hpp"
+#include "tit/py/gil.hpp"
 #include "tit/py/number.hpp"
 #include "tit/py/object.hpp"
 
@@ -48,6 +53,21 @@ TEST_CASE("py::CFunction") {
                          "arguments (2 given)");
       }
     }
+    SUBCASE("releases the GIL") {
+      // Other thread could use Python while the function is running.
+      const auto func = py::make_func<"func",
+                                      py::release_gil<[](int a) {
+                                        int result = 0;
+                                        std::jthread{[a, &result] {
+                                          const py::AcquireGIL acquire_gil{};
+                                          result = py::extract<int>(
+                                              py::Int{a} + py::Int{1});
+                                        }}.join();
+                                        return result;
+                                      }>,
+                                      py::Param<int, "a">>();
+      CHECK(func(1) == py::Int{2});
+    }
     SUBCASE("with arguments") {
       const auto func = py::make_func<"func",
                                       [](int a, int b) { return a + b; },
@@ -6,7 +6,10 @@
 #include "tit/core/exception.hpp"
 
 #include "tit/py/_python.hpp"
+#include "tit/py/cast.hpp"
 #include "tit/py/gil.hpp"
+#include "tit/py/module.hpp"
+#include "tit/py/object.hpp"
 
 namespace tit::py {
 
@@ -34,6 +37,27 @@ AcquireGIL::~AcquireGIL() noexcept {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+auto is_gil_enabled() -> bool {
+  // `sys._is_gil_enabled` is only available since Python 3.13.
+  const auto sys = import_("sys");
+  if (!sys.has_attr("_is_gil_enabled")) return true;
+  return extract<bool>(sys.attr("_is_gil_enabled")());
+}
+
+auto current_thread_id() -> ThreadID {
+  return PyThread_get_thread_ident();
+}
+
+void interrupt_thread(ThreadID thread_id) {
+  PyThreadState_SetAsyncExc(thread_id, PyExc_TimeoutError);
+}
+
+void cancel_thread_interrupt(ThreadID thread_id) {
+  PyThreadState_SetAsyncExc(thread_id, nullptr);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 // NOLINTEND(*-include-cleaner)
 
 } // namespace tit::py
@@ -76,4 +76,26 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Check if the GIL is enabled. It is always enabled, except for the
+/// free-threaded build of Python, where `ReleaseGIL` and `AcquireGIL` only
+/// detach and attach the thread state, and the Python code runs in parallel.
+/// GIL must be held.
+auto is_gil_enabled() -> bool;
+
+/// Python thread identifier.
+using ThreadID = unsigned long; // NOLINT(*-runtime-int)
+
+/// Get the identifier of the current Python thread. GIL must be held.
+auto current_thread_id() -> ThreadID;
+
+/// Interrupt the Python code running in the thread by raising `TimeoutError`
+/// in it. The error is raised once the thread executes the next bytecode
+/// instruction. GIL must be held.
+void interrupt_thread(ThreadID thread_id);
+
+/// Cancel the pending interruption of the thread. GIL must be held.
+void cancel_thread_interrupt(ThreadID thread_id);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::py
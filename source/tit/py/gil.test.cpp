@@ -3,6 +3,7 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <atomic>
 #include <string>
 #include <thread>
 #include <vector>
@@ -13,6 +14,7 @@
 #include "tit/py/gil.hpp"
 #include "tit/py/sequence.hpp"
 
+#include "tit/py/interpreter.testing.hpp"
 #include "tit/testing/test.hpp"
 
 namespace tit {
@@ -32,6 +34,24 @@ TEST_CASE("py::ReleaseGIL") {
   }
 }
 
+TEST_CASE("py::interrupt_thread") {
+  const py::ReleaseGIL release_gil{};
+  std::atomic<py::ThreadID> thread_id = 0;
+  std::atomic_bool success = true;
+  std::jthread thread{[&thread_id, &success] {
+    const py::AcquireGIL acquire_gil{};
+    thread_id = py::current_thread_id();
+    success = testing::interpreter().exec("while True: pass");
+  }};
+  while (thread_id == 0) std::this_thread::yield();
+  {
+    const py::AcquireGIL acquire_gil{};
+    py::interrupt_thread(thread_id);
+  }
+  thread.join();
+  CHECK_FALSE(success);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
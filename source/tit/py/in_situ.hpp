@@ -0,0 +1,208 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/profiler.hpp"
+#include "tit/core/time.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/py/gil.hpp"
+#include "tit/py/object.hpp"
+#include "tit/py/particles.hpp"
+
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::py {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// In-situ analysis stage, that invokes the Python callbacks on the particle
+/// array during the run.
+///
+/// Each callback is invoked as `callback(step, time, fields)` every
+/// `interval` steps, where `fields` are the read-only field views from
+/// `particle_fields`, valid only during the call. If the callbacks of a
+/// single invocation run longer than the time budget, their intervals are
+/// doubled, so that the analysis stays within the budget on average.
+///
+/// In the asynchronous mode, the callbacks receive the views of a snapshot of
+/// the particle array and run in a background thread. If the previous
+/// invocation is still running once the next one is due, the next one is
+/// skipped, so that the solver never waits for Python. The calling thread
+/// must not hold the GIL in this mode, see `ReleaseGIL`.
+template<sph::particle_array ParticleArray>
+class InSituAnalysis final {
+public:
+
+  /// Construct an in-situ analysis stage.
+  ///
+  /// @param budget Time budget of a single invocation (in seconds).
+  /// @param async  Run the callbacks asynchronously on a snapshot.
+  explicit InSituAnalysis(
+      real_t budget = std::numeric_limits<real_t>::infinity(),
+      bool async = false)
+      : budget_{budget}, async_{async} {
+    TIT_ASSERT(budget_ > 0.0, "Time budget must be positive!");
+    if (async_) thread_ = std::jthread{[this] { run_(); }};
+  }
+
+  /// In-situ analysis stage is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(InSituAnalysis);
+
+  /// Wait for the running invocation and stop the stage.
+  ~InSituAnalysis() noexcept {
+    if (async_) {
+      {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this] { return !is_pending_; });
+        is_stopping_ = true;
+        cv_.notify_all();
+      }
+      thread_.join();
+    }
+    const AcquireGIL acquire_gil{};
+    callbacks_.clear();
+  }
+
+  /// Register a callback that is invoked every @p interval steps.
+  void add(Object callback, size_t interval = 1) {
+    TIT_ASSERT(interval > 0, "Interval must be positive!");
+    const std::scoped_lock lock{mutex_};
+    callbacks_.push_back({std::move(callback), interval});
+  }
+
+  /// Number of the asynchronous invocations that were skipped.
+  auto num_skipped() const noexcept -> size_t {
+    return num_skipped_;
+  }
+
+  /// Invoke the callbacks that are due at the step.
+  void operator()(size_t step, real_t time, const ParticleArray& particles) {
+    TIT_PROFILE_SECTION("InSituAnalysis::operator()");
+    std::unique_lock lock{mutex_};
+    if (error_ != nullptr) std::rethrow_exception(std::exchange(error_, {}));
+    if (!is_due_(step)) return;
+    if (!async_) {
+      lock.unlock();
+      const AcquireGIL acquire_gil{};
+      invoke_(step, time, particles);
+      return;
+    }
+    if (is_pending_) {
+      num_skipped_ += 1;
+      return;
+    }
+    snapshot_ = particles;
+    step_ = step, time_ = time;
+    is_pending_ = true;
+    cv_.notify_all();
+  }
+
+  /// Block until the running invocation is completed.
+  void wait() {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return !is_pending_; });
+    if (error_ != nullptr) std::rethrow_exception(std::exchange(error_, {}));
+  }
+
+private:
+
+  struct Callback_ final {
+    Object func;
+    size_t interval;
+  };
+
+  auto is_due_(size_t step) const noexcept -> bool {
+    return std::ranges::any_of(callbacks_, [step](const Callback_& callback) {
+      return step % callback.interval == 0;
+    });
+  }
+
+  // Invoke the due callbacks. GIL must be held.
+  void invoke_(size_t step, real_t time, const ParticleArray& particles) {
+    std::vector<std::pair<size_t, Object>> due;
+    {
+      const std::scoped_lock lock{mutex_};
+      for (size_t index = 0; index < callbacks_.size(); ++index) {
+        const auto& callback = callbacks_[index];
+        if (step % callback.interval == 0) {
+          due.emplace_back(index, callback.func);
+        }
+      }
+    }
+    const auto fields = particle_fields(particles, None());
+    Stopwatch stopwatch{};
+    {
+      const StopwatchCycle cycle{stopwatch};
+      for (const auto& func : due | std::views::values) {
+        func(step, time, fields);
+      }
+    }
+    if (stopwatch.total() <= budget_) return;
+    TIT_WARN("In-situ analysis took {:.3f}s, which exceeds the budget of "
+             "{:.3f}s. Invocation intervals are doubled.",
+             stopwatch.total(),
+             budget_);
+    const std::scoped_lock lock{mutex_};
+    for (const auto index : due | std::views::keys) {
+      callbacks_[index].interval *= 2;
+    }
+  }
+
+  void run_() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [this] { return is_stopping_ || is_pending_; });
+      if (!is_pending_) break;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        const AcquireGIL acquire_gil{};
+        invoke_(step_, time_, *snapshot_);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error != nullptr && error_ == nullptr) error_ = std::move(error);
+      is_pending_ = false;
+      cv_.notify_all();
+    }
+  }
+
+  real_t budget_;
+  bool async_;
+  std::vector<Callback_> callbacks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::optional<ParticleArray> snapshot_;
+  size_t step_ = 0;
+  real_t time_{};
+  size_t num_skipped_ = 0;
+  std::exception_ptr error_;
+  bool is_pending_ = false;
+  bool is_stopping_ = false;
+  std::jthread thread_;
+
+}; // class InSituAnalysis
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::py
@@ -0,0 +1,98 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/py/gil.hpp"
+#include "tit/py/in_situ.hpp"
+#include "tit/py/object.hpp"
+#include "tit/py/sequence.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/py/interpreter.testing.hpp"
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the varying position and density fields.
+using DensityEquations = EquationsStub<meta::Set{sph::r, sph::rho}>;
+
+TEST_CASE("py::InSituAnalysis") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, DensityEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 4)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+    sph::rho[a] = 1.0;
+  }
+  using Analysis = py::InSituAnalysis<decltype(particles)>;
+
+  // Callback records the step and the total density.
+  REQUIRE(testing::interpreter().exec(R"PY(
+    import time
+    calls = []
+    def total_density(step, t, fields):
+      calls.append((step, float(fields["rho"].sum())))
+    def slow_total_density(step, t, fields):
+      time.sleep(0.01)
+      total_density(step, t, fields)
+  )PY"));
+  const auto& globals = testing::interpreter().globals();
+  const auto calls = py::expect<py::List>(globals["calls"]);
+  SUBCASE("sync") {
+    {
+      Analysis analysis{};
+      analysis.add(globals["total_density"], /*interval=*/2);
+      for (size_t step = 0; step < 5; ++step) {
+        analysis(step, 0.1 * static_cast<double>(step), particles);
+      }
+    }
+    CHECK(calls == py::make_list(py::make_tuple(0, 4.0),
+                                 py::make_tuple(2, 4.0),
+                                 py::make_tuple(4, 4.0)));
+  }
+  SUBCASE("budget") {
+    {
+      Analysis analysis{/*budget=*/1.0e-3};
+      analysis.add(globals["slow_total_density"]);
+      for (size_t step = 0; step < 3; ++step) {
+        analysis(step, 0.1 * static_cast<double>(step), particles);
+      }
+    }
+    CHECK(calls ==
+          py::make_list(py::make_tuple(0, 4.0), py::make_tuple(2, 4.0)));
+  }
+  SUBCASE("async") {
+    {
+      const py::ReleaseGIL release_gil{};
+      Analysis analysis{/*budget=*/1.0, /*async=*/true};
+      {
+        const py::AcquireGIL acquire_gil{};
+        analysis.add(globals["total_density"]);
+      }
+      analysis(0, 0.0, particles);
+      analysis.wait();
+
+      // Snapshot is taken, so the further changes are not visible.
+      analysis(1, 0.1, particles);
+      for (const auto a : particles.all()) sph::rho[a] = 2.0;
+      analysis.wait();
+      CHECK(analysis.num_skipped() == 0);
+    }
+    CHECK(calls ==
+          py::make_list(py::make_tuple(0, 4.0), py::make_tuple(1, 4.0)));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -106,6 +106,20 @@ auto dedent(CStrView str) -> std::string {
   return extract<std::string>(result);
 }
 
+// Execute the Python statement with the given global variables.
+auto exec_with(const Dict& globals, CStrView stmt) -> bool {
+  auto* const result = PyRun_String(dedent(stmt).c_str(),
+                                    /*start=*/Py_file_input,
+                                    /*globals=*/globals.get(),
+                                    /*locals=*/globals.get());
+  if (result == nullptr) {
+    PyErr_Print();
+    return false;
+  }
+  Py_DECREF(result);
+  return true;
+}
+
 } // namespace
 
 Interpreter::Interpreter(Config config)
@@ -145,16 +159,7 @@ auto Interpreter::eval(CStrView expr) const -> Object {
 }
 
 auto Interpreter::exec(CStrView stmt) const -> bool {
-  auto* const result = PyRun_String(dedent(stmt).c_str(),
-                                    /*start=*/Py_file_input,
-                                    /*globals=*/globals_.get(),
-                                    /*locals=*/globals_.get());
-  if (result == nullptr) {
-    PyErr_Print();
-    return false;
-  }
-  Py_DECREF(result);
-  return true;
+  return exec_with(globals_, stmt);
 }
 
 auto Interpreter::exec_file(CStrView file_name) const -> bool {
@@ -204,6 +209,81 @@ void Interpreter::stop_coverage_report_() const {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+#if PY_VERSION_HEX >= 0x030C0000
+
+SubInterpreter::SubInterpreter() {
+  const PyInterpreterConfig config{
+      .use_main_obmalloc = 0,
+      .allow_fork = 0,
+      .allow_exec = 0,
+      .allow_threads = 1,
+      .allow_daemon_threads = 0,
+      .check_multi_interp_extensions = 1,
+      .gil = PyInterpreterConfig_OWN_GIL,
+  };
+
+  // New interpreter's thread state becomes current, so we switch back to
+  // the caller's one right away.
+  auto* const caller_state = PyThreadState_Get();
+  PyThreadState* state = nullptr;
+  const auto status = Py_NewInterpreterFromConfig(&state, &config);
+  PyThreadState_Swap(caller_state);
+  if (PyStatus_IsError(status) != 0) {
+    TIT_THROW("Failed to initialize Python sub-interpreter: {}: {}.",
+              status.func,
+              status.err_msg);
+  }
+  interp_ = PyThreadState_GetInterpreter(state);
+
+  // The initial thread state is not needed, since each call to `run` creates
+  // its own one.
+  PyThreadState_Swap(state);
+  PyThreadState_Clear(state);
+  PyThreadState_Swap(caller_state);
+  PyThreadState_Delete(state);
+}
+
+SubInterpreter::~SubInterpreter() {
+  auto* const state = PyThreadState_New(interp_);
+  auto* const caller_state = PyThreadState_Swap(state);
+  Py_EndInterpreter(state);
+  PyThreadState_Swap(caller_state);
+}
+
+SubInterpreter::ThreadState_::ThreadState_(PyInterpreterState* interp)
+    : state_{PyThreadState_New(interp)} {
+  if (state_ == nullptr) {
+    TIT_THROW("Failed to create Python sub-interpreter thread state.");
+  }
+  PyEval_RestoreThread(state_);
+}
+
+SubInterpreter::ThreadState_::~ThreadState_() noexcept {
+  PyThreadState_Clear(state_);
+  PyThreadState_DeleteCurrent();
+}
+
+#else
+
+SubInterpreter::SubInterpreter() {
+  TIT_THROW("Python sub-interpreters require Python 3.12 or newer.");
+}
+
+SubInterpreter::~SubInterpreter() = default;
+
+SubInterpreter::ThreadState_::ThreadState_(PyInterpreterState* /*interp*/)
+    : state_{nullptr} {}
+
+SubInterpreter::ThreadState_::~ThreadState_() noexcept = default;
+
+#endif
+
+auto SubInterpreter::exec(CStrView stmt) const -> bool {
+  return run([stmt] { return exec_with(import_("__main__").dict(), stmt); });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 // NOLINTEND(*-include-cleaner)
 
 } // namespace tit::py::embed
@@ -5,16 +5,21 @@
 
 #pragma once
 
+#include <concepts>
+#include <functional>
 #include <memory>
+#include <type_traits>
 
 #include "tit/core/cmd.hpp"
 #include "tit/core/str_utils.hpp"
 #include "tit/core/utils.hpp"
 
+#include "tit/py/gil.hpp"
 #include "tit/py/mapping.hpp"
 #include "tit/py/object.hpp"
 
 struct PyConfig; // Not available under limited API.
+using PyInterpreterState = struct _is; // NOLINT(*-reserved-identifier, cert-*)
 
 namespace tit::py::embed {
 
@@ -115,4 +120,60 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Embedded Python sub-interpreter with its own GIL.
+///
+/// Sub-interpreters are isolated from the main interpreter and from each
+/// other, so that the Python code runs in them in parallel. Python objects
+/// must never be passed between the interpreters. Extension modules that do
+/// not support isolated sub-interpreters (NumPy, for example) cannot be
+/// imported. Requires Python 3.12 or newer.
+class SubInterpreter final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(SubInterpreter);
+
+  /// Construct the sub-interpreter. GIL of the main interpreter must be held.
+  SubInterpreter();
+
+  /// Destroy the sub-interpreter. GIL of the main interpreter must be held,
+  /// and no threads may be running in the sub-interpreter.
+  ~SubInterpreter();
+
+  /// Run the function in the sub-interpreter on the current thread. Thread
+  /// must not hold the GIL of any other interpreter. Python objects created
+  /// by the function must not outlive it.
+  template<std::invocable Func>
+  auto run(Func func) const -> std::invoke_result_t<Func> {
+    const ThreadState_ thread_state{interp_};
+    return std::invoke(std::move(func));
+  }
+
+  /// Execute the Python statement on the current thread, same as `run`.
+  /// If execution fails, an error is printed and `false` is returned.
+  auto exec(CStrView stmt) const -> bool;
+
+private:
+
+  // Thread state of the sub-interpreter, attached to the current thread.
+  class ThreadState_ final {
+  public:
+
+    TIT_NOT_COPYABLE_OR_MOVABLE(ThreadState_);
+
+    explicit ThreadState_(PyInterpreterState* interp);
+
+    ~ThreadState_() noexcept;
+
+  private:
+
+    PyThreadState* state_;
+
+  }; // class ThreadState_
+
+  PyInterpreterState* interp_ = nullptr;
+
+}; // class SubInterpreter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::py::embed
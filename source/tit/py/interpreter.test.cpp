@@ -3,13 +3,20 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <atomic>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <thread>
+#include <vector>
 
 #include "tit/core/exception.hpp"
 
 #include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
+#include "tit/py/gil.hpp"
+#include "tit/py/interpreter.hpp"
+#include "tit/py/module.hpp"
 
 #include "tit/py/interpreter.testing.hpp"
 #include "tit/testing/test.hpp"
@@ -75,5 +82,30 @@ TEST_CASE("py::embed::Interpreter::exec_file") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("py::embed::SubInterpreter") {
+  std::vector<py::embed::SubInterpreter> interpreters(4);
+  std::atomic<size_t> num_succeeded = 0;
+  {
+    const py::ReleaseGIL release_gil{};
+    std::vector<std::jthread> threads;
+    for (size_t i = 0; i < interpreters.size(); ++i) {
+      threads.emplace_back([i, &interpreters, &num_succeeded] {
+        const auto& interpreter = interpreters[i];
+        CHECK(interpreter.exec(std::format("value = {}", i)));
+        const auto value = interpreter.run([] {
+          return py::extract<size_t>(py::import_("__main__").dict()["value"]);
+        });
+        if (value == i) ++num_succeeded;
+      });
+    }
+  }
+
+  // Global variables of the interpreters are isolated.
+  CHECK(num_succeeded == interpreters.size());
+  CHECK_FALSE(testing::interpreter().globals().has_key("value"));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -5,6 +5,7 @@
 
 #include <algorithm> // IWYU pragma: keep
 #include <functional>
+#include <ranges>
 #include <span>
 #include <utility>
 
@@ -90,17 +91,56 @@ auto NDArray::isinstance(const Object& obj) -> bool {
 NDArray::NDArray(data::DataKind kind,
                  byte_t* data,
                  size_t num_bytes,
-                 std::span<const size_t> shape) {
-  const auto num_bytes_from_shape =
-      std::ranges::fold_left(shape, kind.width(), std::multiplies{});
-  TIT_ASSERT(num_bytes == num_bytes_from_shape, "Invalid number of bytes!");
+                 std::span<const size_t> shape,
+                 std::span<const size_t> strides,
+                 bool writeable) {
+  if (strides.empty()) {
+    const auto num_bytes_from_shape =
+        std::ranges::fold_left(shape, kind.width(), std::multiplies{});
+    TIT_ASSERT(num_bytes == num_bytes_from_shape, "Invalid number of bytes!");
+  } else {
+    TIT_ASSERT(strides.size() == shape.size(), "Invalid number of strides!");
+    const auto num_bytes_from_strides = std::ranges::fold_left(
+        std::views::zip(shape, strides),
+        kind.width(),
+        [](size_t result, const auto& dim_and_stride) {
+          const auto [dim, stride] = dim_and_stride;
+          return dim == 0 ? result : result + (dim - 1) * stride;
+        });
+    TIT_ASSERT(num_bytes == 0 || num_bytes >= num_bytes_from_strides,
+               "Invalid number of bytes!");
+  }
   TIT_ASSERT(num_bytes == 0 || data != nullptr, "Invalid data pointer!");
   ensure_numpy_imported();
-  reset(ensure(PyArray_SimpleNewFromData( //
-      shape.size(),
-      std::bit_cast<const ssize_t*>(shape.data()),
+  reset(ensure(PyArray_New( //
+      &PyArray_Type,
+      static_cast<int>(shape.size()),
+      std::bit_cast<ssize_t*>(shape.data()),
       data_kind_to_numpy(kind),
-      data)));
+      strides.empty() ? nullptr : std::bit_cast<ssize_t*>(strides.data()),
+      data,
+      /*itemsize=*/0,
+      writeable ? NPY_ARRAY_WRITEABLE : 0,
+      /*obj=*/nullptr)));
+}
+
+NDArray::NDArray(data::DataKind kind, std::span<const size_t> shape) {
+  ensure_numpy_imported();
+  reset(ensure(PyArray_SimpleNew(static_cast<int>(shape.size()),
+                                 std::bit_cast<ssize_t*>(shape.data()),
+                                 data_kind_to_numpy(kind))));
+}
+
+auto NDArray::from(const Object& obj, data::DataKind kind) -> NDArray {
+  ensure_numpy_imported();
+  // Type descriptor reference is stolen by the call.
+  return steal<NDArray>(ensure(PyArray_FromAny( //
+      obj.get(),
+      ensure(PyArray_DescrFromType(data_kind_to_numpy(kind))),
+      /*min_depth=*/0,
+      /*max_depth=*/0,
+      NPY_ARRAY_IN_ARRAY,
+      /*context=*/nullptr)));
 }
 
 auto NDArray::get_array() const -> PyArrayObject* {
@@ -119,6 +159,12 @@ auto NDArray::kind() const -> data::DataKind {
   return data_kind_from_numpy(ensure<NPY_TYPES>(PyArray_TYPE(get_array())));
 }
 
+auto NDArray::bytes() const -> std::span<byte_t> {
+  TIT_ASSERT(PyArray_IS_C_CONTIGUOUS(get_array()), "Array is not contiguous!");
+  return std::span{ensure<byte_t*>(PyArray_DATA(get_array())),
+                   ensure<size_t>(PyArray_NBYTES(get_array()))};
+}
+
 auto NDArray::elem(std::span<const ssize_t> mdindex) const
     -> std::span<byte_t> {
   TIT_ASSERT(mdindex.size() == rank(), "Invalid index size!");
@@ -133,6 +179,10 @@ void NDArray::set_base(Object base) const {
   ensure(PyArray_SetBaseObject(get_array(), base.release()));
 }
 
+auto NDArray::is_writeable() const -> bool {
+  return PyArray_ISWRITEABLE(get_array());
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 // NOLINTEND(*-include-cleaner,*-cstyle-cast,*-pointer-arithmetic)
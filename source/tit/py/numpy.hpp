@@ -5,19 +5,27 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <concepts>
 #include <memory>
 #include <span>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/containers/mdvector.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/vec.hpp"
 
 #include "tit/data/type.hpp"
 
 #include "tit/py/capsule.hpp"
+#include "tit/py/cast.hpp"
+#include "tit/py/error.hpp"
 #include "tit/py/object.hpp"
 #include "tit/py/sequence.hpp"
 #include "tit/py/type.hpp"
@@ -38,14 +46,146 @@ public:
   /// Check if the object is a subclass of `NDArray`.
   static auto isinstance(const Object& obj) -> bool;
 
-  /// Create a new NumPy array from a multidimensional array.
-  template<data::known_type_of Val, size_t Rank>
-  explicit NDArray(Mdvector<Val, Rank> mdvec)
+  /// Create a new NumPy array from a multidimensional array. Row-major
+  /// arrays are wrapped without copying, with the strides that skip the
+  /// padding, if any.
+  template<data::known_type_of Val, size_t Rank, class Layout>
+    requires (!Mdvector<Val, Rank, Layout>::is_tiled)
+  explicit NDArray(Mdvector<Val, Rank, Layout> mdvec)
       : NDArray{data::kind_of<Val>,
                 std::bit_cast<byte_t*>(mdvec.data()),
-                mdvec.size() * sizeof(Val),
-                mdvec.shape()} {
-    set_base(Capsule{std::make_unique<Mdvector<Val, Rank>>(std::move(mdvec))});
+                mdvec.storage_size() * sizeof(Val),
+                mdvec.shape(),
+                byte_strides_<Val>(mdvec.strides())} {
+    set_base(Capsule{
+        std::make_unique<Mdvector<Val, Rank, Layout>>(std::move(mdvec))});
+  }
+
+  /// Create a new NumPy array from a tiled multidimensional array. Tiles
+  /// cannot be expressed with the strides, so the values are copied into a
+  /// contiguous array.
+  template<data::known_type_of Val, size_t Rank, class Layout>
+    requires Mdvector<Val, Rank, Layout>::is_tiled
+  explicit NDArray(const Mdvector<Val, Rank, Layout>& mdvec)
+      : NDArray{data::kind_of<Val>, mdvec.shape()} {
+    mdvec.copy_to(std::bit_cast<Val*>(bytes().data()));
+  }
+
+  /// Create a new uninitialized contiguous NumPy array.
+  NDArray(data::DataKind kind, std::span<const size_t> shape);
+
+  /// Create a NumPy array view of the existing memory, without copying.
+  ///
+  /// @param data    Array elements. The view is read-only if they are const.
+  /// @param shape   Array shape.
+  /// @param strides Array strides in bytes. Row-major if empty.
+  /// @param owner   Object that owns the memory, and is kept alive while the
+  ///                view exists.
+  template<class Val>
+    requires data::known_kind_of<std::remove_const_t<Val>>
+  NDArray(std::span<Val> data,
+          std::span<const size_t> shape,
+          std::span<const size_t> strides,
+          Object owner)
+      : NDArray{data::kind_of<std::remove_const_t<Val>>,
+                std::bit_cast<byte_t*>(
+                    const_cast<std::remove_const_t<Val>*>(data.data())),
+                data.size_bytes(),
+                shape,
+                strides,
+                /*writeable=*/!std::is_const_v<Val>} {
+    set_base(std::move(owner));
+  }
+
+  /// Create a NumPy array view of the existing scalars, vectors or matrices,
+  /// without copying. Vectors and matrices become the trailing dimensions.
+  ///
+  /// @param vals  Values. The view is read-only if they are const.
+  /// @param owner Object that owns the memory, and is kept alive while the
+  ///              view exists.
+  template<class Val>
+    requires data::known_type_of<std::remove_const_t<Val>>
+  static auto view(std::span<Val> vals, Object owner) -> NDArray {
+    using Value = std::remove_const_t<Val>;
+    if constexpr (is_vec_v<Value>) {
+      // Vector elements are not contiguous across the values, since the
+      // vectors may be padded.
+      using Num = vec_num_t<Value>;
+      const std::array shape{vals.size(), vec_dim_v<Value>};
+      const std::array strides{sizeof(Value), sizeof(Num)};
+      return view_<Num>(vals, shape, strides, std::move(owner));
+    } else if constexpr (is_mat_v<Value>) {
+      using Row = mat_row_t<Value>;
+      using Num = mat_num_t<Value>;
+      const std::array shape{vals.size(), vec_dim_v<Row>, vec_dim_v<Row>};
+      const std::array strides{sizeof(Value), sizeof(Row), sizeof(Num)};
+      return view_<Num>(vals, shape, strides, std::move(owner));
+    } else {
+      const std::array shape{vals.size()};
+      return NDArray{vals, shape, {}, std::move(owner)};
+    }
+  }
+
+  /// Create a new NumPy array with a copy of the scalars, vectors or
+  /// matrices. Vectors and matrices become the trailing dimensions.
+  template<data::known_type_of Val>
+  static auto copy(std::span<const Val> vals) -> NDArray {
+    constexpr auto val_type = data::type_of<Val>;
+    const NDArray result{val_type.kind(), value_shape_<Val>(vals.size())};
+    if constexpr (val_type.rank() == data::DataRank::scalar) {
+      std::ranges::copy(std::as_bytes(vals), result.bytes().begin());
+    } else {
+      // Values may be padded, so they are copied component-wise.
+      auto out = result.bytes().begin();
+      for (const auto& val : vals) {
+        for_each_num_(val, [&out](const auto& num) {
+          out = std::ranges::copy(std::as_bytes(std::span{&num, 1}), out).out;
+        });
+      }
+    }
+    return result;
+  }
+
+  /// Convert an array-like object into a contiguous NumPy array of the given
+  /// data kind.
+  ///
+  /// NumPy arrays, `memoryview`s and other objects that implement the buffer
+  /// protocol are converted with a single bulk copy, and are not copied at
+  /// all if they are already contiguous and of the requested kind. Sequences
+  /// of numbers are converted by NumPy, without the per-element conversions
+  /// through the Python objects on our side.
+  static auto from(const Object& obj, data::DataKind kind) -> NDArray;
+
+  /// Copy the array into a vector of scalars, vectors or matrices. The array
+  /// must be contiguous. Vectors and matrices are read from the trailing
+  /// dimensions.
+  template<data::known_type_of Val>
+  auto values() const -> std::vector<Val> {
+    constexpr auto val_type = data::type_of<Val>;
+    if (kind() != val_type.kind()) {
+      raise_type_error("expected array of '{}', got '{}'",
+                       val_type.kind().name(),
+                       kind().name());
+    }
+    if (rank() == 0 ||
+        !std::ranges::equal(shape(), value_shape_<Val>(shape().front()))) {
+      raise_type_error("array shape does not match '{}'", val_type.name());
+    }
+    const auto num_vals = shape().front();
+    std::vector<Val> result(num_vals);
+    if constexpr (val_type.rank() == data::DataRank::scalar) {
+      const auto out = std::as_writable_bytes(std::span{result});
+      std::ranges::copy(bytes(), out.begin());
+    } else {
+      auto in = bytes().begin();
+      for (auto& val : result) {
+        for_each_num_(val, [&in](auto& num) {
+          const auto out = std::as_writable_bytes(std::span{&num, 1});
+          in = std::ranges::copy_n(in, out.size(), out.begin()).in;
+        });
+      }
+    }
+    return result;
   }
 
   /// Get pointer to the object as `PyArrayObject*`.
@@ -60,6 +200,9 @@ public:
   /// Get the array data kind.
   auto kind() const -> data::DataKind;
 
+  /// Get the array elements as bytes. The array must be contiguous.
+  auto bytes() const -> std::span<byte_t>;
+
   /// Get the array element at the given index.
   /// @{
   auto elem(std::span<const ssize_t> mdindex) const -> std::span<byte_t>;
@@ -84,16 +227,101 @@ public:
   void set_base(Object base) const;
   /// @}
 
+  /// Check if the array is writeable.
+  auto is_writeable() const -> bool;
+
 private:
 
   // Create a new NumPy array from a raw pointer.
   NDArray(data::DataKind kind,
           byte_t* data,
           size_t num_bytes,
-          std::span<const size_t> shape);
+          std::span<const size_t> shape,
+          std::span<const size_t> strides = {},
+          bool writeable = true);
+
+  // Strides (in bytes) of the values with the given strides (in values).
+  template<class Val, size_t Rank>
+  static constexpr auto byte_strides_(
+      const std::array<size_t, Rank>& strides) noexcept {
+    auto result = strides;
+    for (auto& stride : result) stride *= sizeof(Val);
+    return result;
+  }
+
+  // Shape of the array of the scalars, vectors or matrices.
+  template<data::known_type_of Val>
+  static auto value_shape_(size_t num_vals) {
+    constexpr auto val_type = data::type_of<Val>;
+    if constexpr (val_type.rank() == data::DataRank::scalar) {
+      return std::array{num_vals};
+    } else if constexpr (val_type.rank() == data::DataRank::vector) {
+      return std::array{num_vals, val_type.dim()};
+    } else {
+      return std::array{num_vals, val_type.dim(), val_type.dim()};
+    }
+  }
+
+  // Call the function for each component of the vector or matrix, in the
+  // row-major order.
+  template<class Val, class Func>
+  static void for_each_num_(Val& val, const Func& func) {
+    constexpr auto val_type = data::type_of<std::remove_const_t<Val>>;
+    for (size_t i = 0; i < val_type.dim(); ++i) {
+      if constexpr (val_type.rank() == data::DataRank::vector) {
+        func(val[i]);
+      } else {
+        for (size_t j = 0; j < val_type.dim(); ++j) func(val[i, j]);
+      }
+    }
+  }
+
+  // Create a NumPy array view of the vector or matrix components.
+  template<class Num, class Val, size_t Rank>
+  static auto view_(std::span<Val> vals,
+                    const std::array<size_t, Rank>& shape,
+                    const std::array<size_t, Rank>& strides,
+                    Object owner) -> NDArray {
+    using ConstNum = std::conditional_t<std::is_const_v<Val>, const Num, Num>;
+    const std::span nums{std::bit_cast<ConstNum*>(vals.data()),
+                         vals.size_bytes() / sizeof(Num)};
+    return NDArray{nums, shape, strides, std::move(owner)};
+  }
 
 }; // class NDArray
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Vector converter. Vectors are moved into NumPy arrays that own them, so
+// the values are not copied once again. Any array-like objects are extracted
+// in bulk.
+template<data::known_type_of Val>
+struct Converter<std::vector<Val>> final {
+  static auto object(std::vector<Val> vals) -> NDArray {
+    auto owned = std::make_unique<std::vector<Val>>(std::move(vals));
+    const std::span view{*owned};
+    return NDArray::view(view, Capsule{std::move(owned)});
+  }
+  static auto extract(const Object& obj) -> std::vector<Val> {
+    return NDArray::from(obj, data::type_of<Val>.kind()).values<Val>();
+  }
+};
+
+// Span converter. Values are copied into a new NumPy array, since the span
+// does not own them. Use `NDArray::view` to avoid copying.
+template<class Val>
+  requires data::known_type_of<std::remove_const_t<Val>>
+struct Converter<std::span<Val>> final {
+  static auto object(std::span<const std::remove_const_t<Val>> vals)
+      -> NDArray {
+    return NDArray::copy(vals);
+  }
+};
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::py
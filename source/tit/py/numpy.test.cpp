@@ -3,10 +3,14 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <array>
+#include <span>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/containers/mdvector.hpp"
+#include "tit/core/vec.hpp"
 
 #include "tit/data/type.hpp"
 
@@ -42,6 +46,96 @@ TEST_CASE("py::NDArray") {
       CHECK(array.elem<double>(1, 1) == 4.0);
       CHECK(py::Capsule::isinstance(array.base()));
     }
+    SUBCASE("from padded Mdvector") {
+      const std::array vals{1.0, 2.0, 3.0, 4.0};
+      const Mdvector<double, 2, CacheAlignedLayout> mdvec{vals.begin(), 2, 2};
+      const py::NDArray array{mdvec};
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), std::array{2, 2});
+      CHECK(array.elem<double>(0, 1) == 2.0);
+      CHECK(array.elem<double>(1, 0) == 3.0);
+      CHECK(array.elem<double>(1, 1) == 4.0);
+    }
+    SUBCASE("from tiled Mdvector") {
+      const std::array vals{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+      const Mdvector<double, 2, TiledLayout<4>> mdvec{vals.begin(), 3, 2};
+      const py::NDArray array{mdvec};
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), std::array{3, 2});
+      CHECK_RANGE_EQ(array.values<double>(), vals);
+    }
+    SUBCASE("uninitialized") {
+      const py::NDArray array{data::kind_of<float>,
+                              std::array<size_t, 2>{3, 2}};
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), std::array{3, 2});
+      CHECK(array.kind() == data::kind_of<float>);
+      REQUIRE(array.bytes().size() == 6 * sizeof(float));
+      std::ranges::copy(std::as_bytes(std::span{std::array{1.0F, 2.0F}}),
+                        array.bytes().begin());
+      CHECK(array.elem<float>(0, 1) == 2.0F);
+    }
+    SUBCASE("view of existing memory") {
+      std::array vals{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+      const py::List owner{};
+      const py::NDArray array{std::span{vals},
+                              std::array<size_t, 2>{3, 2},
+                              {},
+                              owner};
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), std::array{3, 2});
+      CHECK(array.is_writeable());
+      CHECK(array.base().is(owner));
+      CHECK(array.elem<double>(2, 1) == 6.0);
+      array[0, 1] = py::Float{7.0};
+      CHECK(vals[1] == 7.0);
+    }
+    SUBCASE("view of vectors") {
+      const std::array vals{Vec{1.0, 2.0, 3.0}, Vec{4.0, 5.0, 6.0}};
+      const auto array = py::NDArray::view(std::span{vals}, py::None());
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), std::array{2, 3});
+      CHECK_FALSE(array.is_writeable());
+      CHECK(array.elem<double>(0, 2) == 3.0);
+      CHECK(array.elem<double>(1, 0) == 4.0);
+      CHECK(array.elem<double>(1, 2) == 6.0);
+    }
+  }
+  SUBCASE("copy") {
+    const std::array vals{Vec{1.0, 2.0}, Vec{3.0, 4.0}, Vec{5.0, 6.0}};
+    const auto array = py::NDArray::copy(std::span{vals});
+    REQUIRE(array.rank() == 2);
+    REQUIRE_RANGE_EQ(array.shape(), std::array{3, 2});
+    CHECK(array.is_writeable());
+    CHECK(array.elem<double>(0, 1) == 2.0);
+    CHECK(array.elem<double>(2, 0) == 5.0);
+    const auto eq = [](const auto& a, const auto& b) { return all(a == b); };
+    CHECK_RANGE_EQ(array.values<Vec<double, 2>>(), vals, eq);
+  }
+  SUBCASE("from array-like") {
+    SUBCASE("array of the same kind") {
+      const py::NDArray array{Mdvector{std::array{1.0, 2.0}.begin(), 2}};
+      CHECK(py::NDArray::from(array, data::kind_of<double>).is(array));
+    }
+    SUBCASE("sequence") {
+      const auto array = py::NDArray::from(py::make_list(1, 2, 3),
+                                           data::kind_of<float>);
+      CHECK(array.kind() == data::kind_of<float>);
+      CHECK_RANGE_EQ(array.values<float>(), std::array{1.0F, 2.0F, 3.0F});
+    }
+    SUBCASE("invalid") {
+      CHECK_THROWS_MSG(
+          py::NDArray::from(py::make_list(1.5), data::kind_of<int>),
+          py::ErrorException,
+          "TypeError");
+      const py::NDArray array{Mdvector{std::array{1, 2, 3, 4}.begin(), 2, 2}};
+      CHECK_THROWS_MSG(static_cast<void>(array.values<int>()),
+                       py::ErrorException,
+                       "TypeError: array shape does not match 'int32_t'");
+      CHECK_THROWS_MSG(static_cast<void>(array.values<float>()),
+                       py::ErrorException,
+                       "TypeError: expected array of 'float32_t'");
+    }
   }
   SUBCASE("data access") {
     const std::array vals{1, 2, 3, 4, 5, 6, 7, 8};
@@ -128,6 +222,36 @@ TEST_CASE("py::NDArray") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("py::impl::Converter<std::vector>") {
+  SUBCASE("object") {
+    const auto obj = py::object(std::vector{Vec{1.0F, 2.0F}, Vec{3.0F, 4.0F}});
+    const auto array = py::expect<py::NDArray>(obj);
+    REQUIRE_RANGE_EQ(array.shape(), std::array{2, 2});
+    CHECK(array.elem<float>(1, 0) == 3.0F);
+    CHECK(py::Capsule::isinstance(array.base()));
+  }
+  SUBCASE("extract") {
+    REQUIRE(testing::interpreter().exec(R"PY(
+      import numpy as np
+      ints = [1, 2, 3]
+      view = memoryview(np.array([1.0, 2.0, 3.0, 4.0]))
+      points = np.array([[1.0, 2.0], [3.0, 4.0]])[:, ::-1]
+    )PY"));
+    const auto& globals = testing::interpreter().globals();
+    CHECK_RANGE_EQ(py::extract<std::vector<int>>(globals["ints"]),
+                   std::array{1, 2, 3});
+    CHECK_RANGE_EQ(py::extract<std::vector<double>>(globals["view"]),
+                   std::array{1.0, 2.0, 3.0, 4.0});
+    const auto eq = [](const auto& a, const auto& b) { return all(a == b); };
+    CHECK_RANGE_EQ(
+        py::extract<std::vector<Vec<double, 2>>>(globals["points"]),
+        std::array{Vec{2.0, 1.0}, Vec{4.0, 3.0}},
+        eq);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("NDArrays from Python") {
   REQUIRE(testing::interpreter().exec(R"PY(
     import numpy as np
@@ -0,0 +1,65 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <ranges>
+#include <span>
+#include <string>
+#include <type_traits>
+
+#include "tit/data/type.hpp"
+
+#include "tit/py/mapping.hpp"
+#include "tit/py/numpy.hpp"
+#include "tit/py/object.hpp"
+
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::py {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Particle field values that are stored in a separate array.
+template<class Values>
+concept column_values =
+    std::ranges::contiguous_range<Values> &&
+    std::ranges::sized_range<Values> &&
+    data::known_type_of<std::ranges::range_value_t<Values>>;
+
+} // namespace impl
+
+/// Expose the varying particle fields as NumPy arrays, without copying.
+///
+/// Only the fields that are stored in separate arrays are exposed, the fields
+/// stored in tiles are skipped. Arrays are read-only if the particle array is
+/// const.
+///
+/// @param particles Particle array.
+/// @param owner     Object that keeps the particle array alive while the
+///                  NumPy arrays exist.
+///
+/// @note Arrays are invalidated once the particles are appended or removed.
+///
+/// @returns Dictionary that maps the field names to the NumPy arrays.
+template<class ParticleArray>
+  requires sph::particle_array<ParticleArray>
+auto particle_fields(ParticleArray& particles, const Object& owner) -> Dict {
+  const Dict result;
+  std::remove_const_t<ParticleArray>::varying_fields.for_each(
+      [&particles, &owner, &result](auto field) {
+        if constexpr (impl::column_values<decltype(field[particles])>) {
+          result[std::string{field.field_name}] =
+              NDArray::view(std::span{field[particles]}, owner);
+        }
+      });
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::py
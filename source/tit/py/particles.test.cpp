@@ -0,0 +1,67 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/py/mapping.hpp"
+#include "tit/py/numpy.hpp"
+#include "tit/py/object.hpp"
+#include "tit/py/particles.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/py/interpreter.testing.hpp"
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the varying position and density fields.
+using DensityEquations = EquationsStub<meta::Set{sph::r, sph::rho}>;
+
+TEST_CASE("py::particle_fields") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, DensityEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 3)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 1.0};
+    sph::rho[a] = 1000.0;
+  }
+
+  const auto fields = py::particle_fields(particles, py::None());
+  const auto r = py::expect<py::NDArray>(fields["r"]);
+  REQUIRE_RANGE_EQ(r.shape(), std::array{3, 2});
+  CHECK(r.elem<double>(2, 0) == 2.0);
+  CHECK(r.elem<double>(2, 1) == 1.0);
+  const auto rho = py::expect<py::NDArray>(fields["rho"]);
+  REQUIRE_RANGE_EQ(rho.shape(), std::array{3});
+  CHECK(rho.is_writeable());
+
+  // Modify the particle fields from Python.
+  testing::interpreter().globals()["fields"] = fields;
+  REQUIRE(testing::interpreter().exec(R"PY(
+    fields["rho"][1] = 999.0
+    fields["r"][:, 1] *= 2.0
+  )PY"));
+  CHECK(sph::rho[particles[1]] == 999.0);
+  CHECK(sph::r[particles[0]][1] == 2.0);
+  CHECK(sph::r[particles[2]][1] == 2.0);
+
+  // Views of the const particle array are read-only.
+  const auto& const_particles = particles;
+  const auto const_fields = py::particle_fields(const_particles, py::None());
+  CHECK_FALSE(py::expect<py::NDArray>(const_fields["rho"]).is_writeable());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,136 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
+
+#include "tit/sparse/operator.hpp"
+
+namespace tit::sparse {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Dot product of the sparse row with the dense vector. Vector entries are
+// gathered into the registers, and the row values are loaded as is.
+template<class Num, std::unsigned_integral Index>
+auto row_dot(std::span<const Num> vals,
+             std::span<const Index> cols,
+             std::span<const Num> x) noexcept -> Num {
+  Num result{};
+  size_t k = 0;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    constexpr auto Size = simd::max_reg_size_v<Num>;
+    using Reg = simd::Reg<Num, Size>;
+    Reg acc{};
+    std::array<Num, Size> gathered{};
+    for (; k + Size <= cols.size(); k += Size) {
+      for (size_t l = 0; l < Size; ++l) gathered[l] = x[cols[k + l]];
+      acc = simd::fma(Reg(vals.subspan(k, Size)), Reg(gathered), acc);
+    }
+    result = simd::sum(acc);
+  }
+  for (; k < cols.size(); ++k) result += vals[k] * x[cols[k]];
+  return result;
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Sparse square matrix in the modified compressed sparse row format.
+///
+/// Column indices of the off-diagonal entries are taken from the sparsity
+/// pattern, which has the same layout as the `Multivector`, e.g. the graph
+/// adjacency. Values are stored in the same order as the pattern values,
+/// so that the matrix row is iterated along with the pattern row. Diagonal
+/// entries are stored separately, since the pattern rows do not necessarily
+/// contain the rows themselves. Pattern must outlive the matrix.
+template<class Num, std::unsigned_integral Index = size_t>
+class Matrix final {
+public:
+
+  /// Number type.
+  using num_type = Num;
+
+  /// Construct a zero matrix with the given sparsity pattern.
+  explicit Matrix(const Multivector<Index>& pattern)
+      : pattern_{&pattern}, diag_(pattern.size()),
+        vals_(pattern.values().size()) {}
+
+  /// Sparsity pattern.
+  auto pattern() const noexcept -> const Multivector<Index>& {
+    return *pattern_;
+  }
+
+  /// Number of matrix rows.
+  auto num_rows() const noexcept -> size_t {
+    return diag_.size();
+  }
+
+  /// Diagonal entries.
+  auto diag(this auto& self) noexcept {
+    return std::span{self.diag_};
+  }
+
+  /// Diagonal entry of the row.
+  auto diag(this auto& self, size_t row) noexcept -> auto& {
+    TIT_ASSERT(row < self.num_rows(), "Row index is out of range!");
+    return self.diag_[row];
+  }
+
+  /// Column indices of the off-diagonal entries of the row.
+  auto cols(size_t row) const noexcept -> std::span<const Index> {
+    TIT_ASSERT(row < num_rows(), "Row index is out of range!");
+    return (*pattern_)[row];
+  }
+
+  /// Off-diagonal entries of the row, ordered as the row column indices.
+  auto row(this auto& self, size_t row) noexcept {
+    const auto cols = self.cols(row);
+    const auto offset =
+        static_cast<size_t>(cols.data() - self.pattern_->values().data());
+    return std::span{self.vals_}.subspan(offset, cols.size());
+  }
+
+  /// Compute the matrix-vector product `y = A * x` in parallel. Rows are
+  /// multiplied on the SIMD registers, if possible.
+  void multiply(std::span<const Num> x, std::span<Num> y) const {
+    TIT_PROFILE_SECTION("sparse::Matrix::multiply()");
+    TIT_ASSERT(x.size() == num_rows(), "Vector size must match the matrix!");
+    TIT_ASSERT(y.size() == num_rows(), "Vector size must match the matrix!");
+    par::for_each(std::views::iota(size_t{0}, num_rows()),
+                  [&x, &y, this](size_t i) {
+                    const auto off_diag =
+                        impl::row_dot<Num, Index>(row(i), cols(i), x);
+                    y[i] = diag_[i] * x[i] + off_diag;
+                  });
+  }
+
+private:
+
+  const Multivector<Index>* pattern_;
+  std::vector<Num> diag_;
+  std::vector<Num> vals_;
+
+}; // class Matrix
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sparse
@@ -0,0 +1,86 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/sparse/matrix.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sparse::Matrix") {
+  const Multivector<size_t> pattern{{1}, {0, 2}, {1}};
+  sparse::Matrix<double> matrix{pattern};
+  REQUIRE(matrix.num_rows() == 3);
+  SUBCASE("zero") {
+    // Ensure the matrix is zero-initialized.
+    CHECK_RANGE_EQ(matrix.diag(), std::vector{0.0, 0.0, 0.0});
+    CHECK_RANGE_EQ(matrix.row(1), std::vector{0.0, 0.0});
+  }
+  SUBCASE("rows") {
+    // Ensure the rows are aligned with the pattern.
+    matrix.diag(1) = 3.0;
+    matrix.row(1)[0] = 1.0;
+    matrix.row(1)[1] = 2.0;
+    CHECK(matrix.diag(1) == 3.0);
+    CHECK_RANGE_EQ(matrix.cols(1), std::vector<size_t>{0, 2});
+    CHECK_RANGE_EQ(matrix.row(0), std::vector{0.0});
+    CHECK_RANGE_EQ(matrix.row(1), std::vector{1.0, 2.0});
+    CHECK_RANGE_EQ(matrix.row(2), std::vector{0.0});
+  }
+}
+
+TEST_CASE("sparse::Matrix::multiply") {
+  par::set_num_threads(4);
+  SUBCASE("tridiagonal") {
+    const Multivector<size_t> pattern{{1}, {0, 2}, {1, 3}, {2}};
+    sparse::Matrix<double> matrix{pattern};
+    for (size_t i = 0; i < matrix.num_rows(); ++i) {
+      matrix.diag(i) = 2.0;
+      std::ranges::fill(matrix.row(i), -1.0);
+    }
+    const std::vector x{1.0, 2.0, 4.0, 8.0};
+    std::vector<double> y(x.size());
+    matrix.multiply(x, y);
+    CHECK_RANGE_EQ(y, std::vector{0.0, -1.0, -2.0, 12.0});
+  }
+  SUBCASE("dense") {
+    // Ensure the long rows, that are multiplied on the SIMD registers with
+    // the scalar remainder, are handled correctly.
+    constexpr size_t n = 37;
+    Multivector<size_t> pattern{};
+    for (size_t i = 0; i < n; ++i) {
+      pattern.append_bucket(std::views::iota(size_t{0}, n) |
+                            std::views::filter([i](size_t j) {
+                              return j != i;
+                            }));
+    }
+    sparse::Matrix<double> matrix{pattern};
+    for (size_t i = 0; i < n; ++i) {
+      matrix.diag(i) = 1.0;
+      std::ranges::fill(matrix.row(i), 1.0);
+    }
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = static_cast<double>(i);
+    std::vector<double> y(n);
+    matrix.multiply(x, y);
+    CHECK_RANGE_EQ(y, std::vector(n, static_cast<double>(n * (n - 1) / 2)));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
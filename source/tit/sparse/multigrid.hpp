@@ -0,0 +1,360 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <deque>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/grid.hpp"
+#include "tit/geom/point_range.hpp"
+
+#include "tit/sparse/matrix.hpp"
+
+namespace tit::sparse {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Geometric multigrid preconditioner on the background grid hierarchy.
+///
+/// Rows of the matrix are associated with the points, e.g. the particles.
+/// The first coarse level aggregates the points binned into the cells of the
+/// uniform grid, and each next level aggregates the 2^Dim blocks of the cells
+/// of the previous level. Transfer operators are piecewise constant and are
+/// applied matrix-free, using the cell aggregates. Coarse operators are the
+/// Galerkin products `R * A * P`, so the preconditioner is suitable for the
+/// matrices that have no natural grid stencil, such as the particle
+/// Laplacians.
+///
+/// Preconditioner applies a single V-cycle with the damped Jacobi smoother,
+/// the same number of the pre- and post-smoothing sweeps, and the
+/// over-relaxed coarse correction. The cycle is symmetric, so it can be used
+/// with the conjugate gradient solver. Matrix must outlive the
+/// preconditioner. Each level keeps its own work vectors, so the
+/// preconditioner must not be applied concurrently.
+template<class Num, std::unsigned_integral Index = size_t>
+class MultigridPreconditioner final {
+public:
+
+  /// Build the grid hierarchy for the matrix.
+  ///
+  /// @param matrix     Fine level matrix.
+  /// @param points     Points associated with the matrix rows.
+  /// @param size_hint  Cell size hint of the first coarse level, typically
+  ///                   the kernel support width.
+  /// @param max_levels Maximal number of levels, including the fine one.
+  /// @param num_sweeps Number of the pre- and post-smoothing sweeps.
+  template<geom::point_range Points>
+  MultigridPreconditioner(const Matrix<Num, Index>& matrix,
+                          Points&& points,
+                          vec_num_t<geom::point_range_vec_t<Points>> size_hint,
+                          size_t max_levels = 10,
+                          size_t num_sweeps = 2)
+      : fine_{&matrix}, num_sweeps_{num_sweeps} {
+    TIT_PROFILE_SECTION("sparse::MultigridPreconditioner::build()");
+    TIT_ASSERT(std::size(points) == matrix.num_rows(),
+               "Number of points must match the matrix!");
+    TIT_ASSERT(size_hint > 0, "Cell size hint must be positive!");
+    TIT_ASSERT(max_levels > 0, "Number of levels must be positive!");
+    TIT_ASSERT(num_sweeps_ > 0, "Number of sweeps must be positive!");
+    fine_inv_diag_ = inverse_diag_(matrix);
+    work_.emplace_back(matrix.num_rows());
+    if (max_levels == 1 || matrix.num_rows() <= coarsest_size_) return;
+
+    // Bin the points into the cells of the first coarse level. Bounding box
+    // is grown by half of the cell, so that all the points are inside.
+    using Vec = geom::point_range_vec_t<Points>;
+    const auto box = geom::compute_bbox(points).grow(size_hint / 2);
+    const auto grid = geom::Grid{box}.set_cell_extents(size_hint);
+    using VecIndex = typename geom::Grid<Vec>::VecIndex;
+    std::vector<VecIndex> cells(matrix.num_rows());
+    par::for_each(std::views::iota(size_t{0}, cells.size()),
+                  [&points, &grid, &cells](size_t i) {
+                    cells[i] = grid.cell_index(std::begin(points)[i]);
+                  });
+
+    // Build the levels, each time merging the blocks of the cells, until the
+    // level is small enough or the cells stop merging.
+    auto num_cells = grid.num_cells();
+    for (size_t scale = 1; levels_.size() + 1 < max_levels; scale = 2) {
+      const auto num_rows = work_.back().residual.size();
+      if (num_rows <= coarsest_size_) break;
+      num_cells = (num_cells + VecIndex(scale - 1)) / scale;
+      const geom::Grid<Vec> level_grid{box, num_cells};
+      std::vector<size_t> parents(num_rows);
+      std::vector<VecIndex> coarse_cells{};
+      const auto num_coarse_rows =
+          number_cells_(level_grid, scale, cells, parents, coarse_cells);
+      if (num_coarse_rows == num_rows) {
+        if (scale != 1) break;
+        continue; // Points are already one per cell, keep merging.
+      }
+      auto& level = levels_.emplace_back(std::move(parents), num_coarse_rows);
+      if (levels_.size() == 1) contract_(matrix, level);
+      else contract_(levels_[levels_.size() - 2].matrix, level);
+      level.inv_diag = inverse_diag_(level.matrix);
+      work_.emplace_back(num_coarse_rows);
+      cells = std::move(coarse_cells);
+    }
+  }
+
+  /// Number of levels, including the fine one.
+  auto num_levels() const noexcept -> size_t {
+    return work_.size();
+  }
+
+  /// Number of rows on the level.
+  auto level_size(size_t level) const noexcept -> size_t {
+    TIT_ASSERT(level < num_levels(), "Level index is out of range!");
+    return work_[level].residual.size();
+  }
+
+  /// Apply the preconditioner, `z = M⁻¹ * r`.
+  void apply(std::span<const Num> r, std::span<Num> z) const {
+    TIT_PROFILE_SECTION("sparse::MultigridPreconditioner::apply()");
+    TIT_ASSERT(r.size() == fine_->num_rows(), "Vector size must match!");
+    TIT_ASSERT(z.size() == fine_->num_rows(), "Vector size must match!");
+    cycle_(0, r, z);
+  }
+
+private:
+
+  // Coarse level of the hierarchy.
+  struct Level_ {
+    Level_(std::vector<size_t> parents_, size_t num_rows)
+        : parents{std::move(parents_)} {
+      // Members are numbered sequentially, so that the restricted sums do
+      // not depend on the thread scheduling.
+      members.assign_pairs_seq(
+          num_rows,
+          std::views::iota(size_t{0}, parents.size()) |
+              std::views::transform([this](size_t row) {
+                return std::pair{parents[row], row};
+              }));
+    }
+
+    // Coarse operator refers to the pattern, so the level is pinned.
+    Level_(const Level_&) = delete;
+    Level_(Level_&&) = delete;
+    auto operator=(const Level_&) -> Level_& = delete;
+    auto operator=(Level_&&) -> Level_& = delete;
+    ~Level_() = default;
+
+    std::vector<size_t> parents;  // Coarse rows of the finer level rows.
+    Multivector<size_t> members;  // Finer level rows of the coarse rows.
+    Multivector<size_t> pattern;  // Coarse operator sparsity pattern.
+    Matrix<Num, size_t> matrix{pattern};
+    std::vector<Num> inv_diag;
+  };
+
+  // Work vectors of the level.
+  struct Work_ {
+    explicit Work_(size_t num_rows)
+        : rhs(num_rows), solution(num_rows), residual(num_rows) {}
+
+    std::vector<Num> rhs;
+    std::vector<Num> solution;
+    std::vector<Num> residual;
+  };
+
+  // Levels smaller than this are not coarsened further.
+  static constexpr size_t coarsest_size_ = 32;
+
+  // Number of the Jacobi sweeps on the coarsest level, per smoothing sweep.
+  static constexpr size_t coarsest_factor_ = 8;
+
+  // Jacobi smoother damping factor.
+  static constexpr auto omega_ = static_cast<Num>(2.0 / 3.0);
+
+  // Coarse correction scaling factor. Piecewise constant prolongation
+  // underestimates the smooth error, so the correction is over-relaxed.
+  static constexpr auto alpha_ = static_cast<Num>(1.8);
+
+  // Compute the inverse diagonal of the matrix.
+  template<std::unsigned_integral MatIndex>
+  static auto inverse_diag_(const Matrix<Num, MatIndex>& matrix)
+      -> std::vector<Num> {
+    std::vector<Num> inv_diag(matrix.num_rows());
+    par::transform(matrix.diag(), inv_diag.begin(), [](Num d) {
+      return is_tiny(d) ? Num{1} : inverse(d);
+    });
+    return inv_diag;
+  }
+
+  // Number the non-empty cells of the level in the order of appearance.
+  template<class Grid, class VecIndex>
+  static auto number_cells_(const Grid& level_grid,
+                            size_t scale,
+                            const std::vector<VecIndex>& cells,
+                            std::vector<size_t>& parents,
+                            std::vector<VecIndex>& coarse_cells) -> size_t {
+    static constexpr auto npos = std::numeric_limits<size_t>::max();
+    std::vector<size_t> cell_rows(level_grid.flat_num_cells(), npos);
+    for (size_t row = 0; row < cells.size(); ++row) {
+      const auto cell = cells[row] / scale;
+      auto& cell_row = cell_rows[level_grid.flatten_cell_index(cell)];
+      if (cell_row == npos) {
+        cell_row = coarse_cells.size();
+        coarse_cells.push_back(cell);
+      }
+      parents[row] = cell_row;
+    }
+    return coarse_cells.size();
+  }
+
+  // Compute the coarse operator of the level from the finer level operator.
+  template<std::unsigned_integral MatIndex>
+  static void contract_(const Matrix<Num, MatIndex>& fine, Level_& level) {
+    const auto& parents = level.parents;
+    const auto& members = level.members;
+    const auto num_rows = members.size();
+
+    // Merge the finer rows, summing the entries within the coarse rows into
+    // the diagonal, and summing the entries of the parallel edges.
+    std::vector<Num> diag(num_rows);
+    std::vector<std::vector<std::tuple<size_t, Num>>> buckets(num_rows);
+    par::for_each(
+        std::views::iota(size_t{0}, num_rows),
+        [&fine, &parents, &members, &diag, &buckets](size_t coarse_row) {
+          auto& bucket = buckets[coarse_row];
+          Num coarse_diag{};
+          for (const auto row : members[coarse_row]) {
+            coarse_diag += fine.diag(row);
+            const auto cols = fine.cols(row);
+            const auto vals = fine.row(row);
+            for (size_t k = 0; k < cols.size(); ++k) {
+              const auto coarse_col = parents[cols[k]];
+              if (coarse_col == coarse_row) coarse_diag += vals[k];
+              else bucket.emplace_back(coarse_col, vals[k]);
+            }
+          }
+          diag[coarse_row] = coarse_diag;
+
+          std::ranges::sort(bucket);
+          auto out = bucket.begin();
+          for (auto iter = bucket.begin(); iter != bucket.end();) {
+            auto [col, val] = *iter;
+            for (++iter; iter != bucket.end() && std::get<0>(*iter) == col;
+                 ++iter) {
+              val += std::get<1>(*iter);
+            }
+            *out++ = {col, val};
+          }
+          bucket.erase(out, bucket.end());
+        });
+
+    // Assemble the coarse operator.
+    level.pattern.assign_buckets_par(
+        buckets | std::views::transform([](const auto& bucket) {
+          return bucket | std::views::keys;
+        }));
+    level.matrix = Matrix<Num, size_t>{level.pattern};
+    par::for_each(std::views::iota(size_t{0}, num_rows),
+                  [&level, &diag, &buckets](size_t coarse_row) {
+                    level.matrix.diag(coarse_row) = diag[coarse_row];
+                    std::ranges::copy(buckets[coarse_row] | std::views::values,
+                                      level.matrix.row(coarse_row).begin());
+                  });
+  }
+
+  // Run the damped Jacobi sweeps, `x += ω D⁻¹ (b - A x)`.
+  template<std::unsigned_integral MatIndex>
+  static void smooth_(const Matrix<Num, MatIndex>& A,
+                      const std::vector<Num>& inv_diag,
+                      std::span<const Num> b,
+                      std::span<Num> x,
+                      std::span<Num> t,
+                      size_t num_sweeps) {
+    for (size_t sweep = 0; sweep < num_sweeps; ++sweep) {
+      A.multiply(x, t);
+      par::for_each(std::views::iota(size_t{0}, x.size()),
+                    [&inv_diag, &b, &x, &t](size_t i) {
+                      x[i] += omega_ * inv_diag[i] * (b[i] - t[i]);
+                    });
+    }
+  }
+
+  // Approximately solve `A x = b` on the level with the V-cycle.
+  void cycle_(size_t level, std::span<const Num> b, std::span<Num> x) const {
+    std::ranges::fill(x, Num{0});
+    auto& work = work_[level];
+    const auto smooth = [level, b, x, &work, this](size_t num_sweeps) {
+      if (level == 0) {
+        smooth_(*fine_, fine_inv_diag_, b, x, work.residual, num_sweeps);
+      } else {
+        const auto& coarse = levels_[level - 1];
+        smooth_(coarse.matrix,
+                coarse.inv_diag,
+                b,
+                x,
+                work.residual,
+                num_sweeps);
+      }
+    };
+
+    // Solve approximately on the coarsest level.
+    if (level + 1 == num_levels()) {
+      smooth(coarsest_factor_ * num_sweeps_);
+      return;
+    }
+
+    // Pre-smooth and compute the residual.
+    smooth(num_sweeps_);
+    auto& residual = work.residual;
+    if (level == 0) fine_->multiply(x, residual);
+    else levels_[level - 1].matrix.multiply(x, residual);
+    par::for_each(std::views::iota(size_t{0}, x.size()),
+                  [b, &residual](size_t i) {
+                    residual[i] = b[i] - residual[i];
+                  });
+
+    // Restrict the residual, correct on the coarse level and prolongate.
+    const auto& coarse = levels_[level];
+    auto& coarse_work = work_[level + 1];
+    par::for_each(std::views::iota(size_t{0}, coarse.members.size()),
+                  [&coarse, &coarse_work, &residual](size_t coarse_row) {
+                    Num sum{};
+                    for (const auto row : coarse.members[coarse_row]) {
+                      sum += residual[row];
+                    }
+                    coarse_work.rhs[coarse_row] = sum;
+                  });
+    cycle_(level + 1, coarse_work.rhs, coarse_work.solution);
+    const auto& correction = coarse_work.solution;
+    par::for_each(std::views::iota(size_t{0}, x.size()),
+                  [&coarse, &correction, x](size_t row) {
+                    x[row] += alpha_ * correction[coarse.parents[row]];
+                  });
+
+    // Post-smooth.
+    smooth(num_sweeps_);
+  }
+
+  const Matrix<Num, Index>* fine_;
+  size_t num_sweeps_;
+  std::vector<Num> fine_inv_diag_;
+  std::deque<Level_> levels_;
+  mutable std::deque<Work_> work_;
+
+}; // class MultigridPreconditioner
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sparse
@@ -0,0 +1,106 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sparse/matrix.hpp"
+#include "tit/sparse/multigrid.hpp"
+#include "tit/sparse/preconditioner.hpp"
+#include "tit/sparse/solver.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// 2D Poisson equation with the Dirichlet boundary conditions on the uniform
+// lattice with the unit spacing.
+struct Poisson2D {
+  explicit Poisson2D(size_t n) {
+    const auto index = [n](size_t i, size_t j) { return i * n + j; };
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        std::vector<size_t> cols{};
+        if (i > 0) cols.push_back(index(i - 1, j));
+        if (j > 0) cols.push_back(index(i, j - 1));
+        if (j + 1 < n) cols.push_back(index(i, j + 1));
+        if (i + 1 < n) cols.push_back(index(i + 1, j));
+        pattern.append_bucket(cols);
+        points.emplace_back(static_cast<double>(i) + 0.5,
+                            static_cast<double>(j) + 0.5);
+      }
+    }
+    matrix = sparse::Matrix<double>{pattern};
+    for (size_t row = 0; row < matrix.num_rows(); ++row) {
+      matrix.diag(row) = 4.0;
+      std::ranges::fill(matrix.row(row), -1.0);
+    }
+  }
+
+  Multivector<size_t> pattern;
+  std::vector<Vec<double, 2>> points;
+  sparse::Matrix<double> matrix{pattern};
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sparse::MultigridPreconditioner") {
+  par::set_num_threads(4);
+  constexpr size_t n = 64;
+  const Poisson2D problem{n};
+  const auto& A = problem.matrix;
+  SUBCASE("levels") {
+    // Ensure the 2x2 blocks of cells are merged on each level, until the
+    // level is small enough.
+    const sparse::MultigridPreconditioner precond{A, problem.points, 1.0};
+    REQUIRE(precond.num_levels() == 5);
+    CHECK(precond.level_size(0) == 4096);
+    CHECK(precond.level_size(1) == 1024);
+    CHECK(precond.level_size(2) == 256);
+    CHECK(precond.level_size(3) == 64);
+    CHECK(precond.level_size(4) == 16);
+  }
+  SUBCASE("max levels") {
+    // Ensure the number of levels is limited.
+    const sparse::MultigridPreconditioner precond{A,
+                                                  problem.points,
+                                                  1.0,
+                                                  /*max_levels=*/2};
+    REQUIRE(precond.num_levels() == 2);
+    CHECK(precond.level_size(1) == 1024);
+  }
+  SUBCASE("solve") {
+    // Ensure the preconditioned solver converges much faster than the
+    // Jacobi-preconditioned one.
+    constexpr sparse::ConjugateGradientSolver solver{/*tolerance=*/1.0e-8};
+    const std::vector b(n * n, 1.0);
+    std::vector<double> x_jacobi(n * n);
+    const auto result_jacobi =
+        solver(A, b, x_jacobi, sparse::JacobiPreconditioner{A});
+    REQUIRE(result_jacobi.converged);
+    std::vector<double> x(n * n);
+    const auto result = solver(
+        A,
+        b,
+        x,
+        sparse::MultigridPreconditioner{A, problem.points, 1.0});
+    REQUIRE(result.converged);
+    CHECK(2 * result.num_iterations < result_jacobi.num_iterations);
+    CHECK_RANGE_EQ(x, x_jacobi, [](double a, double b) {
+      return abs(a - b) <= 1.0e-4 * abs(b);
+    });
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,77 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <functional>
+#include <span>
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+
+namespace tit::sparse {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Number type of the linear operator.
+template<class Op>
+using operator_num_t = typename Op::num_type;
+
+/// Square linear operator, that computes `y = A * x`.
+template<class Op>
+concept linear_operator =
+    requires { typename operator_num_t<Op>; } &&
+    requires(const Op& op,
+             std::span<const operator_num_t<Op>> x,
+             std::span<operator_num_t<Op>> y) {
+      { op.num_rows() } -> std::convertible_to<size_t>;
+      op.multiply(x, y);
+    };
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Matrix-free linear operator, defined by the product function.
+///
+/// Product function is called as `func(x, y)`, and must compute `y = A * x`.
+/// It allows the solvers to be used without assembling the matrix, e.g. with
+/// the operators evaluated over the particle pairs.
+template<class Num, std::invocable<std::span<const Num>, std::span<Num>> Func>
+class FuncOperator final {
+public:
+
+  /// Number type.
+  using num_type = Num;
+
+  /// Construct a matrix-free linear operator.
+  ///
+  /// @param num_rows Number of the operator rows.
+  /// @param func     Product function.
+  constexpr FuncOperator(size_t num_rows, Func func) noexcept
+      : num_rows_{num_rows}, func_{std::move(func)} {}
+
+  /// Number of the operator rows.
+  constexpr auto num_rows() const noexcept -> size_t {
+    return num_rows_;
+  }
+
+  /// Compute the product `y = A * x`.
+  void multiply(std::span<const Num> x, std::span<Num> y) const {
+    TIT_ASSERT(x.size() == num_rows_, "Vector size must match the operator!");
+    TIT_ASSERT(y.size() == num_rows_, "Vector size must match the operator!");
+    std::invoke(func_, x, y);
+  }
+
+private:
+
+  size_t num_rows_;
+  Func func_;
+
+}; // class FuncOperator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sparse
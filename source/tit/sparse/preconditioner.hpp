@@ -0,0 +1,83 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+
+#include "tit/sparse/matrix.hpp"
+
+namespace tit::sparse {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Preconditioner, that approximately solves `M * z = r`.
+template<class Precond, class Num>
+concept preconditioner =
+    requires(const Precond& precond, std::span<const Num> r, std::span<Num> z) {
+      precond.apply(r, z);
+    };
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Identity preconditioner, i.e. no preconditioning.
+class IdentityPreconditioner final {
+public:
+
+  /// Apply the preconditioner, `z = r`.
+  template<class Num>
+  static void apply(std::span<const Num> r, std::span<Num> z) {
+    TIT_ASSERT(r.size() == z.size(), "Vector sizes must match!");
+    par::transform(r, z.begin(), std::identity{});
+  }
+
+}; // class IdentityPreconditioner
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Jacobi (diagonal) preconditioner.
+template<class Num>
+class JacobiPreconditioner final {
+public:
+
+  /// Construct a Jacobi preconditioner from the diagonal of the operator.
+  /// Rows with the (almost) zero diagonal entries are not scaled.
+  explicit JacobiPreconditioner(std::span<const Num> diag)
+      : inv_diag_(diag.size()) {
+    par::transform(diag, inv_diag_.begin(), [](Num d) {
+      return is_tiny(d) ? Num{1} : inverse(d);
+    });
+  }
+
+  /// Construct a Jacobi preconditioner for the matrix.
+  template<std::unsigned_integral Index>
+  explicit JacobiPreconditioner(const Matrix<Num, Index>& matrix)
+      : JacobiPreconditioner{std::span<const Num>{matrix.diag()}} {}
+
+  /// Apply the preconditioner, `z = D⁻¹ * r`.
+  void apply(std::span<const Num> r, std::span<Num> z) const {
+    TIT_ASSERT(r.size() == inv_diag_.size(), "Vector size must match!");
+    TIT_ASSERT(z.size() == inv_diag_.size(), "Vector size must match!");
+    par::for_each(std::views::iota(size_t{0}, inv_diag_.size()),
+                  [&r, &z, this](size_t i) { z[i] = inv_diag_[i] * r[i]; });
+  }
+
+private:
+
+  std::vector<Num> inv_diag_;
+
+}; // class JacobiPreconditioner
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sparse
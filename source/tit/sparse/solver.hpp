@@ -0,0 +1,400 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+
+#include "tit/sparse/operator.hpp"
+#include "tit/sparse/preconditioner.hpp"
+
+namespace tit::sparse {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Result of the iterative linear solver.
+struct SolverResult final {
+  size_t num_iterations = 0; ///< Number of the performed iterations.
+  float64_t residual = 0.0;  ///< Relative residual norm of the solution.
+  bool converged = false;    ///< Was the tolerance reached?
+};
+
+namespace impl {
+
+// Dot product of the vectors. Deterministic parallel reduction is used, so
+// that the result does not depend on the number of threads.
+template<class Num>
+auto dot(std::span<const Num> u, std::span<const Num> w) -> Num {
+  TIT_ASSERT(u.size() == w.size(), "Vector sizes must match!");
+  return par::transform_reduce(std::views::iota(size_t{0}, u.size()),
+                               Num{0},
+                               std::plus{},
+                               [&u, &w](size_t i) { return u[i] * w[i]; });
+}
+
+// Euclidean norm of the vector.
+template<class Num>
+auto norm(std::span<const Num> u) -> Num {
+  return sqrt(dot(u, u));
+}
+
+// Compute `y = alpha * x + y` in parallel.
+template<class Num>
+void axpy(Num alpha, std::span<const Num> x, std::span<Num> y) {
+  TIT_ASSERT(x.size() == y.size(), "Vector sizes must match!");
+  par::for_each(std::views::iota(size_t{0}, x.size()),
+                [alpha, &x, &y](size_t i) { y[i] += alpha * x[i]; });
+}
+
+// Compute the residual `r = b - A * x`.
+template<linear_operator Op, class Num = operator_num_t<Op>>
+void residual(const Op& A,
+              std::span<const Num> b,
+              std::span<const Num> x,
+              std::span<Num> r) {
+  A.multiply(x, r);
+  par::for_each(std::views::iota(size_t{0}, r.size()),
+                [&b, &r](size_t i) { r[i] = b[i] - r[i]; });
+}
+
+// Base of the iterative solvers, that stores the stopping criteria.
+class BaseSolver {
+public:
+
+  constexpr explicit BaseSolver(float64_t tolerance,
+                                size_t max_iterations) noexcept
+      : tolerance_{tolerance}, max_iterations_{max_iterations} {
+    TIT_ASSERT(tolerance_ > 0.0, "Tolerance must be positive!");
+  }
+
+protected:
+
+  float64_t tolerance_;
+  size_t max_iterations_;
+
+}; // class BaseSolver
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Preconditioned conjugate gradient linear solver function.
+///
+/// Operator and preconditioner must be symmetric positive (semi-)definite.
+class ConjugateGradientSolver final : public impl::BaseSolver {
+public:
+
+  /// Construct a conjugate gradient solver.
+  ///
+  /// @param tolerance      Relative residual norm to stop at.
+  /// @param max_iterations Maximal number of iterations.
+  constexpr explicit ConjugateGradientSolver(
+      float64_t tolerance = 1.0e-6,
+      size_t max_iterations = 1000) noexcept
+      : BaseSolver{tolerance, max_iterations} {}
+
+  /// Solve the linear system `A * x = b`. Initial value of `x` is used as
+  /// the initial guess.
+  template<linear_operator Op,
+           class Num = operator_num_t<Op>,
+           preconditioner<Num> Precond = IdentityPreconditioner>
+  auto operator()(const Op& A,
+                  std::type_identity_t<std::span<const Num>> b,
+                  std::type_identity_t<std::span<Num>> x,
+                  const Precond& M = {}) const -> SolverResult {
+    TIT_PROFILE_SECTION("sparse::ConjugateGradientSolver::operator()");
+    const auto n = A.num_rows();
+    TIT_ASSERT(b.size() == n, "Right hand side size must match the operator!");
+    TIT_ASSERT(x.size() == n, "Solution size must match the operator!");
+    const auto indices = std::views::iota(size_t{0}, n);
+
+    // Compute the initial residual and the search direction.
+    std::vector<Num> r(n);
+    std::vector<Num> z(n);
+    std::vector<Num> p(n);
+    std::vector<Num> q(n);
+    impl::residual<Op, Num>(A, b, x, r);
+    M.apply(std::span<const Num>{r}, std::span{z});
+    std::ranges::copy(z, p.begin());
+    auto rz = impl::dot<Num>(r, z);
+    const auto norm_b = impl::norm(b);
+    const auto scale = is_tiny(norm_b) ? Num{1} : norm_b;
+
+    // Iterate until the residual is small enough.
+    SolverResult result{};
+    while (true) {
+      result.residual = static_cast<float64_t>(impl::norm<Num>(r) / scale);
+      if (result.residual <= tolerance_) {
+        result.converged = true;
+        break;
+      }
+      if (result.num_iterations == max_iterations_) break;
+
+      // Advance the solution along the search direction.
+      A.multiply(std::span<const Num>{p}, std::span{q});
+      const auto pq = impl::dot<Num>(p, q);
+      if (pq <= Num{0}) break; // Operator is not positive definite.
+      const auto alpha = rz / pq;
+      par::for_each(indices, [alpha, &x, &r, &p, &q](size_t i) {
+        x[i] += alpha * p[i];
+        r[i] -= alpha * q[i];
+      });
+
+      // Update the search direction.
+      M.apply(std::span<const Num>{r}, std::span{z});
+      const auto rz_new = impl::dot<Num>(r, z);
+      const auto beta = rz_new / rz;
+      rz = rz_new;
+      par::for_each(indices,
+                    [beta, &z, &p](size_t i) { p[i] = z[i] + beta * p[i]; });
+      result.num_iterations += 1;
+    }
+    TIT_STATS_HIST("sparse::ConjugateGradientSolver::num_iterations",
+                   result.num_iterations);
+    return result;
+  }
+
+}; // class ConjugateGradientSolver
+
+/// Preconditioned conjugate gradient linear solver.
+inline constexpr ConjugateGradientSolver cg_solver{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Right-preconditioned biconjugate gradient stabilized linear solver
+/// function.
+///
+/// Suitable for the general non-symmetric operators.
+class BiCGStabSolver final : public impl::BaseSolver {
+public:
+
+  /// Construct a biconjugate gradient stabilized solver.
+  ///
+  /// @param tolerance      Relative residual norm to stop at.
+  /// @param max_iterations Maximal number of iterations.
+  constexpr explicit BiCGStabSolver(float64_t tolerance = 1.0e-6,
+                                    size_t max_iterations = 1000) noexcept
+      : BaseSolver{tolerance, max_iterations} {}
+
+  /// Solve the linear system `A * x = b`. Initial value of `x` is used as
+  /// the initial guess.
+  template<linear_operator Op,
+           class Num = operator_num_t<Op>,
+           preconditioner<Num> Precond = IdentityPreconditioner>
+  auto operator()(const Op& A,
+                  std::type_identity_t<std::span<const Num>> b,
+                  std::type_identity_t<std::span<Num>> x,
+                  const Precond& M = {}) const -> SolverResult {
+    TIT_PROFILE_SECTION("sparse::BiCGStabSolver::operator()");
+    const auto n = A.num_rows();
+    TIT_ASSERT(b.size() == n, "Right hand side size must match the operator!");
+    TIT_ASSERT(x.size() == n, "Solution size must match the operator!");
+    const auto indices = std::views::iota(size_t{0}, n);
+
+    // Compute the initial residual and the shadow residual.
+    std::vector<Num> r(n);
+    std::vector<Num> r_0(n);
+    std::vector<Num> p(n);
+    std::vector<Num> p_hat(n);
+    std::vector<Num> s_hat(n);
+    std::vector<Num> v(n);
+    std::vector<Num> t(n);
+    impl::residual<Op, Num>(A, b, x, r);
+    std::ranges::copy(r, r_0.begin());
+    const auto norm_b = impl::norm(b);
+    const auto scale = is_tiny(norm_b) ? Num{1} : norm_b;
+    Num rho{1};
+    Num alpha{1};
+    Num omega{1};
+
+    // Iterate until the residual is small enough.
+    SolverResult result{};
+    while (true) {
+      result.residual = static_cast<float64_t>(impl::norm<Num>(r) / scale);
+      if (result.residual <= tolerance_) {
+        result.converged = true;
+        break;
+      }
+      if (result.num_iterations == max_iterations_) break;
+
+      // Update the search direction.
+      const auto rho_new = impl::dot<Num>(r_0, r);
+      if (rho_new == Num{0}) break; // Breakdown.
+      const auto beta = (rho_new / rho) * (alpha / omega);
+      rho = rho_new;
+      par::for_each(indices, [beta, omega, &r, &p, &v](size_t i) {
+        p[i] = r[i] + beta * (p[i] - omega * v[i]);
+      });
+
+      // Compute the intermediate solution.
+      M.apply(std::span<const Num>{p}, std::span{p_hat});
+      A.multiply(std::span<const Num>{p_hat}, std::span{v});
+      const auto r_0v = impl::dot<Num>(r_0, v);
+      if (r_0v == Num{0}) break; // Breakdown.
+      alpha = rho / r_0v;
+      impl::axpy<Num>(alpha, p_hat, x);
+      impl::axpy<Num>(-alpha, v, r);
+      result.num_iterations += 1;
+      if (impl::norm<Num>(r) / scale <= tolerance_) continue;
+
+      // Stabilize the solution.
+      M.apply(std::span<const Num>{r}, std::span{s_hat});
+      A.multiply(std::span<const Num>{s_hat}, std::span{t});
+      const auto tt = impl::dot<Num>(t, t);
+      if (tt == Num{0}) break; // Breakdown.
+      omega = impl::dot<Num>(t, r) / tt;
+      impl::axpy<Num>(omega, s_hat, x);
+      impl::axpy<Num>(-omega, t, r);
+      if (omega == Num{0}) break; // Stagnation.
+    }
+    TIT_STATS_HIST("sparse::BiCGStabSolver::num_iterations",
+                   result.num_iterations);
+    return result;
+  }
+
+}; // class BiCGStabSolver
+
+/// Right-preconditioned biconjugate gradient stabilized linear solver.
+inline constexpr BiCGStabSolver bicgstab_solver{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Right-preconditioned restarted generalized minimal residual linear solver
+/// function.
+///
+/// Suitable for the general non-symmetric operators. Krylov basis is
+/// orthogonalized with the modified Gram-Schmidt process, and the least
+/// squares problem is solved with the Givens rotations.
+class GMRESSolver final : public impl::BaseSolver {
+public:
+
+  /// Construct a restarted generalized minimal residual solver.
+  ///
+  /// @param tolerance      Relative residual norm to stop at.
+  /// @param max_iterations Maximal number of iterations.
+  /// @param restart        Number of iterations before the restart.
+  constexpr explicit GMRESSolver(float64_t tolerance = 1.0e-6,
+                                 size_t max_iterations = 1000,
+                                 size_t restart = 30) noexcept
+      : BaseSolver{tolerance, max_iterations}, restart_{restart} {
+    TIT_ASSERT(restart_ > 0, "Restart length must be positive!");
+  }
+
+  /// Solve the linear system `A * x = b`. Initial value of `x` is used as
+  /// the initial guess.
+  template<linear_operator Op,
+           class Num = operator_num_t<Op>,
+           preconditioner<Num> Precond = IdentityPreconditioner>
+  auto operator()(const Op& A,
+                  std::type_identity_t<std::span<const Num>> b,
+                  std::type_identity_t<std::span<Num>> x,
+                  const Precond& M = {}) const -> SolverResult {
+    TIT_PROFILE_SECTION("sparse::GMRESSolver::operator()");
+    const auto n = A.num_rows();
+    TIT_ASSERT(b.size() == n, "Right hand side size must match the operator!");
+    TIT_ASSERT(x.size() == n, "Solution size must match the operator!");
+    const auto m = restart_;
+    const auto norm_b = impl::norm(b);
+    const auto scale = is_tiny(norm_b) ? Num{1} : norm_b;
+
+    // Krylov basis, preconditioned basis, Hessenberg matrix (stored by
+    // columns), Givens rotations and the least squares right hand side.
+    std::vector<std::vector<Num>> V(m + 1, std::vector<Num>(n));
+    std::vector<std::vector<Num>> Z(m, std::vector<Num>(n));
+    std::vector<std::vector<Num>> H(m, std::vector<Num>(m + 1));
+    std::vector<Num> cs(m);
+    std::vector<Num> sn(m);
+    std::vector<Num> g(m + 1);
+    std::vector<Num> y(m);
+
+    // Iterate until the residual is small enough.
+    SolverResult result{};
+    while (true) {
+      // Compute the residual and start the new cycle.
+      impl::residual<Op, Num>(A, b, x, V[0]);
+      const auto beta = impl::norm<Num>(V[0]);
+      result.residual = static_cast<float64_t>(beta / scale);
+      if (result.residual <= tolerance_) {
+        result.converged = true;
+        break;
+      }
+      if (result.num_iterations == max_iterations_) break;
+      par::transform(V[0], V[0].begin(), [beta](Num v) { return v / beta; });
+      std::ranges::fill(g, Num{0});
+      g[0] = beta;
+
+      // Build the Krylov basis.
+      size_t k = 0;
+      while (k < m && result.num_iterations < max_iterations_) {
+        M.apply(std::span<const Num>{V[k]}, std::span{Z[k]});
+        A.multiply(std::span<const Num>{Z[k]}, std::span{V[k + 1]});
+        for (size_t j = 0; j <= k; ++j) {
+          H[k][j] = impl::dot<Num>(V[k + 1], V[j]);
+          impl::axpy<Num>(-H[k][j], V[j], V[k + 1]);
+        }
+        const auto h_next = impl::norm<Num>(V[k + 1]);
+        H[k][k + 1] = h_next;
+        if (h_next != Num{0}) {
+          const auto inv_h = inverse(h_next);
+          par::transform(V[k + 1], V[k + 1].begin(), [inv_h](Num v) {
+            return v * inv_h;
+          });
+        }
+
+        // Apply the previous rotations, and compute the new one.
+        for (size_t j = 0; j < k; ++j) {
+          const auto h_j = H[k][j];
+          H[k][j] = cs[j] * h_j + sn[j] * H[k][j + 1];
+          H[k][j + 1] = -sn[j] * h_j + cs[j] * H[k][j + 1];
+        }
+        const auto h = sqrt(pow2(H[k][k]) + pow2(H[k][k + 1]));
+        cs[k] = h == Num{0} ? Num{1} : H[k][k] / h;
+        sn[k] = h == Num{0} ? Num{0} : H[k][k + 1] / h;
+        H[k][k] = h;
+        H[k][k + 1] = Num{0};
+        g[k + 1] = -sn[k] * g[k];
+        g[k] = cs[k] * g[k];
+        k += 1, result.num_iterations += 1;
+        if (abs(g[k]) / scale <= tolerance_) break;
+        if (h_next == Num{0}) break; // Invariant subspace is found.
+      }
+
+      // Solve the least squares problem and update the solution.
+      for (size_t i = k; i-- > 0;) {
+        auto sum = g[i];
+        for (size_t j = i + 1; j < k; ++j) sum -= H[j][i] * y[j];
+        y[i] = H[i][i] == Num{0} ? Num{0} : sum / H[i][i];
+      }
+      for (size_t i = 0; i < k; ++i) impl::axpy<Num>(y[i], Z[i], x);
+    }
+    TIT_STATS_HIST("sparse::GMRESSolver::num_iterations",
+                   result.num_iterations);
+    return result;
+  }
+
+private:
+
+  size_t restart_;
+
+}; // class GMRESSolver
+
+/// Right-preconditioned restarted generalized minimal residual linear solver.
+inline constexpr GMRESSolver gmres_solver{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sparse
@@ -0,0 +1,168 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/sparse/matrix.hpp"
+#include "tit/sparse/operator.hpp"
+#include "tit/sparse/preconditioner.hpp"
+#include "tit/sparse/solver.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// Build a sparsity pattern of the tridiagonal matrix.
+auto make_pattern(size_t num_rows) -> Multivector<size_t> {
+  Multivector<size_t> pattern{};
+  for (size_t i = 0; i < num_rows; ++i) {
+    std::vector<size_t> cols{};
+    if (i > 0) cols.push_back(i - 1);
+    if (i + 1 < num_rows) cols.push_back(i + 1);
+    pattern.append_bucket(cols);
+  }
+  return pattern;
+}
+
+// Assemble the tridiagonal matrix with the given coefficients.
+auto make_matrix(const Multivector<size_t>& pattern,
+                 double lower,
+                 double diag,
+                 double upper) -> sparse::Matrix<double> {
+  sparse::Matrix<double> matrix{pattern};
+  for (size_t i = 0; i < matrix.num_rows(); ++i) {
+    matrix.diag(i) = diag;
+    const auto cols = matrix.cols(i);
+    const auto row = matrix.row(i);
+    for (size_t k = 0; k < cols.size(); ++k) {
+      row[k] = cols[k] < i ? lower : upper;
+    }
+  }
+  return matrix;
+}
+
+// Exact solution of the discrete Poisson equation with the unit right hand
+// side, `x_i = (i + 1) * (n - i) / 2`.
+auto poisson_solution(size_t n) -> std::vector<double> {
+  std::vector<double> x(n);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = static_cast<double>((i + 1) * (n - i)) / 2.0;
+  }
+  return x;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sparse::ConjugateGradientSolver") {
+  par::set_num_threads(4);
+  constexpr size_t n = 100;
+  const auto pattern = make_pattern(n);
+  const auto laplacian = make_matrix(pattern, -1.0, 2.0, -1.0);
+  const std::vector b(n, 1.0);
+  SUBCASE("converged") {
+    // Ensure the solution of the discrete Poisson equation is found.
+    constexpr sparse::ConjugateGradientSolver solver{/*tolerance=*/1.0e-12};
+    std::vector<double> x(n);
+    const auto result = solver(laplacian, b, x);
+    CHECK(result.converged);
+    CHECK(result.num_iterations <= n);
+    CHECK_RANGE_EQ(x, poisson_solution(n), approx_equal_to<double>);
+  }
+  SUBCASE("preconditioned") {
+    // Ensure the solution is found with the Jacobi preconditioner.
+    constexpr sparse::ConjugateGradientSolver solver{/*tolerance=*/1.0e-12};
+    std::vector<double> x(n);
+    const auto result =
+        solver(laplacian, b, x, sparse::JacobiPreconditioner{laplacian});
+    CHECK(result.converged);
+    CHECK_RANGE_EQ(x, poisson_solution(n), approx_equal_to<double>);
+  }
+  SUBCASE("initial guess") {
+    // Ensure the exact initial guess is kept as is.
+    auto x = poisson_solution(n);
+    const auto result = sparse::cg_solver(laplacian, b, x);
+    CHECK(result.converged);
+    CHECK(result.num_iterations == 0);
+  }
+  SUBCASE("not converged") {
+    // Ensure the iterations are limited.
+    constexpr sparse::ConjugateGradientSolver solver{/*tolerance=*/1.0e-6,
+                                                    /*max_iterations=*/3};
+    std::vector<double> x(n);
+    const auto result = solver(laplacian, b, x);
+    CHECK_FALSE(result.converged);
+    CHECK(result.num_iterations == 3);
+    CHECK(result.residual > 1.0e-6);
+  }
+  SUBCASE("matrix-free") {
+    // Ensure the matrix-free operators are supported.
+    const auto laplace = [](std::span<const double> u, std::span<double> v) {
+      for (size_t i = 0; i < u.size(); ++i) {
+        v[i] = 2.0 * u[i];
+        if (i > 0) v[i] -= u[i - 1];
+        if (i + 1 < u.size()) v[i] -= u[i + 1];
+      }
+    };
+    const sparse::FuncOperator<double, decltype(laplace)> op{n, laplace};
+    constexpr sparse::ConjugateGradientSolver solver{/*tolerance=*/1.0e-12};
+    std::vector<double> x(n);
+    const auto result = solver(op, b, x);
+    CHECK(result.converged);
+    CHECK_RANGE_EQ(x, poisson_solution(n), approx_equal_to<double>);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sparse::NonSymmetricSolver",
+                   Solver,
+                   sparse::BiCGStabSolver,
+                   sparse::GMRESSolver) {
+  par::set_num_threads(4);
+  constexpr size_t n = 50;
+  const auto pattern = make_pattern(n);
+  const auto matrix = make_matrix(pattern, -1.2, 3.0, -0.8);
+  const std::vector b(n, 1.0);
+  SUBCASE("converged") {
+    // Ensure the solution of the convection-diffusion equation is found.
+    const Solver solver{/*tolerance=*/1.0e-10};
+    std::vector<double> x(n);
+    const auto result = solver(matrix, b, x);
+    CHECK(result.converged);
+    std::vector<double> Ax(n);
+    matrix.multiply(x, Ax);
+    CHECK_RANGE_EQ(Ax, b, approx_equal_to<double>);
+  }
+  SUBCASE("preconditioned") {
+    // Ensure the solution is found with the Jacobi preconditioner.
+    const Solver solver{/*tolerance=*/1.0e-10};
+    std::vector<double> x(n);
+    const auto result =
+        solver(matrix, b, x, sparse::JacobiPreconditioner{matrix});
+    CHECK(result.converged);
+    std::vector<double> Ax(n);
+    matrix.multiply(x, Ax);
+    CHECK_RANGE_EQ(Ax, b, approx_equal_to<double>);
+  }
+  SUBCASE("not converged") {
+    // Ensure the iterations are limited.
+    const Solver solver{/*tolerance=*/1.0e-10, /*max_iterations=*/2};
+    std::vector<double> x(n);
+    const auto result = solver(matrix, b, x);
+    CHECK_FALSE(result.converged);
+    CHECK(result.num_iterations == 2);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,366 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/task_group.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Block schedule that processes the blocks in the barrier-separated chunks
+/// of `par::num_parts()` blocks, see `par::block_for_each`.
+struct LevelSchedule final {
+  /// Update the schedule. Does nothing.
+  static constexpr void update(size_t /*num_blocks*/,
+                               const auto& /*particle_blocks*/) noexcept {}
+
+  /// Iterate through the blocks in parallel.
+  template<par::range Blocks, class Func>
+  static void for_each(Blocks&& blocks, Func func) {
+    par::block_for_each(std::forward<Blocks>(blocks), std::move(func));
+  }
+
+  /// Iterate through the blocks in parallel, running the task concurrently
+  /// with the first chunk of blocks.
+  template<par::range Blocks, class Func, par::task Task>
+  static void for_each(Blocks&& blocks, Func func, Task overlap_task) {
+    par::block_for_each(std::forward<Blocks>(blocks),
+                        std::move(func),
+                        std::move(overlap_task));
+  }
+
+  /// Iterate through the blocks in two dependent passes in parallel. The
+  /// second pass is started once the first one is completed.
+  template<par::range FirstBlocks,
+           class FirstFunc,
+           par::range SecondBlocks,
+           class SecondFunc>
+  static void for_each_chain(FirstBlocks&& first_blocks,
+                             FirstFunc first_func,
+                             SecondBlocks&& second_blocks,
+                             SecondFunc second_func) {
+    par::block_for_each(std::forward<FirstBlocks>(first_blocks),
+                        std::move(first_func));
+    par::block_for_each(std::forward<SecondBlocks>(second_blocks),
+                        std::move(second_func));
+  }
+
+  /// Iterate through the blocks in parallel, and through the items of the
+  /// matching epilogue block right after each block is processed. Since the
+  /// blocks are processed in the index order, an item that is touched by no
+  /// block past the one of its epilogue is never touched again.
+  template<par::range Blocks,
+           class Func,
+           par::range EpilogueBlocks,
+           class EpilogueFunc>
+  static void for_each_epilogue(Blocks&& blocks,
+                                Func func,
+                                EpilogueBlocks&& epilogue_blocks,
+                                EpilogueFunc epilogue_func) {
+    TIT_ASSERT(std::size(blocks) == std::size(epilogue_blocks),
+               "Number of the epilogue blocks must match!");
+    par::block_for_each(
+        std::views::iota(size_t{0}, std::size(blocks)) |
+            std::views::transform(
+                [](size_t block) { return std::views::single(block); }),
+        [&blocks, &func, &epilogue_blocks, &epilogue_func](size_t block) {
+          std::ranges::for_each(std::begin(blocks)[block], std::cref(func));
+          std::ranges::for_each(std::begin(epilogue_blocks)[block],
+                                std::cref(epilogue_func));
+        });
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Block schedule based on the greedy coloring of the blocks.
+///
+/// Two blocks conflict if they share a particle. Blocks are colored so that
+/// no two conflicting blocks have the same color, and each block is run as a
+/// task once all the conflicting blocks of the lower colors are completed.
+/// Compared to the level schedule, there are no barriers between the chunks:
+/// a block starts as soon as the blocks it depends on are done.
+class ColoringSchedule final {
+public:
+
+  /// Number of the block colors.
+  constexpr auto num_colors() const noexcept -> size_t {
+    return num_colors_;
+  }
+
+  /// Color of the block.
+  constexpr auto color(size_t block) const noexcept -> size_t {
+    TIT_ASSERT(block < colors_.size(), "Block index is out of range!");
+    return colors_[block];
+  }
+
+  /// Update the schedule.
+  ///
+  /// @param num_blocks      Number of blocks.
+  /// @param particle_blocks Range of the blocks that each particle may be
+  ///                        touched by. Duplicates are allowed.
+  template<par::range ParticleBlocks>
+  void update(size_t num_blocks, ParticleBlocks&& particle_blocks) {
+    TIT_PROFILE_SECTION("ColoringSchedule::update()");
+    TIT_ASSUME_UNIVERSAL(ParticleBlocks, particle_blocks);
+
+    // Find the conflicting blocks.
+    static thread_local std::vector<std::vector<uint8_t>> conflicts_buffer{};
+    auto& thread_conflicts = conflicts_buffer;
+    thread_conflicts.resize(par::num_threads());
+    for (auto& conflicts : thread_conflicts) {
+      conflicts.assign(num_blocks * num_blocks, 0);
+    }
+    par::static_for_each( //
+        particle_blocks,
+        [&thread_conflicts, num_blocks](size_t thread, const auto& blocks) {
+          auto& conflicts = thread_conflicts[thread];
+          for (const size_t block : blocks) {
+            TIT_ASSERT(block < num_blocks, "Block index is out of range!");
+            for (const size_t other_block : blocks) {
+              conflicts[block * num_blocks + other_block] = 1;
+            }
+          }
+        });
+    auto& conflicts = thread_conflicts.front();
+    for (const auto& other_conflicts : thread_conflicts | std::views::drop(1)) {
+      std::ranges::transform(conflicts,
+                             other_conflicts,
+                             conflicts.begin(),
+                             std::bit_or{});
+    }
+    const auto conflict = [num_blocks, &conflicts](size_t block,
+                                                   size_t other_block) {
+      return block != other_block &&
+             conflicts[block * num_blocks + other_block] != 0;
+    };
+
+    // Color the blocks greedily: each block gets the smallest color that is
+    // not taken by the conflicting blocks colored before it.
+    colors_.assign(num_blocks, npos);
+    num_colors_ = 0;
+    std::vector<bool> taken{};
+    for (size_t block = 0; block < num_blocks; ++block) {
+      taken.assign(num_colors_ + 1, false);
+      for (size_t other_block = 0; other_block < block; ++other_block) {
+        if (conflict(block, other_block)) taken[colors_[other_block]] = true;
+      }
+      const auto free_color = std::ranges::find(taken, false);
+      colors_[block] = static_cast<size_t>(free_color - taken.begin());
+      num_colors_ = std::max(num_colors_, colors_[block] + 1);
+    }
+    TIT_STATS("ColoringSchedule::num_colors_", num_colors_);
+
+    // Build the dependency graph: each block depends on the conflicting blocks
+    // of the lower colors.
+    std::vector<std::pair<size_t, size_t>> dependencies{};
+    std::vector<std::pair<size_t, size_t>> neighbors{};
+    num_deps_.assign(num_blocks, 0);
+    for (size_t block = 0; block < num_blocks; ++block) {
+      neighbors.emplace_back(block, block);
+      for (size_t other_block = 0; other_block < num_blocks; ++other_block) {
+        if (!conflict(block, other_block)) continue;
+        neighbors.emplace_back(block, other_block);
+        if (colors_[other_block] >= colors_[block]) continue;
+        dependencies.emplace_back(other_block, block);
+        num_deps_[block] += 1;
+      }
+    }
+    successors_.assign_pairs_seq(num_blocks, dependencies);
+    neighbors_.assign_pairs_seq(num_blocks, neighbors);
+  }
+
+  /// Iterate through the blocks in parallel.
+  template<par::range Blocks, class Func>
+  void for_each(Blocks&& blocks, Func func) const {
+    TIT_ASSUME_UNIVERSAL(Blocks, blocks);
+    run_(blocks, func, /*overlap_task=*/nullptr);
+  }
+
+  /// Iterate through the blocks in parallel, running the task concurrently
+  /// with the first `par::num_parts()` blocks. The remaining blocks are
+  /// started only after the task is completed.
+  template<par::range Blocks, class Func, par::task Task>
+  void for_each(Blocks&& blocks, Func func, Task overlap_task) const {
+    TIT_ASSUME_UNIVERSAL(Blocks, blocks);
+    run_(blocks, func, std::move(overlap_task));
+  }
+
+  /// Iterate through the blocks in two dependent passes in parallel.
+  ///
+  /// Second pass over a block is started as soon as the first pass is
+  /// completed for the block itself and for all the blocks it conflicts
+  /// with, i.e. once the first pass values of all the block particles are
+  /// final. There is no barrier between the passes: the blocks of the second
+  /// pass run alongside the remaining blocks of the first one.
+  template<par::range FirstBlocks,
+           class FirstFunc,
+           par::range SecondBlocks,
+           class SecondFunc>
+  void for_each_chain(FirstBlocks&& first_blocks,
+                      FirstFunc first_func,
+                      SecondBlocks&& second_blocks,
+                      SecondFunc second_func) const {
+    TIT_ASSUME_UNIVERSAL(FirstBlocks, first_blocks);
+    TIT_ASSUME_UNIVERSAL(SecondBlocks, second_blocks);
+    TIT_ASSERT(std::size(first_blocks) == num_deps_.size() &&
+                   std::size(second_blocks) == num_deps_.size(),
+               "Number of blocks does not match the schedule!");
+
+    // Tasks below `num_blocks` are the first pass blocks, and the rest are
+    // the second pass ones.
+    const auto num_blocks = num_deps_.size();
+    std::vector<size_t> counters(2 * num_blocks);
+    for (size_t block = 0; block < num_blocks; ++block) {
+      counters[block] = num_deps_[block];
+      counters[num_blocks + block] =
+          num_deps_[block] + neighbors_[block].size();
+    }
+
+    // Run the block, and then run the dependent tasks that became ready.
+    par::TaskGroup tasks{};
+    const auto release = [&counters](size_t task) {
+      return std::atomic_ref{counters[task]}.fetch_sub(
+                 1,
+                 std::memory_order_acq_rel) == 1;
+    };
+    const auto run_task = [&first_blocks,
+                           &first_func,
+                           &second_blocks,
+                           &second_func,
+                           &tasks,
+                           &release,
+                           num_blocks,
+                           this](this const auto& self, size_t task) -> void {
+      tasks.run([&first_blocks,
+                 &first_func,
+                 &second_blocks,
+                 &second_func,
+                 &release,
+                 &self,
+                 num_blocks,
+                 task,
+                 this] {
+        if (task < num_blocks) {
+          std::ranges::for_each(std::ranges::begin(first_blocks)[task],
+                                first_func);
+          for (const auto next_block : successors_[task]) {
+            if (release(next_block)) self(next_block);
+          }
+          for (const auto next_block : neighbors_[task]) {
+            if (release(num_blocks + next_block)) self(num_blocks + next_block);
+          }
+        } else {
+          const auto block = task - num_blocks;
+          std::ranges::for_each(std::ranges::begin(second_blocks)[block],
+                                second_func);
+          for (const auto next_block : successors_[block]) {
+            if (release(num_blocks + next_block)) self(num_blocks + next_block);
+          }
+        }
+      });
+    };
+
+    // Run the first pass blocks that have no dependencies.
+    for (size_t block = 0; block < num_blocks; ++block) {
+      if (num_deps_[block] == 0) run_task(block);
+    }
+    tasks.wait();
+  }
+
+private:
+
+  // Run the blocks as the tasks, each one started once the blocks it depends
+  // on are completed. If the overlap task is present, the blocks past the
+  // first `par::num_parts()` ones also depend on it.
+  template<par::range Blocks, class Func, class Task>
+  void run_(Blocks& blocks, const Func& func, Task overlap_task) const {
+    TIT_ASSERT(std::size(blocks) == num_deps_.size(),
+               "Number of blocks does not match the schedule!");
+    static constexpr bool Overlap = !std::same_as<Task, std::nullptr_t>;
+    const auto num_blocks = num_deps_.size();
+    const auto first_dependent_block = Overlap ? par::num_parts() : npos;
+    std::vector<size_t> counters(num_deps_);
+    for (size_t block = first_dependent_block; block < num_blocks; ++block) {
+      counters[block] += 1;
+    }
+
+    // Run the block, and then run the dependent blocks that became ready.
+    par::TaskGroup tasks{};
+    const auto release = [&counters](size_t block) {
+      return std::atomic_ref{counters[block]}.fetch_sub(
+                 1,
+                 std::memory_order_acq_rel) == 1;
+    };
+    const auto run_block = [&blocks, &func, &tasks, &release, this](
+                               this const auto& self,
+                               size_t block) -> void {
+      tasks.run([&blocks, &func, &release, &self, block, this] {
+        std::ranges::for_each(std::ranges::begin(blocks)[block], func);
+        for (const auto next_block : successors_[block]) {
+          if (release(next_block)) self(next_block);
+        }
+      });
+    };
+
+    // Run the overlap task and release the blocks that wait for it.
+    if constexpr (Overlap) {
+      tasks.run([&overlap_task,
+                 &run_block,
+                 &release,
+                 first_dependent_block,
+                 num_blocks] {
+        overlap_task();
+        for (size_t block = first_dependent_block; block < num_blocks;
+             ++block) {
+          if (release(block)) run_block(block);
+        }
+      });
+    }
+
+    // Run the blocks that have no dependencies.
+    for (size_t block = 0; block < std::min(num_blocks, first_dependent_block);
+         ++block) {
+      if (num_deps_[block] == 0) run_block(block);
+    }
+    tasks.wait();
+  }
+
+  std::vector<size_t> colors_;
+  size_t num_colors_ = 0;
+  std::vector<size_t> num_deps_;
+  Multivector<size_t> successors_;
+  Multivector<size_t> neighbors_;
+
+}; // class ColoringSchedule
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Block schedule type.
+template<class BS>
+concept block_schedule =
+    std::same_as<BS, LevelSchedule> || std::same_as<BS, ColoringSchedule>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
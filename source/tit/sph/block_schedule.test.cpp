@@ -0,0 +1,165 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/sph/block_schedule.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::LevelSchedule::for_each_epilogue") {
+  par::set_num_threads(2);
+
+  // Items of each block are the block indices, items of each epilogue block
+  // are the item indices. Each item records the time stamp it was processed
+  // at.
+  const std::vector<std::vector<size_t>> blocks{
+      {0, 0, 0},
+      {1, 1},
+      {2, 2, 2, 2},
+      {3},
+  };
+  const std::vector<std::vector<size_t>> epilogue_blocks{
+      {0, 1},
+      {},
+      {2},
+      {3, 4},
+  };
+  std::atomic<size_t> clock = 0;
+  std::vector<std::vector<size_t>> stamps(blocks.size());
+  std::vector<size_t> epilogue_stamps(5);
+  sph::LevelSchedule::for_each_epilogue(
+      blocks,
+      [&clock, &stamps](size_t block) { stamps[block].push_back(clock++); },
+      epilogue_blocks,
+      [&clock, &epilogue_stamps](size_t item) {
+        epilogue_stamps[item] = clock++;
+      });
+
+  // Ensure all the items are processed, and the epilogue items are processed
+  // after their block.
+  for (size_t block = 0; block < blocks.size(); ++block) {
+    REQUIRE(stamps[block].size() == blocks[block].size());
+    for (const size_t item : epilogue_blocks[block]) {
+      CHECK(std::ranges::max(stamps[block]) < epilogue_stamps[item]);
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ColoringSchedule") {
+  par::set_num_threads(2);
+
+  // Setup the schedule, so that the block 2 conflicts with all the others.
+  const std::vector<std::vector<size_t>> particle_blocks{
+      {0, 2},
+      {1, 2},
+      {2, 3},
+      {0},
+  };
+  sph::ColoringSchedule schedule{};
+  schedule.update(4, particle_blocks);
+  REQUIRE(schedule.num_colors() == 2);
+  CHECK(schedule.color(0) == 0);
+  CHECK(schedule.color(1) == 0);
+  CHECK(schedule.color(2) == 1);
+  CHECK(schedule.color(3) == 0);
+
+  // Items of each block are the block indices, and each item records the
+  // time stamp it was processed at.
+  const std::vector<std::vector<size_t>> blocks{
+      {0, 0, 0},
+      {1, 1},
+      {2, 2, 2, 2},
+      {3},
+  };
+  std::atomic<size_t> clock = 0;
+  std::vector<std::vector<size_t>> stamps(blocks.size());
+  const auto func = [&clock, &stamps](size_t block) {
+    stamps[block].push_back(clock++);
+  };
+  const auto last_stamp = [&stamps](size_t block) {
+    return std::ranges::max(stamps[block]);
+  };
+  const auto first_stamp = [&stamps](size_t block) {
+    return std::ranges::min(stamps[block]);
+  };
+
+  SUBCASE("basic") {
+    // Ensure all the items are processed, and the conflicting block is
+    // processed after the blocks it depends on.
+    schedule.for_each(blocks, func);
+    for (size_t block = 0; block < blocks.size(); ++block) {
+      CHECK(stamps[block].size() == blocks[block].size());
+    }
+    for (const size_t block : {0, 1, 3}) {
+      CHECK(last_stamp(block) < first_stamp(2));
+    }
+  }
+  SUBCASE("overlap") {
+    // Ensure the blocks past the first chunk are processed after the task.
+    size_t task_stamp = 0;
+    schedule.for_each(blocks, func, [&clock, &task_stamp] {
+      task_stamp = clock++;
+    });
+    for (size_t block = 0; block < blocks.size(); ++block) {
+      CHECK(stamps[block].size() == blocks[block].size());
+    }
+    for (const size_t block : {2, 3}) {
+      CHECK(task_stamp < first_stamp(block));
+    }
+    for (const size_t block : {0, 1, 3}) {
+      CHECK(last_stamp(block) < first_stamp(2));
+    }
+  }
+  SUBCASE("chain") {
+    // Ensure the second pass over each block is started after the first
+    // pass over the block and the blocks it conflicts with is completed.
+    std::vector<std::vector<size_t>> second_stamps(blocks.size());
+    schedule.for_each_chain(
+        blocks,
+        func,
+        blocks,
+        [&clock, &second_stamps](size_t block) {
+          second_stamps[block].push_back(clock++);
+        });
+    for (size_t block = 0; block < blocks.size(); ++block) {
+      CHECK(stamps[block].size() == blocks[block].size());
+      CHECK(second_stamps[block].size() == blocks[block].size());
+    }
+    const std::vector<std::vector<size_t>> conflicting_blocks{
+        {0, 2},
+        {1, 2},
+        {0, 1, 2, 3},
+        {2, 3},
+    };
+    for (size_t block = 0; block < blocks.size(); ++block) {
+      for (const size_t other_block : conflicting_blocks[block]) {
+        CHECK(last_stamp(other_block) <
+              std::ranges::min(second_stamps[block]));
+      }
+    }
+    for (const size_t block : {0, 1, 3}) {
+      CHECK(std::ranges::max(second_stamps[block]) <
+            std::ranges::min(second_stamps[2]));
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
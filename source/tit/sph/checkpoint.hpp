@@ -0,0 +1,190 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/data/zstd.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Object that can write its state into a checkpoint and restore it back.
+template<class State>
+concept checkpointable = requires (const State& const_state,
+                                   State& state,
+                                   OutputStream<byte_t>& out,
+                                   InputStream<byte_t>& in) {
+  const_state.checkpoint(out);
+  state.restore(in);
+};
+
+namespace impl {
+
+// Checkpoint file signature, "TITCKPT1".
+inline constexpr uint64_t checkpoint_magic = 0x3154'504B'4354'4954;
+
+template<class State>
+void checkpoint_state(OutputStream<byte_t>& out, const State& state) {
+  if constexpr (checkpointable<State>) state.checkpoint(out);
+  else serialize(out, state);
+}
+
+template<class State>
+void restore_state(InputStream<byte_t>& in, State& state) {
+  if constexpr (checkpointable<State>) state.restore(in);
+  else if (!deserialize(in, state)) deserialization_failed();
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Write the solver state checkpoint into a file.
+///
+/// Each state is either a checkpointable object, like a particle array or a
+/// time integrator, or a serializable value, like the current time. The
+/// checkpoint is written into a temporary file first, that replaces the
+/// previous checkpoint only once it is complete, so a crash during writing
+/// never corrupts the last checkpoint.
+template<class... States>
+void save_checkpoint(const std::filesystem::path& path,
+                     const States&... states) {
+  TIT_PROFILE_SECTION("sph::save_checkpoint()");
+  auto temp_path = path;
+  temp_path += ".tmp";
+  {
+    const auto out = make_file_output_stream(temp_path);
+    serialize(*out, impl::checkpoint_magic);
+    (impl::checkpoint_state(*out, states), ...);
+    out->flush(); // Errors on destruction are only logged.
+  }
+  std::filesystem::rename(temp_path, path);
+}
+
+/// Restore the solver state from a checkpoint file.
+///
+/// States must be passed in the same order as they were checkpointed.
+/// Particle mesh is not checkpointed, so a new one must be used, or the old
+/// one must be invalidated after the restoring.
+template<class... States>
+void load_checkpoint(const std::filesystem::path& path, States&... states) {
+  TIT_PROFILE_SECTION("sph::load_checkpoint()");
+  const auto in = make_file_input_stream(path);
+  if (uint64_t magic = 0;
+      !deserialize(*in, magic) || magic != impl::checkpoint_magic) {
+    TIT_THROW("File '{}' is not a checkpoint.", path.native());
+  }
+  (impl::restore_state(*in, states), ...);
+  if (byte_t probe{}; in->read({&probe, 1}) != 0) {
+    TIT_THROW("Checkpoint '{}' does not match the restored state.",
+              path.native());
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Ring of the in-memory checkpoints of the solver state, that the run is
+/// rolled back to once it becomes unstable, see `NumUnstable`.
+///
+/// States are checkpointed the same way as by `save_checkpoint`, and the
+/// checkpoints are compressed at the fastest ZSTD level, so that a few
+/// latest states fit into the memory along with the run itself. Once the
+/// ring is full, the oldest checkpoint is replaced by the new one.
+class CheckpointRing final {
+public:
+
+  /// Construct an empty checkpoint ring.
+  ///
+  /// @param capacity Maximum number of the stored checkpoints.
+  explicit CheckpointRing(size_t capacity) : capacity_{capacity} {
+    TIT_ASSERT(capacity_ > 0, "Capacity must be positive!");
+  }
+
+  /// Maximum number of the stored checkpoints.
+  constexpr auto capacity() const noexcept -> size_t {
+    return capacity_;
+  }
+
+  /// Number of the stored checkpoints.
+  auto size() const noexcept -> size_t {
+    return checkpoints_.size();
+  }
+
+  /// Are there no stored checkpoints?
+  auto empty() const noexcept -> bool {
+    return checkpoints_.empty();
+  }
+
+  /// Memory used by the stored checkpoints (in bytes).
+  auto memory_usage() const noexcept -> size_t {
+    size_t result = 0;
+    for (const auto& checkpoint : checkpoints_) result += checkpoint.size();
+    return result;
+  }
+
+  /// Store the checkpoint of the states as the latest one.
+  template<class... States>
+  void save(const States&... states) {
+    TIT_PROFILE_SECTION("CheckpointRing::save()");
+    std::vector<byte_t> checkpoint;
+    if (checkpoints_.size() == capacity_) {
+      // Reuse the storage of the oldest checkpoint.
+      checkpoint = std::move(checkpoints_.front());
+      checkpoint.clear();
+      checkpoints_.pop_front();
+    }
+    {
+      // Compressor is flushed on destruction.
+      const auto out = data::zstd::make_stream_compressor(
+          make_container_output_stream(checkpoint),
+          {.level = 1});
+      (impl::checkpoint_state(*out, states), ...);
+    }
+    checkpoints_.push_back(std::move(checkpoint));
+  }
+
+  /// Restore the states from the latest checkpoint. The checkpoint is kept,
+  /// so that the run could be rolled back to it again.
+  ///
+  /// States must be passed in the same order as they were saved.
+  template<class... States>
+  void restore(States&... states) const {
+    TIT_PROFILE_SECTION("CheckpointRing::restore()");
+    if (checkpoints_.empty()) TIT_THROW("There is no checkpoint to restore.");
+    const auto in = data::zstd::make_stream_decompressor(
+        make_range_input_stream(checkpoints_.back()));
+    (impl::restore_state(*in, states), ...);
+  }
+
+  /// Drop the latest checkpoint, e.g. to roll back further.
+  void pop() {
+    TIT_ASSERT(!checkpoints_.empty(), "There is no checkpoint to drop!");
+    checkpoints_.pop_back();
+  }
+
+private:
+
+  size_t capacity_;
+  std::deque<std::vector<byte_t>> checkpoints_;
+
+}; // class CheckpointRing
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,61 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/sph/checkpoint.hpp"
+#include "tit/sph/time_step.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::CheckpointRing") {
+  sph::CheckpointRing ring{/*capacity=*/2};
+  CHECK(ring.capacity() == 2);
+  CHECK(ring.empty());
+  size_t step = 0;
+  double time = 0.0;
+  sph::TimeStepController time_step{/*cs_0=*/1.0};
+  CHECK_THROWS_MSG(ring.restore(step, time, time_step),
+                   Exception,
+                   "There is no checkpoint to restore.");
+
+  // Save a few states. Only the latest ones are kept.
+  for (step = 1; step <= 3; ++step) {
+    time = 0.5 * static_cast<double>(step);
+    time_step(1.0 / static_cast<double>(step));
+    ring.save(step, time, time_step);
+  }
+  CHECK(ring.size() == 2);
+  CHECK(ring.memory_usage() > 0);
+
+  // Restore the latest state. It is kept, so it could be restored again.
+  for (size_t i = 0; i < 2; ++i) {
+    step = 0, time = 0.0, time_step = sph::TimeStepController{1.0};
+    ring.restore(step, time, time_step);
+    CHECK(step == 3);
+    CHECK(time == 1.5);
+    CHECK_APPROX_EQ(time_step.dt(), 1.0 / 3.0);
+  }
+
+  // Drop the latest state and restore the previous one.
+  ring.pop();
+  ring.restore(step, time, time_step);
+  CHECK(step == 2);
+  CHECK(time == 1.0);
+  CHECK_APPROX_EQ(time_step.dt(), 0.5);
+  ring.pop();
+  CHECK(ring.empty());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,341 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/type_utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/time_step.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Total kinetic energy of the fluid particles, `Σ m |v|² / 2`.
+struct KineticEnergy final {
+  /// Name of the diagnostic value.
+  static constexpr std::string_view name = "kinetic_energy";
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{m, v};
+
+  /// Initial partial result.
+  static constexpr float64_t identity = 0.0;
+
+  /// Accumulate the particle into the partial result.
+  template<particle_view<required_fields> PV>
+  static constexpr void accumulate(float64_t& acc, PV a) noexcept {
+    acc += static_cast<float64_t>(m[a] * norm2(v[a]) / 2);
+  }
+
+  /// Merge the two partial results.
+  static constexpr auto merge(float64_t acc, float64_t other) noexcept
+      -> float64_t {
+    return acc + other;
+  }
+
+  /// Compute the value from the merged result.
+  static constexpr auto finalize(float64_t acc, size_t /*count*/) noexcept
+      -> float64_t {
+    return acc;
+  }
+}; // struct KineticEnergy
+
+/// Total mass of the fluid particles, `Σ m`.
+struct TotalMass final {
+  /// Name of the diagnostic value.
+  static constexpr std::string_view name = "total_mass";
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{m};
+
+  /// Initial partial result.
+  static constexpr float64_t identity = 0.0;
+
+  /// Accumulate the particle into the partial result.
+  template<particle_view<required_fields> PV>
+  static constexpr void accumulate(float64_t& acc, PV a) noexcept {
+    acc += static_cast<float64_t>(m[a]);
+  }
+
+  /// Merge the two partial results.
+  static constexpr auto merge(float64_t acc, float64_t other) noexcept
+      -> float64_t {
+    return acc + other;
+  }
+
+  /// Compute the value from the merged result.
+  static constexpr auto finalize(float64_t acc, size_t /*count*/) noexcept
+      -> float64_t {
+    return acc;
+  }
+}; // struct TotalMass
+
+/// Maximum velocity magnitude of the fluid particles, `max |v|`.
+struct MaxVelocity final {
+  /// Name of the diagnostic value.
+  static constexpr std::string_view name = "max_velocity";
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{v};
+
+  /// Initial partial result.
+  static constexpr float64_t identity = 0.0;
+
+  /// Accumulate the particle into the partial result. Squared magnitude is
+  /// accumulated, so that the root is only taken once.
+  template<particle_view<required_fields> PV>
+  static constexpr void accumulate(float64_t& acc, PV a) noexcept {
+    acc = std::max(acc, static_cast<float64_t>(norm2(v[a])));
+  }
+
+  /// Merge the two partial results.
+  static constexpr auto merge(float64_t acc, float64_t other) noexcept
+      -> float64_t {
+    return std::max(acc, other);
+  }
+
+  /// Compute the value from the merged result.
+  static constexpr auto finalize(float64_t acc, size_t /*count*/) noexcept
+      -> float64_t {
+    return sqrt(acc);
+  }
+}; // struct MaxVelocity
+
+/// Mean density of the fluid particles, `Σ rho / N`.
+struct MeanDensity final {
+  /// Name of the diagnostic value.
+  static constexpr std::string_view name = "mean_density";
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{rho};
+
+  /// Initial partial result.
+  static constexpr float64_t identity = 0.0;
+
+  /// Accumulate the particle into the partial result.
+  template<particle_view<required_fields> PV>
+  static constexpr void accumulate(float64_t& acc, PV a) noexcept {
+    acc += static_cast<float64_t>(rho[a]);
+  }
+
+  /// Merge the two partial results.
+  static constexpr auto merge(float64_t acc, float64_t other) noexcept
+      -> float64_t {
+    return acc + other;
+  }
+
+  /// Compute the value from the merged result.
+  static constexpr auto finalize(float64_t acc, size_t count) noexcept
+      -> float64_t {
+    return count == 0 ? 0.0 : acc / static_cast<float64_t>(count);
+  }
+}; // struct MeanDensity
+
+/// Number of the unstable fluid particles, whose position, velocity or
+/// density is not finite, or whose density is not positive. Nonzero value
+/// means that the run has blown up, e.g. the time step was too large.
+struct NumUnstable final {
+  /// Name of the diagnostic value.
+  static constexpr std::string_view name = "num_unstable";
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v, rho};
+
+  /// Initial partial result.
+  static constexpr float64_t identity = 0.0;
+
+  /// Accumulate the particle into the partial result. Norms of the vectors
+  /// are not finite if any of the components is not.
+  template<particle_view<required_fields> PV>
+  static constexpr void accumulate(float64_t& acc, PV a) noexcept {
+    const auto state =
+        static_cast<float64_t>(norm2(r[a]) + norm2(v[a]) + rho[a]);
+    if (!std::isfinite(state) || !(rho[a] > 0.0)) acc += 1.0;
+  }
+
+  /// Merge the two partial results.
+  static constexpr auto merge(float64_t acc, float64_t other) noexcept
+      -> float64_t {
+    return acc + other;
+  }
+
+  /// Compute the value from the merged result.
+  static constexpr auto finalize(float64_t acc, size_t /*count*/) noexcept
+      -> float64_t {
+    return acc;
+  }
+}; // struct NumUnstable
+
+/// Minimum of the stable time steps of the fluid particles, see
+/// `TimeStepController::particle_dt`. Pass it to the controller to compute
+/// the next time step without traversing the particles again.
+class StableTimeStep final {
+public:
+
+  /// Name of the diagnostic value.
+  static constexpr std::string_view name = "stable_dt";
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields = TimeStepController::required_fields;
+
+  /// Initial partial result.
+  static constexpr float64_t identity = std::numeric_limits<float64_t>::max();
+
+  /// Construct the reduction.
+  ///
+  /// @param time_step Time step controller. Must outlive the reduction.
+  constexpr explicit StableTimeStep(
+      const TimeStepController& time_step) noexcept
+      : time_step_{&time_step} {}
+
+  /// Accumulate the particle into the partial result.
+  template<particle_view<required_fields> PV>
+  constexpr void accumulate(float64_t& acc, PV a) const noexcept {
+    acc = std::min(acc, static_cast<float64_t>(time_step_->particle_dt(a)));
+  }
+
+  /// Merge the two partial results.
+  static constexpr auto merge(float64_t acc, float64_t other) noexcept
+      -> float64_t {
+    return std::min(acc, other);
+  }
+
+  /// Compute the value from the merged result.
+  static constexpr auto finalize(float64_t acc, size_t /*count*/) noexcept
+      -> float64_t {
+    return acc;
+  }
+
+private:
+
+  const TimeStepController* time_step_;
+
+}; // class StableTimeStep
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Particle observer that does nothing.
+struct NoDiagnostics final {
+  /// Ignore the particle.
+  static constexpr void operator()(const auto& /*a*/) noexcept {}
+}; // struct NoDiagnostics
+
+/// Global diagnostics of the particles.
+///
+/// Diagnostics is a particle observer: the time integrators call it for each
+/// fluid particle from their existing update loops, once per step, after the
+/// particle reaches its final state, see e.g. `RungeKuttaIntegrator::step`.
+/// Each thread accumulates into its own partial results, that are merged by
+/// `reduce` at the end of the step. Hence the monitoring makes no extra
+/// traversals of the particles.
+///
+/// @note Order of the accumulation depends on the thread scheduling, so the
+///       sums are not bitwise reproducible, even in the reproducible mode.
+template<class... Reductions>
+  requires all_unique_v<Reductions...>
+class Diagnostics final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      (meta::Set{} | ... | Reductions::required_fields);
+
+  /// Construct the diagnostics.
+  constexpr explicit Diagnostics(Reductions... reductions)
+      : reductions_{std::move(reductions)...} {
+    reset_();
+  }
+
+  /// Accumulate the particle into the partial results of the current thread.
+  template<particle_view<required_fields> PV>
+  void operator()(PV a) {
+    const auto index = par::thread_index();
+    TIT_ASSERT(index < slots_.size(), "Thread index is out of range!");
+    auto& slot = slots_[index];
+    [&]<size_t... Is>(std::index_sequence<Is...> /*is*/) {
+      (std::get<Is>(reductions_).accumulate(slot.partials[Is], a), ...);
+    }(std::index_sequence_for<Reductions...>{});
+    slot.count += 1;
+  }
+
+  /// Merge the partial results of the threads into the values, publish them
+  /// as the metrics, and start the accumulation anew. Must be called outside
+  /// of the parallel loops.
+  void reduce() {
+    Slot_ total{};
+    for (const auto& slot : slots_) {
+      [&]<size_t... Is>(std::index_sequence<Is...> /*is*/) {
+        ((total.partials[Is] =
+              Reductions::merge(total.partials[Is], slot.partials[Is])),
+         ...);
+      }(std::index_sequence_for<Reductions...>{});
+      total.count += slot.count;
+    }
+    count_ = total.count;
+    [&]<size_t... Is>(std::index_sequence<Is...> /*is*/) {
+      ((values_[Is] = Reductions::finalize(total.partials[Is], count_)), ...);
+      (Metrics::set(Reductions::name, values_[Is]), ...);
+    }(std::index_sequence_for<Reductions...>{});
+    TIT_STATS("Diagnostics::count", count_);
+    reset_();
+  }
+
+  /// Number of the particles that were accumulated before the last `reduce`.
+  constexpr auto count() const noexcept -> size_t {
+    return count_;
+  }
+
+  /// Value of the reduction computed by the last `reduce`.
+  template<class Reduction>
+    requires contains_v<Reduction, Reductions...>
+  constexpr auto get() const noexcept -> float64_t {
+    return values_[index_of_v<Reduction, Reductions...>];
+  }
+
+private:
+
+  // Partial results of a single thread. Slots are aligned to the cache
+  // lines, so that the threads do not share them.
+  struct alignas(64) Slot_ final {
+    std::array<float64_t, sizeof...(Reductions)> partials{
+        Reductions::identity...};
+    size_t count = 0;
+  };
+
+  // Reset the partial results.
+  void reset_() {
+    slots_.assign(par::num_thread_slots(), Slot_{});
+  }
+
+  std::tuple<Reductions...> reductions_;
+  std::vector<Slot_> slots_;
+  std::array<float64_t, sizeof...(Reductions)> values_{};
+  size_t count_ = 0;
+
+}; // class Diagnostics
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
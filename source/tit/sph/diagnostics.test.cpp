@@ -0,0 +1,106 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <limits>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/diagnostics.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/time_step.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the fields of the diagnostics.
+using DiagnosticsEquations = EquationsStub<
+    meta::Set{sph::m, sph::h, sph::r, sph::rho, sph::v, sph::dv_dt},
+    meta::Set{sph::v}>;
+
+TEST_CASE("sph::Diagnostics") {
+  par::set_num_threads(4);
+
+  // Setup the particles: fluid particle `i` has the mass `1`, the density
+  // `i`, and the velocity `(i, 0)`. Fixed particles are not observed.
+  constexpr size_t num_fluid = 1000;
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               DiagnosticsEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 10)) {
+    sph::m[a] = 100.0, sph::rho[a] = 100.0, sph::v[a] = Vec{100.0, 0.0};
+  }
+  double i = 0.0;
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, num_fluid)) {
+    sph::m[a] = 1.0, sph::h[a] = 1.0, sph::rho[a] = i;
+    sph::v[a] = Vec{i, 0.0}, sph::dv_dt[a] = Vec{0.0, 0.0};
+    i += 1.0;
+  }
+
+  // Accumulate the fluid particles in parallel, as the integrators do.
+  sph::TimeStepController time_step{/*cs_0=*/1.0, /*CFL=*/1.0};
+  sph::Diagnostics diagnostics{sph::KineticEnergy{},
+                               sph::TotalMass{},
+                               sph::MaxVelocity{},
+                               sph::MeanDensity{},
+                               sph::StableTimeStep{time_step}};
+  par::for_each(particles.fluid(), [&diagnostics](auto a) { diagnostics(a); });
+  diagnostics.reduce();
+
+  // Check the values. Stable time step is `h / (cs_0 + max |v|)`.
+  const auto n = static_cast<double>(num_fluid);
+  CHECK(diagnostics.count() == num_fluid);
+  CHECK_APPROX_EQ(diagnostics.get<sph::TotalMass>(), n);
+  CHECK_APPROX_EQ(diagnostics.get<sph::MaxVelocity>(), n - 1.0);
+  CHECK_APPROX_EQ(diagnostics.get<sph::MeanDensity>(), (n - 1.0) / 2.0);
+  CHECK_APPROX_EQ(diagnostics.get<sph::KineticEnergy>(),
+                  (n - 1.0) * n * (2.0 * n - 1.0) / 12.0);
+  CHECK_APPROX_EQ(diagnostics.get<sph::StableTimeStep>(), 1.0 / n);
+
+  // Check that the time step controller accepts the reduced time step.
+  CHECK_APPROX_EQ(time_step(diagnostics.get<sph::StableTimeStep>()), 1.0 / n);
+
+  // Check that the partial results are reset.
+  diagnostics.reduce();
+  CHECK(diagnostics.count() == 0);
+  CHECK(diagnostics.get<sph::TotalMass>() == 0.0);
+}
+
+TEST_CASE("sph::NumUnstable") {
+  par::set_num_threads(4);
+
+  // Setup the stable particles, and break a few of them.
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               DiagnosticsEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 100)) {
+    sph::r[a] = Vec{1.0, 2.0}, sph::v[a] = Vec{0.0, 1.0}, sph::rho[a] = 1.0;
+  }
+  sph::Diagnostics diagnostics{sph::NumUnstable{}};
+  const auto count_unstable = [&particles, &diagnostics] {
+    par::for_each(particles.fluid(),
+                  [&diagnostics](auto a) { diagnostics(a); });
+    diagnostics.reduce();
+    return diagnostics.get<sph::NumUnstable>();
+  };
+  CHECK(count_unstable() == 0.0);
+  sph::v[particles[1]][0] = std::numeric_limits<double>::quiet_NaN();
+  sph::r[particles[2]][1] = std::numeric_limits<double>::infinity();
+  sph::rho[particles[3]] = -1.0;
+  sph::rho[particles[4]] = 0.0;
+  CHECK(count_unstable() == 4.0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,161 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+
+#include "tit/geom/partition.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Decomposition of the particles into the domains.
+///
+/// Each domain owns a single top-level partition of the particles. For each
+/// domain the decomposition provides the ghost particles, which belong to the
+/// other domains but are adjacent to the owned ones, and the migrants, which
+/// became owned by the domain since the previous update. These are the
+/// particles that must be received by the domain's owner in a distributed run.
+///
+/// @note Particle indices must not change between the updates, otherwise the
+///       migrants are not tracked.
+template<geom::partition_func PartitionFunc = geom::RecursiveInertialBisection>
+class DomainDecomposition final {
+public:
+
+  /// Construct a domain decomposition.
+  ///
+  /// @param num_domains    Number of domains.
+  /// @param partition_func Geometry partitioning function.
+  constexpr explicit DomainDecomposition(size_t num_domains,
+                                         PartitionFunc partition_func = {})
+      : num_domains_{num_domains}, partition_func_{std::move(partition_func)} {
+    TIT_ASSERT(num_domains_ > 0, "Number of domains must be positive!");
+  }
+
+  /// Number of domains.
+  constexpr auto num_domains() const noexcept -> size_t {
+    return num_domains_;
+  }
+
+  /// Domain that owns the particle.
+  constexpr auto owner(size_t index) const noexcept -> size_t {
+    TIT_ASSERT(index < owners_.size(), "Particle index is out of range!");
+    return owners_[index];
+  }
+
+  /// Particles owned by the domain.
+  constexpr auto owned(size_t domain) const noexcept {
+    TIT_ASSERT(domain < num_domains_, "Domain index is out of range!");
+    return owned_[domain];
+  }
+
+  /// Particles owned by the other domains within the kernel support radius of
+  /// the particles owned by the domain.
+  constexpr auto ghosts(size_t domain) const noexcept {
+    TIT_ASSERT(domain < num_domains_, "Domain index is out of range!");
+    return ghosts_[domain];
+  }
+
+  /// Particles that became owned by the domain since the previous update.
+  constexpr auto migrants(size_t domain) const noexcept {
+    TIT_ASSERT(domain < num_domains_, "Domain index is out of range!");
+    return migrants_[domain];
+  }
+
+  /// Update the decomposition.
+  ///
+  /// Particle mesh must be up to date with the particle array.
+  template<particle_mesh ParticleMesh, particle_array<r> ParticleArray>
+  void update(const ParticleMesh& mesh, ParticleArray& particles) {
+    TIT_PROFILE_SECTION("DomainDecomposition::update()");
+    TIT_ASSERT(particles.size() >= num_domains_,
+               "Number of particles cannot be less than number of domains!");
+
+    // Partition the particles into the domains.
+    const auto tracked = owners_.size() == particles.size();
+    std::swap(owners_, prev_owners_);
+    owners_.resize(particles.size());
+    partition_func_(r[particles], owners_, num_domains_);
+    owned_.assign_pairs_par_tall(
+        num_domains_,
+        std::views::iota(size_t{0}, particles.size()) |
+            std::views::transform([this](size_t a) {
+              return std::pair{owners_[a], a};
+            }));
+
+    // Collect the ghost particles and the migrants.
+    static thread_local std::vector<std::vector<size_t>> ghosts_buffer{};
+    static thread_local std::vector<std::vector<size_t>> migrants_buffer{};
+    auto& domain_ghosts = ghosts_buffer;
+    auto& domain_migrants = migrants_buffer;
+    domain_ghosts.resize(num_domains_);
+    domain_migrants.resize(num_domains_);
+    par::for_each( //
+        std::views::iota(size_t{0}, num_domains_),
+        [&domain_ghosts, &domain_migrants, &mesh, &particles, tracked, this](
+            size_t domain) {
+          auto& ghosts = domain_ghosts[domain];
+          ghosts.clear();
+          for (const auto a : owned_[domain]) {
+            for (const auto b : mesh[particles[a]]) {
+              if (owners_[b.index()] == domain) continue;
+              ghosts.push_back(b.index());
+            }
+          }
+          std::ranges::sort(ghosts);
+          const auto duplicates = std::ranges::unique(ghosts);
+          ghosts.erase(duplicates.begin(), duplicates.end());
+
+          auto& migrants = domain_migrants[domain];
+          migrants.clear();
+          if (!tracked) return;
+          std::ranges::copy_if(owned_[domain],
+                               std::back_inserter(migrants),
+                               [domain, this](size_t a) {
+                                 return prev_owners_[a] != domain;
+                               });
+        });
+    ghosts_.assign_buckets_par(domain_ghosts);
+    migrants_.assign_buckets_par(domain_migrants);
+
+    // Report the exchange sizes.
+    TIT_STATS("DomainDecomposition::ghosts_", ghosts_.bucket_sizes());
+    TIT_STATS("DomainDecomposition::migrants_", migrants_.bucket_sizes());
+  }
+
+private:
+
+  size_t num_domains_;
+  [[no_unique_address]] PartitionFunc partition_func_;
+  std::vector<size_t> owners_;
+  std::vector<size_t> prev_owners_;
+  Multivector<size_t> owned_;
+  Multivector<size_t> ghosts_;
+  Multivector<size_t> migrants_;
+
+}; // class DomainDecomposition
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
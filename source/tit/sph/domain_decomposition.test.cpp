@@ -0,0 +1,116 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/domain_decomposition.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the mesh.
+using MeshEquations = EquationsStub<meta::Set{sph::r, sph::h, sph::parinfo},
+                                    meta::Set{sph::r, sph::parinfo}>;
+
+TEST_CASE("sph::DomainDecomposition") {
+  constexpr size_t num_domains = 4;
+  constexpr double radius = 1.5;
+
+  // Setup the particles on a lattice.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh and the decomposition.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  sph::DomainDecomposition decomposition{num_domains};
+  decomposition.update(mesh, particles);
+  REQUIRE(decomposition.num_domains() == num_domains);
+
+  SUBCASE("owned") {
+    // Each particle must be owned by exactly one domain.
+    size_t num_owned = 0;
+    for (size_t domain = 0; domain < num_domains; ++domain) {
+      const auto owned = decomposition.owned(domain);
+      CHECK_FALSE(owned.empty());
+      for (const auto a : owned) CHECK(decomposition.owner(a) == domain);
+      num_owned += owned.size();
+    }
+    CHECK(num_owned == particles.size());
+  }
+
+  SUBCASE("ghosts") {
+    // Ghosts must be exactly the foreign particles within the radius of the
+    // owned particles.
+    for (size_t domain = 0; domain < num_domains; ++domain) {
+      std::vector<size_t> expected_ghosts{};
+      for (const auto a : particles.all()) {
+        if (decomposition.owner(a.index()) == domain) continue;
+        const auto is_ghost = std::ranges::any_of(
+            decomposition.owned(domain),
+            [&particles, a](size_t b) {
+              return norm(sph::r[a] - sph::r[particles[b]]) < radius;
+            });
+        if (is_ghost) expected_ghosts.push_back(a.index());
+      }
+      const auto ghosts = decomposition.ghosts(domain);
+      CHECK(std::ranges::equal(ghosts, expected_ghosts));
+    }
+  }
+
+  SUBCASE("migrants") {
+    // No migrants are reported on the first update.
+    for (size_t domain = 0; domain < num_domains; ++domain) {
+      CHECK(decomposition.migrants(domain).empty());
+    }
+
+    // Move the particles and update the decomposition. Migrants must be
+    // exactly the particles that have changed their owner.
+    std::vector<size_t> prev_owners(particles.size());
+    for (const auto a : particles.all()) {
+      prev_owners[a.index()] = decomposition.owner(a.index());
+      sph::r[a] = Vec{sph::r[a][1], 15.0 - sph::r[a][0]};
+    }
+    mesh.invalidate();
+    mesh.update(particles, [](auto /*a*/) { return radius; });
+    decomposition.update(mesh, particles);
+    for (size_t domain = 0; domain < num_domains; ++domain) {
+      std::vector<size_t> expected_migrants{};
+      for (const auto a : decomposition.owned(domain)) {
+        if (prev_owners[a] != domain) expected_migrants.push_back(a);
+      }
+      const auto migrants = decomposition.migrants(domain);
+      CHECK(std::ranges::equal(migrants, expected_migrants));
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -6,13 +6,16 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <concepts>
+#include <ranges>
 #include <utility>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/type_utils.hpp"
 
 #include "tit/sph/field.hpp"
@@ -22,6 +25,40 @@ namespace tit::sph {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Batch of particle views, that fits into a SIMD register.
+template<class Batch>
+concept particle_batch =
+    std::ranges::random_access_range<Batch> &&
+    particle_view<std::ranges::range_value_t<Batch>> &&
+    simd::supported_type<particle_num_t<std::ranges::range_value_t<Batch>>>;
+
+// SIMD register type for the particle batch.
+template<particle_batch Batch>
+using batch_reg_t = simd::Reg<
+    particle_num_t<std::ranges::range_value_t<Batch>>,
+    simd::max_reg_size_v<particle_num_t<std::ranges::range_value_t<Batch>>>>;
+
+// Gather the values of the batch particles into the SIMD register. Unused
+// lanes are filled with the given value.
+template<particle_batch Batch, class Func>
+auto gather_batch(Batch&& batch, const Func& func, auto fill) noexcept {
+  using Reg = batch_reg_t<Batch>;
+  using Num = particle_num_t<std::ranges::range_value_t<Batch>>;
+  static constexpr auto Size = simd::max_reg_size_v<Num>;
+  const auto count = std::ranges::size(batch);
+  TIT_ASSERT(count <= Size, "Batch is too large!");
+  std::array<Num, Size> lanes;
+  lanes.fill(static_cast<Num>(fill));
+  for (size_t k = 0; k < count; ++k) lanes[k] = func(batch[k]);
+  return Reg(lanes);
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Ideal gas equation of state.
 class IdealGasEquationOfState final {
 public:
@@ -52,6 +89,21 @@ public:
     return sqrt(gamma_ * (gamma_ - 1.0) * u[a]); // == sqrt(gamma * p / rho).
   }
 
+  /// Pressure and sound speed values for a batch of particles.
+  template<impl::particle_batch Batch>
+  auto pressure_and_sound_speed(Batch&& batch) const noexcept {
+    using Reg = impl::batch_reg_t<Batch>;
+    using Num = particle_num_t<std::ranges::range_value_t<Batch>>;
+    const auto rho_batch =
+        impl::gather_batch(batch, [](auto a) { return rho[a]; }, 1.0);
+    const auto u_batch =
+        impl::gather_batch(batch, [](auto a) { return u[a]; }, 0.0);
+    const Reg gamma_1(static_cast<Num>(gamma_ - 1.0));
+    const Reg gamma_gamma_1(static_cast<Num>(gamma_ * (gamma_ - 1.0)));
+    return std::pair{gamma_1 * rho_batch * u_batch,
+                     simd::sqrt(gamma_gamma_1 * u_batch)};
+  }
+
 private:
 
   real_t gamma_;
@@ -94,6 +146,18 @@ public:
     return sqrt(kappa_ * pow(rho[a], gamma_)); // == sqrt(gamma * p / rho).
   }
 
+  /// Pressure and sound speed values for a batch of particles.
+  template<impl::particle_batch Batch>
+  auto pressure_and_sound_speed(Batch&& batch) const noexcept {
+    using Reg = impl::batch_reg_t<Batch>;
+    using Num = particle_num_t<std::ranges::range_value_t<Batch>>;
+    const auto rho_batch =
+        impl::gather_batch(batch, [](auto a) { return rho[a]; }, 1.0);
+    const auto p_batch = Reg(static_cast<Num>(kappa_)) *
+                         simd::pow(rho_batch, static_cast<Num>(gamma_));
+    return std::pair{p_batch, simd::sqrt(p_batch)};
+  }
+
 private:
 
   real_t kappa_;
@@ -179,6 +243,26 @@ public:
     return cs_0_ * pow(rho_a / rho_0_, gamma_);
   }
 
+  /// Pressure and sound speed values for a batch of particles. With the
+  /// integer polytropic index, the power is computed without `exp`/`log`,
+  /// see `simd::pow`.
+  template<impl::particle_batch Batch>
+  auto pressure_and_sound_speed(Batch&& batch) const noexcept {
+    using Reg = impl::batch_reg_t<Batch>;
+    using Num = particle_num_t<std::ranges::range_value_t<Batch>>;
+    const auto B = rho_0_ * pow2(cs_0_) / gamma_;
+    const auto rho_batch = impl::gather_batch(
+        batch,
+        [this](auto a) { return correction_.corrected_density(a, rho_0_); },
+        rho_0_);
+    const auto rho_ratio_pow = simd::pow(
+        rho_batch / Reg(static_cast<Num>(rho_0_)), static_cast<Num>(gamma_));
+    return std::pair{
+        Reg(static_cast<Num>(p_0_)) +
+            Reg(static_cast<Num>(B)) * (rho_ratio_pow - Reg(Num{1.0})),
+        Reg(static_cast<Num>(cs_0_)) * rho_ratio_pow};
+  }
+
 private:
 
   real_t cs_0_;
@@ -230,6 +314,22 @@ public:
     return cs_0_;
   }
 
+  /// Pressure and sound speed values for a batch of particles.
+  template<impl::particle_batch Batch>
+  auto pressure_and_sound_speed(Batch&& batch) const noexcept {
+    using Reg = impl::batch_reg_t<Batch>;
+    using Num = particle_num_t<std::ranges::range_value_t<Batch>>;
+    const auto rho_batch = impl::gather_batch(
+        batch,
+        [this](auto a) { return correction_.corrected_density(a, rho_0_); },
+        rho_0_);
+    const Reg cs_0(static_cast<Num>(cs_0_));
+    return std::pair{Reg(static_cast<Num>(p_0_)) +
+                         cs_0 * cs_0 *
+                             (rho_batch - Reg(static_cast<Num>(rho_0_))),
+                     cs_0};
+  }
+
 private:
 
   real_t cs_0_;
@@ -241,13 +341,69 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Incompressible fluid "equation of state".
+///
+/// Pressure is not a function of the density, but the solution of the
+/// pressure Poisson equation, computed by the `ProjectionIntegrator`. The
+/// last projected pressure is kept as is.
+class IncompressibleEquationOfState final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{p};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{/*empty*/};
+
+  /// Construct an equation of state.
+  ///
+  /// @param cs_0 Reference sound speed, used by the artificial viscosity and
+  ///             the time step criteria. Unlike in the weakly-compressible
+  ///             case, it does not limit the time step, and may be of order
+  ///             of the expected velocity.
+  constexpr explicit IncompressibleEquationOfState(real_t cs_0) noexcept
+      : cs_0_{cs_0} {
+    TIT_ASSERT(cs_0_ > 0.0, "Reference sound speed must be positive!");
+  }
+
+  /// Pressure value.
+  template<particle_view<required_fields> PV>
+  constexpr auto pressure(PV a) const noexcept {
+    return p[a];
+  }
+
+  /// Sound speed value.
+  template<particle_view<required_fields> PV>
+  constexpr auto sound_speed(PV /*a*/) const noexcept {
+    return cs_0_;
+  }
+
+  /// Pressure and sound speed values for a batch of particles.
+  template<impl::particle_batch Batch>
+  auto pressure_and_sound_speed(Batch&& batch) const noexcept {
+    using Reg = impl::batch_reg_t<Batch>;
+    using Num = particle_num_t<std::ranges::range_value_t<Batch>>;
+    return std::pair{
+        impl::gather_batch(batch, [](auto a) { return p[a]; }, 0.0),
+        Reg(static_cast<Num>(cs_0_))};
+  }
+
+private:
+
+  real_t cs_0_;
+
+}; // class IncompressibleEquationOfState
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Equation of state type.
 template<class EOS>
 concept equation_of_state =
     std::same_as<EOS, IdealGasEquationOfState> ||
     std::same_as<EOS, AdiabaticIdealGasEquationOfState> ||
     specialization_of<EOS, TaitEquationOfState> ||
-    specialization_of<EOS, LinearTaitEquationOfState>;
+    specialization_of<EOS, LinearTaitEquationOfState> ||
+    std::same_as<EOS, IncompressibleEquationOfState>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
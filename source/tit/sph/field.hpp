@@ -15,6 +15,7 @@
 #include "tit/core/mat.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/type_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
@@ -39,6 +40,104 @@ concept has_field_ = with_fields_<PV> && meta::type<Field> &&
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Convert the field value between the value and the storage types.
+template<class To, class From>
+constexpr auto field_cast(const From& from) -> To {
+  if constexpr (std::same_as<To, From>) {
+    return from;
+  } else if constexpr (is_vec_v<To> && is_vec_v<From>) {
+    return vec_cast<vec_num_t<To>>(from);
+  } else if constexpr (is_mat_v<To> && is_mat_v<From>) {
+    To result{};
+    for (size_t i = 0; i < vec_dim_v<mat_row_t<To>>; ++i) {
+      result[i] = vec_cast<mat_num_t<To>>(from[i]);
+    }
+    return result;
+  } else {
+    return static_cast<To>(from);
+  }
+}
+
+/// Reference to the field value that is stored with a different type,
+/// typically of a reduced precision.
+///
+/// Value is converted to the field type on each read, and back to the storage
+/// type on each write, so that the computations are always performed in the
+/// field type.
+template<class Value, class Storage>
+class FieldRef final {
+public:
+
+  /// Construct a field reference.
+  constexpr explicit FieldRef(Storage& storage) noexcept
+      : storage_{&storage} {}
+
+  /// Field value.
+  constexpr auto get() const noexcept -> Value {
+    return field_cast<Value>(*storage_);
+  }
+
+  /// Field value.
+  constexpr operator Value() const noexcept { // NOLINT(*-explicit-*)
+    return get();
+  }
+
+  /// Assign the field value.
+  /// @{
+  constexpr auto operator=(const Value& value) const noexcept
+      -> const FieldRef& {
+    *storage_ = field_cast<Storage>(value);
+    return *this;
+  }
+  constexpr auto operator=(const FieldRef& other) const noexcept
+      -> const FieldRef& {
+    *storage_ = *other.storage_;
+    return *this;
+  }
+  /// @}
+
+  /// Update the field value.
+  /// @{
+  template<class Arg>
+  constexpr auto operator+=(const Arg& arg) const noexcept -> const FieldRef& {
+    return *this = static_cast<Value>(get() + arg);
+  }
+  template<class Arg>
+  constexpr auto operator-=(const Arg& arg) const noexcept -> const FieldRef& {
+    return *this = static_cast<Value>(get() - arg);
+  }
+  template<class Arg>
+  constexpr auto operator*=(const Arg& arg) const noexcept -> const FieldRef& {
+    return *this = static_cast<Value>(get() * arg);
+  }
+  template<class Arg>
+  constexpr auto operator/=(const Arg& arg) const noexcept -> const FieldRef& {
+    return *this = static_cast<Value>(get() / arg);
+  }
+  /// @}
+
+private:
+
+  Storage* storage_;
+
+}; // class FieldRef
+
+namespace impl {
+
+// Unwrap the field reference into the field value.
+template<class Ref>
+constexpr auto field_value_of_(Ref&& ref) -> decltype(auto) {
+  if constexpr (specialization_of<std::remove_cvref_t<Ref>, FieldRef>) {
+    return ref.get();
+  } else {
+    return std::forward<Ref>(ref);
+  }
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Base field specification.
 class BaseField {
 public:
@@ -55,26 +154,32 @@ public:
   constexpr auto get(this const Self& self,
                      PV&& a,
                      Default&& default_val) noexcept -> decltype(auto) {
-    if constexpr (impl::has_field_<PV, Self>) return std::forward<PV>(a)[self];
-    else return std::forward<Default>(default_val);
+    if constexpr (impl::has_field_<PV, Self>) {
+      return impl::field_value_of_(std::forward<PV>(a)[self]);
+    } else return std::forward<Default>(default_val);
   }
 
-  /// Field value delta for the specified particle view.
+  /// Field value delta for the specified particle views. If the particle
+  /// array wraps the deltas, e.g. the periodic positions, it is wrapped.
   template<class Self, impl::has_field_<Self> PVa, impl::has_field_<Self> PVb>
   constexpr auto operator[](this const Self& self, PVa&& a, PVb&& b) noexcept {
-    return std::forward<PVa>(a)[self] - std::forward<PVb>(b)[self];
+    auto delta =
+        impl::field_value_of_(a[self]) - impl::field_value_of_(b[self]);
+    if constexpr (requires { a.array().wrap_delta(self, delta); }) {
+      return a.array().wrap_delta(self, delta);
+    } else return delta;
   }
 
   /// Average of the field values over the specified particle views.
   template<class Self, impl::has_field_<Self>... PVs>
   constexpr auto avg(this const Self& self, PVs&&... ai) {
-    return tit::avg(std::forward<PVs>(ai)[self]...);
+    return tit::avg(impl::field_value_of_(std::forward<PVs>(ai)[self])...);
   }
 
   /// Harmonic average of the field values over the specified particle views.
   template<class Self, impl::has_field_<Self>... PVs>
   constexpr auto havg(this const Self& self, PVs&&... ai) {
-    return tit::havg(std::forward<PVs>(ai)[self]...);
+    return tit::havg(impl::field_value_of_(std::forward<PVs>(ai)[self])...);
   }
 
 }; // class BaseField
@@ -96,9 +201,19 @@ inline constexpr bool is_field_set_v<meta::Set<Fields...>> = true;
 template<class FieldSet>
 concept field_set = impl::is_field_set_v<FieldSet>;
 
+namespace impl {
+template<class Real, class StorageReal = Real>
+using field_storage_num_t =
+    std::conditional_t<(sizeof(StorageReal) < sizeof(Real)), StorageReal, Real>;
+} // namespace impl
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Declare a particle field.
+///
+/// Optional argument specifies the number type the field values are stored
+/// with. It is only used if it is narrower than the computation number type,
+/// and the values are converted on each access, see `FieldRef`.
 #define TIT_DEFINE_FIELD(type, name, ...)                                      \
   class name##_t final : public BaseField {                                    \
   public:                                                                      \
@@ -110,8 +225,14 @@ concept field_set = impl::is_field_set_v<FieldSet>;
     template<class Real, size_t Dim>                                           \
     using field_value_type = type;                                             \
                                                                                \
+    /** Field storage type. */                                                 \
+    template<class Real, size_t Dim>                                           \
+    using field_storage_type = field_value_type<                               \
+        ::tit::impl::field_storage_num_t<Real __VA_OPT__(, __VA_ARGS__)>,      \
+        Dim>;                                                                  \
+                                                                               \
   }; /* class name##_t */                                                      \
-  inline constexpr name##_t name __VA_OPT__(, __VA_ARGS__);
+  inline constexpr name##_t name;
 
 /// Declare a scalar particle field.
 #define TIT_DEFINE_SCALAR_FIELD(name, ...)                                     \
@@ -125,6 +246,10 @@ concept field_set = impl::is_field_set_v<FieldSet>;
 #define TIT_DEFINE_MATRIX_FIELD(name, ...)                                     \
   TIT_DEFINE_FIELD(TIT_PASS(Mat<Real, Dim>), name __VA_OPT__(, __VA_ARGS__))
 
+/// Declare a symmetric matrix particle field, with the packed storage.
+#define TIT_DEFINE_SYM_MATRIX_FIELD(name, ...)                                 \
+  TIT_DEFINE_FIELD(TIT_PASS(SymMat<Real, Dim>), name __VA_OPT__(, __VA_ARGS__))
+
 /// Field name.
 template<meta::type Field>
 inline constexpr auto field_name_v = std::remove_cvref_t<Field>::field_name;
@@ -158,12 +283,28 @@ struct field_value<Field, Space<Real, Dim>> {
 template<meta::type Field, class Space>
 using field_value_t = typename field_value<Field, Space>::type;
 
+template<meta::type Field, class Space>
+struct field_storage;
+
+template<meta::type Field, class Real, size_t Dim>
+struct field_storage<Field, Space<Real, Dim>> {
+  using type = typename std::remove_cvref_t<
+      Field>::template field_storage_type<Real, Dim>;
+};
+
+/// Field storage type.
+template<meta::type Field, class Space>
+using field_storage_t = typename field_storage<Field, Space>::type;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-/// Particle partition index.
-using PartIndex = uint8_t;
+/// Particle partition index. Index is 16-bit wide, so that the partitioning
+/// levels of the many-core nodes fit, see `ParticleMesh::partition()`.
+using PartIndex = uint16_t;
 
-/// Particle multilevel partition index.
+/// Particle multilevel partition index. Indices of all the levels fit into a
+/// single 128-bit register, so the common index is found with a single
+/// SIMD comparison.
 class PartVec final {
 public:
 
@@ -215,11 +356,30 @@ constexpr void serialize(Stream& out, const PartVec& pvec) {
 /// Particle partition information.
 TIT_DEFINE_FIELD(PartVec, parinfo)
 
+/// Number of the adjacent particles.
+TIT_DEFINE_FIELD(uint32_t, num_neighbors)
+/// Number of the particles used for interpolation for the fixed particle.
+TIT_DEFINE_FIELD(uint32_t, num_interp)
+/// Number of the pairs in the block of the particle, relative to the average
+/// block of the same partitioning level.
+TIT_DEFINE_FIELD(float32_t, block_load)
+
+/// Diagnostic particle fields, filled by `ParticleMesh` on each rebuild, if
+/// they are present in the particle array (except in the listless mode).
+/// They show where the work goes, e.g. why a case is slow or imbalanced.
+inline constexpr meta::Set diagnostic_fields{num_neighbors,
+                                             num_interp,
+                                             block_load};
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 namespace sph {
 /// Particle position.
 TIT_DEFINE_VECTOR_FIELD(r)
+/// Particle persistent identifier. Identifiers are assigned on appending,
+/// and are carried along by all the reorderings of the particle array, so
+/// the particles can be tracked across the output time steps.
+TIT_DEFINE_FIELD(uint64_t, id)
 } // namespace sph
 TIT_DEFINE_VECTOR_FIELD(dr)
 
@@ -245,11 +405,13 @@ TIT_DEFINE_SCALAR_FIELD(drho_dt)
 
 /// Particle width.
 TIT_DEFINE_SCALAR_FIELD(h)
+/// Particle width gradient correction factor, see `SmoothingLengthSolver`.
+TIT_DEFINE_SCALAR_FIELD(Omega)
 
 /// Particle pressure.
 TIT_DEFINE_SCALAR_FIELD(p)
 /// Particle sound speed.
-TIT_DEFINE_SCALAR_FIELD(cs)
+TIT_DEFINE_SCALAR_FIELD(cs, float32_t)
 
 /// Particle thermal energy.
 TIT_DEFINE_SCALAR_FIELD(u)
@@ -263,20 +425,29 @@ TIT_DEFINE_SCALAR_FIELD(mu)
 TIT_DEFINE_SCALAR_FIELD(kappa)
 
 /// Particle artificial viscosity switch.
-TIT_DEFINE_SCALAR_FIELD(alpha)
+TIT_DEFINE_SCALAR_FIELD(alpha, float32_t)
 /// Particle artificial viscosity switch time derivative.
-TIT_DEFINE_SCALAR_FIELD(dalpha_dt)
+TIT_DEFINE_SCALAR_FIELD(dalpha_dt, float32_t)
 
 /// Particle concentration value.
 TIT_DEFINE_SCALAR_FIELD(C)
 /// Particle normal vector.
 TIT_DEFINE_VECTOR_FIELD(N)
 /// Particle renormalization matrix.
-TIT_DEFINE_MATRIX_FIELD(L)
+TIT_DEFINE_SYM_MATRIX_FIELD(L)
+/// Packed LDL factors of the particle renormalization matrix, that are
+/// cached between the renormalization matrix updates, see `ldl_batch`.
+TIT_DEFINE_SYM_MATRIX_FIELD(L_ldl)
 
 /// Particle free surface flag.
 TIT_DEFINE_SCALAR_FIELD(FS)
 
+/// Particle time bin (the particle time step is `dt / 2^time_bin`).
+TIT_DEFINE_FIELD(uint8_t, time_bin)
+/// Number of the consecutive steps the particle stayed quiet, see
+/// `SleepController`.
+TIT_DEFINE_FIELD(uint8_t, quiet_steps)
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
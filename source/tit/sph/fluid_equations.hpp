@@ -6,17 +6,35 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <concepts>
+#include <functional>
 #include <limits>
 #include <numbers>
+#include <optional>
 #include <ranges>
-
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/mat.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/meta.hpp"
 #include "tit/core/par/algorithms.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/stats.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/sparse/matrix.hpp"
+#include "tit/sparse/multigrid.hpp"
+
+#include "tit/sph/block_schedule.hpp"
 #include "tit/sph/continuity_equation.hpp"
 #include "tit/sph/energy_equation.hpp"
 #include "tit/sph/equation_of_state.hpp"
@@ -31,13 +49,57 @@ namespace tit::sph {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Particle pair evaluation strategy.
+enum class PairStrategy : uint8_t {
+  /// Each unique pair is visited once, and the contributions are scattered to
+  /// both particles. Pairs are processed by the mesh blocks.
+  scatter,
+
+  /// Each particle visits all of its neighbors and gathers the contributions
+  /// into itself only. This doubles the pair evaluations, but requires
+  /// neither the partitioning nor the barriers.
+  gather,
+};
+
+/// Evaluation strategy of the velocity divergence and curl, that are used by
+/// the artificial viscosity switches.
+enum class SwitchEvaluation : uint8_t {
+  /// Divergence and curl are evaluated for all particles.
+  full,
+
+  /// Divergence and curl are evaluated only for the compressed particles,
+  /// those with the positive density time derivative, by gathering over
+  /// their neighbors. For the rest of the particles, the divergence is
+  /// estimated from the continuity equation as `-drho_dt / rho`, and the
+  /// curl is set to zero. Requires the density time derivative.
+  sparse,
+};
+
+/// Wall boundary model, i.e. the treatment of the fixed particles.
+enum class BoundaryModel : uint8_t {
+  /// Field values of the fixed particles are interpolated from the fluid
+  /// particles near their ghost points, mirrored through the wall. Requires
+  /// the search for the interpolation points and the interpolation weights.
+  interpolation,
+
+  /// Dynamic boundary particles. Fixed particles evolve their density via
+  /// the continuity equation, and their pressure via the equation of state,
+  /// just like the fluid ones, while their positions and velocities are held
+  /// fixed. No interpolation is required, at the cost of the less accurate
+  /// wall pressure and the wider gap between the fluid and the wall.
+  dynamic,
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Fluid equations with fixed kernel width and continuity equation.
 template<motion_equation MotionEquation,
          continuity_equation ContinuityEquation,
          momentum_equation MomentumEquation,
          energy_equation EnergyEquation,
          equation_of_state EquationOfState,
-         kernel Kernel>
+         kernel Kernel,
+         class Boundary>
 class FluidEquations final {
 public:
 
@@ -60,11 +122,21 @@ public:
       EnergyEquation::modified_fields |            //
       EquationOfState::modified_fields |           //
       Kernel::modified_fields |                    //
-      meta::Set{rho, drho_dt, grad_rho, C, N, L} | //
+      meta::Set{rho, drho_dt, grad_rho, C, N, L, L_ldl} | //
       meta::Set{p, v, dv_dt, div_v, curl_v} |      //
       meta::Set{u, du_dt} |                        //
       meta::Set{dr, FS};
 
+  /// Set of particle fields that are read for each neighbor in the density
+  /// and the force passes. These are the candidates for being stored in
+  /// tiles, see `AoSoALayout`.
+  static constexpr meta::Set pair_fields{h, m, r, rho, p, v};
+
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  /// These are stored for the fluid particles only, see
+  /// `ParticleArray::fluid_fields`.
+  static constexpr meta::Set fluid_fields{dr};
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Construct the fluid equations.
@@ -75,18 +147,80 @@ public:
   /// @param energy_equation     Energy equation.
   /// @param equation_of_state   Equation of state.
   /// @param kernel              Kernel.
-  constexpr explicit FluidEquations(MotionEquation motion_equation,
-                                    ContinuityEquation continuity_equation,
-                                    MomentumEquation momentum_equation,
-                                    EnergyEquation energy_equation,
-                                    EquationOfState eos,
-                                    Kernel kernel) noexcept
+  /// @param boundary            Wall boundary.
+  /// @param pair_strategy       Particle pair evaluation strategy.
+  /// @param switch_evaluation   Velocity divergence and curl evaluation.
+  /// @param renormalization_max_disp Maximum particle displacement between
+  ///                            the renormalization matrix updates, see
+  ///                            `renormalization_max_disp()`.
+  /// @param boundary_model      Wall boundary model.
+  constexpr explicit FluidEquations(
+      MotionEquation motion_equation,
+      ContinuityEquation continuity_equation,
+      MomentumEquation momentum_equation,
+      EnergyEquation energy_equation,
+      EquationOfState eos,
+      Kernel kernel,
+      Boundary boundary,
+      PairStrategy pair_strategy = PairStrategy::scatter,
+      SwitchEvaluation switch_evaluation = SwitchEvaluation::full,
+      float64_t renormalization_max_disp = 0.0,
+      BoundaryModel boundary_model = BoundaryModel::interpolation) noexcept
       : motion_equation_{std::move(motion_equation)},
         continuity_equation_{std::move(continuity_equation)},
         momentum_equation_{std::move(momentum_equation)},
         energy_equation_{std::move(energy_equation)}, //
         eos_{std::move(eos)},                         //
-        kernel_{std::move(kernel)} {}
+        kernel_{std::move(kernel)}, boundary_{std::move(boundary)},
+        pair_strategy_{pair_strategy}, switch_evaluation_{switch_evaluation},
+        renormalization_max_disp_{renormalization_max_disp},
+        boundary_model_{boundary_model} {
+    TIT_ASSERT(renormalization_max_disp_ >= 0.0,
+               "Maximum displacement must be non-negative!");
+  }
+
+  /// Particle pair evaluation strategy.
+  constexpr auto pair_strategy() const noexcept -> PairStrategy {
+    return pair_strategy_;
+  }
+
+  /// Velocity divergence and curl evaluation strategy.
+  constexpr auto switch_evaluation() const noexcept -> SwitchEvaluation {
+    return switch_evaluation_;
+  }
+
+  /// Maximum particle displacement between the renormalization matrix
+  /// updates.
+  ///
+  /// Renormalization matrices depend only on the relative particle positions
+  /// and volumes, which change slowly. If the displacement is positive, the
+  /// matrices and their LDL factorizations, cached in the `L_ldl` field, are
+  /// only recomputed on the mesh rebuilds, or once the particles may have
+  /// moved farther than that since the last recomputation. Infinity restricts
+  /// the updates to the mesh rebuilds. Zero (default) recomputes the matrices
+  /// on every density evaluation.
+  constexpr auto renormalization_max_disp() const noexcept -> float64_t {
+    return renormalization_max_disp_;
+  }
+
+  /// Wall boundary model.
+  constexpr auto boundary_model() const noexcept -> BoundaryModel {
+    return boundary_model_;
+  }
+
+  /// Iterate through the particles that are integrated in time in parallel:
+  /// the fluid particles, and, with the dynamic boundary model, the fixed
+  /// ones. Velocity and internal energy time derivatives of the fixed
+  /// particles are zeroed by the force passes, so only their density
+  /// evolves.
+  template<particle_array ParticleArray,
+           std::invocable<ParticleView<ParticleArray>> Func>
+  void integrated_for_each(ParticleArray& particles, const Func& func) const {
+    par::for_each(particles.fluid(), func);
+    if (boundary_model_ == BoundaryModel::dynamic) {
+      par::for_each(particles.fixed(), func);
+    }
+  }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -107,81 +241,105 @@ public:
            particle_array<required_fields> ParticleArray>
   auto index(ParticleMesh& mesh, ParticleArray& particles) const {
     using PV = ParticleView<ParticleArray>;
-    mesh.update(particles, [this](PV a) { return kernel_.radius(a); });
+    mesh.enable_interp_search(boundary_model_ == BoundaryModel::interpolation);
+    mesh.update(
+        particles,
+        [this](PV a) { return kernel_.radius(a); },
+        [this](PV a) { return boundary_.ghost(r[a]); });
+  }
+
+  /// Start the speculative neighbor search for the next mesh rebuild, see
+  /// `ParticleMesh::speculate`. This must be called once per time step.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void speculate(ParticleMesh& mesh,
+                 ParticleArray& particles,
+                 particle_num_t<ParticleArray> dt) const {
+    using PV = ParticleView<ParticleArray>;
+    mesh.speculate(
+        particles,
+        [this](PV a) { return kernel_.radius(a); },
+        dt);
+  }
+
+  /// Prune the particle pairs out of the kernel support, if the pruning of
+  /// the mesh is enabled, and cache the kernel values and gradients for the
+  /// remaining pairs, if the pair cache of the mesh is enabled. This must be
+  /// called every time the particle positions change.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void cache_pairs(ParticleMesh& mesh, ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+    if (mesh.listless()) return;
+    if (mesh.pruning_enabled()) {
+      mesh.prune(particles, [this](PV a) { return kernel_.radius(a); });
+    }
+    if (!mesh.pair_cache_enabled()) return;
+    const auto& kernel = pass_kernel_(particles);
+    mesh.cache_pairs(particles, [&kernel](PV a, PV b) {
+      return std::pair{kernel(a, b), kernel.grad(a, b)};
+    });
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Setup boundary particles.
+  ///
+  /// If the interpolation cache of the mesh is enabled, the interpolation
+  /// weights are computed once per the interpolation point search and reused
+  /// by the subsequent calls. With the dynamic boundary model, there is
+  /// nothing to setup.
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
   void setup_boundary(ParticleMesh& mesh, ParticleArray& particles) const {
     TIT_PROFILE_SECTION("FluidEquations::setup_boundary()");
     using PV = ParticleView<ParticleArray>;
     using Num = particle_num_t<ParticleArray>;
-    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    if (boundary_model_ == BoundaryModel::dynamic) return;
+
+    // Cache the interpolation weights, if necessary.
+    const auto compute_weights = [this, &mesh, &particles](
+                                     PV b,
+                                     std::span<float64_t> weights) {
+      return interp_weights_(mesh, particles, b, weights);
+    };
+    if (mesh.interp_cache_enabled() && !mesh.interp_cached()) {
+      mesh.cache_interp(particles, compute_weights);
+    }
 
     // Interpolate the field values on the boundary.
-    par::for_each(particles.fixed(), [this, &mesh](PV b) {
-      /// @todo Once we have a proper geometry library, we should use
-      ///       here and clean up the code.
-      const auto& search_point = r[b];
-      const auto clipped_point = Domain.clamp(search_point);
-      const auto r_ghost = 2 * clipped_point - search_point;
-      const auto SN = normalize(search_point - clipped_point);
-      const auto SD = norm(r_ghost - r[b]);
+    par::for_each(particles.fixed(), [this, &mesh, &compute_weights](PV b) {
+      // Leave the particle as it is, if it was culled by the mesh.
+      if (mesh.culled(b)) return;
 
-      // Compute the interpolation weights, both for the constant and
-      // linear interpolations.
-      Num S{};
-      Mat<Num, Dim + 1> M{};
-      const auto h_ghost = RADIUS_SCALE * h[b];
-      for (const PV a : mesh.fixed_interp(b)) {
-        const auto r_delta = r_ghost - r[a];
-        const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
-        const auto W_delta = kernel_(r_delta, h_ghost);
-        S += W_delta * m[a] / rho[a];
-        M += outer(B_delta, B_delta * W_delta * m[a] / rho[a]);
+      std::span<const float64_t> weights;
+      if (mesh.interp_cache_enabled()) {
+        weights = mesh.interp_weights(b);
+      } else {
+        static thread_local std::vector<float64_t> weights_buffer{};
+        weights_buffer.resize(std::ranges::size(mesh.fixed_interp(b)));
+        if (compute_weights(b, weights_buffer)) weights = weights_buffer;
       }
 
-      if (const auto fact = ldl(M); fact) {
-        // Linear interpolation succeeds, use it.
-        rho[b] = {};
-        v[b] = {};
-        if constexpr (has<PV>(u)) u[b] = {};
-        const auto E = fact->solve(unit<0>(M[0]));
-        for (const PV a : mesh.fixed_interp(b)) {
-          const auto r_delta = r_ghost - r[a];
-          const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
-          const auto W_delta = dot(E, B_delta) * kernel_(r_delta, h_ghost);
-          rho[b] += m[a] * W_delta;
-          v[b] += m[a] / rho[a] * v[a] * W_delta;
-          if constexpr (has<PV>(u)) u[b] += m[a] / rho[a] * u[a] * W_delta;
-        }
-      } else if (!is_tiny(S)) {
-        // Constant interpolation succeeds, use it.
-        rho[b] = {};
-        v[b] = {};
-        if constexpr (has<PV>(u)) u[b] = {};
-        const auto E = inverse(S);
-        for (const PV a : mesh.fixed_interp(b)) {
-          const auto r_delta = r_ghost - r[a];
-          const auto W_delta = E * kernel_(r_delta, h_ghost);
-          rho[b] += m[a] * W_delta;
-          v[b] += m[a] / rho[a] * v[a] * W_delta;
-          if constexpr (has<PV>(u)) u[b] += m[a] / rho[a] * u[a] * W_delta;
-        }
-      } else {
-        // Both interpolations fail, leave the particle as it is.
-        return;
+      // Leave the particle as it is, if the interpolation fails.
+      if (weights.empty()) return;
+
+      // Interpolate the field values.
+      rho[b] = {};
+      v[b] = {};
+      if constexpr (has<PV>(u)) u[b] = {};
+      for (size_t i = 0; const PV a : mesh.fixed_interp(b)) {
+        const auto W_delta = static_cast<Num>(weights[i++]);
+        rho[b] += m[a] * W_delta;
+        v[b] += m[a] / rho[a] * v[a] * W_delta;
+        if constexpr (has<PV>(u)) u[b] += m[a] / rho[a] * u[a] * W_delta;
       }
 
       // Compute the density at the boundary.
-      // drho/dn = rho_0/(cs_0^2)*dot(g,n).
-      constexpr auto rho_0 = 1000.0;
-      constexpr auto cs_0 = 20 * sqrt(9.81 * 0.6);
-      constexpr auto G = Vec{0.0, -9.81};
-      rho[b] += SD * rho_0 / pow2(cs_0) * dot(G, SN);
+      const auto r_ghost = boundary_.ghost(r[b]);
+      const auto SN = boundary_.normal(r[b]);
+      const auto SD = norm(r_ghost - r[b]);
+      rho[b] += SD * dot(boundary_.grad_rho_0(), SN);
 
       // Compute the velocity at the boundary (slip wall boundary condition).
       const auto Vn = dot(v[b], SN) * SN;
@@ -197,92 +355,80 @@ public:
            particle_array<required_fields> ParticleArray>
   void compute_density(ParticleMesh& mesh, ParticleArray& particles) const {
     TIT_PROFILE_SECTION("FluidEquations::compute_density()");
+    const auto throughput =
+        throughput_("FluidEquations::compute_density()", mesh, particles);
     using PV = ParticleView<ParticleArray>;
 
     // Clean-up continuity equation fields and apply source terms.
-    par::for_each(particles.all(), [this](PV a) {
-      // Clean-up continuity equation fields.
-      drho_dt[a] = {};
-      if constexpr (has<PV>(grad_rho)) grad_rho[a] = {};
-      if constexpr (has<PV>(C)) C[a] = {};
-      if constexpr (has<PV>(N)) N[a] = {};
-      if constexpr (has<PV>(L)) L[a] = {};
-
-      // Apply continuity equation source terms.
-      std::apply([a](const auto&... f) { ((drho_dt[a] += f(a)), ...); },
-                 continuity_equation_.mass_sources());
-    });
+    const auto update_L = needs_renormalization_update_<PV>(mesh);
+    par::for_each(
+        particles.all(),
+        [update_L, this](PV a) { init_density_(a, update_L); },
+        particles_affinity_);
 
     // Compute density gradient and renormalization fields.
     if constexpr (has<PV>(grad_rho) || has<PV>(C) || has<PV>(N) || has<PV>(L)) {
       // Precompute the fields.
-      par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-        const auto [a, b] = ab;
-        const auto V_a = m[a] / rho[a];
-        const auto V_b = m[b] / rho[b];
-        [[maybe_unused]] const auto W_ab = kernel_(a, b);
-        [[maybe_unused]] const auto grad_W_ab = kernel_.grad(a, b);
-
-        // Update density gradient.
-        if constexpr (has<PV>(grad_rho)) {
-          const auto grad_flux = rho[b, a] * grad_W_ab;
-          grad_rho[a] += V_b * grad_flux;
-          grad_rho[b] += V_a * grad_flux;
-        }
-
-        // Update concentration.
-        if constexpr (has<PV>(C)) {
-          const auto C_flux = W_ab;
-          C[a] += V_b * C_flux;
-          C[b] += V_a * C_flux;
-        }
-
-        // Update normal vector.
-        if constexpr (has<PV>(N)) {
-          N[a] += V_b * grad_W_ab;
-          N[b] -= V_a * grad_W_ab;
-        }
-
-        // Update renormalization matrix.
-        if constexpr (has<PV>(L)) {
-          const auto L_flux = outer(r[b, a], grad_W_ab);
-          L[a] += V_b * L_flux;
-          L[b] += V_a * L_flux;
-        }
-      });
-
-      // Renormalize fields.
-      par::for_each(particles.all(), [](PV a) {
-        // Renormalize density, if possible.
-        if constexpr (has<PV>(C)) {
-          if (!is_tiny(C[a])) rho[a] /= C[a];
-        }
-
-        // Renormalize density gradient and normal vector, if possible.
-        if constexpr (has<PV>(L) && (has<PV>(N) || has<PV>(grad_rho))) {
-          if (const auto fact = ldl(L[a]); fact) {
-            if constexpr (has<PV>(N)) N[a] = fact->solve(N[a]);
-            if constexpr (has<PV>(grad_rho))
-              grad_rho[a] = fact->solve(grad_rho[a]);
-          }
-        }
-
-        // Finalize the normal vector.
-        if constexpr (has<PV>(N)) N[a] = normalize(N[a]);
-      });
+      block_pairs_for_each_</*WithValue=*/has<PV>(C)>(
+          mesh,
+          particles,
+          [update_L](auto a,
+                     auto b,
+                     [[maybe_unused]] auto W_ab,
+                     [[maybe_unused]] const auto& grad_W_ab,
+                     auto scatter) {
+            [[maybe_unused]] const auto V_a = m[a] / rho[a];
+            const auto V_b = m[b] / rho[b];
+
+            // Update density gradient.
+            if constexpr (has<PV>(grad_rho)) {
+              const auto grad_flux = rho[b, a] * grad_W_ab;
+              grad_rho[a] += V_b * grad_flux;
+              if constexpr (scatter) grad_rho[b] += V_a * grad_flux;
+            }
+
+            // Update concentration.
+            if constexpr (has<PV>(C)) {
+              const auto C_flux = W_ab;
+              C[a] += V_b * C_flux;
+              if constexpr (scatter) C[b] += V_a * C_flux;
+            }
+
+            // Update normal vector.
+            if constexpr (has<PV>(N)) {
+              N[a] += V_b * grad_W_ab;
+              if constexpr (scatter) N[b] -= V_a * grad_W_ab;
+            }
+
+            // Update renormalization matrix.
+            if constexpr (has<PV>(L)) {
+              if (!update_L) return;
+              const auto L_flux = sym_outer(r[b, a], grad_W_ab);
+              L[a] += V_b * L_flux;
+              if constexpr (scatter) L[b] += V_a * L_flux;
+            }
+          });
+
+      // Renormalize fields, processing the particles in batches.
+      using Num = particle_num_t<ParticleArray>;
+      static constexpr auto BatchSize = simd::max_reg_size_v<Num>;
+      par::for_each(
+          std::views::chunk(particles.all(), BatchSize),
+          [update_L](auto batch) {
+            renormalize_density_batch_(batch, update_L);
+          },
+          batches_affinity_);
     }
 
     // Compute density time derivative.
-    par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-      const auto [a, b] = ab;
-      const auto grad_W_ab = kernel_.grad(a, b);
-
-      // Update density time derivative.
-      const auto Psi_ab =
-          momentum_equation_.artificial_viscosity().density_term(a, b);
-      drho_dt[a] -= m[b] * dot(v[b, a] - Psi_ab / rho[b], grad_W_ab);
-      drho_dt[b] -= m[a] * dot(v[b, a] + Psi_ab / rho[a], grad_W_ab);
-    });
+    block_pairs_for_each_(
+        mesh,
+        particles,
+        [this](auto a,
+               auto b,
+               auto /*W_ab*/,
+               const auto& grad_W_ab,
+               auto scatter) { density_pair_(a, b, grad_W_ab, scatter); });
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -291,89 +437,141 @@ public:
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
   void compute_forces(ParticleMesh& mesh, ParticleArray& particles) const {
+    compute_forces(mesh, particles, NoUpdate_{});
+  }
+
+  /// Compute velocity related fields, and then update each particle that is
+  /// integrated in time with `update(a)`, see `integrated_for_each`.
+  ///
+  /// Same as `compute_forces` followed by a pass over the particles,
+  /// but with the scatter strategy and the level schedule the update is
+  /// fused into the force pass: a particle is updated right after the last
+  /// block that touches it is processed, while its fields are still in
+  /// cache, see `ParticleMesh::final_blocks`. Update must modify the fields
+  /// of its particle only.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           std::invocable<ParticleView<ParticleArray>> Update>
+  void compute_forces(ParticleMesh& mesh,
+                      ParticleArray& particles,
+                      const Update& update) const {
     TIT_PROFILE_SECTION("FluidEquations::compute_forces()");
+    const auto throughput =
+        throughput_("FluidEquations::compute_forces()", mesh, particles);
     using PV = ParticleView<ParticleArray>;
 
     // Clean-up momentum and energy equation fields, compute pressure,
     // sound speed and apply source terms.
-    par::for_each(particles.all(), [this](PV a) {
-      // Clean-up momentum and energy equation fields.
-      dv_dt[a] = {};
-      if constexpr (has<PV>(div_v)) div_v[a] = {};
-      if constexpr (has<PV>(curl_v)) curl_v[a] = {};
-      if constexpr (has<PV>(du_dt)) du_dt[a] = {};
-
-      // Apply source terms.
-      std::apply(
-          [a](const auto&... g) {
-            ((dv_dt[a] += g(a)), ...);
-            if constexpr (has<PV>(du_dt)) ((du_dt[a] += dot(g(a), v[a])), ...);
-          },
-          momentum_equation_.momentum_sources());
-      if constexpr (has<PV>(du_dt)) {
-        std::apply([a](const auto&... q) { ((du_dt[a] += q(a)), ...); },
-                   energy_equation_.energy_sources());
-      }
-
-      // Compute pressure and sound speed.
-      p[a] = eos_.pressure(a);
-      if constexpr (has<PV>(cs)) cs[a] = eos_.sound_speed(a);
-    });
-
-    // Compute velocity divergence and curl.
-    // Those fields may be required by the artificial viscosity.
+    par::for_each(
+        particles.all(),
+        [this](PV a) { init_forces_(a); },
+        particles_affinity_);
+    compute_pressure_(particles);
+
+    // Compute velocity divergence and curl, and then the velocity and
+    // internal energy time derivatives. Divergence and curl may be required
+    // by the artificial viscosity, so the passes are chained: forces of a
+    // block are computed once the divergence and curl of its particles are.
     if constexpr (has<PV>(div_v) || has<PV>(curl_v)) {
-      par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-        const auto [a, b] = ab;
-        const auto V_a = m[a] / rho[a];
-        const auto V_b = m[b] / rho[b];
-        const auto grad_W_ab = kernel_.grad(a, b);
-
-        // Update velocity divergence.
-        if constexpr (has<PV>(div_v)) {
-          const auto div_flux = dot(v[b, a], grad_W_ab);
-          div_v[a] += V_b * div_flux;
-          div_v[b] += V_a * div_flux;
-        }
-
-        // Update velocity curl.
-        if constexpr (has<PV>(curl_v)) {
-          const auto curl_flux = -cross(v[b, a], grad_W_ab);
-          curl_v[a] += V_b * curl_flux;
-          curl_v[b] += V_a * curl_flux;
-        }
-      });
+      const auto velocity_derivatives_pair =
+          [](auto a,
+             auto b,
+             auto /*W_ab*/,
+             const auto& grad_W_ab,
+             auto scatter) {
+            [[maybe_unused]] const auto V_a = m[a] / rho[a];
+            const auto V_b = m[b] / rho[b];
+
+            // Update velocity divergence.
+            if constexpr (has<PV>(div_v)) {
+              const auto div_flux = dot(v[b, a], grad_W_ab);
+              div_v[a] += V_b * div_flux;
+              if constexpr (scatter) div_v[b] += V_a * div_flux;
+            }
+
+            // Update velocity curl.
+            if constexpr (has<PV>(curl_v)) {
+              const auto curl_flux = -cross(v[b, a], grad_W_ab);
+              curl_v[a] += V_b * curl_flux;
+              if constexpr (scatter) curl_v[b] += V_a * curl_flux;
+            }
+          };
+      if (sparse_switch_<PV>()) {
+        sparse_velocity_derivatives_(mesh,
+                                     particles,
+                                     velocity_derivatives_pair);
+        forces_pairs_and_update_</*WithDensity=*/false>(mesh,
+                                                        particles,
+                                                        update);
+      } else if constexpr (!simd_forces_<PV>()) {
+        block_pairs_for_each_chain_(
+            mesh,
+            particles,
+            velocity_derivatives_pair,
+            [this](auto a,
+                   auto b,
+                   auto /*W_ab*/,
+                   const auto& grad_W_ab,
+                   auto scatter) { forces_pair_(a, b, grad_W_ab, scatter); });
+        update_particles_(particles, update);
+      } else {
+        block_pairs_for_each_(mesh, particles, velocity_derivatives_pair);
+        forces_pairs_and_update_</*WithDensity=*/false>(mesh,
+                                                        particles,
+                                                        update);
+      }
+    } else {
+      // Compute velocity and internal energy time derivatives.
+      forces_pairs_and_update_</*WithDensity=*/false>(mesh, particles, update);
     }
+  }
 
-    // Compute velocity and internal energy time derivatives.
-    par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-      const auto [a, b] = ab;
-      const auto grad_W_ab = kernel_.grad(a, b);
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-      // Update velocity time derivative.
-      const auto P_a = p[a] / pow2(rho[a]);
-      const auto P_b = p[b] / pow2(rho[b]);
-      const auto Pi_ab =
-          momentum_equation_.viscosity()(a, b) +
-          momentum_equation_.artificial_viscosity().velocity_term(a, b);
-      const auto v_flux = (-P_a - P_b + Pi_ab) * grad_W_ab;
-      dv_dt[a] += m[b] * v_flux;
-      dv_dt[b] -= m[a] * v_flux;
-
-      // Update internal energy time derivative.
-      if constexpr (has<PV>(du_dt)) {
-        const auto Q_ab = energy_equation_.heat_conductivity()(a, b);
-        du_dt[a] -= m[b] * dot((P_a - Pi_ab / 2) * v[b, a] - Q_ab, grad_W_ab);
-        du_dt[b] -= m[a] * dot((P_b - Pi_ab / 2) * v[b, a] + Q_ab, grad_W_ab);
-      }
-    });
+  /// Compute density and velocity related fields.
+  ///
+  /// Same as `compute_density` followed by `compute_forces`. If neither
+  /// renormalization nor velocity divergence and curl are required, the
+  /// continuity and momentum equations are evaluated in a single pass over
+  /// the particle pairs, with a single kernel gradient evaluation per pair.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void compute_density_and_forces(ParticleMesh& mesh,
+                                  ParticleArray& particles) const {
+    compute_density_and_forces(mesh, particles, NoUpdate_{});
+  }
 
-    // Compute artificial viscosity switch.
-    if constexpr (has<PV>(dalpha_dt)) {
-      par::for_each(particles.fluid(), [this](PV a) {
-        dalpha_dt[a] =
-            momentum_equation_.artificial_viscosity().switch_source(a);
+  /// Compute density and velocity related fields, and then update each
+  /// particle that is integrated in time with `update(a)`, see
+  /// `compute_forces`.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           std::invocable<ParticleView<ParticleArray>> Update>
+  void compute_density_and_forces(ParticleMesh& mesh,
+                                  ParticleArray& particles,
+                                  const Update& update) const {
+    using PV = ParticleView<ParticleArray>;
+    if constexpr (!fused_pairs_<PV>()) {
+      compute_density(mesh, particles);
+      compute_forces(mesh, particles, update);
+    } else {
+      TIT_PROFILE_SECTION("FluidEquations::compute_density_and_forces()");
+      const auto throughput =
+          throughput_("FluidEquations::compute_density_and_forces()",
+                      mesh,
+                      particles);
+
+      // Clean-up the fields, compute pressure, sound speed and apply source
+      // terms. Density is not modified by the continuity equation pass, so
+      // pressure can be computed in advance.
+      par::for_each(particles.all(), [this](PV a) {
+        init_density_(a, /*update_L=*/true);
+        init_forces_(a);
       });
+      compute_pressure_(particles);
+
+      // Compute density, velocity and internal energy time derivatives.
+      forces_pairs_and_update_</*WithDensity=*/true>(mesh, particles, update);
     }
   }
 
@@ -385,15 +583,18 @@ public:
   constexpr void compute_shifts(ParticleMesh& mesh,
                                 ParticleArray& particles) const {
     TIT_PROFILE_SECTION("FluidEquations::compute_shifts()");
+    const auto throughput =
+        throughput_("FluidEquations::compute_shifts()", mesh, particles);
     using PV = ParticleView<ParticleArray>;
     using Num = particle_num_t<PV>;
+    static constexpr auto Dim = particle_dim_v<PV>;
 
     /// @todo Factor out the constants.
     static constexpr Num R{0.2};
     static constexpr Num Ma{0.1};
     static constexpr Num CFL{0.8};
 
-    // Initialize the free surface flag values and clear the particle shifts.
+    // Free surface flag values:
     // - Positive value `FS_FAR` means that the particle is far from the free
     //   surface.
     // - Any positive value in the range `(FS_FAR, FS_ON)` means that the
@@ -405,41 +606,46 @@ public:
     const auto a_0 = particles[0];
     const auto FS_FAR = 2 * CFL * Ma * pow2(h[a_0]);
     static constexpr auto FS_ON = std::numeric_limits<Num>::min();
-    par::for_each(particles.fluid(), [](PV a) { FS[a] = FS_ON, dr[a] = {}; });
     par::for_each(particles.fixed(), [FS_FAR](PV a) { FS[a] = FS_FAR; });
 
-    // Classify the particles into free surface and non-free surface.
-    //
-    // Here we are reading and writing the same field `FS` in the parallel loop.
-    // There is no race condition because we read the neighbor to compare it
-    // with `FS_ON`, and non-free-surface particles are updated in the loop.
-    par::block_for_each(mesh.block_pairs(particles), [FS_FAR](auto ab) {
-      const auto [a, b] = ab;
-
-      // Skip the particles that are too far away.
-      const auto r_ab = norm2(r[a, b]);
-      const auto dist_threshold = pow2(2 * h[a]);
-      if (r_ab > dist_threshold) return;
-
-      // Perform "visibility" test. The actual test is just an optimized
-      // version of `acos(n_{a,b} / sqrt(r_ab)) <= fov`.
-      constexpr Num cos_fov{cos(std::numbers::pi / 4)};
-      const auto fov_threshold = cos_fov * r_ab;
-      if (bitwise_equal(FS[a], FS_ON)) {
+    // Classify the particles into free surface and non-free surface, and
+    // check if the non-free surface particles have any fixed neighbors.
+    // Particle is on the free surface if none of its neighbors is "visible"
+    // along its normal.
+    par::for_each(particles.fluid(), [FS_FAR, &mesh, this](PV a) {
+      bool visible = false;
+      bool near_fixed = false;
+      neighbors_for_each_(mesh, a, [a, &visible, &near_fixed](PV b) {
+        if (b.is_fixed()) near_fixed = true;
+        if (visible) return;
+
+        // Skip the particles that are too far away.
+        const auto r_ab = norm2(r[a, b]);
+        const auto dist_threshold = pow2(2 * h[a]);
+        if (r_ab > dist_threshold) return;
+
+        // Perform "visibility" test. The actual test is just an optimized
+        // version of `acos(n_{a,b} / sqrt(r_ab)) <= fov`.
+        constexpr Num cos_fov{cos(std::numbers::pi / 4)};
+        const auto fov_threshold = cos_fov * r_ab;
         const auto n_a = dot(N[a], r[a, b]);
-        if (n_a > 0 && pow2(n_a) >= fov_threshold) FS[a] = FS_FAR;
-      }
-      if (bitwise_equal(FS[b], FS_ON)) {
-        const auto n_b = dot(N[b], r[a, b]);
-        if (n_b < 0 && pow2(n_b) >= fov_threshold) FS[b] = FS_FAR;
-      }
+        if (n_a > 0 && pow2(n_a) >= fov_threshold) visible = true;
+      });
+
+      // Do not apply the shifts to the particles near the walls.
+      /// @todo No article mentions this. We shall investigate it.
+      if (!visible) FS[a] = FS_ON;
+      else if (near_fixed) FS[a] = Num{1.0e-30} * FS_FAR;
+      else FS[a] = FS_FAR;
     });
 
-    // Classify the non-free surface particles into near and far categories.
+    // Classify the non-free surface particles into near and far categories,
+    // and compute the particle shifts. Shift of a particle is proportional to
+    // its own flag value, so both are computed in a single neighbor pass.
     //
     // Here we are reading and writing the same field `FS` in the parallel loop.
     // There is no race condition because we update the field only when
-    // the particle has `FS_ON`, and read the field only to compare it with
+    // the particle has `FS_FAR`, and read the field only to compare it with
     // `FS_ON`.
     //
     // A distinct non-zero bit pattern of `FS_ON` is essential for
@@ -447,53 +653,935 @@ public:
     // some other thread, and the chances of a false positive comparison with
     // distinct bits are very small, at least orders of magnitude smaller than
     // if we used zero.
-    par::for_each(particles.fluid(), [FS_FAR, &mesh, this](PV a) {
-      if (!bitwise_equal(FS[a], FS_FAR)) return;
+    const auto inv_W_0 = inverse(kernel_(unit(r[a_0], h[a_0] / 2), h[a_0]));
+    const auto& kernel = pass_kernel_(particles);
+    par::for_each(particles.fluid(), [&](PV a) {
+      // Find the nearest free surface neighbor, and accumulate the shift
+      // terms.
+      const bool is_far = bitwise_equal(FS[a], FS_FAR);
+      std::optional<PV> nearest_fs{};
+      Vec<Num, Dim> grad_sum{};
+      Vec<Num, Dim> chi_grad_sum{};
+      neighbors_for_each_(mesh, a, [&](PV b) {
+        if (b == a) return;
+        if (is_far && bitwise_equal(FS[b], FS_ON) &&
+            (!nearest_fs || norm2(r[a, b]) < norm2(r[a, *nearest_fs]))) {
+          nearest_fs = b;
+        }
+        const auto W_ab = kernel(a, b);
+        const auto grad_W_ab = kernel.grad(a, b);
+        const auto Chi_ab = R * pow<4>(W_ab * inv_W_0);
+        const auto V_b = m[b] / rho[b];
+        grad_sum += V_b * grad_W_ab;
+        chi_grad_sum += Chi_ab * V_b * grad_W_ab;
+      });
 
-      // Do not apply the shifts to the particles near the walls.
-      /// @todo No article mentions this. We shall investigate it.
-      if (std::ranges::any_of(mesh[a], [](PV b) { return b.is_fixed(); })) {
-        FS[a] = Num{1.0e-30} * FS_FAR;
+      // Update the flag value and the particle shift.
+      auto FS_a = FS[a];
+      if (nearest_fs) {
+        const auto b = *nearest_fs;
+        FS_a *= abs(dot(N[b], r[a, b])) / kernel_.radius(a);
+        FS[a] = FS_a;
+      }
+      const auto Xi_a = static_cast<Num>(bitwise_equal(FS_a, FS_FAR));
+      dr[a] = -FS_a * (Xi_a * grad_sum + chi_grad_sum);
+    });
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Project the particle velocities onto the divergence-free field.
+  ///
+  /// Pressure increment `δp` is the solution of the pressure Poisson equation
+  /// `∇·(∇δp / ρ) = ∇·v / dt`, which is assembled as a sparse matrix on the
+  /// particle adjacency graph with the Cummins-Rudman Laplacian, and solved
+  /// with the given linear solver, preconditioned with the geometric
+  /// multigrid on the background grid. Velocities of the fluid particles are
+  /// then corrected by `-dt ∇δp / ρ`, and the increment is added to the
+  /// pressure.
+  ///
+  /// Free surface particles, detected by the truncated kernel support (low
+  /// divergence of the position), have zero pressure. Fixed particles are
+  /// the unknowns, just as the fluid ones, so the wall pressure is
+  /// determined by the velocities of the fixed particles, see
+  /// `setup_boundary`.
+  ///
+  /// Mesh must not be in the listless mode. Laplacian is symmetric if the
+  /// kernel width is uniform.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Solver>
+  auto project_velocity(particle_num_t<ParticleArray> dt,
+                        ParticleMesh& mesh,
+                        ParticleArray& particles,
+                        const Solver& solver) const {
+    TIT_PROFILE_SECTION("FluidEquations::project_velocity()");
+    TIT_ASSERT(!mesh.listless(), "Projection requires the stored adjacency!");
+    TIT_ASSERT(dt > 0, "Time step must be positive!");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    const auto& adjacency = mesh.adjacency();
+    const auto num_particles = particles.size();
+    const auto indices = std::views::iota(size_t{0}, num_particles);
+    const auto& kernel = pass_kernel_(particles);
+
+    /// @todo Factor out the constants.
+    static constexpr Num free_surface_threshold{0.75};
+    static constexpr Num eta_scale{0.01};
+
+    // Compute the velocity divergence, and detect the free surface particles.
+    // Position divergence is equal to the dimension inside of the fluid and
+    // drops near the free surface.
+    std::vector<Num> div_v_star(num_particles);
+    std::vector<uint8_t> on_surface(num_particles);
+    par::for_each(indices, [&](size_t i) {
+      const PV a = particles[i];
+      Num div_r{};
+      Num div_v{};
+      for (const size_t j : adjacency[i]) {
+        if (j == i) continue;
+        const PV b = particles[j];
+        const auto grad_W_ab = kernel.grad(a, b);
+        const auto V_b = m[b] / rho[b];
+        div_r += V_b * dot(r[b, a], grad_W_ab);
+        div_v += V_b * dot(v[b, a], grad_W_ab);
+      }
+      div_v_star[i] = div_v;
+      on_surface[i] = !a.is_fixed() && div_r < free_surface_threshold * Dim;
+    });
+
+    // Assemble the pressure Poisson equation. Rows of the free surface
+    // particles set the pressure to zero, and are eliminated from the other
+    // rows to keep the matrix symmetric.
+    using Node = std::ranges::range_value_t<decltype(adjacency.values())>;
+    sparse::Matrix<Num, Node> A{adjacency};
+    std::vector<Num> rhs(num_particles);
+    std::vector<Num> dp(num_particles);
+    par::for_each(indices, [&](size_t i) {
+      const PV a = particles[i];
+      if (on_surface[i] != 0) {
+        A.diag(i) = Num{1};
+        rhs[i] = dp[i] = -p[a];
         return;
       }
+      const auto cols = adjacency[i];
+      const auto row = A.row(i);
+      const auto eta2 = eta_scale * pow2(h[a]);
+      auto A_aa = Num{0};
+      auto rhs_a = -div_v_star[i] / dt;
+      for (size_t k = 0; k < cols.size(); ++k) {
+        const size_t j = cols[k];
+        if (j == i) continue;
+        const PV b = particles[j];
+        const auto r_ab = r[a, b];
+        const auto F_ab = dot(r_ab, kernel.grad(a, b)) / (norm2(r_ab) + eta2);
+        const auto c_ab = -4 * (m[a] + m[b]) / pow2(rho[a] + rho[b]) * F_ab;
+        A_aa += c_ab;
+        if (on_surface[j] != 0) rhs_a -= c_ab * p[b];
+        else row[k] = -c_ab;
+      }
+      A.diag(i) = A_aa;
+      rhs[i] = rhs_a;
+    });
 
-      constexpr auto on_fs = [](PV b) { return bitwise_equal(FS[b], FS_ON); };
-      if (std::ranges::any_of(mesh[a], on_fs)) {
-        auto fs_neighbors = std::views::filter(mesh[a], on_fs);
-        const auto dist_to_a = [a](PV b) { return norm2(r[a, b]); };
-        const auto b = *std::ranges::min_element(fs_neighbors, {}, dist_to_a);
-        FS[a] *= abs(dot(N[b], r[a, b])) / kernel_.radius(a);
+    // Solve for the pressure increment. Multigrid levels start with the cells
+    // of the kernel support width.
+    const auto support =
+        par::max(particles.all(), [this](PV a) { return kernel_.radius(a); });
+    const sparse::MultigridPreconditioner precond{A, r[particles], support};
+    const auto result = solver(A, rhs, dp, precond);
+
+    // Correct the velocities of the fluid particles, and update the pressure.
+    par::for_each(particles.fluid(), [&](PV a) {
+      const auto i = a.index();
+      const auto P_a = dp[i] / pow2(rho[a]);
+      Vec<Num, Dim> dv_a{};
+      for (const size_t j : adjacency[i]) {
+        if (j == i) continue;
+        const PV b = particles[j];
+        const auto P_b = dp[j] / pow2(rho[b]);
+        dv_a += m[b] * (P_a + P_b) * kernel.grad(a, b);
       }
+      v[a] -= dt * dv_a;
     });
+    par::for_each(indices, [&](size_t i) { p[particles[i]] += dp[i]; });
 
-    // Compute the particle shifts.
-    const auto inv_W_0 = inverse(kernel_(unit(r[a_0], h[a_0] / 2), h[a_0]));
-    par::block_for_each(
-        mesh.block_pairs(particles),
-        [inv_W_0, FS_FAR, this](auto ab) {
-          const auto [a, b] = ab;
-          const auto W_ab = kernel_(a, b);
-          const auto grad_W_ab = kernel_.grad(a, b);
-
-          // Update the particle shifts.
-          const auto Chi_ab = R * pow<4>(W_ab * inv_W_0);
-          const auto Xi_a = static_cast<Num>(bitwise_equal(FS[a], FS_FAR));
-          const auto Xi_b = static_cast<Num>(bitwise_equal(FS[b], FS_FAR));
-          dr[a] -= (Xi_a + Chi_ab) * FS[a] * m[b] / rho[b] * grad_W_ab;
-          dr[b] += (Xi_b + Chi_ab) * FS[b] * m[a] / rho[a] * grad_W_ab;
-        });
+    return result;
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  // Integrator update that does nothing.
+  struct NoUpdate_ final {
+    static constexpr void operator()(const auto& /*a*/) noexcept {}
+  };
+
+  // Measure the throughput of the pass: particles, unique particle pairs and
+  // the effective memory bandwidth, assuming that the varying particle
+  // fields are streamed through once per pass.
+  template<particle_mesh ParticleMesh, particle_array ParticleArray>
+  static auto throughput_(std::string_view pass_name,
+                          const ParticleMesh& mesh,
+                          const ParticleArray& particles) -> StatsThroughput {
+    return StatsThroughput{pass_name,
+                           {{"particles", particles.size()},
+                            {"pairs", mesh.num_pairs()},
+                            {"bytes", particles.size_bytes()}}};
+  }
+
+  // Smoothing kernel for the pair passes. If the kernel width is uniform,
+  // the kernel is bound to it, so that the normalization constants are
+  // computed once per pass rather than once per pair.
+  template<particle_array ParticleArray>
+  constexpr auto pass_kernel_(const ParticleArray& particles) const noexcept
+      -> decltype(auto) {
+    if constexpr (has_uniform<ParticleArray>(h)) {
+      return kernel_.bind(particles);
+    } else {
+      return (kernel_);
+    }
+  }
+
+  // Iterate through the blocks in parallel using the mesh block schedule. If
+  // the halo exchange is set for the mesh, it is overlapped with the interior
+  // blocks. If the epilogue is given, it is called for the particle indices
+  // of the mesh final blocks, see `LevelSchedule::for_each_epilogue`.
+  template<particle_mesh ParticleMesh,
+           par::range Blocks,
+           class Func,
+           class Epilogue = NoUpdate_>
+  static void blocks_for_each_(ParticleMesh& mesh,
+                               Blocks&& blocks,
+                               Func func,
+                               const Epilogue& epilogue = {}) {
+    const auto& schedule = mesh.block_schedule();
+    if constexpr (!std::same_as<Epilogue, NoUpdate_>) {
+      TIT_ASSERT(!mesh.halo_exchange(), "Epilogue cannot overlap the halo!");
+      schedule.for_each_epilogue(std::forward<Blocks>(blocks),
+                                 std::move(func),
+                                 mesh.final_blocks(),
+                                 std::cref(epilogue));
+    } else if (const auto& exchange = mesh.halo_exchange(); exchange) {
+      schedule.for_each(std::forward<Blocks>(blocks),
+                        std::move(func),
+                        [&exchange] { exchange(); });
+    } else {
+      schedule.for_each(std::forward<Blocks>(blocks), std::move(func));
+    }
+  }
+
+  // Iterate through the neighbors of the particle, either stored in the mesh
+  // or found on the fly in the listless mode.
+  template<particle_mesh ParticleMesh, particle_view PV, class Func>
+  void neighbors_for_each_(const ParticleMesh& mesh,
+                           PV a,
+                           const Func& func) const {
+    if (mesh.listless()) mesh.for_each_neighbor(a, kernel_.radius(a), func);
+    else std::ranges::for_each(mesh[a], func);
+  }
+
+  // Compute the interpolation weights of the fixed particle, in the
+  // `fixed_interp` order. Linear interpolation is used if possible, and the
+  // constant one otherwise. Returns false if both interpolations fail.
+  template<particle_mesh ParticleMesh, particle_array ParticleArray>
+  auto interp_weights_(const ParticleMesh& mesh,
+                       const ParticleArray& particles,
+                       ParticleView<ParticleArray> b,
+                       std::span<float64_t> weights) const -> bool {
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    const auto r_ghost = boundary_.ghost(r[b]);
+    const auto h_ghost = RADIUS_SCALE * h[b];
+
+    // Compute the interpolation matrices, both for the constant and
+    // linear interpolations.
+    Num S{};
+    SymMat<Num, Dim + 1> M{};
+    for (const PV a : mesh.fixed_interp(b)) {
+      const auto r_delta = particles.wrap_delta(r, r_ghost - r[a]);
+      const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
+      const auto W_delta = kernel_(r_delta, h_ghost);
+      S += W_delta * m[a] / rho[a];
+      M += sym_outer_sqr(B_delta) * (W_delta * m[a] / rho[a]);
+    }
+
+    if (const auto fact = ldl(M); fact) {
+      // Linear interpolation succeeds, use it.
+      const auto E = fact->solve(unit<0>(Vec<Num, Dim + 1>{}));
+      for (size_t i = 0; const PV a : mesh.fixed_interp(b)) {
+        const auto r_delta = particles.wrap_delta(r, r_ghost - r[a]);
+        const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
+        const auto W_delta = dot(E, B_delta) * kernel_(r_delta, h_ghost);
+        weights[i++] = static_cast<float64_t>(W_delta);
+      }
+      return true;
+    }
+    if (!is_tiny(S)) {
+      // Constant interpolation succeeds, use it.
+      const auto E = inverse(S);
+      for (size_t i = 0; const PV a : mesh.fixed_interp(b)) {
+        const auto r_delta = particles.wrap_delta(r, r_ghost - r[a]);
+        const auto W_delta = E * kernel_(r_delta, h_ghost);
+        weights[i++] = static_cast<float64_t>(W_delta);
+      }
+      return true;
+    }
+
+    // Both interpolations fail.
+    return false;
+  }
+
+  // Iterate through the particle pairs in parallel, according to the pair
+  // strategy. Function is called as `func(a, b, scatter)`. With the scatter
+  // strategy, each unique pair is visited once and `scatter` is
+  // `std::true_type`, so the function must update both particles. With the
+  // gather strategy, each particle visits all of its neighbors, `scatter` is
+  // `std::false_type`, and the function must update the first particle only.
+  // In the listless mode of the mesh, the gather strategy is always used.
+  // With the scatter strategy, field columns are bound to raw pointers once
+  // per pass, see `BoundParticleArray`, and the views of the bound array are
+  // passed to the function instead. If the mesh edges are tiled, the second
+  // particle of the edge that is processed a few edges later is prefetched,
+  // see `ParticleMesh::enable_tiling`. Epilogue is supported with the
+  // scatter strategy only, see `blocks_for_each_`.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Func,
+           class Epilogue = NoUpdate_>
+  void pairs_for_each_(ParticleMesh& mesh,
+                       ParticleArray& particles,
+                       const Func& func,
+                       const Epilogue& epilogue = {}) const {
+    using PV = ParticleView<ParticleArray>;
+    if (pair_strategy_ == PairStrategy::gather || mesh.listless()) {
+      TIT_ASSERT((std::same_as<Epilogue, NoUpdate_>),
+                 "Epilogue requires the scatter strategy!");
+      // There is nothing to overlap the halo exchange with, so it is simply
+      // completed in advance.
+      if (const auto& exchange = mesh.halo_exchange(); exchange) exchange();
+      par::for_each(particles.all(), [&mesh, &func, this](PV a) {
+        neighbors_for_each_(mesh, a, [a, &func](PV b) {
+          if (a != b) func(a, b, std::false_type{});
+        });
+      });
+    } else if (const auto distance = mesh.prefetch_distance(); distance != 0) {
+      const BoundParticleArray bound{particles};
+      const auto edges = mesh.block_edge_values();
+      blocks_for_each_(
+          mesh,
+          mesh.block_edges(),
+          [&bound, &func, edges, distance](const auto& ab) {
+            const auto edge = static_cast<size_t>(&ab - edges.data());
+            if (edge + distance < edges.size()) {
+              bound.prefetch(edges[edge + distance].second);
+            }
+            const auto [a, b] = ab;
+            func(bound[a], bound[b], std::true_type{});
+          },
+          epilogue);
+    } else {
+      const BoundParticleArray bound{particles};
+      blocks_for_each_(mesh,
+                       mesh.block_edges(),
+                       [&bound, &func](const auto& ab) {
+                         const auto [a, b] = ab;
+                         func(bound[a], bound[b], std::true_type{});
+                       },
+                       epilogue);
+    }
+  }
+
+  // Iterate through the particle pairs in parallel, passing the kernel values
+  // and gradients along with the pairs, see `pairs_for_each_`. Those are
+  // taken from the mesh pair cache, if it is valid and the scatter strategy
+  // is used. Otherwise, kernel values are evaluated only if requested, and
+  // zeroes are passed instead.
+  template<bool WithValue = false,
+           particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Func,
+           class Epilogue = NoUpdate_>
+  void block_pairs_for_each_(ParticleMesh& mesh,
+                             ParticleArray& particles,
+                             const Func& func,
+                             const Epilogue& epilogue = {}) const {
+    using Num = particle_num_t<ParticleArray>;
+    if (mesh.pairs_cached() && pair_strategy_ == PairStrategy::scatter) {
+      blocks_for_each_(mesh,
+                       mesh.cached_block_pairs(particles),
+                       [&func](const auto& pair) {
+                         const auto& [a, b, W_ab, grad_W_ab] = pair;
+                         func(a, b, W_ab, grad_W_ab, std::true_type{});
+                       },
+                       epilogue);
+    } else {
+      const auto& kernel = pass_kernel_(particles);
+      const auto pair_func = [&func, &kernel](auto a, auto b, auto scatter) {
+        if constexpr (WithValue) {
+          func(a, b, kernel(a, b), kernel.grad(a, b), scatter);
+        } else func(a, b, Num{}, kernel.grad(a, b), scatter);
+      };
+      pairs_for_each_(mesh, particles, pair_func, epilogue);
+    }
+  }
+
+  // Iterate through the particle pairs in two dependent passes, see
+  // `block_pairs_for_each_`. With the scatter strategy, the passes are
+  // chained by the block schedule, so that the second pass over a block
+  // starts once the first pass over all the blocks sharing its particles is
+  // completed. Otherwise, or if the mesh has a halo exchange to overlap with,
+  // the passes simply run one after another.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class FirstFunc,
+           class SecondFunc>
+  void block_pairs_for_each_chain_(ParticleMesh& mesh,
+                                   ParticleArray& particles,
+                                   const FirstFunc& first_func,
+                                   const SecondFunc& second_func) const {
+    using Num = particle_num_t<ParticleArray>;
+    if (pair_strategy_ != PairStrategy::scatter || mesh.listless() ||
+        mesh.halo_exchange()) {
+      block_pairs_for_each_(mesh, particles, first_func);
+      block_pairs_for_each_(mesh, particles, second_func);
+    } else if (mesh.pairs_cached()) {
+      const auto unpack = [](const auto& func) {
+        return [&func](const auto& pair) {
+          const auto& [a, b, W_ab, grad_W_ab] = pair;
+          func(a, b, W_ab, grad_W_ab, std::true_type{});
+        };
+      };
+      mesh.block_schedule().for_each_chain(mesh.cached_block_pairs(particles),
+                                           unpack(first_func),
+                                           mesh.cached_block_pairs(particles),
+                                           unpack(second_func));
+    } else {
+      const BoundParticleArray bound{particles};
+      const auto& kernel = pass_kernel_(particles);
+      const auto unpack = [&bound, &kernel](const auto& func) {
+        return [&bound, &kernel, &func](const auto& ab) {
+          const auto a = bound[ab.first];
+          const auto b = bound[ab.second];
+          func(a, b, Num{}, kernel.grad(a, b), std::true_type{});
+        };
+      };
+      mesh.block_schedule().for_each_chain(mesh.block_edges(),
+                                           unpack(first_func),
+                                           mesh.block_edges(),
+                                           unpack(second_func));
+    }
+  }
+
+  // Clean-up continuity equation fields and apply source terms.
+  // Renormalization matrix is kept, unless it is updated.
+  template<particle_view PV>
+  constexpr void init_density_(PV a, bool update_L) const {
+    // Clean-up continuity equation fields.
+    drho_dt[a] = {};
+    if constexpr (has<PV>(grad_rho)) grad_rho[a] = {};
+    if constexpr (has<PV>(C)) C[a] = {};
+    if constexpr (has<PV>(N)) N[a] = {};
+    if constexpr (has<PV>(L)) {
+      if (update_L) L[a] = {};
+    }
+
+    // Apply continuity equation source terms.
+    std::apply([a](const auto&... f) { ((drho_dt[a] += f(a)), ...); },
+               continuity_equation_.mass_sources());
+  }
+
+  // Update density time derivative with the pair contribution. Second
+  // particle is updated only if scattering.
+  template<particle_view PV, class GradW, class Scatter = std::true_type>
+  constexpr void density_pair_(PV a,
+                               PV b,
+                               const GradW& grad_W_ab,
+                               Scatter scatter = {}) const {
+    const auto Psi_ab =
+        momentum_equation_.artificial_viscosity().density_term(a, b);
+    drho_dt[a] -= m[b] * dot(v[b, a] - Psi_ab / rho[b], grad_W_ab);
+    if constexpr (scatter) {
+      drho_dt[b] -= m[a] * dot(v[b, a] + Psi_ab / rho[a], grad_W_ab);
+    }
+  }
+
+  // Clean-up momentum and energy equation fields and apply source terms.
+  template<particle_view PV>
+  constexpr void init_forces_(PV a) const {
+    // Clean-up momentum and energy equation fields.
+    dv_dt[a] = {};
+    if constexpr (has<PV>(div_v)) div_v[a] = {};
+    if constexpr (has<PV>(curl_v)) curl_v[a] = {};
+    if constexpr (has<PV>(du_dt)) du_dt[a] = {};
+
+    // Apply source terms.
+    std::apply(
+        [a](const auto&... g) {
+          ((dv_dt[a] += g(a)), ...);
+          if constexpr (has<PV>(du_dt)) ((du_dt[a] += dot(g(a), v[a])), ...);
+        },
+        momentum_equation_.momentum_sources());
+    if constexpr (has<PV>(du_dt)) {
+      std::apply([a](const auto&... q) { ((du_dt[a] += q(a)), ...); },
+                 energy_equation_.energy_sources());
+    }
+  }
+
+  // Compute pressure and sound speed. If possible, the particles are
+  // processed in batches with the equation of state evaluated lane-wise.
+  template<particle_array ParticleArray>
+  void compute_pressure_(ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    if constexpr (simd::supported_type<Num>) {
+      static constexpr auto BatchSize = simd::max_reg_size_v<Num>;
+      par::for_each(
+          std::views::chunk(particles.all(), BatchSize),
+          [this](auto batch) {
+            const auto [p_batch, cs_batch] =
+                eos_.pressure_and_sound_speed(batch);
+            std::array<Num, BatchSize> p_lanes;
+            std::array<Num, BatchSize> cs_lanes;
+            p_batch.store(p_lanes);
+            cs_batch.store(cs_lanes);
+            for (size_t k = 0; k < std::ranges::size(batch); ++k) {
+              const PV a = batch[k];
+              p[a] = p_lanes[k];
+              if constexpr (has<PV>(cs)) cs[a] = cs_lanes[k];
+            }
+          },
+          batches_affinity_);
+    } else {
+      par::for_each(
+          particles.all(),
+          [this](PV a) {
+            p[a] = eos_.pressure(a);
+            if constexpr (has<PV>(cs)) cs[a] = eos_.sound_speed(a);
+          },
+          particles_affinity_);
+    }
+  }
+
+  // Update velocity and internal energy time derivatives with the pair
+  // contribution. Second particle is updated only if scattering.
+  template<particle_view PV, class GradW, class Scatter = std::true_type>
+  constexpr void forces_pair_(PV a,
+                              PV b,
+                              const GradW& grad_W_ab,
+                              Scatter scatter = {}) const {
+    // Update velocity time derivative.
+    const auto P_a = p[a] / pow2(rho[a]);
+    const auto P_b = p[b] / pow2(rho[b]);
+    const auto Pi_ab = velocity_term_(a, b);
+    const auto v_flux = (-P_a - P_b + Pi_ab) * grad_W_ab;
+    dv_dt[a] += m[b] * v_flux;
+    if constexpr (scatter) dv_dt[b] -= m[a] * v_flux;
+
+    // Update internal energy time derivative.
+    if constexpr (has<PV>(du_dt)) {
+      const auto Q_ab = energy_equation_.heat_conductivity()(a, b);
+      du_dt[a] -= m[b] * dot((P_a - Pi_ab / 2) * v[b, a] - Q_ab, grad_W_ab);
+      if constexpr (scatter) {
+        du_dt[b] -= m[a] * dot((P_b - Pi_ab / 2) * v[b, a] + Q_ab, grad_W_ab);
+      }
+    }
+  }
+
+  // Compute artificial viscosity switch of the fluid particle, and then
+  // update it. Switch source depends on the particle's own fields only.
+  template<particle_view PV, class Update>
+  constexpr void finish_particle_(PV a, const Update& update) const {
+    if constexpr (has<PV>(dalpha_dt)) {
+      dalpha_dt[a] = momentum_equation_.artificial_viscosity().switch_source(a);
+    }
+    update(a);
+  }
+
+  // Drop the velocity and internal energy time derivatives of the dynamic
+  // boundary particle, so that only its density evolves, and then update it.
+  template<particle_view PV, class Update>
+  constexpr void finish_fixed_particle_(PV b, const Update& update) const {
+    dv_dt[b] = {};
+    if constexpr (has<PV>(du_dt)) du_dt[b] = {};
+    if constexpr (has<PV>(dalpha_dt)) dalpha_dt[b] = {};
+    update(b);
+  }
+
+  // Compute artificial viscosity switch and update the fluid particles, and
+  // the dynamic boundary particles, if any, in a separate pass.
+  template<particle_array ParticleArray, class Update>
+  void update_particles_(ParticleArray& particles, const Update& update) const {
+    using PV = ParticleView<ParticleArray>;
+    if constexpr (has<PV>(dalpha_dt) || !std::same_as<Update, NoUpdate_>) {
+      par::for_each(particles.fluid(), [this, &update](PV a) {
+        finish_particle_(a, update);
+      });
+    }
+    if (boundary_model_ == BoundaryModel::dynamic) {
+      par::for_each(particles.fixed(), [this, &update](PV b) {
+        finish_fixed_particle_(b, update);
+      });
+    }
+  }
+
+  // Compute velocity (and, optionally, density) time derivatives over the
+  // particle pairs, and then compute artificial viscosity switch and update
+  // the fluid particles. With the scatter strategy and the level schedule,
+  // a particle is finished right after the last block that touches it, so
+  // that the separate pass over the particles is not needed. With the halo
+  // exchange the blocks are overlapped with it, so the pass is kept.
+  template<bool WithDensity,
+           particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Update>
+  void forces_pairs_and_update_(ParticleMesh& mesh,
+                                ParticleArray& particles,
+                                const Update& update) const {
+    using PV = ParticleView<ParticleArray>;
+    using Schedule = std::remove_cvref_t<decltype(mesh.block_schedule())>;
+    if constexpr (std::same_as<Schedule, LevelSchedule>) {
+      constexpr bool updates_fluid =
+          has<PV>(dalpha_dt) || !std::same_as<Update, NoUpdate_>;
+      const bool dynamic = boundary_model_ == BoundaryModel::dynamic;
+      if ((updates_fluid || dynamic) &&
+          pair_strategy_ == PairStrategy::scatter && !mesh.listless() &&
+          !mesh.halo_exchange()) {
+        forces_pairs_<WithDensity>(
+            mesh,
+            particles,
+            [this, &particles, &update, dynamic](size_t i) {
+              if (particles.has_type(i, ParticleType::fluid)) {
+                finish_particle_(particles[i], update);
+              } else if (dynamic &&
+                         particles.has_type(i, ParticleType::fixed)) {
+                finish_fixed_particle_(particles[i], update);
+              }
+            });
+        return;
+      }
+    }
+    forces_pairs_<WithDensity>(mesh, particles);
+    update_particles_(particles, update);
+  }
+
+  // Can the continuity and momentum equation pairs be processed in a single
+  // pass? The momentum equation must not depend on any fields that are
+  // computed by pair passes.
+  template<particle_view PV>
+  static consteval auto fused_pairs_() -> bool {
+    return !has<PV>(grad_rho) && !has<PV>(C) && !has<PV>(N) && !has<PV>(L) &&
+           !has<PV>(div_v) && !has<PV>(curl_v);
+  }
+
+  // Should the velocity divergence and curl be evaluated for the compressed
+  // particles only? See `SwitchEvaluation::sparse`.
+  template<particle_view PV>
+  constexpr auto sparse_switch_() const noexcept -> bool {
+    if constexpr (!has<PV>(drho_dt)) {
+      TIT_ASSERT(switch_evaluation_ != SwitchEvaluation::sparse,
+                 "Sparse switch evaluation requires the density derivative!");
+      return false;
+    } else return switch_evaluation_ == SwitchEvaluation::sparse;
+  }
+
+  // Evaluate the velocity divergence and curl for the compressed particles
+  // by gathering over their neighbors, and estimate them for the rest.
+  // Density time derivative of the current stage is used as the indicator,
+  // so the active set follows the compression front without any lag.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Func>
+  void sparse_velocity_derivatives_(ParticleMesh& mesh,
+                                    ParticleArray& particles,
+                                    const Func& velocity_derivatives_pair)
+      const {
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    const auto indices = std::views::iota(size_t{0}, particles.size());
+
+    // Estimate the divergence of the expanding particles from the continuity
+    // equation. Their curl is left zero, as set by `init_forces_`.
+    if constexpr (has<PV>(div_v)) {
+      par::for_each(particles.all(), [](PV a) {
+        if (drho_dt[a] <= Num{0}) div_v[a] = -drho_dt[a] / rho[a];
+      });
+    }
+
+    // Select the compressed particles.
+    std::vector<size_t> active(particles.size());
+    const auto last =
+        par::copy_if(indices, active.begin(), [&particles](size_t i) {
+          return drho_dt[particles[i]] > Num{0};
+        });
+    active.erase(last, active.end());
+    TIT_STATS("FluidEquations::num_switch_active", active.size());
+
+    // Gather the divergence and curl of the active particles.
+    if (const auto& exchange = mesh.halo_exchange(); exchange) exchange();
+    const auto& kernel = pass_kernel_(particles);
+    par::for_each(active, [&](size_t i) {
+      const PV a = particles[i];
+      neighbors_for_each_(mesh, a, [a, &kernel, &velocity_derivatives_pair](
+                                       PV b) {
+        if (a == b) return;
+        velocity_derivatives_pair(a,
+                                  b,
+                                  Num{},
+                                  kernel.grad(a, b),
+                                  std::false_type{});
+      });
+    });
+  }
+
+  // Viscous terms of the momentum equation.
+  template<particle_view PV>
+  constexpr auto velocity_term_(PV a, PV b) const noexcept {
+    return momentum_equation_.viscosity()(a, b) +
+           momentum_equation_.artificial_viscosity().velocity_term(a, b);
+  }
+
+  // Should the momentum equation be evaluated on SIMD registers?
+  //
+  // Energy equation is not supported, since its fluxes would require the
+  // per-pair velocity differences to be gathered as well.
+  template<particle_view PV>
+  static consteval auto simd_forces_() -> bool {
+    return simd_kernel<Kernel> && has_uniform<PV>(h) && !has<PV>(du_dt) &&
+           simd::supported_type<particle_num_t<PV>>;
+  }
+
+  // Compute velocity (and, optionally, density) time derivatives over the
+  // particle pairs. Pairs are processed in batches, if possible.
+  template<bool WithDensity,
+           particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Epilogue = NoUpdate_>
+  void forces_pairs_(ParticleMesh& mesh,
+                     ParticleArray& particles,
+                     const Epilogue& epilogue = {}) const {
+    using PV = ParticleView<ParticleArray>;
+    if constexpr (simd_forces_<PV>()) {
+      if (pair_strategy_ == PairStrategy::scatter && !mesh.listless()) {
+        compute_forces_batches_<WithDensity>(mesh, particles, epilogue);
+        return;
+      }
+    }
+    block_pairs_for_each_(
+        mesh,
+        particles,
+        [this](auto a,
+               auto b,
+               auto /*W_ab*/,
+               const auto& grad_W_ab,
+               auto scatter) {
+          if constexpr (WithDensity) density_pair_(a, b, grad_W_ab, scatter);
+          forces_pair_(a, b, grad_W_ab, scatter);
+        },
+        epilogue);
+  }
+
+  // Should the renormalization matrices be recomputed? See
+  // `renormalization_max_disp()`. Displacement since the last update is
+  // bounded by the sum of the displacements since the mesh rebuild, at the
+  // moment of the update and now.
+  template<particle_view PV, particle_mesh ParticleMesh>
+  auto needs_renormalization_update_(const ParticleMesh& mesh) const -> bool {
+    if constexpr (!has<PV>(L) || !has<PV>(L_ldl)) {
+      TIT_ASSERT(renormalization_max_disp_ == 0.0,
+                 "Lazy renormalization requires the LDL factors field!");
+      return true;
+    } else {
+      if (renormalization_max_disp_ > 0.0 && L_mesh_ == &mesh &&
+          L_num_rebuilds_ == mesh.num_rebuilds() &&
+          L_max_disp_ + mesh.max_disp() < renormalization_max_disp_) {
+        return false;
+      }
+      L_mesh_ = &mesh;
+      L_num_rebuilds_ = mesh.num_rebuilds();
+      L_max_disp_ = mesh.max_disp();
+      return true;
+    }
+  }
+
+  // Renormalize density-related fields for a batch of particles.
+  //
+  // Renormalization matrices are gathered and factorized lane-wise, the
+  // density gradients and the normal vectors are solved with them and
+  // scattered back to the particles. If the factors are cached, they are
+  // only recomputed when the matrices are updated.
+  template<std::ranges::random_access_range Batch>
+  static void renormalize_density_batch_(Batch&& batch, bool update_L) {
+    using PV = std::ranges::range_value_t<Batch>;
+    using Num = particle_num_t<PV>;
+    static constexpr auto Dim = particle_dim_v<PV>;
+    static constexpr auto Size = simd::max_reg_size_v<Num>;
+    const auto count = std::ranges::size(batch);
+    TIT_ASSERT(count <= Size, "Batch is too large!");
+
+    // Renormalize density, if possible.
+    if constexpr (has<PV>(C)) {
+      for (size_t k = 0; k < count; ++k) {
+        const PV a = batch[k];
+        if (!is_tiny(C[a])) rho[a] /= C[a];
+      }
+    }
+
+    // Renormalize density gradient and normal vector, if possible. Both
+    // right hand sides are always solved, the missing one is left zero.
+    if constexpr (has<PV>(L) && (has<PV>(N) || has<PV>(grad_rho))) {
+      std::array<SymMat<Num, Dim>, Size> L_batch{};
+      std::array<Vec<Num, Dim>, Size> N_batch{};
+      std::array<Vec<Num, Dim>, Size> grad_rho_batch{};
+      std::array<bool, Size> ok{};
+      for (size_t k = 0; k < count; ++k) {
+        const PV a = batch[k];
+        if constexpr (has<PV>(L_ldl)) {
+          L_batch[k] = update_L ? L[a] : L_ldl[a];
+        } else L_batch[k] = L[a];
+        if constexpr (has<PV>(N)) N_batch[k] = N[a];
+        if constexpr (has<PV>(grad_rho)) grad_rho_batch[k] = grad_rho[a];
+      }
+      const std::span L_span{L_batch.data(), count};
+      if constexpr (has<PV>(L_ldl)) {
+        if (update_L) {
+          ldl_batch(L_span);
+          for (size_t k = 0; k < count; ++k) L_ldl[batch[k]] = L_batch[k];
+        }
+        ldl_factored_solve_batch(std::span<const SymMat<Num, Dim>>{L_span},
+                                 std::span{ok.data(), count},
+                                 std::span{N_batch.data(), count},
+                                 std::span{grad_rho_batch.data(), count});
+      } else {
+        ldl_solve_batch(std::span<const SymMat<Num, Dim>>{L_span},
+                        std::span{ok.data(), count},
+                        std::span{N_batch.data(), count},
+                        std::span{grad_rho_batch.data(), count});
+      }
+      for (size_t k = 0; k < count; ++k) {
+        if (!ok[k]) continue;
+        const PV a = batch[k];
+        if constexpr (has<PV>(N)) N[a] = N_batch[k];
+        if constexpr (has<PV>(grad_rho)) grad_rho[a] = grad_rho_batch[k];
+      }
+    }
+
+    // Finalize the normal vector.
+    if constexpr (has<PV>(N)) {
+      for (size_t k = 0; k < count; ++k) {
+        const PV a = batch[k];
+        N[a] = normalize(N[a]);
+      }
+    }
+  }
+
+  // Compute velocity (and, optionally, density) time derivatives, processing
+  // the particle pairs in batches.
+  template<bool WithDensity,
+           particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Epilogue = NoUpdate_>
+  void compute_forces_batches_(ParticleMesh& mesh,
+                               ParticleArray& particles,
+                               const Epilogue& epilogue = {}) const {
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto BatchSize = simd::max_reg_size_v<Num>;
+    const auto batches = [](auto block) {
+      return std::views::chunk(block, BatchSize);
+    };
+    blocks_for_each_(mesh,
+                     mesh.block_edges() | std::views::transform(batches),
+                     [bound = BoundParticleArray{particles}, this](auto batch) {
+                       compute_forces_batch_<WithDensity>(bound,
+                                                          std::span{batch});
+                     },
+                     epilogue);
+  }
+
+  // Compute velocity (and, optionally, density) time derivatives for a batch
+  // of particle pairs.
+  //
+  // Pair distances and the flux coefficients are gathered into the
+  // structure-of-arrays layout, the kernel gradients and the fluxes are
+  // computed lane-wise, and the fluxes are scattered back to the particles.
+  template<bool WithDensity, class BoundParticles, class Edge>
+  void compute_forces_batch_(const BoundParticles& particles,
+                             std::span<const Edge> batch) const {
+    using PV = ParticleView<const BoundParticles>;
+    using Num = particle_num_t<PV>;
+    static constexpr auto Dim = particle_dim_v<PV>;
+    static constexpr auto Size = simd::max_reg_size_v<Num>;
+    using Reg = simd::Reg<Num, Size>;
+    TIT_ASSERT(batch.size() <= Size, "Batch is too large!");
+
+    // Gather the pair distances and the flux coefficients. Unused lanes are
+    // left zeroed, which produces zero gradients.
+    Num h_ab{};
+    std::array<std::array<Num, Size>, Dim> x_ab{};
+    std::array<Num, Size> coef_ab{};
+    for (size_t lane = 0; lane < batch.size(); ++lane) {
+      const auto a = particles[batch[lane].first];
+      const auto b = particles[batch[lane].second];
+      const auto r_ab = r[a, b];
+      for (size_t i = 0; i < Dim; ++i) x_ab[i][lane] = r_ab[i];
+      const auto P_a = p[a] / pow2(rho[a]);
+      const auto P_b = p[b] / pow2(rho[b]);
+      coef_ab[lane] = -P_a - P_b + velocity_term_(a, b);
+      h_ab = h[a];
+    }
+
+    // Compute the kernel gradients and the velocity fluxes.
+    std::array<Reg, Dim> x;
+    for (size_t i = 0; i < Dim; ++i) x[i] = Reg(x_ab[i]);
+    const auto grad_W = kernel_.grad(x, h_ab);
+    const Reg coef(coef_ab);
+    std::array<std::array<Num, Size>, Dim> grad_W_ab{};
+    for (size_t i = 0; i < Dim; ++i) {
+      if constexpr (WithDensity) grad_W[i].store(grad_W_ab[i]);
+      (grad_W[i] * coef).store(x_ab[i]);
+    }
+
+    // Scatter the fluxes.
+    for (size_t lane = 0; lane < batch.size(); ++lane) {
+      const auto a = particles[batch[lane].first];
+      const auto b = particles[batch[lane].second];
+      Vec<Num, Dim> v_flux_ab;
+      for (size_t i = 0; i < Dim; ++i) v_flux_ab[i] = x_ab[i][lane];
+      dv_dt[a] += m[b] * v_flux_ab;
+      dv_dt[b] -= m[a] * v_flux_ab;
+      if constexpr (WithDensity) {
+        Vec<Num, Dim> grad_W_lane;
+        for (size_t i = 0; i < Dim; ++i) grad_W_lane[i] = grad_W_ab[i][lane];
+        density_pair_(a, b, grad_W_lane);
+      }
+    }
+  }
+
   [[no_unique_address]] MotionEquation motion_equation_;
   [[no_unique_address]] ContinuityEquation continuity_equation_;
   [[no_unique_address]] MomentumEquation momentum_equation_;
   [[no_unique_address]] EnergyEquation energy_equation_;
   [[no_unique_address]] EquationOfState eos_;
   [[no_unique_address]] Kernel kernel_;
+  Boundary boundary_;
+  PairStrategy pair_strategy_;
+  SwitchEvaluation switch_evaluation_;
+  float64_t renormalization_max_disp_;
+  BoundaryModel boundary_model_;
+
+  // Mesh state at the last renormalization matrix update.
+  mutable const void* L_mesh_ = nullptr;
+  mutable size_t L_num_rebuilds_ = 0;
+  mutable float64_t L_max_disp_ = 0.0;
+
+  // Affinities of the passes over all the particles, and over the batches of
+  // them, so that the same particles are processed by the same threads in
+  // each of the passes and steps.
+  mutable par::Affinity particles_affinity_;
+  mutable par::Affinity batches_affinity_;
 
 }; // class FluidEquations
 
@@ -0,0 +1,316 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/energy_equation.hpp"
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/fluid_equations.hpp"
+#include "tit/sph/heat_conductivity.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/momentum_equation.hpp"
+#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/time_integrator.hpp"
+#include "tit/sph/viscosity.hpp"
+#include "tit/sph/wall_boundary.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+constexpr size_t lattice_size = 12;
+constexpr double dr = 0.1;
+constexpr double h_0 = 2.0 * dr;
+constexpr double rho_0 = 1000.0;
+constexpr double cs_0 = 10.0;
+
+// Weakly-compressible equations with the Balsara switch and the heat
+// conductivity, so that the velocity divergence and curl, and the internal
+// energy time derivative are computed over the particle pairs as well.
+auto make_equations(
+    sph::PairStrategy pair_strategy = sph::PairStrategy::scatter,
+    sph::SwitchEvaluation switch_evaluation = sph::SwitchEvaluation::full) {
+  return sph::FluidEquations{
+      sph::MotionEquation{},
+      sph::ContinuityEquation{},
+      sph::MomentumEquation{
+          sph::NoViscosity{},
+          sph::BalsaraArtificialViscosity{
+              sph::AlphaBetaArtificialViscosity{}},
+      },
+      sph::EnergyEquation{sph::HeatConductivity{/*c_v=*/1.0}},
+      sph::LinearTaitEquationOfState{cs_0, rho_0},
+      sph::QuarticWendlandKernel{},
+      // No walls, the lattice has no fixed particles.
+      sph::WallBoundary<Vec<double, 2>>{},
+      pair_strategy,
+      switch_evaluation,
+  };
+}
+
+// Equations with no velocity divergence and curl, and no renormalization,
+// so that the density and the forces are computed in a single pair pass.
+auto make_fused_equations() {
+  return sph::FluidEquations{
+      sph::MotionEquation{},
+      sph::ContinuityEquation{},
+      sph::MomentumEquation{
+          sph::NoViscosity{},
+          sph::AlphaBetaArtificialViscosity{},
+      },
+      sph::NoEnergyEquation{},
+      sph::LinearTaitEquationOfState{cs_0, rho_0},
+      sph::QuarticWendlandKernel{},
+      // No walls, the lattice has no fixed particles.
+      sph::WallBoundary<Vec<double, 2>>{},
+  };
+}
+
+auto make_mesh() {
+  return sph::ParticleMesh{
+      geom::GridSearch{h_0},
+      geom::RecursiveInertialBisection{},
+      geom::GridGraphPartition{2 * h_0},
+  };
+}
+
+// Perturbed fluid lattice with a perturbed density, in the flow that has
+// both the compression and the expansion regions, and a non-zero vorticity.
+template<class Equations>
+auto make_particles(const Equations& equations) {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, equations};
+  using ParticleArray = decltype(particles);
+  for (size_t i = 0; i < lattice_size; ++i) {
+    for (size_t j = 0; j < lattice_size; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      const auto x = static_cast<double>(i) * dr;
+      const auto y = static_cast<double>(j) * dr;
+      sph::r[a] = Vec{x + 0.1 * dr * std::sin(7.0 * y),
+                      y + 0.1 * dr * std::cos(5.0 * x)};
+      sph::v[a] = Vec{std::sin(2.0 * x) + 0.5 * std::sin(3.0 * y),
+                      std::cos(3.0 * y) + 0.5 * std::cos(2.0 * x)};
+      sph::rho[a] = rho_0 * (1.0 + 0.01 * std::sin(4.0 * (x + y)));
+      if constexpr (sph::has<ParticleArray>(sph::u)) sph::u[a] = 1.0 + x * y;
+    }
+  }
+  sph::m[particles] = rho_0 * dr * dr;
+  sph::h[particles] = h_0;
+  if constexpr (sph::has<ParticleArray>(sph::kappa)) {
+    sph::kappa[particles] = 1.0;
+  }
+  return particles;
+}
+
+// Index the particles, and compute their density and velocity related
+// fields.
+template<class Equations, class ParticleMesh, class ParticleArray>
+void compute_derivatives(const Equations& equations,
+                         ParticleMesh& mesh,
+                         ParticleArray& particles) {
+  equations.init(particles);
+  equations.index(mesh, particles);
+  equations.compute_density(mesh, particles);
+  equations.compute_forces(mesh, particles);
+}
+
+// Check that the time derivatives of the particles are approximately equal.
+template<class ParticleArray>
+void check_derivatives_eq(const ParticleArray& expected,
+                          const ParticleArray& actual) {
+  REQUIRE(actual.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const auto a = expected[i];
+    const auto b = actual[i];
+    CHECK_APPROX_EQ(sph::drho_dt[a] / rho_0, sph::drho_dt[b] / rho_0);
+    CHECK_APPROX_EQ(sph::dv_dt[a], sph::dv_dt[b]);
+    if constexpr (sph::has<ParticleArray>(sph::du_dt)) {
+      CHECK_APPROX_EQ(sph::du_dt[a], sph::du_dt[b]);
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::FluidEquations") {
+  par::set_num_threads(4);
+  constexpr double dt = 1.0e-3;
+
+  SUBCASE("pair strategies") {
+    // Gather strategy visits each pair twice, once from each particle, and
+    // must match the scatter strategy up to the summation order, both in the
+    // time derivatives and in the state after a step.
+    sph::KickDriftKickIntegrator scatter_integrator{
+        make_equations(sph::PairStrategy::scatter)};
+    sph::KickDriftKickIntegrator gather_integrator{
+        make_equations(sph::PairStrategy::gather)};
+    auto scatter_particles = make_particles(scatter_integrator);
+    auto gather_particles = scatter_particles;
+    auto scatter_mesh = make_mesh();
+    auto gather_mesh = make_mesh();
+    compute_derivatives(make_equations(sph::PairStrategy::scatter),
+                        scatter_mesh,
+                        scatter_particles);
+    compute_derivatives(make_equations(sph::PairStrategy::gather),
+                        gather_mesh,
+                        gather_particles);
+    check_derivatives_eq(scatter_particles, gather_particles);
+
+    scatter_integrator.step(dt, scatter_mesh, scatter_particles);
+    gather_integrator.step(dt, gather_mesh, gather_particles);
+    check_derivatives_eq(scatter_particles, gather_particles);
+    for (size_t i = 0; i < scatter_particles.size(); ++i) {
+      const auto a = scatter_particles[i];
+      const auto b = gather_particles[i];
+      CHECK_APPROX_EQ(sph::r[a], sph::r[b]);
+      CHECK_APPROX_EQ(sph::v[a], sph::v[b]);
+      CHECK_APPROX_EQ(sph::rho[a] / rho_0, sph::rho[b] / rho_0);
+    }
+  }
+
+  SUBCASE("fused density and forces") {
+    // With the level schedule and the scatter strategy, each particle is
+    // updated right after the last block that touches it, in the same pass
+    // the density and the forces are computed in. Result must match the
+    // separate passes followed by the update. Blocks are run sequentially,
+    // so that the order of the pair and update calls is deterministic.
+    par::set_num_threads(1);
+    par::set_reproducible(4);
+    const auto equations = make_fused_equations();
+    auto particles = make_particles(equations);
+    auto fused_particles = particles;
+    auto mesh = make_mesh();
+    auto fused_mesh = make_mesh();
+    const auto update = [](auto a) {
+      sph::v[a] += dt * sph::dv_dt[a];
+      sph::rho[a] += dt * sph::drho_dt[a];
+    };
+
+    compute_derivatives(equations, mesh, particles);
+    for (const auto a : particles.fluid()) update(a);
+
+    // Velocity time derivatives of all the particles, as seen by the first
+    // update.
+    std::vector<Vec<double, 2>> first_dv_dt;
+    equations.init(fused_particles);
+    equations.index(fused_mesh, fused_particles);
+    equations.compute_density_and_forces(
+        fused_mesh,
+        fused_particles,
+        [&update, &first_dv_dt, &fused_particles](auto a) {
+          if (first_dv_dt.empty()) {
+            for (const auto b : fused_particles.all()) {
+              first_dv_dt.push_back(sph::dv_dt[b]);
+            }
+          }
+          update(a);
+        });
+    par::set_reproducible(0);
+
+    check_derivatives_eq(particles, fused_particles);
+    for (size_t i = 0; i < particles.size(); ++i) {
+      const auto a = particles[i];
+      const auto b = fused_particles[i];
+      CHECK_APPROX_EQ(sph::v[a], sph::v[b]);
+      CHECK_APPROX_EQ(sph::rho[a] / rho_0, sph::rho[b] / rho_0);
+    }
+
+    // Fused update has actually run: the first particle was updated before
+    // the pairs of some other particles were processed.
+    CHECK(first_dv_dt.size() == fused_particles.size());
+    CHECK(std::ranges::any_of(
+        std::views::iota(size_t{0}, first_dv_dt.size()),
+        [&first_dv_dt, &fused_particles](size_t i) {
+          return !approx_equal_to(first_dv_dt[i],
+                                  sph::dv_dt[fused_particles[i]]);
+        }));
+  }
+
+  SUBCASE("pair cache") {
+    // Cached kernel values and gradients are refreshed every time the
+    // particles move, so the cached pair passes must match the evaluated ones
+    // after a few steps. Mesh is only rebuilt on the first step.
+    constexpr size_t num_steps = 5;
+    sph::KickDriftKickIntegrator integrator{make_equations()};
+    auto cached_integrator = integrator;
+    auto particles = make_particles(integrator);
+    auto cached_particles = particles;
+    auto mesh = make_mesh();
+    auto cached_mesh = make_mesh();
+    cached_mesh.enable_pair_cache();
+    for (size_t n = 0; n < num_steps; ++n) {
+      integrator.step(dt, mesh, particles);
+      cached_integrator.step(dt, cached_mesh, cached_particles);
+    }
+    REQUIRE(cached_mesh.pairs_cached());
+    CHECK(cached_mesh.num_rebuilds() == 1);
+    check_derivatives_eq(particles, cached_particles);
+    for (size_t i = 0; i < particles.size(); ++i) {
+      const auto a = particles[i];
+      const auto b = cached_particles[i];
+      CHECK_APPROX_EQ(sph::r[a], sph::r[b]);
+      CHECK_APPROX_EQ(sph::v[a], sph::v[b]);
+      CHECK_APPROX_EQ(sph::rho[a] / rho_0, sph::rho[b] / rho_0);
+    }
+  }
+
+  SUBCASE("sparse switch") {
+    // Velocity divergence and curl of the compressed particles are gathered
+    // over all of their neighbors, and must match the full evaluation. For
+    // the expanding particles, the divergence is estimated from the
+    // continuity equation, and the curl is zero.
+    const auto equations = make_equations();
+    const auto sparse_equations =
+        make_equations(sph::PairStrategy::scatter,
+                       sph::SwitchEvaluation::sparse);
+    auto particles = make_particles(equations);
+    auto sparse_particles = particles;
+    auto mesh = make_mesh();
+    auto sparse_mesh = make_mesh();
+    compute_derivatives(equations, mesh, particles);
+    compute_derivatives(sparse_equations, sparse_mesh, sparse_particles);
+    size_t num_compressed = 0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+      const auto a = particles[i];
+      const auto b = sparse_particles[i];
+      CHECK_APPROX_EQ(sph::drho_dt[a] / rho_0, sph::drho_dt[b] / rho_0);
+      if (sph::drho_dt[b] > 0.0) {
+        num_compressed += 1;
+        CHECK_APPROX_EQ(sph::div_v[a], sph::div_v[b]);
+        CHECK_APPROX_EQ(sph::curl_v[a], sph::curl_v[b]);
+      } else {
+        CHECK_APPROX_EQ(sph::div_v[b], -sph::drho_dt[b] / sph::rho[b]);
+        CHECK_APPROX_EQ(norm(sph::curl_v[b]), 0.0);
+      }
+    }
+
+    // Flow has both the compressed and the expanding particles.
+    CHECK(num_compressed > 0);
+    CHECK(num_compressed < particles.size());
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
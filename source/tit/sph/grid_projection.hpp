@@ -0,0 +1,319 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/mdvector.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Projection of the particle fields onto a uniform grid.
+///
+/// Fields are interpolated at the grid nodes, which are the centers of the
+/// grid cells, from the fluid particles with the Shepard-normalized SPH
+/// kernel. Projection is a parallel scatter: the fluid particles are split
+/// into the contiguous blocks, one per thread, and each thread accumulates
+/// the contributions of its block into a private tile, that only covers the
+/// nodes within the kernel support of the block particles. Tiles are then
+/// reduced into the dense grid arrays in parallel, with no atomics. Since the
+/// particles are kept in the spatial order by the particle mesh, the tiles
+/// are small and barely overlap.
+///
+/// @note Periodic images of the particles are not projected.
+///
+/// @tparam Fields Fields that are projected.
+template<class Num, size_t Dim, field_set Fields, kernel Kernel>
+class GridProjection final {
+public:
+
+  /// Set of particle fields that are projected.
+  static constexpr Fields fields{};
+
+  /// Grid point type.
+  using Point = Vec<Num, Dim>;
+
+  /// Grid type.
+  using Grid = geom::Grid<Point>;
+
+  /// Construct a grid projection.
+  ///
+  /// @param kernel Smoothing kernel used for the interpolation.
+  /// @param grid   Grid, the fields are projected onto its cell centers.
+  constexpr GridProjection(Space<Num, Dim> /*space*/,
+                           Fields /*fields*/,
+                           Kernel kernel,
+                           Grid grid)
+      : kernel_{std::move(kernel)}, grid_{std::move(grid)} {}
+
+  /// Grid.
+  constexpr auto grid() const noexcept -> const Grid& {
+    return grid_;
+  }
+
+  /// Projected field values at the grid nodes.
+  template<field Field>
+  constexpr auto values(Field /*field*/) const noexcept
+      -> const Mdvector<field_value_t<Field, Space<Num, Dim>>, Dim>& {
+    static_assert(fields.contains(Field{}));
+    return std::get<fields.find(Field{})>(values_);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Project the particle fields onto the grid. Nodes with no fluid particles
+  /// nearby get zero values.
+  template<particle_array ParticleArray>
+    requires (ParticleArray::fields.includes(meta::Set{r, h, m, rho})) &&
+             (ParticleArray::fields.includes(Fields{}))
+  void project(ParticleArray& particles) {
+    TIT_PROFILE_SECTION("GridProjection::project()");
+
+    // Scatter the particle blocks into the tiles.
+    const auto fluid = particles.fluid();
+    const auto num_particles = std::size(fluid);
+    const auto num_tiles = par::num_threads();
+    tiles_.resize(num_tiles);
+    par::for_each(
+        std::views::iota(size_t{0}, num_tiles),
+        [&fluid, num_particles, num_tiles, this](size_t tile_index) {
+          auto& tile = tiles_[tile_index];
+          const auto block = std::views::iota(
+              tile_index * num_particles / num_tiles,
+              (tile_index + 1) * num_particles / num_tiles);
+
+          // Compute the tile nodes.
+          tile.reset();
+          for (const auto i : block) {
+            const auto b = fluid[i];
+            const auto nodes = node_range_(r[b], kernel_.radius(h[b]));
+            if (nodes) tile.expand(nodes->first, nodes->second);
+          }
+          if (tile.empty()) return;
+          tile.allocate();
+
+          // Accumulate the particle contributions.
+          for (const auto i : block) {
+            const auto b = fluid[i];
+            const auto nodes = node_range_(r[b], kernel_.radius(h[b]));
+            if (!nodes) continue;
+            const auto V_b = m[b] / rho[b];
+            for (const auto& node : grid_.cells_inclusive(nodes->first,
+                                                          nodes->second)) {
+              const auto W_b = V_b * kernel_(node_point_(node) - r[b], h[b]);
+              if (W_b == Num{0.0}) continue;
+              const auto slot = tile.slot(node);
+              tile.weights[slot] += W_b;
+              fields.for_each([&tile, b, slot, W_b](auto field) {
+                using Field = decltype(field);
+                using Value = field_value_t<Field, Space<Num, Dim>>;
+                std::get<fields.find(Field{})>(tile.sums)[slot] +=
+                    W_b * field_cast<Value>(field[b]);
+              });
+            }
+          }
+        });
+
+    // Reduce the tiles into the grid.
+    const auto& num_nodes = grid_.num_cells();
+    std::apply(
+        [&num_nodes](auto&... vals) {
+          [&num_nodes, &vals...]<size_t... Axes>(
+              std::index_sequence<Axes...> /*axes*/) {
+            (vals.assign(num_nodes[Axes]...), ...);
+          }(std::make_index_sequence<Dim>{});
+        },
+        values_);
+    par::for_each(
+        std::views::iota(size_t{0}, grid_.flat_num_cells()),
+        [this](size_t flat_node) {
+          const auto node = unflatten_(flat_node);
+          Num weight{0.0};
+          Sums_ sums{};
+          for (const auto& tile : tiles_) {
+            if (!tile.contains(node)) continue;
+            const auto slot = tile.slot(node);
+            weight += tile.weights[slot];
+            fields.for_each([&tile, &sums, slot](auto field) {
+              constexpr auto index = fields.find(decltype(field){});
+              std::get<index>(sums) += std::get<index>(tile.sums)[slot];
+            });
+          }
+          if (is_tiny(weight)) return;
+          fields.for_each([&sums, flat_node, weight, this](auto field) {
+            constexpr auto index = fields.find(decltype(field){});
+            std::get<index>(values_).data()[flat_node] =
+                std::get<index>(sums) / weight;
+          });
+        });
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Write the projected fields into a data series.
+  ///
+  /// Uniform arrays `grid_box` and `grid_shape` hold the low and the high
+  /// points of the grid bounding box and the number of the grid nodes along
+  /// each axis, and each varying array holds the dense field values, with
+  /// the last axis being the fastest.
+  void write(real_t time,
+             data::DataSeriesView<data::DataStorage> series) const {
+    auto transaction = series.storage().transaction();
+    write_(series.create_time_step(time));
+    transaction.commit();
+  }
+
+  /// Snapshot the projected fields and write them into a data series
+  /// in background.
+  void write(real_t time, data::DataWriter& writer) const {
+    auto snapshot = writer.acquire(time);
+    write_(*snapshot);
+    writer.submit(std::move(snapshot));
+  }
+
+private:
+
+  using VecIndex_ = typename Grid::VecIndex;
+
+  using Sums_ = decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+    return std::tuple<field_value_t<Fs, Space<Num, Dim>>...>{};
+  }(fields));
+
+  using Values_ = decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+    return std::tuple<Mdvector<field_value_t<Fs, Space<Num, Dim>>, Dim>...>{};
+  }(fields));
+
+  // Tile of the grid nodes, that accumulates the contributions of a block
+  // of particles.
+  struct Tile_ final {
+    VecIndex_ low;
+    VecIndex_ high;
+    bool is_empty = true;
+    std::vector<Num> weights;
+    decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+      return std::tuple<std::vector<field_value_t<Fs, Space<Num, Dim>>>...>{};
+    }(fields)) sums;
+
+    void reset() noexcept {
+      is_empty = true;
+    }
+
+    auto empty() const noexcept -> bool {
+      return is_empty;
+    }
+
+    void expand(const VecIndex_& first, const VecIndex_& last) {
+      if (is_empty) low = first, high = last, is_empty = false;
+      else low = minimum(low, first), high = maximum(high, last);
+    }
+
+    void allocate() {
+      const auto size = prod(high - low + VecIndex_(1));
+      weights.assign(size, Num{0.0});
+      std::apply([size](auto&... vals) { (vals.assign(size, {}), ...); },
+                 sums);
+    }
+
+    auto contains(const VecIndex_& node) const noexcept -> bool {
+      return !is_empty && all(low <= node) && all(node <= high);
+    }
+
+    auto slot(const VecIndex_& node) const noexcept -> size_t {
+      const auto shape = high - low + VecIndex_(1);
+      const auto offset = node - low;
+      auto flat_index = offset[0];
+      for (size_t i = 1; i < Dim; ++i) {
+        flat_index = shape[i] * flat_index + offset[i];
+      }
+      return flat_index;
+    }
+  };
+
+  // Range of the grid nodes within the radius to the point, if any.
+  auto node_range_(const Point& x, Num radius) const
+      -> std::optional<std::pair<VecIndex_, VecIndex_>> {
+    const auto num_nodes = vec_cast<Num>(grid_.num_cells());
+    const auto& low = grid_.box().low();
+    const auto& extents = grid_.cell_extents();
+    const auto first = ceil((x - Point(radius) - low) / extents - Point(0.5));
+    const auto last = floor((x + Point(radius) - low) / extents - Point(0.5));
+    if (!all(first < num_nodes) || !all(last >= Point(Num{0.0}))) return {};
+    return std::pair{
+        vec_cast<size_t>(maximum(first, Point(Num{0.0}))),
+        vec_cast<size_t>(minimum(last, num_nodes - Point(Num{1.0})))};
+  }
+
+  // Unflatten the grid node index, the last axis is the fastest.
+  auto unflatten_(size_t flat_node) const -> VecIndex_ {
+    VecIndex_ node{};
+    for (size_t i = Dim; i-- > 0; flat_node /= grid_.num_cells()[i]) {
+      node[i] = flat_node % grid_.num_cells()[i];
+    }
+    return node;
+  }
+
+  // Position of the grid node, which is the center of the grid cell.
+  auto node_point_(const VecIndex_& node) const -> Point {
+    return grid_.box().low() +
+           (vec_cast<Num>(node) + Point(Num{0.5})) * grid_.cell_extents();
+  }
+
+  // Write the projected fields into a time step or its snapshot.
+  template<class TimeStep>
+  void write_(TimeStep&& time_step) const {
+    TIT_ASSUME_UNIVERSAL(TimeStep, time_step);
+    auto&& uniforms = time_step.uniforms();
+    const std::array box{grid_.box().low(), grid_.box().high()};
+    uniforms.create_array("grid_box", std::span{box});
+    const auto& num_nodes = grid_.num_cells();
+    std::array<uint64_t, Dim> shape{};
+    for (size_t i = 0; i < Dim; ++i) shape[i] = num_nodes[i];
+    uniforms.create_array("grid_shape", std::span{shape});
+    auto&& varyings = time_step.varyings();
+    fields.for_each([&varyings, this](auto field) {
+      const auto& vals = values(field);
+      varyings.create_array(field.field_name,
+                            std::span{vals.data(), vals.size()});
+    });
+  }
+
+  Kernel kernel_;
+  Grid grid_;
+  std::vector<Tile_> tiles_;
+  Values_ values_;
+
+}; // class GridProjection
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,100 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/grid_projection.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the projection.
+using ProjectionEquations = EquationsStub<
+    meta::Set{sph::r, sph::h, sph::parinfo, sph::m, sph::rho, sph::p, sph::v},
+    meta::Set{sph::r, sph::parinfo, sph::p, sph::v}>;
+
+TEST_CASE("sph::GridProjection") {
+  constexpr double width = 1.0;
+  const sph::CubicSplineKernel kernel{};
+
+  // Setup the particles on a lattice, with the pressure being constant,
+  // and the velocity being linear.
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               ProjectionEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i), static_cast<double>(j)};
+      sph::v[a] = sph::r[a];
+      sph::p[a] = 3.0;
+    }
+  }
+  sph::h[particles] = width;
+  sph::m[particles] = 1.0;
+  sph::rho[particles] = 1.0;
+
+  // Project the fields onto a grid, that sticks out of the particles.
+  const geom::Grid grid{geom::BBox{Vec{4.0, 4.0}, Vec{24.0, 12.0}},
+                        Vec<size_t, 2>{20, 8}};
+  sph::GridProjection projection{sph::Space<double, 2>{},
+                                 meta::Set{sph::p, sph::v},
+                                 kernel,
+                                 grid};
+  projection.project(particles);
+  const auto& p_values = projection.values(sph::p);
+  const auto& v_values = projection.values(sph::v);
+  REQUIRE(p_values.shape() == std::array<size_t, 2>{20, 8});
+  REQUIRE(v_values.shape() == std::array<size_t, 2>{20, 8});
+  for (size_t i = 0; i < 20; ++i) {
+    for (size_t j = 0; j < 8; ++j) {
+      const Vec node{4.5 + static_cast<double>(i),
+                     4.5 + static_cast<double>(j)};
+      if (node[0] <= 11.5) {
+        // Nodes inside of the particles.
+        CHECK_APPROX_EQ(p_values[i, j], 3.0);
+        CHECK(approx_equal_to(v_values[i, j], node));
+      } else if (node[0] >= 18.5) {
+        // Nodes far from the particles.
+        CHECK(p_values[i, j] == 0.0);
+        CHECK(all(v_values[i, j] == Vec{0.0, 0.0}));
+      }
+    }
+  }
+
+  // Write the projected fields.
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  projection.write(0.0, series);
+  const auto step = series.last_time_step();
+  const auto shape = step.uniforms().find_array("grid_shape");
+  REQUIRE(shape.has_value());
+  CHECK(shape->size() == 2);
+  const auto pressures = step.varyings().find_array("p");
+  REQUIRE(pressures.has_value());
+  CHECK(pressures->size() == 160);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,13 +5,16 @@
 
 #pragma once
 
+#include <array>
 #include <concepts>
 #include <numbers>
+#include <utility>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/sph/field.hpp"
@@ -24,6 +27,25 @@ namespace tit::sph {
 // Kernel class.
 //
 
+template<class K, class Num, size_t Dim>
+class BoundKernel;
+
+namespace impl {
+
+// Scaled radius `q = |x| / h` and its spatial gradient `x / (|x| * h)`,
+// computed from a single reciprocal square root. Gradient is zero for the
+// tiny radii.
+template<class Num, size_t Dim>
+constexpr auto radius_and_grad(const Vec<Num, Dim>& x, Num h_inverse) noexcept
+    -> std::pair<Num, Vec<Num, Dim>> {
+  const auto norm2_x = norm2(x);
+  const auto norm_x_recip =
+      norm2_x >= pow2(tiny_v<Num>) ? approx_rsqrt(norm2_x) : Num{0.0};
+  return {h_inverse * norm2_x * norm_x_recip, x * (h_inverse * norm_x_recip)};
+}
+
+} // namespace impl
+
 /// Abstract smoothing kernel.
 class Kernel {
 public:
@@ -43,11 +65,14 @@ public:
   }
 
   /// Value of the smoothing kernel for two particles.
+  ///
+  /// If the particle widths are varying and the pair width is not specified,
+  /// the average width of the pair is used, so that the kernel is symmetric.
   /// @{
   template<particle_view<required_fields> PV>
   constexpr auto operator()(this auto& self, PV a, PV b) noexcept {
-    static_assert(has_uniform<PV>(h));
-    return self(r[a, b], h[a]);
+    if constexpr (has_uniform<PV>(h)) return self(r[a, b], h[a]);
+    else return self(r[a, b], avg(h[a], h[b]));
   }
   template<particle_view<required_fields> PV>
   constexpr auto operator()(this auto& self, PV a, PV b, auto h_ab) noexcept {
@@ -56,12 +81,12 @@ public:
   }
   /// @}
 
-  /// Value of the smoothing kernel for two particles.
+  /// Spatial gradient of the smoothing kernel for two particles.
   /// @{
   template<particle_view<required_fields> PV>
   constexpr auto grad(this auto& self, PV a, PV b) noexcept {
-    static_assert(has_uniform<PV>(h));
-    return self.grad(r[a, b], h[a]);
+    if constexpr (has_uniform<PV>(h)) return self.grad(r[a, b], h[a]);
+    else return self.grad(r[a, b], avg(h[a], h[b]));
   }
   template<particle_view<required_fields> PV>
   constexpr auto grad(this auto& self, PV a, PV b, auto h_ab) noexcept {
@@ -74,8 +99,8 @@ public:
   /// @{
   template<particle_view<required_fields> PV>
   constexpr auto width_deriv(this auto& self, PV a, PV b) noexcept {
-    static_assert(has_uniform<PV>(h));
-    return self.width_deriv(r[a, b], h[a]);
+    if constexpr (has_uniform<PV>(h)) return self.width_deriv(r[a, b], h[a]);
+    else return self.width_deriv(r[a, b], avg(h[a], h[b]));
   }
   template<particle_view<required_fields> PV>
   constexpr auto width_deriv(this auto& self, PV a, PV b, auto h_ab) noexcept {
@@ -113,11 +138,35 @@ public:
     TIT_ASSERT(h > Num{0.0}, "Kernel width must be positive!");
     const auto h_inverse = inverse(h);
     const auto w = Self::template weight<Num, Dim>() * pow(h_inverse, Dim);
-    const auto q = h_inverse * norm(x);
-    const auto grad_q = normalize(x) * h_inverse;
+    const auto [q, grad_q] = impl::radius_and_grad(x, h_inverse);
     return w * self.unit_deriv(q) * grad_q;
   }
 
+  /// Spatial gradients of the smoothing kernel for a batch of points.
+  ///
+  /// Points are passed in the structure-of-arrays layout: `x[i]` is the
+  /// register with the `i`-th coordinates of the points.
+  template<class Self, class Num, size_t Size, size_t Dim>
+  constexpr auto grad(this Self& self,
+                      const std::array<simd::Reg<Num, Size>, Dim>& x,
+                      const Num& h) noexcept
+      -> std::array<simd::Reg<Num, Size>, Dim> {
+    using Reg = simd::Reg<Num, Size>;
+    TIT_ASSERT(h > Num{0.0}, "Kernel width must be positive!");
+    const auto h_inverse = inverse(h);
+    const auto w = Self::template weight<Num, Dim>() * pow(h_inverse, Dim);
+    Reg norm2_x{};
+    for (const auto& x_i : x) norm2_x += x_i * x_i;
+    const auto norm_x_recip = simd::filter(norm2_x >= Reg(pow2(tiny_v<Num>)),
+                                           simd::approx_rsqrt(norm2_x));
+    const auto q = Reg(h_inverse) * norm2_x * norm_x_recip;
+    const auto grad_factor =
+        Reg(w * h_inverse) * self.unit_deriv(q) * norm_x_recip;
+    std::array<Reg, Dim> result;
+    for (size_t i = 0; i < Dim; ++i) result[i] = grad_factor * x[i];
+    return result;
+  }
+
   /// Width derivative of the smoothing kernel at point.
   template<class Self, class Num, size_t Dim>
   constexpr auto width_deriv(this Self& self,
@@ -132,8 +181,76 @@ public:
     return dw_dh * self.unit_value(q) + w * self.unit_deriv(q) * dq_dh;
   }
 
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Bind the smoothing kernel to the uniform width, see `BoundKernel`.
+  template<size_t Dim, class Self, class Num>
+  constexpr auto bind(this const Self& self, Num width) noexcept
+      -> BoundKernel<Self, Num, Dim> {
+    return BoundKernel<Self, Num, Dim>{self, width};
+  }
+
+  /// Bind the smoothing kernel to the uniform width of the particle array.
+  template<particle_array ParticleArray>
+    requires (has_uniform<ParticleArray>(h))
+  constexpr auto bind(this const auto& self,
+                      const ParticleArray& particles) noexcept {
+    return self.template bind<particle_dim_v<ParticleArray>>(h[particles]);
+  }
+
 }; // class Kernel
 
+/// Smoothing kernel bound to the uniform width.
+///
+/// Normalization constants of the kernel are computed once on binding, so
+/// that only the work that depends on the point remains in the evaluations.
+/// Bound kernel references the original one, which must outlive it.
+template<class K, class Num, size_t Dim>
+class BoundKernel final {
+public:
+
+  /// Bind the smoothing kernel to the width.
+  constexpr BoundKernel(const K& kernel, Num width) noexcept
+      : kernel_{&kernel}, h_inverse_{inverse(width)},
+        w_{K::template weight<Num, Dim>() * pow(h_inverse_, Dim)},
+        w_grad_{w_ * h_inverse_} {
+    TIT_ASSERT(width > Num{0.0}, "Kernel width must be positive!");
+  }
+
+  /// Value of the smoothing kernel for two particles.
+  template<particle_view PV>
+  constexpr auto operator()(PV a, PV b) const noexcept -> Num {
+    return (*this)(r[a, b]);
+  }
+
+  /// Spatial gradient of the smoothing kernel for two particles.
+  template<particle_view PV>
+  constexpr auto grad(PV a, PV b) const noexcept -> Vec<Num, Dim> {
+    return grad(r[a, b]);
+  }
+
+  /// Value of the smoothing kernel at point.
+  constexpr auto operator()(const Vec<Num, Dim>& x) const noexcept -> Num {
+    const auto q = h_inverse_ * norm(x);
+    return w_ * kernel_->unit_value(q);
+  }
+
+  /// Spatial gradient of the smoothing kernel at point.
+  constexpr auto grad(const Vec<Num, Dim>& x) const noexcept
+      -> Vec<Num, Dim> {
+    const auto [q, grad_q] = impl::radius_and_grad(x, h_inverse_);
+    return w_grad_ * kernel_->unit_deriv(q) * grad_q;
+  }
+
+private:
+
+  const K* kernel_;
+  Num h_inverse_;
+  Num w_;
+  Num w_grad_;
+
+}; // class BoundKernel
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
 // Gaussian kernel.
@@ -326,6 +443,15 @@ public:
     return q < Num{2.0} ? self.unit_deriv_notrunc(q) : Num{0.0};
   }
 
+  /// Derivative of the unit smoothing kernel for a register of points.
+  template<class Num, size_t Size>
+  constexpr auto unit_deriv(this auto& self,
+                            const simd::Reg<Num, Size>& q) noexcept
+      -> simd::Reg<Num, Size> {
+    using Reg = simd::Reg<Num, Size>;
+    return simd::filter(q < Reg(Num{2.0}), self.unit_deriv_notrunc(q));
+  }
+
 }; // class WendlandKernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -426,6 +552,139 @@ public:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+//
+// Tabulated kernels.
+//
+
+/// Interpolation scheme of the tabulated kernel.
+enum class KernelInterpolation : uint8_t {
+  linear, ///< Linear interpolation.
+  cubic,  ///< Cubic interpolation.
+};
+
+/// Tabulated smoothing kernel.
+///
+/// Unit kernel value and derivative of the base kernel are precomputed on a
+/// uniform grid over the support radius at construction and interpolated on
+/// evaluation. In the cubic mode, the value is interpolated with the Hermite
+/// spline (using the tabulated derivatives), and the derivative is
+/// interpolated with the Catmull-Rom spline.
+template<class BaseKernel,
+         size_t TableSize = 2048,
+         KernelInterpolation Interpolation = KernelInterpolation::cubic>
+  requires std::derived_from<BaseKernel, Kernel> && (TableSize >= 4)
+class TabulatedKernel final : public Kernel {
+public:
+
+  /// Number of the table nodes.
+  static constexpr size_t table_size = TableSize;
+
+  /// Construct the tabulated kernel.
+  constexpr explicit TabulatedKernel(BaseKernel base_kernel = {}) noexcept {
+    for (size_t i = 0; i < TableSize; ++i) {
+      const auto q = static_cast<float64_t>(i) * step_;
+      values_[i] = base_kernel.unit_value(q);
+      derivs_[i] = base_kernel.unit_deriv(q);
+    }
+  }
+
+  /// Kernel weight.
+  template<class Num, size_t Dim>
+  static consteval auto weight() noexcept -> Num {
+    return BaseKernel::template weight<Num, Dim>();
+  }
+
+  /// Unit support radius.
+  template<class Num>
+  static consteval auto unit_radius() noexcept -> Num {
+    return BaseKernel::template unit_radius<Num>();
+  }
+
+  /// Value of the unit smoothing kernel at a point.
+  template<std::floating_point Num>
+  constexpr auto unit_value(Num q) const noexcept -> Num {
+    TIT_ASSERT(q >= Num{0.0}, "Kernel argument must be non-negative!");
+    if (q >= unit_radius<Num>()) return Num{0.0};
+    const auto [i, t] = locate_(q);
+    if constexpr (Interpolation == KernelInterpolation::linear) {
+      return static_cast<Num>(lerp_(values_, i, t));
+    } else {
+      // Hermite spline.
+      const auto t2 = pow2(t);
+      const auto t3 = t2 * t;
+      return static_cast<Num>(
+          (2 * t3 - 3 * t2 + 1) * values_[i] +
+          (t3 - 2 * t2 + t) * step_ * derivs_[i] +
+          (-2 * t3 + 3 * t2) * values_[i + 1] +
+          (t3 - t2) * step_ * derivs_[i + 1]);
+    }
+  }
+
+  /// Derivative of the unit smoothing kernel at a point.
+  template<std::floating_point Num>
+  constexpr auto unit_deriv(Num q) const noexcept -> Num {
+    TIT_ASSERT(q >= Num{0.0}, "Kernel argument must be non-negative!");
+    if (q >= unit_radius<Num>()) return Num{0.0};
+    const auto [i, t] = locate_(q);
+    if constexpr (Interpolation == KernelInterpolation::linear) {
+      return static_cast<Num>(lerp_(derivs_, i, t));
+    } else {
+      // Catmull-Rom spline. Edge nodes are repeated outside the table.
+      const auto p0 = derivs_[i == 0 ? 0 : i - 1];
+      const auto p1 = derivs_[i];
+      const auto p2 = derivs_[i + 1];
+      const auto p3 = derivs_[std::min(i + 2, TableSize - 1)];
+      return static_cast<Num>(
+          p1 + 0.5 * t *
+                   (p2 - p0 +
+                    t * (2 * p0 - 5 * p1 + 4 * p2 - p3 +
+                         t * (3 * (p1 - p2) + p3 - p0))));
+    }
+  }
+
+private:
+
+  using Table_ = std::array<float64_t, TableSize>;
+
+  // Table step.
+  static constexpr auto step_ =
+      BaseKernel::template unit_radius<float64_t>() /
+      static_cast<float64_t>(TableSize - 1);
+
+  // Find the table interval and the local coordinate within it.
+  template<class Num>
+  static constexpr auto locate_(Num q) noexcept
+      -> std::pair<size_t, float64_t> {
+    const auto x = static_cast<float64_t>(q) / step_;
+    const auto i = std::min(static_cast<size_t>(x), TableSize - 2);
+    return {i, x - static_cast<float64_t>(i)};
+  }
+
+  // Linearly interpolate the table.
+  static constexpr auto lerp_(const Table_& table,
+                              size_t i,
+                              float64_t t) noexcept -> float64_t {
+    return table[i] + t * (table[i + 1] - table[i]);
+  }
+
+  Table_ values_{};
+  Table_ derivs_{};
+
+}; // class TabulatedKernel
+
+namespace impl {
+
+template<class K>
+inline constexpr bool is_tabulated_kernel_v = false;
+
+template<class BaseKernel, size_t TableSize, KernelInterpolation I>
+inline constexpr bool
+    is_tabulated_kernel_v<TabulatedKernel<BaseKernel, TableSize, I>> = true;
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Smoothing kernel type.
 template<class K>
 concept kernel = std::same_as<K, GaussianKernel> || //
@@ -434,7 +693,12 @@ concept kernel = std::same_as<K, GaussianKernel> || //
                  std::same_as<K, QuinticSplineKernel> ||
                  std::same_as<K, QuarticWendlandKernel> ||
                  std::same_as<K, SixthOrderWendlandKernel> ||
-                 std::same_as<K, EighthOrderWendlandKernel>;
+                 std::same_as<K, EighthOrderWendlandKernel> ||
+                 impl::is_tabulated_kernel_v<K>;
+
+/// Smoothing kernel type, which gradients can be evaluated on SIMD registers.
+template<class K>
+concept simd_kernel = kernel<K> && std::derived_from<K, WendlandKernel>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -3,10 +3,13 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <array>
 #include <numbers>
+#include <ranges>
 
 #include "tit/core/math.hpp"
 #include "tit/core/numbers/dual.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
@@ -29,6 +32,11 @@ namespace {
            sph::SixthOrderWendlandKernel,                                      \
            sph::EighthOrderWendlandKernel)
 
+#define SIMD_KERNEL_TYPES                                                      \
+  TIT_PASS(sph::QuarticWendlandKernel,                                         \
+           sph::SixthOrderWendlandKernel,                                      \
+           sph::EighthOrderWendlandKernel)
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE_TEMPLATE("sph::Kernel::operator()", Kernel, KERNEL_TYPES) {
@@ -113,6 +121,42 @@ TEST_CASE_TEMPLATE("sph::Kernel::grad", Kernel, KERNEL_TYPES) {
       CHECK(approx_equal_to(value.deriv(), sum(gradient)));
     }
   }
+  SUBCASE("all components at once") {
+    for (const double h : {1.0, 0.1, 0.01}) {
+      REQUIRE(w.radius(h) >= h * std::numbers::sqrt3);
+      const auto x = pow2(h) * Vec{0.1, 0.2, 0.3};
+      const auto value = w(seed_duals(x), VecDual<double, 3>{h});
+      const auto gradient = w.grad(x, h);
+      CHECK(approx_equal_to(value.deriv(), gradient));
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sph::Kernel::grad (SIMD)", Kernel, SIMD_KERNEL_TYPES) {
+  // Ensure that the kernel gradients computed on SIMD registers match the
+  // scalar ones: both inside and outside of the support sphere, and at zero.
+  using Reg = simd::Reg<double, 2>;
+  const Kernel w{};
+  for (const double h : {1.0, 0.1, 0.01}) {
+    const std::array<Vec<double, 2>, 3> points{
+        pow2(h) * Vec{0.1, 0.2},
+        w.radius(h) * Vec{0.8, 0.7},
+        Vec{0.0, 0.0},
+    };
+    for (const auto& [x, y] : std::views::pairwise(points)) {
+      const auto gradients = w.grad(std::array{Reg{std::array{x[0], y[0]}},
+                                               Reg{std::array{x[1], y[1]}}},
+                                    h);
+      std::array<std::array<double, 2>, 2> out{};
+      gradients[0].store(out[0]), gradients[1].store(out[1]);
+      const auto x_gradient = w.grad(x, h);
+      const auto y_gradient = w.grad(y, h);
+      CHECK(approx_equal_to(Vec{out[0][0], out[1][0]}, x_gradient));
+      CHECK(approx_equal_to(Vec{out[0][1], out[1][1]}, y_gradient));
+    }
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -133,5 +177,57 @@ TEST_CASE_TEMPLATE("sph::Kernel::width_deriv", Kernel, KERNEL_TYPES) {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE_TEMPLATE("sph::Kernel::bind", Kernel, KERNEL_TYPES) {
+  // Ensure that the bound kernel matches the original one, both inside and
+  // outside of the support sphere, and at zero.
+  const Kernel w{};
+  for (const double h : {1.0, 0.1, 0.01}) {
+    const auto w_bound = w.template bind<2>(h);
+    for (const auto& x : {pow2(h) * Vec{0.1, 0.2},
+                          w.radius(h) * Vec{0.5, 0.6},
+                          w.radius(h) * Vec{0.8, 0.7},
+                          Vec{0.0, 0.0}}) {
+      CHECK(approx_equal_to(w_bound(x), w(x, h)));
+      CHECK(approx_equal_to(w_bound.grad(x), w.grad(x, h)));
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sph::TabulatedKernel", Kernel, KERNEL_TYPES) {
+  // Ensure that the tabulated kernel matches the analytic one over the
+  // entire support, and vanishes outside of it.
+  const Kernel w{};
+  const auto check_kernel = [&w](const auto& w_tab, double tolerance) {
+    const auto r = w.template unit_radius<double>();
+    for (size_t i = 0; i <= 1000; ++i) {
+      const auto q = 1.1 * r * static_cast<double>(i) / 1000.0;
+      CHECK(abs(w_tab.unit_value(q) - w.unit_value(q)) <= tolerance);
+      CHECK(abs(w_tab.unit_deriv(q) - w.unit_deriv(q)) <= tolerance);
+    }
+  };
+  SUBCASE("linear") {
+    using TabKernel =
+        sph::TabulatedKernel<Kernel, 4096, sph::KernelInterpolation::linear>;
+    check_kernel(TabKernel{}, 1.0e-4);
+  }
+  SUBCASE("cubic") {
+    using TabKernel =
+        sph::TabulatedKernel<Kernel, 4096, sph::KernelInterpolation::cubic>;
+    check_kernel(TabKernel{}, 1.0e-7);
+  }
+  SUBCASE("normalization") {
+    const sph::TabulatedKernel<Kernel> w_tab{};
+    for (const double h : {1.0, 0.1, 0.01}) {
+      const auto r = w_tab.radius(h);
+      const auto i = integrate_sp(std::bind_back(w_tab, h), r);
+      CHECK(approx_equal_to(i, 1.0));
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -0,0 +1,196 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Open boundary with the inflow and the outflow zones.
+///
+/// Inlet particles move with the prescribed inflow velocity. Once an inlet
+/// particle leaves the inlet zone, it becomes a fluid particle, and its copy
+/// is emitted at the upstream end of the zone. Fluid particles that enter the
+/// outlet zone become outlet particles, that keep moving with their current
+/// velocity. Once an outlet particle leaves the outlet zone, it is recycled:
+/// it is reused for the next inlet particle emission, so that the particle
+/// array neither grows nor reallocates as long as the outflow keeps up with
+/// the inflow.
+template<class Vec>
+class OpenBoundary final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v};
+
+  /// Bounding box type.
+  using Box = geom::BBox<Vec>;
+
+  /// Construct an open boundary.
+  ///
+  /// @param inlet_box      Inlet zone. It must be longer along the flow than
+  ///                       the distance particles travel within a time step.
+  /// @param inlet_velocity Inflow velocity.
+  /// @param outlet_box     Outlet zone.
+  constexpr OpenBoundary(const Box& inlet_box,
+                         const Vec& inlet_velocity,
+                         const Box& outlet_box)
+      : inlet_box_{inlet_box}, inlet_velocity_{inlet_velocity},
+        outlet_box_{outlet_box} {
+    TIT_ASSERT(!is_tiny(norm(inlet_velocity_)),
+               "Inflow velocity must be non-zero!");
+
+    // Emitted particles are shifted upstream by the inlet zone length.
+    const auto dir = normalize(inlet_velocity_);
+    inlet_shift_ = -dot(maximum(dir, -dir), inlet_box_.extents()) * dir;
+  }
+
+  /// Inlet zone.
+  constexpr auto inlet_box() const noexcept -> const Box& {
+    return inlet_box_;
+  }
+
+  /// Outlet zone.
+  constexpr auto outlet_box() const noexcept -> const Box& {
+    return outlet_box_;
+  }
+
+  /// Advance the inlet and the outlet particles, emit and recycle them.
+  ///
+  /// Particle mesh is invalidated if any particles were emitted, recycled or
+  /// have changed their types.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void update(ParticleMesh& mesh, ParticleArray& particles, real_t dt) {
+    TIT_PROFILE_SECTION("OpenBoundary::update()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    TIT_ASSERT(dt > 0.0, "Time step must be positive!");
+
+    // Advance the inlet and the outlet particles.
+    const auto dt_ = static_cast<Num>(dt);
+    par::for_each(particles.inlet(), [dt_, this](PV a) {
+      v[a] = inlet_velocity_;
+      r[a] += dt_ * inlet_velocity_;
+    });
+    par::for_each(particles.outlet(), [dt_](PV a) { r[a] += dt_ * v[a]; });
+
+    // Select the inlet particles that left the inlet zone, and the outlet
+    // particles that left the outlet zone.
+    const auto left_inlet = [this](PV a) {
+      return !inlet_box_.contains(r[a]);
+    };
+    const auto left_outlet = [this](PV a) {
+      return !outlet_box_.contains(r[a]);
+    };
+    static thread_local std::vector<size_t> exits{};
+    static thread_local std::vector<size_t> expired{};
+    select_(particles, ParticleType::inlet, left_inlet, exits);
+    select_(particles, ParticleType::outlet, left_outlet, expired);
+
+    // Take the expired outlet particles as the targets for the emitted inlet
+    // particles, and append the new inlet particles only if there are not
+    // enough of them. Appending the inlet particles moves the outlet
+    // particles, so the expired ones are selected again.
+    const auto num_reused = std::min(exits.size(), expired.size());
+    const auto num_appended = exits.size() - num_reused;
+    static thread_local std::vector<size_t> targets{};
+    if (num_appended > 0) {
+      const auto appended =
+          particles.append_n(ParticleType::inlet, num_appended);
+      const auto first_appended = appended.front().index();
+      select_(particles, ParticleType::outlet, left_outlet, expired);
+      targets.assign(expired.begin(), expired.begin() + num_reused);
+      for (size_t i = 0; i < num_appended; ++i) {
+        targets.push_back(first_appended + i);
+      }
+    } else {
+      targets.assign(expired.begin(), expired.begin() + num_reused);
+    }
+
+    // Emit the copies of the exiting inlet particles at the upstream end of
+    // the inlet zone.
+    par::for_each(std::views::zip(exits, targets), [&particles, this](auto ab) {
+      const auto [exit, target] = ab;
+      const auto a = particles[exit];
+      const auto b = particles[target];
+      ParticleArray::shared_fields.for_each(
+          [a, b](auto field) { field[b] = field[a]; });
+      r[b] += inlet_shift_;
+    });
+
+    // Update the particle types. Each change moves the particles, so the
+    // particles are selected again every time.
+    static thread_local std::vector<size_t> selected{};
+    particles.retype(std::views::take(targets, num_reused),
+                     ParticleType::inlet);
+    select_(particles, ParticleType::outlet, left_outlet, selected);
+    particles.remove(selected);
+    select_(particles, ParticleType::inlet, left_inlet, selected);
+    particles.retype(selected, ParticleType::fluid);
+    select_(
+        particles,
+        ParticleType::fluid,
+        [this](PV a) { return outlet_box_.contains(r[a]); },
+        selected);
+    const auto num_entered = selected.size();
+    particles.retype(selected, ParticleType::outlet);
+    TIT_STATS("OpenBoundary::num_emitted", exits.size());
+    TIT_STATS("OpenBoundary::num_recycled", num_reused);
+
+    // Particle indices were changed, so the mesh must be rebuilt.
+    if (!exits.empty() || !expired.empty() || num_entered > 0) {
+      mesh.invalidate();
+    }
+  }
+
+private:
+
+  // Select the indices of the particles of the specified type that satisfy
+  // the predicate.
+  template<particle_array ParticleArray, class Pred>
+  static void select_(ParticleArray& particles,
+                      ParticleType type,
+                      const Pred& pred,
+                      std::vector<size_t>& selected) {
+    const auto typed = particles.typed(type);
+    selected.resize(typed.size());
+    const auto selected_end = par::copy_if(
+        typed | std::views::transform([](auto a) { return a.index(); }),
+        selected.begin(),
+        [&particles, &pred](size_t index) { return pred(particles[index]); });
+    selected.erase(selected_end, selected.end());
+  }
+
+  Box inlet_box_;
+  Vec inlet_velocity_;
+  Box outlet_box_;
+  Vec inlet_shift_;
+
+}; // class OpenBoundary
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
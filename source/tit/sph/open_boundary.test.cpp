@@ -0,0 +1,86 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/open_boundary.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the boundary.
+using BoundaryEquations = EquationsStub<
+    meta::Set{sph::r, sph::v, sph::h, sph::parinfo},
+    meta::Set{sph::r, sph::v, sph::parinfo}>;
+
+// Sorted particle positions along the flow.
+auto particle_xs(const auto& particles, sph::ParticleType type)
+    -> std::vector<double> {
+  auto xs = particles.typed(type) |
+            std::views::transform([](auto a) { return sph::r[a][0]; }) |
+            std::ranges::to<std::vector>();
+  std::ranges::sort(xs);
+  return xs;
+}
+
+TEST_CASE("sph::OpenBoundary") {
+  // Setup the boundary: particles enter at the left and leave at the right.
+  sph::OpenBoundary boundary{geom::BBox{Vec{0.0, 0.0}, Vec{1.0, 1.0}},
+                             Vec{1.0, 0.0},
+                             geom::BBox{Vec{4.0, 0.0}, Vec{5.0, 1.0}}};
+  sph::ParticleMesh mesh{geom::GridSearch{1.0}};
+
+  // Setup the particles: an inlet particle that is about to enter the
+  // domain, and a fluid particle that is about to enter the outlet zone.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, BoundaryEquations{}};
+  sph::h[particles] = 1.0;
+  sph::r[particles.append(sph::ParticleType::inlet)] = Vec{0.75, 0.5};
+  sph::r[particles.append(sph::ParticleType::fluid)] = Vec{4.2, 0.5};
+
+  SUBCASE("recycled") {
+    // Expired outlet particle must be reused for the emitted inlet particle.
+    const auto a = particles.append(sph::ParticleType::outlet);
+    sph::r[a] = Vec{4.95, 0.5};
+    sph::v[a] = Vec{1.0, 0.0};
+    boundary.update(mesh, particles, /*dt=*/0.5);
+    CHECK(particles.size() == 3);
+  }
+  SUBCASE("appended") {
+    // Without expired outlet particles, the inlet particle must be appended.
+    boundary.update(mesh, particles, /*dt=*/0.5);
+    CHECK(particles.size() == 3);
+  }
+  CHECK_RANGE_EQ(particle_xs(particles, sph::ParticleType::fluid),
+                 std::vector{1.25});
+  CHECK_RANGE_EQ(particle_xs(particles, sph::ParticleType::inlet),
+                 std::vector{0.25});
+  CHECK_RANGE_EQ(particle_xs(particles, sph::ParticleType::outlet),
+                 std::vector{4.2});
+  for (const auto a : particles.inlet()) {
+    CHECK(all(sph::v[a] == Vec{1.0, 0.0}));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,9 +5,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <concepts>
+#include <functional>
+#include <optional>
 #include <ranges>
 #include <span>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -15,13 +20,29 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
 #include "tit/core/type_utils.hpp"
+#include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/data/arrow.hpp"
+#include "tit/data/live.hpp"
+#include "tit/data/shared.hpp"
 #include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/geom/periodic_box.hpp"
+#include "tit/geom/sort.hpp"
 
 #include "tit/sph/field.hpp"
+#include "tit/sph/particle_output.hpp"
+#include "tit/sph/particle_storage.hpp"
 
 namespace tit::sph {
 
@@ -29,11 +50,31 @@ namespace tit::sph {
 
 /// Particle type.
 enum class ParticleType : uint8_t {
-  fluid, ///< Fluid particle.
-  fixed, ///< Fixed (boundary) particle.
-  count, ///< Number of particle types.
+  fluid,  ///< Fluid particle.
+  fixed,  ///< Fixed (boundary) particle.
+  inlet,  ///< Inflow buffer particle.
+  outlet, ///< Outflow buffer particle.
+  count,  ///< Number of particle types.
 };
 
+/// Particle type layout, where the particles of each type are stored in a
+/// contiguous range, and the ranges follow in the order of the types.
+/// Iteration over the particles of a type is a plain index range.
+struct RangedTypes final {};
+
+/// Particle type layout, where the particles of all the types are
+/// interleaved, and each particle stores a compact type tag. Iteration over
+/// the particles of a type goes through the precomputed index lists. The
+/// whole array may then follow a single spatial order, so that, e.g., the
+/// fluid particles next to the walls are stored close to their fixed
+/// neighbors.
+struct TaggedTypes final {};
+
+/// Particle type layout.
+template<class Types>
+concept particle_type_layout =
+    std::same_as<Types, RangedTypes> || std::same_as<Types, TaggedTypes>;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Particle view.
@@ -134,8 +175,51 @@ concept particle_view =
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Reference to the stored particle field value, converted to the field value
+// type, if the storage type is different.
+template<class Value, class Storage>
+constexpr auto particle_field_ref(Storage& value) noexcept -> decltype(auto) {
+  if constexpr (std::same_as<Value, std::remove_const_t<Storage>>) {
+    return value;
+  } else if constexpr (std::is_const_v<Storage>) {
+    return field_cast<Value>(value);
+  } else return FieldRef<Value, Storage>{value};
+}
+
+} // namespace impl
+
+namespace impl {
+
+// Fields of the equations that are meaningful for the fluid particles only,
+// see `ParticleArray::fluid_fields`.
+template<class Equations>
+consteval auto equations_fluid_fields() noexcept {
+  if constexpr (requires { Equations::fluid_fields; }) {
+    return Equations::fluid_fields;
+  } else return meta::Set{};
+}
+
+template<class Equations>
+using equations_fluid_fields_t = decltype(equations_fluid_fields<Equations>());
+
+} // namespace impl
+
 /// Particle array.
-template<space Space, field_set Uniforms, field_set Varyings>
+///
+/// @tparam Layout Layout of the varying particle fields in memory, see
+///                `SoALayout` and `AoSoALayout`.
+/// @tparam Types  Layout of the particle types, see `RangedTypes` and
+///                `TaggedTypes`.
+/// @tparam Fluids Varying fields that are stored for the fluid particles
+///                only, see `fluid_fields`.
+template<space Space,
+         field_set Uniforms,
+         field_set Varyings,
+         particle_layout Layout = SoALayout,
+         particle_type_layout Types = RangedTypes,
+         field_set Fluids = meta::Set<>>
 class ParticleArray final {
 public:
 
@@ -151,56 +235,496 @@ public:
   /// Set of particle fields that are present.
   static constexpr field_set auto fields = uniform_fields | varying_fields;
 
+  /// Whether the particle types are tagged, see `TaggedTypes`.
+  static constexpr bool tagged_types = std::same_as<Types, TaggedTypes>;
+
+  /// Subset of varying particle fields that are stored for the fluid
+  /// particles only, e.g. the particle shifts. Fluid particles come first in
+  /// the ranged type layout, so the values are stored for the leading range
+  /// of the particles, and accessing them for the particles of the other
+  /// types is an error. If the types are tagged, the fields are stored for
+  /// all the particles.
+  static constexpr field_set auto fluid_fields = [] {
+    if constexpr (tagged_types) return meta::Set{};
+    else return Fluids{} & Varyings{};
+  }();
+
+  /// Subset of varying particle fields that are stored for all the particles.
+  static constexpr field_set auto shared_fields = varying_fields - fluid_fields;
+
+  /// Subset of varying particle fields that are stored in separate
+  /// contiguous arrays, i.e. are not stored in tiles.
+  static constexpr field_set auto column_fields =
+      ParticleStorage<Space, decltype(auto(shared_fields)), Layout>::
+          column_fields |
+      ParticleStorage<Space, decltype(auto(fluid_fields)), Layout>::
+          column_fields;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Construct a particle array.
   ///
   /// @param space The space in which the particles are defined.
   /// @param equations The equations that define the particle fields.
+  /// @param layout The layout of the varying particle fields.
+  /// @param types The layout of the particle types.
   template<class Equations>
   constexpr explicit ParticleArray(Space /*space*/,
-                                   Equations /*equations*/) noexcept {}
+                                   Equations /*equations*/,
+                                   Layout /*layout*/ = {},
+                                   Types /*types*/ = {}) noexcept {}
 
   /// Write a particle array into a data series.
+  ///
+  /// @param output Output schedule, see `ParticleOutput`. All of the fields
+  ///               of all of the particles are written by default.
+  /// @param step   Step number, used to select the fields that are due.
+  template<field_set Fields = std::remove_const_t<decltype(fields)>>
   void write(real_t time,
-             data::DataSeriesView<data::DataStorage> series) const {
-    auto time_step = series.create_time_step(time);
-    auto uniforms = time_step.uniforms();
-    ParticleArray::uniform_fields.for_each([&uniforms, this](auto field) {
-      uniforms.create_array(field.field_name, std::span{&field[*this], 1});
+             data::DataSeriesView<data::DataStorage> series,
+             const ParticleOutput<Fields>& output = ParticleOutput{fields},
+             size_t step = 0) const {
+    auto transaction = series.storage().transaction();
+    write_(series.create_time_step(time), output, step);
+    transaction.commit();
+  }
+
+  /// Snapshot a particle array and write it into a data series in
+  /// background. Blocks only if the writer queue is full.
+  template<field_set Fields = std::remove_const_t<decltype(fields)>>
+  void write(real_t time,
+             data::DataWriter& writer,
+             const ParticleOutput<Fields>& output = ParticleOutput{fields},
+             size_t step = 0) const {
+    auto snapshot = writer.acquire(time);
+    write_(*snapshot, output, step);
+    writer.submit(std::move(snapshot));
+  }
+
+  /// Snapshot a particle array and submit it to the live channel.
+  ///
+  /// Varying fields are written in the level-of-detail order, see
+  /// `geom::LODSort`, so that any leading range of the particles is a
+  /// uniform sample, and the viewers can progressively refine the view.
+  /// Subsampled output is therefore the leading range of that order.
+  template<field_set Fields = std::remove_const_t<decltype(fields)>>
+  void write(real_t time,
+             data::LiveChannel& channel,
+             const ParticleOutput<Fields>& output = ParticleOutput{fields},
+             size_t step = 0) const {
+    TIT_PROFILE_SECTION("ParticleArray::write(live)");
+    auto snapshot = channel.acquire(time);
+    if constexpr (varying_fields.contains(r)) {
+      std::vector<size_t> perm(size());
+      geom::lod_sort((*this)[r], perm);
+      write_(*snapshot,
+             output,
+             step,
+             std::span{perm}.first(output.num_written(size())));
+    } else {
+      write_(*snapshot, output, step);
+    }
+    channel.submit(std::move(snapshot));
+  }
+
+  /// Write a particle array into the shared memory channel. Contiguous
+  /// fields are copied into the shared memory directly, with a single copy.
+  template<field_set Fields = std::remove_const_t<decltype(fields)>>
+  void write(real_t time,
+             data::SharedChannel& channel,
+             const ParticleOutput<Fields>& output = ParticleOutput{fields},
+             size_t step = 0) const {
+    TIT_PROFILE_SECTION("ParticleArray::write(shared)");
+    auto frame = channel.acquire(time);
+    write_(frame, output, step);
+    channel.submit(std::move(frame));
+  }
+
+  /// Export the varying fields of the particle array as an Arrow record
+  /// batch, see `data::ArrowRecordBatch`. Fluid-only fields are skipped.
+  /// Contiguous fields are exported without copying, the fields stored in
+  /// tiles are copied into the batch.
+  ///
+  /// @note Exported arrays are invalidated once the particles are appended,
+  ///       removed or reordered.
+  auto arrow_batch() const -> data::ArrowRecordBatch {
+    data::ArrowRecordBatch batch;
+    shared_fields.for_each([&batch, this](auto field) {
+      batch.add_column(std::string{field.field_name}, field[*this]);
     });
-    auto varyings = time_step.varyings();
-    ParticleArray::varying_fields.for_each([&varyings, this](auto field) {
-      varyings.create_array(field.field_name, field[*this]);
+    return batch;
+  }
+
+  /// Write the complete particle array state into the output stream.
+  ///
+  /// All the fields are written raw and uncompressed, so the checkpoint can
+  /// only be restored into the particle array of the same type.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    TIT_PROFILE_SECTION("ParticleArray::checkpoint()");
+    if constexpr (tagged_types) {
+      serialize(out, next_id_);
+    } else {
+      serialize(out, particle_ranges_, next_id_);
+    }
+    uniform_fields.for_each(
+        [&out, this](auto field) { serialize(out, field[*this]); });
+    varying_data_.checkpoint(out);
+    if constexpr (has_fluid_fields_) fluid_data_.checkpoint(out);
+    if constexpr (tagged_types) out.write(std::as_bytes(std::span{types_}));
+  }
+
+  /// Restore the complete particle array state from the input stream.
+  ///
+  /// @note Particle indices are changed, so the particle mesh must be
+  ///       invalidated after the restoring.
+  void restore(InputStream<byte_t>& in) {
+    TIT_PROFILE_SECTION("ParticleArray::restore()");
+    if constexpr (tagged_types) {
+      if (!deserialize(in, next_id_)) deserialization_failed();
+    } else {
+      if (!deserialize(in, particle_ranges_, next_id_)) {
+        deserialization_failed();
+      }
+    }
+    uniform_fields.for_each([&in, this](auto field) {
+      if (!deserialize(in, field[*this])) deserialization_failed();
     });
+    varying_data_.restore(in);
+    if constexpr (has_fluid_fields_) fluid_data_.restore(in);
+    if constexpr (tagged_types) {
+      types_.resize(size());
+      const auto bytes = std::as_writable_bytes(std::span{types_});
+      if (in.read(bytes) != bytes.size()) deserialization_failed();
+      update_type_indices_();
+    } else if (particle_ranges_.back() != size()) {
+      TIT_THROW("Particle array checkpoint is inconsistent: {} particles "
+                "are expected, but {} are stored.",
+                particle_ranges_.back(),
+                size());
+    } else if (fluid_data_.size() != num_fluid_()) {
+      TIT_THROW("Particle array checkpoint is inconsistent: {} fluid "
+                "particles are expected, but {} are stored.",
+                num_fluid_(),
+                fluid_data_.size());
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Periodic box type.
+  using PeriodicBox = geom::PeriodicBox<field_value_t<r_t, Space>>;
+
+  /// Set the periodic box of the particles.
+  ///
+  /// Particle positions are wrapped into the box by the particle mesh, and
+  /// the position deltas `r[a, b]` are computed using the minimum image
+  /// convention.
+  ///
+  /// @note Particle mesh must be invalidated after the change.
+  constexpr void set_periodic_box(std::optional<PeriodicBox> box) noexcept {
+    periodic_box_ = std::move(box);
+  }
+
+  /// Periodic box of the particles, if any.
+  constexpr auto periodic_box() const noexcept
+      -> const std::optional<PeriodicBox>& {
+    return periodic_box_;
+  }
+
+  /// Wrap the field value delta between two particles. Position deltas are
+  /// taken using the minimum image convention, if the particles are
+  /// periodic, other deltas are returned as is.
+  template<field Field, class Delta>
+  constexpr auto wrap_delta(Field /*field*/, Delta delta) const noexcept
+      -> Delta {
+    if constexpr (std::same_as<Field, r_t>) {
+      if (periodic_box_) return periodic_box_->min_image(delta);
+    }
+    return delta;
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Number of particles.
   constexpr auto size() const noexcept -> size_t {
-    return std::get<0>(varying_data_).size();
+    return varying_data_.size();
+  }
+
+  /// Size of the varying particle fields (in bytes).
+  constexpr auto size_bytes() const noexcept -> size_t {
+    return varying_data_.size_bytes() + fluid_data_.size_bytes();
+  }
+
+  /// Memory allocated by the varying particle fields (in bytes), including
+  /// the unused capacity.
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return varying_data_.memory_usage() + fluid_data_.memory_usage();
   }
 
   /// Reserve amount of particles.
   constexpr void reserve(size_t capacity) {
-    std::apply([capacity](auto&... cols) { ((cols.reserve(capacity)), ...); },
-               varying_data_);
+    varying_data_.reserve(capacity);
   }
 
   /// Appends a new particle of the specified type @p type.
   constexpr auto append(ParticleType type) -> ParticleView<ParticleArray> {
+    return append_n(type, 1).front();
+  }
+
+  /// Append @p count new particles of the specified type @p type.
+  ///
+  /// Each of the following type ranges is shifted by moving at most @p count
+  /// of its first particles past its end, so the cost is proportional to the
+  /// number of the appended particles rather than to the number of all
+  /// particles. If the types are tagged, particles are appended at the end.
+  ///
+  /// If the particles have the persistent identifiers, see `id`, the new
+  /// particles get the fresh ones.
+  ///
+  /// @returns Range of the appended particles.
+  constexpr auto append_n(ParticleType type, size_t count) {
     TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
     const auto type_index = std::to_underlying(type);
-    // Get the index of the next particle of the specified type and increment
-    // the range of particles for the next types.
-    const size_t index = particle_ranges_[type_index + 1];
-    for (auto& p : particle_ranges_ | std::views::drop(type_index + 1)) p += 1;
-    // Insert the new particle.
-    std::apply(
-        [index](auto&... cols) { ((cols.emplace(cols.begin() + index)), ...); },
-        varying_data_);
-    return (*this)[index];
+    const size_t first =
+        tagged_types ? size() : particle_ranges_[type_index + 1];
+    varying_data_.resize(size() + count);
+    if constexpr (tagged_types) {
+      types_.resize(size(), type);
+    } else {
+      for (size_t t = particle_ranges_.size() - 1; t > type_index + 1; --t) {
+        const auto type_first = particle_ranges_[t - 1];
+        const auto type_last = particle_ranges_[t];
+        const auto num_moved = std::min(count, type_last - type_first);
+        for (size_t i = 0; i < num_moved; ++i) {
+          varying_data_.move(type_first + i,
+                             type_last + count - num_moved + i);
+        }
+      }
+    }
+    if constexpr (has_fluid_fields_) {
+      // Fluid range is the leading one, so the new fluid particles are at
+      // the end of it. New values are value-initialized.
+      if (type == ParticleType::fluid) {
+        fluid_data_.resize(fluid_data_.size() + count);
+      }
+    }
+    for (size_t index = first; index < first + count; ++index) {
+      shared_fields.for_each([index, this](auto field) {
+        varying_data_.value(index, field) = {};
+      });
+      if constexpr (varying_fields.contains(id)) {
+        varying_data_.value(index, id) = next_id_++;
+      }
+    }
+    if constexpr (tagged_types) {
+      // Appended particles have the largest indices, so the index list
+      // stays sorted.
+      auto& indices = type_indices_[type_index];
+      const auto appended = std::views::iota(first, first + count);
+      indices.insert(indices.end(), appended.begin(), appended.end());
+    } else {
+      // Increment the range of particles for the next types.
+      for (auto& p : particle_ranges_ | std::views::drop(type_index + 1)) {
+        p += count;
+      }
+    }
+    return std::views::iota(first, first + count) |
+           std::views::transform(
+               [this](size_t index) { return (*this)[index]; });
+  }
+
+  /// Remove the particles at the specified indices.
+  ///
+  /// Each removed particle is replaced with the last particle of its type,
+  /// and each of the following type ranges is shifted by moving its last
+  /// particle to the front, so the cost is proportional to the number of the
+  /// removed particles rather than to the number of all particles. If the
+  /// types are tagged, each removed particle is replaced with the last
+  /// particle, and the type index lists are rebuilt.
+  ///
+  /// @note Particle indices are changed, so the particle mesh must be
+  ///       invalidated after the removal.
+  template<index_range Indices>
+  void remove(Indices&& indices) {
+    TIT_PROFILE_SECTION("ParticleArray::remove()");
+    TIT_ASSUME_UNIVERSAL(Indices, indices);
+
+    // Remove the particles starting from the last one, so that the particles
+    // that are moved into the holes are never the ones to be removed.
+    static thread_local std::vector<size_t> sorted_indices{};
+    sorted_indices.assign(std::begin(indices), std::end(indices));
+    std::ranges::sort(sorted_indices, std::greater{});
+    TIT_ASSERT(std::ranges::adjacent_find(sorted_indices) ==
+                   sorted_indices.end(),
+               "Particle indices must be unique!");
+    if constexpr (tagged_types) {
+      for (const auto index : sorted_indices) {
+        TIT_ASSERT(index < size(), "Particle index is out of range.");
+        const auto last = size() - 1;
+        if (index != last) {
+          varying_data_.move(last, index);
+          types_[index] = types_[last];
+        }
+        varying_data_.resize(last);
+        types_.pop_back();
+      }
+      update_type_indices_();
+      return;
+    }
+    for (const auto index : sorted_indices) {
+      TIT_ASSERT(index < size(), "Particle index is out of range.");
+      const auto type_index =
+          std::ranges::upper_bound(particle_ranges_, index) -
+          particle_ranges_.begin() - 1;
+      if constexpr (has_fluid_fields_) {
+        // Last fluid particle takes the place of the removed one, as below.
+        if (type_index == std::to_underlying(ParticleType::fluid)) {
+          const auto last = fluid_data_.size() - 1;
+          if (index != last) fluid_data_.move(last, index);
+          fluid_data_.resize(last);
+        }
+      }
+      auto hole = index;
+      for (auto& p : particle_ranges_ | std::views::drop(type_index + 1)) {
+        p -= 1;
+        if (p != hole) varying_data_.move(p, hole);
+        hole = p;
+      }
+      varying_data_.resize(size() - 1);
+    }
+  }
+
+  /// Change the type of the particles at the specified indices.
+  ///
+  /// Particles are removed and then appended back with the new type, see
+  /// `remove` and `append_n`, so the cost is proportional to the number of
+  /// the particles being changed. If the types are tagged, particles stay
+  /// in place, only their tags are changed.
+  ///
+  /// @note Particle indices are changed, so the particle mesh must be
+  ///       invalidated after the change.
+  template<index_range Indices>
+  void retype(Indices&& indices, ParticleType type) {
+    TIT_PROFILE_SECTION("ParticleArray::retype()");
+    TIT_ASSUME_UNIVERSAL(Indices, indices);
+    TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
+    if constexpr (tagged_types) {
+      for (const size_t index : indices) {
+        TIT_ASSERT(index < size(), "Particle index is out of range.");
+        types_[index] = type;
+      }
+      update_type_indices_();
+      return;
+    }
+
+    // Save the particle values.
+    saved_indices_.assign(std::begin(indices), std::end(indices));
+    if (saved_indices_.empty()) return;
+    saved_data_.resize(saved_indices_.size());
+    for (size_t i = 0; i < saved_indices_.size(); ++i) {
+      saved_data_.copy(varying_data_, saved_indices_[i], i);
+    }
+    if constexpr (has_fluid_fields_) {
+      // Fluid-only values are kept only if the particles stay fluid, the
+      // particles that become fluid get the value-initialized ones.
+      saved_fluid_data_.resize(0);
+      saved_fluid_data_.resize(saved_indices_.size());
+      for (size_t i = 0; i < saved_indices_.size(); ++i) {
+        if (type == ParticleType::fluid && saved_indices_[i] < num_fluid_()) {
+          saved_fluid_data_.copy(fluid_data_, saved_indices_[i], i);
+        }
+      }
+    }
+
+    // Remove the particles and append them back. Particles keep their
+    // identifiers, so no fresh ones are consumed.
+    remove(saved_indices_);
+    const auto first = particle_ranges_[std::to_underlying(type) + 1];
+    const auto next_id = next_id_;
+    append_n(type, saved_indices_.size());
+    next_id_ = next_id;
+    for (size_t i = 0; i < saved_indices_.size(); ++i) {
+      varying_data_.copy(saved_data_, i, first + i);
+      if constexpr (has_fluid_fields_) {
+        if (type == ParticleType::fluid) {
+          fluid_data_.copy(saved_fluid_data_, i, first + i);
+        }
+      }
+    }
+  }
+
+  /// Reorder the particles according to the permutation.
+  ///
+  /// @param perm Permutation, such that the particle at index `i` after the
+  ///             reordering is the particle at index `perm[i]` before it.
+  ///             Particles must not be moved between the type ranges,
+  ///             unless the types are tagged.
+  template<index_range Perm>
+    requires std::ranges::sized_range<Perm>
+  void permute(Perm&& perm) {
+    TIT_PROFILE_SECTION("ParticleArray::permute()");
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    TIT_ASSERT(std::size(perm) == size(), "Permutation size mismatch!");
+    decltype(varying_data_) permuted_data{};
+    permuted_data.resize(size());
+    par::for_each(std::views::iota(size_t{0}, size()),
+                  [&perm, &permuted_data, this](size_t i) {
+                    const size_t index = std::ranges::begin(perm)[i];
+                    permuted_data.copy(varying_data_, index, i);
+                  });
+    varying_data_ = std::move(permuted_data);
+    if constexpr (has_fluid_fields_) {
+      decltype(fluid_data_) permuted_fluid_data{};
+      permuted_fluid_data.resize(fluid_data_.size());
+      par::for_each(std::views::iota(size_t{0}, fluid_data_.size()),
+                    [&perm, &permuted_fluid_data, this](size_t i) {
+                      const size_t index = std::ranges::begin(perm)[i];
+                      TIT_ASSERT(index < fluid_data_.size(),
+                                 "Particles must stay in their type range!");
+                      permuted_fluid_data.copy(fluid_data_, index, i);
+                    });
+      fluid_data_ = std::move(permuted_fluid_data);
+    }
+    if constexpr (tagged_types) {
+      std::vector<ParticleType> permuted_types(size());
+      par::for_each(std::views::iota(size_t{0}, size()),
+                    [&perm, &permuted_types, this](size_t i) {
+                      const size_t index = std::ranges::begin(perm)[i];
+                      permuted_types[i] = types_[index];
+                    });
+      types_ = std::move(permuted_types);
+      update_type_indices_();
+    }
+  }
+
+  /// Spatially sort the particles inside of each type range. If the types
+  /// are tagged, the whole array is sorted at once, so that the particles of
+  /// all the types follow the same order.
+  ///
+  /// @note Particle indices are changed, so the particle mesh must be
+  ///       invalidated after the sorting.
+  template<geom::sort_func SortFunc>
+    requires (varying_fields.contains(r))
+  void sort(const SortFunc& sort_func = {}) {
+    TIT_PROFILE_SECTION("ParticleArray::sort()");
+    static thread_local std::vector<size_t> perm{};
+    perm.resize(size());
+    const auto positions = (*this)[r];
+    if constexpr (tagged_types) {
+      sort_func(positions, std::span{perm});
+      permute(perm);
+      return;
+    }
+    for (const auto [first, last] : std::views::pairwise(particle_ranges_)) {
+      if (first == last) continue;
+      const auto type_perm = std::span{perm}.subspan(first, last - first);
+      sort_func(positions | std::views::drop(first) |
+                    std::views::take(last - first),
+                type_perm);
+      std::ranges::for_each(type_perm,
+                            [first](size_t& index) { index += first; });
+    }
+    permute(perm);
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -215,9 +739,15 @@ public:
   constexpr auto typed(this auto& self, ParticleType type) noexcept {
     TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
     const auto type_index = std::to_underlying(type);
-    return std::views::iota(self.particle_ranges_[type_index],
-                            self.particle_ranges_[type_index + 1]) |
-           std::views::transform([&self](size_t index) { return self[index]; });
+    const auto to_particle = [&self](size_t index) { return self[index]; };
+    if constexpr (tagged_types) {
+      return std::span<const size_t>{self.type_indices_[type_index]} |
+             std::views::transform(to_particle);
+    } else {
+      return std::views::iota(self.particle_ranges_[type_index],
+                              self.particle_ranges_[type_index + 1]) |
+             std::views::transform(to_particle);
+    }
   }
 
   /// Fluid particles.
@@ -230,15 +760,46 @@ public:
     return self.typed(ParticleType::fixed);
   }
 
+  /// Inlet particles.
+  constexpr auto inlet(this auto& self) noexcept {
+    return self.typed(ParticleType::inlet);
+  }
+
+  /// Outlet particles.
+  constexpr auto outlet(this auto& self) noexcept {
+    return self.typed(ParticleType::outlet);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Check if the particle has the specified type.
   constexpr auto has_type(size_t index, ParticleType type) const noexcept
       -> bool {
     TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
-    const auto type_index = std::to_underlying(type);
-    return particle_ranges_[type_index] <= index &&
-           index < particle_ranges_[type_index + 1];
+    if constexpr (tagged_types) {
+      TIT_ASSERT(index < size(), "Particle index is out of range.");
+      return types_[index] == type;
+    } else {
+      const auto type_index = std::to_underlying(type);
+      return particle_ranges_[type_index] <= index &&
+             index < particle_ranges_[type_index + 1];
+    }
+  }
+
+  /// Position of the particle among the particles of its type, i.e. in the
+  /// range, returned by `typed`.
+  constexpr auto type_rank(size_t index) const noexcept -> size_t {
+    TIT_ASSERT(index < size(), "Particle index is out of range.");
+    if constexpr (tagged_types) {
+      const auto& indices = type_indices_[std::to_underlying(types_[index])];
+      return static_cast<size_t>(std::ranges::lower_bound(indices, index) -
+                                 indices.begin());
+    } else {
+      const auto type_index =
+          std::ranges::upper_bound(particle_ranges_, index) -
+          particle_ranges_.begin() - 1;
+      return index - particle_ranges_[type_index];
+    }
   }
 
   /// Particle at index.
@@ -256,21 +817,32 @@ public:
     TIT_ASSERT(index < self.size(), "Particle index is out of range.");
     if constexpr (uniform_fields.contains(Field{})) {
       return std::get<uniform_fields.find(Field{})>(self.uniform_data_);
+    } else if constexpr (fluid_fields.contains(Field{})) {
+      TIT_ASSERT(index < self.fluid_data_.size(),
+                 "Field is stored for the fluid particles only.");
+      return impl::particle_field_ref<field_value_t<Field, Space>>(
+          self.fluid_data_.value(index, Field{}));
     } else if constexpr (varying_fields.contains(Field{})) {
-      return std::get<varying_fields.find(Field{})>(self.varying_data_)[index];
+      return impl::particle_field_ref<field_value_t<Field, Space>>(
+          self.varying_data_.value(index, Field{}));
     } else static_assert(false);
   }
 
-  /// Values for the specified field.
+  /// Values for the specified field. Values of the fluid-only fields are
+  /// provided for the fluid particles only, see `fluid_fields`.
+  ///
+  /// @note Varying field values are provided in the field storage type, and
+  ///       are contiguous only for the fields that are not stored in tiles.
   template<field Field>
   constexpr auto operator[](this auto& self, Field /*field*/) noexcept
       -> decltype(auto) {
     static_assert(fields.contains(Field{}));
     if constexpr (uniform_fields.contains(Field{})) {
       return std::get<uniform_fields.find(Field{})>(self.uniform_data_);
+    } else if constexpr (fluid_fields.contains(Field{})) {
+      return self.fluid_data_.values(Field{});
     } else if constexpr (varying_fields.contains(Field{})) {
-      return std::span{
-          std::get<varying_fields.find(Field{})>(self.varying_data_)};
+      return self.varying_data_.values(Field{});
     } else static_assert(false);
   }
 
@@ -278,16 +850,122 @@ public:
 
 private:
 
+  // Write the particle fields that are due into a data time step or its
+  // snapshot. Fields that are not selected are not even instantiated.
+  template<class TimeStep, field_set Fields>
+  void write_(TimeStep&& time_step,
+              const ParticleOutput<Fields>& output,
+              size_t step) const {
+    TIT_ASSUME_UNIVERSAL(TimeStep, time_step);
+    write_uniforms_(time_step, output, step);
+    auto&& varyings = time_step.varyings();
+    (shared_fields & (Fields{} | id_fields_)).for_each(
+        [&varyings, &output, step, this](auto field) {
+          if (!is_due_(output, field, step)) return;
+          const auto values = field[*this];
+          if (output.stride() == 1) {
+            varyings.create_array(field.field_name, values);
+          } else {
+            varyings.create_array(field.field_name,
+                                  std::views::stride(values, output.stride()));
+          }
+        });
+  }
+
+  // Write the particle fields that are due into a data time step or its
+  // snapshot, with the varying fields permuted. Permutation is expected to
+  // be already subsampled.
+  template<class TimeStep, field_set Fields>
+  void write_(TimeStep&& time_step,
+              const ParticleOutput<Fields>& output,
+              size_t step,
+              std::span<const size_t> perm) const {
+    TIT_ASSUME_UNIVERSAL(TimeStep, time_step);
+    write_uniforms_(time_step, output, step);
+    auto&& varyings = time_step.varyings();
+    (shared_fields & (Fields{} | id_fields_)).for_each(
+        [&varyings, &output, step, perm, this](auto field) {
+          if (!is_due_(output, field, step)) return;
+          varyings.create_array(field.field_name,
+                                permuted_view(field[*this], perm));
+        });
+  }
+
+  // Write the uniform particle fields that are due.
+  template<class TimeStep, field_set Fields>
+  void write_uniforms_(TimeStep& time_step,
+                       const ParticleOutput<Fields>& output,
+                       size_t step) const {
+    auto&& uniforms = time_step.uniforms();
+    (uniform_fields & Fields{}).for_each(
+        [&uniforms, &output, step, this](auto field) {
+          if (!output.is_due(field, step)) return;
+          uniforms.create_array(field.field_name, std::span{&field[*this], 1});
+        });
+  }
+
+  // Persistent identifiers are written alongside the other varying fields,
+  // even if they are not selected, so that the written particles can always
+  // be matched across the time steps, whatever the particle order is.
+  static constexpr meta::Set id_fields_{id};
+
+  // Check if the field is due on the step. Identifiers are due whenever
+  // anything is written.
+  template<field_set Fields, field Field>
+  static constexpr auto is_due_(const ParticleOutput<Fields>& output,
+                                Field field,
+                                size_t step) -> bool {
+    if constexpr (Fields{}.contains(Field{})) {
+      return output.is_due(field, step);
+    } else {
+      return output.is_any_due(step);
+    }
+  }
+
+  // Rebuild the index lists of the particle types from the type tags.
+  void update_type_indices_()
+    requires (tagged_types)
+  {
+    for (auto& indices : type_indices_) indices.clear();
+    for (size_t index = 0; index < size(); ++index) {
+      type_indices_[std::to_underlying(types_[index])].push_back(index);
+    }
+  }
+
+  // Number of the fluid particles, the fluid range is the leading one.
+  constexpr auto num_fluid_() const noexcept -> size_t
+    requires (!tagged_types)
+  {
+    return particle_ranges_[std::to_underlying(ParticleType::fluid) + 1];
+  }
+
+  // Are there any fluid-only fields?
+  static constexpr bool has_fluid_fields_ = fluid_fields != meta::Set{};
+
+  // Type ranges, used only if the types are not tagged.
   std::array<size_t, std::to_underlying(ParticleType::count) + 1>
       particle_ranges_{0};
 
+  // Type tags and the sorted index lists of the particles of each type, used
+  // only if the types are tagged.
+  std::vector<ParticleType> types_;
+  std::array<std::vector<size_t>, std::to_underlying(ParticleType::count)>
+      type_indices_;
+
+  uint64_t next_id_ = 0;
+
   decltype([]<class... Fields>(meta::Set<Fields...> /*fields*/) {
     return std::tuple<field_value_t<Fields, Space>...>{};
   }(uniform_fields)) uniform_data_;
 
-  decltype([]<class... Fields>(meta::Set<Fields...> /*fields*/) {
-    return std::tuple<std::vector<field_value_t<Fields, Space>>...>{};
-  }(varying_fields)) varying_data_;
+  ParticleStorage<Space, decltype(auto(shared_fields)), Layout> varying_data_;
+  ParticleStorage<Space, decltype(auto(fluid_fields)), Layout> fluid_data_;
+  std::optional<PeriodicBox> periodic_box_;
+
+  // Values of the particles being retyped, see `retype`.
+  std::vector<size_t> saved_indices_;
+  decltype(varying_data_) saved_data_;
+  decltype(fluid_data_) saved_fluid_data_;
 
 }; // class ParticleArray
 
@@ -295,7 +973,50 @@ template<class Space, class Equations>
 ParticleArray(Space, Equations) -> ParticleArray<
     Space,
     decltype(Equations::required_fields - Equations::modified_fields),
-    decltype(Equations::required_fields & Equations::modified_fields)>;
+    decltype(Equations::required_fields & Equations::modified_fields),
+    SoALayout,
+    RangedTypes,
+    impl::equations_fluid_fields_t<Equations>>;
+
+template<class Space, class Equations, class Layout>
+ParticleArray(Space, Equations, Layout) -> ParticleArray<
+    Space,
+    decltype(Equations::required_fields - Equations::modified_fields),
+    decltype(Equations::required_fields & Equations::modified_fields),
+    Layout,
+    RangedTypes,
+    impl::equations_fluid_fields_t<Equations>>;
+
+template<class Space, class Equations, class Layout, class Types>
+ParticleArray(Space, Equations, Layout, Types) -> ParticleArray<
+    Space,
+    decltype(Equations::required_fields - Equations::modified_fields),
+    decltype(Equations::required_fields & Equations::modified_fields),
+    Layout,
+    Types,
+    impl::equations_fluid_fields_t<Equations>>;
+
+/// Equations with the extra varying fields, e.g. the diagnostic fields:
+/// @code
+/// ParticleArray particles{Space<Real, Dim>{},
+///                         WithFields{equations, diagnostic_fields}};
+/// @endcode
+template<class Equations, field_set Fields>
+struct WithFields final {
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields = Equations::required_fields | Fields{};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields = Equations::modified_fields | Fields{};
+
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
+  /// Construct the equations with the extra fields.
+  constexpr WithFields(Equations /*equations*/, Fields /*fields*/) noexcept {}
+
+}; // struct WithFields
 
 /// Particle array type.
 ///
@@ -307,6 +1028,122 @@ concept particle_array =
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Particle array with the field columns resolved to raw pointers.
+///
+/// Bound array is created once before a pass over the particles, so that the
+/// field accesses in the loop body are plain indexed loads and stores through
+/// the pointers, instead of going through the storage containers. Distinct
+/// columns never overlap, so the pointers are restrict-qualified, which lets
+/// the compiler reorder and vectorize the accesses to different fields. Fields
+/// stored in tiles and uniform fields are accessed through the array.
+///
+/// Bound array must not outlive the particle array, and the particles must
+/// not be added, removed or reordered while it is in use.
+template<particle_array ParticleArray>
+class BoundParticleArray final {
+public:
+
+  /// Particle array type.
+  using Array = std::remove_const_t<ParticleArray>;
+
+  /// Particle space.
+  static constexpr space auto space = Array::space;
+
+  /// Subset of particle fields that are array-wise constants.
+  static constexpr field_set auto uniform_fields = Array::uniform_fields;
+
+  /// Subset of particle fields that are individual for each particle.
+  static constexpr field_set auto varying_fields = Array::varying_fields;
+
+  /// Set of particle fields that are present.
+  static constexpr field_set auto fields = Array::fields;
+
+  /// Subset of varying particle fields that are bound to raw pointers.
+  static constexpr field_set auto column_fields = Array::column_fields;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Bind the particle array.
+  constexpr explicit BoundParticleArray(ParticleArray& array) noexcept
+      : array_{&array}, size_{array.size()} {
+    column_fields.for_each([&array, this]<class Field>(Field field) {
+      std::get<column_fields.find(Field{})>(columns_) = std::data(array[field]);
+    });
+  }
+
+  /// Associated particle array.
+  constexpr auto array() const noexcept -> ParticleArray& {
+    return *array_;
+  }
+
+  /// Number of particles.
+  constexpr auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+  /// Check if the particle has the specified type.
+  constexpr auto has_type(size_t index, ParticleType type) const noexcept
+      -> bool {
+    return array_->has_type(index, type);
+  }
+
+  /// Wrap the field value delta between two particles, see
+  /// `ParticleArray::wrap_delta`.
+  template<field Field, class Delta>
+  constexpr auto wrap_delta(Field field, Delta delta) const noexcept -> Delta {
+    return array_->wrap_delta(field, std::move(delta));
+  }
+
+  /// Particle at index.
+  constexpr auto operator[](size_t index) const noexcept {
+    TIT_ASSERT(index < size_, "Particle index is out of range.");
+    return ParticleView{*this, index};
+  }
+
+  /// Particle field at index.
+  template<field Field>
+  constexpr auto operator[](size_t index, Field field) const noexcept
+      -> decltype(auto) {
+    static_assert(fields.contains(Field{}));
+    if constexpr (column_fields.contains(Field{})) {
+      TIT_ASSERT(index < size_, "Particle index is out of range.");
+      return impl::particle_field_ref<field_value_t<Field, Space_>>(
+          std::get<column_fields.find(Field{})>(columns_)[index]);
+    } else return (*array_)[index, field];
+  }
+
+  /// Prefetch the fields of the particle at index, e.g. the one that is
+  /// accessed a few iterations later by a pair loop. Only the fields that
+  /// are bound to the raw pointers are prefetched.
+  constexpr void prefetch(size_t index) const noexcept {
+    TIT_ASSERT(index < size_, "Particle index is out of range.");
+    std::apply(
+        [index](const auto&... columns) {
+          (TIT_PREFETCH(columns + index), ...);
+        },
+        columns_);
+  }
+
+private:
+
+  using Space_ = std::remove_const_t<decltype(space)>;
+
+  template<class Field>
+  using Column_ =
+      std::conditional_t<std::is_const_v<ParticleArray>,
+                         const field_storage_t<Field, Space_>,
+                         field_storage_t<Field, Space_>>* TIT_RESTRICT;
+
+  ParticleArray* array_;
+  size_t size_;
+  decltype([]<class... Fields>(meta::Set<Fields...> /*fields*/) {
+    return std::tuple<Column_<Fields>...>{};
+  }(column_fields)) columns_;
+
+}; // class BoundParticleArray
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 namespace impl {
 template<auto field, class P>
 struct particle_field_reference;
@@ -330,7 +1167,8 @@ using particle_field_reference_t =
 template<auto field, class P>
   requires particle_view<P, field> || particle_array<P, field>
 using particle_field_t =
-    std::remove_cvref_t<particle_field_reference_t<field, P>>;
+    field_value_t<decltype(field),
+                  std::remove_const_t<decltype(std::remove_cvref_t<P>::space)>>;
 
 /// Particle scalar type.
 template<class P>
@@ -367,4 +1205,81 @@ consteval auto has_uniform(field auto... uniforms) -> bool {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Snapshot of a subset of the varying particle fields.
+///
+/// @tparam Fields Fields to store. Fields that are not varying in the particle
+///                array are ignored.
+template<particle_array ParticleArray, field_set Fields>
+class ParticleSnapshot final {
+public:
+
+  /// Set of particle fields that are stored in the snapshot.
+  static constexpr field_set auto fields =
+      ParticleArray::shared_fields & Fields{};
+
+  /// Store the fields of the particles.
+  void store(const ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleSnapshot::store()");
+    fields.for_each([&particles, this](auto field) {
+      const auto values = field[particles];
+      auto& stored_values = column_(field);
+      stored_values.resize(values.size());
+      par::transform(values, stored_values.begin(), std::identity{});
+    });
+  }
+
+  /// Restore the fields of the particles that satisfy the predicate.
+  template<std::predicate<size_t> Pred = AlwaysTrue>
+  void restore(ParticleArray& particles, const Pred& pred = {}) const {
+    TIT_PROFILE_SECTION("ParticleSnapshot::restore()");
+    using PV = ParticleView<ParticleArray>;
+    par::for_each(particles.all(), [&pred, this](PV a) {
+      if (!pred(a.index())) return;
+      fields.for_each(
+          [a, this](auto field) { field[a] = column_(field)[a.index()]; });
+    });
+  }
+
+  /// Resize the snapshot to the number of particles and set all of the
+  /// snapshot values to zero, without storing the fields.
+  void reset(size_t size) {
+    fields.for_each(
+        [size, this](auto field) { column_(field).assign(size, {}); });
+  }
+
+  /// Memory allocated by the snapshot (in bytes), including the unused
+  /// capacity.
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return std::apply(
+        [](const auto&... cols) {
+          return ((cols.capacity() * sizeof(cols[0])) + ... + size_t{0});
+        },
+        data_);
+  }
+
+  /// Stored field value at index.
+  template<field Field>
+  constexpr auto operator[](this auto& self, size_t index, Field field) noexcept
+      -> auto& {
+    static_assert(fields.contains(Field{}));
+    TIT_ASSERT(index < self.column_(field).size(), "Index is out of range!");
+    return self.column_(field)[index];
+  }
+
+private:
+
+  template<field Field>
+  constexpr auto column_(this auto& self, Field /*field*/) noexcept -> auto& {
+    return std::get<fields.find(Field{})>(self.data_);
+  }
+
+  decltype([]<class... Fields_>(meta::Set<Fields_...> /*fields*/) {
+    return std::tuple<
+        std::vector<particle_field_t<Fields_{}, ParticleArray>>...>{};
+  }(fields)) data_;
+
+}; // class ParticleSnapshot
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::sph
@@ -0,0 +1,488 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <concepts>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/arrow.hpp"
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_output.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with a single varying field.
+using PositionEquations = EquationsStub<meta::Set{sph::r}>;
+
+// Layout that stores the positions in the tiles that are smaller than the
+// number of particles in the tests.
+using TiledLayout = sph::AoSoALayout<decltype(meta::Set{sph::r}), 4>;
+
+#define LAYOUT_TYPES TIT_PASS(sph::SoALayout, TiledLayout)
+
+// Particle identifiers, stored in the first position component.
+auto particle_ids(const auto& particles, sph::ParticleType type)
+    -> std::vector<double> {
+  auto ids = particles.typed(type) |
+             std::views::transform([](auto a) { return sph::r[a][0]; }) |
+             std::ranges::to<std::vector>();
+  std::ranges::sort(ids);
+  return ids;
+}
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::append_n", Layout, LAYOUT_TYPES) {
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               PositionEquations{},
+                               Layout{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 2)) {
+    sph::r[a] = Vec{10.0 + static_cast<double>(a.index()), 0.0};
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 3)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+  }
+  REQUIRE(particles.size() == 5);
+  CHECK(particles.fluid().size() == 3);
+  CHECK(particles.fixed().size() == 2);
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fluid),
+                 std::vector{0.0, 1.0, 2.0});
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fixed),
+                 std::vector{10.0, 11.0});
+}
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::remove", Layout, LAYOUT_TYPES) {
+  // Setup the particles: fluid ones are numbered from zero, fixed ones are
+  // numbered from ten.
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               PositionEquations{},
+                               Layout{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 5)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 3)) {
+    sph::r[a] = Vec{5.0 + static_cast<double>(a.index()), 0.0};
+  }
+  REQUIRE(particles.size() == 8);
+
+  // Remove some particles of both types. Remaining particles must keep their
+  // types and values.
+  particles.remove(std::vector<size_t>{3, 1, 6});
+  REQUIRE(particles.size() == 5);
+  CHECK(particles.fluid().size() == 3);
+  CHECK(particles.fixed().size() == 2);
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fluid),
+                 std::vector{0.0, 2.0, 4.0});
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fixed),
+                 std::vector{10.0, 12.0});
+
+  // Remove all the fluid particles.
+  particles.remove(particles.fluid() | std::views::transform([](auto a) {
+                     return a.index();
+                   }));
+  CHECK(particles.fluid().empty());
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fixed),
+                 std::vector{10.0, 12.0});
+}
+
+// Stub with the persistent particle identifiers.
+using IdentifierEquations = EquationsStub<meta::Set{sph::r, sph::id}>;
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::id", Layout, LAYOUT_TYPES) {
+  // Setup the particles, with the positions matching the identifiers.
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               IdentifierEquations{},
+                               Layout{}};
+  particles.append_n(sph::ParticleType::fluid, 5);
+  particles.append_n(sph::ParticleType::fixed, 3);
+  for (const auto a : particles.all()) {
+    CHECK(sph::id[a] == a.index());
+    sph::r[a] = Vec{static_cast<double>(sph::id[a]), 0.0};
+  }
+
+  // Reorder, remove and retype the particles. Identifiers must follow the
+  // particles, and the new particles must get the fresh ones.
+  particles.permute(std::vector<size_t>{4, 3, 2, 1, 0, 7, 6, 5});
+  particles.remove(std::vector<size_t>{0, 6});
+  particles.retype(std::vector<size_t>{0}, sph::ParticleType::fixed);
+  const auto a = particles.append(sph::ParticleType::fluid);
+  sph::r[a] = Vec{static_cast<double>(sph::id[a]), 0.0};
+  CHECK(sph::id[a] == 8);
+  for (const auto b : particles.all()) {
+    CHECK(sph::r[b][0] == static_cast<double>(sph::id[b]));
+  }
+
+  // Identifiers must be written even if they are not selected, so that the
+  // readers can restore the particle order.
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  particles.write(0.0, series, sph::ParticleOutput{meta::Set{sph::r}});
+  const auto step = series.last_time_step();
+  const auto ids = step.varyings().find_array("id");
+  REQUIRE(ids.has_value());
+  const auto id_values = ids->template data<uint64_t>();
+  REQUIRE(id_values.size() == particles.size());
+  CHECK_RANGE_EQ(permuted_view(id_values, sph::id_order(id_values)),
+                 std::vector<uint64_t>{0, 1, 2, 3, 5, 7, 8});
+}
+
+// Stub with a reduced precision varying field.
+using SoundSpeedEquations = EquationsStub<meta::Set{sph::r, cs}>;
+
+TEST_CASE("sph::ParticleArray::reduced_precision") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, SoundSpeedEquations{}};
+  const auto a = particles.append(sph::ParticleType::fluid);
+  const auto b = particles.append(sph::ParticleType::fluid);
+
+  // Values must be stored in the reduced precision.
+  static_assert(
+      std::same_as<decltype(particles[cs])::element_type, float32_t>);
+  cs[a] = 0.1;
+  cs[b] = 0.3;
+  CHECK(particles[cs][0] == 0.1F);
+  CHECK(particles[cs][1] == 0.3F);
+
+  // Values must be computed with the full precision.
+  static_assert(std::same_as<decltype(cs.avg(a, b)), float64_t>);
+  CHECK(cs.get(a, 0.0) == static_cast<float64_t>(0.1F));
+  CHECK(cs.avg(a, b) == (static_cast<float64_t>(0.1F) + 0.3F) / 2);
+  cs[a] += 1.0;
+  CHECK(particles[cs][0] == static_cast<float32_t>(0.1F + 1.0));
+  cs[b] = cs[a];
+  CHECK(particles[cs][1] == particles[cs][0]);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with a uniform and a varying field.
+using MassEquations = EquationsStub<meta::Set{sph::r, sph::m},
+                                    meta::Set{sph::r}>;
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::checkpoint", Layout, LAYOUT_TYPES) {
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               MassEquations{},
+                               Layout{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 7)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 1.0};
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 2)) {
+    sph::r[a] = Vec{10.0 + static_cast<double>(a.index()), 2.0};
+  }
+  sph::m[particles] = 0.5;
+
+  // Write the checkpoint.
+  std::vector<byte_t> bytes;
+  particles.checkpoint(*make_container_output_stream(bytes));
+  SUBCASE("success") {
+    // Restore the checkpoint into a particle array with different state.
+    decltype(particles) restored{sph::Space<double, 2>{},
+                                 MassEquations{},
+                                 Layout{}};
+    restored.append_n(sph::ParticleType::fixed, 3);
+    restored.restore(*make_range_input_stream(bytes));
+    REQUIRE(restored.size() == particles.size());
+    CHECK(restored.fluid().size() == 7);
+    CHECK(restored.fixed().size() == 2);
+    CHECK(sph::m[restored] == 0.5);
+    for (size_t i = 0; i < particles.size(); ++i) {
+      CHECK(sph::r[restored[i]][0] == sph::r[particles[i]][0]);
+      CHECK(sph::r[restored[i]][1] == sph::r[particles[i]][1]);
+    }
+  }
+  SUBCASE("truncated") {
+    bytes.resize(bytes.size() - 1);
+    CHECK_THROWS_MSG(particles.restore(*make_range_input_stream(bytes)),
+                     Exception,
+                     "Serialization failed: truncated stream!");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with a varying field for the fluid particles only.
+using ShiftEquations = EquationsStub<meta::Set{sph::r, sph::dr},
+                                     meta::Set{sph::r, sph::dr},
+                                     meta::Set{sph::dr}>;
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::fluid_fields", Layout, LAYOUT_TYPES) {
+  // Setup the particles: each fluid particle is shifted by its position.
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               ShiftEquations{},
+                               Layout{}};
+  using ParticleArray = decltype(particles);
+  STATIC_CHECK(ParticleArray::fluid_fields == meta::Set{sph::dr});
+  STATIC_CHECK(ParticleArray::shared_fields == meta::Set{sph::r});
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 3)) {
+    sph::r[a] = Vec{10.0 + static_cast<double>(a.index()), 0.0};
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 5)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+    sph::dr[a] = sph::r[a];
+  }
+  REQUIRE(particles.size() == 8);
+
+  // Shifts must follow the fluid particles.
+  const auto check_shifts = [&particles] {
+    REQUIRE(std::ranges::size(sph::dr[particles]) == particles.fluid().size());
+    for (const auto a : particles.fluid()) {
+      CHECK(sph::dr[a][0] == sph::r[a][0]);
+    }
+  };
+  check_shifts();
+
+  // Shifts are not stored for the fixed particles.
+  CHECK(particles.size_bytes() == (8 + 5) * sizeof(Vec<double, 2>));
+
+  SUBCASE("remove") {
+    particles.remove(std::vector<size_t>{1, 6});
+    REQUIRE(particles.fluid().size() == 4);
+    check_shifts();
+    CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fluid),
+                   std::vector{0.0, 2.0, 3.0, 4.0});
+  }
+  SUBCASE("retype") {
+    // Fluid particle keeps its shift, fixed particle gets a zero one.
+    particles.retype(std::vector<size_t>{0, 5}, sph::ParticleType::fluid);
+    REQUIRE(particles.fluid().size() == 6);
+    REQUIRE(std::ranges::size(sph::dr[particles]) == 6);
+    for (const auto a : particles.fluid()) {
+      if (sph::r[a][0] < 10.0) CHECK(sph::dr[a][0] == sph::r[a][0]);
+      else CHECK(sph::dr[a][0] == 0.0);
+    }
+  }
+  SUBCASE("permute") {
+    particles.permute(std::vector<size_t>{4, 3, 2, 1, 0, 5, 7, 6});
+    check_shifts();
+  }
+  SUBCASE("checkpoint") {
+    std::vector<byte_t> bytes;
+    particles.checkpoint(*make_container_output_stream(bytes));
+    ParticleArray restored{sph::Space<double, 2>{},
+                           ShiftEquations{},
+                           Layout{}};
+    restored.restore(*make_range_input_stream(bytes));
+    REQUIRE(restored.fluid().size() == 5);
+    for (const auto a : restored.fluid()) {
+      CHECK(sph::dr[a][0] == sph::r[a][0]);
+    }
+  }
+}
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::arrow_batch", Layout, LAYOUT_TYPES) {
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               ShiftEquations{},
+                               Layout{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 5)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 1.0};
+  }
+
+  // Fluid-only shifts are skipped, positions are exported as the lists.
+  const auto batch = particles.arrow_batch();
+  REQUIRE(batch.num_rows() == 5);
+  REQUIRE(batch.num_columns() == 1);
+  ArrowSchema schema{};
+  batch.export_schema(schema);
+  CHECK(std::string_view{schema.children[0]->name} == "r");
+  CHECK(std::string_view{schema.children[0]->format} == "+w:2");
+  schema.release(&schema);
+  ArrowArray array{};
+  batch.export_array(array);
+  const auto& r_values = *array.children[0]->children[0];
+  REQUIRE(r_values.length == 10);
+  const auto* const r = static_cast<const double*>(r_values.buffers[1]);
+  for (size_t i = 0; i < 5; ++i) {
+    CHECK(r[2 * i] == static_cast<double>(i));
+    CHECK(r[(2 * i) + 1] == 1.0);
+  }
+  array.release(&array);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sph::ParticleArray::TaggedTypes", Layout, LAYOUT_TYPES) {
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               PositionEquations{},
+                               Layout{},
+                               sph::TaggedTypes{}};
+  static_assert(decltype(particles)::tagged_types);
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 2)) {
+    sph::r[a] = Vec{10.0 + static_cast<double>(a.index()), 0.0};
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 3)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 1)) {
+    sph::r[a] = Vec{10.0 + static_cast<double>(a.index()), 0.0};
+  }
+
+  // Particles must be interleaved in the order they were appended.
+  REQUIRE(particles.size() == 6);
+  CHECK(particles[1].is_fixed());
+  CHECK(particles[2].is_fluid());
+  CHECK(particles[5].is_fixed());
+  CHECK(particles.fluid().size() == 3);
+  CHECK(particles.fixed().size() == 3);
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fluid),
+                 std::vector{2.0, 3.0, 4.0});
+  CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fixed),
+                 std::vector{10.0, 11.0, 15.0});
+  CHECK(particles.type_rank(4) == 2);
+  CHECK(particles.type_rank(5) == 2);
+
+  SUBCASE("remove") {
+    // Removed particles must be replaced with the last ones.
+    particles.remove(std::vector<size_t>{1, 3});
+    REQUIRE(particles.size() == 4);
+    CHECK(sph::r[particles[1]][0] == 4.0);
+    CHECK(sph::r[particles[3]][0] == 15.0);
+    CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fluid),
+                   std::vector{2.0, 4.0});
+    CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fixed),
+                   std::vector{10.0, 15.0});
+  }
+  SUBCASE("retype") {
+    // Retyped particles must stay in place.
+    particles.retype(std::vector<size_t>{0, 5}, sph::ParticleType::fluid);
+    CHECK(sph::r[particles[0]][0] == 10.0);
+    CHECK(particles[0].is_fluid());
+    CHECK(particles.fluid().size() == 5);
+    CHECK(particles.type_rank(5) == 4);
+    CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fixed),
+                   std::vector{11.0});
+  }
+  SUBCASE("permute") {
+    // Particles may be moved across the types.
+    particles.permute(std::vector<size_t>{5, 4, 3, 2, 1, 0});
+    CHECK(particles[0].is_fixed());
+    CHECK(particles[1].is_fluid());
+    CHECK(sph::r[particles[0]][0] == 15.0);
+    CHECK(particles.type_rank(0) == 0);
+    CHECK_RANGE_EQ(particle_ids(particles, sph::ParticleType::fluid),
+                   std::vector{2.0, 3.0, 4.0});
+  }
+  SUBCASE("checkpoint") {
+    std::vector<byte_t> bytes;
+    particles.checkpoint(*make_container_output_stream(bytes));
+    decltype(particles) restored{sph::Space<double, 2>{},
+                                 PositionEquations{},
+                                 Layout{},
+                                 sph::TaggedTypes{}};
+    restored.restore(*make_range_input_stream(bytes));
+    REQUIRE(restored.size() == particles.size());
+    for (size_t i = 0; i < particles.size(); ++i) {
+      CHECK(restored[i].is_fluid() == particles[i].is_fluid());
+      CHECK(sph::r[restored[i]][0] == sph::r[particles[i]][0]);
+    }
+    CHECK(restored.fixed().size() == 3);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sph::BoundParticleArray", Layout, LAYOUT_TYPES) {
+  sph::ParticleArray particles{sph::Space<double, 2>{},
+                               MassEquations{},
+                               Layout{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 5)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 1.0};
+  }
+  sph::m[particles] = 0.5;
+
+  // Bound views must access the same values as the regular ones.
+  const sph::BoundParticleArray bound{particles};
+  REQUIRE(bound.size() == particles.size());
+  for (size_t i = 0; i < particles.size(); ++i) {
+    const auto a = bound[i];
+    CHECK(a.is_fluid());
+    CHECK(sph::m[a] == 0.5);
+    CHECK(sph::r[a][0] == static_cast<double>(i));
+    sph::r[a] += Vec{0.0, 1.0};
+  }
+  for (const auto a : particles.all()) CHECK(sph::r[a][1] == 2.0);
+}
+
+TEST_CASE("sph::BoundParticleArray::reduced_precision") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, SoundSpeedEquations{}};
+  particles.append_n(sph::ParticleType::fluid, 2);
+
+  // Values must be stored in the reduced precision, and computed with the
+  // full precision, same as through the particle array.
+  const sph::BoundParticleArray bound{particles};
+  const auto a = bound[0];
+  const auto b = bound[1];
+  cs[a] = 0.1;
+  cs[b] = 0.3;
+  CHECK(particles[cs][0] == 0.1F);
+  CHECK(particles[cs][1] == 0.3F);
+  static_assert(std::same_as<decltype(cs.avg(a, b)), float64_t>);
+  CHECK(cs.avg(a, b) == (static_cast<float64_t>(0.1F) + 0.3F) / 2);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with a uniform and two varying fields.
+using MotionEquations = EquationsStub<meta::Set{sph::r, sph::v, sph::m},
+                                      meta::Set{sph::r, sph::v}>;
+
+TEST_CASE("sph::ParticleArray::write") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MotionEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 5)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+  }
+  sph::m[particles] = 0.5;
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  const auto output = sph::ParticleOutput{meta::Set{sph::r, sph::m}}
+                          .set_interval(sph::m, 2)
+                          .set_stride(2);
+  SUBCASE("all fields") {
+    particles.write(0.0, series);
+    const auto step = series.last_time_step();
+    CHECK(step.uniforms().num_arrays() == 1);
+    CHECK(step.varyings().num_arrays() == 2);
+  }
+  SUBCASE("selected fields") {
+    particles.write(0.0, series, output, /*step=*/0);
+    const auto step = series.last_time_step();
+    CHECK(step.uniforms().find_array("m").has_value());
+    CHECK_FALSE(step.varyings().find_array("v").has_value());
+    const auto positions = step.varyings().find_array("r");
+    REQUIRE(positions.has_value());
+    const auto values = positions->template data<Vec<double, 2>>();
+    REQUIRE(values.size() == 3);
+    CHECK(values[0][0] == 0.0);
+    CHECK(values[1][0] == 2.0);
+    CHECK(values[2][0] == 4.0);
+  }
+  SUBCASE("field intervals") {
+    particles.write(0.0, series, output, /*step=*/1);
+    const auto step = series.last_time_step();
+    CHECK(output.is_any_due(1));
+    CHECK_FALSE(output.is_due(sph::m, 1));
+    CHECK(step.uniforms().num_arrays() == 0);
+    CHECK(step.varyings().num_arrays() == 1);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
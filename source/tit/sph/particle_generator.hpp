@@ -0,0 +1,130 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Append the particles at the nodes of the lattice that fills the box.
+///
+/// Lattice nodes are the centers of the cells with the given spacing, the box
+/// is covered by `round(extents / spacing)` cells along each axis. Only the
+/// nodes that satisfy the predicate are appended, for example, passing
+/// `[&sdf](const auto& x) { return sdf(x) < 0; }` fills the shape defined by
+/// the signed distance field. Nodes are generated and filtered in parallel,
+/// and the particles are appended in a single batch, in the lattice order.
+///
+/// @returns Range of the appended particles.
+template<particle_array ParticleArray, class Pred>
+  requires std::predicate<Pred&, const particle_vec_t<ParticleArray>&>
+auto append_lattice(ParticleArray& particles,
+                    ParticleType type,
+                    const geom::BBox<particle_vec_t<ParticleArray>>& box,
+                    particle_num_t<ParticleArray> spacing,
+                    Pred pred) {
+  TIT_PROFILE_SECTION("append_lattice()");
+  using Vec = particle_vec_t<ParticleArray>;
+  constexpr auto Dim = particle_dim_v<ParticleArray>;
+  TIT_ASSERT(spacing > 0, "Lattice spacing must be positive!");
+
+  // Compute the lattice size.
+  const auto num_nodes =
+      vec_cast<size_t>(maximum(round(box.extents() / spacing), Vec(0)));
+  size_t flat_num_nodes = 1;
+  for (size_t i = 0; i < Dim; ++i) flat_num_nodes *= num_nodes[i];
+  const auto node = [&box, &num_nodes, spacing](size_t flat_index) {
+    auto point = box.low();
+    for (size_t i = Dim; i-- > 0; flat_index /= num_nodes[i]) {
+      point[i] += spacing * (static_cast<vec_num_t<Vec>>(
+                                 flat_index % num_nodes[i]) +
+                             vec_num_t<Vec>{0.5});
+    }
+    return point;
+  };
+
+  // Select the nodes that satisfy the predicate.
+  std::vector<size_t> nodes(flat_num_nodes);
+  const auto last = par::copy_if(std::views::iota(size_t{0}, flat_num_nodes),
+                                 nodes.begin(),
+                                 [&node, &pred](size_t flat_index) {
+                                   return pred(node(flat_index));
+                                 });
+  nodes.erase(last, nodes.end());
+
+  // Append the particles and place them at the selected nodes.
+  const auto appended = particles.append_n(type, nodes.size());
+  par::for_each(std::views::iota(size_t{0}, nodes.size()),
+                [&appended, &nodes, &node](size_t i) {
+                  r[appended[i]] = node(nodes[i]);
+                });
+  return appended;
+}
+
+/// Append the particles at the nodes of the lattice that fills the box.
+template<particle_array ParticleArray>
+auto append_lattice(ParticleArray& particles,
+                    ParticleType type,
+                    const geom::BBox<particle_vec_t<ParticleArray>>& box,
+                    particle_num_t<ParticleArray> spacing) {
+  return append_lattice(particles, type, box, spacing, [](const auto& /*x*/) {
+    return true;
+  });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Relax the fluid particle positions before the simulation.
+///
+/// Lattice fills leave the particles near the free surface and the walls in
+/// the unbalanced arrangement, that produces the spurious pressure waves on
+/// the first steps. On each iteration, the particle shifts are computed by
+/// the equations and applied to the fluid particles, while the velocities
+/// are kept intact.
+///
+/// @param num_iters Number of the relaxation iterations.
+template<class Equations,
+         particle_mesh ParticleMesh,
+         particle_array<Equations::required_fields> ParticleArray>
+  requires (ParticleArray::fields.contains(dr))
+void relax_particles(const Equations& equations,
+                     ParticleMesh& mesh,
+                     ParticleArray& particles,
+                     size_t num_iters) {
+  TIT_PROFILE_SECTION("relax_particles()");
+  using PV = ParticleView<ParticleArray>;
+  for (size_t iter = 0; iter < num_iters; ++iter) {
+    equations.index(mesh, particles);
+    equations.cache_pairs(mesh, particles);
+    equations.setup_boundary(mesh, particles);
+    equations.compute_density(mesh, particles);
+    equations.compute_shifts(mesh, particles);
+    par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
+  }
+  mesh.invalidate();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
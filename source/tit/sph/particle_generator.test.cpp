@@ -0,0 +1,80 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_generator.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with a single varying field.
+using PositionEquations = EquationsStub<meta::Set{sph::r}>;
+
+TEST_CASE("sph::append_lattice") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, PositionEquations{}};
+  const auto positions = [&particles](sph::ParticleType type) {
+    return particles.typed(type) |
+           std::views::transform([](auto a) { return sph::r[a]; }) |
+           std::ranges::to<std::vector>();
+  };
+  const auto eq = [](const auto& a, const auto& b) { return all(a == b); };
+  SUBCASE("box") {
+    // Ensure the box is filled with the cell centers, in the lattice order.
+    const auto appended =
+        sph::append_lattice(particles,
+                            sph::ParticleType::fluid,
+                            geom::BBox{Vec{0.0, 0.0}, Vec{1.5, 1.0}},
+                            0.5);
+    CHECK(appended.size() == 6);
+    CHECK_RANGE_EQ(positions(sph::ParticleType::fluid),
+                   std::vector{Vec{0.25, 0.25},
+                               Vec{0.25, 0.75},
+                               Vec{0.75, 0.25},
+                               Vec{0.75, 0.75},
+                               Vec{1.25, 0.25},
+                               Vec{1.25, 0.75}},
+                   eq);
+  }
+  SUBCASE("shape") {
+    // Ensure only the nodes inside of the shape are appended, and the
+    // particles of the other types are kept.
+    const auto a = particles.append(sph::ParticleType::fixed);
+    sph::r[a] = Vec{5.0, 5.0};
+    const auto appended = sph::append_lattice(
+        particles,
+        sph::ParticleType::fluid,
+        geom::BBox{Vec{-1.0, -1.0}, Vec{1.0, 1.0}},
+        0.1,
+        [](const Vec<double, 2>& x) { return norm(x) < 1.0; });
+    CHECK(appended.size() == 316);
+    for (const auto& x : positions(sph::ParticleType::fluid)) {
+      CHECK(norm(x) < 1.0);
+    }
+    CHECK_RANGE_EQ(positions(sph::ParticleType::fixed),
+                   std::vector{Vec{5.0, 5.0}},
+                   eq);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -6,33 +6,52 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <exception>
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <ranges>
+#include <span>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/containers/mdvector.hpp"
 #include "tit/core/containers/multivector.hpp"
 #include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/metrics.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/atomic.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/par/memory_pool.hpp"
 #include "tit/core/par/task_group.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/rand_utils.hpp"
 #include "tit/core/stats.hpp"
 #include "tit/core/type_utils.hpp"
+#include "tit/core/uint_utils.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
 #include "tit/geom/partition.hpp"
+#include "tit/geom/point_range.hpp"
 #include "tit/geom/search.hpp"
 
+#include "tit/graph/cuthill_mckee_ordering.hpp"
 #include "tit/graph/graph.hpp"
 
+#include "tit/sph/block_schedule.hpp"
 #include "tit/sph/field.hpp"
 #include "tit/sph/particle_array.hpp"
 
@@ -40,14 +59,19 @@ namespace tit::sph {
 
 /// @todo Move it to an appropriate place!
 constexpr auto RADIUS_SCALE = 3;
-inline constexpr auto Domain = geom::BBox{Vec{0.0, 0.0}, Vec{3.2196, 1.5}};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Particle adjacency graph.
+///
+/// Adjacency and block pairs store the particle indices as `Index`. Use
+/// `uint32_t` to halve the memory footprint and bandwidth of the pair passes
+/// if the number of particles is below 2³².
 template<geom::search_func SearchFunc = geom::GridSearch,
          geom::partition_func PartitionFunc = geom::RecursiveInertialBisection,
-         geom::partition_func InterfacePartitionFunc = PartitionFunc>
+         geom::partition_func InterfacePartitionFunc = PartitionFunc,
+         block_schedule BlockSchedule = LevelSchedule,
+         std::unsigned_integral Index = size_t>
 class ParticleMesh final {
 public:
 
@@ -58,30 +82,56 @@ public:
   /// @param search_indexing_func Nearest-neighbors search indexing function.
   /// @param partition_func Geometry partitioning function.
   /// @param interface_partition_func Interface partitioning function.
+  /// @param skin Verlet skin width. If positive, the neighbors are searched
+  ///             within the search radius extended by the skin width, and
+  ///             the mesh is rebuilt only when the skin is exhausted.
+  /// @param block_schedule Schedule of the block pairs processing.
   constexpr explicit ParticleMesh(
       SearchFunc search_func = {},
       PartitionFunc partition_func = {},
-      InterfacePartitionFunc interface_partition_func = {}) noexcept
+      InterfacePartitionFunc interface_partition_func = {},
+      float64_t skin = 0.0,
+      BlockSchedule block_schedule = {}) noexcept
       : search_func_{std::move(search_func)},
         partition_func_{std::move(partition_func)},
-        interface_partition_func_{std::move(interface_partition_func)} {}
+        interface_partition_func_{std::move(interface_partition_func)},
+        skin_{skin}, block_schedule_{std::move(block_schedule)} {
+    TIT_ASSERT(skin_ >= 0.0, "Skin width must be non-negative!");
+  }
+
+  /// Verlet skin width.
+  constexpr auto skin() const noexcept -> float64_t {
+    return skin_;
+  }
+
+  /// Schedule of the block pairs processing.
+  constexpr auto block_schedule() const noexcept -> const BlockSchedule& {
+    return block_schedule_;
+  }
 
   /// Adjacent particles.
   template<particle_view PV>
   constexpr auto operator[](PV a) const noexcept {
+    TIT_ASSERT(!listless_, "Adjacency is not stored in the listless mode!");
     auto& particles = a.array();
     return adjacency_[a.index()] |
            std::views::transform(
                [&particles](size_t b) { return particles[b]; });
   }
 
+  /// Particle adjacency graph, with the rows sorted by the particle index.
+  constexpr auto adjacency() const noexcept -> const graph::BasicGraph<Index>& {
+    TIT_ASSERT(!listless_, "Adjacency is not stored in the listless mode!");
+    return adjacency_;
+  }
+
   /// Particles used for interpolation for the fixed particles.
   template<particle_view PV>
   constexpr auto fixed_interp(PV a) const noexcept {
     TIT_ASSERT(a.has_type(ParticleType::fixed),
                "Particle must be of the fixed type!");
     auto& particles = a.array();
-    const size_t i = a - *particles.fixed().begin();
+    const size_t i = particles.type_rank(a.index());
     return interp_adjacency_[i] | //
            std::views::transform(
                [&particles](size_t b) { return particles[b]; });
@@ -90,127 +140,1642 @@ public:
   /// Unique pairs of the adjacent particles.
   template<particle_array ParticleArray>
   constexpr auto pairs(ParticleArray& particles) const noexcept {
+    TIT_ASSERT(!listless_, "Adjacency is not stored in the listless mode!");
     return adjacency_.edges() | std::views::transform([&particles](auto ab) {
              const auto [a, b] = ab;
              return std::pair{particles[a], particles[b]};
            });
   }
 
-  /// Unique pairs of the adjacent particles partitioned by the block.
+  /// Block edge, a pair of the adjacent particle indices.
+  using Edge = std::pair<Index, Index>;
+
+  /// Unique pairs of the adjacent particle indices partitioned by the block.
+  /// Each block is a contiguous span of edges, so that the pair loops are
+  /// plain indexed loops over the edge storage.
+  ///
+  /// If the pairs are pruned, only the pairs within the search radius at the
+  /// current positions are returned. If the mesh is restricted to the active
+  /// particles, only the pairs with at least one active particle are
+  /// returned.
+  constexpr auto block_edges() const noexcept {
+    TIT_ASSERT(!listless_, "Block pairs are not stored in the listless mode!");
+    return current_block_edges_().buckets();
+  }
+
+  /// Number of the unique pairs of the adjacent particles, see
+  /// `block_edges`. Zero in the listless mode.
+  constexpr auto num_pairs() const noexcept -> size_t {
+    if (listless_) return 0;
+    return total_size_(current_block_edges_());
+  }
+
+  /// Unique pairs of the adjacent particles partitioned by the block, along
+  /// with the cached kernel values and gradients.
+  ///
+  /// Pair cache must be valid.
   template<particle_array ParticleArray>
-  constexpr auto block_pairs(ParticleArray& particles) const noexcept {
-    return block_edges_.buckets() |
-           std::views::transform([&particles](auto block) {
-             return block | std::views::transform([&particles](auto ab) {
-                      const auto [a, b] = ab;
-                      /// @todo I have zero idea why, but using pair here
-                      /// instead of a tuple causes a massive performance hit.
-                      return std::tuple{particles[a], particles[b]};
-                    });
+  constexpr auto cached_block_pairs(ParticleArray& particles) const noexcept {
+    TIT_ASSERT(pairs_cached(), "Pair cache is not valid!");
+    return pass_block_edges_().buckets() |
+           std::views::transform([this, &particles](auto block) {
+             return block | std::views::transform(
+                                [this, &particles](const auto& ab) {
+                                  return cached_pair_(particles, ab);
+                                });
            });
   }
 
+  /// Restrict the block pairs to the ones with at least one active particle.
+  template<std::predicate<size_t> ActivePred>
+  void activate(const ActivePred& is_active) {
+    TIT_PROFILE_SECTION("ParticleMesh::activate()");
+    filter_block_edges_(pass_block_edges_(),
+                        active_block_edges_,
+                        [&is_active](const Edge& ab) {
+                          const auto [a, b] = ab;
+                          return is_active(a) || is_active(b);
+                        });
+    active_ = true;
+  }
+
+  /// Remove the active particles restriction.
+  constexpr void activate_all() noexcept {
+    active_ = false;
+  }
+
+  /// Particles grouped by the last block of the block pairs that touches
+  /// them, one group per block. Particles that are touched by no block are
+  /// assigned to the first one. Once the blocks are processed up to and
+  /// including the group's one in the index order, the particles of the
+  /// group are never touched again, see `LevelSchedule::for_each_epilogue`.
+  ///
+  /// Groups are assembled for the unpruned block pairs on the first call
+  /// after the rebuild, so they remain valid for the pruned and activated
+  /// block pairs.
+  auto final_blocks() {
+    TIT_ASSERT(!listless_, "Block pairs are not stored in the listless mode!");
+    if (!final_blocks_valid_) build_final_blocks_();
+    return final_blocks_.buckets();
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the pair pruning. Block pairs are found within the
+  /// search radius extended by the skin width and kept until the next
+  /// rebuild, while the particles move. Pruning drops the pairs that are
+  /// currently out of the search radius, so that the pair passes do not
+  /// evaluate the kernel only to get zero. Full block pairs are kept, since
+  /// the pruned pairs may come back into the search radius before the next
+  /// rebuild.
+  void enable_pruning(bool enabled = true) {
+    TIT_ASSERT(!enabled || !listless_,
+               "Pruning is not available in the listless mode!");
+    pruning_enabled_ = enabled;
+    if (!enabled) pruned_ = false, pruned_block_edges_ = {};
+  }
+
+  /// Is the pair pruning enabled?
+  constexpr auto pruning_enabled() const noexcept -> bool {
+    return pruning_enabled_;
+  }
+
+  /// Restrict the block pairs to the ones within the search radius of either
+  /// of the particles at the current positions. This must be called every
+  /// time the particle positions change, before the pairs are cached.
+  ///
+  /// @param radius_func Search radius function, without the skin width.
+  template<particle_array ParticleArray, class SearchRadiusFunc>
+  void prune(ParticleArray& particles, const SearchRadiusFunc& radius_func) {
+    TIT_PROFILE_SECTION("ParticleMesh::prune()");
+    TIT_ASSERT(pruning_enabled_, "Pruning is not enabled!");
+    TIT_ASSERT(valid_, "Mesh must be up to date!");
+    pairs_cached_ = false;
+    filter_block_edges_(
+        block_edges_,
+        pruned_block_edges_,
+        [&particles, &radius_func](const Edge& ab) {
+          const auto a = particles[ab.first];
+          const auto b = particles[ab.second];
+          const auto search_radius = std::max(radius_func(a), radius_func(b));
+          return norm2(r[a, b]) <= pow2(search_radius);
+        });
+    pruned_ = true;
+    TIT_STATS("ParticleMesh::num_pruned",
+              total_size_(block_edges_) - total_size_(pruned_block_edges_));
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the culling of the inactive fixed particles. Fixed
+  /// particle is inactive if there are no fluid particles within
+  /// `RADIUS_SCALE` search radii of it, e.g. in the inner wall layers.
+  /// Inactive particles are detected on each rebuild, and they are excluded
+  /// from the adjacency graph, the block pairs and the interpolation point
+  /// search, so that their fields are not updated.
+  void enable_culling(bool enabled = true) {
+    TIT_ASSERT(!enabled || !listless_,
+               "Culling is not available in the listless mode!");
+    culling_enabled_ = enabled;
+    invalidate();
+    if (!enabled) culled_ = {}, num_culled_ = 0;
+  }
+
+  /// Is the culling of the inactive fixed particles enabled?
+  constexpr auto culling_enabled() const noexcept -> bool {
+    return culling_enabled_;
+  }
+
+  /// Check if the particle was culled by the last rebuild.
+  template<particle_view PV>
+  constexpr auto culled(PV a) const noexcept -> bool {
+    return is_culled_(a.index());
+  }
+
+  /// Number of the particles culled by the last rebuild.
+  constexpr auto num_culled() const noexcept -> size_t {
+    return num_culled_;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Set the halo exchange.
+  ///
+  /// Halo particles are excluded from the interior blocks, so that the pairs
+  /// with the halo particles are processed only in the interface blocks. The
+  /// exchange task is run concurrently with the interior blocks of each pair
+  /// pass, and the interface blocks are processed after it is completed.
+  ///
+  /// @param is_halo  Predicate that checks if the particle is a halo particle,
+  ///                 e.g. a ghost particle owned by the other domain.
+  /// @param exchange Task that updates the halo particles.
+  void set_halo_exchange(std::function<bool(size_t)> is_halo,
+                         std::function<void()> exchange) {
+    is_halo_ = std::move(is_halo);
+    halo_exchange_ = std::move(exchange);
+    invalidate();
+  }
+
+  /// Halo exchange task, empty if not set.
+  constexpr auto halo_exchange() const noexcept
+      -> const std::function<void()>& {
+    return halo_exchange_;
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Update the adjacency graph.
+  ///
+  /// If the Verlet skin is enabled, the update is skipped until the particles
+  /// have moved far enough from the positions at the last rebuild. In the
+  /// listless mode, only the search index is updated, and this must be done
+  /// every time the particle positions change.
+  ///
+  /// @param radius_func Search radius function.
+  /// @param ghost_func  Ghost point function for the fixed particles. Field
+  ///                    values of the fixed particles are interpolated from
+  ///                    the fluid particles near their ghost points.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           class GhostFunc>
+  void update(ParticleArray& particles,
+              const SearchRadiusFunc& radius_func,
+              const GhostFunc& ghost_func) {
+    TIT_PROFILE_SECTION("ParticleMesh::update()");
+
+    // Release the temporaries of the previous update.
+    arena_.reset();
+
+    // Update the search index only, if the adjacency is not stored.
+    if (listless_) {
+      wrap_positions_(particles);
+      search_(particles, radius_func, ghost_func);
+      valid_ = true;
+      num_rebuilds_ += 1;
+      track_memory_(particles);
+      return;
+    }
+
+    // Check if the adjacency graphs are still valid.
+    if (!needs_rebuild_(particles)) return;
+    const StatsThroughput throughput{
+        "ParticleMesh::update()",
+        {{"particles", particles.size()}, {"bytes", particles.size_bytes()}}};
+
+    // Align the particles by the previous partitioning, if necessary.
+    if (aligned_layout_enabled_ && last_num_level_parts_ != 0) {
+      align_(particles);
+    }
+
+    // Update the adjacency graphs. Unless the particles are weighted by
+    // their neighbor counts, the first level partitioning depends only on
+    // the particle positions, so it runs concurrently with the search.
+    pruned_ = false;
+    wrap_positions_(particles);
+    const auto incremental = max_incremental_imbalance_ >= 1.0 &&
+                             last_num_level_parts_ == par::num_parts();
+    const auto overlapped = !incremental && !weighted_;
+    par::TaskGroup update_tasks{};
+    if (overlapped) {
+      update_tasks.run([&particles, this] {
+        partition_first_level_(particles, /*weighted=*/false);
+      });
+    }
+    search_(particles, radius_func, ghost_func, update_tasks);
+
+    // Partition the adjacency graph by the block. The incremental
+    // repartitioning falls back to the full one if the blocks are still too
+    // imbalanced. If the blocks are imbalanced, repartition with the particles
+    // weighted by their costs.
+    partition_(particles, incremental, /*first_level_ready=*/overlapped);
+    if (incremental && imbalance_ > max_incremental_imbalance_) {
+      partition_(particles, /*incremental=*/false);
+    }
+    if (!weighted_ && imbalance_ > max_imbalance_) {
+      weighted_ = true;
+      partition_(particles, /*incremental=*/false);
+    }
+
+    // Remember the positions the adjacency graphs were built for.
+    store_positions_(particles);
+    valid_ = true;
+    num_rebuilds_ += 1;
+    rebuild_interval_ = steps_since_rebuild_;
+    steps_since_rebuild_ = 0;
+    pairs_cached_ = false;
+    update_diagnostics_(particles);
+    track_memory_(particles);
+  }
+
+  /// Update the adjacency graph, with the fixed particles interpolated at
+  /// their own positions.
   template<particle_array ParticleArray, class SearchRadiusFunc>
   void update(ParticleArray& particles, const SearchRadiusFunc& radius_func) {
-    TIT_PROFILE_SECTION("ParticleMesh::update()");
+    using PV = ParticleView<ParticleArray>;
+    update(particles, radius_func, [](PV a) { return r[a]; });
+  }
 
-    // Update the adjacency graphs.
-    search_(particles, radius_func);
+  /// Set the maximum imbalance of the interior blocks, i.e. the ratio of the
+  /// largest interior block size to the average one. Once it is exceeded,
+  /// the particles are partitioned with their neighbor counts used as weights,
+  /// if the partitioning function supports weights.
+  constexpr void set_max_imbalance(float64_t max_imbalance) noexcept {
+    TIT_ASSERT(max_imbalance >= 1.0, "Maximum imbalance must be at least one!");
+    max_imbalance_ = max_imbalance;
+  }
 
-    // Partition the adjacency graph by the block.
-    partition_(particles);
+  /// Imbalance of the interior blocks after the last rebuild.
+  constexpr auto imbalance() const noexcept -> float64_t {
+    return imbalance_;
   }
 
-private:
+  /// Set the number of the partitioning levels. Each next level partitions
+  /// the interface of the previous one, and the pairs between the blocks of
+  /// the last level are processed serially. More levels shrink the last
+  /// block, at the cost of the smaller blocks on the higher levels.
+  constexpr void set_num_levels(size_t num_levels) noexcept {
+    TIT_ASSERT(num_levels > 0, "Number of levels must be positive!");
+    TIT_ASSERT(num_levels < PartVec::MaxNumLevels,
+               "Number of levels exceeds the predefined maximum!");
+    num_levels_ = num_levels;
+  }
+
+  /// Number of the partitioning levels.
+  constexpr auto num_levels() const noexcept -> size_t {
+    return num_levels_;
+  }
+
+  /// Fraction of the pairs in the last block after the last rebuild. These
+  /// pairs are processed serially, see `set_num_levels`.
+  constexpr auto serial_fraction() const noexcept -> float64_t {
+    return serial_fraction_;
+  }
 
+  /// Enable the incremental repartitioning. On rebuild, the first level
+  /// partitioning of the previous rebuild is reused, and the boundary
+  /// particles of the overloaded interior blocks are migrated to the lighter
+  /// neighboring blocks. The full repartitioning is done only if the
+  /// imbalance still exceeds @p max_imbalance, or if the mesh was
+  /// invalidated. Zero disables the incremental repartitioning.
+  constexpr void set_max_incremental_imbalance(
+      float64_t max_imbalance) noexcept {
+    TIT_ASSERT(max_imbalance == 0.0 || max_imbalance >= 1.0,
+               "Maximum imbalance must be zero or at least one!");
+    max_incremental_imbalance_ = max_imbalance;
+  }
+
+  /// Number of the particles migrated between the interior blocks by the
+  /// last rebuild. Zero if the full repartitioning was done.
+  constexpr auto num_migrated() const noexcept -> size_t {
+    return num_migrated_;
+  }
+
+  /// Number of the adjacency graph rebuilds so far.
+  constexpr auto num_rebuilds() const noexcept -> size_t {
+    return num_rebuilds_;
+  }
+
+  /// Maximum particle displacement since the last rebuild, as measured by the
+  /// last update. Zero if the Verlet skin is disabled.
+  constexpr auto max_disp() const noexcept -> float64_t {
+    return last_max_disp_;
+  }
+
+  /// Check if the adjacency graph is valid for the current particle indices.
+  constexpr auto valid() const noexcept -> bool {
+    return valid_;
+  }
+
+  /// Force the adjacency graph rebuild on the next update. This must be called
+  /// if the particles were reordered, added or removed.
+  void invalidate() noexcept {
+    speculation_.reset();
+    rebuild_interval_ = 0;
+    steps_since_rebuild_ = 0;
+    valid_ = false;
+    final_blocks_valid_ = false;
+    pruned_ = false;
+    pairs_cached_ = false;
+    interp_cached_ = false;
+    last_num_level_parts_ = 0;
+    last_positions_.clear();
+    interp_signatures_.clear();
+  }
+
+  /// Reorder the particles by the adjacency graph ordering, such as the
+  /// reverse Cuthill-McKee ordering, inside of each type range. Unlike the
+  /// spatial sorts, the ordering follows the actual neighbor connectivity.
+  ///
+  /// @note Particle indices are changed, so the mesh is invalidated.
+  template<particle_array ParticleArray,
+           class OrderingFunc = graph::CuthillMcKeeOrdering>
+  void reorder(ParticleArray& particles,
+               const OrderingFunc& ordering_func = {}) {
+    TIT_PROFILE_SECTION("ParticleMesh::reorder()");
+    TIT_ASSERT(valid_, "Mesh must be up to date!");
+    TIT_ASSERT(!listless_, "Adjacency is not stored in the listless mode!");
+    TIT_ASSERT(adjacency_.num_nodes() == particles.size(),
+               "Mesh is not built for the particle array!");
+
+    // Order the adjacency graph.
+    par::ArenaVector<size_t> order(particles.size(),
+                                   par::ArenaAllocator<size_t>{arena_});
+    ordering_func(adjacency_, order);
+    permute_typed_(particles, order);
+    invalidate();
+  }
+
+  /// Reorder the particles by their blocks inside of each type range, so
+  /// that the particles of each block are contiguous: the first level blocks
+  /// come first, followed by the interface level ones, see `parinfo`.
+  /// Relative order of the particles within a block is preserved. Each
+  /// worker then streams its own contiguous region of the array, which is
+  /// also what the first-touch page placement needs on the NUMA nodes.
+  ///
+  /// @note Particle indices are changed, so the mesh is invalidated.
+  template<particle_array ParticleArray>
+  void align(ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleMesh::align()");
+    TIT_ASSERT(valid_, "Mesh must be up to date!");
+    align_(particles);
+    invalidate();
+  }
+
+  /// Enable or disable the partition-aligned layout. If enabled, the
+  /// particles are aligned at the start of each rebuild by the blocks of the
+  /// previous one, see `align`. Partitioning follows the particles, and the
+  /// incremental repartitioning keeps the first level blocks, so the layout
+  /// stays aligned at the cost of a single permutation per rebuild.
+  ///
+  /// @note Particle indices are changed on the rebuilds, so no state must
+  ///       be indexed by the particles outside of the particle array.
+  constexpr void enable_aligned_layout(bool enabled = true) noexcept {
+    aligned_layout_enabled_ = enabled;
+  }
+
+  /// Is the partition-aligned layout enabled?
+  constexpr auto aligned_layout_enabled() const noexcept -> bool {
+    return aligned_layout_enabled_;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable the speculative neighbor search, see `speculate`.
+  ///
+  /// @param margin Search radius margin, that absorbs the errors of the
+  ///               predicted particle positions. Zero disables the
+  ///               speculative search.
+  void enable_speculation(float64_t margin) {
+    TIT_ASSERT(margin >= 0.0, "Speculation margin must be non-negative!");
+    speculation_margin_ = margin;
+    speculation_.reset();
+  }
+
+  /// Search radius margin of the speculative search, zero if disabled.
+  constexpr auto speculation_margin() const noexcept -> float64_t {
+    return speculation_margin_;
+  }
+
+  /// Start the speculative neighbor search for the next rebuild. This must
+  /// be called once per time step, after the update.
+  ///
+  /// Right after a rebuild, the neighbors are searched in background, in the
+  /// I/O task arena, for the particle positions extrapolated by the number
+  /// of steps between the last two rebuilds, `r + k * dt * v`, within the
+  /// search radii extended by the speculation margin. On the next rebuild,
+  /// the speculative adjacency replaces the neighbor search if none of the
+  /// particles has deviated from its predicted position by more than half of
+  /// the margin, and none of the search radii has grown. Otherwise, it is
+  /// discarded.
+  ///
+  /// @note Partition-aligned layout reorders the particles on each rebuild,
+  ///       so the speculative search is disabled with it.
   template<particle_array ParticleArray, class SearchRadiusFunc>
-  void search_(ParticleArray& particles, const SearchRadiusFunc& radius_func) {
-    TIT_PROFILE_SECTION("ParticleMesh::search()");
+  void speculate(ParticleArray& particles,
+                 const SearchRadiusFunc& radius_func,
+                 particle_num_t<ParticleArray> dt) {
     using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    const auto just_rebuilt = steps_since_rebuild_ == 0;
+    steps_since_rebuild_ += 1;
+    if (speculation_margin_ <= 0.0 || listless_ || aligned_layout_enabled_ ||
+        !valid_ || !just_rebuilt || rebuild_interval_ == 0) {
+      return;
+    }
+    TIT_PROFILE_SECTION("ParticleMesh::speculate()");
+    const auto lead_time = static_cast<Num>(rebuild_interval_) * dt;
 
-    // Build the search index.
-    const auto positions = r[particles];
-    const auto search_index = search_func_(positions);
+    // Predict the positions and the search radii.
+    auto speculation = std::make_unique<Speculation_>();
+    std::vector<Vec<Num, Dim>> positions(particles.size());
+    std::vector<Num> radii(particles.size());
+    speculation->positions.assign(particles.size(), Dim);
+    speculation->radii.resize(particles.size());
+    const auto skin = static_cast<Num>(skin_);
+    const auto margin = static_cast<Num>(speculation_margin_);
+    par::for_each(particles.all(), [&](PV a) {
+      const auto index = a.index();
+      positions[index] = r[a] + lead_time * v[a];
+      radii[index] = radius_func(a) + skin + margin;
+      for (size_t i = 0; i < Dim; ++i) {
+        speculation->positions[index, i] =
+            static_cast<float64_t>(positions[index][i]);
+      }
+      speculation->radii[index] = static_cast<float64_t>(radii[index]);
+    });
+
+    // Search for the neighbors in background.
+    speculation->thread = std::jthread{
+        [&state = *speculation,
+         search_func = search_func_,
+         positions = std::move(positions),
+         radii = std::move(radii)] {
+          try {
+            par::io_execute([&] {
+              speculate_search_(search_func, positions, radii, state.adjacency);
+            });
+          } catch (...) {
+            state.error = std::current_exception();
+          }
+          state.done.store(true);
+        }};
+    speculation_ = std::move(speculation);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-    // Search for the neighbors.
+  /// Enable or disable the tiled traversal of the block pairs.
+  ///
+  /// Particles are grouped into the tiles of @p tile_size consecutive
+  /// indices, and the edges of each block are sorted on each rebuild by the
+  /// tile of the first particle, then by the tile of the second one. Since
+  /// the particles are ordered along a space-filling curve, the particles of
+  /// a tile pair are close in space, and their data stays in the L2 cache
+  /// while the edges of the tile pair are processed. The pair passes also
+  /// prefetch the second particle of the edge @p prefetch_distance edges
+  /// ahead, see `BoundParticleArray::prefetch`.
+  ///
+  /// @param tile_size         Number of the particles in a tile. Two tiles
+  ///                          should fit into the L2 cache, e.g. 512
+  ///                          particles with 150 bytes of fields each take
+  ///                          150 KB.
+  /// @param prefetch_distance Number of the edges to prefetch ahead, zero
+  ///                          to disable the prefetching.
+  void enable_tiling(bool enabled = true,
+                     size_t tile_size = 512,
+                     size_t prefetch_distance = 16) {
+    TIT_ASSERT(!enabled || !listless_,
+               "Tiling is not available in the listless mode!");
+    TIT_ASSERT(tile_size > 0, "Tile size must be positive!");
+    tiling_enabled_ = enabled;
+    tile_size_ = tile_size;
+    prefetch_distance_ = prefetch_distance;
+    invalidate();
+  }
+
+  /// Is the tiled traversal of the block pairs enabled?
+  constexpr auto tiling_enabled() const noexcept -> bool {
+    return tiling_enabled_;
+  }
+
+  /// Number of the edges the pair passes prefetch ahead, zero if the tiled
+  /// traversal is disabled, see `enable_tiling`.
+  constexpr auto prefetch_distance() const noexcept -> size_t {
+    return tiling_enabled_ ? prefetch_distance_ : 0;
+  }
+
+  /// Edges of all the blocks, one block after another, see `block_edges`.
+  /// Edge of a block is an element of this span, so the edges that are
+  /// processed later could be found by the offset.
+  constexpr auto block_edge_values() const noexcept -> std::span<const Edge> {
+    TIT_ASSERT(!listless_, "Block pairs are not stored in the listless mode!");
+    return current_block_edges_().values();
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the listless mode. In the listless mode, neither the
+  /// adjacency graph nor the block pairs are stored, and the neighbors are
+  /// found on the fly using the search index, see `for_each_neighbor`. This
+  /// trades the neighbor searches in each pair pass for the memory.
+  void enable_listless(bool enabled = true) {
+    listless_ = enabled;
+    invalidate();
+    if (enabled) {
+      adjacency_ = {};
+      block_edges_ = {};
+      active_block_edges_ = {};
+      enable_pair_cache(false);
+      enable_pruning(false);
+      enable_culling(false);
+      tiling_enabled_ = false;
+    }
+  }
+
+  /// Is the listless mode enabled?
+  constexpr auto listless() const noexcept -> bool {
+    return listless_;
+  }
+
+  /// Call the function for each particle within the radius to the given
+  /// particle, including the particle itself. Neighbors are found using the
+  /// search index, so the mesh must be up to date with the particle positions.
+  template<particle_view PV, class Func>
+  void for_each_neighbor(PV a,
+                         particle_num_t<PV> search_radius,
+                         const Func& func) const {
+    for_each_near(a.array(), r[a], search_radius, func);
+  }
+
+  /// Call the function for each particle within the radius to the given
+  /// point, for example, to interpolate the particle fields at the probe
+  /// points. Particles are found using the search index, so the mesh must be
+  /// up to date with the particle positions.
+  template<particle_array ParticleArray, class Func>
+  void for_each_near(ParticleArray& particles,
+                     const particle_vec_t<ParticleArray>& point,
+                     particle_num_t<ParticleArray> search_radius,
+                     const Func& func) const {
+    TIT_ASSERT(valid_, "Mesh must be up to date!");
+    TIT_ASSERT(search_radius > 0.0, "Search radius must be positive.");
+    const auto& search_index = cached_search_index_(particles);
+    const auto visit = [&particles, &func](size_t b) { func(particles[b]); };
+    search_index.for_each_near(point, search_radius, visit);
+    if (const auto& periodic_box = particles.periodic_box()) {
+      periodic_box->for_each_image(
+          point,
+          search_radius,
+          [&search_index, search_radius, &visit](const auto& image) {
+            search_index.for_each_near(image, search_radius, visit);
+          });
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the pair cache. Pair cache stores the kernel values
+  /// and gradients for each block pair, trading memory for the kernel
+  /// evaluations in the subsequent pair passes.
+  void enable_pair_cache(bool enabled = true) {
+    TIT_ASSERT(!enabled || !listless_,
+               "Pair cache is not available in the listless mode!");
+    pair_cache_enabled_ = enabled;
+    if (!enabled) pairs_cached_ = false, pair_cache_.clear();
+  }
+
+  /// Is the pair cache enabled?
+  constexpr auto pair_cache_enabled() const noexcept -> bool {
+    return pair_cache_enabled_;
+  }
+
+  /// Is the pair cache valid for the current block pairs?
+  constexpr auto pairs_cached() const noexcept -> bool {
+    return pairs_cached_ && !active_;
+  }
+
+  /// Evaluate the pair function for each block pair and store the results.
+  /// This must be called every time the particle positions change.
+  ///
+  /// @param pair_func Function that returns a pair of the kernel value and
+  ///                  the kernel gradient for the particle pair.
+  template<particle_array ParticleArray, class PairFunc>
+  void cache_pairs(ParticleArray& particles, const PairFunc& pair_func) {
+    TIT_PROFILE_SECTION("ParticleMesh::cache_pairs()");
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    TIT_ASSERT(pair_cache_enabled_, "Pair cache is not enabled!");
+    pairs_cached_ = false;
+    const auto& block_edges = pass_block_edges_();
+    pair_cache_.assign(total_size_(block_edges), Dim + 1);
+    par::for_each(block_edges.buckets(), [&](auto block) {
+      for (const auto& ab : block) {
+        const auto [a, b] = ab;
+        const auto edge = edge_index_(ab);
+        const auto [W_ab, grad_W_ab] = pair_func(particles[a], particles[b]);
+        pair_cache_[edge, 0] = static_cast<float64_t>(W_ab);
+        for (size_t i = 0; i < Dim; ++i) {
+          pair_cache_[edge, i + 1] = static_cast<float64_t>(grad_W_ab[i]);
+        }
+      }
+    });
+    pairs_cached_ = true;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the interpolation cache. Interpolation cache stores
+  /// the boundary interpolation weights of the fixed particles, that are
+  /// reused until the interpolation points are searched again. Weights are
+  /// frozen while the fluid particles move within the skin, which trades
+  /// the accuracy of the boundary values for the repeated interpolations.
+  void enable_interp_cache(bool enabled = true) {
+    interp_cache_enabled_ = enabled;
+    if (!enabled) {
+      interp_cached_ = false;
+      interp_cache_.clear();
+      interp_cache_valid_.clear();
+    }
+  }
+
+  /// Is the interpolation cache enabled?
+  constexpr auto interp_cache_enabled() const noexcept -> bool {
+    return interp_cache_enabled_;
+  }
+
+  /// Enable or disable the search for the interpolation points of the fixed
+  /// particles. With the search disabled, `fixed_interp` is empty for all
+  /// the fixed particles, which is sufficient for the boundary models that
+  /// do not interpolate the fluid fields, e.g. the dynamic boundary
+  /// particles. Re-enabling the search invalidates the mesh.
+  void enable_interp_search(bool enabled = true) {
+    if (enabled == interp_search_enabled_) return;
+    interp_search_enabled_ = enabled;
+    if (enabled) invalidate();
+  }
+
+  /// Is the search for the interpolation points enabled?
+  constexpr auto interp_search_enabled() const noexcept -> bool {
+    return interp_search_enabled_;
+  }
+
+  /// Is the interpolation cache valid for the current interpolation points?
+  constexpr auto interp_cached() const noexcept -> bool {
+    return interp_cached_;
+  }
+
+  /// Evaluate the interpolation weights for each fixed particle and store
+  /// the results.
+  ///
+  /// @param weights_func Function that computes the weights of the
+  ///                     interpolation points of the fixed particle, in the
+  ///                     `fixed_interp` order, and returns false if the
+  ///                     interpolation fails.
+  template<particle_array ParticleArray, class WeightsFunc>
+  void cache_interp(ParticleArray& particles, const WeightsFunc& weights_func) {
+    TIT_PROFILE_SECTION("ParticleMesh::cache_interp()");
+    TIT_ASSERT(interp_cache_enabled_, "Interpolation cache is not enabled!");
+    interp_cached_ = false;
+    const auto fixed = particles.fixed();
+    TIT_ASSERT(interp_adjacency_.size() == fixed.size(),
+               "Interpolation points are out of date!");
+    interp_cache_.resize(interp_adjacency_.values().size());
+    interp_cache_valid_.resize(fixed.size());
+    par::for_each(std::views::iota(size_t{0}, fixed.size()), [&](size_t i) {
+      const auto a = fixed[i];
+      const auto weights = interp_cache_span_(i);
+      interp_cache_valid_[i] = !culled(a) && weights_func(a, weights) ? 1 : 0;
+    });
+    interp_cached_ = true;
+  }
+
+  /// Cached interpolation weights of the fixed particle, in the
+  /// `fixed_interp` order. Empty if the interpolation has failed.
+  template<particle_view PV>
+  auto interp_weights(PV a) const noexcept -> std::span<const float64_t> {
+    TIT_ASSERT(interp_cached_, "Interpolation weights are not cached!");
+    TIT_ASSERT(a.has_type(ParticleType::fixed),
+               "Particle must be of the fixed type!");
+    const size_t i = a.array().type_rank(a.index());
+    if (interp_cache_valid_[i] == 0) return {};
+    return interp_cache_span_(i);
+  }
+
+private:
+
+  // Interpolation weights storage of the fixed particle.
+  auto interp_cache_span_(this auto& self, size_t i) noexcept {
+    const auto offset = static_cast<size_t>(
+        self.interp_adjacency_[i].data() -
+        self.interp_adjacency_.values().data());
+    return std::span{self.interp_cache_}.subspan(
+        offset,
+        self.interp_adjacency_[i].size());
+  }
+
+  // Permute the particles by the order, keeping them within their type
+  // ranges, unless the types are tagged.
+  template<particle_array ParticleArray>
+  void permute_typed_(ParticleArray& particles,
+                      std::span<const size_t> order) {
+    // Particles with the tagged types follow the order as is.
+    if constexpr (ParticleArray::tagged_types) {
+      particles.permute(order);
+      return;
+    }
+
+    // Keep the particles within their type ranges, preserving the order.
+    par::ArenaVector<size_t> perm(particles.size(),
+                                  par::ArenaAllocator<size_t>{arena_});
+    auto out = perm.begin();
+    for (size_t type_index = 0;
+         type_index < std::to_underlying(ParticleType::count);
+         ++type_index) {
+      const auto type = static_cast<ParticleType>(type_index);
+      out = par::copy_if(order, out, [&particles, type](size_t index) {
+        return particles.has_type(index, type);
+      });
+    }
+    TIT_ASSERT(out == perm.end(), "Ordering is not a permutation!");
+    particles.permute(perm);
+  }
+
+  // Permute the particles by their blocks, see `align`. Particles are
+  // bucketed by the block sequentially, so that their relative order within
+  // each block is preserved. Interpolation point signatures are keyed by
+  // the fixed particle ranks, so they are dropped.
+  template<particle_array ParticleArray>
+  void align_(ParticleArray& particles) {
+    if (particles.size() == 0) return;
+    const auto parts = parinfo[particles];
+    const auto last_part = [](const PartVec& part) { return part.last(); };
+    const auto num_parts = size_t{par::max(parts, last_part)} + 1;
+    block_particles_.assign_pairs_seq(
+        num_parts,
+        std::views::iota(size_t{0}, particles.size()) |
+            std::views::transform([&parts](size_t a) {
+              return std::pair{size_t{parts[a].last()}, a};
+            }));
+    permute_typed_(particles, block_particles_.values());
+    interp_signatures_.clear();
+  }
+
+  // Sort the edges of each block by the particle tiles, see `enable_tiling`.
+  // Edges of a tile pair are ordered by the particle indices.
+  void tile_block_edges_() {
+    TIT_PROFILE_SECTION("ParticleMesh::tile_block_edges()");
+    par::for_each(block_edges_.buckets(), [tile_size = tile_size_](auto block) {
+      std::ranges::sort(block, {}, [tile_size](const Edge& ab) {
+        const auto [a, b] = ab;
+        return std::tuple{a / tile_size, b / tile_size, a, b};
+      });
+    });
+  }
+
+  // Group the particles by the last block that touches them. Blocks of each
+  // chunk of `par::num_parts()` blocks touch disjoint particles, so the
+  // chunks are visited in order, and the blocks of a chunk in parallel.
+  void build_final_blocks_() {
+    TIT_PROFILE_SECTION("ParticleMesh::build_final_blocks()");
+    const auto num_particles = adjacency_.num_nodes();
+    const auto num_blocks = block_edges_.size();
+    final_block_.assign(num_particles, 0);
+    const auto chunk_size = par::num_parts();
+    for (size_t first = 0; first < num_blocks; first += chunk_size) {
+      const auto last = std::min(first + chunk_size, num_blocks);
+      par::for_each(std::views::iota(first, last), [this](size_t block) {
+        for (const auto& [a, b] : block_edges_[block]) {
+          final_block_[a] = block, final_block_[b] = block;
+        }
+      });
+    }
+    final_blocks_.assign_pairs_par_tall(
+        num_blocks,
+        std::views::iota(size_t{0}, num_particles) |
+            std::views::transform([this](size_t a) {
+              return std::pair{final_block_[a], static_cast<Index>(a)};
+            }));
+    final_blocks_valid_ = true;
+  }
+
+  // Block edges the pair passes are run over, before the activation.
+  constexpr auto pass_block_edges_() const noexcept
+      -> const Multivector<Edge>& {
+    return pruned_ ? pruned_block_edges_ : block_edges_;
+  }
+
+  // Block edges the pair passes are run over, after the activation.
+  constexpr auto current_block_edges_() const noexcept
+      -> const Multivector<Edge>& {
+    return active_ ? active_block_edges_ : pass_block_edges_();
+  }
+
+  // Total number of the block edges.
+  static constexpr auto total_size_(const Multivector<Edge>& block_edges)
+      -> size_t {
+    return std::ranges::fold_left(block_edges.bucket_sizes(),
+                                  size_t{0},
+                                  std::plus{});
+  }
+
+  // Copy the block edges that satisfy the predicate, keeping the blocks.
+  template<class EdgePred>
+  void filter_block_edges_(const Multivector<Edge>& block_edges,
+                           Multivector<Edge>& result,
+                           const EdgePred& pred) {
+    arena_.reset();
+    auto buckets = make_buckets_<Edge>(block_edges.size());
+    par::for_each( //
+        std::views::zip(block_edges.buckets(), buckets),
+        [&pred](const auto& block_and_bucket) {
+          const auto& [block, bucket] = block_and_bucket;
+          bucket.clear();
+          std::ranges::copy_if(block, std::back_inserter(bucket), pred);
+        });
+    result.assign_buckets_par(buckets);
+  }
+
+  // Index of the block edge in the edge storage.
+  auto edge_index_(const Edge& ab) const noexcept -> size_t {
+    return static_cast<size_t>(&ab - pass_block_edges_()[0].data());
+  }
+
+  // Block pair with the cached kernel value and gradient.
+  template<particle_array ParticleArray>
+  auto cached_pair_(ParticleArray& particles,
+                    const Edge& ab) const noexcept {
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    const auto [a, b] = ab;
+    const auto edge = edge_index_(ab);
+    const auto W_ab = static_cast<Num>(pair_cache_[edge, 0]);
+    Vec<Num, Dim> grad_W_ab;
+    for (size_t i = 0; i < Dim; ++i) {
+      grad_W_ab[i] = static_cast<Num>(pair_cache_[edge, i + 1]);
+    }
+    return std::tuple{particles[a], particles[b], W_ab, grad_W_ab};
+  }
+
+  template<particle_array ParticleArray>
+  auto needs_rebuild_(const ParticleArray& particles) -> bool {
+    TIT_PROFILE_SECTION("ParticleMesh::needs_rebuild()");
+    using PV = ParticleView<const ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+
+    // Without the skin, or if particles were added or removed since the last
+    // rebuild, the adjacency graphs are always rebuilt.
+    if (!valid_ || skin_ <= 0.0) return true;
+    if (last_positions_.shape() != std::array{particles.size(), Dim}) {
+      return true;
+    }
+
+    // Compute the maximum particle displacement since the last rebuild.
+    par::ArenaVector<float64_t> thread_max_disp(
+        par::num_threads(),
+        0.0,
+        par::ArenaAllocator<float64_t>{arena_});
+    par::static_for_each(
+        particles.all(),
+        [&thread_max_disp, this](size_t thread, PV a) {
+          float64_t disp{};
+          for (size_t i = 0; i < Dim; ++i) {
+            disp += pow2(static_cast<float64_t>(r[a][i]) -
+                         last_positions_[a.index(), i]);
+          }
+          thread_max_disp[thread] = std::max(thread_max_disp[thread], disp);
+        });
+    const auto max_disp = sqrt(std::ranges::max(thread_max_disp));
+    TIT_STATS("ParticleMesh::max_disp", max_disp);
+
+    // Two particles moving towards each other close the gap twice as fast.
+    // We also assume that the particles will move at least as far until the
+    // next update as they did since the previous one, so that the skin is
+    // not exhausted in between the updates. The extrapolation may fall short
+    // of the current displacement, so the latter is checked as well.
+    const auto next_max_disp = 2 * max_disp - last_max_disp_;
+    last_max_disp_ = max_disp;
+    return 2 * std::max(max_disp, next_max_disp) >= skin_;
+  }
+
+  template<particle_array ParticleArray>
+  void store_positions_(const ParticleArray& particles) {
+    using PV = ParticleView<const ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    last_max_disp_ = 0.0;
+    if (skin_ <= 0.0) return;
+    last_positions_.assign(particles.size(), Dim);
+    par::for_each(particles.all(), [this](PV a) {
+      for (size_t i = 0; i < Dim; ++i) {
+        last_positions_[a.index(), i] = static_cast<float64_t>(r[a][i]);
+      }
+    });
+  }
+
+  // Make the buckets of the temporary values, allocated from the arena.
+  template<class Val>
+  auto make_buckets_(size_t count) -> par::ArenaVector<par::ArenaVector<Val>> {
+    const par::ArenaAllocator<Val> alloc{arena_};
+    return par::ArenaVector<par::ArenaVector<Val>>(
+        count,
+        par::ArenaVector<Val>(alloc),
+        par::ArenaAllocator<par::ArenaVector<Val>>{alloc});
+  }
+
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           class GhostFunc>
+  void search_(ParticleArray& particles,
+               const SearchRadiusFunc& radius_func,
+               const GhostFunc& ghost_func) {
     par::TaskGroup search_tasks{};
-    search_tasks.run([&particles, &radius_func, &search_index, this] {
-      static std::vector<std::vector<size_t>> adjacency_buckets{};
-      adjacency_buckets.resize(particles.size());
-      par::for_each(particles.all(), [&radius_func, &search_index](PV a) {
-        const auto& search_point = r[a];
-        const auto search_radius = radius_func(a);
-        TIT_ASSERT(search_radius > 0.0, "Search radius must be positive.");
-
-        // Search for the neighbors for the current particle and store the
-        // sorted results.
-        auto& search_results = adjacency_buckets[a.index()];
-        search_results.clear();
-        search_index.search(search_point,
-                            search_radius,
-                            std::back_inserter(search_results));
-        std::ranges::sort(search_results);
+    search_(particles, radius_func, ghost_func, search_tasks);
+  }
+
+  // Search for the neighbors with the tasks run in the given group, and wait
+  // for the whole group, including the tasks that were already run in it.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           class GhostFunc>
+  void search_(ParticleArray& particles,
+               const SearchRadiusFunc& radius_func,
+               const GhostFunc& ghost_func,
+               par::TaskGroup& search_tasks) {
+    TIT_PROFILE_SECTION("ParticleMesh::search()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    const auto skin = static_cast<Num>(skin_);
+    if (auto max_num_particles = std::numeric_limits<Index>::max();
+        particles.size() > max_num_particles) {
+      TIT_THROW("Number of particles exceeded the limit of {}.",
+                max_num_particles);
+    }
+
+    // Build the search index and detect the inactive fixed particles.
+    const auto& search_index =
+        build_search_index_(particles, radius_func, skin);
+    cull_(particles, radius_func, search_index, skin);
+
+    // Take the adjacency found by the speculative search, if it is valid.
+    const auto speculated =
+        !listless_ && take_speculation_(particles, radius_func, skin);
+
+    // Search for the neighbors, unless in the listless mode. Results are
+    // written straight into the adjacency storage and then sorted.
+    search_tasks.run([&particles,
+                      &radius_func,
+                      &search_index,
+                      skin,
+                      speculated,
+                      this] {
+      if (listless_) return;
+      const auto positions = r[particles];
+      const auto radii = search_radii_(particles, radius_func, skin);
+      if (speculated) {
+        // Adjacency was found by the speculative search.
+      } else if (search_pairs_(search_index, radii)) {
+        // Adjacency was assembled from the unique pairs.
+      } else if constexpr (requires {
+                             search_index.search_batch(positions,
+                                                       radii,
+                                                       adjacency_);
+                           }) {
+        // Search for all the particles at once, if the index supports it.
+        search_index.search_batch(positions, radii, adjacency_);
+      } else {
+        adjacency_.assign_buckets_par(
+            particles.size(),
+            [&positions, &radii, &search_index, this](size_t index, auto out) {
+              if (is_culled_(index)) return;
+              const auto& search_point = positions[index];
+              const auto search_radius = radii[index];
+              TIT_ASSERT(search_radius > 0.0,
+                         "Search radius must be positive.");
+              // Use the symmetric search if the index supports it, so that
+              // the neighbors with the larger radii are found too.
+              if constexpr (requires {
+                              search_index.search_symmetric(search_point,
+                                                            search_radius,
+                                                            out);
+                            }) {
+                search_index.search_symmetric(search_point,
+                                              search_radius,
+                                              out);
+              } else {
+                search_index.search(search_point, search_radius, out);
+              }
+            });
+      }
+      if (particles.periodic_box()) {
+        search_images_(particles, search_index, radii);
+      }
+      if (num_culled_ > 0) drop_culled_(particles);
+      par::for_each(adjacency_.buckets(), [](auto neighbors) {
+        std::ranges::sort(neighbors);
+        TIT_STATS_HIST("ParticleMesh::num_neighbors", neighbors.size());
       });
-      adjacency_.assign_buckets_par(adjacency_buckets);
     });
 
     // Search for the interpolation points for the fixed particles.
-    search_tasks.run([&particles, &radius_func, &search_index, this] {
-      static std::vector<std::vector<size_t>> interp_adjacency_buckets{};
-      interp_adjacency_buckets.resize(particles.fixed().size());
-      par::for_each( //
-          std::views::enumerate(particles.fixed()),
-          [&radius_func, &search_index, &particles](const auto& ia) {
-            const auto& [i, a] = ia;
-
-            /// @todo Once we have a proper geometry library, we should use
-            ///       here and clean up the code.
-            const auto& search_point = r[a];
-            const auto search_radius = RADIUS_SCALE * radius_func(a);
-            const auto point_on_boundary = Domain.clamp(search_point);
-            const auto interp_point = 2 * point_on_boundary - search_point;
-
-            // Search for the neighbors for the interpolation point and
-            // store the sorted results.
-            auto& search_results = interp_adjacency_buckets[i];
-            search_results.clear();
-            search_index.search( //
+    search_tasks.run(
+        [&particles, &radius_func, &ghost_func, &search_index, skin, this] {
+          search_interp_(particles,
+                         radius_func,
+                         ghost_func,
+                         search_index,
+                         skin);
+        });
+
+    search_tasks.wait();
+  }
+
+  // Search for the interpolation points for the fixed particles.
+  //
+  // Walls do not move, so the interpolation points of a fixed particle are
+  // searched again only if the fluid particles near its ghost point have
+  // changed. Changes are tracked via the cell occupancy: each cell of a
+  // coarse grid gets a signature of the indices and positions of the fluid
+  // particles within it, and each ghost point gets a signature of the cells
+  // its search box intersects.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           class GhostFunc,
+           class SearchIndex>
+  void search_interp_(ParticleArray& particles,
+                      const SearchRadiusFunc& radius_func,
+                      const GhostFunc& ghost_func,
+                      const SearchIndex& search_index,
+                      particle_num_t<ParticleArray> skin) {
+    TIT_PROFILE_SECTION("ParticleMesh::search_interp()");
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    interp_cached_ = false;
+    const auto fixed = particles.fixed();
+    if (fixed.empty()) {
+      interp_adjacency_.clear();
+      interp_signatures_.clear();
+      return;
+    }
+
+    // Leave the interpolation points empty, if the search is disabled.
+    if (!interp_search_enabled_) {
+      interp_adjacency_.assign_buckets_par(fixed.size(),
+                                           [](size_t /*i*/, auto /*out*/) {});
+      interp_signatures_.clear();
+      return;
+    }
+
+    // Ghost point and the search radius for the fixed particle.
+    const auto ghost = [&radius_func, &ghost_func, skin](PV a) {
+      const auto search_radius = RADIUS_SCALE * radius_func(a) + skin;
+      return std::pair{ghost_func(a), search_radius};
+    };
+
+    // Hash of the values, mixed into the seed.
+    const auto hash = [](uint64_t seed, const auto& val) {
+      return SplitMix64{
+          seed ^ std::bit_cast<uint64_t>(static_cast<float64_t>(val))}();
+    };
+    const auto hash_point = [&hash](uint64_t seed, const auto& point) {
+      for (size_t i = 0; i < Dim; ++i) seed = hash(seed, point[i]);
+      return seed;
+    };
+
+    // Compute the cell signatures of the fluid particles. Signatures are the
+    // wrapping sums, so they do not depend on the summation order.
+    const auto max_radius =
+        par::max(fixed, [&ghost](PV a) { return ghost(a).second; });
+    const auto grid =
+        geom::Grid{geom::compute_bbox(r[particles]).grow(max_radius / 2)}
+            .set_cell_extents(max_radius);
+    std::vector<uint64_t> cell_signatures(grid.flat_num_cells());
+    const auto add_to_cell = [&hash_point, &grid, &cell_signatures](PV a) {
+      const auto cell = grid.flat_cell_index(r[a]);
+      par::fetch_and_add(cell_signatures[cell], hash_point(a.index(), r[a]));
+    };
+    par::for_each(particles.fluid(), add_to_cell);
+
+    // Compute the ghost point signatures. Culled particles get a zero
+    // signature, so that their empty results are never reused once they
+    // become active again.
+    std::vector<uint64_t> signatures(fixed.size());
+    const auto compute_signature = [&](size_t i) {
+      if (culled(fixed[i])) return;
+      const auto [interp_point, search_radius] = ghost(fixed[i]);
+      auto signature = hash_point(particles.size(), interp_point);
+      signature = hash(signature, search_radius);
+      const auto search_box = geom::BBox{interp_point}.grow(search_radius);
+      for (const auto& cell : grid.cells_intersecting(search_box)) {
+        const auto flat_cell = grid.flatten_cell_index(cell);
+        signature += SplitMix64{cell_signatures[flat_cell] ^ flat_cell}();
+      }
+      signatures[i] = signature;
+    };
+    par::for_each(std::views::iota(size_t{0}, fixed.size()), compute_signature);
+
+    // Search for the neighbors of the ghost points, reusing the previous
+    // results if the signatures match.
+    // Signatures do not track the particles across the periodic box faces, so
+    // the results are never reused for the periodic particles.
+    const bool can_reuse = !particles.periodic_box() &&
+                           interp_signatures_.size() == fixed.size() &&
+                           interp_adjacency_.size() == fixed.size();
+    const auto prev_interp_adjacency = std::move(interp_adjacency_);
+    std::vector<uint8_t> searched(fixed.size());
+    interp_adjacency_.assign_buckets_par(
+        fixed.size(),
+        [&, can_reuse](size_t i, auto out) {
+          if (culled(fixed[i])) return;
+          if (can_reuse && signatures[i] == interp_signatures_[i]) {
+            std::ranges::copy(prev_interp_adjacency[i], out);
+            return;
+          }
+          searched[i] = 1;
+          const auto [interp_point, search_radius] = ghost(fixed[i]);
+          const auto is_fluid = [&particles](size_t b) {
+            return particles.has_type(b, ParticleType::fluid);
+          };
+          out = search_index.search(interp_point, search_radius, out, is_fluid);
+          if (const auto& periodic_box = particles.periodic_box()) {
+            periodic_box->for_each_image(
                 interp_point,
                 search_radius,
-                std::back_inserter(search_results),
-                [&particles](size_t b) {
-                  return particles.has_type(b, ParticleType::fluid);
+                [&search_index, search_radius, &out, &is_fluid](
+                    const auto& image) {
+                  out =
+                      search_index.search(image, search_radius, out, is_fluid);
                 });
-            std::ranges::sort(search_results);
+          }
+        });
+    par::for_each(std::views::iota(size_t{0}, fixed.size()),
+                  [&searched, this](size_t i) {
+                    if (searched[i] == 0) return;
+                    std::ranges::sort(interp_adjacency_[i]);
+                  });
+    interp_signatures_ = std::move(signatures);
+    TIT_STATS("ParticleMesh::num_interp_searches",
+              std::ranges::count(searched, uint8_t{1}));
+  }
+
+  // Wrap the particle positions into the periodic box, if any.
+  template<particle_array ParticleArray>
+  static void wrap_positions_(ParticleArray& particles) {
+    using PV = ParticleView<ParticleArray>;
+    const auto& periodic_box = particles.periodic_box();
+    if (!periodic_box) return;
+    par::for_each(particles.all(), [&periodic_box](PV a) {
+      r[a] = periodic_box->wrap(r[a]);
+    });
+  }
+
+  // Add the neighbors across the periodic box faces to the adjacency. They
+  // are found by searching near the periodic images of the particles that are
+  // close to the faces, so that no ghost copies of the particles are needed.
+  // Images are taken within the largest search radius, so that the neighbors
+  // are found from both sides even if the radii are different.
+  template<particle_array ParticleArray, class SearchIndex, class Radii>
+  void search_images_(ParticleArray& particles,
+                      const SearchIndex& search_index,
+                      const Radii& radii) {
+    TIT_PROFILE_SECTION("ParticleMesh::search_images()");
+    const auto& periodic_box = *particles.periodic_box();
+    const auto positions = r[particles];
+    const auto max_radius = par::max(radii);
+    Multivector<Index> image_adjacency;
+    image_adjacency.assign_buckets_par(
+        particles.size(),
+        [&](size_t index, auto out) {
+          if (is_culled_(index)) return;
+          const auto search_radius = radii[index];
+          periodic_box.for_each_image(
+              positions[index],
+              max_radius,
+              [&search_index, search_radius, &out](const auto& image) {
+                if constexpr (requires {
+                                search_index.search_symmetric(image,
+                                                              search_radius,
+                                                              out);
+                              }) {
+                  out = search_index.search_symmetric(image,
+                                                      search_radius,
+                                                      out);
+                } else {
+                  out = search_index.search(image, search_radius, out);
+                }
+              });
+        });
+    decltype(adjacency_) adjacency;
+    adjacency.assign_buckets_par(
+        particles.size(),
+        [&image_adjacency, this](size_t index, auto out) {
+          out = std::ranges::copy(adjacency_[index], out).out;
+          std::ranges::copy(image_adjacency[index], out);
+        });
+    adjacency_ = std::move(adjacency);
+  }
+
+  // Is the particle culled by the last rebuild?
+  constexpr auto is_culled_(size_t index) const noexcept -> bool {
+    return !culled_.empty() && culled_[index] != 0;
+  }
+
+  // Mark the fixed particles that have no fluid particles within
+  // `RADIUS_SCALE` search radii as culled, if the culling is enabled. The
+  // search radius is extended by the skin width, so that the particles stay
+  // inactive until the next rebuild.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           class SearchIndex>
+  void cull_(ParticleArray& particles,
+             const SearchRadiusFunc& radius_func,
+             const SearchIndex& search_index,
+             particle_num_t<ParticleArray> skin) {
+    using PV = ParticleView<ParticleArray>;
+    num_culled_ = 0;
+    culled_.clear();
+    if (!culling_enabled_ || listless_) return;
+    TIT_PROFILE_SECTION("ParticleMesh::cull()");
+    culled_.resize(particles.size());
+    const auto is_fluid = [&particles](size_t b) {
+      return particles.has_type(b, ParticleType::fluid);
+    };
+    par::for_each(particles.fixed(), [&](PV a) {
+      par::ArenaVector<size_t> fluid{par::ArenaAllocator<size_t>{arena_}};
+      const auto search_radius = RADIUS_SCALE * radius_func(a) + skin;
+      const auto out = std::back_inserter(fluid);
+      search_index.search(r[a], search_radius, out, is_fluid);
+      if (const auto& periodic_box = particles.periodic_box()) {
+        periodic_box->for_each_image(
+            r[a],
+            search_radius,
+            [&search_index, search_radius, out, &is_fluid](const auto& image) {
+              search_index.search(image, search_radius, out, is_fluid);
+            });
+      }
+      if (fluid.empty()) culled_[a.index()] = 1;
+    });
+    num_culled_ = std::ranges::count(culled_, uint8_t{1});
+    TIT_STATS("ParticleMesh::num_culled", num_culled_);
+    Metrics::set("ParticleMesh::num_culled",
+                 static_cast<float64_t>(num_culled_));
+  }
+
+  // Remove the culled particles from the adjacency graph.
+  template<particle_array ParticleArray>
+  void drop_culled_(ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleMesh::drop_culled()");
+    decltype(adjacency_) adjacency;
+    adjacency.assign_buckets_par(
+        particles.size(),
+        [this](size_t index, auto out) {
+          if (is_culled_(index)) return;
+          std::ranges::copy_if(adjacency_[index], out, [this](size_t b) {
+            return !is_culled_(b);
+          });
+        });
+    adjacency_ = std::move(adjacency);
+  }
+
+  // Search for the neighbors of the predicted positions. Runs in
+  // background, so only the arguments are accessed.
+  template<class Positions, class Radii>
+  static void speculate_search_(const SearchFunc& search_func,
+                                const Positions& positions,
+                                const Radii& radii,
+                                graph::BasicGraph<Index>& adjacency) {
+    TIT_PROFILE_SECTION("ParticleMesh::speculate_search()");
+    const auto search_index = [&search_func, &positions, &radii] {
+      if constexpr (requires { search_func(positions, radii); }) {
+        return search_func(positions, radii);
+      } else {
+        return search_func(positions);
+      }
+    }();
+    if constexpr (requires {
+                    search_index.search_batch(positions, radii, adjacency);
+                  }) {
+      search_index.search_batch(positions, radii, adjacency);
+    } else {
+      adjacency.assign_buckets_par(
+          positions.size(),
+          [&positions, &radii, &search_index](size_t index, auto out) {
+            if constexpr (requires {
+                            search_index.search_symmetric(positions[index],
+                                                          radii[index],
+                                                          out);
+                          }) {
+              search_index.search_symmetric(positions[index],
+                                            radii[index],
+                                            out);
+            } else {
+              search_index.search(positions[index], radii[index], out);
+            }
           });
-      interp_adjacency_.assign_buckets_par(interp_adjacency_buckets);
+    }
+  }
+
+  // Take the adjacency of the speculative search, if there is any, and it
+  // is valid for the current particle positions and search radii. Pairs of
+  // the particles that are within the radius are within the radius extended
+  // by the margin of the predicted positions, as long as each particle is
+  // within half of the margin from its prediction.
+  template<particle_array ParticleArray, class SearchRadiusFunc>
+  auto take_speculation_(ParticleArray& particles,
+                         const SearchRadiusFunc& radius_func,
+                         particle_num_t<ParticleArray> skin) -> bool {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    if (speculation_ == nullptr) return false;
+    TIT_PROFILE_SECTION("ParticleMesh::take_speculation()");
+    const auto speculation = std::move(speculation_);
+    speculation->thread.join();
+    if (speculation->error) std::rethrow_exception(speculation->error);
+    if (speculation->radii.size() != particles.size()) return false;
+    const auto max_error = pow2(speculation_margin_ / 2);
+    std::atomic_bool valid = true;
+    par::for_each(particles.all(), [&](PV a) {
+      const auto index = a.index();
+      float64_t error{};
+      for (size_t i = 0; i < Dim; ++i) {
+        error += pow2(static_cast<float64_t>(r[a][i]) -
+                      speculation->positions[index, i]);
+      }
+      const auto radius =
+          static_cast<float64_t>(radius_func(a) + skin) + speculation_margin_;
+      if (error > max_error || radius > speculation->radii[index]) {
+        valid.store(false, std::memory_order_relaxed);
+      }
     });
+    TIT_STATS("ParticleMesh::speculation_valid", valid.load() ? 1 : 0);
+    if (!valid) return false;
+    adjacency_ = std::move(speculation->adjacency);
+    return true;
+  }
 
-    search_tasks.wait();
+  // Build the search index for the particle positions. If the search function
+  // can update the existing index, it is kept across the rebuilds in order to
+  // reuse its buffers. If the search function accepts the point radii, the
+  // index is built for the symmetric search.
+  template<particle_array ParticleArray, class SearchRadiusFunc>
+  auto build_search_index_(ParticleArray& particles,
+                           const SearchRadiusFunc& radius_func,
+                           particle_num_t<ParticleArray> skin)
+      -> const auto& {
+    const auto positions = r[particles];
+    using SearchIndex = decltype(search_func_(positions));
+    const auto radii = search_radii_(particles, radius_func, skin);
+    if constexpr (requires { search_func_(positions, radii); }) {
+      auto index =
+          std::make_shared<SearchIndex>(search_func_(positions, radii));
+      search_index_ = index;
+      return std::as_const(*index);
+    }
+    if constexpr (requires(SearchIndex& index) {
+                    search_func_.update(index, positions);
+                  }) {
+      if (search_index_ != nullptr) {
+        auto& index = *std::static_pointer_cast<SearchIndex>(search_index_);
+        search_func_.update(index, positions);
+        return std::as_const(index);
+      }
+    }
+    auto index = std::make_shared<SearchIndex>(search_func_(positions));
+    search_index_ = index;
+    return std::as_const(*index);
+  }
+
+  // Assemble the adjacency from the unique pairs found by the half-shell
+  // search, if the search index supports it and the search radius is the
+  // same for all the particles. Each particle is adjacent to itself.
+  template<class SearchIndex, class Radii>
+  auto search_pairs_(const SearchIndex& search_index, const Radii& radii)
+      -> bool {
+    using Pair = std::pair<Index, Index>;
+    if constexpr (requires(Multivector<Pair>& pairs) {
+                    search_index.search_pairs(radii[0], pairs);
+                  }) {
+      if (std::ranges::empty(radii)) return false;
+      const auto search_radius = par::max(radii);
+      if (par::min(radii) != search_radius) return false;
+      Multivector<Pair> pairs;
+      search_index.search_pairs(search_radius, pairs);
+      const auto num_particles = std::size(radii);
+      const auto pair_vals = pairs.values();
+      adjacency_.assign_pairs_par_tall(
+          num_particles,
+          std::views::iota(size_t{0}, num_particles + 2 * pair_vals.size()) |
+              std::views::transform([num_particles, pair_vals](size_t k) {
+                using Entry = std::pair<size_t, Index>;
+                if (k < num_particles) return Entry{k, static_cast<Index>(k)};
+                const auto [a, b] = pair_vals[(k - num_particles) / 2];
+                if ((k - num_particles) % 2 == 0) return Entry{a, b};
+                return Entry{b, a};
+              }));
+      return true;
+    } else return false;
+  }
+
+  // Search radii of the particles, extended by the skin width.
+  template<particle_array ParticleArray, class SearchRadiusFunc>
+  static auto search_radii_(ParticleArray& particles,
+                            const SearchRadiusFunc& radius_func,
+                            particle_num_t<ParticleArray> skin) {
+    return std::views::iota(size_t{0}, particles.size()) |
+           std::views::transform(
+               [&particles, &radius_func, skin](size_t index) {
+                 return radius_func(particles[index]) + skin;
+               });
   }
 
+  // Search index that was built for the particle positions.
   template<particle_array ParticleArray>
-  void partition_(ParticleArray& particles, size_t num_levels = 2) {
-    TIT_PROFILE_SECTION("ParticleMesh::partition()");
-    TIT_ASSERT(num_levels < PartVec::MaxNumLevels,
-               "Number of levels exceeds the predefined maximum!");
+  auto cached_search_index_(ParticleArray& particles) const -> const auto& {
+    const auto positions = r[particles];
+    using SearchIndex = decltype(search_func_(positions));
+    TIT_ASSERT(search_index_ != nullptr, "Search index is not built!");
+    return *std::static_pointer_cast<const SearchIndex>(search_index_);
+  }
 
-    // Initialize the partitioning.
-    const auto num_threads = par::num_threads();
-    const auto num_parts = num_levels * num_threads + 1;
+  // Report the memory used by the particles, the adjacency graphs and the
+  // search index to the profiler.
+  template<particle_array ParticleArray>
+  void track_memory_(ParticleArray& particles) const {
+    if (!Profiler::is_enabled()) return;
+    Profiler::track_memory("ParticleArray", particles.memory_usage());
+    Profiler::track_memory("ParticleMesh::adjacency",
+                           adjacency_.memory_usage());
+    Profiler::track_memory("ParticleMesh::interp_adjacency",
+                           interp_adjacency_.memory_usage() +
+                               interp_signatures_.capacity() *
+                                   sizeof(uint64_t));
+    Profiler::track_memory("ParticleMesh::block_edges",
+                           block_edges_.memory_usage() +
+                               pruned_block_edges_.memory_usage() +
+                               active_block_edges_.memory_usage() +
+                               final_blocks_.memory_usage() +
+                               final_block_.capacity() * sizeof(size_t));
+    Profiler::track_memory(
+        "ParticleMesh::caches",
+        last_positions_.memory_usage() + pair_cache_.memory_usage() +
+            interp_cache_.capacity() * sizeof(float64_t) +
+            interp_cache_valid_.capacity() * sizeof(uint8_t) +
+            culled_.capacity() * sizeof(uint8_t));
+    const auto& search_index = cached_search_index_(particles);
+    if constexpr (requires { search_index.memory_usage(); }) {
+      Profiler::track_memory("ParticleMesh::search_index",
+                             search_index.memory_usage());
+    }
+  }
+
+  // Fill the diagnostic fields that are present in the particle array, see
+  // `diagnostic_fields`. They are computed from the adjacency bucket sizes
+  // and the partition indices, so they cost a single pass.
+  template<particle_array ParticleArray>
+  void update_diagnostics_(ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+    if constexpr (has<ParticleArray>(num_neighbors)) {
+      par::for_each(particles.all(), [this](PV a) {
+        num_neighbors[a] = static_cast<uint32_t>(adjacency_[a.index()].size());
+      });
+    }
+    if constexpr (has<ParticleArray>(num_interp)) {
+      par::for_each(particles.all(), [&particles, this](PV a) {
+        if (!a.has_type(ParticleType::fixed)) {
+          num_interp[a] = 0;
+          return;
+        }
+        const auto i = particles.type_rank(a.index());
+        num_interp[a] = i < interp_adjacency_.size() ?
+                            static_cast<uint32_t>(interp_adjacency_[i].size()) :
+                            0;
+      });
+    }
+    if constexpr (has<ParticleArray>(block_load)) {
+      // Blocks of each level are processed together, so the block is only
+      // compared to the blocks of its level. Halo block is the last level.
+      const auto num_level_parts = par::num_parts();
+      const auto block_sizes = block_edges_.bucket_sizes();
+      std::vector<float64_t> avg_block_sizes(num_levels_ + 1);
+      for (size_t part = 0; part < block_sizes.size(); ++part) {
+        const auto level = std::min(part / num_level_parts, num_levels_);
+        avg_block_sizes[level] +=
+            static_cast<float64_t>(block_sizes[part]) /
+            static_cast<float64_t>(level < num_levels_ ? num_level_parts : 1);
+      }
+      par::for_each(particles.all(), [&, num_level_parts](PV a) {
+        const size_t part = parinfo[a].last();
+        if (part >= block_sizes.size()) {
+          block_load[a] = 0.0F;
+          return;
+        }
+        const auto level = std::min(part / num_level_parts, num_levels_);
+        block_load[a] = static_cast<float32_t>(
+            avg_block_sizes[level] > 0.0 ?
+                static_cast<float64_t>(block_sizes[part]) /
+                    avg_block_sizes[level] :
+                0.0);
+      });
+    }
+  }
+
+  // Index of the halo part, which is the last one.
+  auto halo_part_(size_t num_level_parts) const -> PartIndex {
+    const auto num_parts = num_levels_ * num_level_parts + 1;
     if (auto max_num_parts = std::numeric_limits<PartIndex>::max();
         num_parts >= max_num_parts) {
       TIT_THROW("Number of parts exceeded the limit of {}.", max_num_parts);
     }
+    return static_cast<PartIndex>(num_parts - 1);
+  }
+
+  // Reset the partitioning, and partition the particles on the first level.
+  // Unless the particles are weighted, the adjacency is not used, so the
+  // partitioning may run concurrently with the neighbor search.
+  template<particle_array ParticleArray>
+  void partition_first_level_(ParticleArray& particles, bool weighted) {
+    TIT_PROFILE_SECTION("ParticleMesh::partition_first_level()");
+    const auto num_level_parts = par::num_parts();
+    const auto halo_part = halo_part_(num_level_parts);
     const auto parts = parinfo[particles];
-    std::ranges::fill(parts, PartVec(static_cast<PartIndex>(num_parts - 1)));
+    std::ranges::fill(parts, PartVec(halo_part));
+    const auto positions = r[particles];
+    const auto level_parts =
+        parts |
+        std::views::transform([](PartVec& part) -> auto& { return part[0]; });
+
+    // Weight the particles by the neighbor counts, since the pair passes
+    // cost is proportional to it.
+    const auto weights =
+        std::views::iota(size_t{0}, particles.size()) |
+        std::views::transform(
+            [this](size_t a) { return adjacency_[a].size() + 1; });
+    if constexpr (requires {
+                    partition_func_(positions,
+                                    weights,
+                                    level_parts,
+                                    num_level_parts);
+                  }) {
+      if (weighted) {
+        partition_func_(positions, weights, level_parts, num_level_parts);
+      } else partition_func_(positions, level_parts, num_level_parts);
+    } else partition_func_(positions, level_parts, num_level_parts);
+
+    // Move the halo particles out of the interior blocks.
+    if (is_halo_) {
+      par::for_each(iota_perm(particles.all()),
+                    [level_parts, halo_part, this](size_t a) {
+                      if (is_halo_(a)) level_parts[a] = halo_part;
+                    });
+    }
+  }
+
+  // Partition the particles. If the first level partitioning is ready, see
+  // `partition_first_level_`, it is used as is.
+  template<particle_array ParticleArray>
+  void partition_(ParticleArray& particles,
+                  bool incremental,
+                  bool first_level_ready = false) {
+    TIT_PROFILE_SECTION("ParticleMesh::partition()");
+    const auto num_levels = num_levels_;
+
+    // Initialize the partitioning.
+    const auto num_level_parts = par::num_parts();
+    const auto halo_part = halo_part_(num_level_parts);
+    const auto num_parts = size_t{halo_part} + 1;
+    const auto parts = parinfo[particles];
+    if (incremental) {
+      // Keep the first level partitioning, it is rebalanced below.
+      par::for_each(parts, [halo_part](PartVec& part) {
+        const auto first_level_part = part[0];
+        part = PartVec(halo_part);
+        part[0] = first_level_part;
+      });
+    } else if (!first_level_ready) {
+      partition_first_level_(particles, weighted_);
+    }
+    num_migrated_ = 0;
 
     // Build the multi-level partitioning.
     const auto positions = r[particles];
-    static std::vector<size_t> interface{};
+    par::ArenaVector<size_t> interface{par::ArenaAllocator<size_t>{arena_}};
     for (size_t level = 0; level < num_levels; ++level) {
       const auto is_first_level = level == 0;
       const auto is_last_level = level == (num_levels - 1);
@@ -219,13 +1784,15 @@ private:
       const auto level_parts =
           parts | std::views::transform(
                       [level](PartVec& part) -> auto& { return part[level]; });
-      if (is_first_level) {
-        partition_func_(positions, level_parts, num_threads);
+      if (is_first_level && incremental) {
+        migrate_(particles, level_parts, num_level_parts, halo_part);
+      } else if (is_first_level) {
+        // First level is already partitioned above.
       } else {
         interface_partition_func_(permuted_view(positions, interface),
                                   permuted_view(level_parts, interface),
-                                  num_threads,
-                                  /*init_part=*/level * num_threads);
+                                  num_level_parts,
+                                  /*init_part=*/level * num_level_parts);
       }
 
       // Update the interface particles.
@@ -242,36 +1809,259 @@ private:
             par::copy_if(all_particles, interface.begin(), is_interface);
         interface.erase(not_interface_iter, interface.end());
       } else {
-        // Note: `std::ranges::partition` is faster than `std::erase_if`
-        //       because it does not preserve the order of the elements.
-        /// @todo Parallelize this code.
         const auto non_interface =
-            std::ranges::partition(interface, is_interface);
+            par::stable_partition(interface, is_interface);
         interface.erase(std::begin(non_interface), interface.end());
       }
     }
 
     // Assemble the block adjacency graph.
-    block_edges_.assign_pairs_par_wide(
+    final_blocks_valid_ = false;
+    block_edges_.assign_pairs_par(
         num_parts,
         adjacency_.transform_edges([parts](const auto& ab) {
           const auto [a, b] = ab;
           const auto part_ab = PartVec::common(parts[a], parts[b]);
           return std::pair{part_ab, ab};
         }));
+    if (tiling_enabled_) tile_block_edges_();
 
-    // Report the block sizes.
-    TIT_STATS("ParticleMesh::block_edges_", block_edges_.bucket_sizes());
+    // Update the block schedule. Particle may only be touched by the blocks
+    // of its partition indices.
+    block_schedule_.update(
+        num_parts,
+        parts | std::views::transform([](PartVec part) {
+          return std::views::iota(size_t{0}, PartVec::MaxNumLevels) |
+                 std::views::transform([part](size_t level) -> size_t {
+                   return part[level];
+                 });
+        }));
+
+    // Report the block sizes and compute the interior blocks imbalance.
+    const auto block_sizes = block_edges_.bucket_sizes();
+    TIT_STATS("ParticleMesh::block_edges_", block_sizes);
+    const auto interior_block_sizes =
+        block_sizes | std::views::take(num_level_parts);
+    const auto max_block_size = std::ranges::max(interior_block_sizes);
+    const auto avg_block_size =
+        static_cast<float64_t>(std::ranges::fold_left(interior_block_sizes,
+                                                      size_t{0},
+                                                      std::plus{})) /
+        static_cast<float64_t>(num_level_parts);
+    imbalance_ = avg_block_size > 0.0 ?
+                     static_cast<float64_t>(max_block_size) / avg_block_size :
+                     1.0;
+    TIT_STATS("ParticleMesh::imbalance_", imbalance_);
+    Metrics::set("ParticleMesh::imbalance", imbalance_);
+
+    // Report the number of levels against the size of the last block.
+    const auto total_size = std::ranges::fold_left(block_sizes,
+                                                   size_t{0},
+                                                   std::plus{});
+    serial_fraction_ =
+        total_size > 0 ? static_cast<float64_t>(block_sizes.back()) /
+                             static_cast<float64_t>(total_size) :
+                         0.0;
+    TIT_STATS("ParticleMesh::num_levels_", num_levels);
+    TIT_STATS("ParticleMesh::serial_fraction_", serial_fraction_);
+    Metrics::set("ParticleMesh::num_levels",
+                 static_cast<float64_t>(num_levels));
+    Metrics::set("ParticleMesh::serial_fraction", serial_fraction_);
+    Metrics::set("ParticleMesh::num_pairs",
+                 static_cast<float64_t>(num_pairs()));
+    Metrics::add("ParticleMesh::num_rebuilds");
+    last_num_level_parts_ = num_level_parts;
+  }
+
+  // Rebalance the reused first level partitioning by migrating the boundary
+  // particles from the overloaded interior blocks to the lighter neighboring
+  // ones. Particles are weighted by their neighbor counts. Same as in the
+  // label propagation, the candidate particles are selected in parallel, and
+  // then the moves that still reduce the imbalance are applied sequentially.
+  template<particle_array ParticleArray, class LevelParts>
+  void migrate_(ParticleArray& particles,
+                LevelParts level_parts,
+                size_t num_level_parts,
+                PartIndex halo_part) {
+    TIT_PROFILE_SECTION("ParticleMesh::migrate()");
+    const auto all_particles = iota_perm(particles.all());
+    const auto weight = [this](size_t a) { return adjacency_[a].size() + 1; };
+    const auto is_interior = [num_level_parts](PartIndex part) {
+      return part < num_level_parts;
+    };
+
+    // Move the halo particles out of the interior blocks.
+    if (is_halo_) {
+      par::for_each(all_particles, [level_parts, halo_part, this](size_t a) {
+        if (is_halo_(a)) level_parts[a] = halo_part;
+      });
+    }
+    const auto is_owned = [this](size_t a) {
+      return !is_halo_ || !is_halo_(a);
+    };
+
+    // Compute the interior block weights.
+    std::vector<size_t> block_weights(num_level_parts);
+    std::vector<size_t> thread_weights(par::num_threads() * num_level_parts);
+    par::static_for_each(all_particles, [&](size_t thread, size_t a) {
+      const PartIndex part = level_parts[a];
+      if (is_interior(part)) {
+        thread_weights[thread * num_level_parts + part] += weight(a);
+      }
+    });
+    for (size_t i = 0; i < thread_weights.size(); ++i) {
+      block_weights[i % num_level_parts] += thread_weights[i];
+    }
+
+    // Lightest interior block among the neighbors of the particle.
+    const auto lightest_neighbor_part = [&](size_t a) {
+      auto result = halo_part;
+      for (const size_t b : adjacency_[a]) {
+        const PartIndex part = level_parts[b];
+        if (!is_interior(part)) continue;
+        if (result == halo_part ||
+            block_weights[part] < block_weights[result]) {
+          result = part;
+        }
+      }
+      return result;
+    };
+
+    // Assign the former halo particles to the neighboring blocks.
+    par::ArenaVector<size_t> candidates{par::ArenaAllocator<size_t>{arena_}};
+    candidates.resize(particles.size());
+    candidates.erase(
+        par::copy_if(all_particles,
+                     candidates.begin(),
+                     [level_parts, &is_interior, &is_owned](size_t a) {
+                       return is_owned(a) && !is_interior(level_parts[a]);
+                     }),
+        candidates.end());
+    for (const auto a : candidates) {
+      auto part = lightest_neighbor_part(a);
+      if (part == halo_part) {
+        part = static_cast<PartIndex>(std::ranges::min_element(block_weights) -
+                                      block_weights.begin());
+      }
+      level_parts[a] = part;
+      block_weights[part] += weight(a);
+    }
+
+    // Migrate the boundary particles of the overloaded blocks.
+    constexpr size_t max_passes = 16; // Empirical value.
+    for (size_t pass = 0; pass < max_passes; ++pass) {
+      const auto total_weight =
+          std::ranges::fold_left(block_weights, size_t{0}, std::plus{});
+      const auto avg_weight = divide_up(total_weight, num_level_parts);
+
+      // Select the candidate particles.
+      candidates.resize(particles.size());
+      candidates.erase(
+          par::copy_if(all_particles,
+                       candidates.begin(),
+                       [&](size_t a) {
+                         const PartIndex part = level_parts[a];
+                         if (!is_interior(part)) return false;
+                         if (block_weights[part] <= avg_weight) return false;
+                         const auto target = lightest_neighbor_part(a);
+                         return target != halo_part && target != part &&
+                                block_weights[target] < block_weights[part];
+                       }),
+          candidates.end());
+      if (candidates.empty()) break;
+
+      // Apply the moves that still reduce the imbalance.
+      size_t num_moves = 0;
+      for (const auto a : candidates) {
+        const PartIndex part = level_parts[a];
+        if (block_weights[part] <= avg_weight) continue;
+        const auto target = lightest_neighbor_part(a);
+        if (target == halo_part || target == part) continue;
+        const auto particle_weight = weight(a);
+        if (block_weights[target] + 2 * particle_weight >
+            block_weights[part]) {
+          continue;
+        }
+        block_weights[part] -= particle_weight;
+        block_weights[target] += particle_weight;
+        level_parts[a] = target;
+        num_moves += 1;
+      }
+      num_migrated_ += num_moves;
+      if (num_moves == 0) break;
+    }
+    TIT_STATS("ParticleMesh::num_migrated_", num_migrated_);
+    Metrics::add("ParticleMesh::num_migrated",
+                 static_cast<float64_t>(num_migrated_));
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  graph::Graph adjacency_;
-  graph::Graph interp_adjacency_;
-  Multivector<std::pair<size_t, size_t>> block_edges_;
+  graph::BasicGraph<Index> adjacency_;
+  graph::BasicGraph<Index> interp_adjacency_;
+  std::vector<uint64_t> interp_signatures_;
+  Multivector<Edge> block_edges_;
+  Multivector<Edge> pruned_block_edges_;
+  bool pruning_enabled_ = false;
+  bool pruned_ = false;
+  Multivector<Edge> active_block_edges_;
+  bool active_ = false;
+  std::vector<size_t> final_block_;
+  Multivector<Index> final_blocks_;
+  bool final_blocks_valid_ = false;
+  std::vector<uint8_t> culled_;
+  size_t num_culled_ = 0;
+  bool culling_enabled_ = false;
   [[no_unique_address]] SearchFunc search_func_;
   [[no_unique_address]] PartitionFunc partition_func_;
   [[no_unique_address]] InterfacePartitionFunc interface_partition_func_;
+  float64_t skin_;
+  [[no_unique_address]] BlockSchedule block_schedule_;
+  Mdvector<float64_t, 2> last_positions_;
+  float64_t last_max_disp_ = 0.0;
+  bool valid_ = false;
+  size_t num_rebuilds_ = 0;
+  Mdvector<float64_t, 2> pair_cache_;
+  bool pair_cache_enabled_ = false;
+  bool pairs_cached_ = false;
+  std::vector<float64_t> interp_cache_;
+  std::vector<uint8_t> interp_cache_valid_;
+  bool interp_cache_enabled_ = false;
+  bool interp_cached_ = false;
+  bool interp_search_enabled_ = true;
+  bool aligned_layout_enabled_ = false;
+  Multivector<size_t> block_particles_;
+  bool tiling_enabled_ = false;
+  size_t tile_size_ = 512;
+  size_t prefetch_distance_ = 16;
+  float64_t max_imbalance_ = std::numeric_limits<float64_t>::infinity();
+  float64_t imbalance_ = 1.0;
+  bool weighted_ = false;
+  float64_t max_incremental_imbalance_ = 0.0;
+  size_t num_levels_ = 2;
+  float64_t serial_fraction_ = 0.0;
+  size_t last_num_level_parts_ = 0;
+  size_t num_migrated_ = 0;
+  std::function<bool(size_t)> is_halo_;
+  std::function<void()> halo_exchange_;
+  std::shared_ptr<void> search_index_;
+  bool listless_ = false;
+  par::Arena arena_;
+
+  // State of the speculative search. Thread is destroyed first, so that it
+  // is joined before the rest of the state.
+  struct Speculation_ final {
+    Mdvector<float64_t, 2> positions;
+    std::vector<float64_t> radii;
+    graph::BasicGraph<Index> adjacency;
+    std::exception_ptr error;
+    std::atomic_bool done = false;
+    std::jthread thread;
+  };
+  float64_t speculation_margin_ = 0.0;
+  size_t rebuild_interval_ = 0;
+  size_t steps_since_rebuild_ = 0;
+  std::unique_ptr<Speculation_> speculation_;
 
 }; // class ParticleMesh
 
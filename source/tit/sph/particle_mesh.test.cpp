@@ -0,0 +1,721 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <numbers>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/rand_utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/partition.hpp"
+#include "tit/geom/periodic_box.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the mesh.
+using MeshEquations = EquationsStub<meta::Set{sph::r, sph::h, sph::parinfo},
+                                    meta::Set{sph::r, sph::parinfo}>;
+
+TEST_CASE("sph::PartVec") {
+  // Ensure the partition indices beyond the 8-bit range are distinguished,
+  // as they are on the many-core nodes.
+  sph::PartVec a{1000};
+  sph::PartVec b{1000};
+  a[0] = 300;
+  b[0] = 301;
+  CHECK(a.last() == 300);
+  CHECK(sph::PartVec::common(a, b) == 1000);
+  b[0] = 300;
+  CHECK(sph::PartVec::common(a, b) == 300);
+}
+
+TEST_CASE("sph::ParticleMesh::set_max_incremental_imbalance") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+  constexpr double max_imbalance = 1.5;
+
+  // Setup the particles on a lattice.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 32; ++i) {
+    for (size_t j = 0; j < 32; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh. First rebuild is always the full one.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.set_max_incremental_imbalance(max_imbalance);
+  const auto update = [&mesh, &particles] {
+    mesh.update(particles, [](auto /*a*/) { return radius; });
+  };
+  update();
+  CHECK(mesh.num_migrated() == 0);
+  const auto first_level_parts = [&particles] {
+    std::vector<sph::PartIndex> result{};
+    for (const auto a : particles.all()) result.push_back(sph::parinfo[a][0]);
+    return result;
+  };
+  const auto init_parts = first_level_parts();
+  const auto num_changed = [&init_parts](const auto& parts) {
+    size_t result = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      if (parts[i] != init_parts[i]) result += 1;
+    }
+    return result;
+  };
+
+  SUBCASE("reused") {
+    // Partitioning is balanced, so it is mostly kept as is.
+    update();
+    CHECK(mesh.imbalance() <= max_imbalance);
+    CHECK(num_changed(first_level_parts()) < particles.size() / 20);
+  }
+
+  SUBCASE("rebalanced") {
+    // Overload the first block with the boundary layer of its neighbors.
+    for (const auto a : particles.all()) {
+      if (init_parts[a.index()] == 0) continue;
+      const auto is_boundary = std::ranges::any_of(mesh[a], [&](auto b) {
+        return init_parts[b.index()] == 0;
+      });
+      if (is_boundary) sph::parinfo[a][0] = 0;
+    }
+
+    // Boundary particles must be migrated back, and the rest are kept.
+    update();
+    CHECK(mesh.num_migrated() > 0);
+    CHECK(mesh.imbalance() <= max_imbalance);
+    CHECK(num_changed(first_level_parts()) < particles.size() / 5);
+  }
+
+  SUBCASE("invalidated") {
+    // Partitioning may not be reused after the mesh is invalidated.
+    mesh.invalidate();
+    update();
+    CHECK(mesh.num_migrated() == 0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::set_num_levels") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the particles on a lattice.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 32; ++i) {
+    for (size_t j = 0; j < 32; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Ensure that more levels leave fewer pairs to the last block, and that
+  // all of the pairs are kept.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  std::vector<double> serial_fractions{};
+  std::vector<size_t> num_pairs{};
+  for (size_t num_levels = 1; num_levels <= 3; ++num_levels) {
+    mesh.set_num_levels(num_levels);
+    REQUIRE(mesh.num_levels() == num_levels);
+    mesh.invalidate();
+    mesh.update(particles, [](auto /*a*/) { return radius; });
+    serial_fractions.push_back(mesh.serial_fraction());
+    num_pairs.push_back(mesh.num_pairs());
+  }
+  CHECK(serial_fractions[0] > 0.0);
+  CHECK(serial_fractions[1] < serial_fractions[0]);
+  CHECK(serial_fractions[2] <= serial_fractions[1]);
+  CHECK(std::ranges::all_of(num_pairs, [&num_pairs](size_t n) {
+    return n == num_pairs.front();
+  }));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::reorder") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the particles on a lattice in a scattered order.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t k = 0; k < 1024; ++k) {
+    const auto index = k * 389 % 1024;
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{static_cast<double>(index % 32),
+                    static_cast<double>(index / 32)};
+  }
+  sph::h[particles] = radius;
+
+  // Compute the maximal index distance between the adjacent particles.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  const auto bandwidth = [&mesh, &particles] {
+    mesh.update(particles, [](auto /*a*/) { return radius; });
+    size_t result = 0;
+    for (const auto [a, b] : mesh.pairs(particles)) {
+      const auto [i, j] = std::minmax(a.index(), b.index());
+      result = std::max(result, j - i);
+    }
+    return result;
+  };
+  const auto init_bandwidth = bandwidth();
+  const auto init_num_pairs = mesh.num_pairs();
+  REQUIRE(init_bandwidth > 512);
+
+  // Ensure the reordering localizes the neighbors, keeping the pairs.
+  mesh.reorder(particles);
+  CHECK_FALSE(mesh.valid());
+  CHECK(bandwidth() < 3 * 32);
+  CHECK(mesh.num_pairs() == init_num_pairs);
+}
+
+TEST_CASE("sph::ParticleMesh::align") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the particles on a lattice in a scattered order.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t k = 0; k < 1024; ++k) {
+    const auto index = k * 389 % 1024;
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{static_cast<double>(index % 32),
+                    static_cast<double>(index / 32)};
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  const auto num_pairs = mesh.num_pairs();
+
+  // Ensure the particles of each block are contiguous, and the blocks follow
+  // in order, keeping the pairs.
+  mesh.align(particles);
+  CHECK_FALSE(mesh.valid());
+  for (size_t i = 1; i < particles.size(); ++i) {
+    CHECK(sph::parinfo[particles[i - 1]].last() <=
+          sph::parinfo[particles[i]].last());
+  }
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  CHECK(mesh.num_pairs() == num_pairs);
+}
+
+TEST_CASE("sph::ParticleMesh::enable_tiling") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+  constexpr size_t tile_size = 64;
+
+  // Setup the particles on a lattice.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t index = 0; index < 1024; ++index) {
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{static_cast<double>(index % 32),
+                    static_cast<double>(index / 32)};
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh without and with the tiling.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  const auto num_pairs = mesh.num_pairs();
+  CHECK(mesh.prefetch_distance() == 0);
+  mesh.enable_tiling(true, tile_size, /*prefetch_distance=*/8);
+  CHECK_FALSE(mesh.valid());
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  CHECK(mesh.prefetch_distance() == 8);
+
+  // Ensure the pairs are kept, and the edges of each block are ordered by
+  // the tiles.
+  CHECK(mesh.num_pairs() == num_pairs);
+  CHECK(mesh.block_edge_values().size() == num_pairs);
+  const auto tile_key = [](const auto& ab) {
+    return std::pair{ab.first / tile_size, ab.second / tile_size};
+  };
+  for (const auto block : mesh.block_edges()) {
+    CHECK(std::ranges::is_sorted(block, {}, tile_key));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the speculative search.
+using MovingMeshEquations = EquationsStub<
+    meta::Set{sph::r, sph::v, sph::h, sph::parinfo},
+    meta::Set{sph::r, sph::parinfo}>;
+
+TEST_CASE("sph::ParticleMesh::speculate") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+  constexpr double margin = 0.5;
+  constexpr double dt = 1.0;
+  const auto radius_func = [](auto /*a*/) { return radius; };
+
+  // Setup the particles on a lattice, moving diagonally.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MovingMeshEquations{}};
+  for (size_t index = 0; index < 1024; ++index) {
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{static_cast<double>(index % 32),
+                    static_cast<double>(index / 32)};
+    sph::v[a] = Vec{0.1, 0.05 * static_cast<double>(index % 3)};
+  }
+  sph::h[particles] = radius;
+  const auto advance = [&particles] {
+    for (const auto a : particles.all()) sph::r[a] += dt * sph::v[a];
+  };
+
+  // Run a few steps. Speculative search is started after each rebuild
+  // except the first one, and its adjacency is taken on the next rebuild.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.enable_speculation(margin);
+  CHECK(mesh.speculation_margin() == margin);
+  for (size_t step = 0; step < 3; ++step) {
+    mesh.update(particles, radius_func);
+    mesh.speculate(particles, radius_func, dt);
+    advance();
+  }
+  mesh.update(particles, radius_func);
+
+  // Ensure all the neighbors are found, and the extra ones are within the
+  // radius extended by the margin.
+  const auto check_neighbors = [&particles, &mesh] {
+    sph::ParticleMesh reference_mesh{geom::GridSearch{radius}};
+    reference_mesh.update(particles, [](auto /*a*/) { return radius; });
+    for (const auto a : particles.all()) {
+      for (const auto b : reference_mesh[a]) {
+        CHECK(std::ranges::any_of(mesh[a], [b](auto c) {
+          return c.index() == b.index();
+        }));
+      }
+      for (const auto b : mesh[a]) {
+        CHECK(norm(sph::r[a, b]) <= radius + margin);
+      }
+    }
+  };
+  check_neighbors();
+
+  // Ensure the speculative adjacency is discarded if a particle strays from
+  // its prediction.
+  mesh.speculate(particles, radius_func, dt);
+  advance();
+  sph::r[particles[0]] += Vec{1.0, 1.0};
+  mesh.update(particles, radius_func);
+  check_neighbors();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::skin") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+  constexpr double skin = 0.5;
+
+  // Setup the particles on a jittered lattice, so that the pair distances
+  // are spread around the search radius.
+  SplitMix64 rng{/*seed=*/123};
+  const auto uniform = [&rng] {
+    return static_cast<double>(rng()) / static_cast<double>(SplitMix64::max());
+  };
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i) + 0.3 * uniform(),
+                      static_cast<double>(j) + 0.3 * uniform()};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh with the skin.
+  sph::ParticleMesh mesh{geom::GridSearch{radius},
+                         geom::RecursiveInertialBisection{},
+                         geom::RecursiveInertialBisection{},
+                         skin};
+  const auto update = [&mesh, &particles] {
+    mesh.update(particles, [](auto /*a*/) { return radius; });
+  };
+  update();
+  REQUIRE(mesh.num_rebuilds() == 1);
+  std::vector<Vec<double, 2>> init_positions{};
+  for (const auto a : particles.all()) init_positions.push_back(sph::r[a]);
+
+  // Move each particle in its own direction.
+  std::vector<Vec<double, 2>> directions{};
+  for (size_t i = 0; i < particles.size(); ++i) {
+    const auto angle = 2 * std::numbers::pi * uniform();
+    directions.emplace_back(std::cos(angle), std::sin(angle));
+  }
+  const auto drift = [&particles, &directions](double disp) {
+    for (const auto a : particles.all()) {
+      sph::r[a] += disp * directions[a.index()];
+    }
+  };
+
+  SUBCASE("within skin") {
+    // Particles moved within the skin, so the mesh is kept. Nevertheless, no
+    // pair within the search radius must be missing, including the ones
+    // that were farther apart on the rebuild.
+    drift(0.1);
+    update();
+    CHECK(mesh.num_rebuilds() == 1);
+    CHECK_APPROX_EQ(mesh.max_disp(), 0.1);
+    size_t num_new_pairs = 0;
+    for (const auto a : particles.all()) {
+      for (const auto b : particles.all()) {
+        if (a == b || norm(sph::r[a, b]) >= radius) continue;
+        CHECK(std::ranges::any_of(mesh[a], [b](auto c) { return c == b; }));
+        const auto init_dist =
+            norm(init_positions[a.index()] - init_positions[b.index()]);
+        if (init_dist >= radius) num_new_pairs += 1;
+      }
+    }
+    CHECK(num_new_pairs > 0);
+  }
+
+  SUBCASE("skin exhausted") {
+    // First displacement leaves half of the skin, since the particles that
+    // move towards each other close the gap twice as fast. Next update
+    // predicts the same displacement, which exhausts the skin.
+    drift(0.1);
+    update();
+    CHECK(mesh.num_rebuilds() == 1);
+    drift(0.1);
+    update();
+    CHECK(mesh.num_rebuilds() == 2);
+    CHECK(mesh.max_disp() == 0.0);
+
+    // Rebuilt mesh is kept again while the particles stay within the skin.
+    drift(0.1);
+    update();
+    CHECK(mesh.num_rebuilds() == 2);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::periodic") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the particles on a lattice, with the first column shifted by one
+  // period, so that it must be wrapped back into the box.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i == 0 ? 16 : i) + 0.5,
+                      static_cast<double>(j) + 0.5};
+    }
+  }
+  sph::h[particles] = radius;
+  particles.set_periodic_box(
+      geom::PeriodicBox{geom::BBox{Vec{0.0, 0.0}, Vec{16.0, 16.0}},
+                        VecMask<double, 2>{true, false}});
+
+  // Build the mesh. Particles must be wrapped, and only the bottom and the
+  // top rows must have the neighbors missing.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  for (const auto a : particles.all()) {
+    CHECK(sph::r[a][0] >= 0.0);
+    CHECK(sph::r[a][0] < 16.0);
+    const auto y = sph::r[a][1];
+    const auto num_neighbors = y < 1.0 || y > 15.0 ? 6 : 9;
+    CHECK(std::ranges::distance(mesh[a]) == num_neighbors);
+  }
+
+  // Position deltas across the box faces must be the minimum images.
+  for (const auto [a, b] : mesh.pairs(particles)) {
+    CHECK(norm(sph::r[a, b]) < radius);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::prune") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the particles on a lattice and build the mesh.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.enable_pruning();
+  mesh.update(particles, [](auto /*a*/) { return radius; });
+  const auto init_num_pairs = mesh.num_pairs();
+
+  // Stretch the lattice, so that the diagonal pairs are out of the radius.
+  const auto stretch = [&particles, &mesh](double factor) {
+    for (const auto a : particles.all()) sph::r[a] *= factor;
+    mesh.prune(particles, [](auto /*a*/) { return radius; });
+  };
+  stretch(1.2);
+  size_t num_pairs = 0;
+  for (const auto& block : mesh.block_edges()) {
+    for (const auto [a, b] : block) {
+      CHECK(norm(sph::r[particles[a], particles[b]]) <= radius);
+      num_pairs += 1;
+    }
+  }
+  CHECK(num_pairs == mesh.num_pairs());
+  CHECK(num_pairs == std::ranges::count_if(
+                         mesh.pairs(particles),
+                         [](const auto& ab) {
+                           const auto [a, b] = ab;
+                           return norm(sph::r[a, b]) <= radius;
+                         }));
+  CHECK(num_pairs < init_num_pairs);
+
+  // Pruned pairs must come back once the particles move back.
+  stretch(1.0 / 1.2);
+  CHECK(mesh.num_pairs() == init_num_pairs);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::interp_cache") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the fluid particles on a lattice, with a row of the fixed particles
+  // below it.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    const auto a = particles.append(sph::ParticleType::fixed);
+    sph::r[a] = Vec{static_cast<double>(i), -1.0};
+    for (size_t j = 0; j < 16; ++j) {
+      const auto b = particles.append(sph::ParticleType::fluid);
+      sph::r[b] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh, with the ghost points mirrored above the fixed particles.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.enable_interp_cache();
+  const auto update = [&mesh, &particles] {
+    mesh.update(
+        particles,
+        [](auto /*a*/) { return radius; },
+        [](auto a) { return Vec{sph::r[a][0], -sph::r[a][1]}; });
+  };
+  update();
+  CHECK_FALSE(mesh.interp_cached());
+
+  // Cache the uniform weights, with the interpolation failing for the first
+  // fixed particle.
+  const auto first = *particles.fixed().begin();
+  mesh.cache_interp(particles, [first](auto a, auto weights) {
+    if (a == first) return false;
+    std::ranges::fill(weights, 1.0 / static_cast<double>(weights.size()));
+    return true;
+  });
+  REQUIRE(mesh.interp_cached());
+  CHECK(mesh.interp_weights(first).empty());
+  for (const auto a : particles.fixed() | std::views::drop(1)) {
+    const auto weights = mesh.interp_weights(a);
+    REQUIRE(weights.size() == std::ranges::size(mesh.fixed_interp(a)));
+    CHECK_FALSE(weights.empty());
+    CHECK(std::ranges::fold_left(weights, 0.0, std::plus{}) ==
+          doctest::Approx(1.0));
+  }
+
+  // Cache must be dropped once the interpolation points are searched again.
+  mesh.invalidate();
+  CHECK_FALSE(mesh.interp_cached());
+  update();
+  CHECK_FALSE(mesh.interp_cached());
+}
+
+TEST_CASE("sph::ParticleMesh::enable_interp_search") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.5;
+
+  // Setup the fluid particles on a lattice, with a row of the fixed particles
+  // below it.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    const auto a = particles.append(sph::ParticleType::fixed);
+    sph::r[a] = Vec{static_cast<double>(i), -1.0};
+    for (size_t j = 0; j < 16; ++j) {
+      const auto b = particles.append(sph::ParticleType::fluid);
+      sph::r[b] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh with the search disabled. Fixed particles must have no
+  // interpolation points, but must still have their neighbors.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  const auto update = [&mesh, &particles] {
+    mesh.update(
+        particles,
+        [](auto /*a*/) { return radius; },
+        [](auto a) { return Vec{sph::r[a][0], -sph::r[a][1]}; });
+  };
+  mesh.enable_interp_search(false);
+  update();
+  for (const auto a : particles.fixed()) {
+    CHECK(std::ranges::empty(mesh.fixed_interp(a)));
+    CHECK_FALSE(std::ranges::empty(mesh[a]));
+  }
+
+  // Re-enabling the search must invalidate the mesh, so that the points are
+  // found on the next update.
+  mesh.enable_interp_search();
+  CHECK_FALSE(mesh.valid());
+  update();
+  for (const auto a : particles.fixed()) {
+    CHECK_FALSE(std::ranges::empty(mesh.fixed_interp(a)));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh::enable_culling") {
+  par::set_num_threads(4);
+  constexpr double radius = 0.9;
+
+  // Setup the fluid particles on a lattice, with four layers of the fixed
+  // particles below it. Only the two upper layers are within `RADIUS_SCALE`
+  // search radii of the fluid.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, MeshEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 1; j <= 4; ++j) {
+      const auto a = particles.append(sph::ParticleType::fixed);
+      sph::r[a] = Vec{static_cast<double>(i), -static_cast<double>(j)};
+    }
+    for (size_t j = 0; j < 8; ++j) {
+      const auto b = particles.append(sph::ParticleType::fluid);
+      sph::r[b] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.enable_culling();
+  const auto update = [&mesh, &particles] {
+    mesh.update(
+        particles,
+        [](auto /*a*/) { return radius; },
+        [](auto a) { return Vec{sph::r[a][0], -sph::r[a][1]}; });
+  };
+  update();
+  const auto num_pairs = mesh.num_pairs();
+
+  // Deep wall particles must be culled, and excluded from the adjacency,
+  // the block pairs and the interpolation points.
+  REQUIRE(mesh.num_culled() == 32);
+  for (const auto a : particles.all()) {
+    const auto is_deep = sph::r[a][1] < -2.5;
+    CHECK(mesh.culled(a) == is_deep);
+    if (is_deep) {
+      CHECK(std::ranges::empty(mesh[a]));
+      CHECK(std::ranges::empty(mesh.fixed_interp(a)));
+    } else if (a.is_fixed()) {
+      CHECK_FALSE(std::ranges::empty(mesh.fixed_interp(a)));
+    }
+  }
+  for (const auto& block : mesh.block_edges()) {
+    for (const auto [a, b] : block) {
+      CHECK_FALSE(mesh.culled(particles[a]));
+      CHECK_FALSE(mesh.culled(particles[b]));
+    }
+  }
+
+  // Culled particles must come back once the culling is disabled.
+  mesh.enable_culling(false);
+  update();
+  CHECK(mesh.num_culled() == 0);
+  CHECK(mesh.num_pairs() > num_pairs);
+  for (const auto a : particles.all()) CHECK_FALSE(mesh.culled(a));
+}
+
+TEST_CASE("sph::ParticleMesh::diagnostic_fields") {
+  par::set_num_threads(4);
+  constexpr double radius = 1.1;
+
+  // Setup the fluid particles on a lattice, with a layer of the fixed
+  // particles below it.
+  sph::ParticleArray particles{
+      sph::Space<double, 2>{},
+      sph::WithFields{MeshEquations{}, sph::diagnostic_fields}};
+  for (size_t i = 0; i < 16; ++i) {
+    const auto a = particles.append(sph::ParticleType::fixed);
+    sph::r[a] = Vec{static_cast<double>(i), -1.0};
+    for (size_t j = 0; j < 16; ++j) {
+      const auto b = particles.append(sph::ParticleType::fluid);
+      sph::r[b] = Vec{static_cast<double>(i), static_cast<double>(j)};
+    }
+  }
+  sph::h[particles] = radius;
+
+  // Build the mesh.
+  sph::ParticleMesh mesh{geom::GridSearch{radius}};
+  mesh.update(
+      particles,
+      [](auto /*a*/) { return radius; },
+      [](auto a) { return Vec{sph::r[a][0], -sph::r[a][1]}; });
+
+  // Neighbor counts and stencil sizes must match the adjacency.
+  for (const auto a : particles.all()) {
+    CHECK(sph::num_neighbors[a] == std::ranges::size(mesh[a]));
+    if (a.is_fixed()) {
+      CHECK(sph::num_interp[a] == std::ranges::size(mesh.fixed_interp(a)));
+      CHECK(sph::num_interp[a] > 0);
+    } else {
+      CHECK(sph::num_interp[a] == 0);
+    }
+  }
+
+  // Loads of the first level blocks must average to one.
+  std::map<sph::PartIndex, float32_t> first_level_loads;
+  for (const auto a : particles.all()) {
+    const auto part = sph::parinfo[a].last();
+    CHECK(sph::block_load[a] >= 0.0F);
+    if (part < par::num_parts()) first_level_loads[part] = sph::block_load[a];
+  }
+  REQUIRE(first_level_loads.size() == par::num_parts());
+  CHECK(std::ranges::fold_left(first_level_loads | std::views::values,
+                               0.0F,
+                               std::plus{}) ==
+        doctest::Approx(static_cast<double>(par::num_parts())));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
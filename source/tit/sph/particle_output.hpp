@@ -0,0 +1,133 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/uint_utils.hpp"
+
+#include "tit/sph/field.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Particle output schedule.
+///
+/// Only the selected fields are written, the rest of the particle fields,
+/// e.g. the scratch fields of the equations, are never touched. Each of the
+/// selected fields is written with its own interval, so that the fields
+/// that are rarely needed do not take up most of the output bytes. Particles
+/// may also be subsampled, to produce the lightweight preview outputs.
+///
+/// @tparam Fields Fields that may be written. Fields that are not present in
+///                the particle array are ignored.
+template<field_set Fields>
+class ParticleOutput final {
+public:
+
+  /// Set of particle fields that may be written.
+  static constexpr Fields fields{};
+
+  /// Construct a particle output schedule.
+  ///
+  /// @param interval Output interval for all of the fields, in steps.
+  constexpr explicit ParticleOutput(Fields /*fields*/,
+                                    size_t interval = 1) noexcept {
+    intervals_.fill(interval);
+  }
+
+  /// Output interval of the field, in steps. Zero means that the field is
+  /// never written.
+  template<field Field>
+  constexpr auto interval(Field /*field*/) const noexcept -> size_t {
+    static_assert(fields.contains(Field{}));
+    return intervals_[fields.find(Field{})];
+  }
+
+  /// Set the output interval of the field, in steps.
+  template<field Field>
+  constexpr auto set_interval(Field /*field*/, size_t interval) noexcept
+      -> ParticleOutput& {
+    static_assert(fields.contains(Field{}));
+    intervals_[fields.find(Field{})] = interval;
+    return *this;
+  }
+
+  /// Particle subsampling stride: each `stride`-th particle is written.
+  constexpr auto stride() const noexcept -> size_t {
+    return stride_;
+  }
+
+  /// Set the particle subsampling stride.
+  constexpr auto set_stride(size_t stride) noexcept -> ParticleOutput& {
+    TIT_ASSERT(stride > 0, "Stride must be positive!");
+    stride_ = stride;
+    return *this;
+  }
+
+  /// Number of the particles written out of the given number.
+  constexpr auto num_written(size_t num_particles) const noexcept -> size_t {
+    return divide_up(num_particles, stride_);
+  }
+
+  /// Check if the field should be written on the step.
+  template<field Field>
+  constexpr auto is_due(Field field, size_t step) const noexcept -> bool {
+    const auto field_interval = interval(field);
+    return field_interval != 0 && step % field_interval == 0;
+  }
+
+  /// Check if any of the fields should be written on the step.
+  constexpr auto is_any_due(size_t step) const noexcept -> bool {
+    return std::ranges::any_of(intervals_, [step](size_t field_interval) {
+      return field_interval != 0 && step % field_interval == 0;
+    });
+  }
+
+private:
+
+  static constexpr auto num_fields_ =
+      fields.apply([](auto... field) { return sizeof...(field); });
+
+  std::array<size_t, num_fields_> intervals_{};
+  size_t stride_ = 1;
+
+}; // class ParticleOutput
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Order of the written particles by their persistent identifiers.
+///
+/// Particles are written in their current order, which changes between the
+/// time steps, so the readers that track the particles apply the order to
+/// the varying arrays of a time step, e.g. with `permuted_view`, instead of
+/// the simulation re-sorting the particles before each output.
+///
+/// @param ids Identifiers of the written particles, see `id`.
+///
+/// @returns Permutation, such that `ids[order[i]]` are ascending.
+template<std::ranges::random_access_range IDs>
+  requires std::ranges::sized_range<IDs>
+auto id_order(const IDs& ids) -> std::vector<size_t> {
+  std::vector<size_t> order(std::size(ids));
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::ranges::sort(order, std::less{}, [&ids](size_t index) {
+    return std::ranges::begin(ids)[index];
+  });
+  return order;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,274 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Particle field probes.
+///
+/// Probes are the fixed sample points, at which the particle fields are
+/// interpolated, e.g. to monitor the pressure at the sensors, without
+/// writing out the whole particle array. Fields are interpolated from the
+/// fluid particles with the Shepard-normalized SPH kernel of the given
+/// width, and the neighbors of the sample points are found through the
+/// search index of the particle mesh, so each sample costs a few neighbor
+/// lookups per point.
+///
+/// Samples are buffered in memory, and written into the data series in
+/// batches, as a single time step per batch: uniform arrays `probe_points`
+/// and `probe_times` hold the sample points and the sample times, and each
+/// varying array holds the field values of all the samples, sample-major,
+/// i.e. `values[sample * num_points + point]`.
+///
+/// @tparam Fields Fields that are interpolated.
+template<class Num, size_t Dim, field_set Fields, kernel Kernel>
+class ParticleProbes final {
+public:
+
+  /// Set of particle fields that are interpolated.
+  static constexpr Fields fields{};
+
+  /// Sample point type.
+  using Point = Vec<Num, Dim>;
+
+  /// Construct the particle probes.
+  ///
+  /// @param kernel Smoothing kernel used for the interpolation.
+  /// @param width  Smoothing kernel width used for the interpolation,
+  ///               typically the particle width.
+  constexpr ParticleProbes(Space<Num, Dim> /*space*/,
+                           Fields /*fields*/,
+                           Kernel kernel,
+                           Num width) noexcept
+      : kernel_{std::move(kernel)}, width_{width} {
+    TIT_ASSERT(width_ > Num{0.0}, "Kernel width must be positive!");
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Sample points.
+  constexpr auto points() const noexcept -> std::span<const Point> {
+    return points_;
+  }
+
+  /// Number of the sample points.
+  constexpr auto num_points() const noexcept -> size_t {
+    return points_.size();
+  }
+
+  /// Add a single sample point.
+  ///
+  /// @returns Range of the added point indices.
+  constexpr auto add_point(const Point& point) {
+    return add_points_(1, [&point](size_t /*i*/) { return point; });
+  }
+
+  /// Add the evenly spaced sample points on a line segment, including
+  /// the segment ends.
+  ///
+  /// @returns Range of the added point indices.
+  constexpr auto add_line(const Point& from,
+                          const Point& to,
+                          size_t num_points) {
+    TIT_ASSERT(num_points >= 2, "Line must have at least two points!");
+    const auto step = (to - from) / static_cast<Num>(num_points - 1);
+    return add_points_(num_points, [&from, &step](size_t i) {
+      return from + static_cast<Num>(i) * step;
+    });
+  }
+
+  /// Add the sample points on a regular grid over a parallelogram, that is
+  /// spanned by the two edge vectors from the origin, including the edges.
+  ///
+  /// @returns Range of the added point indices, the second edge direction
+  ///          is the fastest.
+  constexpr auto add_plane(const Point& origin,
+                           const Point& edge_1,
+                           const Point& edge_2,
+                           size_t num_points_1,
+                           size_t num_points_2) {
+    TIT_ASSERT(num_points_1 >= 2 && num_points_2 >= 2,
+               "Plane must have at least two points along each edge!");
+    const auto step_1 = edge_1 / static_cast<Num>(num_points_1 - 1);
+    const auto step_2 = edge_2 / static_cast<Num>(num_points_2 - 1);
+    return add_points_(
+        num_points_1 * num_points_2,
+        [&origin, &step_1, &step_2, num_points_2](size_t i) {
+          return origin + static_cast<Num>(i / num_points_2) * step_1 +
+                 static_cast<Num>(i % num_points_2) * step_2;
+        });
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Number of the buffered samples.
+  constexpr auto num_samples() const noexcept -> size_t {
+    return times_.size();
+  }
+
+  /// Times of the buffered samples.
+  constexpr auto times() const noexcept -> std::span<const real_t> {
+    return times_;
+  }
+
+  /// Field values of the buffered samples, sample-major.
+  template<field Field>
+  constexpr auto values(Field /*field*/) const noexcept
+      -> std::span<const field_value_t<Field, Space<Num, Dim>>> {
+    static_assert(fields.contains(Field{}));
+    return std::get<fields.find(Field{})>(values_);
+  }
+
+  /// Interpolate the particle fields at the sample points, and buffer
+  /// the sample. Points with no fluid particles nearby get zero values.
+  ///
+  /// @note Particle mesh must be up to date with the particle positions.
+  template<particle_mesh ParticleMesh, particle_array ParticleArray>
+    requires (ParticleArray::fields.includes(meta::Set{r, m, rho})) &&
+             (ParticleArray::fields.includes(Fields{}))
+  void sample(real_t time,
+              const ParticleMesh& mesh,
+              ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleProbes::sample()");
+    using PV = ParticleView<ParticleArray>;
+    const auto first = times_.size() * points_.size();
+    times_.push_back(time);
+    std::apply(
+        [size = first + points_.size()](auto&... vals) {
+          (vals.resize(size), ...);
+        },
+        values_);
+    const auto w = kernel_.template bind<Dim>(width_);
+    const auto radius = kernel_.radius(width_);
+    par::for_each(
+        std::views::iota(size_t{0}, points_.size()),
+        [&w, &mesh, &particles, first, radius, this](size_t i) {
+          const auto& x = points_[i];
+          Num sum_weights{0.0};
+          Values_ sums{};
+          mesh.for_each_near(
+              particles,
+              x,
+              radius,
+              [&w, &particles, &x, &sum_weights, &sums](PV b) {
+                if (!b.is_fluid()) return;
+                const auto x_b = particles.wrap_delta(r, x - r[b]);
+                const auto weight = m[b] / rho[b] * w(x_b);
+                sum_weights += weight;
+                fields.for_each([&sums, b, weight](auto field) {
+                  using Field = decltype(field);
+                  using Value = field_value_t<Field, Space<Num, Dim>>;
+                  std::get<fields.find(Field{})>(sums) +=
+                      weight * field_cast<Value>(field[b]);
+                });
+              });
+          if (is_tiny(sum_weights)) return;
+          fields.for_each([&sums, sum_weights, first, i, this](auto field) {
+            constexpr auto index = fields.find(decltype(field){});
+            std::get<index>(values_)[first + i] =
+                std::get<index>(sums) / sum_weights;
+          });
+        });
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Write the buffered samples into a data series as a single time step,
+  /// and clear the buffer. Nothing is written if there are no samples.
+  void write(data::DataSeriesView<data::DataStorage> series) {
+    if (times_.empty()) return;
+    auto transaction = series.storage().transaction();
+    write_(series.create_time_step(times_.back()));
+    transaction.commit();
+    clear();
+  }
+
+  /// Snapshot the buffered samples and write them into a data series in
+  /// background, and clear the buffer. Nothing is written if there are no
+  /// samples.
+  void write(data::DataWriter& writer) {
+    if (times_.empty()) return;
+    auto snapshot = writer.acquire(times_.back());
+    write_(*snapshot);
+    writer.submit(std::move(snapshot));
+    clear();
+  }
+
+  /// Clear the buffered samples.
+  void clear() noexcept {
+    times_.clear();
+    std::apply([](auto&... vals) { (vals.clear(), ...); }, values_);
+  }
+
+private:
+
+  // Add the sample points, computed by the function of the point index.
+  template<class PointFunc>
+  constexpr auto add_points_(size_t count, const PointFunc& point_func) {
+    TIT_ASSERT(times_.empty(),
+               "Sample points cannot be added while samples are buffered!");
+    const auto first = points_.size();
+    for (size_t i = 0; i < count; ++i) points_.push_back(point_func(i));
+    return std::views::iota(first, points_.size());
+  }
+
+  // Write the buffered samples into a time step or its snapshot.
+  template<class TimeStep>
+  void write_(TimeStep&& time_step) const {
+    TIT_ASSUME_UNIVERSAL(TimeStep, time_step);
+    auto&& uniforms = time_step.uniforms();
+    uniforms.create_array("probe_points", std::span{points_});
+    uniforms.create_array("probe_times", std::span{times_});
+    auto&& varyings = time_step.varyings();
+    fields.for_each([&varyings, this](auto field) {
+      varyings.create_array(field.field_name, values(field));
+    });
+  }
+
+  using Values_ = decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+    return std::tuple<field_value_t<Fs, Space<Num, Dim>>...>{};
+  }(fields));
+
+  using Buffers_ = decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+    return std::tuple<std::vector<field_value_t<Fs, Space<Num, Dim>>>...>{};
+  }(fields));
+
+  Kernel kernel_;
+  Num width_;
+  std::vector<Point> points_;
+  std::vector<real_t> times_;
+  Buffers_ values_;
+
+}; // class ParticleProbes
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
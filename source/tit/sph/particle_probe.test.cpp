@@ -0,0 +1,113 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_probe.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the probes.
+using ProbeEquations = EquationsStub<
+    meta::Set{sph::r, sph::h, sph::parinfo, sph::m, sph::rho, sph::p, sph::v},
+    meta::Set{sph::r, sph::parinfo, sph::p, sph::v}>;
+
+TEST_CASE("sph::ParticleProbes") {
+  constexpr double width = 1.0;
+  const sph::CubicSplineKernel kernel{};
+
+  // Setup the particles on a lattice, with the pressure being constant,
+  // and the velocity being linear.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, ProbeEquations{}};
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = Vec{static_cast<double>(i), static_cast<double>(j)};
+      sph::v[a] = sph::r[a];
+      sph::p[a] = 3.0;
+    }
+  }
+  sph::h[particles] = width;
+  sph::m[particles] = 1.0;
+  sph::rho[particles] = 1.0;
+  sph::ParticleMesh mesh{geom::GridSearch{kernel.radius(width)}};
+  mesh.update(particles, [&kernel](auto a) {
+    return kernel.radius(sph::h[a]);
+  });
+
+  // Setup the probes.
+  sph::ParticleProbes probes{sph::Space<double, 2>{},
+                             meta::Set{sph::p, sph::v},
+                             kernel,
+                             width};
+  const auto point = probes.add_point(Vec{7.0, 7.0});
+  const auto line = probes.add_line(Vec{6.0, 8.0}, Vec{10.0, 8.0}, 3);
+  const auto plane =
+      probes.add_plane(Vec{5.0, 5.0}, Vec{2.0, 0.0}, Vec{0.0, 4.0}, 2, 3);
+  const auto outside = probes.add_point(Vec{100.0, 100.0});
+  REQUIRE(probes.num_points() == 10);
+  CHECK(point.front() == 0);
+  CHECK(line.front() == 1);
+  CHECK(all(probes.points()[line[1]] == Vec{8.0, 8.0}));
+  CHECK(plane.front() == 4);
+  CHECK(all(probes.points()[plane[4]] == Vec{7.0, 7.0}));
+  CHECK(outside.front() == 9);
+
+  // Sample the fields.
+  probes.sample(0.0, mesh, particles);
+  probes.sample(1.0, mesh, particles);
+  REQUIRE(probes.num_samples() == 2);
+  const auto p_values = probes.values(sph::p);
+  const auto v_values = probes.values(sph::v);
+  REQUIRE(p_values.size() == 20);
+  for (size_t s = 0; s < 2; ++s) {
+    for (size_t i = 0; i < 9; ++i) {
+      const auto index = s * probes.num_points() + i;
+      CHECK_APPROX_EQ(p_values[index], 3.0);
+      CHECK(approx_equal_to(v_values[index], probes.points()[i]));
+    }
+    CHECK(p_values[s * probes.num_points() + 9] == 0.0);
+  }
+
+  // Write the samples.
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  probes.write(series);
+  CHECK(probes.num_samples() == 0);
+  const auto step = series.last_time_step();
+  CHECK(step.time() == 1.0);
+  const auto times = step.uniforms().find_array("probe_times");
+  REQUIRE(times.has_value());
+  CHECK(times->template data<real_t>().size() == 2);
+  const auto pressures = step.varyings().find_array("p");
+  REQUIRE(pressures.has_value());
+  CHECK(pressures->size() == 20);
+
+  // Nothing is written without samples.
+  probes.write(series);
+  CHECK(series.num_time_steps() == 1);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
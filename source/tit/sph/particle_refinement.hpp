@@ -0,0 +1,214 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Adaptive particle refinement.
+///
+/// Fluid particles on or near the free surface, or near the walls, are split
+/// into the `2^Dim` children, placed on the lattice around the parent, until
+/// the minimum mass is reached. Fluid particles in the calm regions are
+/// merged pairwise with their nearest neighbors, until the maximum mass is
+/// reached. Both the operations conserve mass and momentum.
+///
+/// Particles are classified using the free surface flag `FS`, computed by
+/// the particle shifting: particles that have the maximal value of the flag
+/// are far from both the free surface and the walls, and are considered calm.
+/// Particle widths must be varying, and the particle mesh must be updated
+/// using the particle widths, so that the neighbor search radius follows the
+/// particle resolution.
+template<class Num>
+class ParticleRefinement final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v, m, rho, h, FS};
+
+  /// Construct a particle refinement.
+  ///
+  /// @param max_mass   Maximum particle mass, typically the mass of the
+  ///                   particles at the initial resolution.
+  /// @param num_levels Number of the refinement levels. Particles are split
+  ///                   at most this many times.
+  constexpr explicit ParticleRefinement(Num max_mass, size_t num_levels = 1)
+      : max_mass_{max_mass}, num_levels_{num_levels} {
+    TIT_ASSERT(max_mass_ > Num{0}, "Maximum mass must be positive!");
+    TIT_ASSERT(num_levels_ > 0, "Number of levels must be positive!");
+  }
+
+  /// Maximum particle mass.
+  constexpr auto max_mass() const noexcept -> Num {
+    return max_mass_;
+  }
+
+  /// Number of the refinement levels.
+  constexpr auto num_levels() const noexcept -> size_t {
+    return num_levels_;
+  }
+
+  /// Split and merge the fluid particles.
+  ///
+  /// Particle mesh must be up to date, it is invalidated if any particles were
+  /// split or merged.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void update(ParticleMesh& mesh, ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleRefinement::update()");
+    using PV = ParticleView<ParticleArray>;
+    constexpr auto Dim = particle_dim_v<ParticleArray>;
+    constexpr size_t num_children = size_t{1} << Dim;
+    static_assert(!has_uniform<ParticleArray>(m) &&
+                      !has_uniform<ParticleArray>(h),
+                  "Particle masses and widths must be varying!");
+    if (particles.fluid().empty()) return;
+
+    // Masses are compared with a small tolerance, so that the particles that
+    // were split and merged back are not affected by the rounding errors.
+    static constexpr Num tol{1.0e-3};
+    const auto min_mass =
+        max_mass_ / pow(static_cast<Num>(num_children),
+                        static_cast<Num>(num_levels_));
+    const auto split_mass = (1 - tol) * num_children * min_mass;
+    const auto merge_mass = (1 + tol) * max_mass_;
+
+    // Classify the particles: calm particles have the maximal value of the
+    // free surface flag, all the other fluid particles are near the free
+    // surface or the walls.
+    const auto FS_far = par::max(particles.all(), [](PV a) { return FS[a]; });
+    const auto is_calm = [FS_far](PV a) {
+      return bitwise_equal(FS[a], FS_far);
+    };
+
+    // Match the calm particles that can be merged: each particle proposes its
+    // nearest calm neighbor, and the mutual proposals form the merged pairs.
+    // Matching is done before the splitting, since it uses the particle mesh.
+    static constexpr auto none = std::numeric_limits<size_t>::max();
+    static thread_local std::vector<size_t> proposals_buffer{};
+    auto& proposals = proposals_buffer;
+    proposals.assign(particles.size(), none);
+    par::for_each(
+        particles.fluid(),
+        [&proposals, &mesh, &is_calm, merge_mass](PV a) {
+          if (!is_calm(a)) return;
+          std::optional<PV> nearest{};
+          for (const PV b : mesh[a]) {
+            if (!b.has_type(ParticleType::fluid) || !is_calm(b)) continue;
+            if (m[a] + m[b] > merge_mass) continue;
+            if (!nearest || norm2(r[a, b]) < norm2(r[a, *nearest])) {
+              nearest = b;
+            }
+          }
+          if (nearest) proposals[a.index()] = nearest->index();
+        });
+    static thread_local std::vector<size_t> victims{};
+    victims.clear();
+    for (const PV a : particles.fluid()) {
+      const auto b = proposals[a.index()];
+      if (b != none && a.index() < b && proposals[b] == a.index()) {
+        victims.push_back(b);
+      }
+    }
+
+    // Merge the pairs: the first particle of the pair takes the total mass
+    // and the mass-weighted position and velocity of the pair, and its width
+    // is scaled with the mass.
+    par::for_each(victims, [&proposals, &particles](size_t victim) {
+      const auto b = particles[victim];
+      const auto a = particles[proposals[victim]];
+      const auto m_ab = m[a] + m[b];
+      const auto w_a = m[a] / m_ab;
+      const auto w_b = m[b] / m_ab;
+      r[a] = w_a * r[a] + w_b * r[b];
+      v[a] = w_a * v[a] + w_b * v[b];
+      if constexpr (has<PV>(u)) u[a] = w_a * u[a] + w_b * u[b];
+      h[a] *= pow(m_ab / m[a], inverse(static_cast<Num>(Dim)));
+      m[a] = m_ab;
+    });
+
+    // Select the particles to be split.
+    static thread_local std::vector<size_t> parents_buffer{};
+    auto& parents = parents_buffer;
+    parents.clear();
+    for (const PV a : particles.fluid()) {
+      if (!is_calm(a) && m[a] >= split_mass) parents.push_back(a.index());
+    }
+
+    // Split the particles. Appending the fluid particles does not move the
+    // existing fluid particles, so the parent and the victim indices stay
+    // valid. First child reuses the parent, the rest are appended.
+    if (!parents.empty()) {
+      const auto appended = particles.append_n(ParticleType::fluid,
+                                               parents.size() *
+                                                   (num_children - 1));
+      const auto first_appended = appended.front().index();
+      par::for_each(
+          std::views::iota(size_t{0}, parents.size()),
+          [&parents, &particles, first_appended](size_t i) {
+            const auto a = particles[parents[i]];
+            TIT_ASSERT(rho[a] > Num{0}, "Particle density must be positive!");
+            const auto dr_a =
+                pow(m[a] / rho[a], inverse(static_cast<Num>(Dim)));
+            const auto child_pos = [r_a = r[a], dr_a](size_t c) {
+              auto pos = r_a;
+              for (size_t d = 0; d < Dim; ++d) {
+                pos[d] += (((c >> d) & 1) != 0 ? dr_a : -dr_a) / 4;
+              }
+              return pos;
+            };
+            m[a] /= num_children, h[a] /= 2;
+            const auto first_child =
+                first_appended + i * (num_children - 1) - 1;
+            for (size_t c = 1; c < num_children; ++c) {
+              const auto b = particles[first_child + c];
+              ParticleArray::shared_fields.for_each(
+                  [a, b](auto field) { field[b] = field[a]; });
+              r[b] = child_pos(c);
+            }
+            r[a] = child_pos(0);
+          });
+    }
+
+    // Remove the merged particles. Removal moves the particles, so it is done
+    // after the children are written.
+    particles.remove(victims);
+    TIT_STATS("ParticleRefinement::num_split", parents.size());
+    TIT_STATS("ParticleRefinement::num_merged", victims.size());
+
+    // Particle indices were changed, so the mesh must be rebuilt.
+    if (!parents.empty() || !victims.empty()) mesh.invalidate();
+  }
+
+private:
+
+  Num max_mass_;
+  size_t num_levels_;
+
+}; // class ParticleRefinement
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
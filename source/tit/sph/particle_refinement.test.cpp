@@ -0,0 +1,113 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <numbers>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_refinement.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the refinement.
+using RefinementEquations = EquationsStub<
+    meta::Set{sph::r, sph::v, sph::m, sph::rho, sph::h, sph::FS},
+    meta::Set{sph::r, sph::v, sph::m, sph::h, sph::FS}>;
+
+// Sorted fluid particle positions.
+auto fluid_positions(const auto& particles) -> std::vector<Vec<double, 2>> {
+  auto rs = particles.fluid() |
+            std::views::transform([](auto a) { return sph::r[a]; }) |
+            std::ranges::to<std::vector>();
+  std::ranges::sort(rs, [](const auto& a, const auto& b) {
+    return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+  });
+  return rs;
+}
+
+TEST_CASE("sph::ParticleRefinement") {
+  sph::ParticleRefinement refinement{/*max_mass=*/1.0};
+  sph::ParticleMesh mesh{geom::GridSearch{1.0}};
+
+  // Setup the particles: a fixed particle is far from the free surface, so
+  // that it defines the flag value for the calm particles.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, RefinementEquations{}};
+  sph::rho[particles] = 1.0;
+  const auto w = particles.append(sph::ParticleType::fixed);
+  sph::r[w] = Vec{10.0, 10.0}, sph::m[w] = 1.0, sph::h[w] = 1.0;
+  sph::FS[w] = 1.0;
+
+  SUBCASE("split") {
+    // Particle near the free surface must be split into four children.
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{0.0, 0.0}, sph::v[a] = Vec{1.0, 2.0};
+    sph::m[a] = 1.0, sph::h[a] = 1.0, sph::FS[a] = 0.5;
+    mesh.update(particles, [](auto /*a*/) { return 1.0; });
+    refinement.update(mesh, particles);
+    REQUIRE(particles.fluid().size() == 4);
+    CHECK_RANGE_EQ(fluid_positions(particles),
+                   std::vector{Vec{-0.25, -0.25},
+                               Vec{-0.25, +0.25},
+                               Vec{+0.25, -0.25},
+                               Vec{+0.25, +0.25}},
+                   [](const auto& x, const auto& y) { return all(x == y); });
+    for (const auto b : particles.fluid()) {
+      CHECK(sph::m[b] == 0.25);
+      CHECK(sph::h[b] == 0.5);
+      CHECK(all(sph::v[b] == Vec{1.0, 2.0}));
+    }
+
+    // Children are at the minimum mass, so they must not be split again.
+    mesh.update(particles, [](auto /*a*/) { return 1.0; });
+    refinement.update(mesh, particles);
+    CHECK(particles.fluid().size() == 4);
+  }
+  SUBCASE("merged") {
+    // Pair of calm particles must be merged, the isolated one must be kept.
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{0.0, 0.0}, sph::v[a] = Vec{1.0, 0.0};
+    sph::m[a] = 0.5, sph::h[a] = 1.0, sph::FS[a] = 1.0;
+    const auto b = particles.append(sph::ParticleType::fluid);
+    sph::r[b] = Vec{0.5, 0.0}, sph::v[b] = Vec{0.0, 1.0};
+    sph::m[b] = 0.5, sph::h[b] = 1.0, sph::FS[b] = 1.0;
+    const auto c = particles.append(sph::ParticleType::fluid);
+    sph::r[c] = Vec{5.0, 0.0}, sph::v[c] = Vec{0.0, 0.0};
+    sph::m[c] = 0.5, sph::h[c] = 1.0, sph::FS[c] = 1.0;
+    mesh.update(particles, [](auto /*a*/) { return 1.0; });
+    refinement.update(mesh, particles);
+    REQUIRE(particles.fluid().size() == 2);
+    CHECK_RANGE_EQ(fluid_positions(particles),
+                   std::vector{Vec{0.25, 0.0}, Vec{5.0, 0.0}},
+                   [](const auto& x, const auto& y) { return all(x == y); });
+    for (const auto d : particles.fluid()) {
+      if (sph::r[d][0] > 1.0) continue;
+      CHECK(sph::m[d] == 1.0);
+      CHECK(approx_equal_to(sph::h[d], std::numbers::sqrt2));
+      CHECK(all(sph::v[d] == Vec{0.5, 0.5}));
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
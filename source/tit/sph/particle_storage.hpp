@@ -0,0 +1,251 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/allocator.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/uint_utils.hpp"
+
+#include "tit/sph/field.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Structure-of-arrays particle layout: each varying field is stored in a
+/// separate array.
+struct SoALayout final {
+  /// Set of particle fields that are stored in tiles.
+  static constexpr meta::Set<> tiled_fields{};
+
+  /// Number of particles in a tile.
+  static constexpr size_t tile_size = 1;
+};
+
+/// Array-of-structures-of-arrays particle layout: the particle fields that
+/// are read together are stored in tiles of @p TileSize particles, so that a
+/// single neighbor fetch touches a single cache line. The remaining fields
+/// are stored in separate arrays, as in `SoALayout`.
+///
+/// @tparam TiledFields Fields that are stored in tiles, for example the
+///                     `FluidEquations::pair_fields`. Fields that are not
+///                     varying in the particle array are ignored.
+template<field_set TiledFields, size_t TileSize = 8>
+  requires (TileSize > 0)
+struct AoSoALayout final {
+  /// Set of particle fields that are stored in tiles.
+  static constexpr TiledFields tiled_fields{};
+
+  /// Number of particles in a tile.
+  static constexpr size_t tile_size = TileSize;
+};
+
+namespace impl {
+template<class Layout>
+inline constexpr bool is_particle_layout_v = false;
+template<>
+inline constexpr bool is_particle_layout_v<SoALayout> = true;
+template<class TiledFields, size_t TileSize>
+inline constexpr bool
+    is_particle_layout_v<AoSoALayout<TiledFields, TileSize>> = true;
+} // namespace impl
+
+/// Particle layout type.
+template<class Layout>
+concept particle_layout = impl::is_particle_layout_v<Layout>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Storage of the varying particle fields.
+template<space Space, field_set Fields, particle_layout Layout>
+class ParticleStorage final {
+public:
+
+  /// Set of particle fields that are stored.
+  static constexpr Fields fields{};
+
+  /// Subset of particle fields that are stored in tiles.
+  static constexpr field_set auto tiled_fields = fields & Layout::tiled_fields;
+
+  /// Subset of particle fields that are stored in separate arrays.
+  static constexpr field_set auto column_fields = fields - tiled_fields;
+
+  /// Number of particles in a tile.
+  static constexpr size_t tile_size = Layout::tile_size;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Number of particles.
+  constexpr auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+  /// Size of the stored particle values (in bytes).
+  constexpr auto size_bytes() const noexcept -> size_t {
+    size_t result = 0;
+    std::apply(
+        [&result](const auto&... cols) {
+          ((result += std::span{cols}.size_bytes()), ...);
+        },
+        columns_);
+    if constexpr (has_tiles_) result += std::span{tiles_}.size_bytes();
+    return result;
+  }
+
+  /// Memory allocated by the storage (in bytes), including the unused
+  /// capacity.
+  constexpr auto memory_usage() const noexcept -> size_t {
+    size_t result = 0;
+    std::apply(
+        [&result](const auto&... cols) {
+          ((result += cols.capacity() * sizeof(cols[0])), ...);
+        },
+        columns_);
+    if constexpr (has_tiles_) result += tiles_.capacity() * sizeof(Tile_);
+    return result;
+  }
+
+  /// Reserve amount of particles.
+  constexpr void reserve(size_t capacity) {
+    std::apply([capacity](auto&... cols) { ((cols.reserve(capacity)), ...); },
+               columns_);
+    if constexpr (has_tiles_) tiles_.reserve(divide_up(capacity, tile_size));
+  }
+
+  /// Resize the storage. New particle values are value-initialized.
+  constexpr void resize(size_t count) {
+    std::apply([count](auto&... cols) { ((cols.resize(count)), ...); },
+               columns_);
+    const auto old_size = std::exchange(size_, count);
+    if constexpr (has_tiles_) {
+      // Tail of the last tile may hold the values of the removed particles,
+      // so the new values are reset explicitly.
+      tiles_.resize(divide_up(count, tile_size));
+      for (size_t index = old_size; index < count; ++index) {
+        tiled_fields.for_each(
+            [index, this](auto field) { value(index, field) = {}; });
+      }
+    }
+  }
+
+  /// Move the particle values from one index to another.
+  constexpr void move(size_t from, size_t to) {
+    TIT_ASSERT(from < size_, "Particle index is out of range.");
+    TIT_ASSERT(to < size_, "Particle index is out of range.");
+    fields.for_each([from, to, this](auto field) {
+      value(to, field) = std::move(value(from, field));
+    });
+  }
+
+  /// Copy the particle values from another storage.
+  constexpr void copy(const ParticleStorage& other, size_t from, size_t to) {
+    TIT_ASSERT(from < other.size_, "Particle index is out of range.");
+    TIT_ASSERT(to < size_, "Particle index is out of range.");
+    fields.for_each([&other, from, to, this](auto field) {
+      value(to, field) = other.value(from, field);
+    });
+  }
+
+  /// Particle field value at index.
+  template<field Field>
+  constexpr auto value(this auto& self, size_t index, Field /*field*/) noexcept
+      -> auto& {
+    static_assert(fields.contains(Field{}));
+    TIT_ASSERT(index < self.size_, "Particle index is out of range.");
+    if constexpr (tiled_fields.contains(Field{})) {
+      auto& tile = self.tiles_[index / tile_size];
+      return std::get<tiled_fields.find(Field{})>(tile)[index % tile_size];
+    } else {
+      return std::get<column_fields.find(Field{})>(self.columns_)[index];
+    }
+  }
+
+  /// Values for the specified field. A span is returned for the fields that
+  /// are stored in separate arrays, and a random access view otherwise.
+  template<field Field>
+  constexpr auto values(this auto& self, Field field) noexcept {
+    static_assert(fields.contains(Field{}));
+    if constexpr (tiled_fields.contains(Field{})) {
+      return std::views::iota(size_t{0}, self.size_) |
+             std::views::transform([&self, field](size_t index) -> auto& {
+               return self.value(index, field);
+             });
+    } else {
+      return std::span{std::get<column_fields.find(Field{})>(self.columns_)};
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Write the raw particle values into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, static_cast<uint64_t>(size_));
+    std::apply([&out](const auto&... cols) { (write_raw_(out, cols), ...); },
+               columns_);
+    if constexpr (has_tiles_) write_raw_(out, tiles_);
+  }
+
+  /// Read the raw particle values from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    uint64_t size = 0;
+    if (!deserialize(in, size)) deserialization_failed();
+    resize(size);
+    std::apply([&in](auto&... cols) { (read_raw_(in, cols), ...); },
+               columns_);
+    if constexpr (has_tiles_) read_raw_(in, tiles_);
+  }
+
+private:
+
+  template<class Val>
+  using Array_ = std::vector<Val, par::Allocator<Val>>;
+
+  template<class Val>
+  static void write_raw_(OutputStream<byte_t>& out, const Array_<Val>& vals) {
+    static_assert(std::is_trivially_copyable_v<Val>);
+    out.write(std::as_bytes(std::span{vals}));
+  }
+
+  template<class Val>
+  static void read_raw_(InputStream<byte_t>& in, Array_<Val>& vals) {
+    static_assert(std::is_trivially_copyable_v<Val>);
+    const auto bytes = std::as_writable_bytes(std::span{vals});
+    if (in.read(bytes) != bytes.size()) deserialization_failed();
+  }
+
+  using Tile_ = decltype([]<class... Fields_>(meta::Set<Fields_...> /*fs*/) {
+    return std::tuple<
+        std::array<field_storage_t<Fields_, Space>, tile_size>...>{};
+  }(tiled_fields));
+
+  static constexpr bool has_tiles_ = std::tuple_size_v<Tile_> != 0;
+
+  size_t size_ = 0;
+
+  decltype([]<class... Fields_>(meta::Set<Fields_...> /*fs*/) {
+    return std::tuple<Array_<field_storage_t<Fields_, Space>>...>{};
+  }(column_fields)) columns_;
+
+  Array_<Tile_> tiles_;
+
+}; // class ParticleStorage
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,162 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <functional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/mdvector.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/kernel.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Post-processing operators over a particle snapshot.
+///
+/// Snapshot is a set of the plain particle arrays, e.g. the ones read from a
+/// stored time step, so that the derived quantities could be computed
+/// outside of the solver. Neighbors are found through the grid search index,
+/// that is built once for the snapshot, and the operators run in parallel
+/// over the particles or the points. Periodic boxes are not supported.
+///
+/// @note Snapshot does not own the arrays, they must outlive it.
+template<kernel Kernel, class Num, size_t Dim>
+class ParticleSnapshot final {
+public:
+
+  /// Particle position type.
+  using Point = Vec<Num, Dim>;
+
+  /// Index a particle snapshot.
+  ///
+  /// @param kernel Smoothing kernel.
+  /// @param r      Particle positions.
+  /// @param V      Particle volumes, i.e. `m / rho`.
+  /// @param h      Particle widths.
+  ParticleSnapshot(Kernel kernel,
+                   std::span<const Point> r,
+                   std::span<const Num> V,
+                   std::span<const Num> h)
+      : kernel_{std::move(kernel)}, r_{r}, V_{V}, h_{h},
+        radius_{r.empty() ? Num{1.0} : kernel_.radius(par::max(h))},
+        index_{geom::GridSearch{radius_}(r_)} {
+    TIT_ASSERT(V_.size() == r_.size(), "Volumes size mismatch!");
+    TIT_ASSERT(h_.size() == r_.size(), "Widths size mismatch!");
+  }
+
+  /// Number of the particles.
+  constexpr auto size() const noexcept -> size_t {
+    return r_.size();
+  }
+
+  /// Interpolate the particle values onto the points, with the
+  /// Shepard-normalized smoothing kernel. Points with no particles nearby
+  /// get zero values.
+  ///
+  /// @param vals   Particle values, one row per particle.
+  /// @param points Interpolation points.
+  ///
+  /// @returns Interpolated values, one row per point.
+  auto interpolate(Mdspan<const Num, 2> vals,
+                   std::span<const Point> points) const -> Mdvector<Num, 2> {
+    TIT_PROFILE_SECTION("ParticleSnapshot::interpolate()");
+    TIT_ASSERT(vals.shape()[0] == size(), "Values size mismatch!");
+    const auto num_comps = vals.shape()[1];
+    Mdvector<Num, 2> result(points.size(), num_comps);
+    par::for_each(
+        std::views::iota(size_t{0}, points.size()),
+        [&vals, &points, &result, num_comps, this](size_t i) {
+          const auto& x = points[i];
+          const auto out = result[i];
+          Num sum_weights{0.0};
+          for_each_near_(x, [&](size_t b) {
+            const auto weight = V_[b] * kernel_(x - r_[b], h_[b]);
+            if (weight == Num{0.0}) return;
+            sum_weights += weight;
+            const auto vals_b = vals[b];
+            for (size_t k = 0; k < num_comps; ++k) {
+              out[k] += weight * vals_b[k];
+            }
+          });
+          if (is_tiny(sum_weights)) return;
+          for (auto& val : out) val /= sum_weights;
+        });
+    return result;
+  }
+
+  /// Velocity curl (vorticity) of the particles, always 3D.
+  ///
+  /// @param v Particle velocities.
+  auto vorticity(std::span<const Point> v) const -> std::vector<Vec<Num, 3>> {
+    TIT_PROFILE_SECTION("ParticleSnapshot::vorticity()");
+    TIT_ASSERT(v.size() == size(), "Velocities size mismatch!");
+    std::vector<Vec<Num, 3>> result(size());
+    par::for_each(std::views::iota(size_t{0}, size()),
+                  [&v, &result, this](size_t a) {
+                    Vec<Num, 3> curl_v{};
+                    for_each_near_(r_[a], [&](size_t b) {
+                      if (a == b) return;
+                      const auto h_ab = avg(h_[a], h_[b]);
+                      const auto grad_W_ab = kernel_.grad(r_[a] - r_[b], h_ab);
+                      curl_v -= V_[b] * cross(v[b] - v[a], grad_W_ab);
+                    });
+                    result[a] = curl_v;
+                  });
+    return result;
+  }
+
+private:
+
+  // Call the function for each particle within the largest support radius.
+  template<class Func>
+  void for_each_near_(const Point& x, const Func& func) const {
+    static thread_local std::vector<size_t> near{};
+    near.clear();
+    index_.search(x, radius_, std::back_inserter(near));
+    for (const auto b : near) func(b);
+  }
+
+  [[no_unique_address]] Kernel kernel_;
+  std::span<const Point> r_;
+  std::span<const Num> V_;
+  std::span<const Num> h_;
+  Num radius_;
+  decltype(geom::GridSearch{1.0}(std::span<const Point>{})) index_;
+
+}; // class ParticleSnapshot
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Total kinetic energy of the particles, `Σ m |v|² / 2`.
+template<class Num, size_t Dim>
+auto kinetic_energy(std::span<const Num> m, std::span<const Vec<Num, Dim>> v)
+    -> Num {
+  TIT_PROFILE_SECTION("sph::kinetic_energy()");
+  TIT_ASSERT(m.size() == v.size(), "Velocities size mismatch!");
+  return par::transform_reduce(std::views::iota(size_t{0}, m.size()),
+                               Num{0.0},
+                               std::plus{},
+                               [&m, &v](size_t a) {
+                                 return m[a] * norm2(v[a]) / Num{2.0};
+                               });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
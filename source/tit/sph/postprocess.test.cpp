@@ -0,0 +1,88 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/mdvector.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/postprocess.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleSnapshot") {
+  constexpr size_t n = 16;
+  constexpr double omega = 0.5;
+
+  // Setup the particles on a lattice, rotating as a rigid body, with a field
+  // that has a constant and a linear component.
+  std::vector<Vec<double, 2>> r;
+  std::vector<Vec<double, 2>> v;
+  std::vector<double> vals;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      const Vec x{static_cast<double>(i), static_cast<double>(j)};
+      r.push_back(x);
+      v.push_back(omega * Vec{-x[1], x[0]});
+      vals.push_back(3.0);
+      vals.push_back(x[0] + 2.0 * x[1]);
+    }
+  }
+  const std::vector<double> V(r.size(), 1.0);
+  const std::vector<double> h(r.size(), 1.3);
+  const sph::ParticleSnapshot snapshot{sph::QuarticWendlandKernel{},
+                                       std::span<const Vec<double, 2>>{r},
+                                       std::span<const double>{V},
+                                       std::span<const double>{h}};
+  REQUIRE(snapshot.size() == n * n);
+
+  SUBCASE("interpolate") {
+    // Interpolation must be exact for the constant values, and close for the
+    // linear ones inside of the lattice.
+    const std::array shape{r.size(), size_t{2}};
+    const Mdspan<const double, 2> values{vals.begin(), shape};
+    const std::vector<Vec<double, 2>> points{{7.5, 7.5},
+                                             {8.0, 6.0},
+                                             {100.0, 100.0}};
+    const auto result = snapshot.interpolate(values, points);
+    REQUIRE(result.shape() == std::array{size_t{3}, size_t{2}});
+    CHECK(result[0, 0] == doctest::Approx(3.0));
+    CHECK(result[0, 1] == doctest::Approx(22.5));
+    CHECK(result[1, 0] == doctest::Approx(3.0));
+    CHECK(result[1, 1] == doctest::Approx(20.0));
+    CHECK(result[2, 0] == 0.0);
+    CHECK(result[2, 1] == 0.0);
+  }
+  SUBCASE("vorticity") {
+    // Vorticity of the rigid rotation is twice the angular velocity.
+    const auto curl_v = snapshot.vorticity(v);
+    REQUIRE(curl_v.size() == r.size());
+    const auto& center = curl_v[(n / 2) * n + n / 2];
+    CHECK(center[0] == 0.0);
+    CHECK(center[1] == 0.0);
+    CHECK(center[2] == doctest::Approx(2.0 * omega).epsilon(0.05));
+  }
+}
+
+TEST_CASE("sph::kinetic_energy") {
+  const std::vector<double> m{1.0, 2.0, 4.0};
+  const std::vector<Vec<double, 2>> v{{1.0, 0.0}, {0.0, 2.0}, {3.0, 4.0}};
+  CHECK(sph::kinetic_energy(std::span{m}, std::span{v}) ==
+        0.5 * (1.0 + 2.0 * 4.0 + 4.0 * 25.0));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
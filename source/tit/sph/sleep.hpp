@@ -0,0 +1,211 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/grid.hpp"
+#include "tit/geom/point_range.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Deactivation of the quiescent fluid particles (sleeping particles).
+///
+/// Fluid particle is quiet on a step if its velocity and acceleration
+/// magnitudes are below the thresholds, and it falls asleep once it stays
+/// quiet for `num_quiet_steps` consecutive steps, as counted by the
+/// `quiet_steps` field. Sleeping particles are frozen: they are neither
+/// drifted nor kicked, and their derivatives are held fixed.
+///
+/// Particle states are tracked on a grid. Cells that contain the awake fluid
+/// particles, along with their neighboring cells, are the paired cells, and
+/// the pair passes only evaluate the pairs with at least one particle in a
+/// paired cell, see `ParticleMesh::activate`. Cells must be no smaller than
+/// the kernel support, so that the sleeping neighbors of the awake particles
+/// have all of their pairs evaluated, and the fields the awake particles
+/// read from them are complete. Sleeping particle wakes up once its own
+/// acceleration exceeds the threshold, i.e. once the disturbance front
+/// reaches it, or once a neighboring cell contains a particle that was not
+/// quiet on the last step. Under the CFL condition the front travels less
+/// than a cell per step, so it is never missed.
+class SleepController final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v, dv_dt, quiet_steps};
+
+  /// Construct a sleep controller.
+  ///
+  /// @param cell_size        Cell size of the tracking grid. Must be no
+  ///                         smaller than the kernel support radius.
+  /// @param max_velocity     Velocity magnitude threshold.
+  /// @param max_acceleration Acceleration magnitude threshold.
+  /// @param num_quiet_steps  Number of the consecutive quiet steps before
+  ///                         the particle falls asleep.
+  constexpr explicit SleepController(real_t cell_size,
+                                     real_t max_velocity,
+                                     real_t max_acceleration,
+                                     size_t num_quiet_steps = 10) noexcept
+      : cell_size_{cell_size}, max_velocity_{max_velocity},
+        max_acceleration_{max_acceleration},
+        num_quiet_steps_{num_quiet_steps} {
+    TIT_ASSERT(cell_size_ > 0.0, "Cell size must be positive!");
+    TIT_ASSERT(max_velocity_ >= 0.0, "Velocity threshold must be positive!");
+    TIT_ASSERT(max_acceleration_ >= 0.0,
+               "Acceleration threshold must be positive!");
+    TIT_ASSERT(num_quiet_steps_ > 0, "Number of quiet steps must be positive!");
+    TIT_ASSERT(num_quiet_steps_ <= std::numeric_limits<uint8_t>::max(),
+               "Number of quiet steps is too large!");
+  }
+
+  /// Number of the sleeping fluid particles after the last update.
+  constexpr auto num_asleep() const noexcept -> size_t {
+    return num_asleep_;
+  }
+
+  /// Check if the particle is asleep.
+  template<particle_view<required_fields> PV>
+  constexpr auto asleep(PV a) const noexcept -> bool {
+    return quiet_steps[a] >= num_quiet_steps_;
+  }
+
+  /// Check if the pairs of the particle with the given index are evaluated,
+  /// i.e. if the particle is in a paired cell.
+  constexpr auto paired(size_t index) const noexcept -> bool {
+    TIT_ASSERT(index < paired_.size(), "Particle index is out of range!");
+    return paired_[index] != 0;
+  }
+
+  /// Check if the particle is integrated in time: it is awake, and its pairs
+  /// are evaluated. Latter matters for the fixed particles only.
+  template<particle_view<required_fields> PV>
+  constexpr auto active(PV a) const noexcept -> bool {
+    return !asleep(a) && paired(a.index());
+  }
+
+  /// Update the particle states with the velocities and the accelerations of
+  /// the last step. This must be called once per step, after the particles
+  /// are reordered, and before the pair passes.
+  template<particle_array<required_fields> ParticleArray>
+  void update(ParticleArray& particles) {
+    TIT_PROFILE_SECTION("SleepController::update()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    paired_.assign(particles.size(), 0);
+    num_asleep_ = 0;
+    if (particles.size() == 0) return;
+
+    // Count the quiet steps of the fluid particles.
+    const auto max_v2 = pow2(static_cast<Num>(max_velocity_));
+    const auto max_a2 = pow2(static_cast<Num>(max_acceleration_));
+    par::for_each(particles.fluid(), [max_v2, max_a2, this](PV a) {
+      if (norm2(v[a]) >= max_v2 || norm2(dv_dt[a]) >= max_a2) {
+        quiet_steps[a] = 0;
+      } else if (quiet_steps[a] < num_quiet_steps_) {
+        quiet_steps[a] = static_cast<uint8_t>(quiet_steps[a] + 1);
+      }
+    });
+
+    // Build the tracking grid. Grid is extended by a cell, so that the
+    // stencils of all the particle cells exist.
+    const auto cell_size = static_cast<Num>(cell_size_);
+    auto grid =
+        geom::Grid{geom::compute_bbox(r[particles]).grow(cell_size / 2)};
+    grid.set_cell_extents(cell_size).extend(1);
+    const auto num_cells = grid.flat_num_cells();
+    const auto offsets = grid.stencil_offsets();
+    const auto for_each_stencil_cell = [&offsets](size_t cell,
+                                                  const auto& func) {
+      for (const auto offset : offsets) {
+        func(static_cast<size_t>(static_cast<ssize_t>(cell) + offset));
+      }
+    };
+    const auto mark = [](std::vector<uint8_t>& cells, size_t cell) {
+      std::atomic_ref{cells[cell]}.store(1, std::memory_order_relaxed);
+    };
+
+    // Mark the cells of the particles that were not quiet on the last step.
+    disturbed_cells_.assign(num_cells, 0);
+    par::for_each(particles.fluid(), [&grid, &mark, this](PV a) {
+      if (quiet_steps[a] != 0) return;
+      mark(disturbed_cells_, grid.flat_cell_index(r[a]));
+    });
+
+    // Wake up the sleeping particles next to the disturbed cells, and mark
+    // the cells of the awake particles.
+    awake_cells_.assign(num_cells, 0);
+    par::for_each(
+        particles.fluid(),
+        [&grid, &for_each_stencil_cell, &mark, this](PV a) {
+          const auto cell = grid.flat_cell_index(r[a]);
+          if (asleep(a)) {
+            bool disturbed = false;
+            for_each_stencil_cell(cell, [&disturbed, this](size_t other) {
+              if (disturbed_cells_[other] != 0) disturbed = true;
+            });
+            if (!disturbed) return;
+            quiet_steps[a] = 0;
+          }
+          mark(awake_cells_, cell);
+        });
+
+    // Mark the paired cells, and the particles in them.
+    paired_cells_.assign(num_cells, 0);
+    par::for_each(std::views::iota(size_t{0}, num_cells),
+                  [&for_each_stencil_cell, &mark, this](size_t cell) {
+                    if (awake_cells_[cell] == 0) return;
+                    for_each_stencil_cell(cell, [&mark, this](size_t other) {
+                      mark(paired_cells_, other);
+                    });
+                  });
+    par::for_each(particles.all(), [&grid, this](PV a) {
+      paired_[a.index()] = paired_cells_[grid.flat_cell_index(r[a])];
+    });
+
+    // Count the sleeping particles.
+    num_asleep_ = par::transform_reduce(
+        particles.fluid(),
+        size_t{0},
+        std::plus{},
+        [this](PV a) { return static_cast<size_t>(asleep(a)); });
+    TIT_STATS("SleepController::num_asleep", num_asleep_);
+  }
+
+private:
+
+  real_t cell_size_;
+  real_t max_velocity_;
+  real_t max_acceleration_;
+  size_t num_quiet_steps_;
+  size_t num_asleep_ = 0;
+  std::vector<uint8_t> disturbed_cells_;
+  std::vector<uint8_t> awake_cells_;
+  std::vector<uint8_t> paired_cells_;
+  std::vector<uint8_t> paired_;
+
+}; // class SleepController
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
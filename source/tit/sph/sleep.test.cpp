@@ -0,0 +1,80 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/sleep.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the fields of the sleep controller.
+using SleepEquations = EquationsStub<
+    meta::Set{sph::r, sph::v, sph::dv_dt, sph::quiet_steps},
+    meta::Set{sph::v, sph::dv_dt, sph::quiet_steps}>;
+
+TEST_CASE("sph::SleepController") {
+  // Setup the particles: fluid particles at rest are placed in a row, one
+  // particle per tracking grid cell.
+  constexpr size_t num_fluid = 100;
+  sph::ParticleArray particles{sph::Space<double, 2>{}, SleepEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, num_fluid)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+  }
+  sph::SleepController controller{/*cell_size=*/1.0,
+                                  /*max_velocity=*/0.1,
+                                  /*max_acceleration=*/0.1,
+                                  /*num_quiet_steps=*/3};
+  const auto num_paired = [&particles, &controller] {
+    size_t result = 0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+      if (controller.paired(i)) result += 1;
+    }
+    return result;
+  };
+
+  // Particles fall asleep after the quiet steps, and no pairs remain.
+  controller.update(particles);
+  controller.update(particles);
+  CHECK(controller.num_asleep() == 0);
+  CHECK(num_paired() == num_fluid);
+  controller.update(particles);
+  CHECK(controller.num_asleep() == num_fluid);
+  CHECK(num_paired() == 0);
+
+  // Disturb a particle. It wakes up its neighbors, and the pairs are
+  // evaluated next to the awake particles only.
+  sph::dv_dt[particles[50]] = Vec{1.0, 0.0};
+  controller.update(particles);
+  CHECK(controller.num_asleep() == num_fluid - 3);
+  for (size_t i = 0; i < num_fluid; ++i) {
+    const auto a = particles[i];
+    CHECK(controller.asleep(a) == (i < 49 || i > 51));
+    CHECK(controller.active(a) == !controller.asleep(a));
+    CHECK(controller.paired(i) == (i >= 48 && i <= 52));
+  }
+
+  // Once the disturbance is gone, the particles fall asleep again.
+  sph::dv_dt[particles[50]] = Vec{0.0, 0.0};
+  controller.update(particles);
+  controller.update(particles);
+  CHECK(controller.num_asleep() == num_fluid - 3);
+  controller.update(particles);
+  CHECK(controller.num_asleep() == num_fluid);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
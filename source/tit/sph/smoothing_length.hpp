@@ -0,0 +1,188 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Variable particle width solver with the grad-h correction factors.
+///
+/// Width of each fluid particle is tied to its density as
+/// `h = eta * (m / rho)^(1/Dim)`, so that the number of the neighbors within
+/// the kernel support stays the same across the density contrasts. Width
+/// and the summation density `rho = Σ m_b W(r_ab, h)` are found together by
+/// the Newton iteration for each particle. Correction factor
+/// `Omega = 1 + h / (Dim * rho) * Σ m_b ∂W/∂h(r_ab, h)` is stored for the
+/// momentum equations of the variable width formulation.
+///
+/// Neighbors are searched once per solve, within the upper bound radius
+/// that corresponds to the width grown by the `max_growth` factor, see
+/// `index`. Iterations run over the candidate neighbor lists of the mesh,
+/// and the widths are kept within the bound, so no search is repeated. Pairs
+/// out of the new kernel supports are pruned afterwards, if the pruning of
+/// the mesh is enabled.
+template<kernel Kernel>
+class SmoothingLengthSolver final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Kernel::required_fields | meta::Set{m, rho, h, Omega};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{rho, h, Omega};
+
+  /// Construct a variable width solver.
+  ///
+  /// @param kernel     Smoothing kernel.
+  /// @param eta        Ratio of the width to the particle spacing.
+  /// @param max_growth Maximum growth or shrink factor of the width per
+  ///                   solve. Search radius is extended by it.
+  /// @param tolerance  Relative tolerance of the density residual.
+  /// @param max_iters  Maximum number of the Newton iterations.
+  constexpr explicit SmoothingLengthSolver(Kernel kernel = {},
+                                           real_t eta = 1.2,
+                                           real_t max_growth = 1.25,
+                                           real_t tolerance = 1.0e-4,
+                                           size_t max_iters = 20) noexcept
+      : kernel_{std::move(kernel)}, eta_{eta}, max_growth_{max_growth},
+        tolerance_{tolerance}, max_iters_{max_iters} {
+    TIT_ASSERT(eta_ > 0.0, "Width ratio must be positive!");
+    TIT_ASSERT(max_growth_ > 1.0, "Maximum growth must be greater than one!");
+    TIT_ASSERT(tolerance_ > 0.0, "Tolerance must be positive!");
+    TIT_ASSERT(max_iters_ > 0, "Number of iterations must be positive!");
+  }
+
+  /// Smoothing kernel.
+  constexpr auto kernel() const noexcept -> const Kernel& {
+    return kernel_;
+  }
+
+  /// Ratio of the width to the particle spacing.
+  constexpr auto eta() const noexcept -> real_t {
+    return eta_;
+  }
+
+  /// Maximum growth or shrink factor of the width per solve.
+  constexpr auto max_growth() const noexcept -> real_t {
+    return max_growth_;
+  }
+
+  /// Upper bound search radius of the particle, that covers the kernel
+  /// support of any width the particle may reach within the solve.
+  template<particle_view<required_fields> PV>
+  constexpr auto search_radius(PV a) const noexcept {
+    return kernel_.radius(static_cast<particle_num_t<PV>>(max_growth_) * h[a]);
+  }
+
+  /// Index the particles with the upper bound search radii. Particle mesh
+  /// must be rebuilt each time, so it must have no skin.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void index(ParticleMesh& mesh, ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+    mesh.update(particles, [this](PV a) { return search_radius(a); });
+  }
+
+  /// Find the widths, the densities and the correction factors of the fluid
+  /// particles. Particle mesh must be indexed by `index` for the current
+  /// positions and widths.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void solve(ParticleMesh& mesh, ParticleArray& particles) const {
+    TIT_PROFILE_SECTION("SmoothingLengthSolver::solve()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    static_assert(!has_uniform<ParticleArray>(h),
+                  "Particle widths must be varying!");
+    TIT_ASSERT(mesh.valid(), "Mesh must be up to date!");
+
+    const auto eta = static_cast<Num>(eta_);
+    const auto max_growth = static_cast<Num>(max_growth_);
+    const auto tolerance = static_cast<Num>(tolerance_);
+    par::for_each(
+        particles.fluid(),
+        [&mesh, eta, max_growth, tolerance, this](PV a) {
+          // Widths are kept within the bound of the candidate neighbor lists.
+          const auto h_min = h[a] / max_growth;
+          const auto h_max = h[a] * max_growth;
+          auto h_a = h[a];
+          Num rho_a{};
+          Num drho_dh_a{};
+          size_t iter = 1;
+          for (;; ++iter) {
+            // Compute the summation density and its width derivative. Adjacency
+            // includes the particle itself.
+            rho_a = {}, drho_dh_a = {};
+            for (const PV b : mesh[a]) {
+              const auto r_ab = r[a, b];
+              rho_a += m[b] * kernel_(r_ab, h_a);
+              drho_dh_a += m[b] * kernel_.width_deriv(r_ab, h_a);
+            }
+
+            // Check the residual of `rho(h) = m * (eta / h)^Dim`.
+            const auto rho_h = m[a] * pow<Dim>(eta / h_a);
+            const auto f = rho_a - rho_h;
+            if (abs(f) <= tolerance * rho_h || iter == max_iters_) break;
+
+            // Make the Newton step. If the derivative is degenerate, the width
+            // is estimated from the current density.
+            const auto df_dh = drho_dh_a + Num{Dim} * rho_h / h_a;
+            const auto h_next =
+                std::clamp(df_dh > tiny_v<Num>
+                               ? h_a - f / df_dh
+                               : eta * pow(m[a] / rho_a, inverse(Num{Dim})),
+                           h_min,
+                           h_max);
+            if (h_next == h_a) break; // Stuck at the bound.
+            h_a = h_next;
+          }
+          TIT_STATS_HIST("SmoothingLengthSolver::num_iters", iter);
+
+          // Store the results.
+          h[a] = h_a;
+          rho[a] = rho_a;
+          Omega[a] = 1 + h_a / (Num{Dim} * rho_a) * drho_dh_a;
+        });
+
+    // Drop the pairs out of the new kernel supports.
+    if (mesh.pruning_enabled()) {
+      mesh.prune(particles, [this](PV a) { return kernel_.radius(a); });
+    }
+  }
+
+private:
+
+  [[no_unique_address]] Kernel kernel_;
+  real_t eta_;
+  real_t max_growth_;
+  real_t tolerance_;
+  size_t max_iters_;
+
+}; // class SmoothingLengthSolver
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,90 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/smoothing_length.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the solver.
+using SmoothingLengthEquations = EquationsStub<
+    meta::Set{sph::r, sph::m, sph::rho, sph::h, sph::Omega},
+    meta::Set{sph::rho, sph::h, sph::Omega}>;
+
+TEST_CASE("sph::SmoothingLengthSolver") {
+  par::set_num_threads(4);
+  constexpr size_t n = 24;
+  constexpr double eta = 1.2;
+  const sph::SmoothingLengthSolver solver{sph::QuarticWendlandKernel{}, eta};
+
+  // Solve for the widths of the unit mass particles on the lattice with the
+  // given spacing, starting from the width equal to the spacing. Return the
+  // neighbor counts of the particles in the middle of the lattice.
+  const auto solve = [&solver](double dx) {
+    sph::ParticleArray particles{sph::Space<double, 2>{},
+                                 SmoothingLengthEquations{}};
+    sph::m[particles] = 1.0;
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        const auto a = particles.append(sph::ParticleType::fluid);
+        sph::r[a] = dx * Vec{static_cast<double>(i), static_cast<double>(j)};
+        sph::h[a] = dx;
+      }
+    }
+    sph::ParticleMesh mesh{geom::GridSearch{2.5 * dx}};
+    for (size_t iter = 0; iter < 2; ++iter) {
+      solver.index(mesh, particles);
+      solver.solve(mesh, particles);
+    }
+
+    // Check the widths and the densities in the middle of the lattice.
+    std::vector<size_t> num_neighbors;
+    for (size_t i = n / 2 - 2; i < n / 2 + 2; ++i) {
+      for (size_t j = n / 2 - 2; j < n / 2 + 2; ++j) {
+        const auto a = particles[i * n + j];
+        CHECK(abs(sph::h[a] / dx - eta) < 0.05);
+        CHECK(abs(sph::rho[a] * pow2(dx) - 1.0) < 0.05);
+        CHECK(abs(sph::rho[a] * pow2(sph::h[a]) - pow2(eta)) < 1.0e-3);
+        CHECK(sph::Omega[a] > 0.5);
+        CHECK(sph::Omega[a] < 1.5);
+        const auto radius = solver.kernel().radius(sph::h[a]);
+        const auto is_neighbor = [a, radius](auto b) {
+          return norm(sph::r[a, b]) < radius;
+        };
+        num_neighbors.push_back(
+            static_cast<size_t>(std::ranges::count_if(mesh[a], is_neighbor)));
+      }
+    }
+    return num_neighbors;
+  };
+
+  // Neighbor counts do not depend on the density.
+  CHECK_RANGE_EQ(solve(1.0), solve(0.5));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,343 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Free surface mesh reconstruction.
+///
+/// Free surface is extracted as the iso-surface of the color field, that is
+/// the Shepard sum `sum(m[b] / rho[b] * W(x - r[b], h[b]))` of the fluid
+/// particles. Color field is only evaluated at the nodes of the uniform grid
+/// that are within the kernel support of the particles on the free surface,
+/// i.e. the particles with the `FS` flag set by `FluidEquations`, so the cost
+/// scales with the surface area, not with the volume of the fluid.
+///
+/// Each grid cell is split into the `Dim!` simplices along its main diagonal,
+/// and the iso-surface is extracted from each simplex in parallel ("marching
+/// tetrahedra" in 3D, "marching triangles" in 2D). Result is a soup of
+/// facets: triangles in 3D and line segments in 2D, oriented with the normals
+/// pointing out of the fluid.
+template<class Num, size_t Dim, kernel Kernel>
+  requires (Dim == 2 || Dim == 3)
+class SurfaceMesh final {
+public:
+
+  /// Vertex type.
+  using Point = Vec<Num, Dim>;
+
+  /// Construct a free surface mesh reconstruction.
+  ///
+  /// @param kernel    Smoothing kernel used for the color field.
+  /// @param spacing   Grid spacing, typically a fraction of the particle
+  ///                  spacing.
+  /// @param iso_value Color field value on the surface.
+  constexpr SurfaceMesh(Space<Num, Dim> /*space*/,
+                        Kernel kernel,
+                        Num spacing,
+                        Num iso_value = Num{0.5}) noexcept
+      : kernel_{std::move(kernel)}, spacing_{spacing}, iso_value_{iso_value} {
+    TIT_ASSERT(spacing_ > Num{0.0}, "Grid spacing must be positive!");
+  }
+
+  /// Facet vertices: each `Dim` consecutive vertices form a facet.
+  constexpr auto vertices() const noexcept -> std::span<const Point> {
+    return vertices_;
+  }
+
+  /// Number of the facets.
+  constexpr auto num_facets() const noexcept -> size_t {
+    return vertices_.size() / Dim;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Reconstruct the free surface mesh.
+  ///
+  /// @note Particle mesh must be up to date with the particle positions, and
+  ///       the free surface flags must be computed.
+  template<particle_mesh ParticleMesh, particle_array ParticleArray>
+    requires (ParticleArray::fields.includes(meta::Set{r, h, m, rho, FS}))
+  void reconstruct(const ParticleMesh& mesh, ParticleArray& particles) {
+    TIT_PROFILE_SECTION("SurfaceMesh::reconstruct()");
+    using PV = ParticleView<ParticleArray>;
+    vertices_.clear();
+
+    // Collect the particles on the free surface.
+    static constexpr auto FS_ON =
+        std::numeric_limits<particle_num_t<ParticleArray>>::min();
+    surface_.resize(particles.size());
+    surface_.erase(par::copy_if(std::views::iota(size_t{0}, particles.size()),
+                                surface_.begin(),
+                                [&particles](size_t index) {
+                                  const auto a = particles[index];
+                                  return a.is_fluid() &&
+                                         bitwise_equal(FS[a], FS_ON);
+                                }),
+                   surface_.end());
+    if (surface_.empty()) return;
+
+    // Build the grid around the free surface particles.
+    geom::BBox<Point> box{r[particles[surface_.front()]]};
+    Num radius{0.0};
+    for (const auto index : surface_) {
+      const auto a = particles[index];
+      box.expand(r[a]);
+      radius = std::max(radius, kernel_.radius(h[a]));
+    }
+    box.grow(radius + spacing_);
+    grid_ = geom::Grid<Point>{box}.set_cell_extents(spacing_);
+
+    // Mark the grid nodes within the support of the free surface particles.
+    active_.assign(grid_.flat_num_cells(), 0);
+    for (const auto index : surface_) {
+      const auto& x = r[particles[index]];
+      for (const auto& node : grid_.cells_intersecting(
+               geom::BBox<Point>{x}.grow(radius + spacing_))) {
+        active_[grid_.flatten_cell_index(node)] = 1;
+      }
+    }
+
+    // Evaluate the color field at the marked grid nodes.
+    color_.assign(grid_.flat_num_cells(), Num{0.0});
+    par::for_each(
+        std::views::iota(size_t{0}, grid_.flat_num_cells()),
+        [&mesh, &particles, radius, this](size_t flat_node) {
+          if (active_[flat_node] == 0) return;
+          const auto x = node_point_(unflatten_(flat_node, grid_.num_cells()));
+          Num color{0.0};
+          mesh.for_each_near(particles,
+                             x,
+                             radius,
+                             [&particles, &x, &color, this](PV b) {
+                               if (!b.is_fluid()) return;
+                               const auto x_b =
+                                   particles.wrap_delta(r, x - r[b]);
+                               color += m[b] / rho[b] * kernel_(x_b, h[b]);
+                             });
+          color_[flat_node] = color;
+        });
+
+    // Extract the iso-surface from the cells with all the nodes marked.
+    const auto num_cubes = grid_.num_cells() - VecIndex_(1);
+    thread_vertices_.resize(par::num_threads());
+    for (auto& out : thread_vertices_) out.clear();
+    par::static_for_each(
+        std::views::iota(size_t{0}, prod(num_cubes)),
+        [&num_cubes, this](size_t thread, size_t flat_cube) {
+          polygonize_cube_(unflatten_(flat_cube, num_cubes),
+                           thread_vertices_[thread]);
+        });
+    for (const auto& out : thread_vertices_) {
+      vertices_.insert(vertices_.end(), out.begin(), out.end());
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Write the free surface mesh into a data series, as the varying array
+  /// `surface` of the facet vertices.
+  void write(real_t time,
+             data::DataSeriesView<data::DataStorage> series) const {
+    auto transaction = series.storage().transaction();
+    write_(series.create_time_step(time));
+    transaction.commit();
+  }
+
+  /// Snapshot the free surface mesh and write it into a data series in
+  /// background.
+  void write(real_t time, data::DataWriter& writer) const {
+    auto snapshot = writer.acquire(time);
+    write_(*snapshot);
+    writer.submit(std::move(snapshot));
+  }
+
+private:
+
+  using VecIndex_ = geom::Grid<Point>::VecIndex;
+
+  static constexpr size_t num_corners_ = size_t{1} << Dim;
+  static constexpr size_t num_simplices_ = Dim == 2 ? 2 : 6;
+
+  // Simplices of the cell, split along its main diagonal: each simplex walks
+  // from the first corner to the last one, along the axes in a distinct
+  // order. Bit `i` of the corner index is the shift along the axis `i`.
+  static constexpr auto simplices_ = [] {
+    std::array<std::array<size_t, Dim + 1>, num_simplices_> result{};
+    std::array<size_t, Dim> axes{};
+    std::iota(axes.begin(), axes.end(), size_t{0});
+    for (auto& simplex : result) {
+      for (size_t j = 0; j < Dim; ++j) {
+        simplex[j + 1] = simplex[j] | (size_t{1} << axes[j]);
+      }
+      std::ranges::next_permutation(axes);
+    }
+    return result;
+  }();
+
+  // Unflatten the index, the last axis is the fastest.
+  static constexpr auto unflatten_(size_t flat_index, const VecIndex_& dims)
+      -> VecIndex_ {
+    VecIndex_ index{};
+    for (size_t i = Dim; i-- > 0; flat_index /= dims[i]) {
+      index[i] = flat_index % dims[i];
+    }
+    return index;
+  }
+
+  // Position of the grid node, which is the center of the grid cell.
+  constexpr auto node_point_(const VecIndex_& node) const -> Point {
+    return grid_.box().low() +
+           (vec_cast<Num>(node) + Point(Num{0.5})) * grid_.cell_extents();
+  }
+
+  // Extract the iso-surface facets from the cube between the grid nodes.
+  void polygonize_cube_(const VecIndex_& low, std::vector<Point>& out) const {
+    std::array<Point, num_corners_> x{};
+    std::array<Num, num_corners_> c{};
+    bool any_inside = false;
+    bool any_outside = false;
+    for (size_t k = 0; k < num_corners_; ++k) {
+      auto node = low;
+      for (size_t i = 0; i < Dim; ++i) node[i] += (k >> i) & 1;
+      const auto flat_node = grid_.flatten_cell_index(node);
+      if (active_[flat_node] == 0) return;
+      x[k] = node_point_(node), c[k] = color_[flat_node];
+      if (c[k] >= iso_value_) any_inside = true;
+      else any_outside = true;
+    }
+    if (!any_inside || !any_outside) return;
+    for (const auto& simplex : simplices_) {
+      std::array<Point, Dim + 1> sx{};
+      std::array<Num, Dim + 1> sc{};
+      for (size_t j = 0; j <= Dim; ++j) {
+        sx[j] = x[simplex[j]], sc[j] = c[simplex[j]];
+      }
+      polygonize_simplex_(sx, sc, out);
+    }
+  }
+
+  // Extract the iso-surface facets from the simplex.
+  void polygonize_simplex_(const std::array<Point, Dim + 1>& x,
+                           const std::array<Num, Dim + 1>& c,
+                           std::vector<Point>& out) const {
+    // Split the simplex vertices into the inside and the outside ones.
+    std::array<size_t, Dim + 1> in{};
+    std::array<size_t, Dim + 1> ex{};
+    size_t num_in = 0;
+    size_t num_ex = 0;
+    Point in_center{};
+    Point ex_center{};
+    for (size_t j = 0; j <= Dim; ++j) {
+      if (c[j] >= iso_value_) {
+        in[num_in++] = j;
+        in_center += x[j];
+      } else {
+        ex[num_ex++] = j;
+        ex_center += x[j];
+      }
+    }
+    if (num_in == 0 || num_ex == 0) return;
+
+    // Facets are oriented along the direction from the inside vertices to
+    // the outside ones.
+    const auto dir = ex_center / static_cast<Num>(num_ex) -
+                     in_center / static_cast<Num>(num_in);
+    const auto edge_point = [&x, &c, this](size_t i, size_t j) {
+      const auto t = (iso_value_ - c[i]) / (c[j] - c[i]);
+      return x[i] + t * (x[j] - x[i]);
+    };
+    const auto emit = [&dir, &out](std::array<Point, Dim> facet) {
+      if constexpr (Dim == 2) {
+        const auto t = facet[1] - facet[0];
+        if (dot(Point{t[1], -t[0]}, dir) < Num{0.0}) {
+          std::swap(facet[0], facet[1]);
+        }
+      } else {
+        const auto n = cross(facet[1] - facet[0], facet[2] - facet[0]);
+        if (dot(n, dir) < Num{0.0}) std::swap(facet[1], facet[2]);
+      }
+      out.insert(out.end(), facet.begin(), facet.end());
+    };
+
+    // Single vertex is separated from the rest: the facet crosses all of
+    // its edges.
+    if (num_in == 1 || num_ex == 1) {
+      const auto lone = num_in == 1 ? in[0] : ex[0];
+      std::array<Point, Dim> facet{};
+      for (size_t j = 0, k = 0; j <= Dim; ++j) {
+        if (j != lone) facet[k++] = edge_point(lone, j);
+      }
+      emit(facet);
+      return;
+    }
+
+    // Two vertices are separated from the other two (3D only): the
+    // iso-surface is a quadrilateral, split into two triangles.
+    if constexpr (Dim == 3) {
+      const auto p_00 = edge_point(in[0], ex[0]);
+      const auto p_01 = edge_point(in[0], ex[1]);
+      const auto p_11 = edge_point(in[1], ex[1]);
+      const auto p_10 = edge_point(in[1], ex[0]);
+      emit({p_00, p_01, p_11});
+      emit({p_00, p_11, p_10});
+    }
+  }
+
+  // Write the free surface mesh into a time step or its snapshot.
+  template<class TimeStep>
+  void write_(TimeStep&& time_step) const {
+    TIT_ASSUME_UNIVERSAL(TimeStep, time_step);
+    time_step.varyings().create_array("surface", std::span{vertices_});
+  }
+
+  Kernel kernel_;
+  Num spacing_;
+  Num iso_value_;
+  geom::Grid<Point> grid_;
+  std::vector<size_t> surface_;
+  std::vector<uint8_t> active_;
+  std::vector<Num> color_;
+  std::vector<std::vector<Point>> thread_vertices_;
+  std::vector<Point> vertices_;
+
+}; // class SurfaceMesh
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
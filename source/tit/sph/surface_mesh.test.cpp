@@ -0,0 +1,102 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <limits>
+#include <numbers>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/surface_mesh.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the particle fields needed for the surface.
+using SurfaceEquations = EquationsStub<
+    meta::Set{sph::r, sph::h, sph::parinfo, sph::m, sph::rho, sph::FS},
+    meta::Set{sph::r, sph::parinfo, sph::FS}>;
+
+TEST_CASE("sph::SurfaceMesh") {
+  constexpr double width = 1.0;
+  constexpr double disk_radius = 8.0;
+  const sph::CubicSplineKernel kernel{};
+
+  // Setup the particles on a lattice that fills the disk, with the outer
+  // layer flagged as the free surface.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, SurfaceEquations{}};
+  for (int i = -10; i <= 10; ++i) {
+    for (int j = -10; j <= 10; ++j) {
+      const Vec x{static_cast<double>(i), static_cast<double>(j)};
+      if (norm(x) > disk_radius) continue;
+      const auto a = particles.append(sph::ParticleType::fluid);
+      sph::r[a] = x;
+      sph::FS[a] = norm(x) > disk_radius - 1.5 ?
+                       std::numeric_limits<double>::min() :
+                       1.0;
+    }
+  }
+  sph::h[particles] = width;
+  sph::m[particles] = 1.0;
+  sph::rho[particles] = 1.0;
+  sph::ParticleMesh mesh{geom::GridSearch{kernel.radius(width)}};
+  mesh.update(particles, [&kernel](auto a) {
+    return kernel.radius(sph::h[a]);
+  });
+
+  // Reconstruct the surface.
+  sph::SurfaceMesh surface{sph::Space<double, 2>{}, kernel, 0.25};
+  surface.reconstruct(mesh, particles);
+  REQUIRE(surface.num_facets() > 0);
+  const auto vertices = surface.vertices();
+  REQUIRE(vertices.size() == 2 * surface.num_facets());
+  double length = 0.0;
+  for (size_t i = 0; i < vertices.size(); i += 2) {
+    const auto& p = vertices[i];
+    const auto& q = vertices[i + 1];
+
+    // Surface is near the edge of the disk.
+    CHECK(norm(p) >= disk_radius - 1.0);
+    CHECK(norm(p) <= disk_radius + 1.5);
+
+    // Normals point out of the fluid.
+    const auto t = q - p;
+    CHECK(dot(Vec{t[1], -t[0]}, p + q) >= 0.0);
+    length += norm(t);
+  }
+
+  // Surface is a closed curve around the disk.
+  CHECK(length >= 2 * std::numbers::pi * (disk_radius - 1.0));
+  CHECK(length <= 2 * std::numbers::pi * (disk_radius + 1.5) * 1.1);
+
+  // Write the surface.
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  surface.write(0.0, series);
+  const auto step = series.last_time_step();
+  const auto array = step.varyings().find_array("surface");
+  REQUIRE(array.has_value());
+  CHECK(array->size() == vertices.size());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,18 +5,34 @@
 
 #pragma once
 
+#include <any>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <functional>
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/meta.hpp"
 #include "tit/core/par/algorithms.hpp"
 #include "tit/core/profiler.hpp"
-
+#include "tit/core/serialization.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/stream.hpp"
 #include "tit/core/type_utils.hpp"
+
+#include "tit/sparse/solver.hpp"
+
+#include "tit/sph/diagnostics.hpp"
 #include "tit/sph/field.hpp"
 #include "tit/sph/fluid_equations.hpp"
 #include "tit/sph/particle_array.hpp"
 #include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/sleep.hpp"
+#include "tit/sph/time_step.hpp"
 
 namespace tit::sph {
 
@@ -26,6 +42,30 @@ namespace tit::sph {
 template<class EE>
 concept explicit_equations = specialization_of<EE, FluidEquations>;
 
+namespace impl {
+
+// Scratch buffer of the time integrator. Its type depends on the particle
+// array, which is only known once the integrator makes a step, so it is
+// type-erased. Buffer is owned by the integrator, so that the integrators
+// that run on the same thread do not share it.
+class ScratchBuffer final {
+public:
+
+  // Get the buffer of the given type, constructing it if necessary.
+  template<std::default_initializable Buffer>
+  auto get() -> Buffer& {
+    if (auto* const buffer = std::any_cast<Buffer>(&buffer_)) return *buffer;
+    return buffer_.emplace<Buffer>();
+  }
+
+private:
+
+  std::any buffer_;
+
+}; // class ScratchBuffer
+
+} // namespace impl
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Kick-Drift Euler time integrator.
@@ -41,6 +81,10 @@ public:
   static constexpr auto modified_fields =
       Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
 
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
   /// Construct time integrator.
   ///
   /// @param equations Equations to integrate.
@@ -49,17 +93,25 @@ public:
       : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq} {}
 
   /// Make a step in time.
+  ///
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
   template<particle_mesh ParticleMesh,
-           particle_array<required_fields> ParticleArray>
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
   void step(particle_num_t<ParticleArray> dt,
             ParticleMesh& mesh,
-            ParticleArray& particles) {
+            ParticleArray& particles,
+            Observe&& observe = {}) {
     TIT_PROFILE_SECTION("EulerIntegrator::step()");
     using PV = ParticleView<ParticleArray>;
 
     // Initialize particles, build the mesh.
     if (step_index_ == 0) equations_.init(particles);
-    if (step_index_ % mesh_update_freq_ == 0) equations_.index(mesh, particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
+    equations_.cache_pairs(mesh, particles);
 
     // Setup boundary conditions.
     equations_.setup_boundary(mesh, particles);
@@ -67,17 +119,17 @@ public:
     // Update particle density.
     equations_.compute_density(mesh, particles);
     if constexpr (has<PV>(drho_dt)) {
-      par::for_each(particles.fluid(),
-                    [dt](PV a) { rho[a] += dt * drho_dt[a]; });
+      equations_.integrated_for_each(particles,
+                                     [dt](PV a) { rho[a] += dt * drho_dt[a]; });
     }
 
     // Update particle velocty, internal energy, etc.
-    equations_.compute_forces(mesh, particles);
-    par::for_each(particles.fluid(), [dt](PV a) {
+    equations_.compute_forces(mesh, particles, [dt, &observe](PV a) {
       v[a] += dt * dv_dt[a];
       r[a] += dt * v[a]; // Kick-Drift: position is updated after velocity.
       if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
       if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
+      if (a.is_fluid()) observe(a);
     });
 
     // Apply particle shifting.
@@ -90,6 +142,16 @@ public:
     step_index_ += 1;
   }
 
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+  }
+
 private:
 
   [[no_unique_address]] Equations equations_{};
@@ -113,6 +175,10 @@ public:
   static constexpr auto modified_fields =
       Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
 
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
   /// Construct time integrator.
   ///
   /// @param equations Equations to integrate.
@@ -122,17 +188,25 @@ public:
       : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq} {}
 
   /// Make a step in time.
+  ///
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
   template<particle_mesh ParticleMesh,
-           particle_array<required_fields> ParticleArray>
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
   void step(particle_num_t<ParticleArray> dt,
             ParticleMesh& mesh,
-            ParticleArray& particles) {
+            ParticleArray& particles,
+            Observe&& observe = {}) {
     TIT_PROFILE_SECTION("LeapfrogIntegrator::step()");
     using PV = ParticleView<ParticleArray>;
 
     // Initialize and index particles.
     if (step_index_ == 0) equations_.init(particles);
-    if (step_index_ % mesh_update_freq_ == 0) equations_.index(mesh, particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
+    equations_.cache_pairs(mesh, particles);
 
     // Setup boundary conditions.
     equations_.setup_boundary(mesh, particles);
@@ -140,27 +214,27 @@ public:
     // Update particle velocity to the half step, and position to the full
     // step.
     const auto dt_2 = dt / 2;
-    equations_.compute_forces(mesh, particles);
-    par::for_each(particles.fluid(), [dt, dt_2](PV a) {
+    equations_.compute_forces(mesh, particles, [dt, dt_2](PV a) {
       v[a] += dt_2 * dv_dt[a];
       r[a] += dt * v[a]; // Kick-Drift: position is updated after velocity.
       if constexpr (has<PV>(u, du_dt)) u[a] += dt_2 * du_dt[a];
       if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt_2 * dalpha_dt[a];
     });
+    equations_.cache_pairs(mesh, particles);
 
     // Update particle velocity to the full step.
     equations_.compute_density(mesh, particles);
     if constexpr (has<PV>(drho_dt)) {
-      par::for_each(particles.fluid(),
-                    [dt](PV a) { rho[a] += dt * drho_dt[a]; });
+      equations_.integrated_for_each(particles,
+                                     [dt](PV a) { rho[a] += dt * drho_dt[a]; });
     }
 
     // Update particle velocity to the full step.
-    equations_.compute_forces(mesh, particles);
-    par::for_each(particles.fluid(), [dt_2](PV a) {
+    equations_.compute_forces(mesh, particles, [dt_2, &observe](PV a) {
       v[a] += dt_2 * dv_dt[a]; // Kick.
       if constexpr (has<PV>(u, du_dt)) u[a] += dt_2 * du_dt[a];
       if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt_2 * dalpha_dt[a];
+      if (a.is_fluid()) observe(a);
     });
 
     // Apply particle shifting, if necessary.
@@ -173,6 +247,16 @@ public:
     step_index_ += 1;
   }
 
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+  }
+
 private:
 
   [[no_unique_address]] Equations equations_{};
@@ -183,9 +267,22 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-/// Runge-Kutta time integrator (SSPRK(3,3)).
+/// Velocity Verlet time integrator.
+///
+/// Same as the Kick-Drift-Kick Leapfrog, but the derivatives computed at the
+/// end of the step are reused for the first kick of the next step, so that
+/// the right hand sides are evaluated once per step. Derivatives are stored
+/// in the particle fields, so they follow the particles when the particle
+/// array is reordered. They are recomputed on the first step, and after the
+/// integrator is restored. Particle shifts are applied after the derivatives
+/// are computed, and are not accounted for in the reused derivatives.
+///
+/// Scheme is second-order accurate for the accelerations that depend on the
+/// positions only. Fields whose derivatives depend on the fields themselves
+/// (like the artificial viscosity switch) are integrated with the two
+/// explicit Euler half steps, which is first-order accurate.
 template<explicit_equations Equations>
-class RungeKuttaIntegrator final {
+class VelocityVerletIntegrator final {
 public:
 
   /// Set of particle fields that are required.
@@ -196,32 +293,59 @@ public:
   static constexpr auto modified_fields =
       Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
 
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
   /// Construct time integrator.
-  constexpr explicit RungeKuttaIntegrator(Equations equations,
-                                          size_t mesh_update_freq = 10) noexcept
+  ///
+  /// @param equations Equations to integrate.
+  constexpr explicit VelocityVerletIntegrator(
+      Equations equations,
+      size_t mesh_update_freq = 10) noexcept
       : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq} {}
 
   /// Make a step in time.
+  ///
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
   template<particle_mesh ParticleMesh,
-           particle_array<required_fields> ParticleArray>
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
   void step(particle_num_t<ParticleArray> dt,
             ParticleMesh& mesh,
-            ParticleArray& particles) {
-    TIT_PROFILE_SECTION("RungeKuttaIntegrator::step()");
+            ParticleArray& particles,
+            Observe&& observe = {}) {
+    TIT_PROFILE_SECTION("VelocityVerletIntegrator::step()");
     using PV = ParticleView<ParticleArray>;
 
     // Initialize and index particles.
     if (step_index_ == 0) equations_.init(particles);
-    if (step_index_ % mesh_update_freq_ == 0) equations_.index(mesh, particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
 
-    // Run the SSPRK(3,3) substeps.
-    /// @todo We should copy only the needed fields, and not the whole array.
-    const auto old_particles(particles);
-    substep_(dt, mesh, particles);
-    substep_(dt, mesh, particles);
-    lincomb_(0.75, old_particles, 0.25, particles);
-    substep_(dt, mesh, particles);
-    lincomb_(1.0 / 3.0, old_particles, 2.0 / 3.0, particles);
+    // Compute the derivatives of the current state, if they are not known
+    // from the previous step.
+    if (!has_derivatives_) {
+      derivatives_(mesh, particles);
+      has_derivatives_ = true;
+    }
+
+    // Update particle velocity and density to the half step, and position
+    // to the full step.
+    const auto dt_2 = dt / 2;
+    equations_.integrated_for_each(particles, [dt, dt_2](PV a) {
+      kick_(a, dt_2);
+      r[a] += dt * v[a]; // Kick-Drift: position is updated after velocity.
+    });
+
+    // Update particle velocity and density to the full step. Derivatives are
+    // reused on the next step.
+    derivatives_(mesh, particles, [dt_2, &observe](PV a) {
+      kick_(a, dt_2);
+      if (a.is_fluid()) observe(a);
+    });
 
     // Apply particle shifting, if necessary.
     if constexpr (has<PV>(dr)) {
@@ -233,60 +357,790 @@ public:
     step_index_ += 1;
   }
 
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+    has_derivatives_ = false;
+  }
+
 private:
 
-  // Do an explicit Euler substep.
+  // Compute the derivatives of the current state.
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
-  void substep_(particle_num_t<ParticleArray> dt,
-                ParticleMesh& mesh,
-                ParticleArray& particles) {
+  void derivatives_(ParticleMesh& mesh, ParticleArray& particles) const {
+    equations_.cache_pairs(mesh, particles);
+    equations_.setup_boundary(mesh, particles);
+    equations_.compute_density_and_forces(mesh, particles);
+  }
+
+  // Compute the derivatives of the current state, and then update the
+  // particles, see `FluidEquations::compute_density_and_forces`.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Update>
+  void derivatives_(ParticleMesh& mesh,
+                    ParticleArray& particles,
+                    const Update& update) const {
+    equations_.cache_pairs(mesh, particles);
+    equations_.setup_boundary(mesh, particles);
+    equations_.compute_density_and_forces(mesh, particles, update);
+  }
+
+  // Kick the particle.
+  template<class PV>
+  static constexpr void kick_(PV a, particle_num_t<PV> dt) noexcept {
+    v[a] += dt * dv_dt[a];
+    if constexpr (has<PV>(drho_dt)) rho[a] += dt * drho_dt[a];
+    if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
+    if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
+  }
+
+  [[no_unique_address]] Equations equations_{};
+  size_t mesh_update_freq_;
+  size_t step_index_ = 0;
+  bool has_derivatives_ = false;
+
+}; // class VelocityVerletIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Kick-Drift-Kick Leapfrog time integrator with hierarchical block time
+/// steps.
+///
+/// Each fluid particle is assigned to a time bin, such that the particle time
+/// step is `dt / 2^time_bin`, where `dt` is the step passed to `step`. The
+/// step is split into the substeps of the smallest bin. All the particles are
+/// drifted on each substep, but the forces are recomputed only for the
+/// particles that complete their own step (the active particles). Auxiliary
+/// fields (like velocity divergence) are recomputed for the neighbors of the
+/// active particles too, since the forces of the active particles depend on
+/// them.
+template<explicit_equations Equations>
+class BlockKickDriftKickIntegrator final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Equations::required_fields | TimeStepController::required_fields |
+      meta::Set{parinfo, time_bin, r, v, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields =
+      Equations::modified_fields | meta::Set{parinfo, time_bin, r, v, u, alpha};
+
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
+  /// Construct time integrator.
+  ///
+  /// @param equations  Equations to integrate.
+  /// @param time_step  Time step controller to assign the time bins.
+  /// @param num_bins   Number of the time bins.
+  constexpr explicit BlockKickDriftKickIntegrator(
+      Equations equations,
+      TimeStepController time_step,
+      size_t num_bins = 4,
+      size_t mesh_update_freq = 10) noexcept
+      : equations_{std::move(equations)}, time_step_{std::move(time_step)},
+        num_bins_{num_bins}, mesh_update_freq_{mesh_update_freq} {
+    TIT_ASSERT(num_bins_ > 0, "Number of time bins must be positive!");
+    TIT_ASSERT(num_bins_ <= 8, "Number of time bins is too large!");
+  }
+
+  /// Make a step in time.
+  ///
+  /// @param dt      Time step of the largest time bin.
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            Observe&& observe = {}) {
+    TIT_PROFILE_SECTION("BlockKickDriftKickIntegrator::step()");
     using PV = ParticleView<ParticleArray>;
 
-    // Calculate right hand sides for the given particle array.
+    // Initialize and index particles.
+    if (step_index_ == 0) equations_.init(particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
+    equations_.cache_pairs(mesh, particles);
+
+    // Compute the forces for all the particles, assign the time bins and
+    // open the particle steps.
+    const auto num_substeps = size_t{1} << (num_bins_ - 1);
+    const auto substep_dt = dt / num_substeps;
     equations_.setup_boundary(mesh, particles);
-    equations_.compute_density(mesh, particles);
-    equations_.compute_forces(mesh, particles);
+    equations_.compute_forces(mesh, particles, [this, dt](PV a) {
+      time_bin[a] = bin_(a, dt, /*substep=*/0);
+      kick_(a, bin_dt_(dt, time_bin[a]) / 2);
+    });
+
+    // Run the substeps.
+    auto& derivatives = derivatives_.get<Derivatives_<ParticleArray>>();
+    for (size_t substep = 1; substep <= num_substeps; ++substep) {
+      // Drift all the particles.
+      par::for_each(particles.fluid(),
+                    [substep_dt](PV a) { r[a] += substep_dt * v[a]; });
+      equations_.cache_pairs(mesh, particles);
+
+      // Update the density of all the particles.
+      equations_.setup_boundary(mesh, particles);
+      equations_.compute_density(mesh, particles);
+      if constexpr (has<PV>(drho_dt)) {
+        equations_.integrated_for_each(particles, [substep_dt](PV a) {
+          rho[a] += substep_dt * drho_dt[a];
+        });
+      }
+
+      // Compute the forces for the active particles only, and keep the
+      // derivatives of the inactive ones.
+      const auto is_active = [this, &particles, substep](size_t index) {
+        if (!particles.has_type(index, ParticleType::fluid)) return false;
+        return substep % bin_span_(time_bin[particles[index]]) == 0;
+      };
+      derivatives.store(particles);
+      activate_neighbors_(mesh, particles.size(), is_active);
+      equations_.compute_forces(mesh, particles);
+      mesh.activate_all();
+      derivatives.restore(particles, std::not_fn(is_active));
+
+      // Close the steps of the active particles and open the next ones.
+      par::for_each(particles.fluid(), [&](PV a) {
+        if (!is_active(a.index())) return;
+        kick_(a, bin_dt_(dt, time_bin[a]) / 2);
+        if (substep == num_substeps) {
+          // All the particles are active on the last substep.
+          observe(a);
+          return;
+        }
+        time_bin[a] = bin_(a, dt, substep);
+        kick_(a, bin_dt_(dt, time_bin[a]) / 2);
+      });
+    }
+
+    // Apply particle shifting, if necessary.
+    if constexpr (has<PV>(dr)) {
+      equations_.compute_shifts(mesh, particles);
+      par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
+    }
+
+    // Increment step index.
+    step_index_ += 1;
+  }
+
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+    time_step_.checkpoint(out);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+    time_step_.restore(in);
+  }
+
+private:
+
+  // Time step of the time bin.
+  template<class Num>
+  static constexpr auto bin_dt_(Num dt, size_t bin) noexcept -> Num {
+    return dt / static_cast<Num>(size_t{1} << bin);
+  }
+
+  // Number of the substeps the time bin spans.
+  constexpr auto bin_span_(size_t bin) const noexcept -> size_t {
+    return size_t{1} << (num_bins_ - 1 - bin);
+  }
+
+  // Find the time bin for the particle which step starts at the substep.
+  // The particle step must be stable and end at the boundary of its bin.
+  template<class PV>
+  constexpr auto bin_(PV a,
+                      particle_num_t<PV> dt,
+                      size_t substep) const noexcept -> uint8_t {
+    const auto particle_dt = time_step_.particle_dt(a);
+    size_t bin = 0;
+    while (bin + 1 < num_bins_ &&
+           (bin_dt_(dt, bin) > particle_dt || substep % bin_span_(bin) != 0)) {
+      bin += 1;
+    }
+    return static_cast<uint8_t>(bin);
+  }
+
+  // Kick the particle.
+  template<class PV>
+  static constexpr void kick_(PV a, particle_num_t<PV> dt) noexcept {
+    v[a] += dt * dv_dt[a];
+    if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
+    if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
+  }
+
+  // Restrict the mesh to the pairs that touch the active particles or their
+  // neighbors. Every pair of a neighbor is then processed, so its auxiliary
+  // fields are complete once the forces of the active particles use them.
+  template<particle_mesh ParticleMesh, std::predicate<size_t> ActivePred>
+  void activate_neighbors_(ParticleMesh& mesh,
+                           size_t num_particles,
+                           const ActivePred& is_active) {
+    mesh.activate(is_active);
+    neighbors_.assign(num_particles, 0);
+    par::for_each(mesh.block_edges(), [this](auto block) {
+      for (const auto& [a, b] : block) {
+        std::atomic_ref{neighbors_[a]}.store(1, std::memory_order_relaxed);
+        std::atomic_ref{neighbors_[b]}.store(1, std::memory_order_relaxed);
+      }
+    });
+    mesh.activate([this](size_t index) { return neighbors_[index] != 0; });
+  }
+
+  // Snapshot of the fields that are computed by the forces pass.
+  template<particle_array ParticleArray>
+  using Derivatives_ =
+      ParticleSnapshot<
+          ParticleArray,
+          decltype(meta::Set{dv_dt, du_dt, dalpha_dt, div_v, curl_v})>;
+
+  [[no_unique_address]] Equations equations_{};
+  TimeStepController time_step_;
+  size_t num_bins_;
+  size_t mesh_update_freq_;
+  size_t step_index_ = 0;
+  std::vector<uint8_t> neighbors_;
+  impl::ScratchBuffer derivatives_;
+
+}; // class BlockKickDriftKickIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Incompressible SPH (ISPH) projection time integrator.
+///
+/// Velocities are first predicted with all of the forces, including the
+/// pressure forces of the last projected pressure, and then projected onto
+/// the divergence-free field with the pressure increment (incremental
+/// pressure projection), see `FluidEquations::project_velocity`. Particles
+/// are drifted with the projected velocities, and the density is not evolved.
+///
+/// Time step is only limited by the flow velocity and the forces, not by the
+/// sound speed, so it may be an order of magnitude larger than with the
+/// weakly-compressible integrators. Equations must use the
+/// `IncompressibleEquationOfState`.
+template<explicit_equations Equations,
+         class Solver = sparse::ConjugateGradientSolver>
+class ProjectionIntegrator final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Equations::required_fields | meta::Set{parinfo, r, v, p, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields =
+      Equations::modified_fields | meta::Set{parinfo, r, v, p, u, alpha};
+
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
+  /// Construct time integrator.
+  ///
+  /// @param equations Equations to integrate.
+  /// @param solver    Linear solver for the pressure Poisson equation.
+  constexpr explicit ProjectionIntegrator(Equations equations,
+                                          Solver solver = {},
+                                          size_t mesh_update_freq = 10) noexcept
+      : equations_{std::move(equations)}, solver_{std::move(solver)},
+        mesh_update_freq_{mesh_update_freq} {}
+
+  /// Result of the last pressure Poisson equation solve.
+  constexpr auto last_solve() const noexcept -> const sparse::SolverResult& {
+    return last_solve_;
+  }
+
+  /// Make a step in time.
+  ///
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            Observe&& observe = {}) {
+    TIT_PROFILE_SECTION("ProjectionIntegrator::step()");
+    using PV = ParticleView<ParticleArray>;
+
+    // Initialize and index particles.
+    if (step_index_ == 0) equations_.init(particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
+    equations_.cache_pairs(mesh, particles);
 
-    // Integrate.
-    par::for_each(particles.fluid(), [dt](PV a) {
-      r[a] += dt * v[a]; // Drift-Kick: position is updated before velocity.
+    // Predict the particle velocities.
+    equations_.setup_boundary(mesh, particles);
+    equations_.compute_forces(mesh, particles, [dt](PV a) {
       v[a] += dt * dv_dt[a];
-      if constexpr (has<PV>(drho_dt)) rho[a] += dt * drho_dt[a];
       if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
       if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
     });
+
+    // Project the velocities, so that the boundary velocities follow the
+    // predicted ones, and drift the particles.
+    equations_.setup_boundary(mesh, particles);
+    last_solve_ = equations_.project_velocity(dt, mesh, particles, solver_);
+    TIT_STATS("ProjectionIntegrator::residual", last_solve_.residual);
+    par::for_each(particles.fluid(), [dt, &observe](PV a) {
+      r[a] += dt * v[a];
+      observe(a);
+    });
+
+    // Apply particle shifting, if necessary. Normals are computed by the
+    // density pass.
+    if constexpr (has<PV>(dr)) {
+      equations_.cache_pairs(mesh, particles);
+      equations_.compute_density(mesh, particles);
+      equations_.compute_shifts(mesh, particles);
+      par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
+    }
+
+    // Increment step index.
+    step_index_ += 1;
+  }
+
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+  }
+
+private:
+
+  [[no_unique_address]] Equations equations_;
+  [[no_unique_address]] Solver solver_;
+  size_t mesh_update_freq_;
+  size_t step_index_ = 0;
+  sparse::SolverResult last_solve_{};
+
+}; // class ProjectionIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Boundary update frequency of the multistage time integrators.
+enum class BoundaryUpdate : uint8_t {
+  /// Update the boundary particles before each stage.
+  each_stage,
+
+  /// Update the boundary particles before the first stage only. The boundary
+  /// state is held fixed during the step, which saves the interpolations of
+  /// the later stages, at the cost of the boundary values lagging behind the
+  /// fluid ones by up to one step.
+  each_step,
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Runge-Kutta time integrator (SSPRK(3,3)).
+///
+/// If the sleep controller is enabled and the particles have the
+/// `quiet_steps` field, the quiescent fluid particles are put to sleep, and
+/// only the pairs with at least one particle near the awake ones are
+/// evaluated, see `SleepController`.
+template<explicit_equations Equations>
+class RungeKuttaIntegrator final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Equations::required_fields | meta::Set{parinfo, r, v, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields =
+      Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
+
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
+  /// Construct time integrator.
+  constexpr explicit RungeKuttaIntegrator(
+      Equations equations,
+      size_t mesh_update_freq = 10,
+      BoundaryUpdate boundary_update = BoundaryUpdate::each_stage) noexcept
+      : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq},
+        boundary_update_{boundary_update} {}
+
+  /// Enable the deactivation of the quiescent particles. Particles must have
+  /// the `quiet_steps` field.
+  void enable_sleep(SleepController sleep) {
+    sleep_ = std::move(sleep);
+  }
+
+  /// Sleep controller, if enabled.
+  constexpr auto sleep() const noexcept
+      -> const std::optional<SleepController>& {
+    return sleep_;
+  }
+
+  /// Make a step in time.
+  ///
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            Observe&& observe = {}) {
+    TIT_PROFILE_SECTION("RungeKuttaIntegrator::step()");
+    using PV = ParticleView<ParticleArray>;
+
+    // Initialize and index particles.
+    if (step_index_ == 0) equations_.init(particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
+    equations_.cache_pairs(mesh, particles);
+
+    // Search for the neighbors of the next mesh rebuild in background.
+    if constexpr (requires { equations_.speculate(mesh, particles, dt); }) {
+      equations_.speculate(mesh, particles, dt);
+    }
+
+    // Put the quiescent particles to sleep and wake up the disturbed ones,
+    // and restrict the pairs to the ones near the awake particles. Particle
+    // accelerations are only known after the first step.
+    bool sleeping = false;
+    auto& held_derivatives =
+        held_derivatives_.get<HeldDerivatives_<ParticleArray>>();
+    if constexpr (has<PV>(quiet_steps)) {
+      sleeping = sleep_.has_value() && step_index_ > 0;
+      if (sleeping) {
+        sleep_->update(particles);
+        held_derivatives.store(particles);
+      }
+    }
+
+    // Store the integrated fields of the current state.
+    auto& old_state = old_state_.get<Snapshot_<ParticleArray>>();
+    old_state.store(particles);
+    Profiler::track_memory("RungeKuttaIntegrator::old_state",
+                           old_state.memory_usage());
+
+    // Run the SSPRK(3,3) substeps.
+    const auto each_stage = boundary_update_ == BoundaryUpdate::each_stage;
+    substep_(dt, mesh, particles, /*update_boundary=*/true, sleeping);
+    substep_(dt, mesh, particles, each_stage, sleeping);
+    lincomb_(0.75, old_state, 0.25, particles, sleeping);
+    substep_(dt, mesh, particles, each_stage, sleeping);
+    if (sleeping) {
+      // Hold the derivatives of the sleeping particles whose pairs were not
+      // evaluated, so that they stay asleep, and lift the pair restriction.
+      held_derivatives.restore(particles, [&particles, this](size_t index) {
+        return particles.has_type(index, ParticleType::fluid) &&
+               !sleep_->paired(index);
+      });
+      mesh.activate_all();
+    }
+    lincomb_(1.0 / 3.0, old_state, 2.0 / 3.0, particles, sleeping, observe);
+
+    // Apply particle shifting, if necessary.
+    if constexpr (has<PV>(dr)) {
+      equations_.cache_pairs(mesh, particles);
+      equations_.compute_shifts(mesh, particles);
+      par::for_each(particles.fluid(), [sleeping, this](PV a) {
+        if (active_(a, sleeping)) r[a] += dr[a];
+      });
+    }
+
+    // Increment step index.
+    step_index_ += 1;
   }
 
-  // Compute the linear combination of the two substeps.
-  template<particle_array<required_fields> ParticleArray>
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+  }
+
+private:
+
+  // Do an explicit Euler substep. If the particles are sleeping, only the
+  // active particles are integrated.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void substep_(particle_num_t<ParticleArray> dt,
+                ParticleMesh& mesh,
+                ParticleArray& particles,
+                bool update_boundary,
+                bool sleeping) {
+    using PV = ParticleView<ParticleArray>;
+
+    // Calculate right hand sides for the given particle array, and
+    // integrate. Pairs must be restricted after each caching, since the
+    // caching may prune them.
+    equations_.cache_pairs(mesh, particles);
+    if (sleeping) {
+      mesh.activate([this](size_t index) { return sleep_->paired(index); });
+    }
+    if (update_boundary) equations_.setup_boundary(mesh, particles);
+    equations_.compute_density_and_forces(
+        mesh,
+        particles,
+        [dt, sleeping, this](PV a) {
+          if (!active_(a, sleeping)) return;
+          r[a] += dt * v[a]; // Drift-Kick: position is updated first.
+          v[a] += dt * dv_dt[a];
+          if constexpr (has<PV>(drho_dt)) rho[a] += dt * drho_dt[a];
+          if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
+          if constexpr (has<PV>(alpha, dalpha_dt)) {
+            alpha[a] += dt * dalpha_dt[a];
+          }
+        });
+  }
+
+  // Snapshot of the fields that are integrated in time.
+  template<particle_array ParticleArray>
+  using Snapshot_ =
+      ParticleSnapshot<ParticleArray,
+                       decltype(meta::Set{r, v, rho, u, alpha})>;
+
+  // Snapshot of the time derivatives that are held for the sleeping
+  // particles.
+  template<particle_array ParticleArray>
+  using HeldDerivatives_ =
+      ParticleSnapshot<ParticleArray,
+                       decltype(meta::Set{dv_dt, drho_dt, du_dt, dalpha_dt})>;
+
+  // Check if the particle is integrated in time, see
+  // `SleepController::active`.
+  template<class PV>
+  constexpr auto active_(PV a, bool sleeping) const noexcept -> bool {
+    if constexpr (has<PV>(quiet_steps)) {
+      if (sleeping) return sleep_->active(a);
+    }
+    return true;
+  }
+
+  // Compute the linear combination of the snapshot and the current state of
+  // the active particles, and then observe the fluid particles.
+  template<particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
   void lincomb_(particle_num_t<ParticleArray> weight,
-                const ParticleArray& particles,
+                const Snapshot_<ParticleArray>& snapshot,
                 particle_num_t<ParticleArray> out_weight,
-                ParticleArray& out_particles) {
+                ParticleArray& out_particles,
+                bool sleeping,
+                Observe&& observe = {}) const {
     using PV = ParticleView<ParticleArray>;
-    par::for_each( //
-        out_particles.fluid(),
-        [out_weight, weight, &particles](PV out_a) {
-          const auto a = particles[out_a.index()];
-          r[out_a] = weight * r[a] + out_weight * r[out_a];
-          v[out_a] = weight * v[a] + out_weight * v[out_a];
-          rho[out_a] = weight * rho[a] + out_weight * rho[out_a];
-          if constexpr (has<PV>(u)) {
-            u[out_a] = weight * u[a] + out_weight * u[out_a];
-          }
-          if constexpr (has<PV>(alpha)) {
-            alpha[out_a] = weight * alpha[a] + out_weight * alpha[out_a];
+    equations_.integrated_for_each( //
+        out_particles,
+        [out_weight, weight, &snapshot, &observe, sleeping, this](PV out_a) {
+          if (active_(out_a, sleeping)) {
+            Snapshot_<ParticleArray>::fields.for_each([&](auto field) {
+              const auto& old_value = snapshot[out_a.index(), field];
+              field[out_a] = weight * old_value + out_weight * field[out_a];
+            });
           }
+          if (out_a.is_fluid()) observe(out_a);
         });
   }
 
   [[no_unique_address]] Equations equations_;
   size_t mesh_update_freq_;
+  BoundaryUpdate boundary_update_;
+  std::optional<SleepController> sleep_;
   size_t step_index_ = 0;
+  impl::ScratchBuffer held_derivatives_;
+  impl::ScratchBuffer old_state_;
 
 }; // class RungeKuttaIntegrator
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Williamson's three-stage third-order low-storage Runge-Kutta scheme
+/// (Williamson, 1980).
+struct Williamson3Scheme final {
+  /// Increment coefficients.
+  static constexpr std::array A{0.0, -5.0 / 9.0, -153.0 / 128.0};
+
+  /// State coefficients.
+  static constexpr std::array B{1.0 / 3.0, 15.0 / 16.0, 8.0 / 15.0};
+}; // struct Williamson3Scheme
+
+/// Five-stage fourth-order low-storage Runge-Kutta scheme (Carpenter,
+/// Kennedy, 1994).
+struct CarpenterKennedy4Scheme final {
+  /// Increment coefficients.
+  static constexpr std::array A{
+      0.0,
+      -567301805773.0 / 1357537059087.0,
+      -2404267990393.0 / 2016746695238.0,
+      -3550918686646.0 / 2091501179385.0,
+      -1275806237668.0 / 842570457699.0,
+  };
+
+  /// State coefficients.
+  static constexpr std::array B{
+      1432997174477.0 / 9575080441755.0,
+      5161836677717.0 / 13612068292357.0,
+      1720146321549.0 / 2090206949498.0,
+      3134564353537.0 / 4481467310338.0,
+      2277821191437.0 / 14882151754819.0,
+  };
+}; // struct CarpenterKennedy4Scheme
+
+/// Low-storage Runge-Kutta scheme type.
+template<class Scheme>
+concept low_storage_scheme =
+    Scheme::A.size() == Scheme::B.size() && Scheme::A.front() == 0.0;
+
+/// Low-storage Runge-Kutta time integrator (Williamson form).
+///
+/// Each stage updates the increment register and then the state in place:
+/// `dq = A_i * dq + dt * f(q)`, `q += B_i * dq`. Only the increments of the
+/// integrated fields are stored, so no copy of the state is made. Higher
+/// order schemes with more stages allow larger stable time steps, at the
+/// cost of one right hand side evaluation per stage.
+template<explicit_equations Equations,
+         low_storage_scheme Scheme = Williamson3Scheme>
+class LowStorageRungeKuttaIntegrator final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Equations::required_fields | meta::Set{parinfo, r, v, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields =
+      Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
+
+  /// Set of particle fields that are meaningful for the fluid particles only.
+  static constexpr auto fluid_fields =
+      impl::equations_fluid_fields<Equations>();
+
+  /// Construct time integrator.
+  constexpr explicit LowStorageRungeKuttaIntegrator(
+      Equations equations,
+      size_t mesh_update_freq = 10,
+      Scheme /*scheme*/ = {},
+      BoundaryUpdate boundary_update = BoundaryUpdate::each_stage) noexcept
+      : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq},
+        boundary_update_{boundary_update} {}
+
+  /// Make a step in time.
+  ///
+  /// @param observe Particle observer, e.g. `Diagnostics`. It is called for
+  ///                each fluid particle once it reaches the end of the step.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observe = NoDiagnostics>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            Observe&& observe = {}) {
+    TIT_PROFILE_SECTION("LowStorageRungeKuttaIntegrator::step()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+
+    // Initialize and index particles.
+    if (step_index_ == 0) equations_.init(particles);
+    if (step_index_ % mesh_update_freq_ == 0 || !mesh.valid()) {
+      equations_.index(mesh, particles);
+    }
+
+    // Run the stages. Increments are zeroed, so that the stale values of the
+    // previous step (that may be non-finite, if the step was unstable) do
+    // not leak into the first stage, even though its coefficient `A` is zero.
+    auto& increments = increments_.get<Increments_<ParticleArray>>();
+    increments.reset(particles.size());
+    Profiler::track_memory("LowStorageRungeKuttaIntegrator::increments",
+                           increments.memory_usage());
+    for (size_t stage = 0; stage < Scheme::A.size(); ++stage) {
+      equations_.cache_pairs(mesh, particles);
+      if (stage == 0 || boundary_update_ == BoundaryUpdate::each_stage) {
+        equations_.setup_boundary(mesh, particles);
+      }
+      const auto A = static_cast<Num>(Scheme::A[stage]);
+      const auto B = static_cast<Num>(Scheme::B[stage]);
+      const auto last = stage + 1 == Scheme::A.size();
+      const auto integrate = [&increments, &observe, dt, A, B, last](PV a) {
+        const auto update = [&increments, a, A, B](auto field, auto rate) {
+          auto& increment = increments[a.index(), field];
+          increment = A * increment + rate;
+          field[a] += B * increment;
+        };
+        // Position increment uses the velocity before the update.
+        update(r, dt * v[a]);
+        update(v, dt * dv_dt[a]);
+        if constexpr (has<PV>(drho_dt)) update(rho, dt * drho_dt[a]);
+        if constexpr (has<PV>(u, du_dt)) update(u, dt * du_dt[a]);
+        if constexpr (has<PV>(alpha, dalpha_dt)) {
+          update(alpha, dt * dalpha_dt[a]);
+        }
+        if (last && a.is_fluid()) observe(a);
+      };
+      equations_.compute_density_and_forces(mesh, particles, integrate);
+    }
+
+    // Apply particle shifting, if necessary.
+    if constexpr (has<PV>(dr)) {
+      equations_.cache_pairs(mesh, particles);
+      equations_.compute_shifts(mesh, particles);
+      par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
+    }
+
+    // Increment step index.
+    step_index_ += 1;
+  }
+
+  /// Write the integrator state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, step_index_);
+  }
+
+  /// Restore the integrator state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, step_index_)) deserialization_failed();
+  }
+
+private:
+
+  // Increments of the fields that are integrated in time.
+  template<particle_array ParticleArray>
+  using Increments_ =
+      ParticleSnapshot<ParticleArray,
+                       decltype(meta::Set{r, v, rho, u, alpha})>;
+
+  [[no_unique_address]] Equations equations_;
+  size_t mesh_update_freq_;
+  BoundaryUpdate boundary_update_;
+  size_t step_index_ = 0;
+  impl::ScratchBuffer increments_;
+
+}; // class LowStorageRungeKuttaIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::sph
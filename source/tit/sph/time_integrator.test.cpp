@@ -0,0 +1,271 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ranges>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/energy_equation.hpp"
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/fluid_equations.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/momentum_equation.hpp"
+#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/time_integrator.hpp"
+#include "tit/sph/time_step.hpp"
+#include "tit/sph/viscosity.hpp"
+#include "tit/sph/wall_boundary.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+constexpr size_t lattice_size = 16;
+constexpr double dr = 0.1;
+constexpr double lattice_width = lattice_size * dr;
+constexpr double h_0 = 2.0 * dr;
+constexpr double rho_0 = 1000.0;
+constexpr double cs_0 = 10.0;
+
+// Weakly-compressible equations with the Balsara switch, so that the forces
+// depend on the velocity divergence and curl of the neighbors.
+auto make_equations() {
+  return sph::FluidEquations{
+      sph::MotionEquation{},
+      sph::ContinuityEquation{},
+      sph::MomentumEquation{
+          sph::NoViscosity{},
+          sph::BalsaraArtificialViscosity{
+              sph::AlphaBetaArtificialViscosity{}},
+      },
+      sph::NoEnergyEquation{},
+      sph::LinearTaitEquationOfState{cs_0, rho_0},
+      sph::QuarticWendlandKernel{},
+      // No walls, the lattice has no fixed particles.
+      sph::WallBoundary<Vec<double, 2>>{},
+  };
+}
+
+auto make_mesh() {
+  return sph::ParticleMesh{
+      geom::GridSearch{h_0},
+      geom::RecursiveInertialBisection{},
+      geom::GridGraphPartition{2 * h_0},
+  };
+}
+
+// Fluid lattice at rest in the left half and in the shear flow in the right
+// half, so that the particles on the right need the smaller time steps.
+template<class Integrator>
+auto make_particles(const Integrator& integrator) {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, integrator};
+  for (size_t i = 0; i < lattice_size; ++i) {
+    for (size_t j = 0; j < lattice_size; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      const auto x = static_cast<double>(i) * dr;
+      const auto y = static_cast<double>(j) * dr;
+      sph::r[a] = Vec{x, y};
+      sph::v[a] =
+          Vec{0.0, 4.0 * std::max(x - lattice_width / 2, 0.0) / lattice_width};
+    }
+  }
+  sph::m[particles] = rho_0 * dr * dr;
+  sph::h[particles] = h_0;
+  sph::rho[particles] = rho_0;
+  return particles;
+}
+
+// Stable time step of the particles at rest.
+template<class ParticleArray>
+auto max_particle_dt(const sph::TimeStepController& time_step,
+                     const ParticleArray& particles) -> double {
+  double result = 0.0;
+  for (const auto a : particles.fluid()) {
+    result = std::max(result, time_step.particle_dt(a));
+  }
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::BlockKickDriftKickIntegrator") {
+  par::set_num_threads(4);
+  constexpr size_t num_steps = 10;
+  const auto equations = make_equations();
+  const sph::TimeStepController time_step{cs_0};
+
+  SUBCASE("single bin") {
+    // With a single time bin, all the particles are active on each step, so
+    // the integrator must match the Kick-Drift-Kick Leapfrog.
+    sph::BlockKickDriftKickIntegrator block_integrator{equations,
+                                                       time_step,
+                                                       /*num_bins=*/1};
+    sph::KickDriftKickIntegrator integrator{equations};
+    auto block_particles = make_particles(block_integrator);
+    auto particles = block_particles;
+    auto block_mesh = make_mesh();
+    auto mesh = make_mesh();
+    const auto dt = max_particle_dt(time_step, particles);
+    for (size_t n = 0; n < num_steps; ++n) {
+      block_integrator.step(dt, block_mesh, block_particles);
+      integrator.step(dt, mesh, particles);
+    }
+    for (size_t i = 0; i < particles.size(); ++i) {
+      const auto a = block_particles[i];
+      const auto b = particles[i];
+      CHECK_APPROX_EQ(sph::r[a], sph::r[b]);
+      CHECK_APPROX_EQ(sph::v[a], sph::v[b]);
+      CHECK_APPROX_EQ(sph::rho[a] / rho_0, sph::rho[b] / rho_0);
+    }
+  }
+
+  SUBCASE("multiple bins") {
+    // Pairwise forces are antisymmetric, and the steps of the particles in
+    // different bins are synchronized at the end of each step, so that the
+    // total momentum is conserved up to the time discretization error.
+    sph::BlockKickDriftKickIntegrator integrator{equations,
+                                                 time_step,
+                                                 /*num_bins=*/3};
+    auto particles = make_particles(integrator);
+    auto mesh = make_mesh();
+    const auto dt = max_particle_dt(time_step, particles);
+    const auto momentum = [&particles] {
+      Vec<double, 2> result{};
+      for (const auto a : particles.fluid()) result += sph::m[a] * sph::v[a];
+      return result;
+    };
+    const auto momentum_scale = [&particles] {
+      double result = 0.0;
+      for (const auto a : particles.fluid()) {
+        result += sph::m[a] * norm(sph::v[a]);
+      }
+      return result;
+    };
+    const auto init_momentum = momentum();
+    const auto init_momentum_scale = momentum_scale();
+    for (size_t n = 0; n < num_steps; ++n) {
+      integrator.step(dt, mesh, particles);
+      if (n == 0) {
+        // Particles at rest and in the flow are in the different bins.
+        const auto [min_bin, max_bin] = std::ranges::minmax(
+            particles.fluid() |
+            std::views::transform([](auto a) { return sph::time_bin[a]; }));
+        CHECK(min_bin == uint8_t{0});
+        CHECK(max_bin > uint8_t{0});
+      }
+    }
+    CHECK(norm(momentum() - init_momentum) <= 1.0e-4 * init_momentum_scale);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+constexpr double g = 9.81;
+constexpr double alpha_min = 0.1;
+constexpr double sigma = 0.1;
+constexpr double tau = h_0 / (sigma * cs_0);
+
+// Equations with gravity and the Rosswog switch. Isolated particles fall
+// freely, and their switch relaxes as `alpha' = -(alpha - alpha_min) / tau`,
+// which is the linear test equation `y' = lambda * y`.
+auto make_relaxation_equations() {
+  return sph::FluidEquations{
+      sph::MotionEquation{},
+      sph::ContinuityEquation{},
+      sph::MomentumEquation{
+          sph::NoViscosity{},
+          sph::RosswogArtificialViscosity{
+              sph::BalsaraArtificialViscosity{
+                  sph::AlphaBetaArtificialViscosity{}},
+              alpha_min,
+              /*alpha_max=*/2.0,
+              sigma},
+          sph::GravitySource{g},
+      },
+      sph::NoEnergyEquation{},
+      sph::LinearTaitEquationOfState{cs_0, rho_0},
+      sph::QuarticWendlandKernel{},
+      // No walls, there are no fixed particles.
+      sph::WallBoundary<Vec<double, 2>>{},
+  };
+}
+
+// Integrate the isolated particles over the relaxation time with the given
+// number of steps, and return the error of the switch value. Free fall
+// trajectories must be exact, since the acceleration is constant.
+template<class Integrator>
+auto relaxation_error(Integrator integrator, size_t num_steps) -> double {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, integrator};
+  for (size_t i = 0; i < 4; ++i) {
+    const auto a = particles.append(sph::ParticleType::fluid);
+    sph::r[a] = Vec{10.0 * h_0 * static_cast<double>(i), 0.0};
+  }
+  sph::m[particles] = rho_0 * dr * dr;
+  sph::h[particles] = h_0;
+  sph::rho[particles] = rho_0;
+  sph::ParticleMesh mesh{geom::GridSearch{h_0}};
+  const auto dt = tau / static_cast<double>(num_steps);
+  for (size_t n = 0; n < num_steps; ++n) integrator.step(dt, mesh, particles);
+  const auto a = particles[0];
+  CHECK_APPROX_EQ(sph::r[a], Vec{0.0, -g * tau * tau / 2});
+  CHECK_APPROX_EQ(sph::v[a], Vec{0.0, -g * tau});
+  const auto exact_alpha = alpha_min + (1.0 - alpha_min) * std::exp(-1.0);
+  return std::abs(sph::alpha[a] - exact_alpha);
+}
+
+// Observed order of convergence of the switch value.
+template<class Integrator>
+auto convergence_order(const Integrator& integrator) -> double {
+  return std::log2(relaxation_error(integrator, 16) /
+                   relaxation_error(integrator, 32));
+}
+
+TEST_CASE("sph::VelocityVerletIntegrator") {
+  par::set_num_threads(4);
+  // Switch derivative depends on the switch itself, so it is integrated by
+  // the two explicit Euler half steps, which is only first-order accurate.
+  const sph::VelocityVerletIntegrator integrator{make_relaxation_equations()};
+  CHECK(std::abs(convergence_order(integrator) - 1.0) < 0.1);
+}
+
+TEST_CASE("sph::LowStorageRungeKuttaIntegrator") {
+  par::set_num_threads(4);
+  SUBCASE("Williamson3Scheme") {
+    const sph::LowStorageRungeKuttaIntegrator integrator{
+        make_relaxation_equations(),
+        /*mesh_update_freq=*/10,
+        sph::Williamson3Scheme{}};
+    CHECK(std::abs(convergence_order(integrator) - 3.0) < 0.1);
+  }
+  SUBCASE("CarpenterKennedy4Scheme") {
+    const sph::LowStorageRungeKuttaIntegrator integrator{
+        make_relaxation_equations(),
+        /*mesh_update_freq=*/10,
+        sph::CarpenterKennedy4Scheme{}};
+    CHECK(std::abs(convergence_order(integrator) - 4.0) < 0.1);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,192 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <limits>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Adaptive global time step controller.
+///
+/// Time step is computed as the minimum over the fluid particles of the
+/// following criteria:
+/// - sound speed (CFL) criterion: `CFL * h / (cs + |v|)`,
+/// - force criterion: `force_factor * sqrt(h / |dv_dt|)`,
+/// - viscous criterion: `viscous_factor * rho * h^2 / mu`, if viscosity
+///   is present.
+///
+/// Particle accelerations are not known before the first step, so the force
+/// criterion of the first step uses the body force acceleration `g` (if set)
+/// instead: `force_factor * sqrt(h / g)`. This bound stands for the previous
+/// step, that limits the growth of the first step.
+class TimeStepController final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{h, v, dv_dt};
+
+  /// Construct a time step controller.
+  ///
+  /// @param cs_0           Reference sound speed. Used if the sound speed
+  ///                       is not computed for the particles.
+  /// @param CFL            Courant number for the sound speed criterion.
+  /// @param force_factor   Safety factor for the force criterion.
+  /// @param viscous_factor Safety factor for the viscous criterion.
+  /// @param max_growth     Maximum ratio of the two consecutive time steps.
+  constexpr explicit TimeStepController(real_t cs_0,
+                                        real_t CFL = 0.8,
+                                        real_t force_factor = 0.25,
+                                        real_t viscous_factor = 0.125,
+                                        real_t max_growth = 1.1) noexcept
+      : cs_0_{cs_0}, CFL_{CFL}, force_factor_{force_factor},
+        viscous_factor_{viscous_factor}, max_growth_{max_growth} {
+    TIT_ASSERT(cs_0_ > 0.0, "Reference sound speed must be positive!");
+    TIT_ASSERT(CFL_ > 0.0, "Courant number must be positive!");
+    TIT_ASSERT(force_factor_ > 0.0, "Force factor must be positive!");
+    TIT_ASSERT(viscous_factor_ > 0.0, "Viscous factor must be positive!");
+    TIT_ASSERT(max_growth_ >= 1.0, "Maximum growth must be at least one!");
+  }
+
+  /// Last computed time step, zero if none was computed yet.
+  constexpr auto dt() const noexcept -> real_t {
+    return dt_;
+  }
+
+  /// Time step scale, that multiplies the stable time step.
+  constexpr auto scale() const noexcept -> real_t {
+    return scale_;
+  }
+
+  /// Set the time step scale, e.g. reduce it to retry the unstable steps.
+  /// Scale is not checkpointed.
+  constexpr void set_scale(real_t scale) noexcept {
+    TIT_ASSERT(scale > 0.0 && scale <= 1.0, "Scale must be in (0, 1]!");
+    scale_ = scale;
+  }
+
+  /// Body force acceleration magnitude, e.g. gravity.
+  constexpr auto body_force() const noexcept -> real_t {
+    return g_0_;
+  }
+
+  /// Set the body force acceleration magnitude, e.g. gravity. It bounds the
+  /// first time step, while the particle accelerations are not known yet.
+  constexpr void set_body_force(real_t g_0) noexcept {
+    TIT_ASSERT(g_0 >= 0.0, "Body force must be non-negative!");
+    g_0_ = g_0;
+  }
+
+  /// Compute the stable time step for the particle.
+  template<particle_view<required_fields> PV>
+  constexpr auto particle_dt(PV a) const noexcept -> particle_num_t<PV> {
+    using Num = particle_num_t<PV>;
+
+    // Sound speed criterion.
+    const auto cs_a = cs.get(a, static_cast<Num>(cs_0_));
+    auto dt = static_cast<Num>(CFL_) * h[a] / (cs_a + norm(v[a]));
+
+    // Force criterion. On the first step the acceleration is not known, so
+    // it is bounded by the body force.
+    auto dv_dt_a = norm(dv_dt[a]);
+    if (dt_ == 0.0) dv_dt_a = std::max(dv_dt_a, static_cast<Num>(g_0_));
+    if (!is_tiny(dv_dt_a)) {
+      dt = std::min(dt, static_cast<Num>(force_factor_) * sqrt(h[a] / dv_dt_a));
+    }
+
+    // Viscous criterion.
+    if constexpr (has<PV>(rho, mu)) {
+      if (!is_tiny(mu[a])) {
+        dt = std::min(dt,
+                      static_cast<Num>(viscous_factor_) * rho[a] * pow2(h[a]) /
+                          mu[a]);
+      }
+    }
+
+    return dt;
+  }
+
+  /// Compute the time step for the next step.
+  ///
+  /// Time step may grow at most by the factor of `max_growth` between the
+  /// consecutive steps, and the first step is limited by the body force.
+  /// Time step is never limited when shrinking, since it must remain stable.
+  template<particle_array<required_fields> ParticleArray>
+  auto operator()(const ParticleArray& particles)
+      -> particle_num_t<ParticleArray> {
+    TIT_PROFILE_SECTION("TimeStepController::operator()");
+    using PV = ParticleView<const ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+
+    // Compute the stable time step for each particle and reduce it.
+    const auto min_dt = par::transform_reduce(
+        particles.fluid(),
+        std::numeric_limits<Num>::max(),
+        [](Num dt_a, Num dt_b) { return std::min(dt_a, dt_b); },
+        [this](PV a) { return particle_dt(a); });
+
+    return (*this)(min_dt);
+  }
+
+  /// Compute the time step for the next step from the minimum of the stable
+  /// particle time steps, e.g. the one reduced by the `StableTimeStep`
+  /// diagnostics, so that the particles are not traversed again.
+  template<std::floating_point Num>
+  auto operator()(Num min_dt) -> Num {
+    TIT_ASSERT(min_dt > 0.0, "Stable time step must be positive!");
+    auto dt = static_cast<Num>(scale_) * min_dt;
+
+    // Limit the time step growth.
+    if (dt_ > 0.0) dt = std::min(dt, static_cast<Num>(max_growth_ * dt_));
+    dt_ = static_cast<real_t>(dt);
+    TIT_STATS("TimeStepController::dt", dt_);
+
+    return dt;
+  }
+
+  /// Write the time step controller state into the output stream.
+  void checkpoint(OutputStream<byte_t>& out) const {
+    serialize(out, dt_);
+  }
+
+  /// Restore the time step controller state from the input stream.
+  void restore(InputStream<byte_t>& in) {
+    if (!deserialize(in, dt_)) deserialization_failed();
+  }
+
+private:
+
+  real_t cs_0_;
+  real_t CFL_;
+  real_t force_factor_;
+  real_t viscous_factor_;
+  real_t max_growth_;
+  real_t g_0_ = 0.0;
+  real_t scale_ = 1.0;
+  real_t dt_ = 0.0;
+
+}; // class TimeStepController
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
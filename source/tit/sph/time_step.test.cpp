@@ -0,0 +1,83 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/time_step.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the fields of the time step criteria.
+using TimeStepEquations = EquationsStub<
+    meta::Set{sph::h, sph::v, sph::dv_dt, sph::rho, sph::mu},
+    meta::Set{sph::v, sph::dv_dt}>;
+
+TEST_CASE("sph::TimeStepController") {
+  // Setup a single fluid particle at rest.
+  sph::ParticleArray particles{sph::Space<double, 2>{}, TimeStepEquations{}};
+  const auto a = particles.append(sph::ParticleType::fluid);
+  sph::h[a] = 1.0;
+  sph::rho[a] = 1.0;
+  sph::TimeStepController time_step{/*cs_0=*/10.0, /*CFL=*/0.8};
+  CHECK(time_step.dt() == 0.0);
+
+  SUBCASE("sound speed criterion") {
+    CHECK_APPROX_EQ(time_step.particle_dt(a), 0.08);
+    sph::v[a] = Vec{10.0, 0.0};
+    CHECK_APPROX_EQ(time_step.particle_dt(a), 0.04);
+  }
+
+  SUBCASE("force criterion") {
+    sph::dv_dt[a] = Vec{0.0, 100.0};
+    CHECK_APPROX_EQ(time_step.particle_dt(a), 0.025);
+  }
+
+  SUBCASE("viscous criterion") {
+    sph::mu[a] = 10.0;
+    CHECK_APPROX_EQ(time_step.particle_dt(a), 0.0125);
+  }
+
+  SUBCASE("scale") {
+    time_step.set_scale(0.5);
+    CHECK_APPROX_EQ(time_step(particles), 0.04);
+  }
+
+  SUBCASE("growth limit") {
+    // Time step grows by at most `max_growth` per step.
+    sph::dv_dt[a] = Vec{0.0, 100.0};
+    CHECK_APPROX_EQ(time_step(particles), 0.025);
+    sph::dv_dt[a] = Vec{0.0, 0.0};
+    CHECK_APPROX_EQ(time_step(particles), 0.0275);
+    CHECK_APPROX_EQ(time_step(particles), 0.03025);
+
+    // Time step shrinks immediately.
+    sph::dv_dt[a] = Vec{0.0, 100.0};
+    CHECK_APPROX_EQ(time_step(particles), 0.025);
+    CHECK_APPROX_EQ(time_step.dt(), 0.025);
+  }
+
+  SUBCASE("body force") {
+    // Acceleration of the particle at rest is not known on the first step,
+    // so the first step is bounded by the body force, and then grows.
+    time_step.set_body_force(100.0);
+    CHECK_APPROX_EQ(time_step(particles), 0.025);
+    CHECK_APPROX_EQ(time_step(particles), 0.0275);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
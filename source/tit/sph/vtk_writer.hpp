@@ -0,0 +1,411 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/type.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Value that can be stored in a VTK data array.
+template<class Val>
+concept vtk_value = data::known_type_of<Val> &&
+                    data::type_of<Val>.kind().width() <= sizeof(uint64_t);
+
+// Number type of the VTK data array components.
+template<class Val>
+struct vtk_num : std::type_identity<Val> {};
+template<class Num, size_t Dim>
+struct vtk_num<Vec<Num, Dim>> : std::type_identity<Num> {};
+template<class Num, size_t Dim>
+struct vtk_num<Mat<Num, Dim>> : std::type_identity<Num> {};
+template<class Val>
+using vtk_num_t = typename vtk_num<Val>::type;
+
+// Number of the VTK data array components.
+template<vtk_value Val>
+inline constexpr size_t vtk_num_components_v =
+    data::type_of<Val>.width() / sizeof(vtk_num_t<Val>);
+
+// VTK name of the data array type.
+template<vtk_value Val>
+constexpr auto vtk_type_name() -> std::string_view {
+  using enum data::DataKind::ID;
+  return translate<std::string_view>(data::type_of<Val>.kind().id())
+      .option(int8, "Int8")
+      .option(uint8, "UInt8")
+      .option(int16, "Int16")
+      .option(uint16, "UInt16")
+      .option(int32, "Int32")
+      .option(uint32, "UInt32")
+      .option(int64, "Int64")
+      .option(uint64, "UInt64")
+      .option(float32, "Float32")
+      .option(float64, "Float64");
+}
+
+// VTK name of the native byte order.
+inline constexpr std::string_view vtk_byte_order =
+    std::endian::native == std::endian::little ? "LittleEndian" : "BigEndian";
+
+// Append the value components to the buffer. Vectors and matrices are
+// flattened explicitly, since their storage may be padded.
+template<class Num, class Val>
+constexpr void vtk_flatten(std::vector<Num>& buffer, const Val& val) {
+  if constexpr (is_vec_v<Val> || is_mat_v<Val>) {
+    for (size_t i = 0; i < data::type_of<Val>.dim(); ++i) {
+      vtk_flatten(buffer, val[i]);
+    }
+  } else {
+    buffer.push_back(val);
+  }
+}
+
+// Data array that is stored in the appended data section.
+struct VTKArray final {
+  std::string_view name;
+  std::string_view type;
+  size_t num_components;
+  size_t num_bytes;
+};
+
+// Describe the data array of the range.
+template<std::ranges::sized_range Vals>
+constexpr auto vtk_array(std::string_view name, const Vals& vals) -> VTKArray {
+  using Val = std::ranges::range_value_t<Vals>;
+  return {.name = name,
+          .type = vtk_type_name<Val>(),
+          .num_components = vtk_num_components_v<Val>,
+          .num_bytes = std::ranges::size(vals) * data::type_of<Val>.width()};
+}
+
+// Write the data array of the range into the appended data section.
+template<std::ranges::sized_range Vals>
+void vtk_write_array(OutputStream<byte_t>& out, Vals&& vals) {
+  using Val = std::ranges::range_value_t<Vals>;
+  using Num = vtk_num_t<Val>;
+  const uint64_t num_bytes = vtk_array("", vals).num_bytes;
+  out.write(std::as_bytes(std::span{&num_bytes, 1}));
+
+  // Values are converted through a small buffer, so that the fields stored
+  // in tiles are not copied into the temporary arrays.
+  constexpr size_t buffer_size = 4096;
+  std::vector<Num> buffer;
+  buffer.reserve(buffer_size + vtk_num_components_v<Val>);
+  for (const auto& val : vals) {
+    vtk_flatten(buffer, val);
+    if (buffer.size() >= buffer_size) {
+      out.write(std::as_bytes(std::span{buffer}));
+      buffer.clear();
+    }
+  }
+  out.write(std::as_bytes(std::span{buffer}));
+}
+
+// Write the XML text.
+inline void vtk_write_text(OutputStream<byte_t>& out, std::string_view text) {
+  out.write(std::as_bytes(std::span{text}));
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Streaming writer of the particle arrays into the VTK files.
+///
+/// Each written particle array becomes a parallel unstructured grid
+/// (`.pvtu`), whose pieces (`.vtu`) are contiguous particle ranges written in
+/// parallel. Varying particle fields are stored as the raw appended binary
+/// data directly from the particle array, and the particle types are stored
+/// as the `type` field. Written time steps are collected into a ParaView data
+/// file (`.pvd`), that is rewritten on each step.
+class VTKWriter final {
+public:
+
+  /// Construct a VTK writer.
+  ///
+  /// @param dir  Directory to write the files into. It is created if needed.
+  /// @param name Base name of the written files.
+  explicit VTKWriter(std::filesystem::path dir, std::string name = "particles")
+      : dir_{std::move(dir)}, name_{std::move(name)} {
+    std::filesystem::create_directories(dir_);
+  }
+
+  /// Output directory.
+  auto dir() const noexcept -> const std::filesystem::path& {
+    return dir_;
+  }
+
+  /// Number of written time steps.
+  auto num_time_steps() const noexcept -> size_t {
+    return time_steps_.size();
+  }
+
+  /// Write the particle array as a new time step.
+  ///
+  /// @param time       Time step time.
+  /// @param particles  Particle array to write.
+  /// @param num_pieces Number of pieces. Particles are sorted along the
+  ///                   space filling curve, so that contiguous particle
+  ///                   ranges stay spatially local.
+  template<particle_array<r> ParticleArray>
+  void write(real_t time,
+             const ParticleArray& particles,
+             size_t num_pieces = par::num_threads()) {
+    TIT_PROFILE_SECTION("VTKWriter::write()");
+    const auto step = std::format("{}_{:06}", name_, time_steps_.size());
+    num_pieces = std::max<size_t>(std::min(num_pieces, particles.size()), 1);
+
+    // Write the pieces.
+    const auto piece_first = [&particles, num_pieces](size_t piece) {
+      return piece * particles.size() / num_pieces;
+    };
+    par::for_each(
+        std::views::iota(size_t{0}, num_pieces),
+        [&particles, &step, &piece_first, this](size_t piece) {
+          write_piece_(dir_ / std::format("{}_{}.vtu", step, piece),
+                       particles,
+                       piece_first(piece),
+                       piece_first(piece + 1));
+        });
+
+    // Write the piece index and update the collection.
+    write_index_(dir_ / std::format("{}.pvtu", step),
+                 particles,
+                 step,
+                 num_pieces);
+    time_steps_.emplace_back(time, std::format("{}.pvtu", step));
+    write_collection_();
+  }
+
+private:
+
+  // Enumerate the point data arrays of a particle range.
+  template<class ParticleArray, class Func>
+  static void for_each_point_array_(const ParticleArray& particles,
+                                    size_t first,
+                                    size_t last,
+                                    const Func& func) {
+    func("type",
+         std::views::iota(first, last) |
+             std::views::transform([&particles](size_t index) {
+               auto type = ParticleType::fluid;
+               while (!particles.has_type(index, type)) {
+                 type = static_cast<ParticleType>(std::to_underlying(type) + 1);
+               }
+               return std::to_underlying(type);
+             }));
+    ParticleArray::shared_fields.for_each(
+        [&particles, first, last, &func](auto field) {
+          using Val = std::ranges::range_value_t<decltype(field[particles])>;
+          if constexpr (!std::same_as<decltype(field), r_t> &&
+                        impl::vtk_value<Val>) {
+            func(field.field_name,
+                 field[particles] | std::views::drop(first) |
+                     std::views::take(last - first));
+          }
+        });
+  }
+
+  // Particle positions of a particle range, padded to three dimensions.
+  template<class ParticleArray>
+  static auto points_(const ParticleArray& particles,
+                      size_t first,
+                      size_t last) {
+    return r[particles] | std::views::drop(first) |
+           std::views::take(last - first) |
+           std::views::transform([](const auto& pos) {
+             using Pos = std::remove_cvref_t<decltype(pos)>;
+             Vec<vec_num_t<Pos>, 3> point{};
+             for (size_t i = 0; i < vec_dim_v<Pos>; ++i) point[i] = pos[i];
+             return point;
+           });
+  }
+
+  // Write a single piece of the particle array.
+  template<class ParticleArray>
+  static void write_piece_(const std::filesystem::path& path,
+                           const ParticleArray& particles,
+                           size_t first,
+                           size_t last) {
+    TIT_PROFILE_SECTION("VTKWriter::write_piece_()");
+    const auto count = last - first;
+    const auto num_cells = static_cast<int64_t>(count);
+    const auto connectivity = std::views::iota(int64_t{0}, num_cells);
+    const auto offsets = std::views::iota(int64_t{1}, num_cells + 1);
+    const auto cell_types = std::views::iota(size_t{0}, count) |
+                            std::views::transform([](size_t /*index*/) {
+                              return uint8_t{1}; // VTK_VERTEX.
+                            });
+
+    // Write the header. Offsets of the arrays in the appended data section
+    // include the size headers that precede each array.
+    std::string xml;
+    auto xml_out = std::back_inserter(xml);
+    size_t offset = 0;
+    const auto write_array_header = [&xml_out, &offset](impl::VTKArray arr) {
+      std::format_to(xml_out,
+                     "    <DataArray type=\"{}\" Name=\"{}\" "
+                     "NumberOfComponents=\"{}\" format=\"appended\" "
+                     "offset=\"{}\"/>\n",
+                     arr.type,
+                     arr.name,
+                     arr.num_components,
+                     offset);
+      offset += sizeof(uint64_t) + arr.num_bytes;
+    };
+    std::format_to(xml_out,
+                   "<?xml version=\"1.0\"?>\n"
+                   "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+                   "byte_order=\"{}\" header_type=\"UInt64\">\n"
+                   "<UnstructuredGrid>\n"
+                   "<Piece NumberOfPoints=\"{}\" NumberOfCells=\"{}\">\n"
+                   "  <PointData>\n",
+                   impl::vtk_byte_order,
+                   count,
+                   count);
+    for_each_point_array_(
+        particles,
+        first,
+        last,
+        [&write_array_header](std::string_view name, const auto& vals) {
+          write_array_header(impl::vtk_array(name, vals));
+        });
+    std::format_to(xml_out, "  </PointData>\n  <Points>\n");
+    write_array_header(
+        impl::vtk_array("Points", points_(particles, first, last)));
+    std::format_to(xml_out, "  </Points>\n  <Cells>\n");
+    write_array_header(impl::vtk_array("connectivity", connectivity));
+    write_array_header(impl::vtk_array("offsets", offsets));
+    write_array_header(impl::vtk_array("types", cell_types));
+    std::format_to(xml_out,
+                   "  </Cells>\n"
+                   "</Piece>\n"
+                   "</UnstructuredGrid>\n"
+                   "<AppendedData encoding=\"raw\">\n_");
+
+    // Write the appended data.
+    const auto out = make_file_output_stream(path);
+    impl::vtk_write_text(*out, xml);
+    for_each_point_array_(particles,
+                          first,
+                          last,
+                          [&out](std::string_view /*name*/, auto vals) {
+                            impl::vtk_write_array(*out, std::move(vals));
+                          });
+    impl::vtk_write_array(*out, points_(particles, first, last));
+    impl::vtk_write_array(*out, connectivity);
+    impl::vtk_write_array(*out, offsets);
+    impl::vtk_write_array(*out, cell_types);
+    impl::vtk_write_text(*out, "\n</AppendedData>\n</VTKFile>\n");
+    out->flush();
+  }
+
+  // Write the parallel unstructured grid file that lists the pieces.
+  template<class ParticleArray>
+  static void write_index_(const std::filesystem::path& path,
+                           const ParticleArray& particles,
+                           std::string_view step,
+                           size_t num_pieces) {
+    std::string xml;
+    auto xml_out = std::back_inserter(xml);
+    const auto write_array_header = [&xml_out](impl::VTKArray arr) {
+      std::format_to(xml_out,
+                     "    <PDataArray type=\"{}\" Name=\"{}\" "
+                     "NumberOfComponents=\"{}\"/>\n",
+                     arr.type,
+                     arr.name,
+                     arr.num_components);
+    };
+    std::format_to(xml_out,
+                   "<?xml version=\"1.0\"?>\n"
+                   "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" "
+                   "byte_order=\"{}\" header_type=\"UInt64\">\n"
+                   "<PUnstructuredGrid GhostLevel=\"0\">\n"
+                   "  <PPointData>\n",
+                   impl::vtk_byte_order);
+    for_each_point_array_(
+        particles,
+        0,
+        0,
+        [&write_array_header](std::string_view name, const auto& vals) {
+          write_array_header(impl::vtk_array(name, vals));
+        });
+    std::format_to(xml_out, "  </PPointData>\n  <PPoints>\n");
+    write_array_header(impl::vtk_array("Points", points_(particles, 0, 0)));
+    std::format_to(xml_out, "  </PPoints>\n");
+    for (size_t piece = 0; piece < num_pieces; ++piece) {
+      std::format_to(xml_out, "  <Piece Source=\"{}_{}.vtu\"/>\n", step, piece);
+    }
+    std::format_to(xml_out, "</PUnstructuredGrid>\n</VTKFile>\n");
+
+    const auto out = make_file_output_stream(path);
+    impl::vtk_write_text(*out, xml);
+    out->flush();
+  }
+
+  // Write the collection of the time steps.
+  void write_collection_() const {
+    std::string xml;
+    auto xml_out = std::back_inserter(xml);
+    std::format_to(xml_out,
+                   "<?xml version=\"1.0\"?>\n"
+                   "<VTKFile type=\"Collection\" version=\"1.0\" "
+                   "byte_order=\"{}\">\n"
+                   "<Collection>\n",
+                   impl::vtk_byte_order);
+    for (const auto& [time, file] : time_steps_) {
+      std::format_to(xml_out,
+                     "  <DataSet timestep=\"{}\" file=\"{}\"/>\n",
+                     time,
+                     file);
+    }
+    std::format_to(xml_out, "</Collection>\n</VTKFile>\n");
+
+    const auto out = make_file_output_stream(dir_ / (name_ + ".pvd"));
+    impl::vtk_write_text(*out, xml);
+    out->flush();
+  }
+
+  std::filesystem::path dir_;
+  std::string name_;
+  std::vector<std::pair<real_t, std::string>> time_steps_;
+
+}; // class VTKWriter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,88 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/vtk_writer.hpp"
+
+#include "tit/testing/equations.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stub with the varying position and density fields.
+using DensityEquations = EquationsStub<meta::Set{sph::r, sph::rho}>;
+
+// Read the whole file as a string.
+auto read_file(const std::filesystem::path& path) -> std::string {
+  std::vector<byte_t> bytes;
+  read_from(make_file_input_stream(path), bytes, /*chunk_size=*/256);
+  return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+TEST_CASE("sph::VTKWriter") {
+  sph::ParticleArray particles{sph::Space<double, 2>{}, DensityEquations{}};
+  for (const auto a : particles.append_n(sph::ParticleType::fluid, 5)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 1.0};
+    sph::rho[a] = 1000.0 + static_cast<double>(a.index());
+  }
+  for (const auto a : particles.append_n(sph::ParticleType::fixed, 2)) {
+    sph::r[a] = Vec{static_cast<double>(a.index()), 0.0};
+    sph::rho[a] = 1000.0;
+  }
+
+  const std::filesystem::path dir{"test_vtk_writer"};
+  std::filesystem::remove_all(dir);
+  sph::VTKWriter writer{dir};
+  writer.write(0.0, particles, /*num_pieces=*/2);
+  writer.write(0.5, particles, /*num_pieces=*/2);
+  REQUIRE(writer.num_time_steps() == 2);
+
+  // Check the collection and the piece index.
+  const auto collection = read_file(dir / "particles.pvd");
+  CHECK(collection.contains(R"(file="particles_000000.pvtu")"));
+  CHECK(collection.contains(R"(file="particles_000001.pvtu")"));
+  const auto index = read_file(dir / "particles_000001.pvtu");
+  CHECK(index.contains(R"(Name="rho")"));
+  CHECK(index.contains(R"(Name="type")"));
+  CHECK(index.contains(R"(<Piece Source="particles_000001_0.vtu"/>)"));
+  CHECK(index.contains(R"(<Piece Source="particles_000001_1.vtu"/>)"));
+
+  // Check the appended data of the second piece: it holds particles from
+  // the third to the last one, and starts with the particle types.
+  const auto piece = read_file(dir / "particles_000001_1.vtu");
+  CHECK(piece.contains(R"(NumberOfPoints="4")"));
+  const std::string_view marker = "<AppendedData encoding=\"raw\">\n_";
+  const auto data_first = piece.find(marker);
+  REQUIRE(data_first != std::string::npos);
+  const auto* const data = piece.data() + data_first + marker.size();
+  uint64_t num_bytes = 0;
+  std::memcpy(&num_bytes, data, sizeof(num_bytes));
+  REQUIRE(num_bytes == 4);
+  CHECK(data[sizeof(num_bytes) + 0] == 0); // fluid
+  CHECK(data[sizeof(num_bytes) + 1] == 0); // fluid
+  CHECK(data[sizeof(num_bytes) + 2] == 1); // fixed
+  CHECK(data[sizeof(num_bytes) + 3] == 1); // fixed
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
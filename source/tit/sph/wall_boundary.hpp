@@ -0,0 +1,78 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <utility>
+
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/sdf.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Solid wall boundary, described by the signed distance field.
+///
+/// Signed distance is positive inside of the walls, where the fixed particles
+/// are placed, and negative inside of the fluid domain. Each fixed particle
+/// is mirrored over the wall surface into the ghost point, where its field
+/// values are interpolated from the fluid particles.
+template<class Vec>
+class WallBoundary final {
+public:
+
+  /// Signed distance field type.
+  using SDF = geom::GridSDF<Vec>;
+
+  /// Construct an empty wall boundary. It must not be used with the fixed
+  /// particles.
+  constexpr WallBoundary() = default;
+
+  /// Construct a wall boundary.
+  ///
+  /// @param sdf        Signed distance field of the walls.
+  /// @param grad_rho_0 Reference density gradient near the walls, e.g.
+  ///                   `rho_0 / cs_0^2 * g` for the hydrostatic pressure.
+  constexpr explicit WallBoundary(geom::GridSDF<Vec> sdf,
+                                 const Vec& grad_rho_0 = {})
+      : sdf_{std::move(sdf)}, grad_rho_0_{grad_rho_0} {}
+
+  /// Signed distance field of the walls.
+  constexpr auto sdf() const noexcept -> const SDF& {
+    return sdf_;
+  }
+
+  /// Reference density gradient near the walls.
+  constexpr auto grad_rho_0() const noexcept -> const Vec& {
+    return grad_rho_0_;
+  }
+
+  /// Closest point on the wall surface.
+  constexpr auto project(const Vec& point) const -> Vec {
+    return sdf_.project(point);
+  }
+
+  /// Wall normal, pointing into the walls.
+  constexpr auto normal(const Vec& point) const -> Vec {
+    return sdf_.normal(point);
+  }
+
+  /// Ghost point, i.e. the point mirrored over the wall surface.
+  constexpr auto ghost(const Vec& point) const -> Vec {
+    return sdf_.mirror(point);
+  }
+
+private:
+
+  SDF sdf_;
+  Vec grad_rho_0_{};
+
+}; // class WallBoundary
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,31 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include "tit/core/meta.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Equations stub that only defines the particle fields. Used to construct the
+/// particle arrays in the tests that need no actual equations.
+///
+/// @tparam RequiredFields Fields that are required by the equations.
+/// @tparam ModifiedFields Fields that are modified by the equations.
+/// @tparam FluidFields    Fields that are provided for the fluid particles.
+template<auto RequiredFields,
+         auto ModifiedFields = RequiredFields,
+         auto FluidFields = meta::Set{}>
+struct EquationsStub final {
+  static constexpr auto required_fields = RequiredFields;
+  static constexpr auto modified_fields = ModifiedFields;
+  static constexpr auto fluid_fields = FluidFields;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
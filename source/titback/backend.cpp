@@ -3,29 +3,56 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <filesystem>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
 #include <span>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <crow/app.h>
 #include <crow/http_request.h>
 #include <crow/http_response.h>
+#include <crow/json.h>
+#include <crow/mime_types.h>
 #include <crow/websocket.h>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/cmd.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/serialization.hpp"
+#include "tit/core/stream.hpp"
+#include "tit/core/str_utils.hpp"
 #include "tit/core/sys/utils.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/live.hpp"
+#include "tit/data/sqlite.hpp"
+#include "tit/data/storage.hpp"
 
 #include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
 #include "tit/py/gil.hpp"
 #include "tit/py/interpreter.hpp"
 #include "tit/py/mapping.hpp"
-#include "tit/py/module.hpp"
+#include "tit/py/number.hpp"
 #include "tit/py/object.hpp"
+#include "tit/py/sequence.hpp"
 #include "tit/py/type.hpp"
 
 namespace tit::back {
@@ -33,6 +60,792 @@ namespace {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+using Clock = std::chrono::steady_clock;
+using Connection = crow::websocket::connection;
+
+// Convert the Python object into JSON. Objects that have no JSON
+// representation are converted into their `repr` strings.
+auto to_json(const py::Object& obj) -> crow::json::wvalue {
+  if (py::NoneType::isinstance(obj)) return nullptr;
+  if (py::Bool::isinstance(obj)) return py::extract<bool>(obj);
+  if (py::Int::isinstance(obj)) return py::extract<long long>(obj);
+  if (py::Float::isinstance(obj)) return py::extract<double>(obj);
+  if (py::Str::isinstance(obj)) return py::extract<std::string>(obj);
+  if (py::List::isinstance(obj) || py::Tuple::isinstance(obj)) {
+    const auto seq = py::expect<py::Sequence>(obj);
+    std::vector<crow::json::wvalue> items;
+    items.reserve(py::len(seq));
+    for (size_t i = 0; i < py::len(seq); ++i) items.push_back(to_json(seq[i]));
+    return items;
+  }
+  if (py::Dict::isinstance(obj)) {
+    crow::json::wvalue result(crow::json::type::Object);
+    py::expect<py::Dict>(obj).for_each(
+        [&result](const py::Object& key, const py::Object& value) {
+          result[py::str(key)] = to_json(value);
+        });
+    return result;
+  }
+  return py::repr(obj);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Request to evaluate a Python expression.
+struct Request final {
+  Connection* connection;
+  crow::json::wvalue request_id;
+  std::string expression;
+  Clock::time_point deadline;
+};
+
+// Evaluator of the Python expressions.
+//
+// Requests are queued by the connection handlers and evaluated one at a time
+// by a dedicated worker thread, so that the responses are sent in the order
+// of the requests, and the connection handlers never wait for the GIL. Once
+// the request timeout expires, the queued request is cancelled, and the
+// running evaluation is interrupted by a watchdog thread.
+class Evaluator final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(Evaluator);
+
+  // Construct the evaluator. GIL must not be held by the calling thread.
+  Evaluator(const py::embed::Interpreter& interpreter, Clock::duration timeout)
+      : interpreter_{&interpreter}, timeout_{timeout},
+        worker_{[this] { run_worker_(); }},
+        watchdog_{[this] { run_watchdog_(); }} {}
+
+  // Stop the evaluator. GIL must not be held by the calling thread.
+  ~Evaluator() noexcept {
+    {
+      const std::scoped_lock lock{mutex_};
+      is_stopping_ = true;
+      queue_.clear();
+      cv_.notify_all();
+    }
+    worker_.join();
+    watchdog_.join();
+  }
+
+  // Queue the expression evaluation request.
+  void submit(Connection& connection, const std::string& data) {
+    const auto request = crow::json::load(data);
+    if (!request || !request.has("expression")) {
+      crow::json::wvalue response;
+      response["status"] = "error";
+      response["result"]["type"] = "ValueError";
+      response["result"]["error"] = "Malformed request.";
+      connection.send_text(response.dump());
+      return;
+    }
+    const std::scoped_lock lock{mutex_};
+    queue_.push_back({
+        .connection = &connection,
+        .request_id = request.has("requestID")
+                          ? crow::json::wvalue{request["requestID"]}
+                          : crow::json::wvalue{nullptr},
+        .expression = std::string{request["expression"].s()},
+        .deadline = Clock::now() + timeout_,
+    });
+    cv_.notify_all();
+  }
+
+  // Drop the requests of the closed connection.
+  void close(Connection& connection) {
+    const std::scoped_lock lock{mutex_};
+    std::erase_if(queue_, [&connection](const Request& request) {
+      return request.connection == &connection;
+    });
+    if (running_connection_ == &connection) running_connection_ = nullptr;
+  }
+
+private:
+
+  void run_worker_() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [this] { return is_stopping_ || !queue_.empty(); });
+      if (is_stopping_) break;
+      auto request = std::move(queue_.front());
+      queue_.pop_front();
+
+      crow::json::wvalue response;
+      response["requestID"] = std::move(request.request_id);
+      running_connection_ = request.connection;
+      if (Clock::now() >= request.deadline) {
+        response["status"] = "error";
+        response["result"]["type"] = "TimeoutError";
+        response["result"]["error"] = "Request has timed out in the queue.";
+      } else {
+        running_deadline_ = request.deadline;
+        lock.unlock();
+        evaluate_(request.expression, response);
+        lock.lock();
+      }
+
+      // Connection might have been closed during the evaluation.
+      if (running_connection_ != nullptr) {
+        running_connection_->send_text(response.dump());
+      }
+      running_connection_ = nullptr;
+      cv_.notify_all();
+    }
+  }
+
+  void evaluate_(const std::string& expr, crow::json::wvalue& response) {
+    const py::AcquireGIL acquire_gil{};
+    {
+      const std::scoped_lock lock{mutex_};
+      worker_id_ = py::current_thread_id();
+      is_evaluating_ = true;
+      cv_.notify_all();
+    }
+    try {
+      response["result"] = to_json(interpreter_->eval(expr));
+      response["status"] = "success";
+    } catch (const py::ErrorException& e) {
+      response["result"]["type"] = py::type(e.error()).fully_qualified_name();
+      response["result"]["error"] = py::str(e.error());
+      if (const auto tb = e.error().traceback(); tb) {
+        response["traceback"] = py::expect<py::Traceback>(tb).render();
+      }
+      response["status"] = "error";
+    }
+    // Interruption might have been requested after the evaluation ended.
+    const std::scoped_lock lock{mutex_};
+    py::cancel_thread_interrupt(worker_id_);
+    is_evaluating_ = false;
+  }
+
+  void run_watchdog_() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [this] { return is_stopping_ || is_evaluating_; });
+      if (is_stopping_) break;
+      const auto deadline = running_deadline_;
+      const auto is_done = cv_.wait_until(lock, deadline, [this, deadline] {
+        return is_stopping_ || !is_evaluating_ ||
+               running_deadline_ != deadline;
+      });
+      if (is_done) continue;
+
+      // Interrupt the evaluation. While the GIL is held by the watchdog, the
+      // worker cannot finish the evaluation, so the check is not racy.
+      lock.unlock();
+      {
+        const py::AcquireGIL acquire_gil{};
+        const std::scoped_lock interrupt_lock{mutex_};
+        if (is_evaluating_ && running_deadline_ == deadline) {
+          py::interrupt_thread(worker_id_);
+        }
+      }
+      lock.lock();
+      cv_.wait(lock, [this, deadline] {
+        return is_stopping_ || !is_evaluating_ ||
+               running_deadline_ != deadline;
+      });
+    }
+  }
+
+  const py::embed::Interpreter* interpreter_;
+  Clock::duration timeout_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request> queue_;
+  Connection* running_connection_ = nullptr;
+  Clock::time_point running_deadline_;
+  py::ThreadID worker_id_ = 0;
+  bool is_evaluating_ = false;
+  bool is_stopping_ = false;
+  std::jthread worker_;
+  std::jthread watchdog_;
+
+}; // class Evaluator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Streamer of the live frames to the viewers.
+//
+// Viewer negotiates the stream by sending a JSON message with the optional
+// `arrays`, `first`, `count`, `stride`, `tolerance` and `rate` fields, and
+// may renegotiate it at any time. Latest frames of the live channel are then
+// sent as binary messages at the negotiated rate, see
+// `data::encode_live_frame`. Frames that were submitted while the viewer was
+// waiting are skipped. Since the particles are streamed in the
+// level-of-detail order, the view is progressively refined by requesting the
+// consecutive item ranges.
+class LiveStreamer final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(LiveStreamer);
+
+  // Construct the live streamer.
+  explicit LiveStreamer(data::LiveChannel& channel)
+      : channel_{&channel}, thread_{[this] { run_(); }} {}
+
+  // Stop the live streamer.
+  ~LiveStreamer() noexcept {
+    {
+      const std::scoped_lock lock{mutex_};
+      is_stopping_ = true;
+      cv_.notify_all();
+    }
+    thread_.join();
+    for (const auto& viewer : viewers_ | std::views::values) {
+      channel_->unsubscribe(viewer.viewer_id);
+    }
+  }
+
+  // Negotiate the stream with the viewer.
+  void negotiate(Connection& connection, const std::string& data) {
+    const auto request = crow::json::load(data);
+    if (!request || request.t() != crow::json::type::Object) {
+      crow::json::wvalue response;
+      response["status"] = "error";
+      response["error"] = "Malformed request.";
+      connection.send_text(response.dump());
+      return;
+    }
+    Viewer_ viewer;
+    if (request.has("arrays")) {
+      for (const auto& name : request["arrays"]) {
+        viewer.options.arrays.emplace_back(name.s());
+      }
+    }
+    if (request.has("first")) viewer.options.first = request["first"].u();
+    if (request.has("count")) viewer.options.count = request["count"].u();
+    if (request.has("stride")) {
+      viewer.options.stride = std::max<size_t>(request["stride"].u(), 1);
+    }
+    if (request.has("tolerance")) {
+      viewer.options.tolerance = std::max(request["tolerance"].d(), 0.0);
+    }
+    const auto rate =
+        std::clamp(request.has("rate") ? request["rate"].d() : default_rate,
+                   min_rate,
+                   max_rate);
+    viewer.period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{1.0 / rate});
+
+    const std::scoped_lock lock{mutex_};
+    if (const auto iter = viewers_.find(&connection); iter != viewers_.end()) {
+      channel_->unsubscribe(iter->second.viewer_id);
+    }
+    viewer.viewer_id = channel_->subscribe(rate);
+    viewers_.insert_or_assign(&connection, std::move(viewer));
+    cv_.notify_all();
+  }
+
+  // Stop streaming to the closed connection.
+  void close(Connection& connection) {
+    const std::scoped_lock lock{mutex_};
+    if (const auto iter = viewers_.find(&connection); iter != viewers_.end()) {
+      channel_->unsubscribe(iter->second.viewer_id);
+      viewers_.erase(iter);
+    }
+  }
+
+private:
+
+  static constexpr double default_rate = 10.0;
+  static constexpr double min_rate = 0.01;
+  static constexpr double max_rate = 60.0;
+
+  struct Viewer_ final {
+    data::LiveFrameOptions options;
+    size_t viewer_id = 0;
+    Clock::duration period{};
+    Clock::time_point next_time;
+    size_t last_index = 0;
+  };
+
+  void run_() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      if (viewers_.empty()) {
+        cv_.wait(lock, [this] { return is_stopping_ || !viewers_.empty(); });
+      } else {
+        const auto next_time = std::ranges::min(
+            viewers_ | std::views::values |
+            std::views::transform(&Viewer_::next_time));
+        cv_.wait_until(lock, next_time, [this] { return is_stopping_; });
+      }
+      if (is_stopping_) break;
+
+      // Send the latest frame to the viewers that are due.
+      const auto now = Clock::now();
+      const auto [index, frame] = channel_->latest();
+      for (auto& [connection, viewer] : viewers_) {
+        if (viewer.next_time > now) continue;
+        viewer.next_time = now + viewer.period;
+        if (frame == nullptr || index == viewer.last_index) continue;
+        viewer.last_index = index;
+        const auto message = data::encode_live_frame(*frame, viewer.options);
+        connection->send_binary(
+            std::string{reinterpret_cast<const char*>(message.data()),
+                        message.size()});
+      }
+    }
+  }
+
+  data::LiveChannel* channel_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<Connection*, Viewer_> viewers_;
+  bool is_stopping_ = false;
+  std::jthread thread_;
+
+}; // class LiveStreamer
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Server of the static frontend files.
+//
+// Files that were precompressed at build time (`.br` and `.gz` siblings) are
+// served compressed, if the client accepts the encoding. Responses carry
+// strong ETags derived from the file size and modification time, so that
+// the revalidation requests are answered with `304 Not Modified`. Bundles
+// in the `assets` directory have the content hashes in their names, so they
+// are cached by the clients forever, while the other files, e.g.
+// `index.html`, are always revalidated. Small files are kept in memory, and
+// are reloaded once they change on disk.
+class StaticFiles final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(StaticFiles);
+
+  // Construct the static file server for the root directory.
+  explicit StaticFiles(std::filesystem::path root_dir)
+      : root_dir_{std::filesystem::weakly_canonical(root_dir)} {}
+
+  // Serve the file at the path relative to the root directory.
+  void serve(const crow::request& request,
+             crow::response& response,
+             const std::filesystem::path& file_name) {
+    // Resolve the path, and make sure it stays inside of the root directory.
+    std::error_code error;
+    auto path = std::filesystem::weakly_canonical(root_dir_ / file_name, error);
+    if (!error && std::filesystem::is_directory(path, error)) {
+      path /= "index.html";
+    }
+    const auto relative = path.lexically_relative(root_dir_);
+    if (error || relative.empty() || relative.native().starts_with("..")) {
+      response.code = 404;
+      response.end();
+      return;
+    }
+
+    // Pick the best encoding accepted by the client.
+    const auto accepts = [&request](std::string_view encoding) {
+      return request.get_header_value("Accept-Encoding").contains(encoding);
+    };
+    std::shared_ptr<const File_> file;
+    std::string_view encoding;
+    if (accepts("br")) file = load_(path, ".br"), encoding = "br";
+    if (file == nullptr && accepts("gzip")) {
+      file = load_(path, ".gz"), encoding = "gzip";
+    }
+    if (file == nullptr) file = load_(path, ""), encoding = {};
+    if (file == nullptr) {
+      response.code = 404;
+      response.end();
+      return;
+    }
+
+    // Set the headers, and answer the revalidation requests.
+    response.set_header("ETag", file->etag);
+    response.set_header("Vary", "Accept-Encoding");
+    response.set_header("Cache-Control",
+                        relative.begin()->native() == "assets" ?
+                            "public, max-age=31536000, immutable" :
+                            "no-cache");
+    const auto extension = path.extension().string();
+    const auto mime_iter = crow::mime_types.find(
+        extension.empty() ? extension : extension.substr(1));
+    response.set_header("Content-Type",
+                        mime_iter != crow::mime_types.end() ?
+                            mime_iter->second :
+                            "application/octet-stream");
+    if (!encoding.empty()) {
+      response.set_header("Content-Encoding", std::string{encoding});
+    }
+    if (request.get_header_value("If-None-Match") == file->etag) {
+      response.code = 304;
+      response.end();
+      return;
+    }
+    response.body = file->contents;
+    response.end();
+  }
+
+private:
+
+  // Largest size of a single cached file, and of all the cached files.
+  static constexpr size_t max_cached_file_size_ = 4 * 1024 * 1024;
+  static constexpr size_t max_cache_size_ = 64 * 1024 * 1024;
+
+  struct File_ final {
+    std::string etag;
+    std::string contents;
+    std::filesystem::file_time_type mtime;
+  };
+
+  // Load the file with the suffix appended to its path from the cache, or
+  // from disk. Returns null if there is no such file.
+  auto load_(const std::filesystem::path& path, std::string_view suffix)
+      -> std::shared_ptr<const File_> {
+    auto file_path = path;
+    file_path += suffix;
+    std::error_code error;
+    const auto size = std::filesystem::file_size(file_path, error);
+    if (error) return nullptr;
+    const auto mtime = std::filesystem::last_write_time(file_path, error);
+    if (error) return nullptr;
+
+    // Return the cached file, unless it has changed.
+    {
+      const std::scoped_lock lock{mutex_};
+      if (const auto iter = cache_.find(file_path.native());
+          iter != cache_.end()) {
+        if (const auto& cached = iter->second;
+            cached->mtime == mtime && cached->contents.size() == size) {
+          return cached;
+        }
+        cache_size_ -= iter->second->contents.size();
+        cache_.erase(iter);
+      }
+    }
+
+    // Read the file. Large files are not kept in the cache.
+    auto file = std::make_shared<File_>();
+    file->etag =
+        std::format(R"("{:x}-{:x}")", size, mtime.time_since_epoch().count());
+    file->mtime = mtime;
+    if (size != 0) {
+      const MappedFile mapped{file_path};
+      const auto bytes = mapped.bytes();
+      file->contents.assign(reinterpret_cast<const char*>(bytes.data()),
+                            bytes.size());
+    }
+    const std::scoped_lock lock{mutex_};
+    if (file->contents.size() <= max_cached_file_size_ &&
+        cache_size_ + file->contents.size() <= max_cache_size_ &&
+        cache_.try_emplace(file_path.native(), file).second) {
+      cache_size_ += file->contents.size();
+    }
+    return file;
+  }
+
+  std::filesystem::path root_dir_;
+  std::mutex mutex_;
+  StrHashMap<std::shared_ptr<const File_>> cache_;
+  size_t cache_size_ = 0;
+
+}; // class StaticFiles
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Parse the single byte range of the `Range` header for the resource of the
+// given size. Returns the first and the past-the-last byte offsets, or null
+// if the range cannot be satisfied.
+auto parse_byte_range(std::string_view header, size_t size)
+    -> std::optional<std::pair<size_t, size_t>> {
+  const auto spec = header.substr(header.find('=') + 1);
+  const auto dash = spec.find('-');
+  if (dash == std::string_view::npos) return std::nullopt;
+  const auto first_str = spec.substr(0, dash);
+  const auto last_str = spec.substr(dash + 1);
+  if (first_str.empty()) {
+    // Suffix range, i.e. the last `N` bytes.
+    const auto suffix = str_to<size_t>(last_str);
+    if (!suffix || *suffix == 0 || size == 0) return std::nullopt;
+    return std::pair{size - std::min(*suffix, size), size};
+  }
+  const auto first = str_to<size_t>(first_str);
+  if (!first || *first >= size) return std::nullopt;
+  if (last_str.empty()) return std::pair{*first, size};
+  const auto last = str_to<size_t>(last_str);
+  if (!last || *last < *first) return std::nullopt;
+  return std::pair{*first, std::min(*last + 1, size)};
+}
+
+// Server of the data stored in the data storages.
+//
+// Storages are the files in the data directory, they are addressed by the
+// file names. Indices of the series and the time steps are served as JSON,
+// while the arrays are served as binary blobs of the data exactly as it is
+// stored, i.e. still compressed, so that no recompression is needed and
+// loading is only limited by the network bandwidth. Blob consists of:
+// - data type identifier (`uint32_t`), see `DataType::id`;
+// - filter (`uint8_t`), see `DataFilter`;
+// - compression flag (`uint8_t`);
+// - tolerance (`float64_t`), zero if the array is encoded losslessly;
+// - number of values per chunk (`uint64_t`), zero if it is not chunked;
+// - number of values (`uint64_t`), all ones if unknown without decoding;
+// - number of the chunks (`uint64_t`), followed by the chunk sizes
+//   (`uint64_t` each), followed by the chunks data.
+// All numbers are in the native byte order.
+//
+// Responses carry strong ETags derived from the storage modification time,
+// so that the revalidation requests are answered with `304 Not Modified`.
+// Storages of the running simulations change, so the responses are always
+// revalidated. Array blobs support the single byte range requests. Storages
+// are not thread-safe, so each server thread opens its own connections, and
+// reads concurrently with the others. Small blobs are kept in memory.
+class StoredData final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(StoredData);
+
+  // Construct the stored data server for the data directory.
+  explicit StoredData(std::filesystem::path data_dir)
+      : data_dir_{std::filesystem::weakly_canonical(data_dir)} {}
+
+  // Serve the index of the data series and their time steps.
+  void serve_index(const crow::request& request,
+                   crow::response& response,
+                   std::string_view name) {
+    const auto path = resolve_(name);
+    if (!path) return not_found_(response);
+    const auto etag = etag_(*path, "index");
+    if (!revalidate_(request, response, etag, "application/json")) return;
+    const auto& storage = open_(*path);
+    std::vector<crow::json::wvalue> series;
+    for (const auto series_id : storage.series_ids()) {
+      std::vector<crow::json::wvalue> time_steps;
+      for (const auto time_step_id : storage.series_time_step_ids(series_id)) {
+        crow::json::wvalue time_step;
+        time_step["id"] = time_step_id.get();
+        time_step["time"] = static_cast<double>(
+            storage.time_step_time(time_step_id));
+        time_steps.push_back(std::move(time_step));
+      }
+      crow::json::wvalue item;
+      item["id"] = series_id.get();
+      item["parameters"] = storage.series_parameters(series_id);
+      item["time_steps"] = std::move(time_steps);
+      series.push_back(std::move(item));
+    }
+    crow::json::wvalue result;
+    result["series"] = std::move(series);
+    response.body = result.dump();
+    response.end();
+  }
+
+  // Serve the index of the data arrays of the time step.
+  void serve_time_step(const crow::request& request,
+                       crow::response& response,
+                       std::string_view name,
+                       uint64_t time_step_id) {
+    const auto path = resolve_(name);
+    if (!path) return not_found_(response);
+    const data::DataTimeStepID id{static_cast<int64_t>(time_step_id)};
+    auto& storage = open_(*path);
+    if (!storage.check_time_step(id)) return not_found_(response);
+    const auto etag = etag_(*path, std::format("step-{:x}", time_step_id));
+    if (!revalidate_(request, response, etag, "application/json")) return;
+    const auto list_arrays = [&storage](data::DataSetID dataset_id) {
+      std::vector<crow::json::wvalue> arrays;
+      for (const auto& [array_name, array_id] :
+           storage.dataset_array_ids(dataset_id)) {
+        const auto type = storage.array_type(array_id);
+        crow::json::wvalue array;
+        array["name"] = array_name;
+        array["id"] = array_id.get();
+        array["type"] = type.name();
+        array["type_id"] = type.id();
+        arrays.push_back(std::move(array));
+      }
+      return arrays;
+    };
+    crow::json::wvalue result;
+    result["time"] = static_cast<double>(storage.time_step_time(id));
+    result["uniforms"] = list_arrays(storage.time_step_uniforms_id(id));
+    result["varyings"] = list_arrays(storage.time_step_varyings_id(id));
+    response.body = result.dump();
+    response.end();
+  }
+
+  // Serve the encoded data of the array.
+  void serve_array(const crow::request& request,
+                   crow::response& response,
+                   std::string_view name,
+                   uint64_t array_id) {
+    const auto path = resolve_(name);
+    if (!path) return not_found_(response);
+    const data::DataArrayID id{static_cast<int64_t>(array_id)};
+    if (!open_(*path).check_array(id)) return not_found_(response);
+    const auto etag = etag_(*path, std::format("array-{:x}", array_id));
+    response.set_header("Accept-Ranges", "bytes");
+    if (!revalidate_(request, response, etag, "application/octet-stream")) {
+      return;
+    }
+    const auto blob = load_(*path, id, etag);
+    const auto size = blob->contents.size();
+
+    // Serve the requested range, unless the client has an outdated copy.
+    const auto range = request.get_header_value("Range");
+    const auto if_range = request.get_header_value("If-Range");
+    if (range.starts_with("bytes=") && !range.contains(',') &&
+        (if_range.empty() || if_range == etag)) {
+      const auto bounds = parse_byte_range(range, size);
+      if (!bounds) {
+        response.code = 416;
+        response.set_header("Content-Range", std::format("bytes */{}", size));
+        response.end();
+        return;
+      }
+      const auto [first, last] = *bounds;
+      response.code = 206;
+      response.set_header(
+          "Content-Range",
+          std::format("bytes {}-{}/{}", first, last - 1, size));
+      response.body = blob->contents.substr(first, last - first);
+      response.end();
+      return;
+    }
+    response.body = blob->contents;
+    response.end();
+  }
+
+private:
+
+  // Largest size of a single cached blob, and of all the cached blobs.
+  static constexpr size_t max_cached_blob_size_ = 16 * 1024 * 1024;
+  static constexpr size_t max_cache_size_ = 256 * 1024 * 1024;
+
+  struct Blob_ final {
+    std::string etag;
+    std::string contents;
+  };
+
+  static void not_found_(crow::response& response) {
+    response.code = 404;
+    response.end();
+  }
+
+  // Set the caching headers, and answer the revalidation request. Returns
+  // false if the response has been completed.
+  static auto revalidate_(const crow::request& request,
+                          crow::response& response,
+                          const std::string& etag,
+                          std::string_view content_type) -> bool {
+    response.set_header("ETag", etag);
+    response.set_header("Cache-Control", "no-cache");
+    response.set_header("Content-Type", std::string{content_type});
+    if (request.get_header_value("If-None-Match") == etag) {
+      response.code = 304;
+      response.end();
+      return false;
+    }
+    return true;
+  }
+
+  // Resolve the path to the storage, and make sure it is a regular `.ttdb`
+  // file inside of the data directory.
+  auto resolve_(std::string_view name) const
+      -> std::optional<std::filesystem::path> {
+    if (name.empty() || name.starts_with('.') || name.contains('/') ||
+        name.contains('\\')) {
+      return std::nullopt;
+    }
+    auto path = data_dir_ / name;
+    if (path.extension() != ".ttdb") return std::nullopt;
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error) || error) {
+      return std::nullopt;
+    }
+    return path;
+  }
+
+  // Make the ETag of the resource. Storages in the WAL mode are modified
+  // through the write-ahead log, so its modification time is accounted too.
+  static auto etag_(const std::filesystem::path& path, std::string_view what)
+      -> std::string {
+    std::error_code error;
+    auto mtime = std::filesystem::last_write_time(path, error);
+    auto wal_path = path;
+    wal_path += "-wal";
+    if (const auto wal_mtime =
+            std::filesystem::last_write_time(wal_path, error);
+        !error) {
+      mtime = std::max(mtime, wal_mtime);
+    }
+    return std::format(R"("{:x}-{}")", mtime.time_since_epoch().count(), what);
+  }
+
+  // Open the storage for the current thread. Storages are opened read-only,
+  // so that browsing never modifies them.
+  static auto open_(const std::filesystem::path& path) -> data::DataStorage& {
+    static thread_local StrHashMap<std::unique_ptr<data::DataStorage>>
+        storages;
+    auto& storage = storages[path.native()];
+    if (storage == nullptr) {
+      storage = std::make_unique<data::DataStorage>(
+          path,
+          data::sqlite::OpenMode::read_only);
+    }
+    return *storage;
+  }
+
+  // Load the encoded array data from the cache, or from the storage.
+  auto load_(const std::filesystem::path& path,
+             data::DataArrayID array_id,
+             const std::string& etag) -> std::shared_ptr<const Blob_> {
+    const auto key = std::format("{}:{}", path.native(), array_id.get());
+
+    // Return the cached blob, unless the storage has changed.
+    {
+      const std::scoped_lock lock{mutex_};
+      if (const auto iter = cache_.find(key); iter != cache_.end()) {
+        if (iter->second->etag == etag) return iter->second;
+        cache_size_ -= iter->second->contents.size();
+        cache_.erase(iter);
+      }
+    }
+
+    // Read the encoded data, and pack it into the blob. Large blobs are not
+    // kept in the cache.
+    const auto encoded = open_(path).array_data_encoded(array_id);
+    std::vector<byte_t> bytes;
+    {
+      const auto out = make_container_output_stream(bytes);
+      serialize(*out, encoded.type.id());
+      serialize(*out, static_cast<uint8_t>(encoded.filter));
+      serialize(*out, static_cast<uint8_t>(encoded.compressed));
+      serialize(*out, encoded.tolerance);
+      serialize(*out, static_cast<uint64_t>(encoded.chunk_size));
+      serialize(*out, static_cast<uint64_t>(encoded.num_values.value_or(npos)));
+      serialize(*out, static_cast<uint64_t>(encoded.chunks.size()));
+      for (const auto& chunk : encoded.chunks) {
+        serialize(*out, static_cast<uint64_t>(chunk.size()));
+      }
+      for (const auto& chunk : encoded.chunks) out->write(chunk);
+    }
+    auto blob = std::make_shared<Blob_>();
+    blob->etag = etag;
+    blob->contents.assign(reinterpret_cast<const char*>(bytes.data()),
+                          bytes.size());
+    const std::scoped_lock lock{mutex_};
+    if (blob->contents.size() <= max_cached_blob_size_ &&
+        cache_size_ + blob->contents.size() <= max_cache_size_ &&
+        cache_.try_emplace(key, blob).second) {
+      cache_size_ += blob->contents.size();
+    }
+    return blob;
+  }
+
+  std::filesystem::path data_dir_;
+  std::mutex mutex_;
+  StrHashMap<std::shared_ptr<const Blob_>> cache_;
+  size_t cache_size_ = 0;
+
+}; // class StoredData
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 auto run_backend(CmdArgs args) -> int {
   // Setup paths.
   const auto exe_dir = exe_path().parent_path();
@@ -60,54 +873,90 @@ auto run_backend(CmdArgs args) -> int {
     return interpreter.exec_file(file_name) ? 0 : 1;
   }
 
+  // Expressions are evaluated in background, so the GIL is released for the
+  // lifetime of the evaluator.
+  const py::ReleaseGIL release_gil{};
+  Evaluator evaluator{interpreter,
+                      std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>{
+                              get_env<double>("TIT_BACKEND_TIMEOUT", 60.0)})};
+
+  LiveStreamer streamer{data::live_channel()};
+
   crow::SimpleApp app;
 
   CROW_WEBSOCKET_ROUTE(app, "/ws")
-      .onmessage([&interpreter](crow::websocket::connection& connection,
-                                const std::string& data,
-                                bool is_binary) { //
+      .onmessage([&evaluator](Connection& connection,
+                              const std::string& data,
+                              bool is_binary) { //
         TIT_ASSERT(!is_binary, "Binary messages are not supported.");
-        const py::AcquireGIL acquire_gil{};
-        const auto json = py::import_("json");
-        const py::Dict response;
-        try {
-          const auto request = py::expect<py::Dict>(json.attr("loads")(data));
-          response["requestID"] = request.at("requestID"); /// @todo Fix it!
-          const auto expr = py::extract<std::string>(request["expression"]);
-          response["result"] = interpreter.eval(expr);
-          response["status"] = "success";
-        } catch (const py::ErrorException& e) {
-          const py::Dict error;
-          error["type"] = py::type(e.error()).fully_qualified_name();
-          error["error"] = py::str(e.error());
-          if (const auto tb = e.error().traceback(); tb) {
-            response["traceback"] = py::expect<py::Traceback>(tb).render();
-          }
-          response["result"] = error;
-          response["status"] = "error";
-        }
-        connection.send_text(
-            py::extract<std::string>(json.attr("dumps")(response)));
+        evaluator.submit(connection, data);
+      })
+      .onclose([&evaluator](Connection& connection, const auto&... /*args*/) {
+        evaluator.close(connection);
       });
 
-  CROW_ROUTE(app, "/")
-  ([&root_dir](const crow::request& /*request*/, crow::response& response) {
-    const auto index_html = root_dir / "frontend" / "index.html";
-    response.set_static_file_info_unsafe(index_html.native());
+  CROW_WEBSOCKET_ROUTE(app, "/live")
+      .onmessage([&streamer](Connection& connection,
+                             const std::string& data,
+                             bool is_binary) { //
+        TIT_ASSERT(!is_binary, "Binary messages are not supported.");
+        streamer.negotiate(connection, data);
+      })
+      .onclose([&streamer](Connection& connection, const auto&... /*args*/) {
+        streamer.close(connection);
+      });
+
+  // Metrics are served in the OpenMetrics text format, to be scraped by
+  // Prometheus.
+  Metrics::enable();
+  CROW_ROUTE(app, "/metrics")
+  ([](const crow::request& /*request*/, crow::response& response) {
+    response.set_header("Content-Type",
+                        "application/openmetrics-text; version=1.0.0");
+    response.write(Metrics::render_openmetrics());
     response.end();
   });
+
+  StaticFiles static_files{root_dir / "frontend"};
+  CROW_ROUTE(app, "/")
+  ([&static_files](const crow::request& request, crow::response& response) {
+    static_files.serve(request, response, "index.html");
+  });
   CROW_ROUTE(app, "/<path>")
-  ([&root_dir](const crow::request& /*request*/,
-               crow::response& response,
-               const std::filesystem::path& file_name) {
-    auto file_path = root_dir / "frontend" / file_name;
-    if (std::filesystem::is_directory(file_path)) file_path /= "index.html";
-    response.set_static_file_info_unsafe(file_path.native());
-    response.end();
+  ([&static_files](const crow::request& request,
+                   crow::response& response,
+                   const std::filesystem::path& file_name) {
+    static_files.serve(request, response, file_name);
+  });
+
+  StoredData stored_data{get_env("TIT_BACKEND_DATA_DIR")
+                             .transform([](std::string_view dir) {
+                               return std::filesystem::path{dir};
+                             })
+                             .value_or(root_dir / "data")};
+  CROW_ROUTE(app, "/data/<string>")
+  ([&stored_data](const crow::request& request,
+                  crow::response& response,
+                  const std::string& name) {
+    stored_data.serve_index(request, response, name);
+  });
+  CROW_ROUTE(app, "/data/<string>/steps/<uint>")
+  ([&stored_data](const crow::request& request,
+                  crow::response& response,
+                  const std::string& name,
+                  uint64_t time_step_id) {
+    stored_data.serve_time_step(request, response, name, time_step_id);
+  });
+  CROW_ROUTE(app, "/data/<string>/arrays/<uint>")
+  ([&stored_data](const crow::request& request,
+                  crow::response& response,
+                  const std::string& name,
+                  uint64_t array_id) {
+    stored_data.serve_array(request, response, name, array_id);
   });
 
   /// @todo Pass port as a command line argument.
-  const py::ReleaseGIL release_gil{};
   app.port(get_env<uint16_t>("TIT_BACKEND_PORT", 18080)).run();
 
   return 0;
@@ -0,0 +1,450 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/cmd.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/io.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/rand_utils.hpp"
+#include "tit/core/str_utils.hpp"
+#include "tit/core/time.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+#include "tit/geom/sort.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/energy_equation.hpp"
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/fluid_equations.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/momentum_equation.hpp"
+#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/viscosity.hpp"
+#include "tit/sph/wall_boundary.hpp"
+
+namespace tit::bench {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Single benchmark measurement.
+struct Result final {
+  std::string name;
+  size_t size;
+  size_t reps;
+  real_t min_time;
+  real_t avg_time;
+};
+
+// Benchmark runner. Each benchmark is run the specified number of times, and
+// the minimal and the average wall times are recorded. Throughputs are also
+// published as the `<name>::<size>` metrics, so that the timed tests could
+// match them with the baseline.
+class Runner final {
+public:
+
+  // Construct a benchmark runner.
+  explicit Runner(size_t num_reps) : num_reps_{num_reps} {
+    TIT_ASSERT(num_reps_ > 0, "Number of repetitions must be positive!");
+  }
+
+  // Run the benchmark.
+  template<class Func>
+  void run(std::string_view name, size_t size, Func func) {
+    Stopwatch total{};
+    auto min_time = std::numeric_limits<real_t>::max();
+    for (size_t rep = 0; rep < num_reps_; ++rep) {
+      const auto prev_total = total.total();
+      {
+        const StopwatchCycle cycle{total};
+        func();
+      }
+      min_time = std::min(min_time, total.total() - prev_total);
+    }
+    results_.push_back({.name = std::string{name},
+                        .size = size,
+                        .reps = num_reps_,
+                        .min_time = min_time,
+                        .avg_time = total.cycle()});
+    Metrics::set(std::format("{}::{}", name, size),
+                 static_cast<float64_t>(size) / min_time);
+    eprintln("{:<40} {:>10} {:>12.6f} s", name, size, min_time);
+  }
+
+  // Write the results as a JSON array to the standard output.
+  void report() const {
+    println("[");
+    for (const auto& [index, result] : std::views::enumerate(results_)) {
+      println(R"(  {{"name": "{}", "size": {}, "reps": {}, )"
+              R"("min_time": {:.9e}, "avg_time": {:.9e}, )"
+              R"("items_per_second": {:.6e}}}{})",
+              result.name,
+              result.size,
+              result.reps,
+              result.min_time,
+              result.avg_time,
+              static_cast<real_t>(result.size) / result.min_time,
+              std::cmp_less(index + 1, results_.size()) ? "," : "");
+    }
+    println("]");
+  }
+
+private:
+
+  size_t num_reps_;
+  std::vector<Result> results_;
+
+}; // class Runner
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Lattice spacing.
+constexpr real_t dr = 1.0;
+
+// Generate a cubic lattice of approximately the given amount of points.
+template<size_t Dim>
+auto make_lattice(size_t size) -> std::vector<Vec<real_t, Dim>> {
+  const auto side = static_cast<size_t>(
+      std::ceil(std::pow(static_cast<real_t>(size), 1.0 / Dim)));
+  std::vector<Vec<real_t, Dim>> points(size);
+  for (const auto& [index, point] : std::views::enumerate(points)) {
+    auto rest = static_cast<size_t>(index);
+    for (size_t d = 0; d < Dim; ++d) {
+      point[d] = dr * (static_cast<real_t>(rest % side) + 0.5);
+      rest /= side;
+    }
+  }
+  return points;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Benchmark the spatial search index construction and the neighbor search.
+template<class SearchFunc>
+void bench_search(Runner& runner,
+                  std::string_view name,
+                  size_t size,
+                  const SearchFunc& search_func) {
+  const auto points = make_lattice<3>(size);
+  const auto search_radius = 2.0 * dr;
+
+  runner.run(std::format("{}::index", name), size, [&] {
+    [[maybe_unused]] const auto index = search_func(points);
+  });
+
+  const auto index = search_func(points);
+  std::vector<std::vector<size_t>> neighbors(par::num_threads());
+  runner.run(std::format("{}::search", name), size, [&] {
+    par::static_for_each(std::views::iota(size_t{0}, size),
+                         [&](size_t thread, size_t i) {
+                           auto& out = neighbors[thread];
+                           out.clear();
+                           index.search(points[i],
+                                        search_radius,
+                                        std::back_inserter(out));
+                         });
+  });
+}
+
+// Benchmark the multivector assembly from the pairs.
+void bench_multivector(Runner& runner, size_t size) {
+  const auto count = std::max<size_t>(size / 8, 1);
+  const auto pairs = std::views::iota(size_t{0}, size) |
+                     std::views::transform([count](size_t i) {
+                       return std::pair{(i * 7919) % count, i};
+                     });
+
+  Multivector<size_t> multivector{};
+  runner.run("Multivector::assign_pairs_par_tall", size, [&] {
+    multivector.assign_pairs_par_tall(count, pairs);
+  });
+  runner.run("Multivector::assign_pairs_par_wide", size, [&] {
+    multivector.assign_pairs_par_wide(count, pairs);
+  });
+  runner.run("Multivector::assign_pairs_par_partitioned", size, [&] {
+    multivector.assign_pairs_par_partitioned(count, pairs);
+  });
+}
+
+// Benchmark a pair loop over the 3D vectors, that are either stored padded
+// to the whole SIMD registers, as `Vec` does, or packed into three numbers
+// and converted on each access.
+void bench_vec_layout(Runner& runner, size_t size) {
+  using PackedVec = std::array<real_t, 3>;
+  const auto search_radius = 2.0 * dr;
+  const auto padded = make_lattice<3>(size);
+  std::vector<PackedVec> packed(size);
+  par::transform(padded, packed.begin(), [](const auto& point) {
+    return point.elems();
+  });
+  Multivector<std::pair<size_t, size_t>> pairs{};
+  geom::GridSearch{search_radius}(padded).search_pairs(search_radius, pairs);
+
+  std::vector<Vec<real_t, 3>> results(pairs.size());
+  const auto pair_loop = [&pairs, &results, search_radius](const auto& load) {
+    par::for_each(std::views::iota(size_t{0}, pairs.size()), [&](size_t i) {
+      Vec<real_t, 3> result{};
+      for (const auto& [a, b] : pairs[i]) {
+        const auto r_ab = load(a) - load(b);
+        const auto q = norm(r_ab) / search_radius;
+        result += pow2(1.0 - q) * r_ab;
+      }
+      results[i] = result;
+    });
+  };
+  runner.run("Vec3D[padded]::pair_loop", size, [&] {
+    pair_loop([&padded](size_t a) -> const auto& { return padded[a]; });
+  });
+  runner.run("Vec3D[packed]::pair_loop", size, [&] {
+    pair_loop([&packed](size_t a) {
+      const auto& p = packed[a];
+      return Vec{p[0], p[1], p[2]};
+    });
+  });
+}
+
+// Benchmark the partitioning functions.
+template<class PartitionFunc>
+void bench_partition(Runner& runner,
+                     std::string_view name,
+                     size_t size,
+                     const PartitionFunc& partition_func) {
+  static constexpr size_t num_parts = 64;
+  const auto points = make_lattice<3>(size);
+  std::vector<size_t> parts(size);
+  runner.run(name, size, [&] { partition_func(points, parts, num_parts); });
+}
+
+// Particle reordering policy.
+enum class Reordering : uint8_t {
+  none,    // Keep the lattice order.
+  hilbert, // Sort along the Hilbert curve.
+  rcm,     // Order by the reverse Cuthill-McKee ordering of the adjacency.
+};
+
+// Benchmark the SPH equation passes on a 2D fluid lattice. If `Tiled` is
+// set, the fields read in the pair loops are stored in tiles. If reordering
+// is requested, the lattice is shuffled first and then reordered.
+template<bool Tiled = false>
+void bench_fluid_equations(Runner& runner,
+                           std::string_view name,
+                           size_t size,
+                           sph::PairStrategy pair_strategy,
+                           bool listless = false,
+                           Reordering reordering = Reordering::none) {
+  using namespace sph;
+  constexpr real_t rho_0 = 1000.0;
+  constexpr real_t cs_0 = 20.0;
+  constexpr real_t h_0 = 2.0 * dr;
+  constexpr real_t m_0 = rho_0 * dr * dr;
+
+  // Setup the equations in the same way the dam breaking solver does.
+  const FluidEquations equations{
+      MotionEquation{},
+      ContinuityEquation{},
+      MomentumEquation{
+          NoViscosity{},
+          DeltaSPHArtificialViscosity{cs_0, rho_0},
+          GravitySource{9.81},
+      },
+      NoEnergyEquation{},
+      LinearTaitEquationOfState{cs_0, rho_0},
+      QuarticWendlandKernel{},
+      // No walls, the lattice has no fixed particles.
+      WallBoundary<Vec<real_t, 2>>{},
+      pair_strategy,
+  };
+
+  // Setup the particles.
+  using Equations = std::remove_const_t<decltype(equations)>;
+  using Layout =
+      std::conditional_t<Tiled,
+                         AoSoALayout<decltype(auto(Equations::pair_fields))>,
+                         SoALayout>;
+  ParticleArray particles{Space<real_t, 2>{}, equations, Layout{}};
+  particles.reserve(size);
+  auto points = make_lattice<2>(size);
+  if (reordering != Reordering::none) {
+    std::ranges::shuffle(points, SplitMix64{size});
+  }
+  for (const auto& point : points) {
+    r[particles.append(ParticleType::fluid)] = point;
+  }
+  m[particles] = m_0;
+  h[particles] = h_0;
+  rho[particles] = rho_0;
+  equations.init(particles);
+
+  // Setup the particle mesh.
+  ParticleMesh mesh{
+      geom::GridSearch{h_0},
+      geom::RecursiveInertialBisection{},
+      geom::GridGraphPartition{2 * h_0},
+  };
+  mesh.enable_listless(listless);
+
+  // Reorder the particles. Reverse Cuthill-McKee ordering needs the adjacency
+  // graph, so its build is included into the measurement.
+  if (reordering == Reordering::hilbert) {
+    runner.run(std::format("{}::reorder", name), size, [&] {
+      particles.sort(geom::hilbert_key_sort);
+    });
+  } else if (reordering == Reordering::rcm) {
+    runner.run(std::format("{}::reorder", name), size, [&] {
+      mesh.invalidate();
+      equations.index(mesh, particles);
+      mesh.reorder(particles);
+    });
+  }
+
+  // Run the passes.
+  runner.run(std::format("{}::index", name), size, [&] {
+    mesh.invalidate();
+    equations.index(mesh, particles);
+  });
+  runner.run(std::format("{}::setup_boundary", name), size, [&] {
+    equations.setup_boundary(mesh, particles);
+  });
+  runner.run(std::format("{}::compute_density", name), size, [&] {
+    equations.compute_density(mesh, particles);
+  });
+  runner.run(std::format("{}::compute_forces", name), size, [&] {
+    equations.compute_forces(mesh, particles);
+  });
+  runner.run(std::format("{}::compute_density_and_forces", name), size, [&] {
+    equations.compute_density_and_forces(mesh, particles);
+  });
+}
+
+// Benchmark the data storage write throughput.
+void bench_storage(Runner& runner, size_t size) {
+  const auto path = std::filesystem::temp_directory_path() / "titbench.ttdb";
+  const auto points = make_lattice<3>(size);
+  std::filesystem::remove(path);
+  data::DataStorage storage{path};
+  storage.set_max_series(1);
+  const auto series = storage.create_series();
+  runner.run("DataStorage::create_array", size, [&] {
+    const auto time_step = series.create_time_step(0.0);
+    time_step.varyings().create_array("r", points);
+  });
+  std::filesystem::remove(path);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto bench_main(CmdArgs args) -> int {
+  // Parse the arguments.
+  const std::span argspan{args.argv(), static_cast<size_t>(args.argc())};
+  size_t max_size = 1'000'000;
+  size_t num_reps = 5;
+  if (argspan.size() >= 2) {
+    const auto value = str_to<size_t>(argspan[1]);
+    if (!value.has_value()) TIT_THROW("Invalid maximal size '{}'.", argspan[1]);
+    max_size = *value;
+  }
+  if (argspan.size() >= 3) {
+    const auto value = str_to<size_t>(argspan[2]);
+    if (!value.has_value() || *value == 0) {
+      TIT_THROW("Invalid number of repetitions '{}'.", argspan[2]);
+    }
+    num_reps = *value;
+  }
+
+  // Run the benchmarks. Cost of the reproducible mode is measured with the
+  // fixed number of parts that does not match the typical thread counts.
+  constexpr size_t reproducible_num_parts = 12;
+  Runner runner{num_reps};
+  for (size_t size = 10'000; size <= max_size; size *= 10) {
+    bench_search(runner, "GridIndex", size, geom::GridSearch{2.0 * dr});
+    bench_search(runner, "KDTreeIndex", size, geom::KDTreeSearch{32});
+    bench_search(runner, "OctreeIndex", size, geom::OctreeSearch{16});
+    bench_multivector(runner, size);
+    bench_vec_layout(runner, size);
+    bench_partition(runner,
+                    "RecursiveInertialBisection",
+                    size,
+                    geom::RecursiveInertialBisection{});
+    bench_partition(runner,
+                    "GridGraphPartition",
+                    size,
+                    geom::GridGraphPartition{2.0 * dr});
+    bench_fluid_equations(runner,
+                          "FluidEquations",
+                          size,
+                          sph::PairStrategy::scatter);
+    bench_fluid_equations(runner,
+                          "FluidEquations[gather]",
+                          size,
+                          sph::PairStrategy::gather);
+    bench_fluid_equations(runner,
+                          "FluidEquations[listless]",
+                          size,
+                          sph::PairStrategy::gather,
+                          /*listless=*/true);
+    bench_fluid_equations(runner,
+                          "FluidEquations[hilbert]",
+                          size,
+                          sph::PairStrategy::scatter,
+                          /*listless=*/false,
+                          Reordering::hilbert);
+    bench_fluid_equations(runner,
+                          "FluidEquations[rcm]",
+                          size,
+                          sph::PairStrategy::scatter,
+                          /*listless=*/false,
+                          Reordering::rcm);
+    bench_fluid_equations</*Tiled=*/true>(runner,
+                                          "FluidEquations[aosoa]",
+                                          size,
+                                          sph::PairStrategy::scatter);
+    par::set_reproducible(reproducible_num_parts);
+    bench_fluid_equations(runner,
+                          "FluidEquations[reproducible]",
+                          size,
+                          sph::PairStrategy::scatter);
+    par::set_reproducible(0);
+    bench_storage(runner, size);
+  }
+
+  // Report the results.
+  runner.report();
+  return 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit::bench
+
+TIT_IMPLEMENT_MAIN(bench::bench_main)
@@ -4,7 +4,9 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /// <reference types="vitest" />
+import fs from "node:fs/promises";
 import path from "node:path";
+import zlib from "node:zlib";
 import react from "@vitejs/plugin-react";
 import tailwindcss from "@tailwindcss/vite";
 import { Plugin, defineConfig } from "vite";
@@ -22,6 +24,7 @@ export default defineConfig({
     }),
     tailwindcss(),
     titback(),
+    precompress(),
   ],
   resolve: {
     alias: {
@@ -59,3 +62,41 @@ function titback(): Plugin {
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Vite plugin to precompress the bundled files, so that the backend server
+/// could serve them without compressing on the fly.
+function precompress(): Plugin {
+  const compressible = /\.(css|html|js|json|map|svg|txt|wasm)$/;
+  const minSize = 1024;
+  return {
+    name: "precompress-bundle",
+    apply: "build",
+    async writeBundle(options, bundle) {
+      const outDir = options.dir ?? "dist";
+      await Promise.all(
+        Object.keys(bundle)
+          .filter((fileName) => compressible.test(fileName))
+          .map(async (fileName) => {
+            const filePath = path.join(outDir, fileName);
+            const data = await fs.readFile(filePath);
+            if (data.length < minSize) return;
+            await fs.writeFile(
+              `${filePath}.gz`,
+              zlib.gzipSync(data, { level: zlib.constants.Z_BEST_COMPRESSION }),
+            );
+            await fs.writeFile(
+              `${filePath}.br`,
+              zlib.brotliCompressSync(data, {
+                params: {
+                  [zlib.constants.BROTLI_PARAM_QUALITY]:
+                    zlib.constants.BROTLI_MAX_QUALITY,
+                },
+              }),
+            );
+          }),
+      );
+    },
+  };
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,421 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/cmd.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/io.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/str_utils.hpp"
+#include "tit/core/time.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+#include "tit/geom/partition.hpp"
+#include "tit/geom/sdf.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/energy_equation.hpp"
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/fluid_equations.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/momentum_equation.hpp"
+#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_generator.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_output.hpp"
+#include "tit/sph/time_integrator.hpp"
+#include "tit/sph/time_step.hpp"
+#include "tit/sph/viscosity.hpp"
+#include "tit/sph/wall_boundary.hpp"
+
+namespace tit::scale {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Single run measurement.
+struct Run final {
+  size_t resolution;
+  size_t num_particles;
+  size_t num_threads;
+  real_t wall_time;
+  float64_t imbalance;
+  float64_t serial_fraction;
+  std::map<std::string, real_t> section_times;
+};
+
+// Deepest level of the reported sections: the root, the main thread, the
+// time step, its passes and their stages. Deeper sections are entered inside
+// of the parallel loops, so their times are summed over the threads, and are
+// not comparable across the thread counts.
+constexpr size_t max_section_depth = 4;
+
+// Flatten the sections of the main thread into the section paths, with the
+// section times in seconds.
+void flatten_sections(const ProfilerNode& node,
+                      const std::string& path,
+                      size_t depth,
+                      std::map<std::string, real_t>& times) {
+  if (depth > max_section_depth) return;
+  if (!path.empty()) {
+    times[path] += static_cast<real_t>(node.total_ns) * 1.0e-9;
+  }
+  for (const auto& child : node.children) {
+    flatten_sections(child,
+                     path.empty() ? child.name :
+                                    std::format("{}/{}", path, child.name),
+                     depth + 1,
+                     times);
+  }
+}
+
+// Section times of the main thread accumulated so far.
+auto main_section_times() -> std::map<std::string, real_t> {
+  std::map<std::string, real_t> times{};
+  const auto tree = Profiler::call_tree();
+  const auto main_iter = std::ranges::find(tree.children,
+                                           std::string_view{"main"},
+                                           &ProfilerNode::name);
+  if (main_iter != tree.children.end()) {
+    flatten_sections(*main_iter, "", /*depth=*/1, times);
+  }
+  return times;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Run the 2D dam break case, same as `titwcsph` does by default, with the
+// given number of particles per water column height, and measure the steps
+// after the first one.
+auto run_dam_break(size_t resolution,
+                   size_t num_steps,
+                   const std::filesystem::path& storage_path) -> Run {
+  using namespace sph;
+  using Real = real_t;
+  constexpr size_t Dim = 2;
+  constexpr Real H = 0.6;
+  constexpr Real L = 2 * H;
+  constexpr Real POOL_WIDTH = 5.366 * H;
+  constexpr Real POOL_HEIGHT = 2.5 * H;
+  constexpr Real g = 9.81;
+  constexpr Real rho_0 = 1000.0;
+  constexpr auto N_FIXED = 4;
+  const Real dr = H / static_cast<Real>(resolution);
+  const Real cs_0 = 20 * sqrt(g * H);
+  const Real h_0 = 2.0 * dr;
+  const Real m_0 = rho_0 * pow2(dr);
+  const auto WATER_M = static_cast<int>(round(L / dr));
+  const auto WATER_N = static_cast<int>(round(H / dr));
+  const auto POOL_M = static_cast<int>(round(POOL_WIDTH / dr));
+  const auto POOL_N = static_cast<int>(round(POOL_HEIGHT / dr));
+
+  // Setup the pool walls and the equations.
+  const geom::BBox pool{Vec<Real, Dim>{}, Vec{POOL_WIDTH, POOL_HEIGHT}};
+  const geom::GridSDF pool_sdf{
+      geom::Grid{auto{pool}.grow((N_FIXED + 1) * dr)}.set_cell_extents(dr),
+      [&pool](const Vec<Real, Dim>& position) {
+        return geom::box_sdf(pool, position);
+      },
+  };
+  const FluidEquations equations{
+      MotionEquation{},
+      ContinuityEquation{},
+      MomentumEquation{
+          NoViscosity{},
+          DeltaSPHArtificialViscosity{cs_0, rho_0},
+          GravitySource{g},
+      },
+      NoEnergyEquation{},
+      LinearTaitEquationOfState{cs_0, rho_0},
+      QuarticWendlandKernel{},
+      WallBoundary{pool_sdf, rho_0 / pow2(cs_0) * Vec{Real{0.0}, -g}},
+  };
+  RungeKuttaIntegrator time_integrator{equations,
+                                       /*mesh_update_freq=*/1};
+  TimeStepController time_step{cs_0, /*CFL=*/0.8};
+  time_step.set_body_force(g);
+
+  // Setup the particles.
+  ParticleArray particles{Space<Real, Dim>{}, time_integrator};
+  const auto lattice_node = [dr](int i, int j) {
+    return dr * Vec{static_cast<Real>(i), static_cast<Real>(j)};
+  };
+  const geom::BBox walls_box{lattice_node(-N_FIXED, -N_FIXED),
+                             lattice_node(POOL_M + N_FIXED, POOL_N)};
+  const geom::BBox interior_box{lattice_node(0, 0),
+                                lattice_node(POOL_M, POOL_N)};
+  append_lattice(particles,
+                 ParticleType::fixed,
+                 walls_box,
+                 dr,
+                 [&interior_box](const Vec<Real, Dim>& position) {
+                   return !interior_box.contains(position);
+                 });
+  append_lattice(particles,
+                 ParticleType::fluid,
+                 geom::BBox{lattice_node(0, 0), lattice_node(WATER_M, WATER_N)},
+                 dr);
+  m[particles] = m_0;
+  h[particles] = h_0;
+  rho[particles] = rho_0;
+  ParticleMesh mesh{
+      geom::GridSearch{h_0},
+      geom::RecursiveInertialBisection{},
+      geom::GridGraphPartition{2 * h_0},
+      /*skin=*/0.25 * h_0,
+  };
+
+  // Particles are written synchronously, so that the output is measured in
+  // the main thread, and no background thread enters the sections.
+  std::filesystem::remove(storage_path);
+  data::DataStorage storage{storage_path};
+  storage.set_max_series(1);
+  const auto series = storage.create_series();
+  const auto output = ParticleOutput{meta::Set{r, v, rho, p}};
+  const auto write = [&particles, &series, &output](Real time) {
+    TIT_PROFILE_SECTION("titscale::write()");
+    particles.write(time, series, output);
+  };
+
+  // Run the steps. First step builds the mesh from scratch and allocates
+  // the buffers, so it is excluded from the measurements.
+  Real time{};
+  const auto step = [&time_step, &time_integrator, &mesh, &particles, &time,
+                     &write](size_t n) {
+    const auto dt = time_step(particles);
+    time_integrator.step(dt, mesh, particles);
+    time += dt;
+    if (n % 10 == 0) write(time);
+  };
+  step(0);
+  const auto times_before = main_section_times();
+  Stopwatch wall{};
+  {
+    const StopwatchCycle cycle{wall};
+    for (size_t n = 1; n <= num_steps; ++n) step(n);
+  }
+  auto times = main_section_times();
+  for (auto& [path, section_time] : times) {
+    if (const auto iter = times_before.find(path);
+        iter != times_before.end()) {
+      section_time -= iter->second;
+    }
+  }
+  std::filesystem::remove(storage_path);
+
+  return {.resolution = resolution,
+          .num_particles = particles.size(),
+          .num_threads = par::num_threads(),
+          .wall_time = wall.total(),
+          .imbalance = mesh.imbalance(),
+          .serial_fraction = mesh.serial_fraction(),
+          .section_times = std::move(times)};
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Scaling study: a series of runs over the thread counts, compared to the
+// single thread run. In the strong scaling study the problem size is fixed,
+// so the ideal speedup equals the thread count. In the weak scaling study
+// the problem size grows with the thread count, so the ideal time is that of
+// the single thread.
+class Study final {
+public:
+
+  // Construct a scaling study.
+  Study(std::string name, bool weak) : name_{std::move(name)}, weak_{weak} {}
+
+  // Add the run to the study.
+  void add(Run run) {
+    runs_.push_back(std::move(run));
+  }
+
+  // Parallel efficiency of the run, relative to the first run.
+  auto efficiency(real_t base_time, real_t time, size_t num_threads) const
+      -> real_t {
+    const auto speedup = base_time / time;
+    return weak_ ? speedup : speedup / static_cast<real_t>(num_threads);
+  }
+
+  // Print the speedup and efficiency tables to the standard error output.
+  void print_tables() const {
+    if (runs_.empty()) return;
+    const auto& base = runs_.front();
+    eprintln();
+    eprintln("{} scaling", name_);
+    eprintln("{:>8} {:>10} {:>12} {:>9} {:>10} {:>10} {:>9}",
+             "threads",
+             "particles",
+             "time [s]",
+             "speedup",
+             "efficiency",
+             "imbalance",
+             "serial");
+    for (const auto& run : runs_) {
+      eprintln(
+          "{:>8} {:>10} {:>12.4f} {:>9.2f} {:>9.1f}% {:>10.3f} {:>8.1f}%",
+          run.num_threads,
+          run.num_particles,
+          run.wall_time,
+          base.wall_time / run.wall_time,
+          100.0 * efficiency(base.wall_time, run.wall_time, run.num_threads),
+          run.imbalance,
+          100.0 * run.serial_fraction);
+    }
+
+    // Per-pass efficiencies show which of the passes stops scaling first.
+    eprintln();
+    eprintln("{} scaling efficiency per section", name_);
+    std::string header = std::format("{:<64}", "section");
+    for (const auto& run : runs_) {
+      header += std::format(" {:>7}", std::format("{}T", run.num_threads));
+    }
+    eprintln("{}", header);
+    for (const auto& [path, base_time] : base.section_times) {
+      if (base_time <= 0.0) continue;
+      std::string line = std::format("{:<64}", path);
+      for (const auto& run : runs_) {
+        const auto iter = run.section_times.find(path);
+        if (iter == run.section_times.end() || iter->second <= 0.0) {
+          line += std::format(" {:>7}", "-");
+          continue;
+        }
+        line += std::format(
+            " {:>6.1f}%",
+            100.0 * efficiency(base_time, iter->second, run.num_threads));
+      }
+      eprintln("{}", line);
+    }
+  }
+
+  // Print the per-section scaling curves as the CSV rows to the standard
+  // output.
+  void print_curves() const {
+    if (runs_.empty()) return;
+    const auto& base = runs_.front();
+    for (const auto& run : runs_) {
+      const auto print_row = [&run, this](std::string_view section,
+                                          real_t base_time,
+                                          real_t time) {
+        println("{},{},{},{},\"{}\",{:.9e},{:.6f},{:.6f}",
+                name_,
+                run.num_threads,
+                run.resolution,
+                run.num_particles,
+                section,
+                time,
+                base_time / time,
+                efficiency(base_time, time, run.num_threads));
+      };
+      print_row("total", base.wall_time, run.wall_time);
+      for (const auto& [path, time] : run.section_times) {
+        const auto iter = base.section_times.find(path);
+        if (iter == base.section_times.end()) continue;
+        if (iter->second <= 0.0 || time <= 0.0) continue;
+        print_row(path, iter->second, time);
+      }
+    }
+  }
+
+private:
+
+  std::string name_;
+  bool weak_;
+  std::vector<Run> runs_;
+
+}; // class Study
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Thread counts of the study: powers of two, up to the maximal one, and the
+// maximal one itself.
+auto thread_counts(size_t max_threads) -> std::vector<size_t> {
+  std::vector<size_t> result{};
+  for (size_t n = 1; n < max_threads; n *= 2) result.push_back(n);
+  result.push_back(max_threads);
+  return result;
+}
+
+auto scale_main(CmdArgs args) -> int {
+  // Parse the arguments.
+  const std::span argspan{args.argv(), static_cast<size_t>(args.argc())};
+  if (argspan.size() > 4) {
+    TIT_THROW("Usage: {} [max_threads] [resolution] [num_steps]", argspan[0]);
+  }
+  const auto parse_arg = [&argspan](size_t index,
+                                    std::string_view what,
+                                    size_t fallback) {
+    if (argspan.size() <= index) return fallback;
+    const auto value = str_to<size_t>(argspan[index]);
+    if (!value.has_value() || *value == 0) {
+      TIT_THROW("Invalid {} '{}'.", what, argspan[index]);
+    }
+    return *value;
+  };
+  const auto max_threads =
+      parse_arg(1, "maximal number of threads", par::num_threads());
+  const auto resolution = parse_arg(2, "resolution", 80);
+  const auto num_steps = parse_arg(3, "number of steps", 50);
+
+  // Section times are collected by the profiler, so it is enabled, unless it
+  // already is.
+  if (!Profiler::is_enabled()) Profiler::enable();
+  const auto storage_path =
+      std::filesystem::temp_directory_path() / "titscale.ttdb";
+
+  // Run the studies. In the weak scaling study, number of the particles per
+  // thread is kept, so the 2D resolution grows as the square root of the
+  // thread count.
+  Study strong{"strong", /*weak=*/false};
+  Study weak{"weak", /*weak=*/true};
+  for (const auto num_threads : thread_counts(max_threads)) {
+    par::set_num_threads(num_threads);
+    const auto weak_resolution = static_cast<size_t>(
+        std::round(static_cast<real_t>(resolution) *
+                   std::sqrt(static_cast<real_t>(num_threads))));
+    eprintln("Running with {} threads...", num_threads);
+    strong.add(run_dam_break(resolution, num_steps, storage_path));
+    weak.add(run_dam_break(weak_resolution, num_steps, storage_path));
+  }
+  par::set_num_threads(max_threads);
+
+  // Report the results.
+  println("study,threads,resolution,particles,section,time,speedup,"
+          "efficiency");
+  strong.print_curves();
+  weak.print_curves();
+  strong.print_tables();
+  weak.print_tables();
+  return 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit::scale
+
+TIT_IMPLEMENT_MAIN(scale::scale_main)
@@ -1,16 +1,45 @@
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "tit/core/autotune.hpp"
 #include "tit/core/basic_types.hpp"
 #include "tit/core/cmd.hpp"
+#include "tit/core/config.hpp"
+#include "tit/core/exception.hpp"
 #include "tit/core/log.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/metrics.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/sys/signal.hpp"
+#include "tit/core/sys/utils.hpp"
 #include "tit/core/time.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
 #include "tit/geom/partition.hpp"
+#include "tit/geom/sdf.hpp"
 #include "tit/geom/search.hpp"
+#include "tit/geom/sort.hpp"
 
+#include "tit/data/live.hpp"
+#include "tit/data/shared.hpp"
 #include "tit/data/storage.hpp"
+#include "tit/data/writer.hpp"
 
 #include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/checkpoint.hpp"
 #include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/diagnostics.hpp"
 #include "tit/sph/energy_equation.hpp"
 #include "tit/sph/equation_of_state.hpp"
 #include "tit/sph/field.hpp"
@@ -19,44 +48,158 @@
 #include "tit/sph/momentum_equation.hpp"
 #include "tit/sph/motion_equation.hpp"
 #include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_generator.hpp"
 #include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_output.hpp"
+#include "tit/sph/sleep.hpp"
 #include "tit/sph/time_integrator.hpp"
+#include "tit/sph/time_step.hpp"
 #include "tit/sph/viscosity.hpp"
+#include "tit/sph/wall_boundary.hpp"
 
 namespace tit::sph {
 namespace {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// Smoothing kernels that could be selected in the case file.
+using KernelVariant =
+    std::variant<QuarticWendlandKernel,
+                 SixthOrderWendlandKernel,
+                 CubicSplineKernel>;
+
+auto make_kernel(std::string_view name) -> KernelVariant {
+  if (name == "quartic_wendland") return QuarticWendlandKernel{};
+  if (name == "sixth_order_wendland") return SixthOrderWendlandKernel{};
+  if (name == "cubic_spline") return CubicSplineKernel{};
+  TIT_THROW("Unknown kernel '{}'.", name);
+}
+
+// Artificial viscosity schemes that could be selected in the case file.
+using ArtificialViscosityVariant =
+    std::variant<DeltaSPHArtificialViscosity,
+                 MolteniColagrossiArtificialViscosity>;
+
+auto make_artificial_viscosity(std::string_view name,
+                               real_t cs_0,
+                               real_t rho_0,
+                               real_t alpha,
+                               real_t diffusion) -> ArtificialViscosityVariant {
+  if (name == "delta_sph") {
+    return DeltaSPHArtificialViscosity{cs_0, rho_0, alpha, diffusion};
+  }
+  if (name == "molteni_colagrossi") {
+    return MolteniColagrossiArtificialViscosity{cs_0, rho_0, alpha, diffusion};
+  }
+  TIT_THROW("Unknown artificial viscosity '{}'.", name);
+}
+
+auto make_boundary_update(std::string_view name) -> BoundaryUpdate {
+  if (name == "each_stage") return BoundaryUpdate::each_stage;
+  if (name == "each_step") return BoundaryUpdate::each_step;
+  TIT_THROW("Unknown boundary update '{}'.", name);
+}
+
+auto make_boundary_model(std::string_view name) -> BoundaryModel {
+  if (name == "interpolation") return BoundaryModel::interpolation;
+  if (name == "dynamic") return BoundaryModel::dynamic;
+  TIT_THROW("Unknown boundary model '{}'.", name);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Dam break case parameters.
 template<class Real>
-auto sph_main(CmdArgs /*args*/) -> int {
-  constexpr Real H = 0.6;   // Water column height.
-  constexpr Real L = 2 * H; // Water column length.
+struct DamBreakCase final {
+  size_t dim;        // Spatial dimension, 2 or 3.
+  Real H;            // Water column height.
+  Real W;            // Pool width along the third axis, in 3D.
+  Real dr;           // Particle spacing.
+  Real g;            // Gravity acceleration.
+  Real rho_0;        // Reference density.
+  Real cs_0;         // Reference sound speed.
+  Real CFL;          // Courant number.
+  Real end_time;     // Dimensionless end time.
+  Real log_interval; // Interval between the progress lines (in seconds).
+  size_t num_relax_iters;
+  BoundaryModel boundary_model;
+  BoundaryUpdate boundary_update;
+  bool interp_cache;
+  bool aligned_layout;
+  size_t tile_size; // Particles per pair traversal tile, zero to disable.
+  Real speculation_margin;
+  bool sleep;
+  Real sleep_velocity;     // Velocity threshold of the sleeping particles.
+  Real sleep_acceleration; // Acceleration threshold of the sleeping particles.
+  size_t sleep_steps;      // Quiet steps before the particle falls asleep.
+  bool autotune;
+  size_t autotune_steps;
+  std::filesystem::path autotune_cache_path;
+  std::filesystem::path storage_path;
+  std::filesystem::path checkpoint_path;
+  std::string shared_memory; // Shared memory channel name, empty to disable.
+  size_t shared_interval;    // Steps between the shared memory frames.
+  size_t rollback_interval;  // Steps between the rollback checkpoints.
+  size_t rollback_depth;     // Number of the stored rollback checkpoints.
+  size_t rollback_retries;   // Retries of the unstable steps before failing.
+  Real rollback_dt_factor;   // Time step reduction factor of each retry.
+};
 
-  constexpr Real POOL_WIDTH = 5.366 * H;
-  constexpr Real POOL_HEIGHT = 2.5 * H;
+template<class Real, size_t Dim, class Kernel, class ArtificialViscosity>
+auto run_case(const DamBreakCase<Real>& params,
+              const Kernel& kernel,
+              const ArtificialViscosity& artificial_viscosity) -> int {
+  const Real H = params.H;
+  const Real L = 2 * H; // Water column length.
 
-  constexpr Real dr = H / 80.0;
+  const Real POOL_WIDTH = 5.366 * H;
+  const Real POOL_HEIGHT = 2.5 * H;
+  const Real POOL_DEPTH = params.W;
+
+  const Real dr = params.dr;
 
   constexpr auto N_FIXED = 4;
-  constexpr auto WATER_M = int(round(L / dr));
-  constexpr auto WATER_N = int(round(H / dr));
-  constexpr auto POOL_M = int(round(POOL_WIDTH / dr));
-  constexpr auto POOL_N = int(round(POOL_HEIGHT / dr));
+  const auto WATER_M = int(round(L / dr));
+  const auto WATER_N = int(round(H / dr));
+  const auto POOL_M = int(round(POOL_WIDTH / dr));
+  const auto POOL_N = int(round(POOL_HEIGHT / dr));
+  const auto POOL_K = int(round(POOL_DEPTH / dr));
 
-  constexpr Real g = 9.81;
-  constexpr Real rho_0 = 1000.0;
-  constexpr Real cs_0 = 20 * sqrt(g * H);
-  constexpr Real h_0 = 2.0 * dr;
-  constexpr Real m_0 = rho_0 * pow(dr, 2);
+  const Real g = params.g;
+  const Real rho_0 = params.rho_0;
+  const Real cs_0 = params.cs_0;
+  const Real h_0 = 2.0 * dr;
+  const Real m_0 = rho_0 * pow<Dim>(dr);
 
-  constexpr Real CFL = 0.8;
-  constexpr Real dt = std::min(CFL * h_0 / cs_0, 0.25 * sqrt(h_0 / g));
+  const Real CFL = params.CFL;
 
   // Parameters for the heat equation. Unused for now.
   [[maybe_unused]] constexpr Real kappa_0 = 0.6;
   [[maybe_unused]] constexpr Real c_v = 4184.0;
 
+  // Points of the case space. The second axis is vertical, and the third
+  // one, that is present in 3D only, spans the pool width, so the water
+  // column occupies the full width and the 2D initial state is reused.
+  const auto point = [](Real x, Real y, Real z) {
+    Vec<Real, Dim> result{};
+    result[0] = x;
+    result[1] = y;
+    if constexpr (Dim == 3) result[2] = z;
+    return result;
+  };
+
+  // Setup the pool walls. Signed distance field is sampled over the pool
+  // extended by the fixed particle layers.
+  const geom::BBox pool{Vec<Real, Dim>{},
+                        point(POOL_WIDTH, POOL_HEIGHT, POOL_DEPTH)};
+  const geom::GridSDF pool_sdf{
+      geom::Grid{auto{pool}.grow((N_FIXED + 1) * dr)}.set_cell_extents(dr),
+      [&pool](const Vec<Real, Dim>& position) {
+        // Walls are outside of the pool.
+        return geom::box_sdf(pool, position);
+      },
+  };
+
   // Setup the SPH equations.
   const FluidEquations equations{
       // Standard motion equation.
@@ -67,8 +210,8 @@ auto sph_main(CmdArgs /*args*/) -> int {
       MomentumEquation{
           // Inviscid flow.
           NoViscosity{},
-          // δ-SPH artificial viscosity formulation.
-          DeltaSPHArtificialViscosity{cs_0, rho_0},
+          // Artificial viscosity selected in the case file.
+          artificial_viscosity,
           // Gravity source term.
           GravitySource{g},
       },
@@ -76,112 +219,460 @@ auto sph_main(CmdArgs /*args*/) -> int {
       NoEnergyEquation{},
       // Weakly compressible equation of state.
       LinearTaitEquationOfState{cs_0, rho_0},
-      // C2 Wendland's spline kernel.
-      QuarticWendlandKernel{},
+      // Smoothing kernel selected in the case file.
+      kernel,
+      // Pool walls, with the hydrostatic density gradient near them.
+      WallBoundary{pool_sdf, rho_0 / pow2(cs_0) * point(0, -g, 0)},
+      // Default pair strategy and switch evaluation, and no renormalization.
+      PairStrategy::scatter,
+      SwitchEvaluation::full,
+      /*renormalization_max_disp=*/0.0,
+      // Wall boundary model selected in the case file.
+      params.boundary_model,
   };
 
-  // Setup the time integrator.
-  RungeKuttaIntegrator time_integrator{equations};
+  // Setup the time integrator. Mesh is checked for updates on each step, it
+  // is rebuilt only when the Verlet skin is exhausted.
+  RungeKuttaIntegrator time_integrator{equations,
+                                       /*mesh_update_freq=*/1,
+                                       params.boundary_update};
+
+  // Put the quiescent particles to sleep, if requested. Tracking cells cover
+  // the kernel support along with the Verlet skin.
+  if (params.sleep) {
+    time_integrator.enable_sleep(
+        SleepController{kernel.radius(h_0) + 0.25 * h_0,
+                        params.sleep_velocity,
+                        params.sleep_acceleration,
+                        params.sleep_steps});
+  }
+
+  // Setup the adaptive time step controller. Gravity bounds the first step.
+  TimeStepController time_step{cs_0, CFL};
+  time_step.set_body_force(g);
+
+  // Setup the global diagnostics. They are accumulated by the time integrator
+  // update loops, exported as the metrics, and the stable time step is
+  // passed to the time step controller.
+  Diagnostics diagnostics{KineticEnergy{},
+                          TotalMass{},
+                          MaxVelocity{},
+                          MeanDensity{},
+                          NumUnstable{},
+                          StableTimeStep{time_step}};
 
   // Setup the particles array:
   ParticleArray particles{
-      // 2D space.
-      Space<Real, 2>{},
-      // Set of fields is inferred from the equations.
-      time_integrator,
+      // 2D or 3D space.
+      Space<Real, Dim>{},
+      // Set of fields is inferred from the equations, the quiet step
+      // counters are stored for the sleeping particles.
+      WithFields{time_integrator, meta::Set{quiet_steps}},
   };
 
-  // Generate individual particles.
-  size_t num_fixed_particles = 0;
-  size_t num_fluid_particles = 0;
-  for (auto i = -N_FIXED; i < POOL_M + N_FIXED; ++i) {
-    for (auto j = -N_FIXED; j < POOL_N; ++j) {
-      const bool is_fixed = (i < 0 || i >= POOL_M) || (j < 0);
-      const bool is_fluid = (i < WATER_M) && (j < WATER_N);
-
-      if (is_fixed) num_fixed_particles += 1;
-      else if (is_fluid) num_fluid_particles += 1;
-      else continue;
-
-      auto a = particles.append(is_fixed ? ParticleType::fixed :
-                                           ParticleType::fluid);
-      r[a] = dr * Vec{i + 0.5, j + 0.5};
-    }
-  }
-  TIT_INFO("Num. fixed particles: {}", num_fixed_particles);
-  TIT_INFO("Num. fluid particles: {}", num_fluid_particles);
+  // Generate the particles on the lattice: the fixed particles fill the
+  // layers around the pool, and the fluid particles fill the water column.
+  // Particles of each type are generated in parallel and appended in a
+  // single batch.
+  const auto lattice_node = [dr, &point](int i, int j, int k) {
+    return dr * point(static_cast<Real>(i),
+                      static_cast<Real>(j),
+                      static_cast<Real>(k));
+  };
+  const geom::BBox walls_box{
+      lattice_node(-N_FIXED, -N_FIXED, -N_FIXED),
+      lattice_node(POOL_M + N_FIXED, POOL_N, POOL_K + N_FIXED)};
+  const geom::BBox interior_box{lattice_node(0, 0, 0),
+                                lattice_node(POOL_M, POOL_N, POOL_K)};
+  const geom::BBox water_box{lattice_node(0, 0, 0),
+                             lattice_node(WATER_M, WATER_N, POOL_K)};
+  const auto num_fixed =
+      append_lattice(particles,
+                     ParticleType::fixed,
+                     walls_box,
+                     dr,
+                     [&interior_box](const Vec<Real, Dim>& position) {
+                       return !interior_box.contains(position);
+                     })
+          .size();
+  const auto num_fluid =
+      append_lattice(particles, ParticleType::fluid, water_box, dr).size();
+  TIT_INFO("Num. fixed particles: {}", num_fixed);
+  TIT_INFO("Num. fluid particles: {}", num_fluid);
 
   // Set global particle constants.
   m[particles] = m_0;
   h[particles] = h_0;
 
   // Density hydrostatic initialization.
-  for (const auto a : particles.all()) {
-    if (a.has_type(ParticleType::fixed)) {
-      rho[a] = rho_0;
-      continue;
-    }
-
-    // Compute pressure from Poisson problem.
-    const auto x = r[a][0];
-    const auto y = r[a][1];
-    p[a] = rho_0 * g * (H - y);
-    for (size_t N = 1; N < 100; N += 2) {
-      constexpr auto pi = std::numbers::pi_v<Real>;
-      const auto n = static_cast<Real>(N);
-      p[a] -= 8 * rho_0 * g * H / pow2(pi) *
-              (exp(n * pi * (x - L) / (2 * H)) * cos(n * pi * y / (2 * H))) /
-              pow2(n);
-    }
-    // Recalculate density from EOS.
-    rho[a] = rho_0 + p[a] / pow2(cs_0);
-  }
+  const auto init_hydrostatic = [&particles, H, L, g, rho_0, cs_0] {
+    par::for_each(particles.fixed(), [rho_0](auto a) { rho[a] = rho_0; });
+    par::for_each(particles.fluid(), [H, L, g, rho_0, cs_0](auto a) {
+      // Compute pressure from Poisson problem.
+      const auto x = r[a][0];
+      const auto y = r[a][1];
+      p[a] = rho_0 * g * (H - y);
+      for (size_t N = 1; N < 100; N += 2) {
+        constexpr auto pi = std::numbers::pi_v<Real>;
+        const auto n = static_cast<Real>(N);
+        p[a] -= 8 * rho_0 * g * H / pow2(pi) *
+                (exp(n * pi * (x - L) / (2 * H)) *
+                 cos(n * pi * y / (2 * H))) /
+                pow2(n);
+      }
+      // Recalculate density from EOS.
+      rho[a] = rho_0 + p[a] / pow2(cs_0);
+    });
+  };
+  init_hydrostatic();
 
   // Setup the particle mesh structure.
-  ParticleMesh mesh{
-      // Search for the particles using the grid search.
-      geom::GridSearch{h_0},
-      // Use RIB as the primary partitioning method.
-      geom::RecursiveInertialBisection{},
-      // Use graph partitioning with larger cell size as the interface
-      // partitioning method.
-      geom::GridGraphPartition{2 * h_0},
+  const auto make_mesh = [h_0, &params](Real search_cell_size,
+                                        size_t num_levels,
+                                        bool pair_cache) {
+    ParticleMesh mesh{
+        // Search for the particles using the grid search.
+        geom::GridSearch{search_cell_size},
+        // Use RIB as the primary partitioning method.
+        geom::RecursiveInertialBisection{},
+        // Use graph partitioning with larger cell size as the interface
+        // partitioning method.
+        geom::GridGraphPartition{2 * h_0},
+        // Use Verlet skin to avoid rebuilding the mesh on each step.
+        /*skin=*/0.25 * h_0,
+    };
+    mesh.set_num_levels(num_levels);
+    mesh.enable_pair_cache(pair_cache);
+    mesh.enable_interp_cache(params.interp_cache);
+    mesh.enable_aligned_layout(params.aligned_layout);
+    if (params.tile_size != 0) mesh.enable_tiling(true, params.tile_size);
+    mesh.enable_speculation(params.speculation_margin * h_0);
+    return mesh;
   };
 
+  // Select the search, partitioning and scheduling parameters. Unless the
+  // autotuning is enabled, the defaults are used. Each parameter is tuned in
+  // turn, with the previously tuned ones fixed, by running a few steps on a
+  // copy of the particles.
+  Real search_cell_size = h_0;
+  size_t num_levels = 2;
+  bool pair_cache = false;
+  if (params.autotune) {
+    Autotuner autotuner{
+        params.autotune_cache_path,
+        std::format("titwcsph, dim {}, {} particles", Dim, particles.size())};
+    const auto trial = [&](Real trial_search_cell_size,
+                           size_t trial_num_levels,
+                           bool trial_pair_cache) {
+      auto trial_particles = particles;
+      auto trial_integrator = time_integrator;
+      auto trial_time_step = time_step;
+      auto trial_mesh = make_mesh(trial_search_cell_size,
+                                  trial_num_levels,
+                                  trial_pair_cache);
+      for (size_t n = 0; n < params.autotune_steps; ++n) {
+        trial_integrator.step(trial_time_step(trial_particles),
+                              trial_mesh,
+                              trial_particles);
+      }
+    };
+    constexpr std::array<size_t, 4> grain_sizes{1, 16, 64, 256};
+    par::set_grain_size(grain_sizes[autotuner.select(
+        "grain_size",
+        grain_sizes.size(),
+        [&](size_t index) {
+          par::set_grain_size(grain_sizes[index]);
+          trial(search_cell_size, num_levels, pair_cache);
+        })]);
+    const std::array<Real, 3> search_cell_sizes{h_0, 3 * h_0 / 2, 3 * h_0};
+    search_cell_size = search_cell_sizes[autotuner.select(
+        "search_cell_size",
+        search_cell_sizes.size(),
+        [&](size_t index) {
+          trial(search_cell_sizes[index], num_levels, pair_cache);
+        })];
+    constexpr std::array<size_t, 3> level_counts{1, 2, 3};
+    num_levels = level_counts[autotuner.select(
+        "num_levels",
+        level_counts.size(),
+        [&](size_t index) {
+          trial(search_cell_size, level_counts[index], pair_cache);
+        })];
+    pair_cache = autotuner.select("pair_cache", 2, [&](size_t index) {
+      trial(search_cell_size, num_levels, index != 0);
+    }) != 0;
+  }
+  auto mesh = make_mesh(search_cell_size, num_levels, pair_cache);
+
+  // Relax the lattice, if requested, and initialize the density for the
+  // relaxed particle positions.
+  if (params.num_relax_iters > 0) {
+    relax_particles(equations, mesh, particles, params.num_relax_iters);
+    init_hydrostatic();
+  }
+
+  // Checkpoints are written periodically, so that a crashed run could be
+  // restarted from the last one by setting the `TIT_RESTART` variable.
+  const auto& checkpoint_path = params.checkpoint_path;
+  const auto restart = get_env<bool>("TIT_RESTART", false);
+  size_t first_n = 0;
+  Real time{};
+  if (restart) {
+    load_checkpoint(checkpoint_path,
+                    first_n,
+                    time,
+                    time_integrator,
+                    time_step,
+                    particles);
+    TIT_INFO("Restarted from the step {}.", first_n);
+  }
+
   // Create a data storage to store the particles.  We'll store only one last
-  // run result, all the previous runs will be discarded.
-  data::DataStorage storage{"./particles.ttdb"};
+  // run result, all the previous runs will be discarded. Restarted run
+  // continues the last series, dropping the outputs past the checkpoint.
+  data::DataStorage storage{params.storage_path};
   storage.set_max_series(1);
-  const auto series = storage.create_series();
-  particles.write(0.0, series);
+  const auto series = restart ? storage.last_series() : storage.create_series();
+  if (restart) {
+    for (const auto step : series.time_steps()) {
+      if (step.time() >= time * sqrt(g / H)) storage.delete_time_step(step);
+    }
+  }
+  // Particles are written in background, so that the simulation could
+  // continue while the data is being compressed and stored.
+  data::DataWriter writer{series};
+  // Only the fields of interest are written: the pressures are written
+  // with each tenth output, and the rest of the fields with each output.
+  const auto output =
+      ParticleOutput{meta::Set{m, h, r, v, rho, p}, /*interval=*/100}
+          .set_interval(p, 1000);
+  if (!restart) particles.write(0.0, writer, output);
+  // External in-situ tools read the frames from the shared memory, if it is
+  // enabled. Slots are sized so that any subset of the fields fits.
+  std::optional<data::SharedChannel> shared;
+  const auto shared_output = ParticleOutput{meta::Set{m, h, r, v, rho, p}};
+  if (!params.shared_memory.empty()) {
+    shared.emplace(params.shared_memory,
+                   particles.size_bytes() + 1024 * 1024);
+  }
+
+  // In-memory checkpoints are taken periodically, if enabled. Once the run
+  // becomes unstable, it is rolled back to the latest one and retried with
+  // a smaller time step. Time step is restored after each interval of the
+  // stable steps.
+  std::optional<CheckpointRing> rollback_ring;
+  if (params.rollback_interval != 0) {
+    rollback_ring.emplace(params.rollback_depth);
+  }
+  size_t num_retries = 0;
+
+  // Preemption signals request the stop, that is performed on the step
+  // boundary: the checkpoint is saved and the run finishes normally, so it
+  // could be restarted.
+  const StopSignalHandler stop_handler{};
 
-  Real time{};
   Stopwatch exectime{};
   Stopwatch printtime{};
-  for (size_t n = 0;; ++n) {
-    TIT_INFO("{:>15}\t\t{:>10.5f}\t\t{:>10.5f}\t\t{:>10.5f}",
-             n,
-             time * sqrt(g / H),
-             exectime.cycle(),
-             printtime.cycle());
+  float64_t num_particle_steps = 0.0;
+  for (size_t n = first_n;; ++n) {
+    // Roll back the unstable run, or store the rollback checkpoint.
+    const auto unstable = rollback_ring.has_value() &&
+                          diagnostics.count() != 0 &&
+                          diagnostics.get<NumUnstable>() > 0.0;
+    if (unstable) {
+      if (rollback_ring->empty() || num_retries == params.rollback_retries) {
+        TIT_THROW("Run became unstable at the step {}, after {} retries.",
+                  n,
+                  num_retries);
+      }
+      const auto unstable_n = n;
+      rollback_ring->restore(n, time, time_integrator, time_step, particles);
+      mesh.invalidate();
+      time_step.set_scale(time_step.scale() * params.rollback_dt_factor);
+      num_retries += 1;
+      // Outputs past the rollback are rewritten.
+      writer.flush();
+      for (const auto step : series.time_steps()) {
+        if (step.time() >= time * sqrt(g / H)) storage.delete_time_step(step);
+      }
+      TIT_WARN("Unstable at the step {}, rolled back to the step {}, "
+               "time step is scaled by {}.",
+               unstable_n,
+               n,
+               time_step.scale());
+    } else if (rollback_ring && n % params.rollback_interval == 0) {
+      if (num_retries > 0) {
+        num_retries = 0;
+        time_step.set_scale(
+            std::min(time_step.scale() / params.rollback_dt_factor, Real{1}));
+      }
+      rollback_ring->save(n, time, time_integrator, time_step, particles);
+    }
+
+    const auto stop = stop_handler.stop_requested();
+    if ((n % 1000 == 0 && n != first_n) || stop) {
+      save_checkpoint(checkpoint_path,
+                      n,
+                      time,
+                      time_integrator,
+                      time_step,
+                      particles);
+    }
+    if (stop) {
+      TIT_WARN("Stopped by the signal {} at the step {}, checkpoint is saved.",
+               stop_handler.signal_number(),
+               n);
+      break;
+    }
+    TIT_INFO_EVERY(params.log_interval,
+                   "{:>15}\t\t{:>10.5f}\t\t{:>10.5f}\t\t{:>10.5f}",
+                   n,
+                   time * sqrt(g / H),
+                   exectime.cycle(),
+                   printtime.cycle());
+    // Stable time step is known from the diagnostics of the previous step,
+    // the particles are traversed only on the first step and after the
+    // rollbacks.
+    const auto dt =
+        diagnostics.count() == 0 || unstable
+            ? time_step(particles)
+            : time_step(static_cast<Real>(diagnostics.get<StableTimeStep>()));
     {
       const StopwatchCycle cycle{exectime};
-      time_integrator.step(dt, mesh, particles);
+      if (n % 100 == 0) {
+        // Restore the spatial locality of the particles.
+        particles.sort(geom::HilbertCurveSort{});
+        mesh.invalidate();
+      }
+      time_integrator.step(dt, mesh, particles, diagnostics);
+      diagnostics.reduce();
     }
-    const auto end = time * sqrt(g / H) >= 6.9;
+    num_particle_steps += static_cast<float64_t>(particles.size());
+    Metrics::set("step", static_cast<float64_t>(n));
+    Metrics::set("time", time * sqrt(g / H));
+    Metrics::set("step::seconds", exectime.last_cycle());
+    Metrics::set("num_particles", static_cast<float64_t>(particles.size()));
+    if (const auto& sleep_ctrl = time_integrator.sleep()) {
+      Metrics::set("num_asleep",
+                   static_cast<float64_t>(sleep_ctrl->num_asleep()));
+    }
+    const auto end = time * sqrt(g / H) >= params.end_time;
     if ((n % 100 == 0 && n != 0) || end) {
       const StopwatchCycle cycle{printtime};
-      particles.write(time * sqrt(g / H), series);
+      // The last step is written in full.
+      particles.write(time * sqrt(g / H), writer, output, end ? 0 : n);
+    }
+    if (auto& live = data::live_channel(); live.is_wanted()) {
+      particles.write(time * sqrt(g / H), live);
+    }
+    if (shared && n % params.shared_interval == 0) {
+      particles.write(time * sqrt(g / H), *shared, shared_output);
     }
     if (end) break;
     time += dt;
   }
 
+  // Report the throughput, so that the runs on the different machines and
+  // with the different resolutions could be compared.
+  const auto throughput = num_particle_steps / exectime.total() /
+                          static_cast<float64_t>(par::num_threads());
+  Metrics::set("throughput", throughput);
+  TIT_INFO("Throughput: {:.4g} particle-steps per second per thread.",
+           throughput);
+
   return 0;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+template<class Real>
+auto sph_main(CmdArgs args) -> int {
+  // Read the case file, if any. Parameters that are not specified take the
+  // values of the classic dam break case.
+  const std::span argspan{args.argv(), static_cast<size_t>(args.argc())};
+  if (argspan.size() > 2) TIT_THROW("Usage: {} [case-file]", argspan[0]);
+  const auto config =
+      argspan.size() == 2 ? Config::load(argspan[1]) : Config{};
+  DamBreakCase<Real> params{};
+  params.dim = config.get<size_t>("dim", 2);
+  if (params.dim != 2 && params.dim != 3) {
+    TIT_THROW("Unsupported dimension {}, must be 2 or 3.", params.dim);
+  }
+  params.H = config.get<Real>("H", 0.6);
+  params.W = config.get<Real>("W", params.H);
+  params.dr = params.H / config.get<Real>("resolution", 80.0);
+  params.g = config.get<Real>("g", 9.81);
+  params.rho_0 = config.get<Real>("rho_0", 1000.0);
+  params.cs_0 = config.get<Real>("cs_0", 20 * sqrt(params.g * params.H));
+  params.CFL = config.get<Real>("CFL", 0.8);
+  params.end_time = config.get<Real>("end_time", 6.9);
+  params.log_interval = config.get<Real>("log_interval", 0.0);
+  params.num_relax_iters = config.get<size_t>("relax_iters", 0);
+  params.boundary_model = make_boundary_model(
+      config.get<std::string_view>("boundary_model", "interpolation"));
+  params.boundary_update = make_boundary_update(
+      config.get<std::string_view>("boundary_update", "each_stage"));
+  params.interp_cache = config.get<bool>("interp_cache", false);
+  params.aligned_layout = config.get<bool>("aligned_layout", false);
+  params.tile_size = config.get<size_t>("tile_size", 0);
+  params.speculation_margin = config.get<Real>("speculation_margin", 0.0);
+  params.sleep = config.get<bool>("sleep", false);
+  params.sleep_velocity =
+      config.get<Real>("sleep_velocity", 1.0e-3 * sqrt(params.g * params.H));
+  params.sleep_acceleration =
+      config.get<Real>("sleep_acceleration", 1.0e-2 * params.g);
+  params.sleep_steps = config.get<size_t>("sleep_steps", 10);
+  params.autotune = config.get<bool>("autotune", false);
+  params.autotune_steps = config.get<size_t>("autotune_steps", 10);
+  params.autotune_cache_path =
+      config.get<std::string_view>("autotune_cache", "./autotune.txt");
+  params.storage_path =
+      config.get<std::string_view>("storage", "./particles.ttdb");
+  params.checkpoint_path =
+      config.get<std::string_view>("checkpoint", "./particles.ckpt");
+  params.shared_memory = config.get<std::string_view>("shared_memory", "");
+  params.shared_interval = config.get<size_t>("shared_interval", 10);
+  if (params.shared_interval == 0) {
+    TIT_THROW("Shared memory frame interval must be positive.");
+  }
+  params.rollback_interval = config.get<size_t>("rollback_interval", 0);
+  params.rollback_depth = config.get<size_t>("rollback_depth", 3);
+  params.rollback_retries = config.get<size_t>("rollback_retries", 3);
+  params.rollback_dt_factor = config.get<Real>("rollback_dt_factor", 0.5);
+  if (params.rollback_depth == 0) {
+    TIT_THROW("Number of the rollback checkpoints must be positive.");
+  }
+  if (params.rollback_dt_factor <= 0.0 || params.rollback_dt_factor >= 1.0) {
+    TIT_THROW("Rollback time step factor must be in (0, 1).");
+  }
+
+  // Select the schemes from the precompiled catalog, so that the changes of
+  // the case do not require recompilation.
+  const auto kernel_variant =
+      make_kernel(config.get<std::string_view>("kernel", "quartic_wendland"));
+  const auto artificial_viscosity_variant = make_artificial_viscosity(
+      config.get<std::string_view>("artificial_viscosity", "delta_sph"),
+      params.cs_0,
+      params.rho_0,
+      config.get<Real>("alpha", 0.02),
+      config.get<Real>("diffusion", 0.1));
+  for (const auto& key : config.unused_keys()) {
+    TIT_WARN("Unknown case parameter '{}' is ignored.", key);
+  }
+
+  return std::visit(
+      [&params](const auto& kernel, const auto& artificial_viscosity) {
+        if (params.dim == 3) {
+          return run_case<Real, 3>(params, kernel, artificial_viscosity);
+        }
+        return run_case<Real, 2>(params, kernel, artificial_viscosity);
+      },
+      kernel_variant,
+      artificial_viscosity_variant);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit::sph
 
@@ -0,0 +1,76 @@
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+# Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+# Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+"""
+Check the results of the default dam break case.
+
+The output file is not compared byte by byte: its layout changes with the
+particle ordering, compression and the set of the written fields, none of
+which affect the solution. Instead, the physical invariants of the solution
+are checked, the surge front is compared with the reference curve, and the
+script fails on the first violated check.
+"""
+
+import numpy as np
+
+import pytit
+
+# Parameters of the default case, see `titwcsph`.
+H, G, RHO_0, END_TIME = 0.6, 9.81, 1000.0, 6.9
+POOL_WIDTH, POOL_HEIGHT = 5.366 * H, 2.5 * H
+MARGIN = 5 * H / 80  # Fixed particle layers.
+FRONT_TOLERANCE = 0.3  # Surge front position tolerance, in H.
+
+
+def check(condition: bool, message: str) -> None:
+    """Fail with the message unless the condition holds."""
+    if not condition:
+        raise AssertionError(message)
+
+
+storage = pytit.DataStorage("particles.ttdb")
+check(len(storage.series) == 1, "Exactly one data series is expected.")
+steps = storage.last_series.time_steps
+check(len(steps) > 1, "Time steps were not written.")
+check(steps[0].time == 0.0, "First time step is not the initial state.")
+check(steps[-1].time >= END_TIME, "Run stopped before the end time.")
+
+front_time, front_ref = np.loadtxt("dam_break_front.csv",
+                                   delimiter=",",
+                                   unpack=True)
+
+initial = steps[0].varyings
+num_particles, total_mass = len(initial["m"]), np.sum(initial["m"])
+for step in steps:
+    fields = step.varyings
+    m, r, v, rho = fields["m"], fields["r"], fields["v"], fields["rho"]
+    where = f"at t = {step.time}"
+    check(len(m) == num_particles, f"Particle count changed {where}.")
+    check(np.isclose(np.sum(m), total_mass, rtol=1.0e-9),
+          f"Mass is not conserved {where}.")
+    check(np.all(np.isfinite(r)) and np.all(np.isfinite(v)),
+          f"Solution diverged {where}.")
+    check(np.all(r >= -MARGIN) and np.all(r[:, 0] <= POOL_WIDTH + MARGIN) and
+          np.all(r[:, 1] <= POOL_HEIGHT + MARGIN),
+          f"Particles escaped the pool {where}.")
+    check(np.all(np.abs(rho / RHO_0 - 1.0) < 0.1),
+          f"Density deviates from the reference one {where}.")
+    check(np.all(np.linalg.norm(v, axis=1) < 4.0 * np.sqrt(G * H)),
+          f"Velocity exceeds the physical bound {where}.")
+
+    # Surge front is the rightmost fluid particle. Fixed particles are the
+    # only ones outside of the pool interior, and they never move.
+    if step.time <= front_time[-1]:
+        fluid = (r[:, 0] > 0.0) & (r[:, 0] < POOL_WIDTH) & (r[:, 1] > 0.0)
+        front = np.max(r[fluid, 0]) / H
+        expected = np.interp(step.time, front_time, front_ref)
+        check(abs(front - expected) < FRONT_TOLERANCE,
+              f"Surge front is at {front:.3f} H instead of {expected:.3f} H "
+              f"{where}.")
+
+# Water column collapses: the potential energy is released into the motion.
+final_energy = pytit.kinetic_energy(steps[-1].varyings["m"],
+                                    steps[-1].varyings["v"])
+check(final_energy > 0.0, "Water column did not collapse.")